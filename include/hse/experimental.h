@@ -93,6 +93,388 @@ hse_kvdb_compact_status_get(struct hse_kvdb *kvdb, struct hse_kvdb_compact_statu
  * @{
  */
 
+/** @brief Maximum number of keys in a single hse_kvs_get_multi() call. */
+#define HSE_KVS_GET_MULTI_MAX (256)
+
+/** @brief Retrieve the values for a batch of keys from a KVS.
+ *
+ * Functionally equivalent to calling hse_kvs_get() once for each key in
+ * @p keyv, except that all lookups are performed against a single view of
+ * the KVS and the per-call overheads (view establishment, transaction
+ * locking, cN tree locking and route map traversal) are paid once per batch
+ * rather than once per key.
+ *
+ * The keys need not be sorted nor unique.  The outputs for key @p keyv[i]
+ * are returned in @p foundv[i], @p valbufv[i] and @p val_lenv[i].
+ *
+ * If @p valbufv is NULL, or if @p valbufv[i] is NULL and @p valbuf_szv[i]
+ * is zero, then the call only probes for the existence of key i and the
+ * length of its value.
+ *
+ * @note This function is thread safe.
+ *
+ * <b>Flags:</b>
+ * @arg 0 - Reserved for future use.
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param flags: Flags for operation specialization.
+ * @param txn: Transaction context (optional).
+ * @param count: Number of keys in @p keyv.
+ * @param keyv: Vector of keys to get from the KVS.
+ * @param key_lenv: Vector of key lengths.
+ * @param[out] foundv: Vector of flags indicating whether each key was found.
+ * @param valbufv: Vector of buffers into which the values are copied (optional).
+ * @param valbuf_szv: Vector of buffer sizes (must not be NULL if @p valbufv
+ * is not NULL).
+ * @param[out] val_lenv: Vector of actual value lengths.
+ *
+ * @remark @p kvs must not be NULL.
+ * @remark @p count must be within the range of [1, HSE_KVS_GET_MULTI_MAX].
+ * @remark @p keyv, @p key_lenv, @p foundv and @p val_lenv must not be NULL.
+ * @remark Each key length must be within the range of [1, HSE_KVS_KEY_LEN_MAX].
+ *
+ * @returns Error status.
+ */
+hse_err_t
+hse_kvs_get_multi(
+    struct hse_kvs *     kvs,
+    unsigned int         flags,
+    struct hse_kvdb_txn *txn,
+    size_t               count,
+    const void *const *  keyv,
+    const size_t *       key_lenv,
+    bool *               foundv,
+    void *const *        valbufv,
+    const size_t *       valbuf_szv,
+    size_t *             val_lenv);
+
+/** @brief Maximum number of operations in a single hse_kvs_write_batch() call. */
+#define HSE_KVS_WRITE_BATCH_MAX (256)
+
+/** @brief Maximum sum of key and value lengths in a single hse_kvs_write_batch() call. */
+#define HSE_KVS_WRITE_BATCH_BYTES_MAX (512 * 1024)
+
+/** @brief Type of a write batch operation. */
+enum hse_kvs_batch_op_type {
+    HSE_KVS_BATCH_PUT = 0,       /**< Put a key-value pair. */
+    HSE_KVS_BATCH_DELETE,        /**< Delete a key. */
+    HSE_KVS_BATCH_PREFIX_DELETE, /**< Delete all keys matching a prefix. */
+};
+
+/** @brief A single operation within a write batch. */
+struct hse_kvs_batch_op {
+    struct hse_kvs            *kbo_kvs;     /**< KVS handle from hse_kvdb_kvs_open(). */
+    enum hse_kvs_batch_op_type kbo_type;    /**< Operation type. */
+    const void                *kbo_key;     /**< Key, or prefix for a prefix delete. */
+    size_t                     kbo_key_len; /**< Length of @p kbo_key. */
+    const void                *kbo_val;     /**< Value (puts only). */
+    size_t                     kbo_val_len; /**< Length of @p kbo_val (puts only). */
+};
+
+/** @brief Apply a batch of puts, deletes and prefix deletes.
+ *
+ * Functionally equivalent to calling hse_kvs_put(), hse_kvs_delete() or
+ * hse_kvs_prefix_delete() for each operation in @p opv, in order, except
+ * that the batch is logged as a single WAL record and inserted into the
+ * in-memory component in a single pass.  This amortizes the per-operation
+ * costs (durability log reservation, throttling, transaction and c0
+ * locking) over the entire batch, which can substantially improve ingest
+ * throughput for small key-value pairs.
+ *
+ * The operations may target different KVSs of the same KVDB.  A batch
+ * is recovered after a crash either in its entirety or not at all.  If
+ * @p txn is given, the operations become part of the transaction and are
+ * made visible atomically when it commits.  Otherwise, concurrent readers
+ * may observe a partially applied batch.
+ *
+ * @note This function is thread safe.
+ *
+ * <b>Flags:</b>
+ * @arg HSE_KVS_PUT_PRIO - Operation will not be throttled.
+ * @arg HSE_KVS_PUT_VCOMP_OFF - Value will not be compressed.
+ * @arg HSE_KVS_PUT_VCOMP_ON - Value may be compressed.
+ *
+ * @param kvdb: KVDB handle from hse_kvdb_open().
+ * @param flags: Flags for operation specialization (apply to all puts).
+ * @param txn: Transaction context (optional).
+ * @param count: Number of operations in @p opv.
+ * @param opv: Vector of operations to apply.
+ *
+ * @remark @p kvdb must not be NULL.
+ * @remark @p count must be within the range of [1, HSE_KVS_WRITE_BATCH_MAX].
+ * @remark @p opv must not be NULL.
+ * @remark Each KVS must belong to @p kvdb.
+ * @remark The sum of all key and value lengths must not exceed
+ * HSE_KVS_WRITE_BATCH_BYTES_MAX.
+ * @remark The same key and prefix length restrictions as hse_kvs_put(),
+ * hse_kvs_delete() and hse_kvs_prefix_delete() apply to each operation.
+ *
+ * @returns Error status.
+ */
+hse_err_t
+hse_kvs_write_batch(
+    struct hse_kvdb *              kvdb,
+    unsigned int                   flags,
+    struct hse_kvdb_txn *          txn,
+    size_t                         count,
+    const struct hse_kvs_batch_op *opv);
+
+/** @brief Maximum length of a merge operand (and of a folded operand). */
+#define HSE_KVS_MERGE_OPERAND_LEN_MAX (1024)
+
+/** @brief Merge operator callback.
+ *
+ * Combines @p operand into @p base and writes the result into @p result.
+ * The operator must be associative, as HSE may combine two operands into
+ * a single operand (passed as @p base and @p operand respectively) long
+ * before the value they will eventually be applied to is known.  @p base
+ * is NULL if the key has no value (i.e., it was never put or has been
+ * deleted), in which case the operator is expected to produce the value
+ * that results from applying @p operand to nothing.
+ *
+ * The operator may be called from any thread, including HSE's internal
+ * ingest and compaction threads, and hence must not call back into HSE.
+ *
+ * @param arg: Argument given to hse_kvs_merge_operator_set().
+ * @param key: Key to which the operand applies.
+ * @param key_len: Length of @p key.
+ * @param base: Existing value or earlier operand (NULL if none).
+ * @param base_len: Length of @p base.
+ * @param operand: Operand to apply to @p base.
+ * @param operand_len: Length of @p operand.
+ * @param[out] result: Buffer into which the result is written.
+ * @param result_sz: Size of @p result.
+ * @param[out] result_len: Length of the result.
+ *
+ * @returns Zero on success, otherwise an errno value which is reported
+ * to the caller of the operation which required the merge.  If the result
+ * does not fit in @p result_sz bytes, the operator should return EMSGSIZE.
+ */
+typedef int
+hse_kvs_merge_fn(
+    void *      arg,
+    const void *key,
+    size_t      key_len,
+    const void *base,
+    size_t      base_len,
+    const void *operand,
+    size_t      operand_len,
+    void *      result,
+    size_t      result_sz,
+    size_t *    result_len);
+
+/** @brief Register the merge operator for a KVS.
+ *
+ * The operator remains registered until the KVS is closed and must be
+ * registered each time the KVS is opened before any merge operands which
+ * may remain in the KVS can be read.  Reading a key which has unresolved
+ * operands while no operator is registered fails with ENOTSUP.
+ *
+ * @note This function is thread safe.
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param fn: Merge operator.
+ * @param arg: Argument passed to each invocation of @p fn.
+ *
+ * @remark @p kvs must not be NULL.
+ * @remark @p fn must not be NULL.
+ *
+ * @returns Error status.  EEXIST if an operator is already registered.
+ */
+hse_err_t
+hse_kvs_merge_operator_set(struct hse_kvs *kvs, hse_kvs_merge_fn *fn, void *arg);
+
+/** @brief Merge an operand into the value of a key.
+ *
+ * Records @p operand as a pending update to the value of @p key without
+ * reading the existing value.  Operands are combined with each other and
+ * with the value they apply to (using the operator registered with
+ * hse_kvs_merge_operator_set()) when the in-memory component is ingested
+ * and when kvsets are compacted, and are resolved on demand by hse_kvs_get()
+ * and cursor reads.  This turns read-modify-write updates such as counters
+ * into blind writes.
+ *
+ * If @p txn is given, the merge is resolved immediately (within the
+ * transaction's view) and stored as a regular value.
+ *
+ * hse_kvs_prefix_probe() reports the unresolved operand of a key whose
+ * most recent update is a merge.
+ *
+ * @note This function is thread safe.
+ *
+ * <b>Flags:</b>
+ * @arg HSE_KVS_PUT_PRIO - Operation will not be throttled.
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param flags: Flags for operation specialization.
+ * @param txn: Transaction context (optional).
+ * @param key: Key to merge into.
+ * @param key_len: Length of @p key.
+ * @param operand: Merge operand.
+ * @param operand_len: Length of @p operand.
+ *
+ * @remark @p kvs must not be NULL.
+ * @remark @p key must not be NULL.
+ * @remark @p key_len must be within the range of [1, HSE_KVS_KEY_LEN_MAX].
+ * @remark @p operand must not be NULL.
+ * @remark @p operand_len must be within the range of [1, HSE_KVS_MERGE_OPERAND_LEN_MAX].
+ *
+ * @returns Error status.  ENOTSUP if no merge operator is registered.
+ */
+hse_err_t
+hse_kvs_merge(
+    struct hse_kvs *     kvs,
+    unsigned int         flags,
+    struct hse_kvdb_txn *txn,
+    const void *         key,
+    size_t               key_len,
+    const void *         operand,
+    size_t               operand_len);
+
+/** @brief Put a key-value pair that expires into a KVS.
+ *
+ * As for hse_kvs_put(), except that the value expires at @p expire_time.
+ * Once expired, the key reads as though it had been deleted: hse_kvs_get()
+ * does not find it, cursors skip it and it hides older values of the key.
+ * Expired values are reclaimed by compaction.
+ *
+ * Expiry is determined using the system clock at the time of the read,
+ * with a granularity of one second.
+ *
+ * @note This function is thread safe.
+ *
+ * <b>Flags:</b>
+ * @arg As for hse_kvs_put().
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param flags: Flags for operation specialization.
+ * @param txn: Transaction context (optional).
+ * @param key: Key to put into kvs.
+ * @param key_len: Length of @p key.
+ * @param val: Value associated with @p key (optional).
+ * @param val_len: Length of @p value.
+ * @param expire_time: Expiry time in seconds since the epoch (zero if none).
+ *
+ * @remark As for hse_kvs_put().
+ * @remark @p expire_time must not exceed UINT32_MAX.
+ *
+ * @returns Error status.
+ */
+hse_err_t
+hse_kvs_put_expire(
+    struct hse_kvs *     kvs,
+    unsigned int         flags,
+    struct hse_kvdb_txn *txn,
+    const void *         key,
+    size_t               key_len,
+    const void *         val,
+    size_t               val_len,
+    uint64_t             expire_time);
+
+/** @brief Delete all key-value pairs in a range of keys from a KVS.
+ *
+ * Deletes every key @p k such that @p start <= @p k < @p end, as ordered by
+ * memcmp() with the shorter key ordering first on a tie.  The delete is
+ * recorded as a single range tombstone rather than one tombstone per key,
+ * so its cost does not depend on the number of keys in the range.  Keys
+ * put after the range delete are not affected by it.
+ *
+ * Covered keys are hidden from gets, cursors and prefix probes
+ * immediately, and are reclaimed by compaction.
+ *
+ * @note This function is thread safe.
+ *
+ * <b>Flags:</b>
+ * @arg 0 - Reserved for future use.
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param flags: Flags for operation specialization.
+ * @param start: First key of the range.
+ * @param start_len: Length of @p start.
+ * @param end: End of the range (exclusive).
+ * @param end_len: Length of @p end.
+ *
+ * @remark The KVS must not have transactions enabled.
+ * @remark @p start must order before @p end.
+ *
+ * @returns Error status.
+ */
+hse_err_t
+hse_kvs_range_delete(
+    struct hse_kvs *kvs,
+    unsigned int    flags,
+    const void *    start,
+    size_t          start_len,
+    const void *    end,
+    size_t          end_len);
+
+/** @brief Compaction filter decision. */
+enum hse_kvs_compact_filter_res {
+    HSE_KVS_COMPACT_FILTER_KEEP = 0, /**< Keep the value. */
+    HSE_KVS_COMPACT_FILTER_DROP,     /**< Delete the key. */
+    HSE_KVS_COMPACT_FILTER_CHANGE,   /**< Replace the value with @p new_value. */
+};
+
+/** @brief Compaction filter callback.
+ *
+ * Called during compaction with the newest value of a key that is visible
+ * to every current and future reader (i.e., the value is older than all
+ * active snapshots and transactions).  The filter may keep the value,
+ * delete the key, or replace the value with one that it writes to
+ * @p new_value.  The replacement retains the original seqno.
+ *
+ * The filter is not offered tombstones or unresolved merge operands, and
+ * may be offered the same value more than once as the key migrates
+ * through the tree, so it must be idempotent.  It may be called
+ * concurrently from HSE's internal compaction threads, even for a single
+ * compaction, and hence must be thread safe and must not call back into HSE.
+ *
+ * @param arg: Argument given to hse_kvs_compact_filter_set().
+ * @param key: Key.
+ * @param key_len: Length of @p key.
+ * @param value: Value (uncompressed).
+ * @param value_len: Length of @p value.
+ * @param seqno: Seqno of @p value.
+ * @param[out] new_value: Buffer for the replacement value.
+ * @param new_value_sz: Size of @p new_value, may be less than
+ * HSE_KVS_VALUE_LEN_MAX.  If the replacement does not fit, the filter
+ * should keep the value, it will be offered again by a later compaction.
+ * @param[out] new_value_len: Length of the replacement value.
+ *
+ * @returns The filter's decision.
+ */
+typedef enum hse_kvs_compact_filter_res
+hse_kvs_compact_filter_fn(
+    void *      arg,
+    const void *key,
+    size_t      key_len,
+    const void *value,
+    size_t      value_len,
+    uint64_t    seqno,
+    void *      new_value,
+    size_t      new_value_sz,
+    size_t *    new_value_len);
+
+/** @brief Register the compaction filter for a KVS.
+ *
+ * The filter remains registered until the KVS is closed and must be
+ * registered each time the KVS is opened.  Values that are not offered to
+ * the filter before it is registered are simply offered to it later.
+ *
+ * @note This function is thread safe.
+ *
+ * @param kvs: KVS handle from hse_kvdb_kvs_open().
+ * @param fn: Compaction filter.
+ * @param arg: Argument passed to each invocation of @p fn.
+ *
+ * @remark @p kvs must not be NULL.
+ * @remark @p fn must not be NULL.
+ *
+ * @returns Error status.  EEXIST if a filter is already registered.
+ */
+hse_err_t
+hse_kvs_compact_filter_set(struct hse_kvs *kvs, hse_kvs_compact_filter_fn *fn, void *arg);
+
 /** @brief Number of keys found from a prefix probe operation. */
 enum hse_kvs_pfx_probe_cnt {
     HSE_KVS_PFX_FOUND_ZERO = 0, /**< Zero keys found with prefix. */
@@ -149,6 +531,109 @@ hse_kvs_prefix_probe(
     size_t                      valbuf_sz,
     size_t *                    val_len);
 
+/* hse_kvs_cursor_read_batch() flags */
+#define HSE_CURSOR_READ_KEY_ONLY (1u << 0)
+
+/** @brief A key-value pair read by hse_kvs_cursor_read_batch(). */
+struct hse_kvs_cursor_pair {
+    const void *key;     /**< Key, within the caller's buffer. */
+    size_t      key_len; /**< Length of @p key. */
+    const void *val;     /**< Value, within the caller's buffer (NULL if keys only). */
+    size_t      val_len; /**< Length of the value, which may exceed the bytes copied. */
+};
+
+/** @brief Read a batch of key-value pairs from a cursor.
+ *
+ * Functionally equivalent to calling hse_kvs_cursor_read_copy() up to
+ * @p pairmax times, except that the pairs are packed into a single buffer
+ * and the per-call overheads are paid once per batch rather than once per
+ * pair.
+ *
+ * Each key is copied into @p buf followed by at most @p val_len_max bytes
+ * of its value, and the i-th pair is described by @p pairv[i].  Reading stops
+ * when @p pairmax pairs have been read, when the next pair would not fit in
+ * what remains of @p buf, or at EOF.  A pair that does not fit is returned by
+ * the next read from the cursor.
+ *
+ * @note If the cursor is at EOF, attempts to read from it will not change the
+ * state of the cursor.
+ * @note Cursor objects are not thread safe.
+ *
+ * <b>Flags:</b>
+ * @arg HSE_CURSOR_READ_KEY_ONLY - Copy only the keys, not the values.
+ *
+ * @param cursor: Cursor handle from hse_kvs_cursor_create().
+ * @param flags: Flags for operation specialization.
+ * @param[in,out] buf: Buffer into which the keys and values are copied.
+ * @param buf_sz: Size of @p buf.
+ * @param val_len_max: Maximum number of bytes of each value to copy.
+ * @param[out] pairv: Vector of pairs read.
+ * @param pairmax: Number of elements in @p pairv.
+ * @param[out] pairc: Number of pairs read.
+ * @param[out] eof: If true, no more key-value pairs follow those read.
+ *
+ * @remark @p cursor must not be NULL.
+ * @remark @p buf, @p pairv, @p pairc and @p eof must not be NULL.
+ * @remark @p pairmax must be greater than zero.
+ *
+ * @returns Error status.  ENOSPC if @p buf is too small to hold even the
+ * next pair.
+ */
+hse_err_t
+hse_kvs_cursor_read_batch(
+    struct hse_kvs_cursor      *cursor,
+    unsigned int                flags,
+    void                       *buf,
+    size_t                      buf_sz,
+    size_t                      val_len_max,
+    struct hse_kvs_cursor_pair *pairv,
+    size_t                      pairmax,
+    size_t                     *pairc,
+    bool                       *eof);
+
+/** @brief Create cursors over disjoint key ranges for a parallel scan.
+ *
+ * Creates up to @p cursormax forward cursors which together read every key in
+ * the KVS exactly once, so that a full scan may be split across threads (one
+ * cursor per thread).  The key ranges are ascending, cursor i reading keys
+ * less than those read by cursor i + 1, and their boundaries are chosen from
+ * the edges of the cN tree such that each range holds about the same amount
+ * of data.  Fewer than @p cursormax cursors are created if the KVS has too
+ * few cN tree nodes to divide it further.
+ *
+ * All the cursors share the same view of the KVS.  Each is positioned as if
+ * by hse_kvs_cursor_seek_range() on its key range; seeking a cursor outside of
+ * its range, or updating its view, gives up the partitioning for that cursor.
+ * Each cursor must be destroyed with hse_kvs_cursor_destroy().
+ *
+ * @note Cursor objects are not thread safe, and each cursor must be used by
+ * only one thread at a time.
+ *
+ * <b>Flags:</b>
+ * @arg 0 - Reserved for future use.
+ *
+ * @param kvs: KVS to iterate over, handle from hse_kvdb_kvs_open().
+ * @param flags: Flags for operation specialization.
+ * @param txn: Transaction context (optional).
+ * @param cursormax: Maximum number of cursors to create.
+ * @param[out] cursorv: Vector of at least @p cursormax cursor handles.
+ * @param[out] cursorc: Number of cursors created.
+ *
+ * @remark @p kvs must not be NULL.
+ * @remark @p cursorv and @p cursorc must not be NULL.
+ * @remark @p cursormax must be greater than zero.
+ *
+ * @returns Error status.
+ */
+hse_err_t
+hse_kvs_cursor_create_partitioned(
+    struct hse_kvs *        kvs,
+    unsigned int            flags,
+    struct hse_kvdb_txn *   txn,
+    unsigned int            cursormax,
+    struct hse_kvs_cursor **cursorv,
+    unsigned int *          cursorc);
+
 /**@} KVS */
 
 #pragma GCC visibility pop
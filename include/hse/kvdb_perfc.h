@@ -37,6 +37,8 @@ enum kvdb_perfc_sidx_kvdbop {
     PERFC_RA_KVDBOP_KVS_PFX_DEL,
     PERFC_RA_KVDBOP_KVS_PFX_DELB,
 
+    PERFC_RA_KVDBOP_KVS_RANGE_DEL,
+
     PERFC_RA_KVDBOP_KVS_PFXPROBE,
 
     PERFC_RA_KVDBOP_KVDB_SYNC,
@@ -88,12 +90,13 @@ enum kvdb_perfc_sidx_ctxnop {
 enum kvdb_perfc_sidx_cnget {
     PERFC_LT_CNGET_GET,
 
-    /* The following five enumerators must match enum key_lookup_res */
+    /* The following six enumerators must match enum key_lookup_res */
     PERFC_RA_CNGET_MISS,
     PERFC_RA_CNGET_GET,
     PERFC_RA_CNGET_TOMB,
     PERFC_RA_CNGET_PTOMB,
     PERFC_RA_CNGET_MULTIPLE,
+    PERFC_RA_CNGET_MERGE,
 
     /* The enumerators PERFC_LT_CNGET_GET_ROOT and LEAF must be sequential */
     PERFC_LT_CNGET_GET_ROOT,
@@ -111,6 +114,8 @@ enum kvdb_perfc_sidx_kvdb_metrics {
     PERFC_RA_KVDBMETRICS_CURRETIRED,
     PERFC_RA_KVDBMETRICS_CUREVICTED,
     PERFC_DI_KVDBMETRICS_THROTTLE,
+    PERFC_BA_KVDBMETRICS_KVSETOPEN,
+    PERFC_RA_KVDBMETRICS_KVSETOPENED,
     PERFC_EN_KVDBMETRICS
 };
 
@@ -200,6 +205,9 @@ enum kvdb_perfc_sidx_pkvsl {
     PERFC_LT_PKVSL_KVS_DEL,
     PERFC_LT_PKVSL_KVS_PFX_PROBE,
     PERFC_LT_PKVSL_KVS_PFX_DEL,
+    PERFC_LT_PKVSL_KVS_RANGE_DEL,
+    PERFC_LT_PKVSL_KVS_GET_MULTI,
+    PERFC_LT_PKVSL_KVS_WRITE_BATCH,
 
     PERFC_EN_PKVSL
 };
@@ -234,4 +242,24 @@ enum kvdb_perfc_sidx_sts_queues {
     PERFC_EN_STS
 };
 
+/* mpool block cache */
+enum kvdb_perfc_sidx_bcache {
+    PERFC_RA_BCACHE_IDX_HIT,
+    PERFC_RA_BCACHE_IDX_MISS,
+    PERFC_RA_BCACHE_DATA_HIT,
+    PERFC_RA_BCACHE_DATA_MISS,
+    PERFC_RA_BCACHE_EVICT,
+
+    PERFC_EN_BCACHE
+};
+
+/* WAL group commit */
+enum kvdb_perfc_sidx_wal {
+    PERFC_RA_WAL_GC_COMMIT,
+    PERFC_DI_WAL_GC_BATCH,
+    PERFC_LT_WAL_GC_SYNC,
+
+    PERFC_EN_WAL
+};
+
 #endif /* HSE_KVDB_PERFC_API_H */
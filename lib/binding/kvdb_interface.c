@@ -26,6 +26,7 @@
 #include <hse_ikvdb/kvdb_home.h>
 #include <hse_ikvdb/kvs.h>
 
+#include <hse_util/alloc.h>
 #include <hse_util/err_ctx.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/mutex.h>
@@ -889,6 +890,50 @@ hse_kvs_put(
     return err;
 }
 
+hse_err_t
+hse_kvs_put_expire(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    const void *               key,
+    size_t                     key_len,
+    const void *               val,
+    size_t                     val_len,
+    uint64_t                   expire_time)
+{
+    struct kvs_ktuple kt;
+    struct kvs_vtuple vt;
+    merr_t            err;
+
+    if (HSE_UNLIKELY(!handle || !key || (val_len > 0 && !val) || flags & ~HSE_KVS_PUT_MASK ||
+            (flags & HSE_KVS_PUT_VCOMP_MASK) == HSE_KVS_PUT_VCOMP_MASK))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(expire_time > UINT32_MAX))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(key_len > HSE_KVS_KEY_LEN_MAX))
+        return merr(ENAMETOOLONG);
+
+    if (HSE_UNLIKELY(key_len == 0))
+        return merr(ENOENT);
+
+    if (HSE_UNLIKELY(val_len > HSE_KVS_VALUE_LEN_MAX))
+        return merr(EMSGSIZE);
+
+    kvs_ktuple_init_nohash(&kt, key, key_len);
+    kvs_vtuple_init(&vt, (void *)val, val_len);
+
+    err = ikvdb_kvs_put_expire(handle, flags, txn, &kt, &vt, expire_time);
+    ev(err);
+
+    if (!err)
+        PERFC_INCADD_RU(
+            &kvdb_pc, PERFC_RA_KVDBOP_KVS_PUT, PERFC_RA_KVDBOP_KVS_PUTB, key_len + val_len);
+
+    return err;
+}
+
 hse_err_t
 hse_kvs_get(
     struct hse_kvs *           handle,
@@ -948,6 +993,96 @@ hse_kvs_get(
     return 0;
 }
 
+hse_err_t
+hse_kvs_get_multi(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    const size_t               count,
+    const void *const *        keyv,
+    const size_t *             key_lenv,
+    bool *                     foundv,
+    void *const *              valbufv,
+    const size_t *             valbuf_szv,
+    size_t *                   val_lenv)
+{
+    struct kvs_ktuple   *ktv;
+    struct kvs_buf      *vbufv;
+    enum key_lookup_res *resv;
+    size_t               getb = 0;
+    merr_t               err = 0;
+
+    if (HSE_UNLIKELY(!handle || !keyv || !key_lenv || !foundv || !val_lenv || flags != 0))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(count == 0 || count > HSE_KVS_GET_MULTI_MAX))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(valbufv && !valbuf_szv))
+        return merr(EINVAL);
+
+    for (size_t i = 0; i < count; i++) {
+        void  *valbuf = valbufv ? valbufv[i] : NULL;
+        size_t valbuf_sz = valbufv ? valbuf_szv[i] : 0;
+
+        if (HSE_UNLIKELY(!keyv[i] || (!valbuf && valbuf_sz > 0)))
+            return merr(EINVAL);
+
+        if (HSE_UNLIKELY(key_lenv[i] > HSE_KVS_KEY_LEN_MAX))
+            return merr(ENAMETOOLONG);
+
+        if (HSE_UNLIKELY(key_lenv[i] == 0))
+            return merr(ENOENT);
+    }
+
+    /* A full batch of tuples, buffers and results is too big for the
+     * caller's stack.
+     */
+    ktv = malloc(count * (sizeof(*ktv) + sizeof(*vbufv) + sizeof(*resv)));
+    if (ev(!ktv))
+        return merr(ENOMEM);
+
+    vbufv = (struct kvs_buf *)(ktv + count);
+    resv = (enum key_lookup_res *)(vbufv + count);
+
+    for (size_t i = 0; i < count; i++) {
+        void  *valbuf = valbufv ? valbufv[i] : NULL;
+        size_t valbuf_sz = valbufv ? valbuf_szv[i] : 0;
+
+        /* See hse_kvs_get() regarding probes (NULL valbuf with zero size).
+         */
+        if (!valbuf && valbuf_sz == 0)
+            valbuf = (void *)-1;
+
+        kvs_ktuple_init_nohash(&ktv[i], keyv[i], key_lenv[i]);
+        kvs_buf_init(&vbufv[i], valbuf, valbuf_sz);
+    }
+
+    err = ikvdb_kvs_get_multi(handle, flags, txn, count, ktv, resv, vbufv);
+    if (ev(err))
+        goto out;
+
+    for (size_t i = 0; i < count; i++) {
+        if (ev(resv[i] == FOUND_MULTIPLE)) {
+            err = merr(EPROTO);
+            goto out;
+        }
+
+        foundv[i] = (resv[i] == FOUND_VAL);
+        val_lenv[i] = vbufv[i].b_len;
+
+        if (foundv[i])
+            getb += val_lenv[i];
+    }
+
+    perfc_add2(&kvdb_pc, PERFC_RA_KVDBOP_KVS_GET, count, PERFC_RA_KVDBOP_KVS_GETB, getb);
+
+out:
+    free(ktv);
+
+    return err;
+}
+
 /**
  * hse_kvs_delete() - remove the supplied key and associated value from the KVS
  */
@@ -1078,6 +1213,219 @@ hse_kvs_prefix_delete(
     return err;
 }
 
+hse_err_t
+hse_kvs_range_delete(
+    struct hse_kvs *   handle,
+    const unsigned int flags,
+    const void *       start,
+    size_t             start_len,
+    const void *       end,
+    size_t             end_len)
+{
+    struct kvs_ktuple kt_start, kt_end;
+    merr_t            err;
+
+    if (HSE_UNLIKELY(!handle || !start || !end || flags != 0))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(start_len > HSE_KVS_KEY_LEN_MAX || end_len > HSE_KVS_KEY_LEN_MAX))
+        return merr(ENAMETOOLONG);
+
+    if (HSE_UNLIKELY(start_len == 0 || end_len == 0))
+        return merr(ENOENT);
+
+    kvs_ktuple_init_nohash(&kt_start, start, start_len);
+    kvs_ktuple_init_nohash(&kt_end, end, end_len);
+
+    err = ikvdb_kvs_range_delete(handle, flags, &kt_start, &kt_end);
+    ev(err);
+
+    if (!err)
+        PERFC_INC_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVS_RANGE_DEL);
+
+    return err;
+}
+
+hse_err_t
+hse_kvs_write_batch(
+    struct hse_kvdb *              handle,
+    const unsigned int             flags,
+    struct hse_kvdb_txn *const     txn,
+    const size_t                   count,
+    const struct hse_kvs_batch_op *opv)
+{
+    struct kvs_batch_op *kopv;
+    struct hse_kvs **    kvsv;
+    size_t               putc = 0, putb = 0, delc = 0, delb = 0, pdelc = 0, pdelb = 0;
+    merr_t               err;
+
+    if (HSE_UNLIKELY(!handle || !opv || flags & ~HSE_KVS_PUT_MASK ||
+            (flags & HSE_KVS_PUT_VCOMP_MASK) == HSE_KVS_PUT_VCOMP_MASK))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(count == 0 || count > HSE_KVS_WRITE_BATCH_MAX))
+        return merr(EINVAL);
+
+    for (size_t i = 0; i < count; i++) {
+        const struct hse_kvs_batch_op *op = opv + i;
+
+        if (HSE_UNLIKELY(!op->kbo_kvs || !op->kbo_key))
+            return merr(EINVAL);
+
+        if (HSE_UNLIKELY(op->kbo_key_len == 0))
+            return merr(ENOENT);
+
+        switch (op->kbo_type) {
+        case HSE_KVS_BATCH_PUT:
+            if (HSE_UNLIKELY(op->kbo_val_len > 0 && !op->kbo_val))
+                return merr(EINVAL);
+
+            if (HSE_UNLIKELY(op->kbo_key_len > HSE_KVS_KEY_LEN_MAX))
+                return merr(ENAMETOOLONG);
+
+            if (HSE_UNLIKELY(op->kbo_val_len > HSE_KVS_VALUE_LEN_MAX))
+                return merr(EMSGSIZE);
+
+            putc++;
+            putb += op->kbo_key_len + op->kbo_val_len;
+            break;
+
+        case HSE_KVS_BATCH_DELETE:
+            if (HSE_UNLIKELY(op->kbo_key_len > HSE_KVS_KEY_LEN_MAX))
+                return merr(ENAMETOOLONG);
+
+            delc++;
+            delb += op->kbo_key_len;
+            break;
+
+        case HSE_KVS_BATCH_PREFIX_DELETE:
+            if (HSE_UNLIKELY(op->kbo_key_len > HSE_KVS_PFX_LEN_MAX))
+                return merr(ENAMETOOLONG);
+
+            pdelc++;
+            pdelb += op->kbo_key_len;
+            break;
+
+        default:
+            return merr(EINVAL);
+        }
+    }
+
+    if (HSE_UNLIKELY(putb + delb + pdelb > HSE_KVS_WRITE_BATCH_BYTES_MAX))
+        return merr(EMSGSIZE);
+
+    /* A full batch of ops is too big for the caller's stack.
+     */
+    kopv = malloc(count * (sizeof(*kopv) + sizeof(*kvsv)));
+    if (ev(!kopv))
+        return merr(ENOMEM);
+
+    kvsv = (struct hse_kvs **)(kopv + count);
+
+    for (size_t i = 0; i < count; i++) {
+        const struct hse_kvs_batch_op *op = opv + i;
+        struct kvs_batch_op *kop = kopv + i;
+
+        kvsv[i] = op->kbo_kvs;
+        kop->kbo_kvs = NULL;
+
+        switch (op->kbo_type) {
+        case HSE_KVS_BATCH_PUT:
+            kop->kbo_op = KVS_BATCH_PUT;
+            kvs_ktuple_init_nohash(&kop->kbo_kt, op->kbo_key, op->kbo_key_len);
+            kvs_vtuple_init(&kop->kbo_vt, (void *)op->kbo_val, op->kbo_val_len);
+            break;
+
+        case HSE_KVS_BATCH_DELETE:
+            kop->kbo_op = KVS_BATCH_DEL;
+            kvs_ktuple_init_nohash(&kop->kbo_kt, op->kbo_key, op->kbo_key_len);
+            kvs_vtuple_init(&kop->kbo_vt, NULL, 0);
+            break;
+
+        default:
+            kop->kbo_op = KVS_BATCH_PDEL;
+            kvs_ktuple_init(&kop->kbo_kt, op->kbo_key, op->kbo_key_len);
+            kvs_vtuple_init(&kop->kbo_vt, NULL, 0);
+            break;
+        }
+    }
+
+    err = ikvdb_kvs_write_batch((struct ikvdb *)handle, flags, txn, count, kvsv, kopv);
+
+    free(kopv);
+
+    if (ev(err))
+        return err;
+
+    if (putc > 0)
+        perfc_add2(&kvdb_pc, PERFC_RA_KVDBOP_KVS_PUT, putc, PERFC_RA_KVDBOP_KVS_PUTB, putb);
+    if (delc > 0)
+        perfc_add2(&kvdb_pc, PERFC_RA_KVDBOP_KVS_DEL, delc, PERFC_RA_KVDBOP_KVS_DELB, delb);
+    if (pdelc > 0)
+        perfc_add2(&kvdb_pc, PERFC_RA_KVDBOP_KVS_PFX_DEL, pdelc,
+                   PERFC_RA_KVDBOP_KVS_PFX_DELB, pdelb);
+
+    return 0;
+}
+
+hse_err_t
+hse_kvs_merge_operator_set(struct hse_kvs *handle, hse_kvs_merge_fn *fn, void *arg)
+{
+    if (HSE_UNLIKELY(!handle || !fn))
+        return merr(EINVAL);
+
+    return ikvdb_kvs_merge_operator_set(handle, fn, arg);
+}
+
+hse_err_t
+hse_kvs_compact_filter_set(struct hse_kvs *handle, hse_kvs_compact_filter_fn *fn, void *arg)
+{
+    if (HSE_UNLIKELY(!handle || !fn))
+        return merr(EINVAL);
+
+    return ikvdb_kvs_compact_filter_set(handle, fn, arg);
+}
+
+hse_err_t
+hse_kvs_merge(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    const void *               key,
+    size_t                     key_len,
+    const void *               operand,
+    size_t                     operand_len)
+{
+    struct kvs_ktuple kt;
+    merr_t            err;
+
+    if (HSE_UNLIKELY(!handle || !key || !operand || flags & ~HSE_KVS_PUT_PRIO))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(key_len > HSE_KVS_KEY_LEN_MAX))
+        return merr(ENAMETOOLONG);
+
+    if (HSE_UNLIKELY(key_len == 0))
+        return merr(ENOENT);
+
+    if (HSE_UNLIKELY(operand_len == 0))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(operand_len > HSE_KVS_MERGE_OPERAND_LEN_MAX))
+        return merr(EMSGSIZE);
+
+    kvs_ktuple_init_nohash(&kt, key, key_len);
+
+    err = ikvdb_kvs_merge(handle, flags, txn, &kt, operand, operand_len);
+    ev(err);
+
+    if (!err)
+        PERFC_INCADD_RU(
+            &kvdb_pc, PERFC_RA_KVDBOP_KVS_PUT, PERFC_RA_KVDBOP_KVS_PUTB, key_len + operand_len);
+
+    return err;
+}
+
 hse_err_t
 hse_kvdb_sync(struct hse_kvdb *handle, const unsigned int flags)
 {
@@ -1262,6 +1610,28 @@ hse_kvs_cursor_create(
     return err;
 }
 
+hse_err_t
+hse_kvs_cursor_create_partitioned(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    unsigned int               cursormax,
+    struct hse_kvs_cursor **   cursorv,
+    unsigned int *             cursorc)
+{
+    merr_t err;
+
+    if (HSE_UNLIKELY(!handle || !cursorv || !cursorc || cursormax == 0 || flags != 0))
+        return merr(EINVAL);
+
+    PERFC_INC_RU(&kvdb_pc, PERFC_RA_KVDBOP_KVS_CURSOR_CREATE);
+
+    err = ikvdb_kvs_cursor_create_partitioned(handle, flags, txn, cursormax, cursorv, cursorc);
+    ev(err);
+
+    return err;
+}
+
 hse_err_t
 hse_kvs_cursor_update_view(struct hse_kvs_cursor *cursor, const unsigned int flags)
 {
@@ -1407,6 +1777,46 @@ hse_kvs_cursor_read_copy(
     return err;
 }
 
+hse_err_t
+hse_kvs_cursor_read_batch(
+    struct hse_kvs_cursor      *cursor,
+    unsigned int                flags,
+    void                       *buf,
+    size_t                      buf_sz,
+    size_t                      val_len_max,
+    struct hse_kvs_cursor_pair *pairv,
+    size_t                      pairmax,
+    size_t                     *pairc,
+    bool                       *eof)
+{
+    merr_t err;
+
+    if (HSE_UNLIKELY(!cursor || !buf || !pairv || !pairc || !eof || pairmax == 0))
+        return merr(EINVAL);
+
+    if (HSE_UNLIKELY(flags & ~HSE_CURSOR_READ_KEY_ONLY))
+        return merr(EINVAL);
+
+    err = ikvdb_kvs_cursor_read_batch(cursor, flags, buf, buf_sz, val_len_max, pairv, pairmax,
+                                      pairc, eof);
+    ev(err);
+
+    if (*pairc > 0) {
+        size_t len = 0;
+
+        for (size_t i = 0; i < *pairc; i++) {
+            len += pairv[i].key_len;
+
+            if (pairv[i].val)
+                len += min_t(size_t, pairv[i].val_len, val_len_max);
+        }
+
+        perfc_add2(&kvdb_pc, PERFC_RA_KVDBOP_KVS_CURSOR_READ, *pairc,
+                   PERFC_RA_KVDBOP_KVS_GETB, len);
+    }
+
+    return err;
+}
 
 hse_err_t
 hse_kvs_cursor_destroy(struct hse_kvs_cursor *cursor)
@@ -128,6 +128,23 @@ c0_prefix_del(struct c0 *handle, struct kvs_ktuple *kt, uintptr_t seqnoref)
     return c0sk_prefix_del(self->c0_c0sk, self->c0_index, kt, seqnoref);
 }
 
+merr_t
+c0_range_del(struct c0 *handle, struct kvs_ktuple *start, struct kvs_ktuple *end, uintptr_t seqnoref)
+{
+    struct c0_impl *self = c0_h2r(handle);
+
+    assert(self->c0_index < HSE_KVS_COUNT_MAX);
+    return c0sk_range_del(self->c0_c0sk, self->c0_index, start, end, seqnoref);
+}
+
+merr_t
+c0_put_batch(struct c0 *handle, uint opc, struct kvs_batch_op *opv, uintptr_t seqnoref)
+{
+    struct c0_impl *self = c0_h2r(handle);
+
+    return c0sk_put_batch(self->c0_c0sk, opc, opv, seqnoref);
+}
+
 /*
  * Tombstone indicated by:
  *     return value == 0 && res == FOUND_TOMB
@@ -135,7 +152,7 @@ c0_prefix_del(struct c0 *handle, struct kvs_ktuple *kt, uintptr_t seqnoref)
 merr_t
 c0_get(
     struct c0 *              handle,
-    const struct kvs_ktuple *kt,
+    struct kvs_ktuple *      kt,
     u64                      view_seqno,
     uintptr_t                seqnoref,
     enum key_lookup_res *    res,
@@ -335,6 +352,12 @@ c0_cursor_update(struct c0_cursor *c0cur, u64 seqno, u32 *flags_out)
     return c0sk_cursor_update(c0cur, seqno, flags_out);
 }
 
+merr_t
+c0_cursor_rtombs(struct c0_cursor *c0cur, struct kvs_rtomb_vec *vec)
+{
+    return c0sk_cursor_rtombs(c0cur, vec);
+}
+
 merr_t
 c0_cursor_destroy(struct c0_cursor *c0cur)
 {
@@ -16,6 +16,7 @@
 #include <hse_ikvdb/c0_kvmultiset.h>
 #include <hse_ikvdb/c0_kvset_iterator.h>
 #include <hse_ikvdb/lc.h>
+#include <hse_ikvdb/kvs_merge.h>
 
 /* clang-format off */
 
@@ -35,6 +36,7 @@
  * @c0iw_coalescec:
  * @c0iw_tingesting:    time of most recent call to c0kvms_ingesting()
  * @c0iw_usage:         finalized usage metrics
+ * @c0iw_horizon:       merge operands at or below this seqno may be folded
  *
  * [HSE_REVISIT]
  */
@@ -70,6 +72,9 @@ struct c0_ingest_work {
     u64 c0iw_ingest_min_seqno;
     u64 c0iw_ingest_order;
 
+    /* Folding of merge operands */
+    u64 c0iw_horizon;
+
     /* c0iw_magic is last field to verify it didn't get clobbered
      * by c0kvs_reset().
      */
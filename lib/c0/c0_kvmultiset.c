@@ -47,6 +47,7 @@
  * @c0ms_rsvd_sn:       reserved at kvms activation for txn flush and ingestid
  * @c0ms_used:          RAM footprint when queued for ingest (bytes)
  * @c0ms_stashp:        ptr to storage in which to cache a single freed kvms
+ * @c0ms_concurrent:    c0 kvsets are concurrent (see c0kvs_create())
  * @c0ms_ingesting:     kvms is being ingested (no longer active)
  * @c0ms_ingested:
  * @c0ms_finalized:     kvms guaranteed to be frozen (no more updates)
@@ -71,6 +72,7 @@ struct c0_kvmultiset_impl {
     atomic_ulong         *c0ms_kvdb_seq;
     void * _Atomic       *c0ms_stashp;
     struct kvdb_callback *c0ms_cb;
+    bool                  c0ms_concurrent;
 
     atomic_int               c0ms_ingesting HSE_L1D_ALIGNED;
     bool                     c0ms_ingested;
@@ -715,7 +717,12 @@ c0kvms_seqno_get(struct c0_kvmultiset *handle)
 }
 
 merr_t
-c0kvms_create(u32 num_sets, atomic_ulong *kvdb_seq, void * _Atomic *stashp, struct c0_kvmultiset **multiset)
+c0kvms_create(
+    u32                    num_sets,
+    bool                   concurrent,
+    atomic_ulong          *kvdb_seq,
+    void * _Atomic        *stashp,
+    struct c0_kvmultiset **multiset)
 {
     struct c0_kvmultiset_impl *kvms = stashp ? *stashp : NULL;
     merr_t                     err;
@@ -731,6 +738,7 @@ c0kvms_create(u32 num_sets, atomic_ulong *kvdb_seq, void * _Atomic *stashp, stru
      */
     if (kvms && atomic_cas(stashp, (void *)kvms, NULL)) {
         if (kvms->c0ms_num_sets != num_sets ||
+            kvms->c0ms_concurrent != concurrent ||
             kvms->c0ms_kvdb_seq != kvdb_seq) {
 
             for (i = 0; i < kvms->c0ms_num_sets; ++i)
@@ -759,6 +767,7 @@ c0kvms_create(u32 num_sets, atomic_ulong *kvdb_seq, void * _Atomic *stashp, stru
     atomic_set(&kvms->c0ms_txhorizon, U64_MAX);
     kvms->c0ms_used = 0;
     kvms->c0ms_kvdb_seq = kvdb_seq;
+    kvms->c0ms_concurrent = concurrent;
     kvms->c0ms_stashp = stashp;
 
     atomic_set(&kvms->c0ms_ingesting, 0);
@@ -783,7 +792,7 @@ c0kvms_create(u32 num_sets, atomic_ulong *kvdb_seq, void * _Atomic *stashp, stru
         goto cached;
 
     for (i = 0; i < num_sets; ++i) {
-        err = c0kvs_create(kvdb_seq, &kvms->c0ms_seqno, &kvms->c0ms_sets[i]);
+        err = c0kvs_create(kvdb_seq, &kvms->c0ms_seqno, concurrent, &kvms->c0ms_sets[i]);
         if (ev(err)) {
             if (i > num_sets / 2)
                 break;
@@ -8,12 +8,12 @@
 #include <hse_util/fmt.h>
 #include <hse_util/keycmp.h>
 #include <hse_util/bonsai_tree.h>
-#include <hse_util/compression_lz4.h>
 #include <hse_util/event_counter.h>
 
 #include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/c0_kvset.h>
 #include <hse_ikvdb/c0_kvset_iterator.h>
+#include <hse_ikvdb/vcomp_params.h>
 
 #include "c0_kvset_internal.h"
 #include "c0_cursor.h"
@@ -26,6 +26,7 @@
 static_assert(HSE_C0_CHEAP_SZ_MIN >= HSE_KVS_VALUE_LEN_MAX + (1ul << 20), "C0_CHEAP_SZ_MIN too small");
 static_assert(HSE_C0_CHEAP_SZ_DFLT >= HSE_C0_CHEAP_SZ_MIN, "C0_CHEAP_SZ_DFLT too small");
 static_assert(HSE_C0_CHEAP_SZ_MAX >= HSE_C0_CHEAP_SZ_DFLT, "C0_CHEAP_SZ_MAX too small");
+static_assert(HSE_CORE_XLEN_EXPIRE == BONSAI_XLEN_EXPIRE, "expire flag mismatch");
 
 /**
  * struct c0kvs_ccache - cache of initialized cheap-based c0kvs objects
@@ -95,6 +96,23 @@ c0kvs_ccache_free(struct c0_kvset_impl *set)
         c0kvs_destroy_impl(set);
 }
 
+/* A concurrent c0kvs has no mutex to serialize updates to its stats,
+ * so it uses a spinlock held only for the duration of the update.
+ */
+static HSE_ALWAYS_INLINE void
+c0kvs_stats_lock(struct c0_kvset_impl *self)
+{
+    if (self->c0s_concurrent)
+        spin_lock(&self->c0s_stats_lock);
+}
+
+static HSE_ALWAYS_INLINE void
+c0kvs_stats_unlock(struct c0_kvset_impl *self)
+{
+    if (self->c0s_concurrent)
+        spin_unlock(&self->c0s_stats_lock);
+}
+
 /**
  * c0kvs_ior_stats() - method to update stats on insert/replace
  * @c0kvs:         struct c0_kvset whose stats will be updated
@@ -125,6 +143,8 @@ c0kvs_ior_stats(
 {
     size_t memsz = sizeof(struct bonsai_val) + new_value_len;
 
+    c0kvs_stats_lock(c0kvs);
+
     if (IS_IOR_INS(code)) {
         /* first insert for this key ... */
 
@@ -163,6 +183,8 @@ c0kvs_ior_stats(
 
     if (keyvals > c0kvs->c0s_keyvals)
         c0kvs->c0s_keyvals = keyvals;
+
+    c0kvs_stats_unlock(c0kvs);
 }
 
 /*
@@ -183,11 +205,30 @@ c0kvs_ior_stats(
  *     s = kvms_seqno
  */
 static u64
-c0kvs_seqno_set(struct c0_kvset_impl *c0kvs, struct bonsai_val *bv)
+c0kvs_seqno_get(struct c0_kvset_impl *c0kvs, bool unique)
 {
     atomic_ulong *sref = c0kvs->c0s_kvdb_seqno;
     u64 seq;
 
+    seq = unique ? atomic_inc_return(sref) : atomic_read(sref);
+
+    /* If KVMS seqno is valid, use it. */
+    if (HSE_UNLIKELY(atomic_read(c0kvs->c0s_kvms_seqno) != HSE_SQNREF_INVALID)) {
+        sref = c0kvs->c0s_kvms_seqno;
+        seq = unique ? atomic_inc_return(sref) : atomic_read(sref);
+    }
+
+    return seq;
+}
+
+/* Assign the seqno of a non-txn value, see c0kvs_seqno_get().
+ */
+static u64
+c0kvs_seqno_set(struct c0_kvset_impl *c0kvs, struct bonsai_val *bv)
+{
+    bool unique;
+    u64 seq;
+
     /* [HSE_REVISIT]
      * If an operation (such as txBegin or cursorCreate) obtains a view
      * after the KVDB seqno is read..
@@ -203,13 +244,13 @@ c0kvs_seqno_set(struct c0_kvset_impl *c0kvs, struct bonsai_val *bv)
      * have changed.
      */
 
-    seq = HSE_CORE_IS_PTOMB(bv->bv_value) ? atomic_inc_return(sref) : atomic_read(sref);
+    /* Prefix tombs and merge operands each get a unique seqno, the former
+     * so that they order correctly with respect to the keys they cover
+     * and the latter so that successive operands do not replace each other.
+     */
+    unique = HSE_CORE_IS_PTOMB(bv->bv_value) || HSE_CORE_IS_MERGE(bv->bv_xlen);
 
-    /* If KVMS seqno is valid, use it. */
-    if (HSE_UNLIKELY(atomic_read(c0kvs->c0s_kvms_seqno) != HSE_SQNREF_INVALID)) {
-        sref = c0kvs->c0s_kvms_seqno;
-        seq = HSE_CORE_IS_PTOMB(bv->bv_value) ? atomic_inc_return(sref) : atomic_read(sref);
-    }
+    seq = c0kvs_seqno_get(c0kvs, unique);
 
     bv->bv_seqnoref = HSE_ORDNL_TO_SQNREF(seq);
 
@@ -435,6 +476,7 @@ merr_t
 c0kvs_create(
     atomic_ulong     *kvdb_seqno,
     atomic_ulong     *kvms_seqno,
+    bool              concurrent,
     struct c0_kvset **handlep)
 {
     struct c0_kvset_impl *set;
@@ -448,7 +490,7 @@ c0kvs_create(
 
     set = c0kvs_ccache_alloc();
     if (set) {
-        if (set->c0s_alloc_sz == alloc_sz)
+        if (set->c0s_alloc_sz == alloc_sz && set->c0s_concurrent == concurrent)
             goto created;
 
         c0kvs_destroy_impl(set);
@@ -466,10 +508,16 @@ c0kvs_create(
 
     set->c0s_alloc_sz = alloc_sz;
     set->c0s_cheap = cheap;
+    set->c0s_rtombs = NULL;
+    set->c0s_concurrent = concurrent;
     atomic_set(&set->c0s_finalized, 0);
     mutex_init(&set->c0s_mutex);
+    spin_lock_init(&set->c0s_stats_lock);
 
-    err = bn_create(cheap, c0kvs_ior_cb, set, &set->c0s_broot);
+    if (concurrent)
+        err = bn_skiplist_create(cheap, c0kvs_ior_cb, set, &set->c0s_broot);
+    else
+        err = bn_create(cheap, c0kvs_ior_cb, set, &set->c0s_broot);
     if (ev(err)) {
         c0kvs_destroy_impl(set);
         return err;
@@ -535,6 +583,7 @@ c0kvs_reset(struct c0_kvset *handle, size_t sz)
 
     bn_reset(set->c0s_broot);
 
+    set->c0s_rtombs = NULL;
     atomic_set(&set->c0s_finalized, 0);
     set->c0s_num_entries = 0;
     set->c0s_num_tombstones = 0;
@@ -564,7 +613,7 @@ c0kvs_alloc(struct c0_kvset *handle, size_t align, size_t sz)
     void *                mem;
 
     c0kvs_lock(impl);
-    mem = cheap_memalign(impl->c0s_cheap, align, sz);
+    mem = bn_memalign(impl->c0s_broot, align, sz);
     c0kvs_unlock(impl);
 
     return mem;
@@ -579,9 +628,13 @@ c0kvs_putdel(
 {
     merr_t err;
 
-    c0kvs_lock(self);
-    err = bn_insert_or_replace(self->c0s_broot, skey, sval);
-    c0kvs_unlock(self);
+    if (self->c0s_concurrent) {
+        err = bn_insert_or_replace(self->c0s_broot, skey, sval);
+    } else {
+        c0kvs_lock(self);
+        err = bn_insert_or_replace(self->c0s_broot, skey, sval);
+        c0kvs_unlock(self);
+    }
 
     /* Callers putting keys into the active kvms must hold the
      * RCU read lock.  As such, a c0kvset undergoing ingest will
@@ -645,6 +698,157 @@ c0kvs_prefix_del(
     return c0kvs_putdel(self, &skey, &sval, &key->kt_seqno);
 }
 
+merr_t
+c0kvs_range_del(
+    struct c0_kvset         *handle,
+    u16                      skidx,
+    struct kvs_ktuple       *start,
+    const struct kvs_ktuple *end,
+    uintptr_t                seqnoref)
+{
+    struct c0_kvset_impl *self = c0_kvset_h2r(handle);
+    struct c0_rtomb      *rt;
+    u64                   seq;
+    void                 *kdata;
+
+    c0kvs_lock(self);
+    rt = bn_memalign(self->c0s_broot, __alignof__(*rt),
+                     sizeof(*rt) + start->kt_len + end->kt_len);
+    if (ev(!rt)) {
+        c0kvs_unlock(self);
+        return merr(ENOMEM);
+    }
+
+    kdata = rt + 1;
+    memcpy(kdata, start->kt_data, start->kt_len);
+    memcpy(kdata + start->kt_len, end->kt_data, end->kt_len);
+
+    /* Like prefix tombs, range tombs take a unique seqno so that they
+     * order correctly with respect to the keys they cover.
+     */
+    if (HSE_SQNREF_SINGLE_P(seqnoref))
+        seq = c0kvs_seqno_get(self, true);
+    else
+        seq = HSE_SQNREF_TO_ORDNL(seqnoref);
+
+    rt->cr_rt.kr_start = kdata;
+    rt->cr_rt.kr_start_len = start->kt_len;
+    rt->cr_rt.kr_end = kdata + start->kt_len;
+    rt->cr_rt.kr_end_len = end->kt_len;
+    rt->cr_rt.kr_seq = seq;
+    rt->cr_skidx = skidx;
+    rt->cr_next = self->c0s_rtombs;
+
+    rcu_assign_pointer(self->c0s_rtombs, rt);
+
+    c0kvs_stats_lock(self);
+    self->c0s_keyb += start->kt_len + end->kt_len;
+    self->c0s_memsz += sizeof(*rt) + start->kt_len + end->kt_len;
+    c0kvs_stats_unlock(self);
+    c0kvs_unlock(self);
+
+    /* See c0kvs_putdel() */
+    assert(atomic_read(&self->c0s_finalized) == 0);
+
+    start->kt_seqno = seq;
+
+    return 0;
+}
+
+u64
+c0kvs_rtomb_seq(struct c0_kvset *handle, u16 skidx, const struct kvs_ktuple *kt, u64 view_seqno)
+{
+    struct c0_kvset_impl *self = c0_kvset_h2r(handle);
+    struct c0_rtomb      *rt;
+    struct key_obj        kobj;
+    u64                   seq = 0;
+
+    key2kobj(&kobj, kt->kt_data, kt->kt_len);
+
+    for (rt = rcu_dereference(self->c0s_rtombs); rt; rt = rcu_dereference(rt->cr_next)) {
+        if (rt->cr_skidx != skidx || rt->cr_rt.kr_seq <= seq || rt->cr_rt.kr_seq > view_seqno)
+            continue;
+
+        if (kvs_rtomb_covers(&rt->cr_rt, &kobj))
+            seq = rt->cr_rt.kr_seq;
+    }
+
+    return seq;
+}
+
+merr_t
+c0kvs_rtomb_collect(
+    struct c0_kvset      *handle,
+    u16                   skidx,
+    u64                   view_seqno,
+    struct kvs_rtomb_vec *vec)
+{
+    struct c0_kvset_impl *self = c0_kvset_h2r(handle);
+    struct c0_rtomb      *rt;
+
+    for (rt = rcu_dereference(self->c0s_rtombs); rt; rt = rcu_dereference(rt->cr_next)) {
+        merr_t err;
+
+        if (rt->cr_skidx != skidx || rt->cr_rt.kr_seq > view_seqno)
+            continue;
+
+        err = kvs_rtomb_vec_add(vec, &rt->cr_rt);
+        if (ev(err))
+            return err;
+    }
+
+    return 0;
+}
+
+merr_t
+c0kvs_putdel_batch(
+    struct c0_kvset     *handle,
+    struct kvs_batch_op *opv,
+    const uint8_t       *idxv,
+    uint                 idxc,
+    uintptr_t            seqnoref,
+    uint                *donep)
+{
+    struct c0_kvset_impl *self = c0_kvset_h2r(handle);
+    merr_t                err = 0;
+    uint                  i;
+
+    if (!self->c0s_concurrent)
+        c0kvs_lock(self);
+
+    for (i = 0; i < idxc; ++i) {
+        struct kvs_batch_op *op = opv + idxv[i];
+        struct kvs_ktuple   *kt = &op->kbo_kt;
+        struct bonsai_skey   skey;
+        struct bonsai_sval   sval;
+
+        if (op->kbo_op == KVS_BATCH_PUT) {
+            bn_skey_init(kt->kt_data, kt->kt_len, kt->kt_flags, op->kbo_skidx, &skey);
+            bn_sval_init(op->kbo_vt.vt_data, op->kbo_vt.vt_xlen, seqnoref, &sval);
+        } else {
+            assert(op->kbo_op == KVS_BATCH_DEL);
+            bn_skey_init(kt->kt_data, kt->kt_len, 0, op->kbo_skidx, &skey);
+            bn_sval_init(HSE_CORE_TOMB_REG, 0, seqnoref, &sval);
+        }
+
+        err = bn_insert_or_replace(self->c0s_broot, &skey, &sval);
+        if (err)
+            break;
+
+        kt->kt_seqno = HSE_SQNREF_TO_ORDNL(sval.bsv_seqnoref);
+    }
+
+    if (!self->c0s_concurrent)
+        c0kvs_unlock(self);
+
+    /* See c0kvs_putdel() */
+    assert(atomic_read(&self->c0s_finalized) == 0);
+
+    *donep = i;
+
+    return err;
+}
+
 u64
 c0kvs_get_element_count(struct c0_kvset *handle)
 {
@@ -682,6 +886,8 @@ c0kvs_usage(struct c0_kvset *handle, struct c0_usage *usage)
 /*
  * If key is found:
  *     return value == 0 && *res == FOUND_VAL && *oseqnoref == seqnoref of match
+ * If merge operand is found:
+ *     return value == 0 && *res == FOUND_MRG && *oseqnoref == seqnoref of match
  * If tombstone is found:
  *     return value == 0 && *res == FOUND_TMB && *oseqnoref == seqnoref of match
  * If key is not found:
@@ -725,7 +931,7 @@ c0kvs_get_excl(
 
     *oseqnoref = val->bv_seqnoref;
 
-    if (HSE_CORE_IS_TOMB(val->bv_value)) {
+    if (HSE_CORE_IS_TOMB(val->bv_value) || kvs_expired(bonsai_val_expire(val))) {
         *res = FOUND_TMB;
         return 0;
     }
@@ -741,8 +947,8 @@ c0kvs_get_excl(
         ulen = bonsai_val_ulen(val);
 
         if (clen > 0) {
-            err = compress_lz4_ops.cop_decompress(
-                val->bv_value, clen, vbuf->b_buf, vbuf->b_buf_sz, &outlen);
+            err = vcomp_decompress(
+                val->bv_value, clen, NULL, vbuf->b_buf, vbuf->b_buf_sz, &outlen);
             if (ev(err))
                 return err;
 
@@ -755,7 +961,7 @@ c0kvs_get_excl(
         }
     }
 
-    *res = FOUND_VAL;
+    *res = HSE_CORE_IS_MERGE(val->bv_xlen) ? FOUND_MRG : FOUND_VAL;
 
     return 0;
 }
@@ -816,7 +1022,8 @@ c0kvs_pfx_probe_cmn(
 
     /* found a key with the requested pfx */
     for (; kv != &root->br_kv; kv = kv->bkv_next) {
-        u32 klen = key_imm_klen(&kv->bkv_key_imm);
+        u32  klen = key_imm_klen(&kv->bkv_key_imm);
+        bool hidden = false;
 
         if (keycmp_prefix(key->kt_data, key->kt_len, kv->bkv_key, klen))
             break; /* eof */
@@ -841,14 +1048,20 @@ c0kvs_pfx_probe_cmn(
              * count this key
              */
         } else {
+            struct key_obj kobj;
+
             if (val_seq < pt_seq)
                 continue;
             if (val_seq < max_seq)
                 continue;
+
+            /* A range tomb hides the key just as a point tomb would */
+            key2kobj(&kobj, kv->bkv_key, klen);
+            hidden = val_seq < qctx_rtomb_seq(qctx, &kobj, view_seqno);
         }
 
-        /* add to tomblist if a tombstone was encountered */
-        if (HSE_CORE_IS_TOMB(val->bv_value)) {
+        /* add to tomblist if a tombstone (or an expired value) was encountered */
+        if (hidden || HSE_CORE_IS_TOMB(val->bv_value) || kvs_expired(bonsai_val_expire(val))) {
             err = qctx_tomb_insert(qctx, kv->bkv_key + klen - sfx_len, sfx_len);
             if (ev(err))
                 break;
@@ -875,8 +1088,8 @@ c0kvs_pfx_probe_cmn(
                 ulen = bonsai_val_ulen(val);
 
                 if (clen > 0) {
-                    err = compress_lz4_ops.cop_decompress(
-                        val->bv_value, clen, vbuf->b_buf, vbuf->b_buf_sz, &outlen);
+                    err = vcomp_decompress(
+                        val->bv_value, clen, NULL, vbuf->b_buf, vbuf->b_buf_sz, &outlen);
                     if (ev(err))
                         return err;
 
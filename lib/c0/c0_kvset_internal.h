@@ -8,8 +8,22 @@
 
 #include <hse_util/bonsai_tree.h>
 
+#include <hse_ikvdb/kvs_rtomb.h>
+
 #define c0_kvset_h2r(handle) container_of(handle, struct c0_kvset_impl, c0s_handle)
 
+/**
+ * struct c0_rtomb - a range tombstone in a c0 kvset
+ * @cr_next:  next (older) range tombstone
+ * @cr_rt:    range tombstone, whose keys follow this struct
+ * @cr_skidx: index of the kvs to which the tombstone applies
+ */
+struct c0_rtomb {
+    struct c0_rtomb *cr_next;
+    struct kvs_rtomb cr_rt;
+    u16              cr_skidx;
+};
+
 /**
  * c0_kvset_impl - private representation of a c0 kvset
  * @c0s_handle:            handle for users of struct c0_kvset_impl's
@@ -19,10 +33,13 @@
  * @c0s_ccache_sz:         cheap's RAM footprint in the cheap cache
  * @c0s_reset_sz:          size of cheap used by fully setup c0kkvs
  * @c0s_finalized:         kvset is frozen and undergoing c0 ingest
+ * @c0s_concurrent:        bonsai tree is a concurrent skiplist
  * @c0s_next:              cheap cache linkage
+ * @c0s_rtombs:            range tombstones, newest first
  * @c0s_kvdb_seqno:        pointer to kvdb seqno
  * @c0s_kvms_seqno:        pointer to kvms seqno
  * @c0s_mutex:             mutex for bonsai tree updates
+ * @c0s_stats_lock:        protects stats in lieu of c0s_mutex if c0s_concurrent
  * @c0s_num_entries:       how many entries (includes tombstones)
  * @c0s_num_tombstones:    how many tombstones
  * @c0s_keyb:              total key bytes
@@ -43,7 +60,9 @@ struct c0_kvset_impl {
     u32                   c0s_ccache_sz;
     u32                   c0s_reset_sz;
     atomic_int            c0s_finalized;
+    bool                  c0s_concurrent;
     struct c0_kvset_impl *c0s_next;
+    struct c0_rtomb      *c0s_rtombs;
 
     /* these apply only to non-txn operations. */
     atomic_ulong *c0s_kvdb_seqno;
@@ -51,7 +70,8 @@ struct c0_kvset_impl {
 
     struct mutex c0s_mutex HSE_ACP_ALIGNED;
 
-    u32 c0s_num_entries HSE_L1D_ALIGNED;
+    spinlock_t c0s_stats_lock HSE_L1D_ALIGNED;
+    u32 c0s_num_entries;
     u32 c0s_num_tombstones;
     u32 c0s_keyb;
     u32 c0s_valb;
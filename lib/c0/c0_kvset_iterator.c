@@ -72,9 +72,9 @@ c0_kvset_iterator_rnext(struct element_source *source, void **element)
         bkv->bkv_flags |= BKV_FLAG_PTOMB;
 
     iter->c0it_prev = bkv;
-    iter->c0it_next = bkv->bkv_prev;
+    iter->c0it_next = bn_kv_prev(bkv);
 
-    __builtin_prefetch(bkv->bkv_prev);
+    __builtin_prefetch(iter->c0it_next);
     __builtin_prefetch(bkv->bkv_values);
 
     bkv->bkv_es = source;
@@ -100,7 +100,7 @@ c0_kvset_iterator_unget(struct element_source *source)
         return false;
     }
 
-    iter->c0it_prev = bkv->bkv_prev;
+    iter->c0it_prev = bn_kv_prev(bkv);
     iter->c0it_next = bkv;
 
     return true;
@@ -142,6 +142,9 @@ c0_kvset_iterator_runget(struct element_source *source)
  * to see C-E-eof, or C-D-E.  Assuming C-D-E, if you immediately called
  * prev, there is a race on updating the list in the opposite direction,
  * so you might see prev as either D or C.
+ *
+ * Reverse traversal goes through bn_kv_prev() because the prev links of
+ * a concurrent (skiplist) c0kvs are only hints until it is finalized.
  */
 void
 c0_kvset_iterator_init(
@@ -157,10 +160,10 @@ c0_kvset_iterator_init(
     if (!(flags & C0_KVSET_ITER_FLAG_REVERSE)) {
         iter->c0it_handle = es_make(c0_kvset_iterator_next, c0_kvset_iterator_unget, 0);
         iter->c0it_next = root->br_kv.bkv_next;
-        iter->c0it_prev = root->br_kv.bkv_prev;
+        iter->c0it_prev = bn_kv_prev(&root->br_kv);
     } else {
         iter->c0it_handle = es_make(c0_kvset_iterator_rnext, c0_kvset_iterator_runget, 0);
-        iter->c0it_next = root->br_kv.bkv_prev;
+        iter->c0it_next = bn_kv_prev(&root->br_kv);
         iter->c0it_prev = root->br_kv.bkv_next;
     }
 }
@@ -195,7 +198,7 @@ c0_kvset_iterator_seek(
     }
 
     if (!(iter->c0it_flags & C0_KVSET_ITER_FLAG_REVERSE))
-        iter->c0it_prev = kv->bkv_prev;
+        iter->c0it_prev = bn_kv_prev(kv);
     else
         iter->c0it_prev = kv->bkv_next;
 
@@ -237,7 +240,7 @@ c0_kvset_iterator_eof(struct c0_kvset_iterator *iter)
     if (!(iter->c0it_flags & C0_KVSET_ITER_FLAG_REVERSE))
         return empty && prev->bkv_next == next;
     else
-        return empty && prev->bkv_prev == next;
+        return empty && bn_kv_prev(prev) == next;
 }
 
 struct element_source *
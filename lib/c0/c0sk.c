@@ -281,6 +281,44 @@ c0sk_prefix_del(struct c0sk *handle, u16 skidx, struct kvs_ktuple *kt, uintptr_t
     return c0sk_putdel(self, skidx, C0SK_OP_PREFIX_DEL, kt, NULL, seqnoref);
 }
 
+merr_t
+c0sk_range_del(
+    struct c0sk       *handle,
+    u16                skidx,
+    struct kvs_ktuple *start,
+    struct kvs_ktuple *end,
+    uintptr_t          seqnoref)
+{
+    struct c0sk_impl *self = c0sk_h2r(handle);
+    struct kvs_vtuple vt;
+
+    kvs_vtuple_init(&vt, (void *)end->kt_data, end->kt_len);
+
+    return c0sk_putdel(self, skidx, C0SK_OP_RANGE_DEL, start, &vt, seqnoref);
+}
+
+merr_t
+c0sk_put_batch(struct c0sk *handle, uint opc, struct kvs_batch_op *opv, uintptr_t seqnoref)
+{
+    struct c0sk_impl *self = c0sk_h2r(handle);
+    uint              puts, dels, i;
+    merr_t            err;
+
+    err = c0sk_putdel_batch(self, opc, opv, seqnoref);
+
+    if (!err && perfc_ison(&self->c0sk_pc_op, PERFC_RA_C0SKOP_PUT)) {
+        for (i = puts = dels = 0; i < opc; ++i) {
+            puts += (opv[i].kbo_op == KVS_BATCH_PUT);
+            dels += (opv[i].kbo_op == KVS_BATCH_DEL);
+        }
+
+        perfc_add(&self->c0sk_pc_op, PERFC_RA_C0SKOP_PUT, puts);
+        perfc_add(&self->c0sk_pc_op, PERFC_RA_C0SKOP_DEL, dels);
+    }
+
+    return err;
+}
+
 /*
  * Tombstone indicated by:
  *     return value == 0 && res == FOUND_TOMB
@@ -290,7 +328,7 @@ c0sk_get(
     struct c0sk *            handle,
     u16                      skidx,
     u32                      pfx_len,
-    const struct kvs_ktuple *kt,
+    struct kvs_ktuple *      kt,
     u64                      view_seq,
     uintptr_t                seqref,
     enum key_lookup_res *    res,
@@ -300,7 +338,7 @@ c0sk_get(
     struct c0sk_impl *    self;
     uintptr_t             key_seqref = 0, ptomb_seqref = 0;
     u64                   start;
-    u64                   pfx_seq = 0, val_seq = 0;
+    u64                   pfx_seq = 0, rt_seq = 0, val_seq = 0;
     u64                   seq;
     merr_t                err = 0;
 
@@ -333,6 +371,11 @@ c0sk_get(
                 pfx_seq = seq;
         }
 
+        /* Range tombs are kept in the ptomb c0kvset. */
+        seq = c0kvs_rtomb_seq(c0kvms_ptomb_c0kvset_get(c0kvms), skidx, kt, view_seq);
+        if (seq > rt_seq)
+            rt_seq = seq;
+
         /* Search for latest value of key w/ seqno <= iseqno. */
         c0kvs = c0kvms_get_hashed_c0kvset(c0kvms, kt->kt_hash);
         err = c0kvs_get_rcu(c0kvs, skidx, kt, view_seq, seqref, res, vbuf, &key_seqref);
@@ -346,9 +389,14 @@ c0sk_get(
     }
     rcu_read_unlock();
 
-    if (pfx_seq > val_seq) {
+    if (pfx_seq > val_seq && pfx_seq >= rt_seq) {
         *res = FOUND_PTMB;
         vbuf->b_len = 0;
+    } else if (rt_seq > val_seq) {
+        *res = FOUND_TMB;
+        vbuf->b_len = 0;
+    } else if (*res == FOUND_MRG) {
+        kt->kt_seqno = val_seq;
     }
 
     if (start > 0) {
@@ -375,6 +423,7 @@ c0sk_pfx_probe(
 {
     struct c0_kvmultiset *c0kvms;
     struct c0sk_impl *    self;
+    struct kvs_rtomb_vec  rtombs = { 0 };
     uintptr_t             ptomb_seqref = 0;
     u64                   pfx_seq = 0;
     merr_t                err = 0;
@@ -387,9 +436,30 @@ c0sk_pfx_probe(
     if (kt->kt_len < pfx_len)
         pfx_len = 0;
 
+    rcu_read_lock();
+
+    /* Gather the range tombs of every c0_kvmultiset up front, they hide
+     * older values here as well as in lc and cn.
+     */
+    cds_list_for_each_entry_rcu(c0kvms, &self->c0sk_kvmultisets, c0ms_link)
+    {
+        err = c0kvs_rtomb_collect(c0kvms_ptomb_c0kvset_get(c0kvms), skidx, view_seq, &rtombs);
+        if (ev(err))
+            break;
+    }
+
+    if (!err && rtombs.krv_cnt > 0)
+        err = qctx_rtombs_add(qctx, rtombs.krv_rtv, rtombs.krv_cnt, kt, view_seq);
+
+    kvs_rtomb_vec_fini(&rtombs);
+
+    if (ev(err)) {
+        rcu_read_unlock();
+        return err;
+    }
+
     /* Search the list of c0_kvmultisets from newest to oldest...
      */
-    rcu_read_lock();
     cds_list_for_each_entry_rcu(c0kvms, &self->c0sk_kvmultisets, c0ms_link)
     {
         struct c0_kvset *c0kvs;
@@ -497,6 +567,14 @@ c0sk_open(
         goto errout;
     }
 
+    tdmax = clamp_t(uint, kvdb_rp->c0_build_threads, 1, HSE_C0_BUILD_THREADS_MAX);
+
+    c0sk->c0sk_wq_build = alloc_workqueue("hse_c0sk_build", 0, 1, tdmax);
+    if (!c0sk->c0sk_wq_build) {
+        err = merr(ENOMEM);
+        goto errout;
+    }
+
     c0sk->c0sk_ingest_width = kvdb_rp->c0_ingest_width;
 
     if (gen > 0)
@@ -504,7 +582,8 @@ c0sk_open(
 
     stashp = HSE_LIKELY(atomic_read(&c0sk->c0sk_replaying) == 0) ? &c0sk->c0sk_stash : NULL;
 
-    err = c0kvms_create(c0sk->c0sk_ingest_width, c0sk->c0sk_kvdb_seq, stashp, &c0kvms);
+    err = c0kvms_create(
+        c0sk->c0sk_ingest_width, kvdb_rp->c0_concurrent, c0sk->c0sk_kvdb_seq, stashp, &c0kvms);
     if (err)
         goto errout;
 
@@ -531,6 +610,7 @@ errout:
         if (c0sk) {
             destroy_workqueue(c0sk->c0sk_wq_ingest);
             destroy_workqueue(c0sk->c0sk_wq_maint);
+            destroy_workqueue(c0sk->c0sk_wq_build);
             cv_destroy(&c0sk->c0sk_kvms_cv);
             mutex_destroy(&c0sk->c0sk_sync_mutex);
             mutex_destroy(&c0sk->c0sk_kvms_mutex);
@@ -581,6 +661,7 @@ c0sk_close(struct c0sk *handle)
     }
 
     destroy_workqueue(self->c0sk_wq_ingest);
+    destroy_workqueue(self->c0sk_wq_build);
     destroy_workqueue(self->c0sk_wq_maint);
     c0kvms_destroy_cache(&self->c0sk_stash);
     cv_destroy(&self->c0sk_kvms_cv);
@@ -1045,6 +1126,24 @@ c0sk_cursor_bind_txn(struct c0_cursor *cur, struct kvdb_ctxn *ctxn)
     cur->c0cur_ctxn = ctxn;
 }
 
+merr_t
+c0sk_cursor_rtombs(struct c0_cursor *cur, struct kvs_rtomb_vec *vec)
+{
+    merr_t err = 0;
+    int i;
+
+    rcu_read_lock();
+    for (i = 0; i < cur->c0cur_cnt && !err; i++) {
+        struct c0_kvmultiset *kvms = cur->c0cur_curv[i]->c0mc_kvms;
+
+        err = c0kvs_rtomb_collect(c0kvms_ptomb_c0kvset_get(kvms), cur->c0cur_skidx,
+                                  cur->c0cur_seqno, vec);
+    }
+    rcu_read_unlock();
+
+    return err;
+}
+
 merr_t
 c0sk_cursor_destroy(struct c0_cursor *cur)
 {
@@ -1205,6 +1304,7 @@ c0sk_cursor_read(struct c0_cursor *cur, struct kvs_cursor_element *elem, bool *e
         key2kobj(&elem->kce_kobj, bkv->bkv_key, key_imm_klen(&bkv->bkv_key_imm));
 
         elem->kce_is_ptomb = false;
+        elem->kce_is_merge = HSE_CORE_IS_MERGE(val->bv_xlen);
         elem->kce_complen = 0;
         elem->kce_seqnoref = val->bv_seqnoref;
 
@@ -1212,6 +1312,9 @@ c0sk_cursor_read(struct c0_cursor *cur, struct kvs_cursor_element *elem, bool *e
             kvs_vtuple_init(&elem->kce_vt, val->bv_value, val->bv_xlen);
             if (HSE_CORE_IS_PTOMB(val->bv_value))
                 elem->kce_is_ptomb = true;
+        } else if (kvs_expired(bonsai_val_expire(val))) {
+            kvs_vtuple_init(&elem->kce_vt, HSE_CORE_TOMB_REG, 0);
+            elem->kce_is_merge = false;
         } else {
             kvs_vtuple_init(&elem->kce_vt, val->bv_value, bonsai_val_ulen(val));
             elem->kce_complen = bonsai_val_clen(val);
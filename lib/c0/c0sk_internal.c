@@ -24,6 +24,7 @@
 #include <hse_ikvdb/cn.h>
 #include <hse_ikvdb/cndb.h>
 #include <hse_ikvdb/kvset_builder.h>
+#include <hse_ikvdb/kvs_rtomb.h>
 #include <hse_ikvdb/c0_kvmultiset.h>
 #include <hse_ikvdb/c0_kvset.h>
 #include <hse_ikvdb/c0_kvset_iterator.h>
@@ -288,18 +289,110 @@ c0sk_bkv_sort_vals(struct bonsai_kv *bkv, struct bonsai_val **val_head)
     } while (unsorted > 0);
 }
 
+static uint64_t
+c0sk_horizon_get(struct c0sk_impl *c0sk)
+{
+    if (!c0sk->c0sk_cb)
+        return 0;
+
+    return ikvdb_horizon(c0sk->c0sk_cb->kc_cbarg);
+}
+
+/* Emit the accumulated merge operand (or the value to which it was resolved)
+ * and mark the accumulator consumed.
+ */
+static merr_t
+c0sk_cningest_merge_emit(struct kvset_builder *bldr, struct kvs_merge *km, struct key_obj *ko)
+{
+    km->km_active = false;
+
+    if (km->km_opnd)
+        return kvset_builder_add_mval(bldr, km->km_seq, km->km_buf, km->km_len);
+
+    return kvset_builder_add_val(bldr, ko, km->km_buf, km->km_len, km->km_seq, 0);
+}
+
+/**
+ * struct c0_ingest_done - completion of the parts built on c0sk_wq_build
+ * @c0id_lock:    protects %c0id_pending
+ * @c0id_cv:      signaled when %c0id_pending drops to zero
+ * @c0id_pending: number of parts still being built
+ */
+struct c0_ingest_done {
+    struct mutex c0id_lock;
+    struct cv    c0id_cv;
+    uint         c0id_pending;
+};
+
+/**
+ * struct c0_ingest_part - a range of kvses whose kvsets are built by one thread
+ * @c0ip_work:     work struct for building on c0sk_wq_build
+ * @c0ip_ingest:   ingest to which the part belongs
+ * @c0ip_bkvcv:    cn ingest lists from the kvms and from lc
+ * @c0ip_startv:   index of the part's first entry in each list
+ * @c0ip_endv:     index one past the part's last entry in each list
+ * @c0ip_skidx_lo: first kvs of the part
+ * @c0ip_skidx_hi: last kvs of the part
+ * @c0ip_err:      result of the build
+ * @c0ip_done:     completion to signal once the part is built
+ * @c0ip_merge:    merge operand accumulator (allocated on first use)
+ */
+struct c0_ingest_part {
+    struct work_struct     c0ip_work;
+    struct c0_ingest_work *c0ip_ingest;
+    struct bkv_collection *c0ip_bkvcv[2];
+    size_t                 c0ip_startv[2];
+    size_t                 c0ip_endv[2];
+    uint                   c0ip_skidx_lo;
+    uint                   c0ip_skidx_hi;
+    merr_t                 c0ip_err;
+    struct c0_ingest_done *c0ip_done;
+    struct kvs_merge       c0ip_merge;
+};
+
+/* Get the kvset builder for the given kvs, creating it if necessary.
+ */
+static merr_t
+c0sk_cningest_bldr_get(struct c0_ingest_work *ingest, u16 skidx, struct kvset_builder **bldrp)
+{
+    struct c0sk_impl *    c0sk = c0sk_h2r(ingest->c0iw_c0sk);
+    struct cn *           cn = c0sk->c0sk_cnv[skidx];
+    struct kvset_builder *bldr = ingest->c0iw_bldrs[skidx];
+    merr_t                err;
+
+    if (!bldr) {
+        assert(cn);
+
+        ingest->c0iw_kvsetidv[skidx] = cndb_kvsetid_mint(cn_get_cndb(cn));
+
+        err = kvset_builder_create(&bldr, cn, cn_get_ingest_perfc(cn),
+                                   ingest->c0iw_kvsetidv[skidx]);
+        if (ev(err))
+            return err;
+
+        kvset_builder_set_agegroup(bldr, HSE_MPOLICY_AGE_ROOT);
+
+        ingest->c0iw_bldrs[skidx] = bldr;
+    }
+
+    *bldrp = bldr;
+
+    return 0;
+}
+
 /**
  * c0sk_cningest_cb() - Callback function for bkv_collection. Called once for every pair of
  *                      key and its value list.
  *
- * @rock:  Context - ingest worker object
+ * @rock:  Context - ingest part object
  * @bkv:   Key
  * @vlist: List of values
  */
 static merr_t
 c0sk_cningest_cb(void *rock, struct bonsai_kv *bkv, struct bonsai_val *vlist)
 {
-    struct c0_ingest_work *ingest = rock;
+    struct c0_ingest_part *part = rock;
+    struct c0_ingest_work *ingest = part->c0ip_ingest;
     struct bonsai_val *    val;
     merr_t                 err;
     u64                    seqno_prev, pt_seqno_prev;
@@ -308,29 +401,27 @@ c0sk_cningest_cb(void *rock, struct bonsai_kv *bkv, struct bonsai_val *vlist)
     u16                    skidx = key_immediate_index(&bkv->bkv_key_imm);
     struct c0sk_impl *     c0sk = c0sk_h2r(ingest->c0iw_c0sk);
     struct cn *            cn = c0sk->c0sk_cnv[skidx];
-    struct kvset_builder **kvbldrs = ingest->c0iw_bldrs;
-    struct kvset_builder * bldr = kvbldrs[skidx];
+    struct kvset_builder * bldr;
+    struct kvs_merge *     km = &part->c0ip_merge;
+    const struct kvs_merge_op *mop;
 
     assert(bkv);
     assert(vlist);
+    assert(skidx >= part->c0ip_skidx_lo && skidx <= part->c0ip_skidx_hi);
 
-    if (!bldr) {
-        assert(cn);
+    err = c0sk_cningest_bldr_get(ingest, skidx, &bldr);
+    if (ev(err))
+        return err;
 
-        ingest->c0iw_kvsetidv[skidx] = cndb_kvsetid_mint(cn_get_cndb(cn));
+    c0sk_bkv_sort_vals(bkv, &vlist);
 
-        err = kvset_builder_create(&bldr, cn, cn_get_ingest_perfc(cn),
-                                   ingest->c0iw_kvsetidv[skidx]);
+    mop = cn_get_merge_op(cn);
+    if (mop && !km->km_buf) {
+        err = kvs_merge_init(km);
         if (ev(err))
             return err;
-
-        kvset_builder_set_agegroup(bldr, HSE_MPOLICY_AGE_ROOT);
-
-        kvbldrs[skidx] = bldr;
     }
 
-    c0sk_bkv_sort_vals(bkv, &vlist);
-
     seqno_prev = U64_MAX;
     pt_seqno_prev = U64_MAX;
     key2kobj(&ko, bkv->bkv_key, key_imm_klen(&bkv->bkv_key_imm));
@@ -339,6 +430,10 @@ c0sk_cningest_cb(void *rock, struct bonsai_kv *bkv, struct bonsai_val *vlist)
         enum hse_seqno_state state HSE_MAYBE_UNUSED;
         int                        rc;
         u64                        seqno = 0;
+        void                      *vdata = val->bv_value;
+        uint                       vlen = bonsai_val_ulen(val);
+        uint                       clen = bonsai_val_clen(val);
+        u32                        expire = 0;
 
         state = seqnoref_to_seqno(val->bv_seqnoref, &seqno);
         assert(state == HSE_SQNREF_STATE_DEFINED);
@@ -355,9 +450,66 @@ c0sk_cningest_cb(void *rock, struct bonsai_kv *bkv, struct bonsai_val *vlist)
         else
             seqno_prev = seqno;
 
-        err = kvset_builder_add_val(
-            bldr, &ko, val->bv_value, bonsai_val_ulen(val), seqno, bonsai_val_clen(val));
+        /* A value that has already expired is ingested as a tombstone.
+         */
+        if (!HSE_CORE_IS_TOMB(vdata) && !HSE_CORE_IS_MERGE(val->bv_xlen)) {
+            expire = bonsai_val_expire(val);
+            if (kvs_expired(expire)) {
+                vdata = HSE_CORE_TOMB_REG;
+                vlen = clen = expire = 0;
+            }
+        }
+
+        /* Merge operands not visible to any view are folded into each other and,
+         * if this key's list also has the value they update, into that value.
+         */
+        if (km->km_active) {
+            if (HSE_CORE_IS_MERGE(val->bv_xlen)) {
+                if (!kvs_merge_fold(km, val->bv_value, bonsai_val_ulen(val),
+                                    HSE_KVS_MERGE_OPERAND_LEN_MAX))
+                    continue;
+
+                err = c0sk_cningest_merge_emit(bldr, km, &ko);
+                if (ev(err))
+                    return err;
+
+                kvs_merge_start(km, mop, &ko, val->bv_value, bonsai_val_ulen(val), seqno);
+                continue;
+            }
+
+            if (vdata == HSE_CORE_TOMB_REG)
+                kvs_merge_resolve(km, NULL, 0, HSE_KVS_VALUE_LEN_MAX);
+            else if (!HSE_CORE_IS_PTOMB(vdata) && !clen && !expire)
+                kvs_merge_resolve(km, vdata, vlen, HSE_KVS_VALUE_LEN_MAX);
 
+            err = c0sk_cningest_merge_emit(bldr, km, &ko);
+            if (ev(err))
+                return err;
+
+            if (!km->km_opnd)
+                break; /* resolved, older values are obsolete */
+        }
+
+        if (HSE_CORE_IS_MERGE(val->bv_xlen)) {
+            if (mop && seqno <= ingest->c0iw_horizon) {
+                kvs_merge_start(km, mop, &ko, val->bv_value, bonsai_val_ulen(val), seqno);
+                continue;
+            }
+
+            err = kvset_builder_add_mval(bldr, seqno, val->bv_value, bonsai_val_ulen(val));
+        } else {
+            if (expire)
+                kvset_builder_set_expire(bldr, expire);
+
+            err = kvset_builder_add_val(bldr, &ko, vdata, vlen, seqno, clen);
+        }
+
+        if (ev(err))
+            return err;
+    }
+
+    if (km->km_active) {
+        err = c0sk_cningest_merge_emit(bldr, km, &ko);
         if (ev(err))
             return err;
     }
@@ -541,6 +693,199 @@ c0sk_merge_loop(
     return 0;
 }
 
+/* Add the kvms' range tombstones to the kvset being built for each kvs.
+ * Range tombstones are not ordered with respect to the keys they cover
+ * and are stored in the hblock, so they are added before the keys are
+ * built by c0sk_ingest_build().
+ */
+static merr_t
+c0sk_cningest_rtombs(struct c0_ingest_work *ingest, u64 min_seq, u64 max_seq)
+{
+    struct c0sk_impl *   c0sk = c0sk_h2r(ingest->c0iw_c0sk);
+    struct c0_kvset *    c0kvs = c0kvms_ptomb_c0kvset_get(ingest->c0iw_c0kvms);
+    struct kvs_rtomb_vec vec = { 0 };
+    merr_t               err = 0;
+
+    for (u16 skidx = 0; skidx < HSE_KVS_COUNT_MAX && !err; skidx++) {
+        if (!c0sk->c0sk_cnv[skidx])
+            continue;
+
+        kvs_rtomb_vec_reset(&vec);
+
+        err = c0kvs_rtomb_collect(c0kvs, skidx, max_seq, &vec);
+        if (ev(err))
+            break;
+
+        for (uint i = 0; i < vec.krv_cnt; i++) {
+            struct kvset_builder *bldr;
+
+            if (vec.krv_rtv[i].kr_seq < min_seq)
+                continue;
+
+            err = c0sk_cningest_bldr_get(ingest, skidx, &bldr);
+            if (ev(err))
+                break;
+
+            err = kvset_builder_add_rtomb(bldr, &vec.krv_rtv[i]);
+            if (ev(err))
+                break;
+        }
+    }
+
+    kvs_rtomb_vec_fini(&vec);
+
+    return err;
+}
+
+/* Merge and build the part's range of the cn ingest lists, then finish
+ * the kvsets of all the kvses in the part.  Each kvs belongs to exactly
+ * one part, so parts do not share kvset builders.
+ */
+static merr_t
+c0sk_ingest_part_build(struct c0_ingest_part *part)
+{
+    struct c0_ingest_work *ingest = part->c0ip_ingest;
+    merr_t                 err;
+
+    err = bkv_collection_finish_pair_range(part->c0ip_bkvcv[0], part->c0ip_bkvcv[1],
+                                           part->c0ip_startv, part->c0ip_endv, part);
+    kvs_merge_fini(&part->c0ip_merge);
+    if (ev(err))
+        return err;
+
+    for (uint i = part->c0ip_skidx_lo; i <= part->c0ip_skidx_hi; ++i) {
+        if (ingest->c0iw_bldrs[i] == 0)
+            continue;
+
+        ingest->c0iw_mbv[i] = &ingest->c0iw_mblocks[i];
+        err = kvset_builder_get_mblocks(ingest->c0iw_bldrs[i], &ingest->c0iw_mblocks[i]);
+        if (ev(err))
+            break;
+    }
+
+    return err;
+}
+
+static void
+c0sk_ingest_part_worker(struct work_struct *work)
+{
+    struct c0_ingest_part *part = container_of(work, struct c0_ingest_part, c0ip_work);
+    struct c0_ingest_done *done = part->c0ip_done;
+
+    part->c0ip_err = c0sk_ingest_part_build(part);
+
+    mutex_lock(&done->c0id_lock);
+    if (--done->c0id_pending == 0)
+        cv_signal(&done->c0id_cv);
+    mutex_unlock(&done->c0id_lock);
+}
+
+/* Divide the kvses into at most %partmax contiguous ranges holding roughly
+ * the same number of cn ingest list entries.  The lists are sorted by key,
+ * and hence by kvs index, so each range maps to a contiguous run of entries
+ * in each list.  The last part always extends to the last kvs so that the
+ * kvsets of kvses having only range tombstones are finished too.
+ */
+static uint
+c0sk_ingest_partition(
+    struct c0_ingest_work *ingest,
+    struct bkv_collection *cn_list[static 2],
+    struct c0_ingest_part *partv,
+    uint                   partmax)
+{
+    struct c0sk_impl *c0sk = c0sk_h2r(ingest->c0iw_c0sk);
+    size_t            startv[2] = { 0, 0 };
+    size_t            total, quota;
+    uint              partc = 0, lo = 0;
+
+    total = bkv_collection_count(cn_list[0]) + bkv_collection_count(cn_list[1]);
+    quota = total / partmax + 1;
+
+    for (uint skidx = 0; skidx < HSE_KVS_COUNT_MAX; skidx++) {
+        struct c0_ingest_part *part;
+        size_t                 endv[2];
+
+        if (skidx < HSE_KVS_COUNT_MAX - 1) {
+            if (partc + 1 >= partmax || !c0sk->c0sk_cnv[skidx])
+                continue;
+
+            for (int i = 0; i < 2; i++)
+                endv[i] = bkv_collection_skidx_bound(cn_list[i], skidx + 1);
+
+            if ((endv[0] - startv[0]) + (endv[1] - startv[1]) < quota)
+                continue;
+        } else {
+            for (int i = 0; i < 2; i++)
+                endv[i] = bkv_collection_count(cn_list[i]);
+        }
+
+        part = &partv[partc++];
+        part->c0ip_ingest = ingest;
+        part->c0ip_skidx_lo = lo;
+        part->c0ip_skidx_hi = skidx;
+
+        for (int i = 0; i < 2; i++) {
+            part->c0ip_bkvcv[i] = cn_list[i];
+            part->c0ip_startv[i] = startv[i];
+            part->c0ip_endv[i] = endv[i];
+            startv[i] = endv[i];
+        }
+
+        lo = skidx + 1;
+    }
+
+    return partc;
+}
+
+/* Build the kvsets of an ingest, one part per thread.  The calling thread
+ * builds the first part while the rest run on c0sk_wq_build.
+ */
+static merr_t
+c0sk_ingest_build(struct c0_ingest_work *ingest, struct bkv_collection *cn_list[static 2])
+{
+    struct c0sk_impl *     c0sk = c0sk_h2r(ingest->c0iw_c0sk);
+    struct c0_ingest_part *partv;
+    struct c0_ingest_done  done;
+    uint                   partmax, partc, i;
+    merr_t                 err = 0;
+
+    partmax = clamp_t(uint, c0sk->c0sk_kvdb_rp->c0_build_threads, 1, HSE_C0_BUILD_THREADS_MAX);
+
+    partv = calloc(partmax, sizeof(*partv));
+    if (ev(!partv))
+        return merr(ENOMEM);
+
+    partc = c0sk_ingest_partition(ingest, cn_list, partv, partmax);
+    assert(partc > 0);
+
+    mutex_init(&done.c0id_lock);
+    cv_init(&done.c0id_cv);
+    done.c0id_pending = partc - 1;
+
+    for (i = 1; i < partc; i++) {
+        partv[i].c0ip_done = &done;
+        INIT_WORK(&partv[i].c0ip_work, c0sk_ingest_part_worker);
+        queue_work(c0sk->c0sk_wq_build, &partv[i].c0ip_work);
+    }
+
+    partv[0].c0ip_err = c0sk_ingest_part_build(&partv[0]);
+
+    mutex_lock(&done.c0id_lock);
+    while (done.c0id_pending > 0)
+        cv_wait(&done.c0id_cv, &done.c0id_lock, "c0build");
+    mutex_unlock(&done.c0id_lock);
+
+    cv_destroy(&done.c0id_cv);
+    mutex_destroy(&done.c0id_lock);
+
+    for (i = 0; i < partc && !err; i++)
+        err = partv[i].c0ip_err;
+
+    free(partv);
+
+    return err;
+}
+
 /**
  * c0sk_ingest_worker() - Ingest worker thread
  *
@@ -559,7 +904,8 @@ c0sk_merge_loop(
  *  2. Iterate over kv-pairs in LC and add them to cn_list[1] if they are ready for ingest.
  *  3. Update LC with the entries in lc_list.
  *  4. Merge cn_list[0] and cn_list[1] and add the resulting list of kv-pairs to cn using kvset
- *     builders.
+ *     builders.  The kvses are divided into ranges that are merged and built concurrently (see
+ *     c0sk_ingest_build()), and the resulting kvsets are then committed by a single cn_ingestv().
  *
  * For all ingests, steps 2 and 3 need to be performed in ingest queuing order.
  */
@@ -612,7 +958,7 @@ c0sk_ingest_worker(struct work_struct *work)
         ingest->t0 = get_time_ns();
 
     for (i = 0; i < 2; i++) {
-        err = bkv_collection_create(&cn_list[i], CN_INGEST_BKV_CNT, &c0sk_cningest_cb, ingest);
+        err = bkv_collection_create(&cn_list[i], CN_INGEST_BKV_CNT, &c0sk_cningest_cb, NULL);
         if (ev(err))
             goto health_err;
     }
@@ -686,21 +1032,17 @@ c0sk_ingest_worker(struct work_struct *work)
 
     ingest->t6 = get_time_ns();
 
-    err = bkv_collection_finish_pair(cn_list[0], cn_list[1]);
+    ingest->c0iw_horizon = c0sk_horizon_get(c0sk);
+
+    err = c0sk_cningest_rtombs(ingest, min_seq, max_seq);
     if (ev(err))
         goto health_err;
 
-    ingest->t7 = get_time_ns();
-
-    for (i = 0; i < HSE_KVS_COUNT_MAX; ++i) {
-        if (ingest->c0iw_bldrs[i] == 0)
-            continue;
+    err = c0sk_ingest_build(ingest, cn_list);
+    if (ev(err))
+        goto health_err;
 
-        mbv[i] = &mblocks[i];
-        err = kvset_builder_get_mblocks(ingest->c0iw_bldrs[i], &mblocks[i]);
-        if (ev(err))
-            goto health_err;
-    }
+    ingest->t7 = get_time_ns();
 
 health_err:
     if (err)
@@ -1085,7 +1427,8 @@ c0sk_queue_ingest(struct c0sk_impl *self, struct c0_kvmultiset *old)
 
     stashp = HSE_LIKELY(atomic_read(&self->c0sk_replaying) == 0) ? &self->c0sk_stash : NULL;
 
-    err = c0kvms_create(self->c0sk_ingest_width, self->c0sk_kvdb_seq, stashp, &new);
+    err = c0kvms_create(self->c0sk_ingest_width, self->c0sk_kvdb_rp->c0_concurrent,
+                        self->c0sk_kvdb_seq, stashp, &new);
     if (!err) {
         c0kvms_getref(new);
 
@@ -1256,6 +1599,14 @@ c0sk_putdel(
             err = c0kvs_put(kvs, skidx, kt, vt, seqnoref);
         } else if (op == C0SK_OP_DEL) {
             err = c0kvs_del(kvs, skidx, kt, seqnoref);
+        } else if (op == C0SK_OP_RANGE_DEL) {
+            struct kvs_ktuple end;
+
+            kvs_ktuple_init_nohash(&end, vt->vt_data, kvs_vtuple_vlen(vt));
+
+            /* Range tombs live alongside the ptombs. */
+            kvs = c0kvms_ptomb_c0kvset_get(dst);
+            err = c0kvs_range_del(kvs, skidx, kt, &end, seqnoref);
         } else {
             assert(op == C0SK_OP_PREFIX_DEL);
 
@@ -1300,6 +1651,153 @@ c0sk_putdel(
     return err;
 }
 
+/* Insert the ops of a write batch, starting at *nextp, into the given kvms.
+ *
+ * Runs of puts and deletes are partitioned by destination c0_kvset so that
+ * each c0_kvset lock is acquired only once per run.  Ops on the same key
+ * hash to the same c0_kvset and hence retain their relative order.  Prefix
+ * deletes terminate a run so that their seqno remains ordered with respect
+ * to the ops that precede and follow them.
+ *
+ * On return, *nextp is the index of the first op that has not been applied.
+ * If a run is interrupted (e.g., the kvms fills up) then it is reapplied in
+ * its entirety to the next kvms, which is harmless since reapplying a prefix
+ * of the run preserves the order of ops within each key.
+ */
+static merr_t
+c0sk_putdel_batch_kvms(
+    struct c0_kvmultiset *dst,
+    uint                  opc,
+    struct kvs_batch_op  *opv,
+    uintptr_t             seqnoref,
+    uint                 *nextp)
+{
+    struct c0_kvset *kvsetv[C0SK_BATCH_RUN_MAX];
+    uint8_t          idxv[C0SK_BATCH_RUN_MAX];
+    uint             next = *nextp;
+    merr_t           err = 0;
+
+    while (next < opc) {
+        uint i, j, end, idxc, done;
+
+        if (opv[next].kbo_op == KVS_BATCH_PDEL) {
+            struct c0_kvset *kvs = c0kvms_ptomb_c0kvset_get(dst);
+
+            err = c0kvs_prefix_del(kvs, opv[next].kbo_skidx, &opv[next].kbo_kt, seqnoref);
+            if (err)
+                break;
+
+            *nextp = ++next;
+            continue;
+        }
+
+        for (end = next; end < opc && end - next < C0SK_BATCH_RUN_MAX; ++end) {
+            if (opv[end].kbo_op == KVS_BATCH_PDEL)
+                break;
+
+            kvsetv[end - next] = c0kvms_get_hashed_c0kvset(dst, opv[end].kbo_kt.kt_hash);
+        }
+
+        for (i = next; i < end && !err; ++i) {
+            struct c0_kvset *kvs = kvsetv[i - next];
+
+            if (!kvs)
+                continue; /* already inserted with an earlier group */
+
+            for (j = i, idxc = 0; j < end; ++j) {
+                if (kvsetv[j - next] == kvs) {
+                    kvsetv[j - next] = NULL;
+                    idxv[idxc++] = j;
+                }
+            }
+
+            err = c0kvs_putdel_batch(kvs, opv, idxv, idxc, seqnoref, &done);
+        }
+
+        if (err)
+            break;
+
+        *nextp = next = end;
+    }
+
+    return err;
+}
+
+merr_t
+c0sk_putdel_batch(struct c0sk_impl *self, uint opc, struct kvs_batch_op *opv, uintptr_t seqnoref)
+{
+    uintptr_t *priv = (uintptr_t *)seqnoref;
+    bool       is_txn = (!HSE_SQNREF_SINGLE_P(seqnoref) && !HSE_SQNREF_ORDNL_P(seqnoref));
+    uint       next = 0;
+    merr_t     err = 0;
+
+    while (next < opc) {
+        struct c0_kvmultiset *dst;
+        uintptr_t *           entry = NULL;
+        void                 *cookie = NULL;
+        u64                   dst_gen;
+        uint                  first, i;
+
+        rcu_read_lock();
+        dst = c0sk_get_first_c0kvms(&self->c0sk_handle);
+        if (ev_warn(!dst)) {
+            rcu_read_unlock();
+            return merr(EINVAL);
+        }
+
+        /* See c0sk_putdel() */
+        c0sk_ingestref_get(self, is_txn, &cookie);
+
+        if (c0kvms_should_ingest(dst) && atomic_read(&self->c0sk_replaying) == 0) {
+            err = merr(ENOMEM);
+            goto unlock;
+        }
+
+        dst_gen = c0kvms_gen_read(dst);
+        if (is_txn && c0snr_get_cgen(priv) != dst_gen) {
+            entry = c0kvms_c0snr_alloc(dst);
+            if (ev(!entry)) {
+                err = merr(ENOMEM);
+                goto unlock;
+            }
+        }
+
+        first = next;
+        err = c0sk_putdel_batch_kvms(dst, opc, opv, seqnoref, &next);
+
+        assert(!c0kvms_is_finalized(dst)); /* See c0kvs_putdel() */
+
+        if (entry) {
+            if (next > first) {
+                *entry = seqnoref;
+                c0snr_getref(priv, dst_gen);
+            } else {
+                *entry = 0;
+            }
+        }
+
+        for (i = first; i < next; ++i)
+            opv[i].kbo_kt.kt_dgen = dst_gen;
+
+    unlock:
+        c0sk_ingestref_put(self, cookie);
+
+        if (merr_errno(err) == ENOMEM)
+            c0kvms_getref(dst);
+
+        rcu_read_unlock();
+
+        if (merr_errno(err) != ENOMEM)
+            break;
+
+        c0sk_queue_ingest(self, dst);
+        c0kvms_putref(dst);
+        err = 0;
+    }
+
+    return err;
+}
+
 #if HSE_MOCKING
 #include "c0sk_internal_ut_impl.i"
 #endif /* HSE_MOCKING */
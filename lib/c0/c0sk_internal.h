@@ -45,6 +45,7 @@ struct c0sk {
  * @c0sk_ds:              mpool dataset
  * @c0sk_wq_ingest        workqueue for ingest processing (one thread)
  * @c0sk_wq_maint         workqueue for concurrent maintenance tasks
+ * @c0sk_wq_build         workqueue for building the kvsets of an ingest
  * @c0sk_kvdb_seq:        kvdb seqno
  * @c0sk_closing:         set to %true when c0sk is closing
  * @c0sk_pc_op:           perf counter for c0sk
@@ -76,6 +77,7 @@ struct c0sk_impl {
     struct mpool            *c0sk_ds;      /* not owned by c0sk */
     struct workqueue_struct *c0sk_wq_ingest;
     struct workqueue_struct *c0sk_wq_maint;
+    struct workqueue_struct *c0sk_wq_build;
     struct kvdb_health      *c0sk_kvdb_health;
     struct kvdb_callback    *c0sk_cb;
     struct csched           *c0sk_csched;
@@ -187,6 +189,7 @@ enum c0sk_op {
     C0SK_OP_PUT,
     C0SK_OP_DEL,
     C0SK_OP_PREFIX_DEL,
+    C0SK_OP_RANGE_DEL,
 };
 
 /**
@@ -195,7 +198,7 @@ enum c0sk_op {
  * @skidx:       which kvs is the insert targeted to
  * @op:
  * @kt:          key tuple
- * @vt:          value tuple
+ * @vt:          value tuple (the end key for C0SK_OP_RANGE_DEL)
  * @seqnoref:    seqnoref of kvtuple
  *
  * The function c0sk_putdel() embodies the primary functionality of c0sk.
@@ -215,6 +218,25 @@ c0sk_putdel(
     const struct kvs_vtuple *vt,
     uintptr_t                seqnoref);
 
+/* Maximum number of consecutive puts and deletes that c0sk_putdel_batch()
+ * partitions by destination c0_kvset in a single pass.
+ */
+#define C0SK_BATCH_RUN_MAX  (64)
+
+/**
+ * c0sk_putdel_batch() - apply the ops of a write batch
+ * @self:        struct c0sk_impl in which to put
+ * @opc:         number of ops in @opv
+ * @opv:         vector of write batch ops, applied in order
+ * @seqnoref:    seqnoref for all ops
+ *
+ * Return: 0 if all ops were applied, merr(EINVAL) if there is no active
+ * kvms, otherwise the error that stopped the batch.  Ops preceding the
+ * failed op remain applied.
+ */
+merr_t
+c0sk_putdel_batch(struct c0sk_impl *self, uint opc, struct kvs_batch_op *opv, uintptr_t seqnoref);
+
 struct cn *
 c0sk_get_cn(struct c0sk_impl *c0sk, u64 skidx);
 
@@ -6,6 +6,8 @@
 #include <hse_util/page.h>
 #include <hse_util/bloom_filter.h>
 
+#include <hse_ikvdb/omf_version.h>
+
 #include "bloom_reader.h"
 
 /* [HSE_REVISIT] bloom_filter.[ch] provides an abstracted data type for a bloom
@@ -28,6 +30,9 @@ bloom_reader_lookup(
     if (!bitmap)
         return true;
 
+    if (HSE_LIKELY(desc->bd_version >= BLOOM_OMF_VERSION6))
+        return bf_blk_lookup(hash, bitmap, desc->bd_modulus, desc->bd_n_hashes);
+
     bkt = bf_hash2bkt(hash, desc->bd_modulus, desc->bd_bktshift);
 
     bitmap += (bkt / PAGE_SIZE) * PAGE_SIZE + (bkt % PAGE_SIZE);
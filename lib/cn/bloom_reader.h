@@ -14,6 +14,7 @@
  * @bd_n_pages:     size of data region in pages
  * @bd_n_hashes:
  * @bd_first_page:  offset, in pages, from start of mblock to data region
+ * @bd_version:     bloom omf version (BLOOM_OMF_VERSION5 or later)
  *
  * When a kblock is opened for reading, the @bloom_hdr_omf struct is read from
  * media and the relevant information is stored in a @bloom_desc struct.
@@ -34,6 +35,7 @@ struct bloom_desc {
     uint32_t  bd_bktmask;
     uint32_t  bd_first_page;
     uint32_t  bd_bktsz;
+    uint32_t  bd_version;
 };
 
 /**
@@ -14,6 +14,8 @@
 #include <hse/error/merr.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/alloc.h>
+#include <hse_util/condvar.h>
+#include <hse_util/mutex.h>
 #include <hse_util/slab.h>
 #include <hse_util/log2.h>
 #include <hse_util/xrand.h>
@@ -35,6 +37,7 @@
 #include <hse_ikvdb/kvdb_health.h>
 #include <hse_ikvdb/cn_kvdb.h>
 #include <hse_ikvdb/kvs_cparams.h>
+#include <hse_ikvdb/kvdb_perfc.h>
 
 #include <hse_ikvdb/csched.h>
 
@@ -184,6 +187,12 @@ cn_get_io_wq(struct cn *cn)
     return cn->cn_io_wq;
 }
 
+struct workqueue_struct *
+cn_get_wr_wq(struct cn *cn)
+{
+    return cn ? cn->cn_wr_wq : NULL;
+}
+
 struct workqueue_struct *
 cn_get_maint_wq(struct cn *cn)
 {
@@ -328,6 +337,61 @@ cn_disable_maint(struct cn *cn, bool onoff)
     }
 }
 
+merr_t
+cn_merge_op_set(struct cn *cn, hse_kvs_merge_fn *fn, void *arg)
+{
+    if (ev(!cn || !fn))
+        return merr(EINVAL);
+
+    /* Claim the slot before filling it in so that concurrent callers
+     * cannot both succeed.  Readers ignore the placeholder value.
+     */
+    if (!atomic_cas(&cn->cn_mopp, (uintptr_t)0, (uintptr_t)1))
+        return merr(EEXIST);
+
+    cn->cn_mop.mo_fn = fn;
+    cn->cn_mop.mo_arg = arg;
+
+    atomic_set_rel(&cn->cn_mopp, (uintptr_t)&cn->cn_mop);
+
+    return 0;
+}
+
+const struct kvs_merge_op *
+cn_get_merge_op(struct cn *cn)
+{
+    uintptr_t mopp = atomic_read_acq(&cn->cn_mopp);
+
+    return (mopp > 1) ? (const struct kvs_merge_op *)mopp : NULL;
+}
+
+merr_t
+cn_compact_filter_set(struct cn *cn, hse_kvs_compact_filter_fn *fn, void *arg)
+{
+    if (ev(!cn || !fn))
+        return merr(EINVAL);
+
+    /* See cn_merge_op_set().
+     */
+    if (!atomic_cas(&cn->cn_cfilterp, (uintptr_t)0, (uintptr_t)1))
+        return merr(EEXIST);
+
+    cn->cn_cfilter.cf_fn = fn;
+    cn->cn_cfilter.cf_arg = arg;
+
+    atomic_set_rel(&cn->cn_cfilterp, (uintptr_t)&cn->cn_cfilter);
+
+    return 0;
+}
+
+const struct cn_compact_filter *
+cn_get_compact_filter(struct cn *cn)
+{
+    uintptr_t cfp = atomic_read_acq(&cn->cn_cfilterp);
+
+    return (cfp > 1) ? (const struct cn_compact_filter *)cfp : NULL;
+}
+
 struct kvs_cparams *
 cn_get_cparams(const struct cn *handle)
 {
@@ -351,6 +415,25 @@ cn_get(
     return cn_tree_lookup(cn->cn_tree, &cn->cn_pc_get, kt, seq, res, NULL, NULL, vbuf);
 }
 
+merr_t
+cn_get_multi(
+    struct cn *          cn,
+    struct kvs_ktuple *  ktv,
+    u64                  seq,
+    enum key_lookup_res *resv,
+    struct kvs_buf *     vbufv,
+    const uint *         idxv,
+    uint                 idxc)
+{
+    return cn_tree_lookup_multi(cn->cn_tree, &cn->cn_pc_get, ktv, seq, resv, vbufv, idxv, idxc);
+}
+
+void
+cn_scan_bounds(struct cn *cn, uint rangec, void *keyv, uint *klenv, uint *keycp)
+{
+    cn_tree_scan_bounds(cn->cn_tree, rangec, keyv, klenv, keycp);
+}
+
 merr_t
 cn_pfx_probe(
     struct cn *          cn,
@@ -760,14 +843,68 @@ cn_maint_task(struct work_struct *work)
                        msecs_to_jiffies(cn->rp->cn_maint_delay));
 }
 
+static void
+cn_node_bloom_task(struct cn_work *work)
+{
+    struct cn *cn = container_of(work, struct cn, cn_nbloom_work);
+
+    cn_tree_node_bloom_build(cn->cn_tree, &cn->cn_maint_cancel);
+}
+
+/**
+ * struct cndb_cn_kvset - a kvset being opened by cn_open()
+ * @ck_work:      for running kvset_open() on a workqueue
+ * @ck_link:      link on the ctx's list of kvsets
+ * @ck_tree:      cn tree
+ * @ck_node:      node into which the kvset is to be inserted
+ * @ck_km:        kvset metadata (owns a copy of the block lists)
+ * @ck_kvsetid:   kvset ID
+ * @ck_kvset:     (output) opened kvset
+ * @ck_err:       (output) status of kvset_open()
+ * @ck_ctx:       state of the cndb_cn_instantiate() that queued the kvset
+ */
+struct cndb_cn_kvset {
+    struct work_struct   ck_work;
+    struct list_head     ck_link;
+    struct cn_tree      *ck_tree;
+    struct cn_tree_node *ck_node;
+    struct kvset_meta    ck_km;
+    uint64_t             ck_kvsetid;
+    struct kvset        *ck_kvset;
+    merr_t               ck_err;
+    struct cndb_cn_ctx  *ck_ctx;
+};
+
+/**
+ * struct cndb_cn_ctx - state of cndb_cn_instantiate()
+ * @tree:     cn tree
+ * @nodemap:  map of node IDs to tree nodes
+ * @max_dgen: max dgen of all kvsets
+ * @wq:       workqueue on which kvsets are opened (NULL to open inline)
+ * @kvsets:   list of struct cndb_cn_kvset, in the order they were queued
+ * @kvsetc:   number of kvsets on %kvsets
+ * @lock:     protects %inflight
+ * @cv:       signaled when %inflight drops to zero
+ * @inflight: number of kvsets queued but not yet opened
+ */
 struct cndb_cn_ctx {
-    struct cn_tree *tree;
-    struct map     *nodemap;
-    uint64_t        max_dgen;
+    struct cn_tree          *tree;
+    struct map              *nodemap;
+    uint64_t                 max_dgen;
+    struct workqueue_struct *wq;
+    struct list_head         kvsets;
+    uint                     kvsetc;
+    struct mutex             lock;
+    struct cv                cv;
+    uint                     inflight;
 };
 
 static merr_t
-cndb_cn_ctx_init(struct cndb_cn_ctx *ctx, struct cn_tree *tree, struct cn_tree_node *root)
+cndb_cn_ctx_init(
+    struct cndb_cn_ctx      *ctx,
+    struct cn_tree          *tree,
+    struct cn_tree_node     *root,
+    struct workqueue_struct *wq)
 {
     struct map *nodemap;
     merr_t err;
@@ -790,6 +927,12 @@ cndb_cn_ctx_init(struct cndb_cn_ctx *ctx, struct cn_tree *tree, struct cn_tree_n
     ctx->nodemap = nodemap;
     ctx->tree = tree;
     ctx->max_dgen = 0;
+    ctx->wq = wq;
+    INIT_LIST_HEAD(&ctx->kvsets);
+    ctx->kvsetc = 0;
+    mutex_init(&ctx->lock);
+    cv_init(&ctx->cv);
+    ctx->inflight = 0;
 
     return 0;
 }
@@ -797,26 +940,153 @@ cndb_cn_ctx_init(struct cndb_cn_ctx *ctx, struct cn_tree *tree, struct cn_tree_n
 static void
 cndb_cn_ctx_fini(struct cndb_cn_ctx *ctx)
 {
+    struct cndb_cn_kvset *ck, *next;
+
     INVARIANT(ctx);
     INVARIANT(ctx->nodemap);
 
+    assert(ctx->inflight == 0);
+
+    /* Kvsets that were opened but not inserted into the tree are closed here.
+     */
+    list_for_each_entry_safe(ck, next, &ctx->kvsets, ck_link) {
+        if (ck->ck_kvset)
+            kvset_put_ref(ck->ck_kvset);
+
+        blk_list_free(&ck->ck_km.km_kblk_list);
+        blk_list_free(&ck->ck_km.km_vblk_list);
+        free(ck);
+    }
+
+    cv_destroy(&ctx->cv);
+    mutex_destroy(&ctx->lock);
     map_destroy(ctx->nodemap);
 }
 
+static void
+cndb_cn_kvset_open(struct work_struct *work)
+{
+    struct cndb_cn_kvset *ck = container_of(work, struct cndb_cn_kvset, ck_work);
+    struct cndb_cn_ctx *ctx = ck->ck_ctx;
+
+    ck->ck_err = kvset_open(ck->ck_tree, ck->ck_kvsetid, &ck->ck_km, &ck->ck_kvset);
+
+    perfc_dec(&kvdb_metrics_pc, PERFC_BA_KVDBMETRICS_KVSETOPEN);
+    perfc_inc(&kvdb_metrics_pc, PERFC_RA_KVDBMETRICS_KVSETOPENED);
+
+    /* ck must not be touched once the lock is dropped, as cn_open() may
+     * then free it.
+     */
+    mutex_lock(&ctx->lock);
+    if (--ctx->inflight == 0)
+        cv_signal(&ctx->cv);
+    mutex_unlock(&ctx->lock);
+}
+
+static merr_t
+cndb_cn_ctx_kvset_add(struct cndb_cn_ctx *ctx, struct cn_tree_node *node, struct kvset_meta *km,
+                      u64 kvsetid)
+{
+    struct cndb_cn_kvset *ck;
+    merr_t err = 0;
+
+    ck = calloc(1, sizeof(*ck));
+    if (ev(!ck))
+        return merr(ENOMEM);
+
+    ck->ck_tree = ctx->tree;
+    ck->ck_node = node;
+    ck->ck_kvsetid = kvsetid;
+    ck->ck_ctx = ctx;
+
+    /* The caller frees the block lists in km upon return, so the work
+     * must be given its own copies.
+     */
+    ck->ck_km = *km;
+    blk_list_init(&ck->ck_km.km_kblk_list);
+    blk_list_init(&ck->ck_km.km_vblk_list);
+
+    for (uint i = 0; i < km->km_kblk_list.n_blks && !err; i++)
+        err = blk_list_append(&ck->ck_km.km_kblk_list, km->km_kblk_list.blks[i].bk_blkid);
+
+    for (uint i = 0; i < km->km_vblk_list.n_blks && !err; i++)
+        err = blk_list_append(&ck->ck_km.km_vblk_list, km->km_vblk_list.blks[i].bk_blkid);
+
+    list_add_tail(&ck->ck_link, &ctx->kvsets);
+    ctx->kvsetc++;
+
+    if (ev(err))
+        return err;
+
+    perfc_inc(&kvdb_metrics_pc, PERFC_BA_KVDBMETRICS_KVSETOPEN);
+
+    mutex_lock(&ctx->lock);
+    ctx->inflight++;
+    mutex_unlock(&ctx->lock);
+
+    INIT_WORK(&ck->ck_work, cndb_cn_kvset_open);
+
+    if (!ctx->wq || !queue_work(ctx->wq, &ck->ck_work))
+        cndb_cn_kvset_open(&ck->ck_work);
+
+    return 0;
+}
+
+/* Wait for all the queued kvsets to be opened.  Don't flush the workqueue,
+ * it may be busy with other kvses' work.
+ */
+static void
+cndb_cn_ctx_wait(struct cndb_cn_ctx *ctx)
+{
+    mutex_lock(&ctx->lock);
+    while (ctx->inflight > 0)
+        cv_wait(&ctx->cv, &ctx->lock, "kvsetopn");
+    mutex_unlock(&ctx->lock);
+}
+
+/* Insert the opened kvsets into their nodes.  This is done by the calling
+ * thread as the node lists are not protected during cn_open().
+ */
+static merr_t
+cndb_cn_ctx_insert(struct cndb_cn_ctx *ctx)
+{
+    struct cndb_cn_kvset *ck;
+    merr_t err = 0;
+
+    list_for_each_entry(ck, &ctx->kvsets, ck_link) {
+        if (ck->ck_err) {
+            err = ck->ck_err;
+            break;
+        }
+    }
+
+    if (err)
+        return err;
+
+    list_for_each_entry(ck, &ctx->kvsets, ck_link) {
+        err = cn_node_insert_kvset(ck->ck_node, ck->ck_kvset);
+        if (ev(err))
+            return err;
+
+        ck->ck_kvset = NULL;
+    }
+
+    return 0;
+}
+
 /*
  * Callback invoked by cndb_cn_instantiate() to place kvsets into tree nodes.
  *
  * This callback is invoked once for each kvset in a KVS.  Each callback
  * contains a node ID, a kvset ID, and other metadata needed to open the
- * on-media kvset.  It opens the kvsets and adds them to tree nodes, creating
- * the tree nodes as needed.
+ * on-media kvset.  It creates the tree nodes as needed and queues the kvsets
+ * to be opened in parallel, after which cn_open() adds them to their nodes.
  */
 static merr_t
 cndb_cn_callback(void *arg, struct kvset_meta *km, u64 kvsetid)
 {
     struct cndb_cn_ctx *ctx = arg;
     struct cn_tree_node *node;
-    struct kvset *kvset;
     merr_t err;
 
     node = map_lookup_ptr(ctx->nodemap, km->km_nodeid);
@@ -831,16 +1101,10 @@ cndb_cn_callback(void *arg, struct kvset_meta *km, u64 kvsetid)
         ctx->tree->ct_fanout++;
     }
 
-    err = kvset_open(ctx->tree, kvsetid, km, &kvset);
+    err = cndb_cn_ctx_kvset_add(ctx, node, km, kvsetid);
     if (ev(err))
         return err;
 
-    err = cn_node_insert_kvset(node, kvset);
-    if (ev(err)) {
-        kvset_put_ref(kvset);
-        return err;
-    }
-
     if (ctx->max_dgen < km->km_dgen_hi)
         ctx->max_dgen = km->km_dgen_hi;
 
@@ -871,7 +1135,8 @@ cn_open(
     char kbuf[HSE_KVS_KEY_LEN_MAX];
     struct cn_tree_node *tn, *tn_next;
     struct route_node *rn;
-    uint klen;
+    uint klen, kvsetc;
+    u64 tstart;
 
     assert(cn_kvdb);
     assert(mp);
@@ -908,6 +1173,7 @@ cn_open(
     strlcpy(cn->cn_kvsname, kvs_name, sizeof(cn->cn_kvsname));
 
     cn->cn_kvdb = cn_kvdb;
+    cn->cn_wr_wq = cn_kvdb->cn_wr_wq;
     cn->rp = rp;
     cn->cp = kvdb_kvs_cparams(kvs);
     cn->cn_cndb = cndb;
@@ -940,13 +1206,23 @@ cn_open(
 
     cn_tree_setup(cn->cn_tree, mp, cn, rp, cndb, cnid, cn->cn_kvdb);
 
-    /* Add kvsets to nodes based on data stored in CNDB.
+    /* Add kvsets to nodes based on data stored in CNDB.  The kvsets are
+     * opened on the io workqueue while cndb is walked.
      */
-    err = cndb_cn_ctx_init(&ctx, cn->cn_tree, cn->cn_tree->ct_root);
+    err = cndb_cn_ctx_init(&ctx, cn->cn_tree, cn->cn_tree->ct_root, cn_kvdb->cn_io_wq);
     if (ev(err))
         goto err_exit;
 
+    tstart = get_time_ns();
+
     err = cndb_cn_instantiate(cndb, cnid, &ctx, cndb_cn_callback);
+    cndb_cn_ctx_wait(&ctx);
+    if (!err)
+        err = cndb_cn_ctx_insert(&ctx);
+
+    tstart = get_time_ns() - tstart;
+    kvsetc = ctx.kvsetc;
+
     atomic_set(&cn->cn_ingest_dgen, ctx.max_dgen);
     cndb_cn_ctx_fini(&ctx);
     if (ev(err))
@@ -1075,9 +1351,10 @@ cn_open(
 
         log_info(
             "opened kvs %s/%s cnid %lu pfx_len %u vcomp %u"
-            " hb %lu%c/%lu kb %lu%c/%lu vb %lu%c/%lu %s%s%s%s%s%s",
+            " kvsets %u/%lums hb %lu%c/%lu kb %lu%c/%lu vb %lu%c/%lu %s%s%s%s%s%s",
             cn->cn_kvdb_alias, cn->cn_kvsname, (ulong)cnid,
             cn->cp->pfx_len, cn->rp->compression.algorithm,
+            kvsetc, (ulong)(tstart / 1000000),
             (ulong)kvs_stats.kst_halen >> (hshift * 10), hszsuf, (ulong)kvs_stats.kst_hblks,
             (ulong)kvs_stats.kst_kalen >> (kshift * 10), kszsuf, (ulong)kvs_stats.kst_kblks,
             (ulong)kvs_stats.kst_valen >> (vshift * 10), vszsuf, (ulong)kvs_stats.kst_vblks,
@@ -1114,6 +1391,13 @@ cn_open(
             cn->csched = ikvdb_get_csched(cn->ikvdb);
 
             csched_tree_add(cn->csched, cn->cn_tree);
+
+            /* Build leaf node blooms in the background, any node that
+             * is compacted in the meantime gets its filter rebuilt on
+             * completion of the compaction.
+             */
+            if (rp->cn_node_bloom_prob)
+                cn_work_submit(cn, cn_node_bloom_task, &cn->cn_nbloom_work);
         }
     }
 
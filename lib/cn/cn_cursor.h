@@ -14,6 +14,7 @@
 #include <hse/limits.h>
 
 #include <hse_ikvdb/cursor.h>
+#include <hse_ikvdb/kvs_rtomb.h>
 
 #include "cn_metrics.h"
 #include "kvset.h"
@@ -43,6 +44,7 @@ struct cn_level_cursor {
     uint64_t                cnlc_dgen_hi;
     uint64_t                cnlc_dgen_lo;
     bool                    cnlc_islast;
+    struct kvs_rtomb_vec    cnlc_rtombs;
 
     uint                    cnlc_next_eklen;
     unsigned char           cnlc_next_ekey[HSE_KVS_KEY_LEN_MAX];
@@ -22,6 +22,10 @@ struct csched;
 #include <hse/limits.h>
 #include <mpool/mpool.h>
 
+#include <hse_ikvdb/kvs_merge.h>
+
+#include "cn_work.h"
+
 struct cn {
     struct cn_tree *  cn_tree;
     struct perfc_set  cn_pc_get;
@@ -38,6 +42,7 @@ struct cn {
 
     /* for asynchronous mblock I/O */
     struct workqueue_struct *cn_io_wq;
+    struct workqueue_struct *cn_wr_wq;
 
     /* perf counters */
     struct perfc_set cn_pc_ingest;
@@ -57,6 +62,7 @@ struct cn {
     struct delayed_work      cn_maint_dwork;
     atomic_int               cn_maint_cancel;
     bool                     cn_maint_running;
+    struct cn_work           cn_nbloom_work;
 
     struct kvs_rparams *  rp;
     struct kvs_cparams *  cp;
@@ -65,6 +71,14 @@ struct cn {
     struct kvdb_health *  cn_kvdb_health;
     struct mclass_policy *cn_mpolicy;
 
+    /* merge operator, published via cn_mopp once set */
+    struct kvs_merge_op cn_mop;
+    atomic_uintptr_t    cn_mopp;
+
+    /* compaction filter, published via cn_cfilterp once set */
+    struct cn_compact_filter cn_cfilter;
+    atomic_uintptr_t         cn_cfilterp;
+
     u32 cn_cflags;
 
     const char *cn_kvdb_alias;
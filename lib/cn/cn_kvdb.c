@@ -35,6 +35,18 @@ cn_kvdb_create(uint cn_maint_threads, uint cn_io_threads, struct cn_kvdb **out)
         return merr(ENOMEM);
     }
 
+    /* Dedicated queue for asynchronous kvset builder mblock writes.  It is not
+     * shared with cn_io_wq so that a job running on cn_io_wq can never wait on
+     * a write queued behind itself.
+     */
+    self->cn_wr_wq = alloc_workqueue("hse_cn_wr", 0, 1, cn_io_threads);
+    if (ev(!self->cn_wr_wq)) {
+        destroy_workqueue(self->cn_io_wq);
+        destroy_workqueue(self->cn_maint_wq);
+        free(self);
+        return merr(ENOMEM);
+    }
+
     *out = self;
 
     return 0;
@@ -46,6 +58,7 @@ cn_kvdb_destroy(struct cn_kvdb *h)
     if (h) {
         destroy_workqueue(h->cn_maint_wq);
         destroy_workqueue(h->cn_io_wq);
+        destroy_workqueue(h->cn_wr_wq);
         free(h);
     }
 }
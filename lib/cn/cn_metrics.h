@@ -37,6 +37,9 @@ struct kvset_stats {
     uint64_t kst_valen;     //<! sum of mpr_alloc_cap for all vblocks
     uint64_t kst_vwlen;     //<! sum of mpr_write_len for all vblocks
     uint64_t kst_vulen;     //<! total referenced data in all vblocks
+    uint64_t kst_ttl_bytes; //<! on-media length of values that expire
+    uint32_t kst_ttl_min;   //<! earliest expiry time (zero if none)
+    uint32_t kst_ttl_max;   //<! latest expiry time (zero if none)
     uint32_t kst_kvsets;    //<! number of kvsets (for node-level)
     uint32_t kst_hblks;     //<! number of hblocks
     uint32_t kst_kblks;     //<! number of kblocks
@@ -278,6 +281,44 @@ cn_merge_stats_diff(
     cn_merge_stats_ops_diff(&s->ms_kblk_read_wait, &a->ms_kblk_read_wait, &b->ms_kblk_read_wait);
 }
 
+static inline void
+cn_merge_stats_ops_add(struct cn_merge_stats_ops *s, const struct cn_merge_stats_ops *a)
+{
+    count_ops(s, a->op_cnt, a->op_size, a->op_time);
+}
+
+static inline void
+cn_merge_stats_add(struct cn_merge_stats *s, const struct cn_merge_stats *a)
+{
+    s->ms_srcs     += a->ms_srcs;
+    s->ms_keys_in  += a->ms_keys_in;
+    s->ms_keys_out += a->ms_keys_out;
+
+    s->ms_key_bytes_in  += a->ms_key_bytes_in;
+    s->ms_key_bytes_out += a->ms_key_bytes_out;
+    s->ms_val_bytes_out += a->ms_val_bytes_out;
+
+    s->ms_vblk_wasted_reads += a->ms_vblk_wasted_reads;
+
+    cn_merge_stats_ops_add(&s->ms_hblk_alloc, &a->ms_hblk_alloc);
+    cn_merge_stats_ops_add(&s->ms_hblk_write, &a->ms_hblk_write);
+
+    cn_merge_stats_ops_add(&s->ms_kblk_alloc, &a->ms_kblk_alloc);
+    cn_merge_stats_ops_add(&s->ms_kblk_write, &a->ms_kblk_write);
+
+    cn_merge_stats_ops_add(&s->ms_vblk_alloc, &a->ms_vblk_alloc);
+    cn_merge_stats_ops_add(&s->ms_vblk_write, &a->ms_vblk_write);
+
+    cn_merge_stats_ops_add(&s->ms_vblk_read1,      &a->ms_vblk_read1);
+    cn_merge_stats_ops_add(&s->ms_vblk_read1_wait, &a->ms_vblk_read1_wait);
+
+    cn_merge_stats_ops_add(&s->ms_vblk_read2,      &a->ms_vblk_read2);
+    cn_merge_stats_ops_add(&s->ms_vblk_read2_wait, &a->ms_vblk_read2_wait);
+
+    cn_merge_stats_ops_add(&s->ms_kblk_read,      &a->ms_kblk_read);
+    cn_merge_stats_ops_add(&s->ms_kblk_read_wait, &a->ms_kblk_read_wait);
+}
+
 /**
  * Metrics used to track space amp
  *
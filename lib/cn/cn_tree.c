@@ -27,11 +27,13 @@
 #include <hse_util/keycmp.h>
 #include <hse_util/bin_heap.h>
 #include <hse_util/log2.h>
+#include <hse_util/minmax.h>
 #include <hse_util/workqueue.h>
 #include <hse_util/compression_lz4.h>
 
 #include <mpool/mpool.h>
 
+#include <hse/experimental.h>
 #include <hse/limits.h>
 
 #include <hse_ikvdb/key_hash.h>
@@ -45,6 +47,9 @@
 #include <hse_ikvdb/sched_sts.h>
 #include <hse_ikvdb/csched.h>
 #include <hse_ikvdb/kvs_rparams.h>
+#include <hse_ikvdb/kvs_rtomb.h>
+#include <hse_ikvdb/kvset_builder.h>
+#include <hse_ikvdb/vcomp_params.h>
 
 #include <cn/cn_cursor.h>
 
@@ -57,6 +62,7 @@
 #include "cn_mblocks.h"
 #include "cn_metrics.h"
 #include "kvset.h"
+#include "node_bloom.h"
 #include "cn_perfc.h"
 #include "kcompact.h"
 #include "blk_list.h"
@@ -124,6 +130,7 @@ cn_node_free(struct cn_tree_node *tn)
 {
     if (tn) {
         hlog_destroy(tn->tn_hlog);
+        node_bloom_destroy(tn->tn_nbloom);
         kmem_cache_free(cn_node_cache, tn);
     }
 }
@@ -372,6 +379,7 @@ tn_samp_clear(struct cn_tree_node *tn)
     memset(&tn->tn_samp, 0, sizeof(tn->tn_samp));
 
     tn->tn_update_incr_dgen = 0;
+    tn->tn_keys_nohlog = 0;
 }
 
 /* Helper for cn_tree_samp_* functions.  Do not use directly. */
@@ -383,8 +391,16 @@ tn_samp_update_incr(struct cn_tree_node *tn, struct kvset *kvset, bool force)
     if (!force && dgen <= tn->tn_update_incr_dgen)
         return false;
 
-    if (tn->tn_hlog)
-        hlog_union(tn->tn_hlog, kvset_get_hlog(kvset));
+    if (tn->tn_hlog) {
+        const u8 *hlog = kvset_get_hlog(kvset);
+
+        /* A kvset that has not been loaded has no hlog to offer.
+         */
+        if (hlog)
+            hlog_union(tn->tn_hlog, hlog);
+        else
+            tn->tn_keys_nohlog += kvset_statsp(kvset)->kst_keys;
+    }
 
     kvset_stats_add(kvset_statsp(kvset), &tn->tn_ns.ns_kst);
 
@@ -405,10 +421,11 @@ tn_samp_update_finish(struct cn_tree_node *tn)
 
     /* Use hlog to estimate number of unique keys, but protect
      * against estimated values outside the valid range.
-     * If no hlog, assume all keys are unique.
+     * If no hlog, assume all keys are unique, as we must for
+     * the keys of kvsets that have not been loaded.
      */
     if (tn->tn_hlog) {
-        s->ns_keys_uniq = hlog_card(tn->tn_hlog);
+        s->ns_keys_uniq = hlog_card(tn->tn_hlog) + tn->tn_keys_nohlog;
         if (s->ns_keys_uniq > num_keys)
             s->ns_keys_uniq = num_keys;
     } else {
@@ -789,6 +806,127 @@ cn_tree_route_get(struct cn_tree *tree, const void *key, uint keylen)
     return node;
 }
 
+void
+cn_tree_node_bloom_update(struct cn_tree_node *tn)
+{
+    struct cn_tree *tree = tn->tn_tree;
+    struct kvset_list_entry *le, **lev;
+    struct node_bloom *nb, *old;
+    struct kvset **kvsetv;
+    uint kvsetc, i;
+    void *lock;
+    merr_t err;
+
+    if (!tree->rp->cn_node_bloom_prob || cn_node_isroot(tn))
+        return;
+
+    /* The token keeps the set of kvsets we collect here stable,
+     * so it's safe to use them after dropping the tree lock.
+     */
+    assert(atomic_read(&tn->tn_compacting));
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    kvsetc = 1;
+    list_for_each_entry(le, &tn->tn_kvset_list, le_link)
+        kvsetc++;
+
+    lev = malloc(kvsetc * (sizeof(*lev) + sizeof(*kvsetv)));
+    if (ev(!lev)) {
+        rmlock_runlock(lock);
+        return;
+    }
+
+    kvsetv = (void *)(lev + kvsetc);
+    kvsetc = 0;
+
+    list_for_each_entry(le, &tn->tn_kvset_list, le_link) {
+        if (kvset_has_ptree(le->le_kvset) || kvset_has_rtombs(le->le_kvset) ||
+            !kvset_is_loaded(le->le_kvset))
+            continue;
+
+        kvsetv[kvsetc] = le->le_kvset;
+        lev[kvsetc++] = le;
+    }
+    rmlock_runlock(lock);
+
+    /* A node bloom only pays for itself if it can rule out several kvsets.
+     */
+    nb = NULL;
+    if (kvsetc > 1) {
+        err = node_bloom_create(kvsetv, kvsetc, tree->rp->cn_node_bloom_prob, &nb);
+        if (err) {
+            log_errx("cnid %lu nodeid %lu: node bloom build failed", err,
+                     cn_tree_get_cnid(tree), tn->tn_nodeid);
+            nb = NULL;
+        }
+    }
+
+    rmlock_wlock(&tree->ct_lock);
+    old = tn->tn_nbloom;
+    tn->tn_nbloom = nb;
+    for (i = 0; nb && i < kvsetc; i++)
+        lev[i]->le_nbgen = nb->nb_gen;
+    rmlock_wunlock(&tree->ct_lock);
+
+    node_bloom_destroy(old);
+    free(lev);
+}
+
+void
+cn_tree_node_bloom_build(struct cn_tree *tree, atomic_int *cancel)
+{
+    struct cn_tree_node *tn;
+    uint64_t *nodeidv;
+    uint nodeidc, i;
+    void *lock;
+
+    if (!tree->rp->cn_node_bloom_prob)
+        return;
+
+    /* Snapshot the node IDs, as nodes may be split or joined while
+     * we are building filters.
+     */
+    rmlock_rlock(&tree->ct_lock, &lock);
+    nodeidc = 0;
+    cn_tree_foreach_leaf(tn, tree)
+        nodeidc++;
+
+    nodeidv = malloc((nodeidc + 1) * sizeof(*nodeidv));
+    if (ev(!nodeidv)) {
+        rmlock_runlock(lock);
+        return;
+    }
+
+    nodeidc = 0;
+    cn_tree_foreach_leaf(tn, tree)
+        nodeidv[nodeidc++] = tn->tn_nodeid;
+    rmlock_runlock(lock);
+
+    for (i = 0; i < nodeidc; i++) {
+        if (cancel && atomic_read(cancel))
+            break;
+
+        /* The compaction token prevents the node from being destroyed
+         * by a join once we drop the tree lock.
+         */
+        rmlock_rlock(&tree->ct_lock, &lock);
+        tn = cn_tree_find_node(tree, nodeidv[i]);
+        if (tn && !cn_node_comp_token_get(tn))
+            tn = NULL;
+        rmlock_runlock(lock);
+
+        if (!tn)
+            continue;
+
+        if (!tn->tn_nbloom)
+            cn_tree_node_bloom_update(tn);
+
+        cn_node_comp_token_put(tn);
+    }
+
+    free(nodeidv);
+}
+
 /**
  * cn_tree_lookup() - search cn tree for a key
  * @tree: cn tree
@@ -843,6 +981,12 @@ cn_tree_lookup(
 
     while (node) {
         struct kvset_list_entry *le;
+        uint64_t nbgen = 0;
+
+        /* A single node bloom probe can rule out all the kvsets it covers.
+         */
+        if (node->tn_nbloom && !qctx && !node_bloom_lookup(node->tn_nbloom, kt->kt_hash))
+            nbgen = node->tn_nbloom->nb_gen;
 
         /* Search kvsets from newest to oldest (head to tail).
          * If an error occurs or a key is found, return immediately.
@@ -850,6 +994,9 @@ cn_tree_lookup(
         list_for_each_entry(le, &node->tn_kvset_list, le_link) {
             struct kvset *kvset = le->le_kvset;
 
+            if (nbgen && le->le_nbgen == nbgen)
+                continue;
+
             if (qctx) {
                 err = kvset_pfx_lookup(kvset, kt, &kdisc, seq, res, wbti, kbuf, vbuf, qctx);
                 if (err || qctx->seen > 1 || *res == FOUND_PTMB)
@@ -891,6 +1038,255 @@ cn_tree_lookup(
     return err;
 }
 
+/**
+ * cn_tree_lookup_node_multi() - search a node for a vector of keys
+ * @node:   cn tree node to search
+ * @ktv:    vector of keys
+ * @kdiscv: vector of key discriminators (indexed as per %ktv)
+ * @seq:    view sequence number
+ * @resv:   (output) vector of results
+ * @vbufv:  (output) vector of value buffers
+ * @pendv:  vector of indices of unresolved keys
+ * @pendcp: (in/out) number of unresolved keys in %pendv
+ *
+ * Kvsets are searched newest to oldest, and each kvset is searched for all
+ * unresolved keys before moving on to the next kvset so that bloom and wbt
+ * pages shared by neighboring keys are touched while they are still hot.
+ * Resolved keys are removed from %pendv, which otherwise retains its order.
+ */
+static merr_t
+cn_tree_lookup_node_multi(
+    struct cn_tree_node *  node,
+    struct kvs_ktuple *    ktv,
+    const struct key_disc *kdiscv,
+    uint64_t               seq,
+    enum key_lookup_res *  resv,
+    struct kvs_buf *       vbufv,
+    uint *                 pendv,
+    uint *                 pendcp)
+{
+    const struct node_bloom *nb = node->tn_nbloom;
+    uint64_t nbmissv[HSE_KVS_GET_MULTI_MAX / 64];
+    struct kvset_list_entry *le;
+    uint pendc = *pendcp;
+
+    /* Probe the node bloom once per key, and remember which keys it rules
+     * out for all the kvsets it covers.
+     */
+    if (nb) {
+        memset(nbmissv, 0, sizeof(nbmissv));
+
+        for (uint i = 0; i < pendc; i++) {
+            const uint idx = pendv[i];
+
+            if (!node_bloom_lookup(nb, ktv[idx].kt_hash))
+                nbmissv[idx / 64] |= 1ul << (idx % 64);
+        }
+    }
+
+    list_for_each_entry(le, &node->tn_kvset_list, le_link) {
+        const bool covered = nb && le->le_nbgen == nb->nb_gen;
+        uint i, n;
+
+        for (i = n = 0; i < pendc; i++) {
+            const uint idx = pendv[i];
+            merr_t err;
+
+            if (covered && (nbmissv[idx / 64] & (1ul << (idx % 64)))) {
+                pendv[n++] = idx;
+                continue;
+            }
+
+            err = kvset_lookup(le->le_kvset, ktv + idx, kdiscv + idx, seq, resv + idx, vbufv + idx);
+            if (err) {
+                *pendcp = 0;
+                return err;
+            }
+
+            if (resv[idx] == NOT_FOUND)
+                pendv[n++] = idx;
+        }
+
+        pendc = n;
+        if (pendc == 0)
+            break;
+    }
+
+    *pendcp = pendc;
+
+    return 0;
+}
+
+/**
+ * cn_tree_lookup_multi() - search cn tree for a batch of keys
+ * @tree:  cn tree
+ * @pc:    perf counters
+ * @ktv:   vector of keys
+ * @seq:   view sequence number
+ * @resv:  (output) vector of results
+ * @vbufv: (output) vector of values for keys whose result is %FOUND_VAL
+ * @idxv:  indices of the keys to search for, sorted by key
+ * @idxc:  number of indices in %idxv
+ *
+ * Equivalent to calling cn_tree_lookup() for each key in %idxv, but the
+ * tree lock is acquired once for the batch, the root node is searched
+ * kvset-by-kvset for all keys, and the route map is consulted only once
+ * per run of keys that land in the same leaf node.
+ */
+merr_t
+cn_tree_lookup_multi(
+    struct cn_tree *     tree,
+    struct perfc_set *   pc,
+    struct kvs_ktuple *  ktv,
+    uint64_t             seq,
+    enum key_lookup_res *resv,
+    struct kvs_buf *     vbufv,
+    const uint *         idxv,
+    uint                 idxc)
+{
+    struct key_disc *kdiscv;
+    struct cn_tree_node *node;
+    uint pendc, i, idxmax;
+    uint *pendv;
+    void *lock;
+    merr_t err;
+
+    assert(idxc <= HSE_KVS_GET_MULTI_MAX);
+
+    /* The discriminators are indexed like %ktv, so size them for the
+     * largest index in the batch.
+     */
+    for (i = idxmax = 0; i < idxc; i++)
+        idxmax = max_t(uint, idxmax, idxv[i] + 1);
+
+    kdiscv = malloc(idxmax * sizeof(*kdiscv) + idxc * sizeof(*pendv));
+    if (ev(!kdiscv))
+        return merr(ENOMEM);
+
+    pendv = (uint *)(kdiscv + idxmax);
+
+    for (i = 0; i < idxc; i++) {
+        const uint idx = idxv[i];
+
+        assert(idx < HSE_KVS_GET_MULTI_MAX);
+
+        resv[idx] = NOT_FOUND;
+        key_disc_init(ktv[idx].kt_data, ktv[idx].kt_len, kdiscv + idx);
+        pendv[i] = idx;
+    }
+
+    pendc = idxc;
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    node = tree->ct_root;
+
+    err = cn_tree_lookup_node_multi(node, ktv, kdiscv, seq, resv, vbufv, pendv, &pendc);
+    if (err || cn_node_isleaf(node))
+        goto done;
+
+    /* pendv[] is still in key order, so all keys that route to the same
+     * leaf form a contiguous run.
+     */
+    i = 0;
+    while (i < pendc) {
+        const struct kvs_ktuple *kt = ktv + pendv[i];
+        struct route_node *rtn;
+        uint runc, j;
+
+        rtn = route_map_lookup(tree->ct_route_map, kt->kt_data, kt->kt_len);
+        if (!rtn) {
+            ++i;
+            continue;
+        }
+
+        for (j = i + 1; j < pendc; j++) {
+            kt = ktv + pendv[j];
+
+            if (route_node_keycmp(rtn, kt->kt_data, kt->kt_len) < 0)
+                break;
+        }
+
+        runc = j - i;
+
+        err = cn_tree_lookup_node_multi(route_node_tnode(rtn), ktv, kdiscv, seq, resv, vbufv,
+                                        pendv + i, &runc);
+        if (err)
+            break;
+
+        i = j;
+    }
+
+  done:
+    rmlock_runlock(lock);
+
+    free(kdiscv);
+
+    for (i = 0; i < idxc; i++)
+        perfc_inc(pc, resv[idxv[i]]);
+
+    return err;
+}
+
+void
+cn_tree_scan_bounds(
+    struct cn_tree *tree,
+    uint            rangec,
+    void           *keyv,
+    uint           *klenv,
+    uint           *keycp)
+{
+    struct route_node *rtn;
+    uint64_t total = 0, sum = 0;
+    uint keyc = 0, passed = 0;
+    bool unitw = false;
+    void *lock;
+
+    *keycp = 0;
+
+    if (rangec < 2)
+        return;
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    for (rtn = route_map_first_node(tree->ct_route_map); rtn; rtn = route_node_next(rtn)) {
+        struct cn_tree_node *tn = route_node_tnode(rtn);
+
+        total += cn_ns_alen(&tn->tn_ns);
+    }
+
+    /* If nothing has been spilled yet then weigh all the leaves equally.
+     */
+    if (total == 0) {
+        for (rtn = route_map_first_node(tree->ct_route_map); rtn; rtn = route_node_next(rtn))
+            total++;
+        unitw = true;
+    }
+
+    /* Each key is the edge key of the leaf at which the running sum of
+     * leaf sizes first reaches another 1/rangec of the total.  The last
+     * leaf's edge bounds nothing, so it is never chosen.
+     */
+    for (rtn = route_map_first_node(tree->ct_route_map); rtn; rtn = route_node_next(rtn)) {
+        struct cn_tree_node *tn = route_node_tnode(rtn);
+        uint n;
+
+        if (route_node_islast(rtn) || keyc >= rangec - 1)
+            break;
+
+        sum += unitw ? 1 : cn_ns_alen(&tn->tn_ns);
+
+        n = sum * rangec / total;
+        if (n > passed) {
+            route_node_keycpy(
+                rtn, (char *)keyv + keyc * HSE_KVS_KEY_LEN_MAX, HSE_KVS_KEY_LEN_MAX, &klenv[keyc]);
+            keyc++;
+            passed = n;
+        }
+    }
+    rmlock_runlock(lock);
+
+    *keycp = keyc;
+}
+
 bool
 cn_tree_is_capped(const struct cn_tree *tree)
 {
@@ -913,6 +1309,136 @@ cn_node_comp_token_put(struct cn_tree_node *tn)
     assert(b);
 }
 
+merr_t
+cn_compact_rtombs(struct cn_compaction_work *w, struct kvs_rtomb_vec *vec)
+{
+    for (uint i = 0; i < w->cw_kvset_cnt; i++) {
+        const struct kvs_rtomb *rtv;
+        uint rtc;
+
+        rtv = kvset_get_rtombs(kvset_from_iter(w->cw_inputv[i]), &rtc);
+        while (rtc-- > 0) {
+            merr_t err = kvs_rtomb_vec_add(vec, rtv++);
+
+            if (ev(err))
+                return err;
+        }
+    }
+
+    return kvs_rtomb_vec_sort(vec);
+}
+
+merr_t
+cn_compact_rtombs_emit(
+    struct cn_compaction_work  *w,
+    const struct kvs_rtomb_vec *vec,
+    struct kvset_builder       *bldr)
+{
+    for (uint i = 0; i < vec->krv_cnt; i++) {
+        const struct kvs_rtomb *rt = vec->krv_rtv + i;
+        merr_t err;
+
+        if (w->cw_drop_tombs && rt->kr_seq <= w->cw_horizon)
+            continue;
+
+        err = kvset_builder_add_rtomb(bldr, rt);
+        if (ev(err))
+            return err;
+    }
+
+    return 0;
+}
+
+merr_t
+cn_compact_filter_init(struct cn_compaction_work *w, struct cn_compact_filter_ctx *ctx, uint vlimit)
+{
+    memset(ctx, 0, sizeof(*ctx));
+
+    ctx->cfc_filter = cn_get_compact_filter(cn_tree_get_cn(w->cw_tree));
+    if (!ctx->cfc_filter)
+        return 0;
+
+    ctx->cfc_nbufsz = min_t(uint, vlimit, HSE_KVS_VALUE_LEN_MAX);
+
+    ctx->cfc_ubuf = malloc(HSE_KVS_VALUE_LEN_MAX);
+    ctx->cfc_nbuf = malloc(ctx->cfc_nbufsz);
+    if (ev(!ctx->cfc_ubuf || !ctx->cfc_nbuf)) {
+        cn_compact_filter_fini(ctx);
+        return merr(ENOMEM);
+    }
+
+    return 0;
+}
+
+void
+cn_compact_filter_fini(struct cn_compact_filter_ctx *ctx)
+{
+    free(ctx->cfc_ubuf);
+    free(ctx->cfc_nbuf);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+merr_t
+cn_compact_filter(
+    struct cn_compact_filter_ctx *ctx,
+    const struct key_obj         *kobj,
+    u64                           seq,
+    const void                  **vdata,
+    uint                         *vlen,
+    uint                         *complen,
+    bool                         *drop)
+{
+    const struct cn_compact_filter *cf = ctx->cfc_filter;
+    enum hse_kvs_compact_filter_res res;
+    char kbuf[HSE_KVS_KEY_LEN_MAX];
+    const void *val = *vdata;
+    size_t nlen = 0;
+    uint klen;
+
+    *drop = false;
+
+    if (*complen) {
+        uint outlen;
+        merr_t err;
+
+        err = vcomp_decompress(*vdata, *complen, NULL, ctx->cfc_ubuf, *vlen, &outlen);
+        if (ev(err))
+            return err;
+
+        if (ev(outlen != *vlen))
+            return merr(EBUG);
+
+        val = ctx->cfc_ubuf;
+    }
+
+    key_obj_copy(kbuf, sizeof(kbuf), &klen, kobj);
+
+    res = cf->cf_fn(cf->cf_arg, kbuf, klen, val, *vlen, seq, ctx->cfc_nbuf, ctx->cfc_nbufsz, &nlen);
+
+    switch (res) {
+    case HSE_KVS_COMPACT_FILTER_DROP:
+        *drop = true;
+        break;
+
+    case HSE_KVS_COMPACT_FILTER_CHANGE:
+        /* A replacement that overruns the buffer is a bug in the filter,
+         * the original value is kept rather than failing the compaction.
+         */
+        if (ev(nlen > ctx->cfc_nbufsz))
+            break;
+
+        *vdata = ctx->cfc_nbuf;
+        *vlen = nlen;
+        *complen = 0;
+        break;
+
+    default:
+        break;
+    }
+
+    return 0;
+}
+
 /**
  * cn_tree_capped_evict() - evict unneeded vblock pages
  * @tree:   cn_tree pointer
@@ -1114,6 +1640,15 @@ cn_tree_prepare_compaction(struct cn_compaction_work *w)
     if (w->cw_action == CN_ACTION_JOIN)
         return 0; /* no resources needed for join */
 
+    /* Input kvsets that were opened lazily must have their blocks mapped
+     * before we read them (node splits access their kblocks directly).
+     */
+    for (i = 0, le = w->cw_mark; i < w->cw_kvset_cnt; i++, le = list_prev_entry(le, le_link)) {
+        err = kvset_load(le->le_kvset);
+        if (ev(err))
+            return err;
+    }
+
     /* If we are k/kv-compacting, we only have a single output.
      *
      * Node split creates at most twice the number of kvsets as the source node (n_outs)
@@ -1865,6 +2400,13 @@ cn_comp_cleanup(struct cn_compaction_work *w)
             cn_node_comp_token_put(w->cw_join);
     }
 
+    /* Compaction replaced kvsets covered by the node bloom (if any),
+     * so rebuild it while we still hold the node's compaction token.
+     */
+    if (!w->cw_err && w->cw_have_token &&
+        (kcompact || w->cw_action == CN_ACTION_COMPACT_KV))
+        cn_tree_node_bloom_update(w->cw_node);
+
     atomic_sub_rel(&w->cw_node->tn_busycnt, (1u << 16) + w->cw_kvset_cnt);
 
     if (w->cw_have_token)
@@ -43,6 +43,36 @@ cn_tree_lookup(
     struct kvs_buf *     kbuf,
     struct kvs_buf *     vbuf);
 
+merr_t
+cn_tree_lookup_multi(
+    struct cn_tree *     tree,
+    struct perfc_set *   pc,
+    struct kvs_ktuple *  ktv,
+    u64                  seq,
+    enum key_lookup_res *resv,
+    struct kvs_buf *     vbufv,
+    const uint *         idxv,
+    uint                 idxc);
+
+/**
+ * cn_tree_scan_bounds() - Find keys that divide a tree into ranges of similar size
+ *
+ * @tree:   cn_tree handle
+ * @rangec: number of key ranges desired
+ * @keyv:   buffer of (@rangec - 1) * HSE_KVS_KEY_LEN_MAX bytes for the keys
+ * @klenv:  (output) key lengths
+ * @keycp:  (output) number of keys found, at most @rangec - 1
+ *
+ * The keys are route map edge keys, in ascending order.  See cn_scan_bounds().
+ */
+void
+cn_tree_scan_bounds(
+    struct cn_tree *tree,
+    uint            rangec,
+    void           *keyv,
+    uint           *klenv,
+    uint           *keycp);
+
 /* Return true if the cn_tree is capped. */
 bool
 cn_tree_is_capped(const struct cn_tree *tree);
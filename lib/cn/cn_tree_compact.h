@@ -27,6 +27,10 @@ struct kv_iterator;
 struct kvset_list_entry;
 struct kvset_mblocks;
 struct kvset;
+struct kvset_builder;
+struct kvs_rtomb_vec;
+struct cn_compact_filter;
+struct key_obj;
 
 enum cn_action {
     CN_ACTION_NONE = 0,
@@ -91,6 +95,7 @@ struct cn_work_est {
  * @cw_node:         node within cn tree
  * @cw_mark:         oldest kvset to be compacted
  * @cw_kvset_cnt:    number of kvsets to be compacted
+ * @cw_subc:         number of key ranges a kv-compaction may be split into
  * @cw_action:       spill, k-compact, or kv-compact
  * @cw_rspill_link:  for adding struct to root node's list of completed spills
  * @cw_rspill_done:  if set, then root spill compaction work is done
@@ -143,6 +148,7 @@ struct cn_compaction_work {
     struct kvset_list_entry *cw_mark;
     struct cn_node_stats     cw_ns;
     uint                     cw_kvset_cnt;
+    uint                     cw_subc;
     uint32_t                 cw_nh;
     uint32_t                 cw_nk;
     uint32_t                 cw_nv;
@@ -217,6 +223,85 @@ cn_tree_ingest_update(
 void
 cn_tree_capped_compact(struct cn_tree *tree);
 
+/**
+ * cn_compact_rtombs() - collect the range tombstones of a compaction's inputs
+ * @w:   compaction work
+ * @vec: tombstone vector to which the tombstones are appended
+ *
+ * %vec is then arranged by kvs_rtomb_vec_sort() for lookups.  The tombstone
+ * keys remain valid until the input iterators are released.
+ */
+merr_t
+cn_compact_rtombs(struct cn_compaction_work *w, struct kvs_rtomb_vec *vec);
+
+/**
+ * cn_compact_rtombs_emit() - add range tombstones to a compaction's output
+ * @w:    compaction work
+ * @vec:  tombstones collected by cn_compact_rtombs()
+ * @bldr: output kvset builder
+ *
+ * Tombstones below the horizon are dropped if the compaction may drop
+ * tombstones, as everything they hide has been dropped by the merge.
+ */
+merr_t
+cn_compact_rtombs_emit(
+    struct cn_compaction_work  *w,
+    const struct kvs_rtomb_vec *vec,
+    struct kvset_builder       *bldr);
+
+/**
+ * struct cn_compact_filter_ctx - compaction filter state of a compaction
+ * @cfc_filter: the kvs compaction filter (NULL if none is registered)
+ * @cfc_ubuf:   buffer for decompressed values
+ * @cfc_nbuf:   buffer for replacement values
+ * @cfc_nbufsz: size of %cfc_nbuf
+ */
+struct cn_compact_filter_ctx {
+    const struct cn_compact_filter *cfc_filter;
+    void                           *cfc_ubuf;
+    void                           *cfc_nbuf;
+    uint                            cfc_nbufsz;
+};
+
+/**
+ * cn_compact_filter_init() - prepare to apply the kvs compaction filter
+ * @w:      compaction work
+ * @ctx:    filter context
+ * @vlimit: max length of a replacement value
+ *
+ * %ctx->cfc_filter is NULL if no filter is registered, in which case
+ * nothing is allocated.
+ */
+merr_t
+cn_compact_filter_init(struct cn_compaction_work *w, struct cn_compact_filter_ctx *ctx, uint vlimit);
+
+void
+cn_compact_filter_fini(struct cn_compact_filter_ctx *ctx);
+
+/**
+ * cn_compact_filter() - offer a value to the kvs compaction filter
+ * @ctx:     filter context
+ * @kobj:    key
+ * @seq:     seqno of the value
+ * @vdata:   (in/out) value
+ * @vlen:    (in/out) uncompressed length of the value
+ * @complen: (in/out) compressed length of the value (zero if uncompressed)
+ * @drop:    (output) set if the filter deleted the key
+ *
+ * The caller must offer only the newest value of a key at or below the
+ * horizon, and never a tombstone or merge operand.  If the filter replaces
+ * the value, %vdata, %vlen and %complen describe the replacement on return.
+ */
+merr_t
+cn_compact_filter(
+    struct cn_compact_filter_ctx *ctx,
+    const struct key_obj         *kobj,
+    u64                           seq,
+    const void                  **vdata,
+    uint                         *vlen,
+    uint                         *complen,
+    bool                         *drop);
+
 /* MTF_MOCK */
 bool
 cn_node_comp_token_get(struct cn_tree_node *tn);
@@ -24,6 +24,7 @@
 #include <hse_util/key_util.h>
 #include <hse_util/keycmp.h>
 #include <hse_util/bin_heap.h>
+#include <hse_util/minmax.h>
 
 #include <hse_ikvdb/cn.h>
 
@@ -170,10 +171,13 @@ cn_lcur_init(
     }
 
     esrc = lcur->cnlc_esrcv;
+    kvs_rtomb_vec_reset(&lcur->cnlc_rtombs);
 
     for (i = 0; i < iterc; i++) {
         struct kvref *k = table_at(tab, i);
+        const struct kvs_rtomb *rtv;
         struct kv_iterator *it;
+        uint rtc;
 
         err = kvset_iter_create(k->kvset, NULL, maint_wq, NULL, cncur->cncur_flags, &it);
         if (ev(err))
@@ -181,8 +185,20 @@ cn_lcur_init(
 
         *esrc++ = kvset_iter_es_get(it);
         ++lcur->cnlc_iterc;
+
+        /* The tombstone keys remain valid while we hold the kvset ref. */
+        rtv = kvset_get_rtombs(k->kvset, &rtc);
+        while (rtc-- > 0) {
+            err = kvs_rtomb_vec_add(&lcur->cnlc_rtombs, rtv++);
+            if (ev(err))
+                return err;
+        }
     }
 
+    err = kvs_rtomb_vec_sort(&lcur->cnlc_rtombs);
+    if (ev(err))
+        return err;
+
     if (!lcur->cnlc_iterc)
         return 0;
 
@@ -213,6 +229,7 @@ cn_lcur_kvset_release(struct cn_level_cursor *lcur)
         kvset_iter_release(kvset_cursor_es_h2r(lcur->cnlc_esrcv[i]));
 
     lcur->cnlc_iterc = 0;
+    kvs_rtomb_vec_reset(&lcur->cnlc_rtombs);
 
     table_apply(lcur->cnlc_kvref_tab, kvref_tab_putref);
     table_reset(lcur->cnlc_kvref_tab);
@@ -276,6 +293,7 @@ out:
             cn_lcur_kvset_release(lcur);
             table_destroy(lcur->cnlc_kvref_tab);
             free(lcur->cnlc_esrcv);
+            kvs_rtomb_vec_fini(&lcur->cnlc_rtombs);
         }
     }
 
@@ -295,6 +313,7 @@ cn_tree_cursor_destroy(struct cn_cursor *cur)
         table_destroy(lcur->cnlc_kvref_tab);
         bin_heap_destroy(lcur->cnlc_bh);
         free(lcur->cnlc_esrcv);
+        kvs_rtomb_vec_fini(&lcur->cnlc_rtombs);
     }
 
     bin_heap_destroy(cur->cncur_bh);
@@ -561,6 +580,29 @@ cn_tree_cursor_update(struct cn_cursor *cur)
     return err;
 }
 
+/* Return the seqno of the newest range tombstone in the cursor's view that
+ * covers the given key, from either the root or the current leaf node.
+ */
+static u64
+cn_tree_cursor_rtomb_seq(struct cn_cursor *cur, const struct key_obj *kobj)
+{
+    u64 seq = 0;
+    int i;
+
+    for (i = 0; i < NUM_LEVELS; i++) {
+        const struct kvs_rtomb_vec *vec = &cur->cncur_lcur[i].cnlc_rtombs;
+        u64 rt_seq;
+
+        if (!vec->krv_cnt)
+            continue;
+
+        rt_seq = kvs_rtomb_seq(vec->krv_rtv, vec->krv_cnt, kobj, cur->cncur_seqno);
+        seq = max_t(u64, seq, rt_seq);
+    }
+
+    return seq;
+}
+
 static void
 drop_dups(struct cn_cursor *cur, struct key_obj *kobj)
 {
@@ -655,6 +697,7 @@ cn_tree_cursor_read(struct cn_cursor *cur, struct kvs_cursor_element *elem, bool
     struct cn_kv_item  *item;
     u64                 seq;
     bool                found;
+    enum kmd_vtype      vtype;
     const void *        vdata;
     uint                vlen;
     uint                complen;
@@ -674,7 +717,6 @@ cn_tree_cursor_read(struct cn_cursor *cur, struct kvs_cursor_element *elem, bool
         key2kobj(&filter_ko, cur->cncur_filter->kcf_maxkey, cur->cncur_filter->kcf_maxklen);
 
     do {
-        enum kmd_vtype vtype;
         u32            vbidx;
         u32            vboff;
         bool           more;
@@ -716,6 +758,9 @@ cn_tree_cursor_read(struct cn_cursor *cur, struct kvs_cursor_element *elem, bool
         if (!found)
             continue; /* Key doesn't have a value in the cursor's view. */
 
+        if (kvs_expired(item->vctx.expire))
+            vtype = VTYPE_TOMB; /* Expired values read as tombstones. */
+
         cur->cncur_merr = kvset_iter_val_get(kv_iter, &item->vctx, vtype, vbidx,
                                        vboff, &vdata, &vlen, &complen);
         if (ev(cur->cncur_merr))
@@ -731,6 +776,9 @@ cn_tree_cursor_read(struct cn_cursor *cur, struct kvs_cursor_element *elem, bool
             }
         }
 
+        if (found && vtype != VTYPE_PTOMB && cn_tree_cursor_rtomb_seq(cur, &item->kobj) > seq)
+            found = false; /* Key is hidden by a range tombstone. */
+
         if (vtype == VTYPE_PTOMB) {
             found = false;
 
@@ -757,6 +805,7 @@ cn_tree_cursor_read(struct cn_cursor *cur, struct kvs_cursor_element *elem, bool
     kvs_vtuple_init(&elem->kce_vt, (void *)vdata, vlen);
     elem->kce_complen = complen;
     elem->kce_is_ptomb = false; /* cn never returns a ptomb */
+    elem->kce_is_merge = (vtype == VTYPE_MVAL);
     elem->kce_seqnoref = HSE_ORDNL_TO_SQNREF(seq);
 
     cur->cncur_stats.ms_keys_out++;
@@ -27,6 +27,7 @@
 #include "csched_sp3.h"
 
 struct hlog;
+struct node_bloom;
 struct route_map;
 
 /* Each node in a cN tree contains a list of kvsets that must be protected
@@ -144,6 +145,8 @@ struct cn_tree {
  * @tn_dnode_linkv:  dirty list linkage for csched
  * @tn_destroy_work: used for async destroy
  * @tn_hlog:         hyperloglog structure
+ * @tn_keys_nohlog:  keys of kvsets not yet loaded, hence not in @tn_hlog
+ * @tn_nbloom:       aggregate bloom over the node's kvsets (leaf nodes only)
  * @tn_ns:           metrics about node to guide node compaction decisions
  * @tn_pfx_spill:    true if spills/scans from this node use the prefix hash
  * @tn_tree:         ptr to tree struct
@@ -158,6 +161,8 @@ struct cn_tree_node {
     struct list_head     tn_kvset_list HSE_L1D_ALIGNED;
     u64                  tn_update_incr_dgen;
     struct hlog         *tn_hlog;
+    u64                  tn_keys_nohlog;
+    struct node_bloom   *tn_nbloom;
     struct cn_node_stats tn_ns;
     struct cn_samp_stats tn_samp;
 
@@ -257,6 +262,33 @@ cn_compact(struct cn_compaction_work *w);
 struct cn_tree_node *
 cn_tree_find_node(struct cn_tree *tree, uint64_t nodeid);
 
+/**
+ * cn_tree_node_bloom_update() - rebuild a leaf node's aggregate bloom filter
+ *
+ * @tn: leaf node
+ *
+ * Builds a new node bloom over all the node's kvsets that do not contain
+ * prefix tombstones and replaces the current one.  Does nothing if node
+ * blooms are disabled.  The caller must hold the node's compaction token,
+ * which ensures that no kvset can be removed from the node while the filter
+ * is being built (kvsets added by a concurrent spill simply remain uncovered).
+ */
+void
+cn_tree_node_bloom_update(struct cn_tree_node *tn);
+
+/**
+ * cn_tree_node_bloom_build() - build node blooms for all leaf nodes
+ *
+ * @tree:   tree
+ * @cancel: stop early if set (may be NULL)
+ *
+ * Used to build the filters after the tree is loaded at open time.  Nodes
+ * whose compaction token is held by a compaction job are skipped, as the
+ * job will rebuild the filter when it completes.
+ */
+void
+cn_tree_node_bloom_build(struct cn_tree *tree, atomic_int *cancel);
+
 #if HSE_MOCKING
 #include "cn_tree_internal_ut.h"
 #endif /* HSE_MOCKING */
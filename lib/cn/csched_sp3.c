@@ -359,6 +359,32 @@ samp_pct_garbage(struct cn_samp_stats *s, uint scale)
     return scale * safe_div(s->l_alen - s->l_good, s->l_alen);
 }
 
+/* Estimate the percentage of a node's space occupied by expired values,
+ * assuming expiry times are evenly distributed between the earliest and
+ * latest expiry times of the node's values.
+ */
+static uint
+sp3_node_pct_expired(const struct cn_node_stats *ns, uint scale)
+{
+    const struct kvset_stats *kst = &ns->ns_kst;
+    uint64_t now, est;
+
+    if (!kst->kst_ttl_bytes)
+        return 0;
+
+    now = time(NULL);
+    if (now < kst->kst_ttl_min)
+        return 0;
+
+    if (now >= kst->kst_ttl_max)
+        est = kst->kst_ttl_bytes;
+    else
+        est = kst->kst_ttl_bytes * (now - kst->kst_ttl_min + 1) /
+              (kst->kst_ttl_max - kst->kst_ttl_min + 1);
+
+    return min_t(uint, scale, scale * safe_div(est, cn_ns_alen(ns)));
+}
+
 static void
 sp3_monitor_wake(struct sp3 *sp)
 {
@@ -640,6 +666,8 @@ sp3_refresh_thresholds(struct sp3 *sp)
 
     thresh.split_cnt_max = qthreads(sp, SP3_QNUM_SPLIT);
 
+    thresh.subc_max = sp->rp->csched_subcomp_max;
+
     /* If thresholds have not changed there's nothing to do.  Otherwise, need to
      * recompute work trees.
      */
@@ -653,13 +681,13 @@ sp3_refresh_thresholds(struct sp3 *sp)
     }
 
     log_info("sp3 thresholds: rspill: min/max/wlenmb %u/%u/%lu, lcomp: max/pct/keys %u/%u%%/%u,"
-             " llen: min/max %u/%u, idlec: %u, idlem: %u, lscat: hwm/max %u/%u split %u",
+             " llen: min/max %u/%u, idlec: %u, idlem: %u, lscat: hwm/max %u/%u split %u subc %u",
              thresh.rspill_runlen_min, thresh.rspill_runlen_max, thresh.rspill_wlen_max >> 20,
              thresh.lcomp_runlen_max, thresh.lcomp_join_pct, thresh.lcomp_split_keys >> 20,
              thresh.llen_runlen_min, thresh.llen_runlen_max,
              thresh.llen_idlec, thresh.llen_idlem,
              thresh.lscat_hwm, thresh.lscat_runlen_max,
-             thresh.split_cnt_max);
+             thresh.split_cnt_max, thresh.subc_max);
 }
 
 static void
@@ -937,6 +965,7 @@ sp3_dirty_node_locked(struct sp3 *sp, struct cn_tree_node *tn)
             uint64_t weight;
 
             garbage = samp_pct_garbage(&tn->tn_samp, 100);
+            garbage = min_t(uint, 100, garbage + sp3_node_pct_expired(ns, 100));
             scatter = cn_tree_node_scatter(tn);
 
             /* Leaf nodes sorted by vgroup scatter and garbage.
@@ -6,6 +6,7 @@
 #define MTF_MOCK_IMPL_csched_sp3_work
 
 #include <hse_util/event_counter.h>
+#include <hse_util/minmax.h>
 #include <hse_util/platform.h>
 #include <hse_util/slab.h>
 #include <hse/logging/logging.h>
@@ -832,6 +833,18 @@ sp3_work_wtype_length(
     return 0;
 }
 
+/* Large kv-compactions are split into key ranges that are merged in
+ * parallel, aiming for at least SP3_SUBC_RLEN_MIN bytes of input per range.
+ */
+static uint
+sp3_work_subc(const struct cn_compaction_work *w, const struct sp3_thresholds *thresh)
+{
+    if (w->cw_action != CN_ACTION_COMPACT_KV)
+        return 1;
+
+    return clamp_t(uint, w->cw_est.cwe_read_sz / SP3_SUBC_RLEN_MIN, 1, thresh->subc_max);
+}
+
 /**
  * sp3_work() - determine if a given node needs maintenance
  * @tn: the cn tree node to check
@@ -1064,6 +1077,8 @@ sp3_work(
 
     sp3_work_estimate(w);
 
+    w->cw_subc = sp3_work_subc(w, thresh);
+
     return 0;
 
 locked_nowork:
@@ -48,6 +48,10 @@
 #define SP3_LCOMP_SPLIT_KEYS_MAX        (UINT_MAX)
 #define SP3_LCOMP_SPLIT_KEYS_DEFAULT    (256u << 20)
 
+/* Min input length per key range of a parallel kv-compaction.
+ */
+#define SP3_SUBC_RLEN_MIN               (4ul << 30)
+
 /* clang-format on */
 
 struct sp3_node;
@@ -81,6 +85,7 @@ struct sp3_thresholds {
     uint8_t  llen_idlec;
     uint8_t  llen_idlem;
     uint8_t  split_cnt_max;       /* max node splits per batch */
+    uint8_t  subc_max;            /* max key ranges per kv-compaction */
 };
 
 /* MTF_MOCK */
@@ -13,6 +13,7 @@
 #include <hse_ikvdb/blk_list.h>
 #include <hse_ikvdb/cn.h>
 #include <hse_ikvdb/kvset_builder.h>
+#include <hse_ikvdb/kvs_rtomb.h>
 #include <hse_ikvdb/mclass_policy.h>
 #include <hse_util/alloc.h>
 #include <hse_util/event_counter.h>
@@ -37,6 +38,10 @@ struct hblock_builder {
     unsigned int               ptree_pgc;
     uint32_t                   max_size;
     uint32_t                   nptombs;
+    uint32_t                   nrtombs;
+    size_t                     rtombs_len;
+    size_t                     rtombs_sz;
+    void                      *rtombs;
     enum hse_mclass_policy_age agegroup;
 };
 
@@ -56,6 +61,8 @@ make_header(
     const uint32_t num_vblocks,
     const uint32_t ptree_pgc,
     const uint32_t vgmap_pgc,
+    const uint32_t num_rtombs,
+    const uint32_t rtomb_pgc,
     const struct key_obj *const min_pfx,
     const struct key_obj *const max_pfx)
 {
@@ -75,6 +82,9 @@ make_header(
     omf_set_hbh_hlog_len_pg(hdr, HLOG_PGC);
     omf_set_hbh_ptree_data_off_pg(hdr, HBLOCK_HDR_PAGES + vgmap_pgc + HLOG_PGC);
     omf_set_hbh_ptree_data_len_pg(hdr, ptree_pgc);
+    omf_set_hbh_num_rtombs(hdr, num_rtombs);
+    omf_set_hbh_rtomb_off_pg(hdr, HBLOCK_HDR_PAGES + vgmap_pgc + HLOG_PGC + ptree_pgc);
+    omf_set_hbh_rtomb_len_pg(hdr, rtomb_pgc);
 
     if (max_pfx) {
         unsigned int max_pfx_len = 0;
@@ -146,6 +156,52 @@ hbb_add_ptomb(
     return !added ? merr(EXFULL) : err;
 }
 
+merr_t
+hbb_add_rtomb(struct hblock_builder *bld, const struct kvs_rtomb *rt)
+{
+    struct rtomb_omf *omf;
+    size_t len;
+
+    len = bld->rtombs_len + sizeof(*omf) + rt->kr_start_len + rt->kr_end_len;
+
+    /* The region is written as-is, so keep it page aligned and sized.
+     */
+    if (len > bld->rtombs_sz) {
+        size_t sz = roundup(len * 2, PAGE_SIZE);
+        void *mem;
+
+        if ((sz / PAGE_SIZE) + bld->ptree_pgc > available_pgc(bld)) {
+            sz = roundup(len, PAGE_SIZE);
+            if ((sz / PAGE_SIZE) + bld->ptree_pgc > available_pgc(bld))
+                return merr(EXFULL);
+        }
+
+        mem = aligned_alloc(PAGE_SIZE, sz);
+        if (ev(!mem))
+            return merr(ENOMEM);
+
+        if (bld->rtombs)
+            memcpy(mem, bld->rtombs, bld->rtombs_len);
+        memset(mem + bld->rtombs_len, 0, sz - bld->rtombs_len);
+
+        free(bld->rtombs);
+        bld->rtombs = mem;
+        bld->rtombs_sz = sz;
+    }
+
+    omf = bld->rtombs + bld->rtombs_len;
+    omf_set_rt_seqno(omf, rt->kr_seq);
+    omf_set_rt_start_len(omf, rt->kr_start_len);
+    omf_set_rt_end_len(omf, rt->kr_end_len);
+    memcpy(omf + 1, rt->kr_start, rt->kr_start_len);
+    memcpy((void *)(omf + 1) + rt->kr_start_len, rt->kr_end, rt->kr_end_len);
+
+    bld->rtombs_len = len;
+    bld->nrtombs++;
+
+    return 0;
+}
+
 merr_t
 hbb_create(struct hblock_builder **bld_out, const struct cn *const cn, struct perfc_set *pc)
 {
@@ -159,6 +215,10 @@ hbb_create(struct hblock_builder **bld_out, const struct cn *const cn, struct pe
         return merr(ENOMEM);
 
     bld->nptombs = 0;
+    bld->nrtombs = 0;
+    bld->rtombs_len = 0;
+    bld->rtombs_sz = 0;
+    bld->rtombs = NULL;
     bld->mpool = cn_get_dataset(cn);
     bld->cn = cn;
     bld->pc = pc;
@@ -194,6 +254,7 @@ hbb_destroy(struct hblock_builder *bld)
         return;
 
     wbb_destroy(bld->ptree);
+    free(bld->rtombs);
     free(bld);
 }
 
@@ -217,7 +278,7 @@ hbb_finish(
     merr_t err;
     enum hse_mclass mclass;
     uint64_t blkid = 0;
-    uint32_t vgmap_pgc = 0;
+    uint32_t vgmap_pgc = 0, rtomb_pgc = 0;
     struct iovec *iov = NULL;
     unsigned int iov_max, iov_idx = 0;
     size_t wlen = 0, sz;
@@ -231,10 +292,10 @@ hbb_finish(
         return merr(EINVAL);
 
     /* In the event that no kblocks were emitted and there are no entries in the
-     * ptree, there is no data within containing kvset. Skip the allocation of
-     * the hblock. This kvset will not be written to disk.
+     * ptree and no range tombstones, there is no data within containing kvset.
+     * Skip the allocation of the hblock. This kvset will not be written to disk.
      */
-    if (num_kblocks == 0 && (!wbb_entries(bld->ptree) && !ptree))
+    if (num_kblocks == 0 && (!wbb_entries(bld->ptree) && !ptree) && bld->nrtombs == 0)
         return 0;
 
     assert(!ptree || (ptree_desc && ptree_pgc > 0));
@@ -249,6 +310,11 @@ hbb_finish(
     /* Header and HyperLogLog */
     iov_max = 2;
 
+    if (bld->nrtombs > 0) {
+        iov_max++;
+        rtomb_pgc = roundup(bld->rtombs_len, PAGE_SIZE) / PAGE_SIZE;
+    }
+
     if (vgmap) {
         iov_max++;
         sz = sizeof(struct vgroup_map_omf) + vgmap->nvgroups * sizeof(struct vgroup_map_entry_omf);
@@ -311,8 +377,14 @@ hbb_finish(
         wbb_min_max_keys(bld->ptree, min_pfxp, max_pfxp);
     }
 
+    if (bld->nrtombs > 0) {
+        /* Finalize range tombstones */
+        iov[iov_idx].iov_base = bld->rtombs;
+        iov[iov_idx++].iov_len = rtomb_pgc * PAGE_SIZE;
+    }
+
     make_header(hdr, min_seqno, max_seqno, num_ptombs, num_kblocks, num_vblocks,
-                ptree_pgc, vgmap_pgc, min_pfxp, max_pfxp);
+                ptree_pgc, vgmap_pgc, bld->nrtombs, rtomb_pgc, min_pfxp, max_pfxp);
 
     if (vgmap)
         make_vgroup_map(vgmap, ((char *)hdr) + HBLOCK_HDR_LEN);
@@ -386,6 +458,12 @@ hbb_get_nptombs(const struct hblock_builder *bld)
     return bld->nptombs;
 }
 
+uint32_t
+hbb_get_nrtombs(const struct hblock_builder *bld)
+{
+    return bld->nrtombs;
+}
+
 #if HSE_MOCKING
 #include "hblock_builder_ut_impl.i"
 #endif /* HSE_MOCKING */
@@ -20,6 +20,7 @@ struct hlog;
 struct key_obj;
 struct kvs_block;
 struct key_stats;
+struct kvs_rtomb;
 struct vgmap;
 struct perfc_set;
 struct wbt_desc;
@@ -33,6 +34,17 @@ hbb_add_ptomb(
     unsigned int kmd_len,
     struct key_stats *stats);
 
+/**
+ * hbb_add_rtomb() - add a range tombstone to the hblock
+ * @bld: hblock builder
+ * @rt:  range tombstone (the keys are copied)
+ *
+ * Range tombstones are stored in their own region after the ptree.
+ */
+/* MTF_MOCK */
+merr_t
+hbb_add_rtomb(struct hblock_builder *bld, const struct kvs_rtomb *rt);
+
 /* MTF_MOCK */
 merr_t
 hbb_create(struct hblock_builder **bld_out, const struct cn *cn, struct perfc_set *pc);
@@ -62,9 +74,14 @@ hbb_finish(
 merr_t
 hbb_set_agegroup(struct hblock_builder *bld, enum hse_mclass_policy_age age) HSE_NONNULL(1);
 
+/* MTF_MOCK */
 uint32_t
 hbb_get_nptombs(const struct hblock_builder *bld);
 
+/* MTF_MOCK */
+uint32_t
+hbb_get_nrtombs(const struct hblock_builder *bld);
+
 #if HSE_MOCKING
 #include "hblock_builder_ut.h"
 #endif /* HSE_MOCKING */
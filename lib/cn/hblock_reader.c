@@ -9,6 +9,7 @@
 #include <errno.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 
 #include <hse_util/compiler.h>
 #include <hse_util/event_counter.h>
@@ -16,6 +17,8 @@
 #include <mpool/mpool_structs.h>
 #include <mpool/mpool.h>
 
+#include <hse_ikvdb/kvs_rtomb.h>
+
 #include "kvset.h"
 #include "hblock_reader.h"
 #include "kvs_mblk_desc.h"
@@ -28,7 +31,8 @@ hblock_hdr_valid(const struct hblock_hdr_omf *omf)
     const uint32_t version = omf_hbh_version(omf);
     const uint32_t magic = omf_hbh_magic(omf);
 
-    return HSE_LIKELY(magic == HBLOCK_HDR_MAGIC && version == HBLOCK_HDR_VERSION);
+    return HSE_LIKELY(magic == HBLOCK_HDR_MAGIC &&
+                      version >= HBLOCK_HDR_VERSION1 && version <= HBLOCK_HDR_VERSION);
 }
 
 static merr_t
@@ -264,6 +268,59 @@ hbr_read_ptree(
     *ptree_pgc = ptd->wbd_n_pages;
 }
 
+merr_t
+hbr_read_rtombs(const struct kvs_mblk_desc *hbd, struct kvs_rtomb **rtv, uint32_t *rtc)
+{
+    const void *region, *end;
+    struct kvs_rtomb *v;
+    uint32_t cnt;
+
+    *rtv = NULL;
+    *rtc = 0;
+
+    /* Version 1 hblocks have no range tombstone region. */
+    if (omf_hbh_version(hbd->map_base) < HBLOCK_HDR_VERSION2)
+        return 0;
+
+    cnt = omf_hbh_num_rtombs(hbd->map_base);
+    if (cnt == 0)
+        return 0;
+
+    region = hbd->map_base + (omf_hbh_rtomb_off_pg(hbd->map_base) * PAGE_SIZE);
+    end = region + (omf_hbh_rtomb_len_pg(hbd->map_base) * PAGE_SIZE);
+
+    v = malloc(cnt * sizeof(*v));
+    if (ev(!v))
+        return merr(ENOMEM);
+
+    for (uint32_t i = 0; i < cnt; i++) {
+        const struct rtomb_omf *omf = region;
+
+        if (region + sizeof(*omf) > end)
+            goto invalid;
+
+        v[i].kr_seq = omf_rt_seqno(omf);
+        v[i].kr_start_len = omf_rt_start_len(omf);
+        v[i].kr_end_len = omf_rt_end_len(omf);
+        v[i].kr_start = omf + 1;
+        v[i].kr_end = v[i].kr_start + v[i].kr_start_len;
+
+        region = v[i].kr_end + v[i].kr_end_len;
+        if (region > end)
+            goto invalid;
+    }
+
+    *rtv = v;
+    *rtc = cnt;
+
+    return 0;
+
+invalid:
+    free(v);
+
+    return merr(EPROTO);
+}
+
 #if HSE_MOCKING
 #include "hblock_reader_ut_impl.i"
 #endif /* HSE_MOCKING */
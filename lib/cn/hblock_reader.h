@@ -14,6 +14,7 @@
 #include <hse/error/merr.h>
 
 struct kvs_mblk_desc;
+struct kvs_rtomb;
 struct mblock_props;
 struct mpool;
 struct mpool_mcache_map;
@@ -147,6 +148,18 @@ hbr_read_ptree(
     uint8_t                   **ptree,
     uint32_t                   *ptree_pgc);
 
+/**
+ * Return the range tombstones from the hblock.
+ *
+ * The keys of each range tombstone reference the mapped hblock.
+ *
+ * @param hbd hblock descriptor
+ * @param[out] rtv range tombstone vector (NULL if none, else free with free())
+ * @param[out] rtc number of range tombstones
+ */
+merr_t
+hbr_read_rtombs(const struct kvs_mblk_desc *hbd, struct kvs_rtomb **rtv, uint32_t *rtc);
+
 #if HSE_MOCKING
 #include "hblock_reader_ut.h"
 #endif /* HSE_MOCKING */
@@ -38,6 +38,7 @@
 #include "cn_metrics.h"
 #include "cn_perfc.h"
 #include "kvs_mblk_desc.h"
+#include "mblk_aio.h"
 
 #include <mpool/mpool.h>
 
@@ -136,8 +137,11 @@ struct curr_kblock {
     uint64_t total_key_bytes;
     uint64_t total_val_bytes;
     uint64_t total_vused_bytes;
+    uint64_t total_ttl_bytes;
     uint32_t num_keys;
     uint32_t num_tombstones;
+    uint32_t ttl_min;
+    uint32_t ttl_max;
 
     uint32_t max_size;
     uint32_t max_pgc;
@@ -173,10 +177,26 @@ available_pgc(struct curr_kblock *kblk)
  * @ds: the dataset in which kblocks will be created
  * @composite_hlog: hlog for the entire set of kblocks
  * @finished_kblks: list of finished kblocks (written, not committed)
- * @curr: the kblock currently being built
+ * @curr: the kblock currently being built (one of @kblkv)
+ * @kblkv: kblocks, @kblkv[1] is only used if writes are asynchronous
+ * @aio: mblock writer
+ * @wreq: the write request in flight
  * @finished: mark builder as finished (end of life)
  * @max_size: Maximum mblock size of all configured media classes.
+ *
+ * If the builder was given a write workqueue via kbb_set_wq() then each
+ * finished kblock is written asynchronously while keys are added to the
+ * other kblock.  At most one write is in flight, and kbb_finish() waits
+ * for it to complete.
  */
+struct kblock_wreq {
+    struct kblock_builder *bld;
+    struct curr_kblock    *kblk;
+    uint64_t               blkid;
+    struct iovec          *iov;
+    uint                   iov_cnt;
+};
+
 struct kblock_builder {
     struct mpool *             ds;
     struct cn *                cn;
@@ -186,7 +206,10 @@ struct kblock_builder {
     struct hlog *              composite_hlog;
     struct cn_merge_stats *    mstats;
     struct blk_list            finished_kblks;
-    struct curr_kblock         curr;
+    struct curr_kblock        *curr;
+    struct curr_kblock         kblkv[2];
+    struct mblk_aio            aio;
+    struct kblock_wreq         wreq;
     enum hse_mclass_policy_age agegroup;
     bool                       finished;
     uint                       pt_pgc;
@@ -486,6 +509,8 @@ kblock_init(
         return err;
     }
 
+    wbb_set_compress(kblk->wbtree, rp->cn_kblock_compress);
+
     return 0;
 }
 
@@ -498,8 +523,11 @@ kblock_reset(struct curr_kblock *kblk)
     kblk->total_key_bytes = 0;
     kblk->total_val_bytes = 0;
     kblk->total_vused_bytes = 0;
+    kblk->total_ttl_bytes = 0;
     kblk->num_keys = 0;
     kblk->num_tombstones = 0;
+    kblk->ttl_min = 0;
+    kblk->ttl_max = 0;
 
     kblk->blm_pgc = 0;
     kblk->blm_elt_cap = 0;
@@ -603,6 +631,13 @@ kblock_add_entry(
     kblk->total_vused_bytes += stats->tot_vused;
     kblk->num_tombstones += stats->ntombs;
 
+    if (stats->ttl_bytes) {
+        kblk->total_ttl_bytes += stats->ttl_bytes;
+        if (!kblk->ttl_min || stats->ttl_min < kblk->ttl_min)
+            kblk->ttl_min = stats->ttl_min;
+        kblk->ttl_max = max_t(uint32_t, kblk->ttl_max, stats->ttl_max);
+    }
+
     return 0;
 }
 
@@ -636,7 +671,7 @@ kblock_finish_bloom(struct curr_kblock *kblk, struct bloom_hdr_omf *blm_hdr)
         kblk->bloom_used_max = max_t(uint, kblk->bloom_used_max, kblk->bloom_len);
 
         memset(kblk->bloom, 0, kblk->bloom_len);
-        bf_filter_init(&bloom, kblk->desc, kblk->num_keys, kblk->bloom, kblk->bloom_len);
+        bf_filter_init_blocked(&bloom, kblk->desc, kblk->num_keys, kblk->bloom, kblk->bloom_len);
         list_for_each_entry (part, &kblk->hash_set.part_list, part_link) {
             bf_filter_insert_by_hashv(&bloom, part->hashvec, part->n_hashes);
         }
@@ -697,6 +732,9 @@ kblock_make_header(
     omf_set_kbh_val_bytes(hdr, kblk->total_val_bytes);
     omf_set_kbh_kvlen(hdr, wbb_kvlen(kblk->wbtree));
     omf_set_kbh_vused_bytes(hdr, kblk->total_vused_bytes);
+    omf_set_kbh_ttl_bytes(hdr, kblk->total_ttl_bytes);
+    omf_set_kbh_ttl_min(hdr, kblk->ttl_min);
+    omf_set_kbh_ttl_max(hdr, kblk->ttl_max);
 
     /* wbtree header is right after kblock_hdr at an 8-byte boundary */
     off += sizeof(*hdr);
@@ -778,13 +816,38 @@ kbb_estimate_alen(struct cn *cn, size_t wlen, enum hse_mclass mclass)
         KBLOCK_MAX_SIZE, zonealloc_unit, wlen, CN_MB_EST_FLAGS_TRUNCATE | CN_MB_EST_FLAGS_POW2);
 }
 
+/* Write a finished kblock to its mblock.  Called either synchronously or
+ * from the write workqueue.  The iovec is freed and the kblock is reset
+ * for reuse regardless of outcome.
+ */
+static merr_t
+kblock_write_cb(void *arg)
+{
+    struct kblock_wreq *wreq = arg;
+    merr_t              err;
+    uint                chunk;
+
+    /* Write mblock in chunks.  Chunk size must be a multiple of
+     * mblock optimal write size. Use largest chunk size less than 1 MiB.
+     */
+    chunk = 1024 * 1024;
+    err = mblk_blow_chunks(wreq->bld, wreq->blkid, wreq->iov, wreq->iov_cnt, chunk);
+
+    free(wreq->iov);
+    kblock_reset(wreq->kblk);
+
+    return err;
+}
+
 /**
  * kblock_finish() - allocate and write an mblock with kblock data
  *
  * Finalize wbtree and Bloom filter regions, allocate an appropriately sized
  * mblock, and write all kblock data to it.  Does not commit the mblock.
  *
- * This function unconditionally invokes kblock_free().
+ * This function unconditionally invokes kblock_reset().  If writes are
+ * asynchronous the write may still be in flight upon return, in which
+ * case subsequent keys are added to the builder's other kblock.
  */
 static merr_t
 kblock_finish(struct kblock_builder *bld)
@@ -794,14 +857,15 @@ kblock_finish(struct kblock_builder *bld)
     struct mblock_props       mbprop;
     struct mpool_mclass_props mc_props;
 
-    struct curr_kblock *   kblk = &bld->curr;
+    struct curr_kblock *   kblk = bld->curr;
+    struct kblock_wreq *   wreq = &bld->wreq;
     struct cn_merge_stats *stats = bld->mstats;
     struct mclass_policy * mpolicy = cn_get_mclass_policy(bld->cn);
 
     struct iovec *iov = NULL;
     uint          iov_cnt = 0;
     uint          iov_max;
-    uint          i, chunk;
+    uint          i;
     size_t        wlen;
     uint32_t      flags = 0;
 
@@ -869,7 +933,7 @@ kblock_finish(struct kblock_builder *bld)
     }
 
     /* Finalize HyperLogLog. */
-    iov[iov_cnt].iov_base = hlog_data(bld->curr.hlog);
+    iov[iov_cnt].iov_base = hlog_data(kblk->hlog);
     iov[iov_cnt].iov_len = HLOG_PGC * PAGE_SIZE;
     iov_cnt++;
 
@@ -920,24 +984,38 @@ kblock_finish(struct kblock_builder *bld)
     if (stats)
         count_ops(&stats->ms_kblk_alloc, 1, mbprop.mpr_alloc_cap, get_time_ns() - tstart);
 
-    /* Write mblock in chunks.  Chunk size must be a multiple of
-     * mblock optimal write size. Use largest chunk size less than 1 MiB.
-     */
-    chunk = 1024 * 1024;
-    err = mblk_blow_chunks(bld, blkid, iov, iov_cnt, chunk);
-    if (ev(err))
-        goto errout;
-
     err = blk_list_append(&bld->finished_kblks, blkid);
     if (ev(err))
         goto errout;
 
+    /* The mblock now belongs to finished_kblks and will be deleted
+     * by kbb_destroy() should the write fail.
+     */
+    blkid = 0;
+
     /* Add the current kblock's hlog to the composite hlog */
     hlog_union(bld->composite_hlog, hlog_data(kblk->hlog));
 
-    /* unconditional reset */
-    kblock_reset(kblk);
-    free(iov);
+    /* Wait for the previous write so that its request may be reused.
+     */
+    err = mblk_aio_wait(&bld->aio);
+    if (ev(err))
+        goto errout;
+
+    wreq->bld = bld;
+    wreq->kblk = kblk;
+    wreq->blkid = bld->finished_kblks.blks[bld->finished_kblks.n_blks - 1].bk_blkid;
+    wreq->iov = iov;
+    wreq->iov_cnt = iov_cnt;
+
+    /* kblock_write_cb() frees the iovec and resets the kblock.
+     */
+    err = mblk_aio_submit(&bld->aio, kblock_write_cb, wreq);
+    if (ev(err))
+        return err;
+
+    if (bld->kblkv[1].wbtree)
+        bld->curr = (kblk == &bld->kblkv[0]) ? &bld->kblkv[1] : &bld->kblkv[0];
 
     return 0;
 
@@ -992,10 +1070,13 @@ kbb_create(struct kblock_builder **builder_out, struct cn *cn, struct perfc_set
     if (ev(err))
         goto err_exit1;
 
-    err = kblock_init(&bld->curr, bld->cp, bld->rp, bld->pc, bld->max_size);
+    err = kblock_init(&bld->kblkv[0], bld->cp, bld->rp, bld->pc, bld->max_size);
     if (ev(err))
         goto err_exit2;
 
+    bld->curr = &bld->kblkv[0];
+    mblk_aio_init(&bld->aio, NULL);
+
     *builder_out = bld;
     return 0;
 
@@ -1014,8 +1095,14 @@ kbb_destroy(struct kblock_builder *bld)
     if (ev(!bld))
         return;
 
+    /* Wait for the in-flight write (if any) before deleting its mblock.
+     */
+    mblk_aio_fini(&bld->aio);
+
     hlog_destroy(bld->composite_hlog);
-    kblock_free(&bld->curr);
+    kblock_free(&bld->kblkv[0]);
+    if (bld->kblkv[1].wbtree)
+        kblock_free(&bld->kblkv[1]);
     delete_mblocks(bld->ds, &bld->finished_kblks);
     blk_list_free(&bld->finished_kblks);
     free(bld);
@@ -1042,11 +1129,11 @@ kbb_add_entry(
 
     hash = hse_hash64v(kobj->ko_pfx, kobj->ko_pfx_len, kobj->ko_sfx, kobj->ko_sfx_len);
 
-    err = kblock_add_entry(&bld->curr, kobj, kmd, kmd_len, stats, &added);
+    err = kblock_add_entry(bld->curr, kobj, kmd, kmd_len, stats, &added);
     if (ev(err))
         return err;
     if (added) {
-        hlog_add(bld->curr.hlog, hash);
+        hlog_add(bld->curr->hlog, hash);
         return 0;
     }
 
@@ -1057,8 +1144,8 @@ kbb_add_entry(
      *   - add key to new kblock
      *   - bug if fails with no space
      */
-    assert(!kblock_is_empty(&bld->curr));
-    if (ev(kblock_is_empty(&bld->curr)))
+    assert(!kblock_is_empty(bld->curr));
+    if (ev(kblock_is_empty(bld->curr)))
         return merr(EBUG);
 
     /* There are more keys to add, do not pass in ptree details */
@@ -1066,10 +1153,10 @@ kbb_add_entry(
     if (ev(err))
         return err;
 
-    err = kblock_add_entry(&bld->curr, kobj, kmd, kmd_len, stats, &added);
+    err = kblock_add_entry(bld->curr, kobj, kmd, kmd_len, stats, &added);
     if (ev(err))
         return err;
-    hlog_add(bld->curr.hlog, hash);
+    hlog_add(bld->curr->hlog, hash);
     assert(added);
     if (ev(!added))
         return merr(EBUG);
@@ -1094,7 +1181,7 @@ kbb_finish(struct kblock_builder *bld, struct blk_list *kblks)
     bld->finished = true;
 
     /* In the event we have no keys, return no kblocks to the caller. */
-    if (bld->curr.num_keys == 0) {
+    if (bld->curr->num_keys == 0) {
         assert(bld->finished_kblks.n_blks == 0);
 
         return 0;
@@ -1104,6 +1191,10 @@ kbb_finish(struct kblock_builder *bld, struct blk_list *kblks)
     if (ev(err))
         return err;
 
+    err = mblk_aio_wait(&bld->aio);
+    if (ev(err))
+        return err;
+
     /* Transfer ownership of blk_list and the mblocks in
      * the blk_list to caller
      */
@@ -1149,7 +1240,7 @@ kbb_set_merge_stats(struct kblock_builder *bld, struct cn_merge_stats *stats)
 bool
 kbb_is_empty(struct kblock_builder *bld)
 {
-    return kblock_is_empty(&bld->curr);
+    return kblock_is_empty(bld->curr);
 }
 
 void
@@ -1158,7 +1249,26 @@ kbb_curr_kblk_min_max_keys(
     struct key_obj        *min_kobj,
     struct key_obj        *max_kobj)
 {
-    wbb_min_max_keys(bld->curr.wbtree, min_kobj, max_kobj);
+    wbb_min_max_keys(bld->curr->wbtree, min_kobj, max_kobj);
+}
+
+void
+kbb_set_wq(struct kblock_builder *bld, struct workqueue_struct *wq)
+{
+    merr_t err;
+
+    assert(kblock_is_empty(bld->curr));
+
+    if (!wq || bld->kblkv[1].wbtree)
+        return;
+
+    err = kblock_init(&bld->kblkv[1], bld->cp, bld->rp, bld->pc, bld->kblkv[0].max_size);
+    if (ev(err)) {
+        memset(&bld->kblkv[1], 0, sizeof(bld->kblkv[1]));
+        return;
+    }
+
+    mblk_aio_set_wq(&bld->aio, wq);
 }
 
 #if HSE_MOCKING
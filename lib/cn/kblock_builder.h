@@ -20,6 +20,7 @@ struct kblock_desc;
 struct key_stats;
 struct kvs_rparams;
 struct wbti;
+struct workqueue_struct;
 
 enum hse_mclass;
 enum hse_mclass_policy_age;
@@ -116,6 +117,7 @@ kbb_finish(struct kblock_builder *bld, struct blk_list *kblks);
 size_t
 kbb_estimate_alen(struct cn *cn, size_t wlen, enum hse_mclass mclass);
 
+/* MTF_MOCK */
 const uint8_t *
 kbb_get_composite_hlog(const struct kblock_builder *bld);
 
@@ -129,12 +131,24 @@ kbb_set_merge_stats(struct kblock_builder *bld, struct cn_merge_stats *stats);
 bool
 kbb_is_empty(struct kblock_builder *bld);
 
+/* MTF_MOCK */
 void
 kbb_curr_kblk_min_max_keys(
     struct kblock_builder *bld,
     struct key_obj        *min_kobj,
     struct key_obj        *max_kobj);
 
+/**
+ * kbb_set_wq() - Issue kblock writes asynchronously
+ * @bld: kblock builder
+ * @wq:  write workqueue
+ *
+ * Must be called before the first key is added.  If the second kblock
+ * cannot be initialized the builder silently remains synchronous.
+ */
+void
+kbb_set_wq(struct kblock_builder *bld, struct workqueue_struct *wq);
+
 #if HSE_MOCKING
 #include "kblock_builder_ut.h"
 #endif /* HSE_MOCKING */
@@ -128,12 +128,17 @@ kbr_read_blm_region_desc(struct kvs_mblk_desc *kbd, struct bloom_desc *desc)
      * it's safe to run without blooms, albeit at a big hit to read perf.
      */
     version = omf_bh_version(blm_omf);
-    if (ev(version != BLOOM_OMF_VERSION)) {
+    if (ev(version != BLOOM_OMF_VERSION && version != BLOOM_OMF_VERSION5)) {
         log_err("bloom %lx invalid version %u (expected %u)",
                 mbid, version, BLOOM_OMF_VERSION);
         return 0;
     }
 
+    if (ev(version >= BLOOM_OMF_VERSION6 && omf_bh_n_hashes(blm_omf) > BF_BLK_HASHES_MAX)) {
+        log_err("bloom %lx invalid hash count %u", mbid, omf_bh_n_hashes(blm_omf));
+        return 0;
+    }
+
     desc->bd_first_page = omf_kbh_blm_doff_pg(hdr);
     desc->bd_n_pages = omf_kbh_blm_dlen_pg(hdr);
 
@@ -142,6 +147,7 @@ kbr_read_blm_region_desc(struct kvs_mblk_desc *kbd, struct bloom_desc *desc)
     desc->bd_n_hashes = omf_bh_n_hashes(blm_omf);
     desc->bd_rotl = omf_bh_rotl(blm_omf);
     desc->bd_bktmask = (1u << desc->bd_bktshift) - 1;
+    desc->bd_version = version;
 
     return 0;
 }
@@ -191,6 +197,15 @@ kbr_read_metrics(struct kvs_mblk_desc *kblkdesc, struct kblk_metrics *metrics)
     metrics->tot_wbt_pages = omf_kbh_wbt_dlen_pg(hdr);
     metrics->tot_blm_pages = omf_kbh_blm_dlen_pg(hdr);
 
+    if (omf_kbh_version(hdr) >= KBLOCK_HDR_VERSION7) {
+        metrics->tot_ttl_bytes = omf_kbh_ttl_bytes(hdr);
+        metrics->ttl_min = omf_kbh_ttl_min(hdr);
+        metrics->ttl_max = omf_kbh_ttl_max(hdr);
+    } else {
+        metrics->tot_ttl_bytes = 0;
+        metrics->ttl_min = metrics->ttl_max = 0;
+    }
+
     return 0;
 }
 
@@ -218,7 +233,7 @@ void
 kbr_madvise_kmd(struct kvs_mblk_desc *kblkdesc, struct wbt_desc *desc, int advice)
 {
     merr_t err;
-    u32    pg = desc->wbd_first_page + desc->wbd_root + 1;
+    u32    pg = wbt_kmd_pg(desc);
     u32    pg_cnt = desc->wbd_kmd_pgc;
 
     err = kbr_madvise_region(kblkdesc, pg, pg_cnt, advice);
@@ -231,7 +246,7 @@ kbr_madvise_wbt_leaf_nodes(struct kvs_mblk_desc *kblkdesc, struct wbt_desc *desc
 {
     merr_t err;
     u32    pg = desc->wbd_first_page;
-    u32    pg_cnt = desc->wbd_leaf_cnt;
+    u32    pg_cnt = wbt_leaf_region_pgc(desc);
 
     err = kbr_madvise_region(kblkdesc, pg, pg_cnt, advice);
 
@@ -242,8 +257,8 @@ void
 kbr_madvise_wbt_int_nodes(struct kvs_mblk_desc *kblkdesc, struct wbt_desc *desc, int advice)
 {
     merr_t err;
-    u32    pg = desc->wbd_first_page + desc->wbd_leaf_cnt;
-    u32    pg_cnt = (desc->wbd_n_pages - desc->wbd_leaf_cnt - desc->wbd_kmd_pgc);
+    u32    pg = desc->wbd_first_page + wbt_leaf_region_pgc(desc);
+    u32    pg_cnt = (desc->wbd_n_pages - wbt_leaf_region_pgc(desc) - desc->wbd_kmd_pgc);
 
     err = kbr_madvise_region(kblkdesc, pg, pg_cnt, advice);
 
@@ -27,6 +27,9 @@ struct kblk_metrics {
     u64 tot_vused_bytes;
     u32 tot_wbt_pages;
     u32 tot_blm_pages;
+    u64 tot_ttl_bytes;
+    u32 ttl_min;
+    u32 ttl_max;
 };
 
 struct kblock_desc {
@@ -7,12 +7,16 @@
 
 #include <hse_util/platform.h>
 #include <hse_util/event_counter.h>
+#include <hse_util/minmax.h>
 #include <hse/logging/logging.h>
 
 #include <hse_ikvdb/kvs_rparams.h>
 #include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/kvset_builder.h>
+#include <hse_ikvdb/kvs_merge.h>
+#include <hse_ikvdb/kvs_rtomb.h>
+#include <hse_ikvdb/cn.h>
 
 #include "kcompact.h"
 
@@ -37,6 +41,31 @@ kv_item_compare(const void *a, const void *b)
     return key_obj_cmp(&item_a->kobj, &item_b->kobj);
 }
 
+/* Emit the accumulated merge operand (or the value to which it was resolved)
+ * and mark the accumulator consumed.
+ */
+static merr_t
+kcompact_merge_emit(
+    struct cn_compaction_work *w,
+    struct kvset_builder      *bldr,
+    struct kvs_merge          *km,
+    const struct key_obj      *kobj)
+{
+    merr_t err;
+
+    if (km->km_opnd)
+        err = kvset_builder_add_mval(bldr, km->km_seq, km->km_buf, km->km_len);
+    else
+        err = kvset_builder_add_val(bldr, kobj, km->km_buf, km->km_len, km->km_seq, 0);
+
+    if (!err)
+        w->cw_stats.ms_val_bytes_out += km->km_len;
+
+    km->km_active = false;
+
+    return err;
+}
+
 /**
  * kcompact() - merge key-value streams in a single output stream
  * Requirements:
@@ -62,6 +91,7 @@ kcompact(struct cn_compaction_work *w, struct kvset_builder *bldr)
 
     bool pt_set = false;
     u64  pt_seq = 0;
+    u64  rt_seq = 0;
     u64  tprog = 0;
 
     u64 dbg_prev_seq HSE_MAYBE_UNUSED;
@@ -71,6 +101,13 @@ kcompact(struct cn_compaction_work *w, struct kvset_builder *bldr)
 
     uint seqno_errcnt = 0;
 
+    const struct kvs_merge_op *mop;
+    struct kvs_merge km = { 0 };
+    struct kvs_rtomb_vec rtombs = { 0 };
+    struct cn_compact_filter_ctx cfilter = { 0 };
+    uint *idxv = NULL;
+    uint vmax;
+
     /* 'vbm_used' counts only the values referenced after this compaction;
      * however, waste accumulates from compact-to-compact
      */
@@ -79,37 +116,67 @@ kcompact(struct cn_compaction_work *w, struct kvset_builder *bldr)
     if (w->cw_prog_interval && w->cw_progress)
         tprog = jiffies;
 
+    /* Vblocks are not rewritten by k-compaction, so merge operands can be
+     * folded only into values that are stored in the kblock.
+     */
+    vmax = min_t(uint, w->cw_cp->vinline_len, CN_INLINE_VALUE_LEN_MAX);
+
+    mop = cn_get_merge_op(cn_tree_get_cn(w->cw_tree));
+    if (mop) {
+        err = kvs_merge_init(&km);
+        if (ev(err))
+            return err;
+    }
+
+    /* For the same reason, the compaction filter is offered only values
+     * stored in the kblock and its replacements must fit in the kblock.
+     */
+    err = cn_compact_filter_init(w, &cfilter, vmax);
+    if (ev(err))
+        goto done;
+
     err = bin_heap_create(w->cw_kvset_cnt, kv_item_compare, &bh);
     if (ev(err))
-        return err;
+        goto done;
 
-    sources = malloc(w->cw_kvset_cnt * sizeof(*sources));
+    sources = malloc(w->cw_kvset_cnt * (sizeof(*sources) + sizeof(*idxv)));
     if (!sources) {
         err = merr(ENOMEM);
         goto done;
     }
 
+    idxv = (void *)(sources + w->cw_kvset_cnt);
+
     for (uint i = 0; i < w->cw_kvset_cnt; i++) {
         struct kv_iterator *iter = w->cw_inputv[i];
 
         sources[i] = kvset_iter_es_get(iter);
+        sources[i]->es_sort = -1;
     }
 
+    err = cn_compact_rtombs(w, &rtombs);
+    if (ev(err))
+        goto done;
+
     err = bin_heap_prepare(bh, w->cw_kvset_cnt, sources);
     if (ev(err))
         goto done;
-    /* In the event this assert fails, at least one iterator is EOF and the idea
-     * that struct element_source::es_sort will properly index the vblock map is
-     * incorrect. Kvsets won't typically exist if they have no prefix tombstones
-     * or keys.
+
+    /* A kvset that holds only range tombstones has no keys, so its iterator
+     * is at EOF and bin_heap_prepare() skips it when assigning es_sort.  Map
+     * es_sort back to the input index so that it properly indexes the vblock
+     * map.
      */
-    assert(bin_heap_width(bh) == w->cw_kvset_cnt);
+    for (uint i = 0; i < w->cw_kvset_cnt; i++) {
+        if (sources[i]->es_sort >= 0)
+            idxv[sources[i]->es_sort] = i;
+    }
 
     w->cw_stats.ms_srcs = w->cw_kvset_cnt;
 
     more = bin_heap_peek(bh, (void **)&curr);
     while (more) {
-        uint idx = curr->src->es_sort;
+        uint idx = idxv[curr->src->es_sort];
         struct kv_iterator *iter = kvset_cursor_es_h2r(curr->src);
 
         if (atomic_read(w->cw_cancel_request)) {
@@ -131,6 +198,9 @@ kcompact(struct cn_compaction_work *w, struct kvset_builder *bldr)
         emitted_seq = 0;
         emitted_seq_pt = 0;
 
+        if (rtombs.krv_cnt > 0)
+            rt_seq = kvs_rtomb_seq(rtombs.krv_rtv, rtombs.krv_cnt, &curr->kobj, w->cw_horizon);
+
         dbg_prev_seq = 0;
         dbg_prev_idx = 0;
         dbg_nvals_this_key = 0;
@@ -141,9 +211,19 @@ kcompact(struct cn_compaction_work *w, struct kvset_builder *bldr)
         w->cw_stats.ms_keys_in++;
         w->cw_stats.ms_key_bytes_in += key_obj_len(&curr->kobj);
 
-        while (horizon && kvset_iter_next_vref(iter, &curr->vctx, &seq, &vtype, &vbidx, &vboff,
-                &vdata, &vlen, &complen)) {
+        while ((horizon || km.km_active) && kvset_iter_next_vref(iter, &curr->vctx, &seq, &vtype,
+                &vbidx, &vboff, &vdata, &vlen, &complen)) {
             bool should_emit = false;
+            bool bg_first;
+            u32  expire = curr->vctx.expire;
+
+            /* An expired value is compacted as a tombstone.
+             */
+            if (kvs_expired(expire)) {
+                vtype = VTYPE_TOMB;
+                vdata = HSE_CORE_TOMB_REG;
+                vlen = complen = expire = 0;
+            }
 
             /* Assertion logic:
              *   if (dbg_nvals_this_key)
@@ -157,11 +237,54 @@ kcompact(struct cn_compaction_work *w, struct kvset_builder *bldr)
             dbg_nvals_this_key++;
             dbg_prev_seq = seq;
 
+            bg_first = horizon && seq <= w->cw_horizon;
+
+            if (km.km_active) {
+                bool hidden = (pt_set && seq < pt_seq) || rt_seq > seq;
+
+                /* Fold older values of this key into the pending operand.  Whenever
+                 * the operator declines, the operand is emitted as-is and this value
+                 * is handled as though no folding had occurred.
+                 */
+                if (seq >= emitted_seq)
+                    continue; /* dup from an overlapping kvset */
+
+                if (vtype == VTYPE_MVAL && !hidden) {
+                    if (!kvs_merge_fold(&km, vdata, vlen, HSE_KVS_MERGE_OPERAND_LEN_MAX)) {
+                        emitted_seq = seq;
+                        continue;
+                    }
+
+                    err = kcompact_merge_emit(w, bldr, &km, &curr->kobj);
+                    if (ev(err))
+                        goto done;
+
+                    kvs_merge_start(&km, mop, &curr->kobj, vdata, vlen, seq);
+                    emitted_seq = seq;
+                    continue;
+                }
+
+                if (hidden || vtype == VTYPE_TOMB || vtype == VTYPE_PTOMB)
+                    kvs_merge_resolve(&km, NULL, 0, vmax);
+                else if (vtype == VTYPE_ZVAL || vtype == VTYPE_IVAL || vtype == VTYPE_LIVAL)
+                    kvs_merge_resolve(&km, vdata, vlen, vmax);
+
+                err = kcompact_merge_emit(w, bldr, &km, &curr->kobj);
+                if (ev(err))
+                    goto done;
+
+                if (!km.km_opnd || hidden)
+                    break; /* resolved, older values are obsolete */
+            }
+
             if (seq <= w->cw_horizon) {
                 horizon = false;
                 if (pt_set && seq < pt_seq)
                     continue; /* skip value */
 
+                if (rt_seq > seq)
+                    continue; /* skip value hidden by a range tombstone */
+
                 if (vtype == VTYPE_PTOMB) {
                     pt_set = true;
                     pt_kobj = curr->kobj;
@@ -185,6 +308,28 @@ kcompact(struct cn_compaction_work *w, struct kvset_builder *bldr)
              * value from the first kvset is emitted.
              */
             if (should_emit) {
+                if (cfilter.cfc_filter && bg_first &&
+                    (vtype == VTYPE_ZVAL || vtype == VTYPE_IVAL ||
+                     vtype == VTYPE_LIVAL || vtype == VTYPE_CIVAL)) {
+                    bool drop;
+
+                    err = cn_compact_filter(&cfilter, &curr->kobj, seq, &vdata, &vlen, &complen,
+                                            &drop);
+                    if (ev(err))
+                        goto done;
+
+                    if (drop) {
+                        if (w->cw_drop_tombs)
+                            continue; /* skip value */
+
+                        vtype = VTYPE_TOMB;
+                        vlen = complen = expire = 0;
+                    }
+                }
+
+                if (expire)
+                    kvset_builder_set_expire(bldr, expire);
+
                 switch (vtype) {
                 case VTYPE_UCVAL:
                 case VTYPE_CVAL:
@@ -193,7 +338,19 @@ kcompact(struct cn_compaction_work *w, struct kvset_builder *bldr)
                     break;
                 case VTYPE_ZVAL:
                 case VTYPE_IVAL:
-                    err = kvset_builder_add_val(bldr, &curr->kobj, vdata, vlen, seq, 0);
+                case VTYPE_LIVAL:
+                case VTYPE_CIVAL:
+                    err = kvset_builder_add_val(bldr, &curr->kobj, vdata, vlen, seq, complen);
+                    break;
+                case VTYPE_MVAL:
+                    if (mop && !horizon) {
+                        kvs_merge_start(&km, mop, &curr->kobj, vdata, vlen, seq);
+                        emitted_val = true;
+                        emitted_seq = seq;
+                        continue;
+                    }
+
+                    err = kvset_builder_add_mval(bldr, seq, vdata, vlen);
                     break;
                 default:
                     err = kvset_builder_add_nonval(bldr, seq, vtype);
@@ -257,7 +414,7 @@ kcompact(struct cn_compaction_work *w, struct kvset_builder *bldr)
         more = bin_heap_peek(bh, (void **)&curr);
         if (more) {
             iter = kvset_cursor_es_h2r(curr->src);
-            idx = curr->src->es_sort;
+            idx = idxv[curr->src->es_sort];
 
             if (key_obj_cmp(&curr->kobj, &prev_kobj) == 0) {
                 dbg_dup = true;
@@ -269,6 +426,17 @@ kcompact(struct cn_compaction_work *w, struct kvset_builder *bldr)
                 pt_set = false;
         }
 
+        if (km.km_active) {
+            /* Operands that reach the bottom of the tree have no base value.
+             */
+            if (w->cw_drop_tombs)
+                kvs_merge_resolve(&km, NULL, 0, vmax);
+
+            err = kcompact_merge_emit(w, bldr, &km, &prev_kobj);
+            if (ev(err))
+                goto done;
+        }
+
         if (emitted_val) {
             err = kvset_builder_add_key(bldr, &prev_kobj);
             if (ev(err))
@@ -278,8 +446,13 @@ kcompact(struct cn_compaction_work *w, struct kvset_builder *bldr)
         }
     }
 
+    err = cn_compact_rtombs_emit(w, &rtombs, bldr);
+
 done:
     w->cw_vbmap.vbm_waste = w->cw_vbmap.vbm_tot - w->cw_vbmap.vbm_used;
+    cn_compact_filter_fini(&cfilter);
+    kvs_rtomb_vec_fini(&rtombs);
+    kvs_merge_fini(&km);
     bin_heap_destroy(bh);
     free(sources);
 
@@ -310,6 +483,7 @@ cn_kcompact(struct cn_compaction_work *w)
 
     kvset_builder_set_agegroup(bldr, HSE_MPOLICY_AGE_LEAF);
     kvset_builder_set_merge_stats(bldr, &w->cw_stats);
+    kvset_builder_set_wq(bldr, cn_get_wr_wq(cn_tree_get_cn(w->cw_tree)));
 
     err = kcompact(w, bldr);
     if (ev(err))
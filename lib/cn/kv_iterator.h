@@ -36,6 +36,7 @@ struct kvset_iter_vctx {
     size_t      off;
     uint        nvals;
     uint        next;
+    uint32_t    expire;
     bool        is_ptomb;
 };
 
@@ -8,6 +8,9 @@
 #include <hse_util/slab.h>
 #include <hse_util/page.h>
 #include <hse_util/event_counter.h>
+#include <hse_util/compression_zstd.h>
+#include <hse_util/condvar.h>
+#include <hse_util/mutex.h>
 #include <hse/logging/logging.h>
 
 #include <hse_ikvdb/kvs_cparams.h>
@@ -16,8 +19,11 @@
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/kvset_builder.h>
 #include <hse_ikvdb/kvdb_perfc.h>
+#include <hse_ikvdb/kvs_merge.h>
+#include <hse_ikvdb/kvs_rtomb.h>
 #include <hse_ikvdb/cndb.h>
 #include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/vcomp_params.h>
 
 #include "kvcompact.h"
 
@@ -28,7 +34,218 @@
 #include "cn_metrics.h"
 #include "kv_iterator.h"
 #include "blk_list.h"
+#include "node_split.h"
 #include "route.h"
+#include "omf.h"
+
+/* Dictionary training parameters: Sample values until either limit is
+ * reached.  zstd recommends about 100x as many sample bytes as the size
+ * of the dictionary.
+ */
+#define VDICT_SAMPLE_BYTES_MAX  (100 * VBLOCK_DICT_LEN_MAX)
+#define VDICT_SAMPLE_CNT_MAX    (64 * 1024)
+
+/**
+ * struct kvcompact_vdict - value compression dictionary state
+ * @vd_dict:     digested dictionary, NULL until trained
+ * @vd_failed:   training failed, do not retry
+ * @vd_samplec:  number of sampled values
+ * @vd_sampleb:  total length of sampled values
+ * @vd_samplev:  vector of sample lengths
+ * @vd_samples:  concatenated sample values
+ * @vd_ubuf:     buffer for an uncompressed value
+ * @vd_cbuf:     buffer for a compressed value
+ *
+ * When compression.algorithm is zstd-dict, kv-compaction of a leaf node
+ * samples the first values it reads, trains a dictionary from them, stores
+ * the dictionary in each output vblock and compresses all values that are
+ * no larger than VCOMP_DICT_VLEN_MAX with it.  Values emitted before the
+ * dictionary is trained are compressed with plain zstd.
+ */
+struct kvcompact_vdict {
+    struct compress_dict *vd_dict;
+    bool                  vd_failed;
+    uint                  vd_samplec;
+    size_t                vd_sampleb;
+    size_t               *vd_samplev;
+    char                 *vd_samples;
+    char                  vd_ubuf[VCOMP_DICT_VLEN_MAX];
+    char                  vd_cbuf[VCOMP_DICT_VLEN_MAX];
+};
+
+#ifdef HAVE_ZSTD
+
+static void
+vdict_destroy(struct kvcompact_vdict *vd)
+{
+    if (!vd)
+        return;
+
+    compress_zstd_dict_destroy(vd->vd_dict);
+    free(vd->vd_samplev);
+    free(vd->vd_samples);
+    free(vd);
+}
+
+static merr_t
+vdict_create(struct cn_compaction_work *w, struct kvset_builder *bldr, struct kvcompact_vdict **vdp)
+{
+    struct kvcompact_vdict *vd;
+    merr_t err;
+
+    *vdp = NULL;
+
+    if (w->cw_rp->compression.algorithm != VCOMP_ALGO_ZSTD_DICT || cn_node_isroot(w->cw_node))
+        return 0;
+
+    vd = calloc(1, sizeof(*vd));
+    if (ev(!vd))
+        return merr(ENOMEM);
+
+    vd->vd_samplev = malloc(VDICT_SAMPLE_CNT_MAX * sizeof(*vd->vd_samplev));
+    vd->vd_samples = malloc(VDICT_SAMPLE_BYTES_MAX);
+    if (ev(!vd->vd_samplev || !vd->vd_samples)) {
+        vdict_destroy(vd);
+        return merr(ENOMEM);
+    }
+
+    err = kvset_builder_set_vdict(bldr, NULL, 0);
+    if (ev(err)) {
+        vdict_destroy(vd);
+        return err;
+    }
+
+    *vdp = vd;
+
+    return 0;
+}
+
+static merr_t
+vdict_train(struct kvcompact_vdict *vd, struct kvset_builder *bldr)
+{
+    char  *dict;
+    uint   dictlen;
+    merr_t err;
+
+    vd->vd_failed = true;
+
+    /* Reuse the tail of the sample buffer for the dictionary.
+     */
+    if (vd->vd_sampleb + VBLOCK_DICT_LEN_MAX > VDICT_SAMPLE_BYTES_MAX)
+        return 0;
+
+    dict = vd->vd_samples + VDICT_SAMPLE_BYTES_MAX - VBLOCK_DICT_LEN_MAX;
+
+    err = compress_zstd_dict_train(vd->vd_samples, vd->vd_samplev, vd->vd_samplec,
+                                   dict, VBLOCK_DICT_LEN_MAX, &dictlen);
+    if (err)
+        return merr_errno(err) == ENODATA ? 0 : err;
+
+    err = compress_zstd_dict_create(dict, dictlen, true, &vd->vd_dict);
+    if (ev(err))
+        return err;
+
+    err = kvset_builder_set_vdict(bldr, dict, dictlen);
+    if (ev(err)) {
+        compress_zstd_dict_destroy(vd->vd_dict);
+        vd->vd_dict = NULL;
+        return err;
+    }
+
+    vd->vd_failed = false;
+
+    return 0;
+}
+
+/* Sample or compress a value with the dictionary.  On return, *vdata
+ * and *complen describe the value as it should be written.
+ */
+static merr_t
+vdict_apply(
+    struct kvcompact_vdict *vd,
+    struct kvset_builder   *bldr,
+    const void            **vdata,
+    uint                    vlen,
+    uint                   *complen)
+{
+    const void *uval = *vdata;
+    uint        clen;
+    merr_t      err;
+
+    if (vlen == 0 || vlen > VCOMP_DICT_VLEN_MAX || HSE_CORE_IS_TOMB(*vdata))
+        return 0;
+
+    if (*complen) {
+        uint outlen;
+
+        err = vcomp_decompress(*vdata, *complen, NULL, vd->vd_ubuf, vlen, &outlen);
+        if (ev(err))
+            return err;
+
+        if (ev(outlen != vlen))
+            return merr(EBUG);
+
+        uval = vd->vd_ubuf;
+    }
+
+    if (!vd->vd_dict && !vd->vd_failed) {
+        memcpy(vd->vd_samples + vd->vd_sampleb, uval, vlen);
+        vd->vd_samplev[vd->vd_samplec++] = vlen;
+        vd->vd_sampleb += vlen;
+
+        if (vd->vd_samplec >= VDICT_SAMPLE_CNT_MAX ||
+            vd->vd_sampleb + VCOMP_DICT_VLEN_MAX + VBLOCK_DICT_LEN_MAX > VDICT_SAMPLE_BYTES_MAX) {
+
+            err = vdict_train(vd, bldr);
+            if (ev(err))
+                return err;
+        }
+    }
+
+    if (vd->vd_dict)
+        err = compress_zstd_dict_compress(vd->vd_dict, uval, vlen,
+                                          vd->vd_cbuf, sizeof(vd->vd_cbuf), &clen);
+    else if (*complen == 0)
+        err = compress_zstd_ops.cop_compress(uval, vlen, vd->vd_cbuf, sizeof(vd->vd_cbuf), &clen);
+    else
+        return 0;
+
+    /* Leave the value as is if it's incompressible.
+     */
+    if (!err && clen < vlen && (!*complen || clen < *complen)) {
+        *vdata = vd->vd_cbuf;
+        *complen = clen;
+    }
+
+    return 0;
+}
+
+#else
+
+static void
+vdict_destroy(struct kvcompact_vdict *vd)
+{
+}
+
+static merr_t
+vdict_create(struct cn_compaction_work *w, struct kvset_builder *bldr, struct kvcompact_vdict **vdp)
+{
+    *vdp = NULL;
+    return 0;
+}
+
+static merr_t
+vdict_apply(
+    struct kvcompact_vdict *vd,
+    struct kvset_builder   *bldr,
+    const void            **vdata,
+    uint                    vlen,
+    uint                   *complen)
+{
+    return 0;
+}
+
+#endif /* HAVE_ZSTD */
 
 static int
 kv_item_compare(const void *a, const void *b)
@@ -84,12 +301,105 @@ get_direct_read_buf(uint len, bool aligned_voff, u32 *bufsz, void **buf)
     return 0;
 }
 
-merr_t
-cn_kvcompact(struct cn_compaction_work *w)
+/* Emit the accumulated merge operand (or the value to which it was resolved)
+ * and mark the accumulator consumed.
+ */
+static merr_t
+kvcompact_merge_emit(
+    struct cn_merge_stats *stats,
+    struct kvset_builder  *bldr,
+    struct kvs_merge      *km,
+    const struct key_obj  *kobj)
+{
+    merr_t err;
+
+    if (km->km_opnd)
+        err = kvset_builder_add_mval(bldr, km->km_seq, km->km_buf, km->km_len);
+    else
+        err = kvset_builder_add_val(bldr, kobj, km->km_buf, km->km_len, km->km_seq, 0);
+
+    if (!err)
+        stats->ms_val_bytes_out += km->km_len;
+
+    km->km_active = false;
+
+    return err;
+}
+
+/**
+ * struct kvcompact_wait - completion of the ranges of a parallel kv-compaction
+ * @kw_lock:     protects %kw_inflight
+ * @kw_cv:       signaled when %kw_inflight drops to zero
+ * @kw_inflight: count of ranges yet to finish
+ */
+struct kvcompact_wait {
+    struct mutex kw_lock;
+    struct cv    kw_cv;
+    uint         kw_inflight;
+};
+
+/**
+ * struct kvcompact_range - a key range of a kv-compaction
+ * @kr_work:      for running the range on a workqueue
+ * @kr_w:         compaction work
+ * @kr_inputv:    input iterators, positioned at the start of the range
+ * @kr_bldr:      output kvset builder
+ * @kr_stats:     merge stats of the range
+ * @kr_start:     start of the range (inclusive), NULL if unbounded
+ * @kr_startlen:  length of %kr_start
+ * @kr_end:       end of the range (exclusive), NULL if unbounded
+ * @kr_endlen:    length of %kr_end
+ * @kr_rtombs:    emit the range tombstones of the inputs into %kr_bldr
+ * @kr_err:       status of the range
+ * @kr_wait:      completion of the parallel ranges (NULL if run by the caller)
+ * @kr_mstats:    storage for %kr_stats of a parallel range
+ *
+ * A kv-compaction is either run as a single unbounded range, or split into
+ * disjoint ranges that are merged in parallel into separate kvset builders
+ * and then concatenated into one kvset (see kvcompact_parallel()).
+ */
+struct kvcompact_range {
+    struct work_struct         kr_work;
+    struct cn_compaction_work *kr_w;
+    struct kv_iterator       **kr_inputv;
+    struct kvset_builder      *kr_bldr;
+    struct cn_merge_stats     *kr_stats;
+    const void                *kr_start;
+    uint                       kr_startlen;
+    const void                *kr_end;
+    uint                       kr_endlen;
+    bool                       kr_rtombs;
+    merr_t                     kr_err;
+    struct kvcompact_wait     *kr_wait;
+    struct cn_merge_stats      kr_mstats;
+};
+
+/* Peek at the next key of the merge, stopping at the end of the range.
+ */
+static bool
+kvcompact_peek(struct bin_heap *bh, const struct key_obj *end, struct cn_kv_item **curr)
+{
+    if (!bin_heap_peek(bh, (void **)curr))
+        return false;
+
+    if (end && key_obj_cmp(&(*curr)->kobj, end) >= 0) {
+        *curr = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+/* Merge the input kvsets of a key range into the range's kvset builder.
+ */
+static merr_t
+kvcompact_range(struct kvcompact_range *kr)
 {
+    struct cn_compaction_work *w = kr->kr_w;
+    struct cn_merge_stats *stats = kr->kr_stats;
+    struct kvset_builder *bldr = kr->kr_bldr;
     struct bin_heap *bh = 0;
-    struct kvset_builder *bldr = NULL;
-    struct key_obj prev_kobj = { 0 };
+    struct key_obj prev_kobj = { 0 }, end_kobj;
 
     uint vlen, complen, omlen, direct_read_len;
     uint curr_klen HSE_MAYBE_UNUSED;
@@ -98,11 +408,12 @@ cn_kvcompact(struct cn_compaction_work *w)
     merr_t err;
 
     u64  seq, emitted_seq = 0, emitted_seq_pt = 0;
-    bool emitted_val = false, bg_val = false;
+    bool emitted_val = false, bg_val = false, bg_first;
 
     struct key_obj pt_kobj = {0};
     u64 pt_seq = 0;
     bool pt_set = false;
+    u64 rt_seq = 0;
 
     u64  tstart, tprog = 0;
     u64  dbg_prev_seq = 0;
@@ -114,9 +425,11 @@ cn_kvcompact(struct cn_compaction_work *w)
     bool more;
     struct cn_kv_item *curr = NULL;
     struct element_source **bh_sources;
-
-    assert(w->cw_kvset_cnt);
-    assert(w->cw_inputv);
+    struct kvcompact_vdict *vdict = NULL;
+    const struct kvs_merge_op *mop;
+    struct kvs_merge km = { 0 };
+    struct kvs_rtomb_vec rtombs = { 0 };
+    struct cn_compact_filter_ctx cfilter = { 0 };
 
     bh_sources = malloc(w->cw_kvset_cnt * sizeof(*bh_sources));
     if (!bh_sources)
@@ -126,9 +439,14 @@ cn_kvcompact(struct cn_compaction_work *w)
     if (err)
         goto out;
 
-    if (w->cw_prog_interval && w->cw_progress)
+    /* Ranges that run on a workqueue leave progress reports to their caller.
+     */
+    if (w->cw_prog_interval && w->cw_progress && !kr->kr_wait)
         tprog = jiffies;
 
+    if (kr->kr_end)
+        key2kobj(&end_kobj, kr->kr_end, kr->kr_endlen);
+
     /* We must issue a direct read for all values that will not fit into the vblock readahead
      * buffer.  Since all direct reads require page size alignment any value whose length is
      * greater than the buffer size minus one page must be read directly from disk (vs from the
@@ -137,33 +455,63 @@ cn_kvcompact(struct cn_compaction_work *w)
     direct_read_len = w->cw_rp->cn_compact_vblk_ra;
     direct_read_len -= PAGE_SIZE;
 
-    w->cw_kvsetidv[0] = cndb_kvsetid_mint(cn_tree_get_cndb(w->cw_tree));
+    /* Values compressed with a dictionary are never large enough to be read
+     * directly, so they're always decompressed by kvset_iter_val_get().
+     */
+    assert(VCOMP_DICT_VLEN_MAX < direct_read_len);
 
-    err = kvset_builder_create(&bldr, cn_tree_get_cn(w->cw_tree), w->cw_pc, w->cw_kvsetidv[0]);
+    err = vdict_create(w, bldr, &vdict);
     if (err)
         goto out;
 
-    kvset_builder_set_merge_stats(bldr, &w->cw_stats);
-    kvset_builder_set_agegroup(bldr, HSE_MPOLICY_AGE_LEAF);
+    err = cn_compact_filter_init(w, &cfilter, HSE_KVS_VALUE_LEN_MAX);
+    if (err)
+        goto out;
+
+    /* Merge operands below the horizon are folded only if an operator is
+     * registered, otherwise they are carried forward as-is.
+     */
+    mop = cn_get_merge_op(cn_tree_get_cn(w->cw_tree));
+    if (mop) {
+        err = kvs_merge_init(&km);
+        if (err)
+            goto out;
+    }
 
     new_key = true;
 
     tstart = perfc_ison(w->cw_pc, PERFC_DI_CNCOMP_VGET) ? 1 : 0;
 
     for (uint i = 0; i < w->cw_kvset_cnt; i++) {
-        struct kv_iterator *iter = w->cw_inputv[i];
+        struct kv_iterator *iter = kr->kr_inputv[i];
 
         bh_sources[i] = kvset_iter_es_get(iter);
     }
 
+    err = cn_compact_rtombs(w, &rtombs);
+    if (err)
+        goto out;
+
     err = bin_heap_prepare(bh, w->cw_kvset_cnt, bh_sources);
     if (err)
         goto out;
 
-    more = bin_heap_peek(bh, (void **)&curr);
+    /* A seek positions the inputs at the wbt leaf node containing the start
+     * of the range, so skip the keys that precede it.
+     */
+    if (kr->kr_start) {
+        struct key_obj start_kobj;
+
+        key2kobj(&start_kobj, kr->kr_start, kr->kr_startlen);
+
+        while (bin_heap_peek(bh, (void **)&curr) && key_obj_cmp(&curr->kobj, &start_kobj) < 0)
+            bin_heap_pop(bh, NULL);
+    }
+
+    more = kvcompact_peek(bh, kr->kr_end ? &end_kobj : NULL, &curr);
     if (curr) {
-        w->cw_stats.ms_keys_in++;
-        w->cw_stats.ms_key_bytes_in += key_obj_len(&curr->kobj);
+        stats->ms_keys_in++;
+        stats->ms_key_bytes_in += key_obj_len(&curr->kobj);
     }
 
     while (more) {
@@ -179,18 +527,22 @@ cn_kvcompact(struct cn_compaction_work *w)
             emitted_seq = 0;
             emitted_seq_pt = 0;
 
+            if (rtombs.krv_cnt > 0)
+                rt_seq = kvs_rtomb_seq(rtombs.krv_rtv, rtombs.krv_cnt, &curr->kobj, w->cw_horizon);
+
             dbg_prev_seq = 0;
             dbg_prev_idx = 0;
             dbg_nvals_this_key = 0;
             dbg_dup = false;
         }
 
-        while (!bg_val) {
+        while (!bg_val || km.km_active) {
             const void *   vdata = NULL;
             bool           should_emit = false;
             enum kmd_vtype vtype;
             u32            vbidx;
             u32            vboff;
+            u32            expire;
             bool           direct;
 
             if (tstart > 0)
@@ -200,6 +552,15 @@ cn_kvcompact(struct cn_compaction_work *w)
                                       &vboff, &vdata, &vlen, &complen))
                 break;
 
+            /* An expired value is compacted as a tombstone, which is dropped
+             * along with the other tombstones once it's below the horizon.
+             */
+            expire = curr->vctx.expire;
+            if (kvs_expired(expire)) {
+                vtype = VTYPE_TOMB;
+                vlen = complen = expire = 0;
+            }
+
             omlen = (vtype == VTYPE_UCVAL) ? vlen : ((vtype == VTYPE_CVAL) ? complen : 0);
 
             direct = omlen > direct_read_len;
@@ -210,6 +571,7 @@ cn_kvcompact(struct cn_compaction_work *w)
 
                 err = kvset_iter_next_val_direct(iter, vtype, vbidx, vboff, buf, omlen, bufsz);
                 vdata = buf;
+                assert(err || !complen || !vcomp_dict_tagged(vdata));
             } else {
                 err = kvset_iter_val_get(iter, &curr->vctx, vtype, vbidx,
                                           vboff, &vdata, &vlen, &complen);
@@ -233,11 +595,53 @@ cn_kvcompact(struct cn_compaction_work *w)
             dbg_nvals_this_key++;
             dbg_prev_seq = seq;
 
+            bg_first = !bg_val && seq <= w->cw_horizon;
             bg_val = (seq <= w->cw_horizon);
 
+            if (km.km_active) {
+                bool hidden = (pt_set && w->cw_horizon >= pt_seq && pt_seq > seq) || rt_seq > seq;
+
+                /* Fold older values of this key into the pending operand.  Whenever
+                 * the operator declines, the operand is emitted as-is and this value
+                 * is handled as though no folding had occurred.
+                 */
+                if (seq >= emitted_seq)
+                    continue; /* dup from an overlapping kvset */
+
+                if (vtype == VTYPE_MVAL && !hidden) {
+                    if (!kvs_merge_fold(&km, vdata, vlen, HSE_KVS_MERGE_OPERAND_LEN_MAX)) {
+                        emitted_seq = seq;
+                        continue;
+                    }
+
+                    err = kvcompact_merge_emit(stats, bldr, &km, &curr->kobj);
+                    if (err)
+                        break;
+
+                    kvs_merge_start(&km, mop, &curr->kobj, vdata, vlen, seq);
+                    emitted_seq = seq;
+                    continue;
+                }
+
+                if (hidden || HSE_CORE_IS_TOMB(vdata))
+                    kvs_merge_resolve(&km, NULL, 0, HSE_KVS_VALUE_LEN_MAX);
+                else if (!complen && !expire)
+                    kvs_merge_resolve(&km, vdata, vlen, HSE_KVS_VALUE_LEN_MAX);
+
+                err = kvcompact_merge_emit(stats, bldr, &km, &curr->kobj);
+                if (err)
+                    break;
+
+                if (!km.km_opnd || hidden)
+                    break; /* resolved, older values are obsolete */
+            }
+
             if (bg_val && pt_set && w->cw_horizon >= pt_seq && pt_seq > seq)
                 break; /* drop val if it and pt are beyond horizon */
 
+            if (bg_val && rt_seq > seq)
+                break; /* drop val hidden by a range tombstone beyond horizon */
+
             /* Set ptomb context irrespective of bg_val for tombstone propagation */
             if (HSE_CORE_IS_PTOMB(vdata)) {
                 pt_set = true;
@@ -259,11 +663,58 @@ cn_kvcompact(struct cn_compaction_work *w)
                 if (w->cw_drop_tombs && HSE_CORE_IS_TOMB(vdata) && bg_val)
                     continue; /* skip value */
 
+                if (vtype == VTYPE_MVAL) {
+                    if (mop && bg_val && !HSE_CORE_IS_PTOMB(vdata)) {
+                        kvs_merge_start(&km, mop, &curr->kobj, vdata, vlen, seq);
+                        emitted_val = true;
+                        emitted_seq = seq;
+                        continue;
+                    }
+
+                    err = kvset_builder_add_mval(bldr, seq, vdata, vlen);
+                    if (err)
+                        break;
+
+                    stats->ms_val_bytes_out += vlen;
+                    emitted_val = true;
+                    emitted_seq = seq;
+                    continue;
+                }
+
+                /* The newest value at or below the horizon is offered to the
+                 * compaction filter, which may delete the key or replace it.
+                 */
+                if (cfilter.cfc_filter && bg_first && !HSE_CORE_IS_TOMB(vdata)) {
+                    bool drop;
+
+                    err = cn_compact_filter(&cfilter, &curr->kobj, seq, &vdata, &vlen, &complen,
+                                            &drop);
+                    if (err)
+                        break;
+
+                    if (drop) {
+                        if (w->cw_drop_tombs)
+                            continue; /* skip value */
+
+                        vdata = HSE_CORE_TOMB_REG;
+                        vlen = complen = expire = 0;
+                    }
+                }
+
+                if (vdict) {
+                    err = vdict_apply(vdict, bldr, &vdata, vlen, &complen);
+                    if (err)
+                        break;
+                }
+
+                if (expire)
+                    kvset_builder_set_expire(bldr, expire);
+
                 err = kvset_builder_add_val(bldr, &curr->kobj, vdata, vlen, seq, complen);
                 if (err)
                     break;
 
-                w->cw_stats.ms_val_bytes_out += complen ? complen : vlen;
+                stats->ms_val_bytes_out += complen ? complen : vlen;
                 emitted_val = true;
                 if (HSE_CORE_IS_PTOMB(vdata))
                     emitted_seq_pt = seq;
@@ -303,11 +754,11 @@ cn_kvcompact(struct cn_compaction_work *w)
          * occur, but only grab the next value after pop() calls heapify().
          */
         bin_heap_pop(bh, NULL);
-        more = bin_heap_peek(bh, (void **)&curr);
+        more = kvcompact_peek(bh, kr->kr_end ? &end_kobj : NULL, &curr);
 
         if (curr) {
-            w->cw_stats.ms_keys_in++;
-            w->cw_stats.ms_key_bytes_in += key_obj_len(&curr->kobj);
+            stats->ms_keys_in++;
+            stats->ms_key_bytes_in += key_obj_len(&curr->kobj);
         }
 
         if (more) {
@@ -321,13 +772,24 @@ cn_kvcompact(struct cn_compaction_work *w)
             }
         }
 
+        if (km.km_active) {
+            /* Operands that reach the bottom of the tree have no base value.
+             */
+            if (w->cw_drop_tombs)
+                kvs_merge_resolve(&km, NULL, 0, HSE_KVS_VALUE_LEN_MAX);
+
+            err = kvcompact_merge_emit(stats, bldr, &km, &prev_kobj);
+            if (err)
+                goto out;
+        }
+
         if (emitted_val) {
             err = kvset_builder_add_key(bldr, &prev_kobj);
             if (err)
                 goto out;
 
-            w->cw_stats.ms_keys_out++;
-            w->cw_stats.ms_key_bytes_out += key_obj_len(&prev_kobj);
+            stats->ms_keys_out++;
+            stats->ms_key_bytes_out += key_obj_len(&prev_kobj);
         }
 
         new_key = true;
@@ -347,12 +809,14 @@ cn_kvcompact(struct cn_compaction_work *w)
         }
     }
 
-    err = kvset_builder_get_mblocks(bldr, &w->cw_outv[0]);
-    if (!err)
-        w->cw_output_nodev[0] = w->cw_node;
+    if (kr->kr_rtombs)
+        err = cn_compact_rtombs_emit(w, &rtombs, bldr);
 
 out:
-    kvset_builder_destroy(bldr);
+    cn_compact_filter_fini(&cfilter);
+    kvs_rtomb_vec_fini(&rtombs);
+    vdict_destroy(vdict);
+    kvs_merge_fini(&km);
     bin_heap_destroy(bh);
     free(bh_sources);
     free(buf);
@@ -365,3 +829,295 @@ out:
 
     return err;
 }
+
+static void
+kvcompact_builder_init(struct cn_compaction_work *w, struct kvset_builder *bldr,
+                       struct cn_merge_stats *stats)
+{
+    kvset_builder_set_merge_stats(bldr, stats);
+    kvset_builder_set_agegroup(bldr, HSE_MPOLICY_AGE_LEAF);
+    kvset_builder_set_wq(bldr, cn_get_wr_wq(cn_tree_get_cn(w->cw_tree)));
+}
+
+static merr_t
+kvcompact_serial(struct cn_compaction_work *w)
+{
+    struct kvcompact_range kr = { 0 };
+    merr_t err;
+
+    w->cw_kvsetidv[0] = cndb_kvsetid_mint(cn_tree_get_cndb(w->cw_tree));
+
+    err = kvset_builder_create(&kr.kr_bldr, cn_tree_get_cn(w->cw_tree), w->cw_pc,
+                               w->cw_kvsetidv[0]);
+    if (err)
+        return err;
+
+    kvcompact_builder_init(w, kr.kr_bldr, &w->cw_stats);
+
+    kr.kr_w = w;
+    kr.kr_inputv = w->cw_inputv;
+    kr.kr_stats = &w->cw_stats;
+    kr.kr_rtombs = true;
+
+    err = kvcompact_range(&kr);
+    if (!err) {
+        err = kvset_builder_get_mblocks(kr.kr_bldr, &w->cw_outv[0]);
+        if (!err)
+            w->cw_output_nodev[0] = w->cw_node;
+    }
+
+    kvset_builder_destroy(kr.kr_bldr);
+
+    return err;
+}
+
+/* Only plain kv-compactions are split into key ranges: Prefix tombstones
+ * may hide keys in any range, and capped kvses are compacted by dropping
+ * whole kvsets rather than merging them.  The vblock index space must also
+ * leave room for each range to write a reasonable number of vblocks.
+ */
+static bool
+kvcompact_splittable(struct cn_compaction_work *w)
+{
+    if (cn_get_flags(cn_tree_get_cn(w->cw_tree)) & CN_CFLAG_CAPPED)
+        return false;
+
+    if (w->cw_nv > (HG16_32K_MAX + 1) / 2)
+        return false;
+
+    for (uint i = 0; i < w->cw_kvset_cnt; i++) {
+        if (kvset_has_ptree(kvset_from_iter(w->cw_inputv[i])))
+            return false;
+    }
+
+    return true;
+}
+
+static void
+kvcompact_range_worker(struct work_struct *work)
+{
+    struct kvcompact_range *kr = container_of(work, struct kvcompact_range, kr_work);
+    struct kvcompact_wait *kw = kr->kr_wait;
+
+    kr->kr_err = kvcompact_range(kr);
+
+    /* kr must not be touched once the lock is dropped, as the caller
+     * may then free it.
+     */
+    mutex_lock(&kw->kw_lock);
+    if (--kw->kw_inflight == 0)
+        cv_signal(&kw->kw_cv);
+    mutex_unlock(&kw->kw_lock);
+}
+
+/* Split the compaction into key ranges of about equal size, merge each range
+ * into its own kvset builder on the cn io workqueue, and then concatenate the
+ * builders into a single output kvset.  Each range reads the input kvsets
+ * through its own set of iterators, positioned by a seek to the range's start.
+ */
+static merr_t
+kvcompact_parallel(struct cn_compaction_work *w)
+{
+    struct kvcompact_range *krv = NULL;
+    struct kvset_builder **bldv = NULL;
+    struct kv_iterator **inputv = NULL;
+    struct workqueue_struct *vra_wq;
+    struct cn_merge_stats base;
+    struct cndb *cndb;
+    struct cn *cn;
+    struct kvcompact_wait kw;
+    uint *klenv = NULL;
+    char *keyv = NULL;
+    uint rangec, keyc, vbidx_max, i, j;
+    u64 tprog = 0;
+    merr_t err;
+
+    cn = cn_tree_get_cn(w->cw_tree);
+    cndb = cn_tree_get_cndb(w->cw_tree);
+    vra_wq = cn_get_maint_wq(cn);
+
+    keyv = malloc((w->cw_subc - 1) * (HSE_KVS_KEY_LEN_MAX + sizeof(*klenv)));
+    if (!keyv)
+        return merr(ENOMEM);
+
+    klenv = (void *)(keyv + (w->cw_subc - 1) * HSE_KVS_KEY_LEN_MAX);
+
+    err = cn_compact_range_keys(w, w->cw_subc, keyv, klenv, &keyc);
+    if (err || keyc == 0) {
+        free(keyv);
+        return err ?: kvcompact_serial(w);
+    }
+
+    rangec = keyc + 1;
+    vbidx_max = (HG16_32K_MAX + 1) / rangec;
+
+    krv = calloc(rangec, sizeof(*krv) + sizeof(*bldv) + w->cw_kvset_cnt * sizeof(*inputv));
+    if (!krv) {
+        free(keyv);
+        return merr(ENOMEM);
+    }
+
+    bldv = (void *)(krv + rangec);
+    inputv = (void *)(bldv + rangec);
+
+    base = w->cw_stats;
+    w->cw_kvsetidv[0] = cndb_kvsetid_mint(cndb);
+
+    for (i = 0; i < rangec; i++) {
+        struct kvcompact_range *kr = krv + i;
+        u64 vgroup = i ? cndb_kvsetid_mint(cndb) : w->cw_kvsetidv[0];
+
+        err = kvset_builder_create(&bldv[i], cn, w->cw_pc, vgroup);
+        if (err)
+            goto out;
+
+        kvcompact_builder_init(w, bldv[i], &kr->kr_mstats);
+        kvset_builder_set_vbidx(bldv[i], i * vbidx_max, vbidx_max);
+
+        kr->kr_w = w;
+        kr->kr_inputv = inputv + i * w->cw_kvset_cnt;
+        kr->kr_bldr = bldv[i];
+        kr->kr_stats = &kr->kr_mstats;
+        kr->kr_rtombs = (i == 0);
+        kr->kr_wait = &kw;
+
+        if (i > 0) {
+            kr->kr_start = keyv + (i - 1) * HSE_KVS_KEY_LEN_MAX;
+            kr->kr_startlen = klenv[i - 1];
+        }
+
+        if (i < keyc) {
+            kr->kr_end = keyv + i * HSE_KVS_KEY_LEN_MAX;
+            kr->kr_endlen = klenv[i];
+        }
+
+        /* Seeking requires mcache maps, and the mcache iterators
+         * do not use an io workqueue.
+         */
+        for (j = 0; j < w->cw_kvset_cnt; j++) {
+            struct kvset *ks = kvset_from_iter(w->cw_inputv[j]);
+            struct kv_iterator **iter = &kr->kr_inputv[j];
+            bool eof;
+
+            kvset_get_ref(ks);
+
+            err = kvset_iter_create(ks, NULL, vra_wq, w->cw_pc,
+                                    w->cw_iter_flags | kvset_iter_flag_mcache, iter);
+            if (ev(err)) {
+                kvset_put_ref(ks);
+                goto out;
+            }
+
+            kvset_iter_set_stats(*iter, &kr->kr_mstats);
+
+            if (kr->kr_start) {
+                err = kvset_iter_seek(*iter, kr->kr_start, kr->kr_startlen, &eof);
+                if (ev(err))
+                    goto out;
+            }
+        }
+    }
+
+    if (w->cw_prog_interval && w->cw_progress)
+        tprog = jiffies;
+
+    mutex_init(&kw.kw_lock);
+    cv_init(&kw.kw_cv);
+    kw.kw_inflight = rangec;
+
+    for (i = 0; i < rangec; i++) {
+        INIT_WORK(&krv[i].kr_work, kvcompact_range_worker);
+
+        if (!queue_work(cn_get_io_wq(cn), &krv[i].kr_work)) {
+            mutex_lock(&kw.kw_lock);
+            kw.kw_inflight -= rangec - i;
+            mutex_unlock(&kw.kw_lock);
+            krv[i].kr_err = merr(EBUG);
+            break;
+        }
+    }
+
+    /* Wait for the ranges to complete, waking up once per progress
+     * interval to report the combined progress of all the ranges.
+     */
+    mutex_lock(&kw.kw_lock);
+    while (kw.kw_inflight > 0) {
+        cv_timedwait(&kw.kw_cv, &kw.kw_lock,
+                     tprog ? w->cw_prog_interval * MSEC_PER_SEC / HSE_HZ : -1, "kvcomp");
+
+        if (tprog && kw.kw_inflight > 0 && jiffies - tprog >= w->cw_prog_interval) {
+            mutex_unlock(&kw.kw_lock);
+            tprog = jiffies;
+
+            w->cw_stats = base;
+            for (i = 0; i < rangec; i++)
+                cn_merge_stats_add(&w->cw_stats, &krv[i].kr_mstats);
+
+            w->cw_progress(w);
+            mutex_lock(&kw.kw_lock);
+        }
+    }
+    mutex_unlock(&kw.kw_lock);
+
+    cv_destroy(&kw.kw_cv);
+    mutex_destroy(&kw.kw_lock);
+
+    w->cw_stats = base;
+
+    for (i = 0; i < rangec; i++) {
+        cn_merge_stats_add(&w->cw_stats, &krv[i].kr_mstats);
+
+        if (krv[i].kr_err && !err)
+            err = krv[i].kr_err;
+    }
+
+    if (!err) {
+        err = kvset_builder_get_mblocks_concat(bldv, rangec, &w->cw_outv[0]);
+        if (!err)
+            w->cw_output_nodev[0] = w->cw_node;
+    }
+
+    if (tprog)
+        w->cw_progress(w);
+
+out:
+    for (i = 0; i < rangec; i++) {
+        for (j = 0; j < w->cw_kvset_cnt; j++) {
+            struct kv_iterator *iter = krv[i].kr_inputv ? krv[i].kr_inputv[j] : NULL;
+
+            if (iter)
+                iter->kvi_ops->kvi_release(iter);
+        }
+
+        if (bldv[i])
+            kvset_builder_destroy(bldv[i]);
+    }
+
+    free(krv);
+    free(keyv);
+
+    return err;
+}
+
+merr_t
+cn_kvcompact(struct cn_compaction_work *w)
+{
+    assert(w->cw_kvset_cnt);
+    assert(w->cw_inputv);
+
+    if (w->cw_subc > 1 && kvcompact_splittable(w)) {
+        struct cn_merge_stats stats = w->cw_stats;
+        merr_t err;
+
+        err = kvcompact_parallel(w);
+        if (merr_errno(err) != EFBIG)
+            return err;
+
+        /* A range ran out of vblock indexes, start over with a single range.
+         */
+        ev(1);
+        w->cw_stats = stats;
+    }
+
+    return kvcompact_serial(w);
+}
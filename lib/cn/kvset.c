@@ -18,17 +18,18 @@
 #include <hse_util/perfc.h>
 #include <hse_util/log2.h>
 #include <hse_util/keycmp.h>
-#include <hse_util/compression_lz4.h>
 #include <hse_util/vlb.h>
 
 #include <hse/limits.h>
 #include <hse/kvdb_perfc.h>
 
 #include <hse_ikvdb/tuple.h>
+#include <hse_ikvdb/key_hash.h>
 #include <hse_ikvdb/cn_kvdb.h>
 #include <hse_ikvdb/cn.h>
 #include <hse_ikvdb/ikvdb.h>
 #include <hse_ikvdb/kvs_rparams.h>
+#include <hse_ikvdb/vcomp_params.h>
 
 #include "kvs_mblk_desc.h"
 
@@ -154,7 +155,7 @@ kvset_put_ref_final(struct kvset *ks)
     /* Wait briefly for any pending vbr_madvise_async() callbacks
      * to complete (likely it's a bug if there are any pending).
      */
-    for (tries = 0; tries < maxtries; ++tries) {
+    for (tries = 0; tries < maxtries && ks->ks_vbsetc > 0; ++tries) {
         for (i = 0; i < ks->ks_st.kst_vblks; ++i) {
             struct vblock_desc *vbd = lvx2vbd(ks, i);
 
@@ -254,6 +255,27 @@ kvset_hblk_init(
     if (err)
         return err;
 
+    /* Freed by kvset_close() should anything below fail. */
+    err = hbr_read_rtombs(hbd, &blk->kh_rtombv, &blk->kh_rtombc);
+    if (err)
+        return err;
+
+    if (blk->kh_rtombc > 0) {
+        struct kvs_rtomb_vec vec = {
+            .krv_rtv = blk->kh_rtombv,
+            .krv_cnt = blk->kh_rtombc,
+            .krv_max = blk->kh_rtombc,
+        };
+
+        /* On failure the tombstones are left as they were read */
+        err = kvs_rtomb_vec_sort(&vec);
+        if (err)
+            return err;
+
+        blk->kh_rtombv = vec.krv_rtv;
+        blk->kh_rtombc = vec.krv_cnt;
+    }
+
     err = hbr_read_vgroup_cnt(hbd, &nvgroups);
     if (err)
         return err;
@@ -395,36 +417,6 @@ blkid_list_to_vec(struct blk_list *blkl, size_t bufc, u64 *bufv)
     return v;
 }
 
-/* This is not a general purpose function!  The caller must ensure mapv is
- * large enough, and must also cleanup on failure.
- */
-static merr_t
-kvset_map_blklist(
-    struct mpool *            mp,
-    struct blk_list *         blks,
-    struct mpool_mcache_map **mapp)
-{
-    uint    idc;
-    u64    *idv;
-    u64     bufv[64];
-    merr_t  err;
-
-    idc = blks->n_blks;
-    if (!idc)
-        return 0;
-
-    idv = blkid_list_to_vec(blks, NELEM(bufv), bufv);
-    if (ev(!idv))
-        return merr(ENOMEM);
-
-    err = mpool_mcache_mmap(mp, idc, idv, mapp);
-
-    if (idv != bufv)
-        free(idv);
-
-    return err;
-}
-
 static merr_t
 vblock_udata_init(
     struct mbset *       mbs,
@@ -444,6 +436,12 @@ vblock_udata_init(
         rock);
 }
 
+static void
+vblock_udata_fini(void *udata)
+{
+    vbr_desc_fini(udata);
+}
+
 static merr_t
 vblock_udata_update(
     struct mbset *       mbs,
@@ -463,151 +461,66 @@ vblock_udata_update(
         rock);
 }
 
-merr_t
-kvset_open2(
-    struct cn_tree *   tree,
-    uint64_t           kvsetid,
-    struct kvset_meta *km,
-    uint               vbset_cnt_len,
-    uint *             vbset_cnts,
-    struct mbset ***   vbset_vecs,
-    struct kvset **    ks_out)
+/* Map the kvset's hblock and read its header, adding its stats to @st.
+ */
+static merr_t
+kvset_map_hblk(struct kvset *ks, struct kvset_stats *st)
 {
-    struct mpool *      mp;
-    struct kvs_rparams *rp;
-    struct cn_kvdb *    cn_kvdb;
-
-    merr_t        err;
-    uint          i, j;
-    size_t        alloc_len;
-    struct kvset *ks;
-    size_t        kcachesz;
-    const uint32_t n_kblks = km->km_kblk_list.n_blks;
-    const uint32_t n_vblks = km->km_vblk_list.n_blks;
-    uint          vbsetc;
-    uint32_t      last_kb;
-
-    struct kvs_cparams *cp;
-
-    /* need hblock, kblocks and vblocks optional */
-    assert(km->km_hblk.bk_blkid);
-    last_kb = n_kblks - 1;
-
-    /* number of vbsets */
-    vbsetc = 0;
-    for (i = 0; i < vbset_cnt_len; i++)
-        vbsetc += vbset_cnts[i];
-
-    /* one allocation for:
-     * - the kvset struct
-     * - array of struct kvset_kblk for kblocks
-     * - array of ptrs to vbsets
-     * - array of struct mbset_locator
-     */
-    alloc_len = sizeof(*ks);
-    alloc_len += sizeof(ks->ks_kblks[0]) * n_kblks;
-    alloc_len += sizeof(ks->ks_vbsetv[0]) * vbsetc;
-    alloc_len += sizeof(ks->ks_vblk2mbs[0]) * n_vblks;
-    alloc_len = ALIGN(alloc_len, __alignof__(*ks));
-
-    if (ev(alloc_len > kvset_cache[0].sz))
-        ks = aligned_alloc(__alignof__(*ks), alloc_len);
-    else if (alloc_len > kvset_cache[1].sz)
-        ks = kmem_cache_alloc(kvset_cache[0].cache);
-    else if (alloc_len > kvset_cache[2].sz)
-        ks = kmem_cache_alloc(kvset_cache[1].cache);
-    else if (alloc_len > kvset_cache[3].sz)
-        ks = kmem_cache_alloc(kvset_cache[2].cache);
-    else
-        ks = kmem_cache_alloc(kvset_cache[3].cache);
-
-    if (ev(!ks))
-        return merr(ENOMEM);
-
-    cp = cn_tree_get_cparams(tree);
-
-    mp = cn_tree_get_mp(tree);
-    rp = cn_tree_get_rp(tree);
-    cn_kvdb = cn_tree_get_cnkvdb(tree);
-
-    memset(ks, 0, alloc_len);
-    ks->ks_vbsetv = (void *)(ks->ks_kblks + n_kblks);
-    ks->ks_vblk2mbs = (void *)(ks->ks_vbsetv + vbsetc);
-
-    assert((void *)ks + alloc_len >= (void *)(ks->ks_vblk2mbs + n_vblks));
-
-    ks->ks_st.kst_kvsets = 1;
-    ks->ks_st.kst_vulen = km->km_vused;
-    ks->ks_st.kst_hblks = 1;
-    ks->ks_st.kst_kblks = n_kblks;
-    ks->ks_st.kst_vblks = n_vblks;
-
-    ks->ks_tree = tree;
-    ks->ks_entry.le_kvset = ks;
-    ks->ks_kvset_sz = alloc_len;
-
-    ks->ks_vbsetc = vbsetc;
-
-    ks->ks_mp = mp;
-    ks->ks_rp = rp;
-    ks->ks_dgen_hi = km->km_dgen_hi;
-    ks->ks_dgen_lo = km->km_dgen_lo;
-    ks->ks_compc = km->km_compc;
-    ks->ks_rule = km->km_rule;
-    ks->ks_kvsetid = kvsetid;
-    ks->ks_cnid = cn_tree_get_cnid(tree);
-    ks->ks_cndb = cn_tree_get_cndb(tree);
-    ks->ks_pfx_len = cp->pfx_len;
-    ks->ks_sfx_len = cp->sfx_len;
-    ks->ks_nodeid = km->km_nodeid;
-    ks->ks_vmax = rp->cn_mcache_vmax;
-    ks->ks_cn_kvdb = cn_kvdb;
-
-    /* initialize atomics */
-    atomic_set(&ks->ks_ref, 0);
-    atomic_set(&ks->ks_delete_error, 0);
-    atomic_set(&ks->ks_mbset_callbacks, 0);
+    struct mblock_props props;
+    uint64_t mbid = ks->ks_hblk.kh_hblk.bk_blkid;
+    merr_t err;
 
-    if (cn_tree_is_capped(ks->ks_tree))
-        ks->ks_vra_len = rp->cn_capped_vra;
-    else if (n_vblks > 0)
-        ks->ks_vra_len = rp->cn_cursor_vra;
+    err = mpool_mcache_mmap(ks->ks_mp, 1, &mbid, &ks->ks_hmap);
+    if (ev(err))
+        return err;
 
-    assert(ks->ks_kvsetid != 0);
+    err = mpool_mblock_props_get(ks->ks_mp, mbid, &props);
+    if (ev(err))
+        return err;
 
-    /* map single hblock */
-    err = mpool_mcache_mmap(mp, 1, &km->km_hblk.bk_blkid, &ks->ks_hmap);
+    err = kvset_hblk_init(ks->ks_mp, &props, ks->ks_hmap, &ks->ks_vgmap, &ks->ks_use_vgmap,
+                          &ks->ks_hlog, &ks->ks_hblk);
     if (ev(err))
-        goto err_exit;
+        return err;
 
-    {
-        struct mblock_props props;
+    st->kst_halen += props.mpr_alloc_cap;
+    st->kst_hwlen += props.mpr_write_len;
+    st->kst_ptombs += ks->ks_hblk.kh_metrics.hm_nptombs;
 
-        err = mpool_mblock_props_get(mp, km->km_hblk.bk_blkid, &props);
-        if (ev(err))
-            goto err_exit;
+    return 0;
+}
 
-        ks->ks_hblk.kh_hblk.bk_blkid = km->km_hblk.bk_blkid;
+/* Map the kvset's kblocks and read their headers, adding their stats to @st.
+ */
+static merr_t
+kvset_map_kblks(struct kvset *ks, struct kvset_stats *st)
+{
+    const uint32_t n_kblks = ks->ks_st.kst_kblks;
+    size_t kcachesz;
+    u64 bufv[64], *idv;
+    merr_t err;
+    uint i;
 
-        err = kvset_hblk_init(mp, &props, ks->ks_hmap, &ks->ks_vgmap, &ks->ks_use_vgmap,
-                              &ks->ks_hlog, &ks->ks_hblk);
-        if (ev(err))
-            goto err_exit;
+    if (!n_kblks)
+        return 0;
 
-        /* kvset_stats from kblocks */
-        ks->ks_st.kst_halen += props.mpr_alloc_cap;
-        ks->ks_st.kst_hwlen += props.mpr_write_len;
-        ks->ks_st.kst_ptombs += ks->ks_hblk.kh_metrics.hm_nptombs;
+    idv = bufv;
+    if (n_kblks > NELEM(bufv)) {
+        idv = malloc_array(n_kblks, sizeof(*idv));
+        if (ev(!idv))
+            return merr(ENOMEM);
     }
 
-    ks->ks_seqno_min = ks->ks_hblk.kh_seqno_min;
-    ks->ks_seqno_max = ks->ks_hblk.kh_seqno_max;
-    assert(ks->ks_seqno_min <= ks->ks_seqno_max);
+    for (i = 0; i < n_kblks; i++)
+        idv[i] = ks->ks_kblks[i].kb_kblk.bk_blkid;
+
+    err = mpool_mcache_mmap(ks->ks_mp, n_kblks, idv, &ks->ks_kmap);
+
+    if (idv != bufv)
+        free(idv);
 
-    /* map kblocks */
-    err = kvset_map_blklist(mp, &km->km_kblk_list, &ks->ks_kmap);
     if (ev(err))
-        goto err_exit;
+        return err;
 
     kcachesz = 0;
 
@@ -615,17 +528,13 @@ kvset_open2(
         struct kvset_kblk * kblk = ks->ks_kblks + i;
         struct mblock_props props;
 
-        u64 mbid = km->km_kblk_list.blks[i].bk_blkid;
-
-        err = mpool_mblock_props_get(mp, mbid, &props);
+        err = mpool_mblock_props_get(ks->ks_mp, kblk->kb_kblk.bk_blkid, &props);
         if (ev(err))
-            goto err_exit;
-
-        kblk->kb_kblk.bk_blkid = mbid;
+            return err;
 
-        err = kvset_kblk_init(rp, mp, &props, ks->ks_kmap, i, kblk);
+        err = kvset_kblk_init(ks->ks_rp, ks->ks_mp, &props, ks->ks_kmap, i, kblk);
         if (ev(err))
-            goto err_exit;
+            return err;
 
         /* Ignore these keys if they've already been cached
          * to kblk->kb_ksmall by kblk_init().
@@ -634,10 +543,19 @@ kvset_open2(
             kcachesz += kblk->kb_klen_max + kblk->kb_klen_min;
 
         /* kvset_stats from kblocks */
-        ks->ks_st.kst_kalen += props.mpr_alloc_cap;
-        ks->ks_st.kst_kwlen += props.mpr_write_len;
-        ks->ks_st.kst_keys += kblk->kb_metrics.num_keys;
-        ks->ks_st.kst_tombs += kblk->kb_metrics.num_tombstones;
+        st->kst_kalen += props.mpr_alloc_cap;
+        st->kst_kwlen += props.mpr_write_len;
+        st->kst_keys += kblk->kb_metrics.num_keys;
+        st->kst_tombs += kblk->kb_metrics.num_tombstones;
+
+        if (kblk->kb_metrics.tot_ttl_bytes) {
+            const u32 ttl_min = kblk->kb_metrics.ttl_min;
+
+            st->kst_ttl_bytes += kblk->kb_metrics.tot_ttl_bytes;
+            if (!st->kst_ttl_min || ttl_min < st->kst_ttl_min)
+                st->kst_ttl_min = ttl_min;
+            st->kst_ttl_max = max_t(u32, st->kst_ttl_max, kblk->kb_metrics.ttl_max);
+        }
     }
 
     /* Cache the large min/max keys from all the kblocks into a packed
@@ -646,7 +564,7 @@ kvset_open2(
      * fail (esp. in the kernel), but that's ok because we'll simply
      * fall back to using the keys in the mcache mapped header.
      */
-    kcachesz = min(kcachesz, rp->cn_kcachesz);
+    kcachesz = min(kcachesz, ks->ks_rp->cn_kcachesz);
     if (kcachesz > 0) {
         u8 *dst;
 
@@ -689,6 +607,17 @@ kvset_open2(
         }
     }
 
+    return 0;
+}
+
+/* Set the kvset's min/max keys from its mapped hblock and kblocks.
+ */
+static void
+kvset_init_bounds(struct kvset *ks)
+{
+    const uint32_t n_kblks = ks->ks_st.kst_kblks;
+    const uint32_t last_kb = n_kblks - 1;
+
     if (n_kblks) {
         if (kvset_has_ptree(ks)) {
             if (keycmp(ks->ks_kblks[0].kb_koff_min, ks->ks_kblks[0].kb_klen_min,
@@ -715,78 +644,450 @@ kvset_open2(
                 ks->ks_kdisc_min = ks->ks_kblks[0].kb_kdisc_min;
             }
 
-            if (key_disc_cmp(&ks->ks_kblks[last_kb].kb_kdisc_max,
-                    &ks->ks_hblk.kh_pfx_max_disc) > 0) {
-                ks->ks_kdisc_max = ks->ks_kblks[last_kb].kb_kdisc_max;
-            } else {
-                ks->ks_kdisc_max = ks->ks_hblk.kh_pfx_max_disc;
-            }
-        } else {
-            ks->ks_minkey = ks->ks_kblks[0].kb_koff_min;
-            ks->ks_minklen = ks->ks_kblks[0].kb_klen_min;
-            ks->ks_maxkey = ks->ks_kblks[last_kb].kb_koff_max;
-            ks->ks_maxklen = ks->ks_kblks[last_kb].kb_klen_max;
+            if (key_disc_cmp(&ks->ks_kblks[last_kb].kb_kdisc_max,
+                    &ks->ks_hblk.kh_pfx_max_disc) > 0) {
+                ks->ks_kdisc_max = ks->ks_kblks[last_kb].kb_kdisc_max;
+            } else {
+                ks->ks_kdisc_max = ks->ks_hblk.kh_pfx_max_disc;
+            }
+        } else {
+            ks->ks_minkey = ks->ks_kblks[0].kb_koff_min;
+            ks->ks_minklen = ks->ks_kblks[0].kb_klen_min;
+            ks->ks_maxkey = ks->ks_kblks[last_kb].kb_koff_max;
+            ks->ks_maxklen = ks->ks_kblks[last_kb].kb_klen_max;
+
+            ks->ks_kdisc_min = ks->ks_kblks[0].kb_kdisc_min;
+            ks->ks_kdisc_max = ks->ks_kblks[last_kb].kb_kdisc_max;
+        }
+
+        /* Check to see if all keys in this kvset have a common prefix.
+         * If so, then remember it so that we can leverage it to reduce
+         * the amount of work required to find keys with common prefixes.
+         */
+        ks->ks_lcp = min_t(size_t, ks->ks_minklen, ks->ks_maxklen);
+        ks->ks_lcp = memlcpq(ks->ks_minkey, ks->ks_maxkey, ks->ks_lcp);
+
+    } else {
+        ks->ks_minkey = ks->ks_hblk.kh_pfx_min;
+        ks->ks_minklen = ks->ks_hblk.kh_pfx_min_len;
+        ks->ks_maxkey = ks->ks_hblk.kh_pfx_max;
+        ks->ks_maxklen = ks->ks_hblk.kh_pfx_max_len;
+
+        ks->ks_kdisc_min = ks->ks_hblk.kh_pfx_min_disc;
+        ks->ks_kdisc_max = ks->ks_hblk.kh_pfx_max_disc;
+    }
+}
+
+/* Take refs on the kvset's vblock mbsets, adding their stats to @st.
+ */
+static merr_t
+kvset_attach_vbsets(
+    struct kvset       *ks,
+    uint                vbset_cnt_len,
+    uint               *vbset_cnts,
+    struct mbset     ***vbset_vecs,
+    struct kvset_stats *st)
+{
+    uint v = 0; /* vblock number (0..n_vblks) */
+    uint m = 0; /* index into mbset vector */
+    uint i, j, k;
+    u64 *argv;
+    uint argc;
+
+    argv = malloc(sizeof(*argv) * (ks->ks_st.kst_vblks + 1));
+    if (ev(!argv))
+        return merr(ENOMEM);
+
+    for (i = 0; i < vbset_cnt_len; i++) {
+        for (j = 0; j < vbset_cnts[i]; j++, m++) {
+            /* set up refs to mbset #j */
+            struct mbset *mbset = vbset_vecs[i][j];
+            uint          blks_in_mbset = mbset_get_blkc(mbset);
+
+            /* kvset_stats from vblocks */
+            st->kst_valen += mbset_get_alen(mbset);
+            st->kst_vwlen += mbset_get_wlen(mbset);
+
+            ks->ks_vbsetv[m] = mbset_get_ref(mbset);
+            for (k = 0; k < blks_in_mbset; k++, v++) {
+                ks->ks_vblk2mbs[v].mbs = mbset;
+                ks->ks_vblk2mbs[v].idx = k;
+            }
+        }
+    }
+
+    assert(v == ks->ks_st.kst_vblks);
+    ks->ks_vbsetc = m;
+
+    /* Compute vgroup indices and tally the number of vgroups.
+     */
+    argc = 0;
+
+    for (i = 0; i < m; ++i) {
+        struct mbset *mbset = ks->ks_vbsetv[i];
+
+        mbset_apply(mbset, vblock_udata_update, &argc, argv);
+    }
+
+    free(argv);
+
+    return 0;
+}
+
+static merr_t
+kvset_vbset_create(struct mpool *mp, uint idc, u64 *idv, bool capped, struct mbset **vbset)
+{
+    merr_t err;
+
+    err = mbset_create(mp, idc, idv, sizeof(struct vblock_desc), vblock_udata_init,
+                       capped ? MBSET_FLAGS_CAPPED : 0, vbset);
+    if (ev(err))
+        return err;
+
+    mbset_set_udata_fini(*vbset, vblock_udata_fini);
+
+    return 0;
+}
+
+/* A kvset may be opened lazily if it was restored from the cndb with a
+ * summary, and if reads need nothing from its hblock to decide whether
+ * the kvset could contain a key (i.e., it has no prefix tombstones).
+ * Summaries are not recorded for kvsets with range tombstones.
+ */
+static bool
+kvset_lazy_ok(struct cn_tree *tree, const struct kvset_meta *km)
+{
+    const struct kvset_summary *sum = km->km_summary;
+
+    return sum && km->km_restored && km->km_kblk_list.n_blks > 0 &&
+        sum->ksum_st.kst_ptombs == 0 && !cn_tree_is_capped(tree) &&
+        cn_tree_get_rp(tree)->cn_kvset_lazy_open;
+}
+
+/* Initialize a kvset from its cndb summary without mapping any of its
+ * blocks.  Everything else is left for kvset_load().
+ */
+static merr_t
+kvset_open_lazy(struct kvset *ks, struct kvset_meta *km)
+{
+    const struct kvset_summary *sum = km->km_summary;
+    const size_t sz = kvset_summary_size(sum->ksum_minklen, sum->ksum_maxklen);
+    struct kvset_stats *st = &ks->ks_st;
+    uint i;
+
+    ks->ks_summary = malloc(sz);
+    if (ev(!ks->ks_summary))
+        return merr(ENOMEM);
+
+    memcpy(ks->ks_summary, sum, sz);
+
+    if (km->km_vblk_list.n_blks > 0) {
+        ks->ks_vblkidv = blkid_list_to_vec(&km->km_vblk_list, 0, NULL);
+        if (ev(!ks->ks_vblkidv))
+            return merr(ENOMEM);
+    }
+
+    ks->ks_hblk.kh_hblk.bk_blkid = km->km_hblk.bk_blkid;
+    for (i = 0; i < st->kst_kblks; i++)
+        ks->ks_kblks[i].kb_kblk.bk_blkid = km->km_kblk_list.blks[i].bk_blkid;
+
+    /* The block counts and vused come from the kvset meta, so take
+     * only what was learned from the blocks themselves.
+     */
+    st->kst_keys = sum->ksum_st.kst_keys;
+    st->kst_tombs = sum->ksum_st.kst_tombs;
+    st->kst_halen = sum->ksum_st.kst_halen;
+    st->kst_hwlen = sum->ksum_st.kst_hwlen;
+    st->kst_kalen = sum->ksum_st.kst_kalen;
+    st->kst_kwlen = sum->ksum_st.kst_kwlen;
+    st->kst_valen = sum->ksum_st.kst_valen;
+    st->kst_vwlen = sum->ksum_st.kst_vwlen;
+    st->kst_ttl_bytes = sum->ksum_st.kst_ttl_bytes;
+    st->kst_ttl_min = sum->ksum_st.kst_ttl_min;
+    st->kst_ttl_max = sum->ksum_st.kst_ttl_max;
+
+    ks->ks_seqno_min = sum->ksum_seqno_min;
+    ks->ks_seqno_max = sum->ksum_seqno_max;
+    assert(ks->ks_seqno_min <= ks->ks_seqno_max);
+
+    ks->ks_minkey = ks->ks_summary->ksum_keyv;
+    ks->ks_minklen = sum->ksum_minklen;
+    ks->ks_maxkey = ks->ks_summary->ksum_keyv + sum->ksum_minklen;
+    ks->ks_maxklen = sum->ksum_maxklen;
+
+    key_disc_init(ks->ks_minkey, ks->ks_minklen, &ks->ks_kdisc_min);
+    key_disc_init(ks->ks_maxkey, ks->ks_maxklen, &ks->ks_kdisc_max);
+
+    ks->ks_lcp = min_t(size_t, ks->ks_minklen, ks->ks_maxklen);
+    ks->ks_lcp = memlcpq(ks->ks_minkey, ks->ks_maxkey, ks->ks_lcp);
+
+    return 0;
+}
+
+/* Undo a partial kvset_load() so that it may be retried.
+ */
+static void
+kvset_unmap(struct kvset *ks)
+{
+    const uint64_t hblkid = ks->ks_hblk.kh_hblk.bk_blkid;
+
+    mpool_mcache_munmap(ks->ks_kmap);
+    mpool_mcache_munmap(ks->ks_hmap);
+    free((void *)ks->ks_klarge);
+    free(ks->ks_hblk.kh_rtombv);
+    vgmap_free(ks->ks_vgmap);
+
+    ks->ks_kmap = NULL;
+    ks->ks_hmap = NULL;
+    ks->ks_klarge = NULL;
+    ks->ks_vgmap = NULL;
+    ks->ks_use_vgmap = false;
+    ks->ks_hlog = NULL;
+
+    memset(&ks->ks_hblk, 0, sizeof(ks->ks_hblk));
+    ks->ks_hblk.kh_hblk.bk_blkid = hblkid;
+}
+
+merr_t
+kvset_load(struct kvset *ks)
+{
+    struct kvset_stats st = { 0 };
+    merr_t err = 0;
+
+    if (atomic_read_acq(&ks->ks_loaded))
+        return 0;
+
+    mutex_lock(&ks->ks_load_lock);
+    if (atomic_read(&ks->ks_loaded))
+        goto out;
+
+    err = kvset_map_hblk(ks, &st);
+    if (!err)
+        err = kvset_map_kblks(ks, &st);
+
+    if (!err && ks->ks_st.kst_vblks > 0) {
+        struct mbset *vbset, **vbsetv = &vbset;
+        uint vbsetc = 1;
+
+        err = kvset_vbset_create(ks->ks_mp, ks->ks_st.kst_vblks, ks->ks_vblkidv,
+                                 cn_tree_is_capped(ks->ks_tree), &vbset);
+        if (!err) {
+            /* kvset_attach_vbsets() takes its own ref.
+             */
+            err = kvset_attach_vbsets(ks, 1, &vbsetc, &vbsetv, &st);
+            mbset_put_ref(vbset);
+        }
+    }
+
+    if (err) {
+        kvset_unmap(ks);
+        log_errx("cnid %lu kvset %lu: load failed", err, ks->ks_cnid, ks->ks_kvsetid);
+        goto out;
+    }
+
+    assert(st.kst_keys == ks->ks_st.kst_keys);
+    assert(st.kst_kwlen == ks->ks_st.kst_kwlen);
+
+    /* The kvset may have been compacted away before it was ever loaded,
+     * in which case its vblocks are deleted along with the mbset.
+     */
+    if (ks->ks_deleted == DEL_ALL)
+        kvset_mark_mbset_for_delete(ks, true);
+
+    atomic_set_rel(&ks->ks_loaded, 1);
+
+out:
+    mutex_unlock(&ks->ks_load_lock);
+
+    return err;
+}
+
+bool
+kvset_is_loaded(const struct kvset *ks)
+{
+    return atomic_read_acq(&ks->ks_loaded);
+}
+
+/* Give the cndb what was just learned from the kvset's hblock and kblocks
+ * so that the next open of the kvdb need not learn it again.  Kvsets with
+ * range tombstones are skipped, as every read must consult their hblock
+ * and hence they cannot be opened lazily.
+ */
+static void
+kvset_summary_record(struct kvset *ks)
+{
+    struct kvset_summary *sum;
+    merr_t err;
+
+    if (ks->ks_hblk.kh_rtombc > 0)
+        return;
+
+    sum = malloc(kvset_summary_size(ks->ks_minklen, ks->ks_maxklen));
+    if (ev(!sum))
+        return;
+
+    sum->ksum_seqno_min = ks->ks_seqno_min;
+    sum->ksum_seqno_max = ks->ks_seqno_max;
+    sum->ksum_st = ks->ks_st;
+    sum->ksum_vgroups = kvset_get_vgroups(ks);
+    sum->ksum_minklen = ks->ks_minklen;
+    sum->ksum_maxklen = ks->ks_maxklen;
+    memcpy(sum->ksum_keyv, ks->ks_minkey, ks->ks_minklen);
+    memcpy(sum->ksum_keyv + ks->ks_minklen, ks->ks_maxkey, ks->ks_maxklen);
+
+    err = cndb_record_kvset_summary(ks->ks_cndb, ks->ks_cnid, ks->ks_kvsetid, sum);
+    ev(err);
+
+    free(sum);
+}
+
+merr_t
+kvset_open2(
+    struct cn_tree *   tree,
+    uint64_t           kvsetid,
+    struct kvset_meta *km,
+    uint               vbset_cnt_len,
+    uint *             vbset_cnts,
+    struct mbset ***   vbset_vecs,
+    struct kvset **    ks_out)
+{
+    struct mpool *      mp;
+    struct kvs_rparams *rp;
+    struct cn_kvdb *    cn_kvdb;
+
+    merr_t        err;
+    uint          i;
+    size_t        alloc_len;
+    struct kvset *ks;
+    const uint32_t n_kblks = km->km_kblk_list.n_blks;
+    const uint32_t n_vblks = km->km_vblk_list.n_blks;
+    uint          vbsetc;
+    bool          lazy;
+
+    struct kvs_cparams *cp;
+
+    /* need hblock, kblocks and vblocks optional */
+    assert(km->km_hblk.bk_blkid);
+
+    /* A lazy kvset creates its one vbset when it is loaded.
+     */
+    lazy = kvset_lazy_ok(tree, km);
+
+    /* number of vbsets */
+    vbsetc = 0;
+    if (lazy) {
+        vbsetc = n_vblks > 0 ? 1 : 0;
+        vbset_cnt_len = 0;
+    }
+    for (i = 0; i < vbset_cnt_len; i++)
+        vbsetc += vbset_cnts[i];
+
+    /* one allocation for:
+     * - the kvset struct
+     * - array of struct kvset_kblk for kblocks
+     * - array of ptrs to vbsets
+     * - array of struct mbset_locator
+     */
+    alloc_len = sizeof(*ks);
+    alloc_len += sizeof(ks->ks_kblks[0]) * n_kblks;
+    alloc_len += sizeof(ks->ks_vbsetv[0]) * vbsetc;
+    alloc_len += sizeof(ks->ks_vblk2mbs[0]) * n_vblks;
+    alloc_len = ALIGN(alloc_len, __alignof__(*ks));
+
+    if (ev(alloc_len > kvset_cache[0].sz))
+        ks = aligned_alloc(__alignof__(*ks), alloc_len);
+    else if (alloc_len > kvset_cache[1].sz)
+        ks = kmem_cache_alloc(kvset_cache[0].cache);
+    else if (alloc_len > kvset_cache[2].sz)
+        ks = kmem_cache_alloc(kvset_cache[1].cache);
+    else if (alloc_len > kvset_cache[3].sz)
+        ks = kmem_cache_alloc(kvset_cache[2].cache);
+    else
+        ks = kmem_cache_alloc(kvset_cache[3].cache);
+
+    if (ev(!ks))
+        return merr(ENOMEM);
+
+    cp = cn_tree_get_cparams(tree);
+
+    mp = cn_tree_get_mp(tree);
+    rp = cn_tree_get_rp(tree);
+    cn_kvdb = cn_tree_get_cnkvdb(tree);
+
+    memset(ks, 0, alloc_len);
+    ks->ks_vbsetv = (void *)(ks->ks_kblks + n_kblks);
+    ks->ks_vblk2mbs = (void *)(ks->ks_vbsetv + vbsetc);
+
+    assert((void *)ks + alloc_len >= (void *)(ks->ks_vblk2mbs + n_vblks));
+
+    ks->ks_st.kst_kvsets = 1;
+    ks->ks_st.kst_vulen = km->km_vused;
+    ks->ks_st.kst_hblks = 1;
+    ks->ks_st.kst_kblks = n_kblks;
+    ks->ks_st.kst_vblks = n_vblks;
+
+    ks->ks_tree = tree;
+    ks->ks_entry.le_kvset = ks;
+    ks->ks_kvset_sz = alloc_len;
+
+    ks->ks_mp = mp;
+    ks->ks_rp = rp;
+    ks->ks_dgen_hi = km->km_dgen_hi;
+    ks->ks_dgen_lo = km->km_dgen_lo;
+    ks->ks_compc = km->km_compc;
+    ks->ks_rule = km->km_rule;
+    ks->ks_kvsetid = kvsetid;
+    ks->ks_cnid = cn_tree_get_cnid(tree);
+    ks->ks_cndb = cn_tree_get_cndb(tree);
+    ks->ks_pfx_len = cp->pfx_len;
+    ks->ks_sfx_len = cp->sfx_len;
+    ks->ks_nodeid = km->km_nodeid;
+    ks->ks_vmax = rp->cn_mcache_vmax;
+    ks->ks_bcache = mpool_bcache_enabled(mp);
+    ks->ks_cn_kvdb = cn_kvdb;
+
+    /* initialize atomics */
+    atomic_set(&ks->ks_ref, 0);
+    atomic_set(&ks->ks_delete_error, 0);
+    atomic_set(&ks->ks_mbset_callbacks, 0);
+    atomic_set(&ks->ks_loaded, 0);
+    mutex_init(&ks->ks_load_lock);
 
-            ks->ks_kdisc_min = ks->ks_kblks[0].kb_kdisc_min;
-            ks->ks_kdisc_max = ks->ks_kblks[last_kb].kb_kdisc_max;
-        }
+    if (cn_tree_is_capped(ks->ks_tree))
+        ks->ks_vra_len = rp->cn_capped_vra;
+    else if (n_vblks > 0)
+        ks->ks_vra_len = rp->cn_cursor_vra;
 
-        /* Check to see if all keys in this kvset have a common prefix.
-         * If so, then remember it so that we can leverage it to reduce
-         * the amount of work required to find keys with common prefixes.
-         */
-        ks->ks_lcp = min_t(size_t, ks->ks_minklen, ks->ks_maxklen);
-        ks->ks_lcp = memlcpq(ks->ks_minkey, ks->ks_maxkey, ks->ks_lcp);
+    assert(ks->ks_kvsetid != 0);
 
+    if (lazy) {
+        err = kvset_open_lazy(ks, km);
+        if (ev(err))
+            goto err_exit;
     } else {
-        ks->ks_minkey = ks->ks_hblk.kh_pfx_min;
-        ks->ks_minklen = ks->ks_hblk.kh_pfx_min_len;
-        ks->ks_maxkey = ks->ks_hblk.kh_pfx_max;
-        ks->ks_maxklen = ks->ks_hblk.kh_pfx_max_len;
+        ks->ks_hblk.kh_hblk.bk_blkid = km->km_hblk.bk_blkid;
+        for (i = 0; i < n_kblks; i++)
+            ks->ks_kblks[i].kb_kblk.bk_blkid = km->km_kblk_list.blks[i].bk_blkid;
 
-        ks->ks_kdisc_min = ks->ks_hblk.kh_pfx_min_disc;
-        ks->ks_kdisc_max = ks->ks_hblk.kh_pfx_max_disc;
-    }
+        err = kvset_map_hblk(ks, &ks->ks_st);
+        if (ev(err))
+            goto err_exit;
 
-    {
-        uint v = 0; /* vblock number (0..n_vblks) */
-        uint m = 0; /* index into mbset vector */
-        uint k;
-        u64 *argv;
-        uint argc;
-
-        for (i = 0; i < vbset_cnt_len; i++) {
-            for (j = 0; j < vbset_cnts[i]; j++, m++) {
-                /* set up refs to mbset #j */
-                struct mbset *mbset = vbset_vecs[i][j];
-                uint          blks_in_mbset = mbset_get_blkc(mbset);
-
-                /* kvset_stats from vblocks */
-                ks->ks_st.kst_valen += mbset_get_alen(mbset);
-                ks->ks_st.kst_vwlen += mbset_get_wlen(mbset);
-
-                ks->ks_vbsetv[m] = mbset_get_ref(mbset);
-                for (k = 0; k < blks_in_mbset; k++, v++) {
-                    ks->ks_vblk2mbs[v].mbs = mbset;
-                    ks->ks_vblk2mbs[v].idx = k;
-                }
-            }
-        }
+        ks->ks_seqno_min = ks->ks_hblk.kh_seqno_min;
+        ks->ks_seqno_max = ks->ks_hblk.kh_seqno_max;
+        assert(ks->ks_seqno_min <= ks->ks_seqno_max);
 
-        /* Compute vgroup indices and tally the number of vgroups.
-         */
-        argc = 0;
-        argv = malloc(sizeof(*argv) * (v + 1));
-        if (ev(!argv))
+        err = kvset_map_kblks(ks, &ks->ks_st);
+        if (ev(err))
             goto err_exit;
 
-        for (i = 0; i < m; ++i) {
-            struct mbset *mbset = ks->ks_vbsetv[i];
+        kvset_init_bounds(ks);
 
-            mbset_apply(mbset, vblock_udata_update, &argc, argv);
-        }
+        err = kvset_attach_vbsets(ks, vbset_cnt_len, vbset_cnts, vbset_vecs, &ks->ks_st);
+        if (ev(err))
+            goto err_exit;
 
-        free(argv);
+        atomic_set(&ks->ks_loaded, 1);
     }
 
     /* begin life with one ref and not deleting */
@@ -816,6 +1117,9 @@ kvset_open2(
         }
     }
 
+    if (ks->ks_cndb && !km->km_summary)
+        kvset_summary_record(ks);
+
     ks->ks_ctime = get_time_ns();
 
     *ks_out = ks;
@@ -836,7 +1140,9 @@ kvset_open(struct cn_tree *tree, uint64_t kvsetid, struct kvset_meta *km, struct
     struct mbset **vbsetv = &vbset;
     uint           vbsetc = 0;
     uint           len = 0;
-    uint           flags = 0;
+
+    if (kvset_lazy_ok(tree, km))
+        n_vblks = 0;
 
     if (n_vblks) {
         u64 bufv[64];
@@ -846,11 +1152,7 @@ kvset_open(struct cn_tree *tree, uint64_t kvsetid, struct kvset_meta *km, struct
         if (ev(!idv))
             return merr(ENOMEM);
 
-        if (km->km_capped)
-            flags |= MBSET_FLAGS_CAPPED;
-
-        err = mbset_create(cn_tree_get_mp(tree), n_vblks, idv, sizeof(struct vblock_desc),
-                           vblock_udata_init, flags, &vbset);
+        err = kvset_vbset_create(cn_tree_get_mp(tree), n_vblks, idv, km->km_capped, &vbset);
         if (idv != bufv)
             free(idv);
         if (ev(err))
@@ -938,12 +1240,17 @@ kvset_mark_mbset_for_delete(struct kvset *ks, bool delete_blks)
 void
 kvset_mark_mblocks_for_delete(struct kvset *ks, bool keepv)
 {
+    /* Serialize with kvset_load(), which marks the mbset itself
+     * should the kvset be loaded after this.
+     */
+    mutex_lock(&ks->ks_load_lock);
     if (keepv) {
         ks->ks_deleted = DEL_KEEPV;
     } else {
         ks->ks_deleted = DEL_ALL;
         kvset_mark_mbset_for_delete(ks, true);
     }
+    mutex_unlock(&ks->ks_load_lock);
 }
 
 void
@@ -1002,6 +1309,24 @@ cleanup_hblock(struct kvset *ks)
     }
 }
 
+/* The vblocks of a kvset that was never loaded have no mbset to delete
+ * them, so delete them here.
+ */
+static void
+cleanup_vblocks_unloaded(struct kvset *ks)
+{
+    if (ks->ks_deleted != DEL_ALL || atomic_read(&ks->ks_loaded) || !ks->ks_vblkidv)
+        return;
+
+    for (uint32_t i = 0; i < ks->ks_st.kst_vblks; i++) {
+        merr_t err = mpool_mblock_delete(ks->ks_mp, ks->ks_vblkidv[i]);
+        if (err) {
+            atomic_inc(&ks->ks_delete_error);
+            return;
+        }
+    }
+}
+
 static void
 cleanup_purge_blklist(struct kvset *ks)
 {
@@ -1026,6 +1351,7 @@ kvset_close(struct kvset *ks)
 
     cleanup_hblock(ks);
     cleanup_kblocks(ks);
+    cleanup_vblocks_unloaded(ks);
 
     if (ks->ks_deleted == DEL_LIST)
         cleanup_purge_blklist(ks);
@@ -1034,8 +1360,12 @@ kvset_close(struct kvset *ks)
         cndb_record_kvset_del_ack(ks->ks_cndb, ks->ks_delete_txn, ks->ks_delete_cookie);
 
     free((void *)ks->ks_klarge);
+    free(ks->ks_hblk.kh_rtombv);
+    free(ks->ks_summary);
+    free(ks->ks_vblkidv);
 
     vgmap_free(ks->ks_vgmap);
+    mutex_destroy(&ks->ks_load_lock);
 
     if (ks->ks_kvset_sz > kvset_cache[0].sz)
         free(ks);
@@ -1125,6 +1455,67 @@ kvset_has_ptree(const struct kvset *const ks)
     return ks->ks_pfx_len > 0 && ks->ks_hblk.kh_ptree_desc.wbd_n_pages > 0;
 }
 
+const struct kvs_rtomb *
+kvset_get_rtombs(const struct kvset *ks, uint *rtc)
+{
+    *rtc = ks->ks_hblk.kh_rtombc;
+
+    return ks->ks_hblk.kh_rtombv;
+}
+
+merr_t
+kvset_bloom_insert(struct kvset *ks, struct bloom_filter *bf)
+{
+    uint64_t hashv[256];
+    struct wbti *wbti;
+    merr_t err;
+
+    err = kvset_load(ks);
+    if (ev(err))
+        return err;
+
+    err = wbti_alloc(&wbti);
+    if (ev(err))
+        return err;
+
+    for (uint i = 0; i < ks->ks_st.kst_kblks; i++) {
+        struct kvset_kblk *kblk = ks->ks_kblks + i;
+        struct key_obj ko;
+        const void *kmd;
+        uint n = 0;
+
+        err = wbti_reset(wbti, kblk->kb_kblk_desc.map_base, &kblk->kb_wbt_desc, NULL,
+                         false, false);
+        if (ev(err))
+            break;
+
+        while (wbti_next(wbti, &ko.ko_sfx, &ko.ko_sfx_len, &kmd)) {
+            wbti_prefix(wbti, &ko.ko_pfx, &ko.ko_pfx_len);
+
+            /* Hash only on the soft prefix, as do the kblock blooms.
+             */
+            if (ks->ks_sfx_len) {
+                size_t min_sfx_len = min_t(size_t, ks->ks_sfx_len, ko.ko_sfx_len);
+
+                ko.ko_sfx_len -= min_sfx_len;
+                ko.ko_pfx_len -= ks->ks_sfx_len - min_sfx_len;
+            }
+
+            hashv[n++] = key_obj_hash64(&ko);
+            if (n == NELEM(hashv)) {
+                bf_filter_insert_by_hashv(bf, hashv, n);
+                n = 0;
+            }
+        }
+
+        bf_filter_insert_by_hashv(bf, hashv, n);
+    }
+
+    wbti_destroy(wbti);
+
+    return err;
+}
+
 /**
  * kvset_kblk_start() - determine if a kvset might contain a key.
  *
@@ -1206,6 +1597,10 @@ kblk_get_value_ref(
     if (!bloom_reader_lookup(&kblk->kb_blm_desc, kt->kt_hash))
         return 0;
 
+    if (ks->ks_bcache)
+        return wbtr_read_vref_cached(ks->ks_mp, &kblk->kb_kblk_desc, &kblk->kb_wbt_desc, kt, seq,
+                                     result, ks->ks_use_vgmap ? ks->ks_vgmap : NULL, vref);
+
     return wbtr_read_vref(kblk->kb_kblk_desc.map_base, &kblk->kb_wbt_desc, kt, seq, result,
                           ks->ks_use_vgmap ? ks->ks_vgmap : NULL, vref);
 }
@@ -1225,14 +1620,25 @@ kvset_ptomb_lookup(
 
         kvs_ktuple_init_nohash(&pfx, kt->kt_data, ks->ks_pfx_len);
 
-        err = wbtr_read_vref(
-            ks->ks_hblk.kh_hblk_desc.map_base,
-            &ks->ks_hblk.kh_ptree_desc,
-            &pfx,
-            view_seq,
-            res,
-            ks->ks_use_vgmap ? ks->ks_vgmap : NULL,
-            vref);
+        if (ks->ks_bcache)
+            err = wbtr_read_vref_cached(
+                ks->ks_mp,
+                &ks->ks_hblk.kh_hblk_desc,
+                &ks->ks_hblk.kh_ptree_desc,
+                &pfx,
+                view_seq,
+                res,
+                ks->ks_use_vgmap ? ks->ks_vgmap : NULL,
+                vref);
+        else
+            err = wbtr_read_vref(
+                ks->ks_hblk.kh_hblk_desc.map_base,
+                &ks->ks_hblk.kh_ptree_desc,
+                &pfx,
+                view_seq,
+                res,
+                ks->ks_use_vgmap ? ks->ks_vgmap : NULL,
+                vref);
         if (ev(err))
             return err;
     }
@@ -1258,6 +1664,19 @@ kvset_lookup_vref(
     enum key_lookup_res   pt_result;
     struct kvs_vtuple_ref pt_vref;
 
+    /* Don't load a lazily opened kvset for a key outside its bounds
+     * (it has neither prefix nor range tombstones to consult).
+     */
+    if (!kvset_is_loaded(ks)) {
+        if (key_disc_cmp(kdisc, &ks->ks_kdisc_max) > 0 ||
+            key_disc_cmp(kdisc, &ks->ks_kdisc_min) < 0)
+            return 0;
+
+        err = kvset_load(ks);
+        if (ev(err))
+            return err;
+    }
+
     lcp = 0;
 
     first = 0;
@@ -1322,6 +1741,22 @@ done:
         }
     }
 
+    /* A range tombstone hides the key if it is newer than anything
+     * found above, regardless of the kvset's key bounds.
+     */
+    if (ks->ks_hblk.kh_rtombc > 0) {
+        struct key_obj kobj;
+        u64 rt_seq;
+
+        key2kobj(&kobj, kt->kt_data, kt->kt_len);
+
+        rt_seq = kvs_rtomb_seq(ks->ks_hblk.kh_rtombv, ks->ks_hblk.kh_rtombc, &kobj, seq);
+        if (rt_seq > 0 && (*result == NOT_FOUND || rt_seq > vref->vr_seq)) {
+            *result = FOUND_TMB;
+            vref->vr_seq = rt_seq;
+        }
+    }
+
     return 0;
 }
 
@@ -1341,6 +1776,29 @@ kvset_get_immediate_value(struct kvs_vtuple_ref *vref, struct kvs_buf *vbuf)
     copylen = vbuf->b_len = vref->vi.vr_len;
     if (copylen > vbuf->b_buf_sz)
         copylen = vbuf->b_buf_sz;
+
+    if (vref->vi.vr_complen) {
+        uint   outlen;
+        merr_t err;
+
+        if (!copylen)
+            return 0;
+
+        /* Inline values are never dictionary compressed.
+         */
+        err = vcomp_decompress(vref->vi.vr_data, vref->vi.vr_complen, NULL,
+                               vbuf->b_buf, copylen, &outlen);
+        if (ev(err))
+            return err;
+
+        if (ev(copylen == vref->vi.vr_len && outlen != copylen)) {
+            assert(0);
+            return merr(EBUG);
+        }
+
+        return 0;
+    }
+
     memcpy(vbuf->b_buf, vref->vi.vr_data, copylen);
 
     return 0;
@@ -1349,6 +1807,22 @@ kvset_get_immediate_value(struct kvs_vtuple_ref *vref, struct kvs_buf *vbuf)
 extern thread_local char tls_vbuf[];
 extern const size_t tls_vbufsz;
 
+/* Values that are not read directly (i.e., smaller than ks_vmax) and that
+ * span at most this many bytes of vblock pages are read via the mpool block
+ * cache when it is enabled rather than via the mcache map.
+ */
+#define KVSET_BCACHE_VSPAN_MAX (4 * PAGE_SIZE)
+
+static merr_t
+kvset_mblock_read(struct kvset *ks, u64 mbid, const struct iovec *iov, size_t off, bool cached)
+{
+    if (cached)
+        return mpool_mblock_read_cached(ks->ks_mp, mbid, iov->iov_base, iov->iov_len, off,
+                                        MPOOL_BCACHE_PRIO_DATA);
+
+    return mpool_mblock_read(ks->ks_mp, mbid, iov, 1, off);
+}
+
 static merr_t
 kvset_lookup_val_direct(
     struct kvset *      ks,
@@ -1357,7 +1831,8 @@ kvset_lookup_val_direct(
     u32                 vboff,
     void *              vbuf,
     u32                 vbufsz,
-    u32                 copylen)
+    u32                 copylen,
+    bool                cached)
 {
     struct iovec iov;
     bool         aligned_vbuf;
@@ -1397,7 +1872,7 @@ kvset_lookup_val_direct(
         }
     }
 
-    err = mpool_mblock_read(ks->ks_mp, mbid, &iov, 1, off);
+    err = kvset_mblock_read(ks, mbid, &iov, off, cached);
     if (err) {
         log_errx("off %lx, len %lx, copylen %u, vbufsz %u",
                  err, off, iov.iov_len, copylen, vbufsz);
@@ -1424,7 +1899,8 @@ kvset_lookup_val_direct_decompress(
     void               *vbuf,
     uint                copylen,
     uint                omlen,
-    uint               *outlenp)
+    uint               *outlenp,
+    bool                cached)
 {
     struct iovec iov;
     bool         freeme;
@@ -1449,14 +1925,14 @@ kvset_lookup_val_direct_decompress(
         freeme = true;
     }
 
-    err = mpool_mblock_read(ks->ks_mp, mbid, &iov, 1, off);
+    err = kvset_mblock_read(ks, mbid, &iov, off, cached);
     if (err) {
         log_errx("off %lx, len %lx, copylen %u, omlen %u",
                  err, off, iov.iov_len, copylen, omlen);
     } else {
         src = iov.iov_base + (vboff & ~PAGE_MASK);
 
-        err = compress_lz4_ops.cop_decompress(src, omlen, vbuf, copylen, outlenp);
+        err = vcomp_decompress(src, omlen, vbr_dict(vbd), vbuf, copylen, outlenp);
     }
 
     if (freeme)
@@ -1473,9 +1949,12 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
     merr_t              err;
     void               *src, *dst;
     uint                omlen, copylen;
-    bool direct;
+    bool direct, cached;
 
     assert(vref->vr_type == VTYPE_IVAL
+        || vref->vr_type == VTYPE_LIVAL
+        || vref->vr_type == VTYPE_MVAL
+        || vref->vr_type == VTYPE_CIVAL
         || vref->vr_type == VTYPE_ZVAL
         || vref->vr_type == VTYPE_UCVAL
         || vref->vr_type == VTYPE_CVAL);
@@ -1485,7 +1964,8 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
         return 0;
     }
 
-    if (vref->vr_type == VTYPE_IVAL)
+    if (vref->vr_type == VTYPE_IVAL || vref->vr_type == VTYPE_LIVAL ||
+        vref->vr_type == VTYPE_MVAL || vref->vr_type == VTYPE_CIVAL)
         return kvset_get_immediate_value(vref, vbuf);
 
     vbd = lvx2vbd(ks, vref->vb.vr_index);
@@ -1501,6 +1981,10 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
 
     direct = (copylen >= ks->ks_vmax) && (vbd->vbd_mblkdesc.mclass != HSE_MCLASS_PMEM);
 
+    cached = !direct && ks->ks_bcache && (vbd->vbd_mblkdesc.mclass != HSE_MCLASS_PMEM) &&
+             (ALIGN(vref->vb.vr_off + omlen, PAGE_SIZE) - (vref->vb.vr_off & PAGE_MASK) <=
+              KVSET_BCACHE_VSPAN_MAX);
+
     if (!copylen)
         goto done;
 
@@ -1509,12 +1993,12 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
 
         err = 0;
 
-        if (direct)
+        if (direct || cached)
             err = kvset_lookup_val_direct_decompress(
-                ks, vbd, vref->vb.vr_index, vref->vb.vr_off, dst, copylen, omlen, &outlen);
+                ks, vbd, vref->vb.vr_index, vref->vb.vr_off, dst, copylen, omlen, &outlen, cached);
 
-        if (!direct || err) {
-            err = compress_lz4_ops.cop_decompress(src, omlen, dst, copylen, &outlen);
+        if (!(direct || cached) || err) {
+            err = vcomp_decompress(src, omlen, vbr_dict(vbd), dst, copylen, &outlen);
             if (ev(err))
                 return err;
         }
@@ -1526,9 +2010,10 @@ kvset_lookup_val(struct kvset *ks, struct kvs_vtuple_ref *vref, struct kvs_buf *
         }
 
     } else {
-        if (direct) {
+        if (direct || cached) {
             err = kvset_lookup_val_direct(
-                ks, vbd, vref->vb.vr_index, vref->vb.vr_off, vbuf->b_buf, vbuf->b_buf_sz, copylen);
+                ks, vbd, vref->vb.vr_index, vref->vb.vr_off, vbuf->b_buf, vbuf->b_buf_sz, copylen,
+                cached);
             if (!ev(err))
                 goto done;
 
@@ -1579,6 +2064,10 @@ kvset_pfx_lookup(
     u8          curr_sfx_data[HSE_KVS_KEY_LEN_MAX];
     const void *curr_sfx;
 
+    err = kvset_load(ks);
+    if (ev(err))
+        return err;
+
     key2kobj(&kt_obj, kt->kt_data, kt->kt_len);
 
     err = kvset_ptomb_lookup(ks, kt, seq, res, &vref);
@@ -1588,6 +2077,15 @@ kvset_pfx_lookup(
     if (*res == FOUND_PTMB)
         pt_seq = vref.vr_seq;
 
+    /* Kvsets are searched newest to oldest, so the range tombstones of
+     * this kvset apply to it and to every kvset searched after it.
+     */
+    if (ks->ks_hblk.kh_rtombc > 0) {
+        err = qctx_rtombs_add(qctx, ks->ks_hblk.kh_rtombv, ks->ks_hblk.kh_rtombc, kt, seq);
+        if (ev(err))
+            return err;
+    }
+
     /* Find the relevant wbt and starting kbidx */
     kbidx = kvset_kblk_start(ks, kt->kt_data, -kt->kt_len, 0);
     if (kbidx < 0)
@@ -1608,7 +2106,9 @@ next_kblk:
     if (!bloom_reader_lookup(&kblk->kb_blm_desc, kt->kt_hash))
         goto done;
 
-    wbti_reset(wbti, kblk->kb_kblk_desc.map_base, &kblk->kb_wbt_desc, kt, 0, 0);
+    err = wbti_reset(wbti, kblk->kb_kblk_desc.map_base, &kblk->kb_wbt_desc, kt, 0, 0);
+    if (ev(err))
+        return err;
 
 get_more:
     /* Get next key and set kmd to the base addr for the next keys' metadata */
@@ -1645,7 +2145,7 @@ get_more:
                 /* can't be  a ptomb, b/c they're in their own WBT */
                 assert(vref.vr_type != VTYPE_PTOMB);
                 vref.vr_seq = vseq;
-                if (vref.vr_type == VTYPE_TOMB)
+                if (vref.vr_type == VTYPE_TOMB || kvs_expired(vref.vr_expire))
                     *res = FOUND_TMB;
                 else
                     *res = FOUND_VAL;
@@ -1658,6 +2158,10 @@ get_more:
 
         if (pt_seq && vseq < pt_seq)
             goto get_more; /* key is hidden behind ptomb; skip */
+
+        /* A range tomb hides the key just as a point tomb would */
+        if (*res == FOUND_VAL && vseq < qctx_rtomb_seq(qctx, &kobj, seq))
+            *res = FOUND_TMB;
     }
 
     if (!kobj.ko_sfx_len) {
@@ -1742,7 +2246,12 @@ kvset_lookup(
     if (ev(err))
         return err;
 
-    if (*res != FOUND_VAL)
+    /* The caller needs the seqno of a merge operand to find the
+     * older values to which it applies.
+     */
+    if (*res == FOUND_MRG)
+        kt->kt_seqno = vref.vr_seq;
+    else if (*res != FOUND_VAL)
         return 0;
 
     return kvset_lookup_val(ks, &vref, vbuf);
@@ -1802,6 +2311,9 @@ kvset_set_compc(struct kvset *ks, uint32_t compc)
 uint32_t
 kvset_get_vgroups(const struct kvset *ks)
 {
+    if (!kvset_is_loaded(ks))
+        return ks->ks_summary->ksum_vgroups;
+
     return ks->ks_vgmap ? ks->ks_vgmap->nvgroups : 0;
 }
 
@@ -1829,7 +2341,7 @@ kvset_get_tree(struct kvset *ks)
 u8 *
 kvset_get_hlog(struct kvset *ks)
 {
-    return ks->ks_hlog;
+    return kvset_is_loaded(ks) ? ks->ks_hlog : NULL;
 }
 
 uint64_t
@@ -1877,6 +2389,13 @@ kvset_stats_add(const struct kvset_stats *add, struct kvset_stats *result)
     result->kst_valen += add->kst_valen;
     result->kst_vwlen += add->kst_vwlen;
     result->kst_vulen += add->kst_vulen;
+
+    if (add->kst_ttl_bytes) {
+        result->kst_ttl_bytes += add->kst_ttl_bytes;
+        if (!result->kst_ttl_min || add->kst_ttl_min < result->kst_ttl_min)
+            result->kst_ttl_min = add->kst_ttl_min;
+        result->kst_ttl_max = max_t(u32, result->kst_ttl_max, add->kst_ttl_max);
+    }
 }
 
 u64
@@ -1918,13 +2437,20 @@ kvset_get_num_vblocks(struct kvset *ks)
 u64
 kvset_get_nth_vblock_id(struct kvset *ks, u32 index)
 {
-    return (index < ks->ks_st.kst_vblks ? lvx2mbid(ks, index) : 0);
+    if (index >= ks->ks_st.kst_vblks)
+        return 0;
+
+    return kvset_is_loaded(ks) ? lvx2mbid(ks, index) : ks->ks_vblkidv[index];
 }
 
 u64
 kvset_get_nth_vblock_len(struct kvset *ks, u32 index)
 {
-    struct vblock_desc *vbd = lvx2vbd(ks, index);
+    struct vblock_desc *vbd;
+
+    assert(kvset_is_loaded(ks));
+
+    vbd = lvx2vbd(ks, index);
 
     return vbd ? vbd->vbd_len : 0;
 }
@@ -1932,6 +2458,8 @@ kvset_get_nth_vblock_len(struct kvset *ks, u32 index)
 struct vblock_desc *
 kvset_get_nth_vblock_desc(struct kvset *ks, uint32_t index)
 {
+    assert(kvset_is_loaded(ks));
+
     return lvx2vbd(ks, index);
 }
 
@@ -1955,6 +2483,12 @@ kvset_get_max_key(struct kvset *ks, const void **max_key, uint *max_klen)
         return;
     }
 
+    if (!kvset_is_loaded(ks)) {
+        *max_key = ks->ks_maxkey;
+        *max_klen = ks->ks_maxklen;
+        return;
+    }
+
     kb = &ks->ks_kblks[ks->ks_st.kst_kblks - 1];
     *max_key = kb->kb_koff_max;
     *max_klen = kb->kb_klen_max;
@@ -1977,6 +2511,15 @@ kvset_get_metrics(struct kvset *ks, struct kvset_metrics *m)
     m->vgroups = kvset_get_vgroups(ks);
     m->nptombs = ks->ks_hblk.kh_metrics.hm_nptombs;
 
+    /* Only the kvset's stats are known until it is loaded.
+     */
+    if (!kvset_is_loaded(ks)) {
+        m->num_keys = ks->ks_st.kst_keys;
+        m->num_tombstones = ks->ks_st.kst_tombs;
+        m->tot_vused_bytes = ks->ks_st.kst_vulen;
+        return;
+    }
+
     for (i = 0; i < ks->ks_st.kst_kblks; i++) {
         p = ks->ks_kblks + i;
         m->num_keys += p->kb_metrics.num_keys;
@@ -2051,6 +2594,12 @@ struct kblk_reader {
         uint  kr_ops;
     } iores;
 
+    /* compressed leaf nodes */
+    const struct wbt_desc *kr_wbd;
+    const void            *kr_map_base;
+    void                  *kr_cbuf;
+    size_t                 kr_cbuf_sz;
+
     u64 kr_mbid;
     u16 kr_blk_cnt;
     u16 kr_nodex;
@@ -2152,6 +2701,10 @@ struct kvset_iterator {
     /* For iterating over keys in a work buffer provided by kreader */
     struct wb_pos wbt_reader;
     struct wb_pos pt_reader;
+
+    /* Buffer for values decompressed with a vblock dictionary */
+    void *vdbuf;
+    uint  vdbufsz;
 };
 
 #define handle_to_kvset_iter(_handle) container_of(_handle, struct kvset_iterator, handle)
@@ -2204,6 +2757,59 @@ mbio_wait(struct async_mbio *io, struct cn_merge_stats_ops *stats)
     return err;
 }
 
+/* Read leaf nodes [kr_nodex, kr_nodex + cnt) of a tree with compressed
+ * leaves and decode them into consecutive pages of %node_buf.
+ */
+static merr_t
+kvset_iter_cleaf_read(struct kblk_reader *kr, void *node_buf, uint cnt, size_t *rlen)
+{
+    struct iovec iov;
+    size_t       start, end, off;
+    uint         len, i;
+    merr_t       err;
+
+    err = wbt_leaf_span(kr->kr_map_base, kr->kr_wbd, kr->kr_nodex, &start, &len);
+    if (ev(err))
+        return err;
+
+    err = wbt_leaf_span(kr->kr_map_base, kr->kr_wbd, kr->kr_nodex + cnt - 1, &end, &len);
+    if (ev(err))
+        return err;
+
+    end = PAGE_ALIGN(end + len);
+    start &= PAGE_MASK;
+
+    if (end - start > kr->kr_cbuf_sz) {
+        void *mem = aligned_alloc(PAGE_SIZE, end - start);
+
+        if (ev(!mem))
+            return merr(ENOMEM);
+
+        free(kr->kr_cbuf);
+        kr->kr_cbuf = mem;
+        kr->kr_cbuf_sz = end - start;
+    }
+
+    iov.iov_base = kr->kr_cbuf;
+    iov.iov_len = end - start;
+
+    err = mpool_mblock_read(kr->ds, kr->kr_mbid, &iov, 1, start);
+    if (ev(err))
+        return err;
+
+    *rlen = iov.iov_len;
+
+    for (i = 0; i < cnt; i++) {
+        err = wbt_leaf_span(kr->kr_map_base, kr->kr_wbd, kr->kr_nodex + i, &off, &len);
+        if (!err)
+            err = wbt_leaf_decode(kr->kr_cbuf + off - start, len, node_buf + i * PAGE_SIZE);
+        if (ev(err))
+            return err;
+    }
+
+    return 0;
+}
+
 static void
 kvset_iter_kblock_read(struct work_struct *rock)
 {
@@ -2239,8 +2845,12 @@ kvset_iter_kblock_read(struct work_struct *rock)
     iov.iov_len = node_read_cnt * PAGE_SIZE;
     kblk_off = (kr->kr_node_start_pg + kr->kr_nodex) * PAGE_SIZE;
 
-    rlen = iov.iov_len;
-    err = mpool_mblock_read(kr->ds, kr->kr_mbid, &iov, 1, kblk_off);
+    if (kr->kr_wbd && kr->kr_wbd->wbd_leaf_pgc) {
+        err = kvset_iter_cleaf_read(kr, buf->node_buf, node_read_cnt, &rlen);
+    } else {
+        rlen = iov.iov_len;
+        err = mpool_mblock_read(kr->ds, kr->kr_mbid, &iov, 1, kblk_off);
+    }
     if (ev(err))
         goto done;
 
@@ -2359,11 +2969,13 @@ kblk_start_read(struct kvset_iterator *iter, struct kblk_reader *kr, enum read_t
 
             wbt = &kblk->kb_wbt_desc;
             kr->kr_mbid = kblk->kb_kblk.bk_blkid;
+            kr->kr_map_base = kblk->kb_kblk_desc.map_base;
             break;
         }
         case READ_PT:
             wbt = &iter->ks->ks_hblk.kh_ptree_desc;
             kr->kr_mbid = iter->ks->ks_hblk.kh_hblk.bk_blkid;
+            kr->kr_map_base = iter->ks->ks_hblk.kh_hblk_desc.map_base;
             break;
         }
 
@@ -2371,7 +2983,8 @@ kblk_start_read(struct kvset_iterator *iter, struct kblk_reader *kr, enum read_t
         kr->kr_nodec = wbt->wbd_leaf_cnt;
         kr->kr_kmd_pgc = wbt->wbd_kmd_pgc;
         kr->kr_node_start_pg = wbt->wbd_first_page;
-        kr->kr_kmd_start_pg = (wbt->wbd_first_page + wbt->wbd_root + 1);
+        kr->kr_kmd_start_pg = wbt_kmd_pg(wbt);
+        kr->kr_wbd = wbt;
 
         if (kr->kr_kmd_pgc == 0) {
             kr->kr_eof = true;
@@ -2485,6 +3098,10 @@ kvset_iter_free_buffers(struct kvset_iterator *iter, struct kblk_reader *kr)
     vlb_free(kr->kr_buf[0].kmd_buf, kr->kr_buf[0].kmd_used_sz);
     vlb_free(kr->kr_buf[1].kmd_buf, kr->kr_buf[1].kmd_used_sz);
 
+    free(kr->kr_cbuf);
+    kr->kr_cbuf = NULL;
+    kr->kr_cbuf_sz = 0;
+
     if (iter->vreaders) {
         uint32_t nvgroups = kvset_get_vgroups(iter->ks);
         for (i = 0; i < nvgroups; i++)
@@ -2701,6 +3318,10 @@ kvset_iter_create(
     if (ev(reverse && (io_workq || mblock_read)))
         return merr(EINVAL);
 
+    err = kvset_load(ks);
+    if (ev(err))
+        return err;
+
     iter = kmem_cache_zalloc(kvset_iter_cache);
     if (ev(!iter))
         return merr(ENOMEM);
@@ -2962,8 +3583,13 @@ kvset_iter_seek(struct kv_iterator *handle, const void *key, s32 len, bool *eof)
             wbti_destroy(wbti);
             return err;
         }
-        wbti_reset(pti, ks->ks_hblk.kh_hblk_desc.map_base, &ks->ks_hblk.kh_ptree_desc, &kt_pfx,
-            iter->reverse, 0);
+        err = wbti_reset(pti, ks->ks_hblk.kh_hblk_desc.map_base, &ks->ks_hblk.kh_ptree_desc,
+                         &kt_pfx, iter->reverse, 0);
+        if (ev(err)) {
+            wbti_destroy(wbti);
+            wbti_destroy(pti);
+            return err;
+        }
         iter->pti = pti;
         pti = NULL;
 
@@ -3004,7 +3630,11 @@ kvset_iter_seek(struct kv_iterator *handle, const void *key, s32 len, bool *eof)
     if (!iter->wbti_meta.eof) {
         if (!wbti)
             err = wbti_alloc(&wbti);
+        if (!err)
+            err = wbti_reset(wbti, kblk->kb_kblk_desc.map_base, &kblk->kb_wbt_desc, &kt,
+                             iter->reverse, 0);
         if (ev(err)) {
+            wbti_destroy(wbti);
             if (pti) {
                 assert(iter->pti == NULL);
                 wbti_destroy(pti);
@@ -3014,7 +3644,6 @@ kvset_iter_seek(struct kv_iterator *handle, const void *key, s32 len, bool *eof)
             }
             return err;
         }
-        wbti_reset(wbti, kblk->kb_kblk_desc.map_base, &kblk->kb_wbt_desc, &kt, iter->reverse, 0);
         iter->wbti = wbti;
         wbti = NULL;
     }
@@ -3370,7 +3999,7 @@ kvset_iter_next_vref(
     if (vc->next >= vc->nvals)
         return false;
 
-    kmd_type_seq(vc->kmd, &vc->off, vtype, seq);
+    kmd_type_seq_expire(vc->kmd, &vc->off, vtype, seq, &vc->expire);
     switch (*vtype) {
         case VTYPE_UCVAL:
             kmd_val(vc->kmd, &vc->off, vbidx, vboff, vlen);
@@ -3381,6 +4010,15 @@ kvset_iter_next_vref(
         case VTYPE_IVAL:
             kmd_ival(vc->kmd, &vc->off, vdata, vlen);
             break;
+        case VTYPE_LIVAL:
+            kmd_lival(vc->kmd, &vc->off, vdata, vlen);
+            break;
+        case VTYPE_MVAL:
+            kmd_mval(vc->kmd, &vc->off, vdata, vlen);
+            break;
+        case VTYPE_CIVAL:
+            kmd_cival(vc->kmd, &vc->off, vdata, vlen, complen);
+            break;
         case VTYPE_ZVAL:
         case VTYPE_TOMB:
         case VTYPE_PTOMB:
@@ -3581,6 +4219,47 @@ kvset_iter_get_valptr(
     return 0;
 }
 
+/* Values compressed with a vblock's dictionary cannot be decompressed by
+ * consumers of the iterator (e.g., cursors and compaction), which have no
+ * access to the dictionary.  Hence they are returned uncompressed.
+ */
+static merr_t
+kvset_iter_dict_decompress(
+    struct kv_iterator *handle,
+    uint                vbidx,
+    const void **       vdata,
+    uint                vlen,
+    uint *              complen)
+{
+    struct kvset_iterator *iter = handle_to_kvset_iter(handle);
+    uint                   outlen;
+    merr_t                 err;
+
+    if (iter->vdbufsz < vlen) {
+        free(iter->vdbuf);
+
+        iter->vdbufsz = max_t(uint, vlen, VCOMP_DICT_VLEN_MAX);
+        iter->vdbuf = malloc(iter->vdbufsz);
+        if (ev(!iter->vdbuf)) {
+            iter->vdbufsz = 0;
+            return merr(ENOMEM);
+        }
+    }
+
+    err = vcomp_decompress(*vdata, *complen, vbr_dict(lvx2vbd(iter->ks, vbidx)),
+                           iter->vdbuf, vlen, &outlen);
+    if (ev(err))
+        return err;
+
+    if (ev(outlen != vlen))
+        return merr(EBUG);
+
+    *vdata = iter->vdbuf;
+    *complen = 0;
+
+    return 0;
+}
+
 merr_t
 kvset_iter_val_get(
     struct kv_iterator *    handle,
@@ -3595,8 +4274,15 @@ kvset_iter_val_get(
     switch (vtype) {
         case VTYPE_UCVAL:
             return kvset_iter_get_valptr(handle, vbidx, vboff, *vlen, vdata);
-        case VTYPE_CVAL:
-            return kvset_iter_get_valptr(handle, vbidx, vboff, *complen, vdata);
+        case VTYPE_CVAL: {
+            merr_t err;
+
+            err = kvset_iter_get_valptr(handle, vbidx, vboff, *complen, vdata);
+            if (!err && HSE_UNLIKELY(vcomp_dict_tagged(*vdata)))
+                err = kvset_iter_dict_decompress(handle, vbidx, vdata, *vlen, complen);
+
+            return err;
+        }
         case VTYPE_ZVAL:
             *vdata = 0;
             *vlen = 0;
@@ -3613,10 +4299,16 @@ kvset_iter_val_get(
             *complen = 0;
             return 0;
         case VTYPE_IVAL:
+        case VTYPE_LIVAL:
+        case VTYPE_MVAL:
             assert(*vdata);
             assert(*vlen);
             *complen = 0;
             return 0;
+        case VTYPE_CIVAL:
+            assert(*vdata);
+            assert(*vlen && *complen);
+            return 0;
     }
 
     /* BUG! */
@@ -3640,7 +4332,7 @@ kvset_iter_next_val_direct(
     vbd = lvx2vbd(iter->ks, vbidx);
     assert(vbd);
 
-    return kvset_lookup_val_direct(iter->ks, vbd, vbidx, vboff, vdata, bufsz, vlen);
+    return kvset_lookup_val_direct(iter->ks, vbd, vbidx, vboff, vdata, bufsz, vlen, false);
 }
 
 void
@@ -3687,6 +4379,8 @@ kvset_iter_release(struct kv_iterator *handle)
     kvset_iter_free_buffers(iter, &iter->kreader);
     kvset_iter_free_buffers(iter, &iter->ptreader);
 
+    free(iter->vdbuf);
+
     kvset_put_ref(iter->ks);
     kmem_cache_free(kvset_iter_cache, iter);
 }
@@ -19,6 +19,7 @@
 #include <hse_ikvdb/cndb.h>
 
 #include "blk_list.h"
+#include "cn_metrics.h"
 #include "kv_iterator.h"
 
 struct kvset;
@@ -35,10 +36,16 @@ struct cn_kvdb;
 struct cn_tree;
 struct cn_merge_stats;
 struct kvset_stats;
+struct bloom_filter;
+struct kvs_rtomb;
 
+/* le_nbgen is the generation of the node bloom (if any) that covers this
+ * kvset, see node_bloom.h.
+ */
 struct kvset_list_entry {
     struct list_head le_link;
     struct kvset *   le_kvset;
+    uint64_t         le_nbgen;
 };
 
 enum kvset_iter_flags {
@@ -60,6 +67,7 @@ enum kvset_iter_flags {
  * @km_rule:        compaction rule ID that created this kvset
  * @km_capped:      cn is capped
  * @km_restored:    kvset is being restored from the cndb
+ * @km_summary:     kvset summary recorded in the cndb (if any)
  *
  * This structure is passed between the MDC and kvset_open().
  */
@@ -75,8 +83,42 @@ struct kvset_meta {
     uint16_t        km_rule;
     bool            km_capped;
     bool            km_restored;
+
+    const struct kvset_summary *km_summary;
+};
+
+/**
+ * struct kvset_summary - kvset metadata cached in the cndb
+ * @ksum_seqno_min: min seqno of all entries in the kvset
+ * @ksum_seqno_max: max seqno of all entries in the kvset
+ * @ksum_st:        kvset stats
+ * @ksum_vgroups:   number of vgroups
+ * @ksum_minklen:   length of the kvset's min key
+ * @ksum_maxklen:   length of the kvset's max key
+ * @ksum_keyv:      min key immediately followed by the max key
+ *
+ * A summary holds what kvset_open() otherwise learns by reading the kvset's
+ * hblock and kblock headers, enough to place the kvset in the cn tree and
+ * to schedule compactions without mapping any of its mblocks.  Summaries
+ * are recorded with cndb_record_kvset_summary() and written to the cndb
+ * mdc whenever it is compacted.
+ */
+struct kvset_summary {
+    uint64_t           ksum_seqno_min;
+    uint64_t           ksum_seqno_max;
+    struct kvset_stats ksum_st;
+    uint32_t           ksum_vgroups;
+    uint16_t           ksum_minklen;
+    uint16_t           ksum_maxklen;
+    uint8_t            ksum_keyv[];
 };
 
+static inline size_t
+kvset_summary_size(uint minklen, uint maxklen)
+{
+    return sizeof(struct kvset_summary) + minklen + maxklen;
+}
+
 enum {
     KVSET_MISS_KEY_TOO_SMALL = -1,
     KVSET_MISS_KEY_TOO_LARGE = -2,
@@ -247,6 +289,24 @@ kvset_open2(
     struct mbset ***   vbset_vecs,
     struct kvset **    kvset);
 
+/**
+ * kvset_load() - map the blocks of a lazily opened kvset
+ * @ks: kvset
+ *
+ * With the cn_kvset_lazy_open rparam set, a kvset restored from the cndb
+ * with a summary is opened knowing only its key range, seqno range and
+ * stats.  Its hblock, kblocks and vblocks are mapped by the first lookup,
+ * iterator or compaction that needs them.  Returns immediately if the
+ * kvset is already loaded.
+ */
+/* MTF_MOCK */
+merr_t
+kvset_load(struct kvset *ks);
+
+/* MTF_MOCK */
+bool
+kvset_is_loaded(const struct kvset *ks);
+
 /* MTF_MOCK */
 merr_t
 kvset_delete_log_record(struct kvset *ks, struct cndb_txn *txn);
@@ -291,9 +351,44 @@ kvset_get_max_key(struct kvset *ks, const void **max_key, uint *max_klen);
 u64
 kvset_ctime(const struct kvset *kvset);
 
+/* MTF_MOCK */
 bool
 kvset_has_ptree(const struct kvset *ks) HSE_NONNULL(1);
 
+/**
+ * kvset_get_rtombs() - get the range tombstones of a kvset
+ * @ks:  kvset
+ * @rtc: (output) number of range tombstones
+ *
+ * The returned vector and its keys remain valid until the kvset's
+ * last reference is released.
+ */
+/* MTF_MOCK */
+const struct kvs_rtomb *
+kvset_get_rtombs(const struct kvset *ks, uint *rtc) HSE_NONNULL(1, 2);
+
+static inline bool
+kvset_has_rtombs(const struct kvset *ks)
+{
+    uint rtc;
+
+    kvset_get_rtombs(ks, &rtc);
+
+    return rtc > 0;
+}
+
+/**
+ * kvset_bloom_insert() - insert the hash of every key in a kvset into a bloom filter
+ * @ks: kvset handle
+ * @bf: bloom filter
+ *
+ * Walks the wbtree of each kblock, so the cost is proportional to the
+ * number of keys in the kvset.  Prefix tombstones are not inserted.
+ */
+/* MTF_MOCK */
+merr_t
+kvset_bloom_insert(struct kvset *ks, struct bloom_filter *bf);
+
 /**
  * kvset_kblk_start() - return index of kblock where this key may reside
  * @kvset:   kvset to search
@@ -373,6 +468,8 @@ kvset_set_workid(struct kvset *km, u64 id);
 
 /**
  * kvset_get_nth_vblock_len() - Get len of useful data in nth vblock
+ *
+ * The kvset must be loaded, see kvset_load().
  */
 /* MTF_MOCK */
 u64
@@ -416,6 +513,7 @@ kvset_get_vwlen(const struct kvset *ks);
 struct cn_tree *
 kvset_get_tree(struct kvset *kvset);
 
+/* The kvset must be loaded, see kvset_load() */
 struct vblock_desc *
 kvset_get_nth_vblock_desc(struct kvset *ks, uint32_t index);
 
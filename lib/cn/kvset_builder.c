@@ -10,11 +10,14 @@
 #include <hse_util/slab.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/bonsai_tree.h>
+#include <hse_util/hlog.h>
 
 #include <hse_ikvdb/kvset_builder.h>
 #include <hse_ikvdb/key_hash.h>
 #include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/kvs_cparams.h>
+#include <hse_ikvdb/vcomp_params.h>
 
 #include <hse/limits.h>
 
@@ -36,6 +39,7 @@ kvset_builder_create(
     struct perfc_set *     pc,
     u64                    vgroup)
 {
+    const struct kvs_cparams *cp;
     struct kvset_builder *bld;
     merr_t err;
 
@@ -58,6 +62,9 @@ kvset_builder_create(
         goto out;
 
     bld->cn = cn;
+    cp = cn_get_cparams(cn);
+    bld->vinline = min_t(uint, cp->vinline_len, CN_INLINE_VALUE_LEN_MAX);
+    bld->vbidx_max = HG16_32K_MAX + 1;
     bld->seqno_prev = UINT64_MAX;
     bld->seqno_prev_ptomb = UINT64_MAX;
 
@@ -77,7 +84,7 @@ static int
 reserve_kmd(struct kmd_info *ki)
 {
     uint initial = 16*1024;
-    uint need = 256;
+    uint need = 256 + CN_INLINE_VALUE_LEN_MAX;
     uint min_size = ki->kmd_used + need;
     uint new_size;
     u8 * new_mem;
@@ -143,6 +150,9 @@ kvset_builder_add_key(struct kvset_builder *self, const struct key_obj *kobj)
     self->key_stats.tot_vlen = 0;
     self->key_stats.tot_vused = 0;
     self->key_stats.nptombs = 0;
+    self->key_stats.ttl_bytes = 0;
+    self->key_stats.ttl_min = 0;
+    self->key_stats.ttl_max = 0;
 
     self->kblk_kmd.kmd_used = 0;
     self->hblk_kmd.kmd_used = 0;
@@ -153,6 +163,28 @@ kvset_builder_add_key(struct kvset_builder *self, const struct key_obj *kobj)
     return ev(err);
 }
 
+/* Consume the expiry time set by kvset_builder_set_expire(), if any, by
+ * prefixing the next kmd entry with an expiry record.
+ */
+static void
+kvset_builder_add_expire(struct kvset_builder *self, uint omlen)
+{
+    struct key_stats *ks = &self->key_stats;
+    u32 expire = self->expire;
+
+    if (!expire)
+        return;
+
+    kmd_add_expire(self->kblk_kmd.kmd, &self->kblk_kmd.kmd_used, expire);
+
+    ks->ttl_bytes += omlen;
+    if (!ks->ttl_min || expire < ks->ttl_min)
+        ks->ttl_min = expire;
+    ks->ttl_max = max_t(u32, ks->ttl_max, expire);
+
+    self->expire = 0;
+}
+
 /**
  * kvset_builder_add_val() - Add a value or a tombstone to a kvset entry.
  * @builder: Kvset builder object.
@@ -168,6 +200,9 @@ kvset_builder_add_key(struct kvset_builder *self, const struct key_obj *kobj)
  * - If @complen > 0, then the value is already compressed and will be
  *   stored on media as is (even if compression is not enabled for this
  *   kvset).
+ * - Values whose on-media length does not exceed the kvs "value.inline_length"
+ *   cparam are stored in the kblock KMD rather than in a vblock, which saves
+ *   a vblock read per get.  Dictionary compressed values always go to a vblock.
  *
  * Special cases for tombstones:
  *  - If @vdata == %HSE_CORE_TOMB_PFX, then a prefix tombstone is added
@@ -193,6 +228,11 @@ kvset_builder_add_val(
     if (ev(reserve_kmd(ki)))
         return merr(ENOMEM);
 
+    if (HSE_CORE_IS_TOMB(vdata))
+        self->expire = 0;
+    else
+        kvset_builder_add_expire(self, complen ? complen : vlen);
+
     if (vdata == HSE_CORE_TOMB_REG) {
         kmd_add_tomb(self->kblk_kmd.kmd, &self->kblk_kmd.kmd_used, seq);
         self->key_stats.ntombs++;
@@ -202,12 +242,18 @@ kvset_builder_add_val(
         self->last_ptseq = seq;
     } else if (!vdata || vlen == 0) {
         kmd_add_zval(self->kblk_kmd.kmd, &self->kblk_kmd.kmd_used, seq);
-    } else if (complen == 0 && vlen <= CN_SMALL_VALUE_THRESHOLD) {
-        /* Do not currently support compressed valus in KMD as an "ival", so
-         * complen must be zero.
-         */
-        kmd_add_ival(self->kblk_kmd.kmd, &self->kblk_kmd.kmd_used, seq, vdata, vlen);
+    } else if (complen == 0 && vlen <= self->vinline) {
+        if (vlen <= U8_MAX)
+            kmd_add_ival(self->kblk_kmd.kmd, &self->kblk_kmd.kmd_used, seq, vdata, vlen);
+        else
+            kmd_add_lival(self->kblk_kmd.kmd, &self->kblk_kmd.kmd_used, seq, vdata, vlen);
         self->key_stats.tot_vlen += vlen;
+    } else if (complen > 0 && complen <= self->vinline && !vcomp_dict_tagged(vdata)) {
+        /* Dictionary compressed values cannot be stored in the kmd as
+         * the dictionary lives in the vblock.
+         */
+        kmd_add_cival(self->kblk_kmd.kmd, &self->kblk_kmd.kmd_used, seq, vdata, vlen, complen);
+        self->key_stats.tot_vlen += complen;
     } else {
 
         uint vbidx = 0, vboff = 0;
@@ -224,6 +270,11 @@ kvset_builder_add_val(
         if (ev(err))
             return err;
 
+        if (ev(vbidx >= self->vbidx_max))
+            return merr(EFBIG);
+
+        vbidx += self->vbidx_base;
+
         if (complen)
             kmd_add_cval(self->kblk_kmd.kmd, &self->kblk_kmd.kmd_used, seq, vbidx, vboff, vlen, complen);
         else
@@ -275,6 +326,8 @@ kvset_builder_add_vref(
     if (reserve_kmd(&self->kblk_kmd))
         return merr(ev(ENOMEM));
 
+    kvset_builder_add_expire(self, om_len);
+
     if (complen > 0)
         kmd_add_cval(self->kblk_kmd.kmd, &self->kblk_kmd.kmd_used, seq, vbidx, vboff, vlen, complen);
     else
@@ -291,6 +344,37 @@ kvset_builder_add_vref(
     return 0;
 }
 
+/* Merge operands are always stored in the kblock regardless of the
+ * kvs value.inline_length cparam, so that they never need a vblock read.
+ */
+static_assert(HSE_KVS_MERGE_OPERAND_LEN_MAX <= CN_INLINE_VALUE_LEN_MAX,
+              "merge operands must fit in reserve_kmd()");
+
+/**
+ * kvset_builder_add_mval() - add a VTYPE_MVAL (merge operand) entry to a kvset
+ */
+merr_t
+kvset_builder_add_mval(struct kvset_builder *self, u64 seq, const void *vdata, uint vlen)
+{
+    if (ev(vlen == 0 || vlen > HSE_KVS_MERGE_OPERAND_LEN_MAX))
+        return merr(EINVAL);
+
+    if (reserve_kmd(&self->kblk_kmd))
+        return merr(ev(ENOMEM));
+
+    kvset_builder_add_expire(self, vlen);
+
+    kmd_add_mval(self->kblk_kmd.kmd, &self->kblk_kmd.kmd_used, seq, vdata, vlen);
+
+    self->key_stats.tot_vlen += vlen;
+    self->key_stats.nvals++;
+
+    self->seqno_max = max_t(u64, self->seqno_max, seq);
+    self->seqno_min = min_t(u64, self->seqno_min, seq);
+
+    return 0;
+}
+
 merr_t
 kvset_builder_add_nonval(struct kvset_builder *self, u64 seq, enum kmd_vtype vtype)
 {
@@ -299,6 +383,8 @@ kvset_builder_add_nonval(struct kvset_builder *self, u64 seq, enum kmd_vtype vty
     if (reserve_kmd(ki))
         return merr(ev(ENOMEM));
 
+    self->expire = 0;
+
     assert(vtype != VTYPE_ZVAL);
     if (vtype == VTYPE_TOMB) {
         kmd_add_tomb(self->kblk_kmd.kmd, &self->kblk_kmd.kmd_used, seq);
@@ -317,6 +403,21 @@ kvset_builder_add_nonval(struct kvset_builder *self, u64 seq, enum kmd_vtype vty
     return 0;
 }
 
+merr_t
+kvset_builder_add_rtomb(struct kvset_builder *self, const struct kvs_rtomb *rt)
+{
+    merr_t err;
+
+    err = hbb_add_rtomb(self->hbb, rt);
+    if (ev(err))
+        return err;
+
+    self->seqno_max = max_t(u64, self->seqno_max, rt->kr_seq);
+    self->seqno_min = min_t(u64, self->seqno_min, rt->kr_seq);
+
+    return 0;
+}
+
 void
 kvset_builder_adopt_vblocks(
     struct kvset_builder *self,
@@ -495,6 +596,153 @@ kvset_builder_get_mblocks(struct kvset_builder *self, struct kvset_mblocks *mblk
     return 0;
 }
 
+merr_t
+kvset_builder_get_mblocks_concat(
+    struct kvset_builder **bldv,
+    uint                   bldc,
+    struct kvset_mblocks  *mblks)
+{
+    struct kvset_builder *head = bldv[0];
+    struct blk_list kblks, vblks;
+    struct vgmap *vgmap = NULL;
+    struct hlog *hlog = NULL;
+    uint64_t seqno_min = UINT64_MAX, seqno_max = 0, vused = 0;
+    uint32_t nvgroups = 0, vgidx = 0, vbidx_out = 0;
+    merr_t err;
+
+    INVARIANT(bldc > 0);
+
+    blk_list_init(&kblks);
+    blk_list_init(&vblks);
+
+    for (uint i = 0; i < bldc; i++) {
+        struct kvset_builder *bld = bldv[i];
+
+        /* Only the head builder may carry hblock content (ptombs, rtombs),
+         * and none may have adopted vblocks.
+         */
+        assert(i == 0 || (!hbb_get_nptombs(bld->hbb) && !hbb_get_nrtombs(bld->hbb)));
+        assert(bld->vblk_list.n_blks == 0 && !bld->vgmap);
+
+        if (!kbb_is_empty(bld->kbb)) {
+            struct key_obj min_kobj = { 0 }, max_kobj = { 0 };
+
+            kbb_curr_kblk_min_max_keys(bld->kbb, &min_kobj, &max_kobj);
+
+            err = vbb_finish(bld->vbb, &bld->vblk_list, &max_kobj);
+            if (err)
+                goto out;
+        } else {
+            vbb_destroy(bld->vbb);
+            bld->vbb = NULL;
+        }
+
+        err = kbb_finish(bld->kbb, &bld->kblk_list);
+        if (err)
+            goto out;
+
+        if (bld->vblk_list.n_blks > 0)
+            nvgroups++;
+    }
+
+    if (nvgroups > 0) {
+        vgmap = vgmap_alloc(nvgroups);
+        if (ev(!vgmap)) {
+            err = merr(ENOMEM);
+            goto out;
+        }
+    }
+
+    err = hlog_create(&hlog, HLOG_PRECISION);
+    if (ev(err))
+        goto out;
+
+    /* Each builder's vblocks form a vgroup.  The kblocks of a builder
+     * record vblock indexes relative to its vbidx_base, which the vgroup
+     * map translates to indexes in the concatenated vblock list.
+     */
+    for (uint i = 0; i < bldc; i++) {
+        struct kvset_builder *bld = bldv[i];
+        uint32_t nvblks = bld->vblk_list.n_blks;
+
+        for (uint32_t j = 0; j < bld->kblk_list.n_blks; j++) {
+            err = blk_list_append(&kblks, bld->kblk_list.blks[j].bk_blkid);
+            if (ev(err))
+                goto out;
+        }
+
+        for (uint32_t j = 0; j < nvblks; j++) {
+            err = blk_list_append(&vblks, bld->vblk_list.blks[j].bk_blkid);
+            if (ev(err))
+                goto out;
+        }
+
+        if (nvblks > 0) {
+            vbidx_out += nvblks;
+            assert(bld->vbidx_base + nvblks >= vbidx_out);
+
+            err = vgmap_vbidx_set(NULL, bld->vbidx_base + nvblks - 1, vgmap, vbidx_out - 1, vgidx++);
+            if (ev(err))
+                goto out;
+        }
+
+        if (bld->kblk_list.n_blks > 0)
+            hlog_union(hlog, kbb_get_composite_hlog(bld->kbb));
+
+        seqno_min = min_t(uint64_t, seqno_min, bld->seqno_min);
+        seqno_max = max_t(uint64_t, seqno_max, bld->seqno_max);
+        vused += bld->vused;
+    }
+
+    err = hbb_finish(head->hbb, &head->hblk, vgmap, NULL, NULL, seqno_min, seqno_max,
+                     kblks.n_blks, vblks.n_blks, hbb_get_nptombs(head->hbb), hlog_data(hlog),
+                     NULL, NULL, 0);
+    if (err)
+        goto out;
+
+    /* The concatenated lists now own the kblock and vblock ids.
+     */
+    for (uint i = 0; i < bldc; i++) {
+        blk_list_free(&bldv[i]->kblk_list);
+        blk_list_free(&bldv[i]->vblk_list);
+    }
+
+    mblks->hblk = head->hblk;
+    head->hblk.bk_blkid = 0;
+
+    mblks->kblks = kblks;
+    mblks->vblks = vblks;
+    blk_list_init(&kblks);
+    blk_list_init(&vblks);
+
+    mblks->bl_vused = vused;
+    mblks->bl_seqno_max = seqno_max;
+    mblks->bl_seqno_min = seqno_min;
+
+out:
+    blk_list_free(&kblks);
+    blk_list_free(&vblks);
+    hlog_destroy(hlog);
+    vgmap_free(vgmap);
+
+    return err;
+}
+
+void
+kvset_builder_set_vbidx(struct kvset_builder *self, uint base, uint max)
+{
+    INVARIANT(base + max <= HG16_32K_MAX + 1);
+
+    self->vbidx_base = base;
+    self->vbidx_max = max;
+}
+
+void
+kvset_builder_set_expire(struct kvset_builder *self, u32 expire)
+{
+    self->expire = expire;
+}
+
 void
 kvset_builder_set_agegroup(struct kvset_builder *self, enum hse_mclass_policy_age age)
 {
@@ -512,6 +760,19 @@ kvset_builder_set_merge_stats(struct kvset_builder *self, struct cn_merge_stats
     vbb_set_merge_stats(self->vbb, stats);
 }
 
+void
+kvset_builder_set_wq(struct kvset_builder *self, struct workqueue_struct *wq)
+{
+    kbb_set_wq(self->kbb, wq);
+    vbb_set_wq(self->vbb, wq);
+}
+
+merr_t
+kvset_builder_set_vdict(struct kvset_builder *self, const void *dict, uint dictlen)
+{
+    return vbb_set_dict(self->vbb, dict, dictlen);
+}
+
 #if HSE_MOCKING
 #include "kvset_builder_ut_impl.i"
 #endif /* HSE_MOCKING */
@@ -52,6 +52,10 @@ struct kvset_builder {
     uint64_t seqno_max; // max seqno present in new kvset
     uint64_t seqno_min; // min seqno present in new kvset
     uint64_t vused;     // sum of len of all values in new kvset
+    uint32_t vinline;   // max on-media len of values stored in kmd
+    uint32_t vbidx_base; // vblock index recorded for the first vblock
+    uint32_t vbidx_max;  // max number of vblocks
+    uint32_t expire;    // expiry time of the next value (zero if none)
 
     uint64_t seqno_prev;       // for sanity checks while building kvsets
     uint64_t seqno_prev_ptomb; // for sanity checks while building kvsets
@@ -10,6 +10,7 @@
 #include <hse_util/inttypes.h>
 #include <hse_util/list.h>
 #include <hse_util/atomic.h>
+#include <hse_util/mutex.h>
 #include <hse_util/workqueue.h>
 #include <hse_util/key_util.h>
 
@@ -17,6 +18,7 @@
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/omf_kmd.h>
 #include <hse_ikvdb/kvset_view.h>
+#include <hse_ikvdb/kvs_rtomb.h>
 
 #include <mpool/mpool.h>
 
@@ -46,6 +48,9 @@ struct kvset_hblk {
     uint64_t kh_seqno_min; /* min seqno */
     uint64_t kh_seqno_max; /* max seqno */
 
+    struct kvs_rtomb *kh_rtombv; /* range tombstones (keys ref the hblock map) */
+    uint32_t kh_rtombc;
+
     struct hblk_metrics kh_metrics;
     struct kvs_block kh_hblk;
 };
@@ -81,6 +86,7 @@ struct kvset {
     u64           ks_nodeid;
     u32           ks_vmin;
     u32           ks_vmax;
+    bool          ks_bcache;  /* use mpool block cache for point lookups */
     uint64_t      ks_vra_len;
     uint32_t      ks_compc;
 
@@ -135,6 +141,12 @@ struct kvset {
     size_t     ks_kvset_sz;
     u64        ks_ctime;
 
+    /* Lazy open (see kvset_load()) */
+    struct mutex          ks_load_lock;
+    atomic_int            ks_loaded;
+    struct kvset_summary *ks_summary; /* summary a lazy kvset was opened from */
+    u64                  *ks_vblkidv; /* vblock IDs of a lazy kvset */
+
     struct blk_list ks_purge; /* used by kvset split */
 
     struct kvset_kblk ks_kblks[] HSE_L1D_ALIGNED;
@@ -159,7 +159,7 @@ kblock_copy_range(
 
         while (nvals--) {
             struct kvs_vtuple_ref vref = { 0 };
-            uint64_t vseq, omlen;
+            uint64_t vseq, omlen, tot_vlen = stats.tot_vlen;
 
             /* Pass NULL for vgmap as vbidx is not used here */
             wbt_read_kmd_vref(kmd, NULL, &off, &vseq, &vref);
@@ -174,9 +174,15 @@ kblock_copy_range(
                 break;
 
             case VTYPE_IVAL:
+            case VTYPE_LIVAL:
+            case VTYPE_MVAL:
                 stats.tot_vlen += vref.vi.vr_len;
                 break;
 
+            case VTYPE_CIVAL:
+                stats.tot_vlen += vref.vi.vr_complen;
+                break;
+
             case VTYPE_TOMB:
                 ++stats.ntombs;
                 break;
@@ -187,6 +193,16 @@ kblock_copy_range(
             case VTYPE_PTOMB:
                 abort();
             }
+
+            /* Expiry records are copied along with the kmd, so just
+             * account for them here.
+             */
+            if (vref.vr_expire) {
+                stats.ttl_bytes += stats.tot_vlen - tot_vlen;
+                if (!stats.ttl_min || vref.vr_expire < stats.ttl_min)
+                    stats.ttl_min = vref.vr_expire;
+                stats.ttl_max = max_t(uint32_t, stats.ttl_max, vref.vr_expire);
+            }
         }
 
         err = kbb_add_entry(kbb, &cur, kmd + kmd_cnt_off, off - kmd_cnt_off, &stats);
@@ -593,6 +609,8 @@ vblocks_split(
  * The hblock is rewritten in the left and the right kvsets by duplicating the following
  * fields from the hblock in the source kvset:
  *   - min/max seqno, min/max prefix, ptomb tree and its related fields
+ *   - range tombstones (copied to both halves, which is conservative but never
+ *     exposes a value hidden by a range tombstone)
  *
  * The following fields are regenerated for the left and the right kvsets:
  *   - hlog and vgroup map
@@ -607,7 +625,7 @@ hblock_split(
     struct key_obj min_pfx = { 0 }, max_pfx = { 0 };
     struct kvset_mblocks *blks_left = result->ks[LEFT].blks;
     struct kvset_mblocks *blks_right = result->ks[RIGHT].blks;
-    uint32_t num_ptombs, ptree_pgc;
+    uint32_t num_ptombs, ptree_pgc, num_rtombs;
     uint64_t min_seqno, max_seqno;
     uint8_t *ptree;
     merr_t err = 0;
@@ -615,6 +633,7 @@ hblock_split(
     min_seqno = ks->ks_hblk.kh_seqno_min;
     max_seqno = ks->ks_hblk.kh_seqno_max;
     num_ptombs = ks->ks_hblk.kh_metrics.hm_nptombs;
+    num_rtombs = ks->ks_hblk.kh_rtombc;
 
     key2kobj(&min_pfx, ks->ks_hblk.kh_pfx_min, ks->ks_hblk.kh_pfx_min_len);
     key2kobj(&max_pfx, ks->ks_hblk.kh_pfx_max, ks->ks_hblk.kh_pfx_max_len);
@@ -623,10 +642,20 @@ hblock_split(
     if (ptree_pgc == 0)
         ptree = NULL;
 
+    for (uint32_t i = 0; i < num_rtombs; i++) {
+        const struct kvs_rtomb *rt = ks->ks_hblk.kh_rtombv + i;
+
+        err = hbb_add_rtomb(work[LEFT].hbb, rt);
+        if (!err)
+            err = hbb_add_rtomb(work[RIGHT].hbb, rt);
+        if (err)
+            return err;
+    }
+
     /* Add both the left and the right hblock to the commit list and add the source hblock
      * to the purge list.
      */
-    if (blks_left->kblks.n_blks > 0 || ptree) {
+    if (blks_left->kblks.n_blks > 0 || ptree || num_rtombs > 0) {
         hblk.bk_blkid = 0;
         err = hbb_finish(work[LEFT].hbb, &hblk, work[LEFT].vgmap, &min_pfx, &max_pfx,
                          min_seqno, max_seqno, blks_left->kblks.n_blks, blks_left->vblks.n_blks,
@@ -639,7 +668,7 @@ hblock_split(
         }
     }
 
-    if (!err && (blks_right->kblks.n_blks > 0 || ptree)) {
+    if (!err && (blks_right->kblks.n_blks > 0 || ptree || num_rtombs > 0)) {
         hblk.bk_blkid = 0;
         err = hbb_finish(work[RIGHT].hbb, &hblk, work[RIGHT].vgmap, &min_pfx, &max_pfx,
                          min_seqno, max_seqno, blks_right->kblks.n_blks, blks_right->vblks.n_blks,
@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <string.h>
+
+#include <hse_util/base.h>
+#include <hse_util/assert.h>
+#include <hse_util/event_counter.h>
+
+#include "mblk_aio.h"
+
+static void
+mblk_aio_worker(struct work_struct *work)
+{
+    struct mblk_aio *aio = container_of(work, struct mblk_aio, ma_work);
+    merr_t err;
+
+    err = aio->ma_func(aio->ma_arg);
+
+    mutex_lock(&aio->ma_lock);
+    if (err && !aio->ma_err)
+        aio->ma_err = err;
+    aio->ma_busy = false;
+    cv_signal(&aio->ma_cv);
+    mutex_unlock(&aio->ma_lock);
+}
+
+void
+mblk_aio_init(struct mblk_aio *aio, struct workqueue_struct *wq)
+{
+    INVARIANT(aio);
+
+    memset(aio, 0, sizeof(*aio));
+    INIT_WORK(&aio->ma_work, mblk_aio_worker);
+    mutex_init(&aio->ma_lock);
+    cv_init(&aio->ma_cv);
+    aio->ma_wq = wq;
+}
+
+void
+mblk_aio_fini(struct mblk_aio *aio)
+{
+    if (!aio)
+        return;
+
+    mblk_aio_wait(aio);
+
+    cv_destroy(&aio->ma_cv);
+    mutex_destroy(&aio->ma_lock);
+}
+
+merr_t
+mblk_aio_wait(struct mblk_aio *aio)
+{
+    merr_t err;
+
+    if (!aio->ma_wq)
+        return aio->ma_err;
+
+    mutex_lock(&aio->ma_lock);
+    while (aio->ma_busy)
+        cv_wait(&aio->ma_cv, &aio->ma_lock, "mblkaio");
+    err = aio->ma_err;
+    mutex_unlock(&aio->ma_lock);
+
+    return err;
+}
+
+merr_t
+mblk_aio_submit(struct mblk_aio *aio, mblk_aio_func_t *func, void *arg)
+{
+    merr_t err;
+
+    INVARIANT(func);
+
+    err = mblk_aio_wait(aio);
+    if (err)
+        return err;
+
+    if (!aio->ma_wq)
+        return func(arg);
+
+    aio->ma_func = func;
+    aio->ma_arg = arg;
+
+    mutex_lock(&aio->ma_lock);
+    aio->ma_busy = true;
+    mutex_unlock(&aio->ma_lock);
+
+    /* The work item is idle, so queue_work() cannot fail.  Should it
+     * ever do so, perform the write synchronously so that the caller
+     * can rely on func having been called.
+     */
+    if (ev(!queue_work(aio->ma_wq, &aio->ma_work))) {
+        assert(0);
+
+        mutex_lock(&aio->ma_lock);
+        aio->ma_busy = false;
+        mutex_unlock(&aio->ma_lock);
+
+        return func(arg);
+    }
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_KVS_CN_MBLK_AIO_H
+#define HSE_KVS_CN_MBLK_AIO_H
+
+#include <stdbool.h>
+
+#include <hse/error/merr.h>
+#include <hse_util/assert.h>
+#include <hse_util/mutex.h>
+#include <hse_util/condvar.h>
+#include <hse_util/workqueue.h>
+
+typedef merr_t
+mblk_aio_func_t(void *arg);
+
+/**
+ * struct mblk_aio - single-slot asynchronous mblock writer
+ * @ma_work:  work struct for the write workqueue
+ * @ma_wq:    write workqueue (NULL for synchronous operation)
+ * @ma_func:  function that performs the in-flight write
+ * @ma_arg:   argument to @ma_func
+ * @ma_lock:  protects @ma_busy and @ma_err
+ * @ma_cv:    signaled when the in-flight write completes
+ * @ma_busy:  a write is in flight
+ * @ma_err:   first error encountered (sticky)
+ *
+ * The kblock and vblock builders use an mblk_aio to overlap writing the
+ * previous (full) buffer with filling the next one.  At most one write is
+ * in flight at any time, which preserves the append-only write order that
+ * mpool requires within an mblock.  Once an asynchronous write fails, all
+ * subsequent submissions fail with the same error.
+ */
+struct mblk_aio {
+    struct work_struct       ma_work;
+    struct workqueue_struct *ma_wq;
+    mblk_aio_func_t         *ma_func;
+    void                    *ma_arg;
+    struct mutex             ma_lock;
+    struct cv                ma_cv;
+    bool                     ma_busy;
+    merr_t                   ma_err;
+};
+
+/**
+ * mblk_aio_init() - initialize an mblk_aio
+ * @aio: mblk_aio handle
+ * @wq:  write workqueue, or NULL to perform all writes synchronously
+ */
+void
+mblk_aio_init(struct mblk_aio *aio, struct workqueue_struct *wq);
+
+/**
+ * mblk_aio_fini() - wait for any in-flight write and release resources
+ * @aio: mblk_aio handle
+ */
+void
+mblk_aio_fini(struct mblk_aio *aio);
+
+/**
+ * mblk_aio_submit() - issue a write
+ * @aio:  mblk_aio handle
+ * @func: function that performs the write
+ * @arg:  argument to @func
+ *
+ * Waits for the previous write to complete.  If the previous write failed
+ * its error is returned and @func is not called.  Otherwise, @func is
+ * queued to the write workqueue (or called synchronously if there is no
+ * workqueue) and is thereby responsible for releasing any resources tied
+ * to the write.  Errors from an asynchronous write are returned by the
+ * next call to mblk_aio_submit() or mblk_aio_wait().
+ */
+merr_t
+mblk_aio_submit(struct mblk_aio *aio, mblk_aio_func_t *func, void *arg);
+
+/**
+ * mblk_aio_wait() - wait for the in-flight write to complete
+ * @aio: mblk_aio handle
+ *
+ * Return: The first error encountered by any write issued through @aio.
+ */
+merr_t
+mblk_aio_wait(struct mblk_aio *aio);
+
+/**
+ * mblk_aio_set_wq() - switch an idle mblk_aio to asynchronous operation
+ * @aio: mblk_aio handle
+ * @wq:  write workqueue
+ */
+static inline void
+mblk_aio_set_wq(struct mblk_aio *aio, struct workqueue_struct *wq)
+{
+    assert(!aio->ma_busy);
+    aio->ma_wq = wq;
+}
+
+/**
+ * mblk_aio_is_async() - check whether writes are issued asynchronously
+ * @aio: mblk_aio handle
+ */
+static inline bool
+mblk_aio_is_async(const struct mblk_aio *aio)
+{
+    return aio->ma_wq != NULL;
+}
+
+#endif
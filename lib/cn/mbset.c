@@ -243,6 +243,11 @@ mbset_destroy(struct mbset *self, bool *delete_errors)
     if (ev(!self))
         return;
 
+    if (self->mbs_udata_fini) {
+        for (uint i = 0; i < self->mbs_idc; i++)
+            self->mbs_udata_fini(self->mbs_udata + self->mbs_udata_sz * i);
+    }
+
     mbset_unmap(self);
     if (self->mbs_del) {
         err = mbset_mblk_del(self);
@@ -301,6 +306,18 @@ mbset_set_callback(struct mbset *self, mbset_callback *callback, void *rock)
     self->mbs_callback_rock = rock;
 }
 
+/**
+ * mbset_set_udata_fini() - configure the destructor for each block's udata
+ *
+ * The destructor is invoked by the mbset destructor for each block before
+ * the mblocks are unmapped.
+ */
+void
+mbset_set_udata_fini(struct mbset *self, mbset_udata_fini_fn *fn)
+{
+    self->mbs_udata_fini = fn;
+}
+
 void
 mbset_set_delete_flag(struct mbset *self)
 {
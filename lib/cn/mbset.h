@@ -32,6 +32,9 @@ mbset_udata_init_fn(
     struct mblock_props *props,
     void *               rock);
 
+typedef void
+mbset_udata_fini_fn(void *udata);
+
 /**
  * struct mbset - a ref counted set of mblocks
  * @mbs_map:  mcache map handle
@@ -42,6 +45,7 @@ mbset_udata_init_fn(
  * @mbs_del:  if true, delete mblocks in destructor
  * @mbs_alen: sum of mblock allocated lengths
  * @mbs_wlen: sum of mblock written lengths
+ * @mbs_udata_fini: udata destructor (optional)
  *
  * An "mbset" is a set of kblocks (or vblocks) owned by a single kvset and
  * possibly referenced by multiple kvsets (e.g., after k-compaction).
@@ -58,6 +62,7 @@ struct mbset {
     void *                    mbs_callback_rock;
     void *                    mbs_udata;
     uint                      mbs_udata_sz;
+    mbset_udata_fini_fn *     mbs_udata_fini;
     bool                      mbs_del;
 };
 
@@ -84,6 +89,10 @@ mbset_put_ref(struct mbset *self);
 void
 mbset_set_callback(struct mbset *self, mbset_callback *callback, void *rock);
 
+/* MTF_MOCK */
+void
+mbset_set_udata_fini(struct mbset *self, mbset_udata_fini_fn *fn);
+
 /* MTF_MOCK */
 void
 mbset_apply(struct mbset *self, mbset_udata_init_fn fn, uint *argcp, u64 *argv);
@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/platform.h>
+#include <hse_util/alloc.h>
+#include <hse_util/atomic.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/minmax.h>
+#include <hse_util/page.h>
+
+#include "cn_metrics.h"
+#include "kvset.h"
+#include "node_bloom.h"
+
+/* The bitmap of a node bloom is limited to 1GiB (enough for ~850M keys at
+ * 1% false positive rate), larger nodes simply get a denser filter.
+ */
+#define NODE_BLOOM_SZ_MAX (1ul << 30)
+
+static atomic_ulong node_bloom_gen;
+
+merr_t
+node_bloom_create(struct kvset **kvsetv, uint kvsetc, uint64_t prob, struct node_bloom **nb_out)
+{
+    struct bf_bithash_desc desc;
+    struct node_bloom *nb;
+    uint64_t nkeys = 0;
+    size_t sz;
+    u8 *bitmap;
+    merr_t err;
+
+    if (ev(!kvsetv || !kvsetc || !prob || !nb_out))
+        return merr(EINVAL);
+
+    for (uint i = 0; i < kvsetc; i++) {
+        const struct kvset_stats *stats = kvset_statsp(kvsetv[i]);
+
+        nkeys += stats->kst_keys;
+    }
+
+    desc = bf_compute_bithash_est(min_t(uint64_t, prob, U32_MAX));
+
+    sz = (nkeys * desc.bhd_bits_per_elt) / CHAR_BIT;
+    sz = clamp_t(size_t, ALIGN(sz, PAGE_SIZE), PAGE_SIZE, NODE_BLOOM_SZ_MAX);
+
+    nb = malloc(sizeof(*nb));
+    if (ev(!nb))
+        return merr(ENOMEM);
+
+    bitmap = aligned_alloc(PAGE_SIZE, sz);
+    if (ev(!bitmap)) {
+        free(nb);
+        return merr(ENOMEM);
+    }
+
+    memset(bitmap, 0, sz);
+
+    bf_filter_init_blocked(&nb->nb_bf, desc, min_t(uint64_t, nkeys, U32_MAX), bitmap, sz);
+    nb->nb_keys = nkeys;
+
+    for (uint i = 0; i < kvsetc; i++) {
+        err = kvset_bloom_insert(kvsetv[i], &nb->nb_bf);
+        if (ev(err)) {
+            node_bloom_destroy(nb);
+            return err;
+        }
+    }
+
+    nb->nb_gen = atomic_inc_return(&node_bloom_gen);
+
+    *nb_out = nb;
+
+    return 0;
+}
+
+void
+node_bloom_destroy(struct node_bloom *nb)
+{
+    if (nb) {
+        free(nb->nb_bf.bf_bitmap);
+        free(nb);
+    }
+}
@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_KVS_CN_NODE_BLOOM_H
+#define HSE_KVS_CN_NODE_BLOOM_H
+
+#include <hse_util/inttypes.h>
+#include <hse_util/bloom_filter.h>
+#include <hse/error/merr.h>
+
+struct kvset;
+
+/**
+ * struct node_bloom - aggregate bloom filter over the kvsets of a cn node
+ * @nb_gen:   unique generation number of this filter
+ * @nb_keys:  number of keys inserted (including duplicates)
+ * @nb_bf:    blocked bloom filter
+ *
+ * A node bloom contains the hashes of all keys of a set of kvsets in a
+ * leaf node, such that a single cache-line probe can rule out every one
+ * of those kvsets on a point get miss.  The kvsets covered by the filter
+ * are those whose kvset_list_entry le_nbgen matches @nb_gen.  Kvsets added
+ * to the node after the filter was built (e.g., by spill) are not covered
+ * and must be probed individually, as must any kvset with prefix or range
+ * tombstones.
+ * The filter is immutable once built and is replaced wholesale under the
+ * tree write lock.
+ */
+struct node_bloom {
+    uint64_t            nb_gen;
+    uint64_t            nb_keys;
+    struct bloom_filter nb_bf;
+};
+
+/**
+ * node_bloom_create() - build a node bloom from a vector of kvsets
+ * @kvsetv: vector of kvsets
+ * @kvsetc: number of kvsets in %kvsetv
+ * @prob:   target false positive probability (in parts per million)
+ * @nb_out: (output) new node bloom
+ */
+merr_t
+node_bloom_create(struct kvset **kvsetv, uint kvsetc, uint64_t prob, struct node_bloom **nb_out);
+
+/**
+ * node_bloom_destroy() - free a node bloom
+ * @nb: node bloom (may be NULL)
+ */
+void
+node_bloom_destroy(struct node_bloom *nb);
+
+/**
+ * node_bloom_lookup() - check whether a key might be in the covered kvsets
+ * @nb:   node bloom
+ * @hash: hash of key to lookup
+ *
+ * Return: false if the key is definitely not in any covered kvset.
+ */
+static HSE_ALWAYS_INLINE bool
+node_bloom_lookup(const struct node_bloom *nb, uint64_t hash)
+{
+    const struct bloom_filter *bf = &nb->nb_bf;
+
+    return bf_blk_lookup(hash, bf->bf_bitmap, bf->bf_modulus, bf->bf_n_hashes);
+}
+
+#endif
@@ -3,6 +3,8 @@
  * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
  */
 
+#define MTF_MOCK_IMPL_node_split
+
 #include <assert.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -30,6 +32,7 @@
 #include "node_split.h"
 #include "kvset_internal.h"
 #include "wbt_internal.h"
+#include "wbt_reader.h"
 #include "route.h"
 
 struct reverse_kblk_iterator {
@@ -45,6 +48,9 @@ struct forward_wbt_leaf_iterator {
         uint32_t kblk_idx;
         uint32_t leaf_idx;
     } offset;
+    merr_t err;
+    uint32_t nodex;
+    void *nodev; /* two decode buffers for compressed leaf nodes */
 };
 
 static bool
@@ -279,8 +285,26 @@ forward_wbt_leaf_iterator_next(struct element_source *source, void **data)
     if (iter->offset.leaf_idx == 0)
         kbr_madvise_wbt_leaf_nodes(&kblk->kb_kblk_desc, desc, MADV_WILLNEED);
 
-    *data = kblk->kb_kblk_desc.map_base + desc->wbd_first_page * PAGE_SIZE +
-        iter->offset.leaf_idx * WBT_NODE_SIZE;
+    if (desc->wbd_leaf_pgc) {
+        size_t off;
+        uint len;
+
+        /* The binheap holds on to the previously returned node until
+         * this call returns, hence alternate between two buffers.
+         */
+        *data = iter->nodev + iter->nodex * WBT_NODE_SIZE;
+        iter->nodex ^= 1;
+
+        iter->err = wbt_leaf_span(kblk->kb_kblk_desc.map_base, desc, iter->offset.leaf_idx,
+            &off, &len);
+        if (!iter->err)
+            iter->err = wbt_leaf_decode(kblk->kb_kblk_desc.map_base + off, len, *data);
+        if (ev(iter->err))
+            return false;
+    } else {
+        *data = kblk->kb_kblk_desc.map_base + desc->wbd_first_page * PAGE_SIZE +
+            iter->offset.leaf_idx * WBT_NODE_SIZE;
+    }
 
     assert(((struct wbt_node_hdr_omf *)(*data))->wbn_magic == WBT_LFE_NODE_MAGIC);
 
@@ -301,7 +325,8 @@ static void
 forward_wbt_leaf_iterator_init(
     struct forward_wbt_leaf_iterator *const iter,
     struct kvset *const ks,
-    const uint32_t kblk_idx)
+    const uint32_t kblk_idx,
+    void *const nodev)
 {
     INVARIANT(ks);
     INVARIANT(iter);
@@ -309,6 +334,9 @@ forward_wbt_leaf_iterator_init(
     iter->ks = ks;
     iter->offset.kblk_idx = kblk_idx;
     iter->offset.leaf_idx = 0;
+    iter->err = 0;
+    iter->nodex = 0;
+    iter->nodev = nodev;
     iter->es = es_make(forward_wbt_leaf_iterator_next, NULL, NULL);
 }
 
@@ -360,7 +388,7 @@ find_split_key(
     struct key_obj key;
     uint64_t limit;
     struct wbt_node_hdr_omf *wnode = NULL;
-    void *buf = NULL;
+    void *buf = NULL, *nodev;
     uint64_t total_kvlen = 0;
     uint64_t kvset_idx = 0;
 
@@ -377,9 +405,9 @@ find_split_key(
         return err;
 
     /* Forgive me for I have sinned; allocate all necessary memory for managing
-     * iterators and element sources in one go.
+     * iterators, element sources and leaf decode buffers in one go.
      */
-    buf = malloc(num_kvsets * (sizeof(*iters) + sizeof(void *)));
+    buf = malloc(num_kvsets * (sizeof(*iters) + sizeof(void *) + 2 * WBT_NODE_SIZE));
     if (ev(!buf)) {
         err = merr(ENOMEM);
         goto out;
@@ -387,6 +415,7 @@ find_split_key(
 
     iters = buf;
     srcs = buf + num_kvsets * sizeof(*iters);
+    nodev = buf + num_kvsets * (sizeof(*iters) + sizeof(void *));
 
     list_for_each_entry(le, &tn->tn_kvset_list, le_link) {
         struct kvset_metrics metrics;
@@ -396,7 +425,8 @@ find_split_key(
 
         total_kvlen += metrics.tot_kvlen;
 
-        forward_wbt_leaf_iterator_init(iter, le->le_kvset, offsets[kvset_idx]);
+        forward_wbt_leaf_iterator_init(iter, le->le_kvset, offsets[kvset_idx],
+            nodev + kvset_idx * 2 * WBT_NODE_SIZE);
 
         srcs[kvset_idx] = &(iter)->es;
 
@@ -419,6 +449,12 @@ find_split_key(
 
     while (seen_kvlen <= limit && bin_heap_pop(bh, (void **)&wnode))
         seen_kvlen += omf_wbn_kvlen(wnode);
+
+    for (uint64_t i = 0; i < num_kvsets; i++) {
+        err = iters[i].err;
+        if (ev(err))
+            goto out;
+    }
     assert(wnode);
 
     log_debug("node %lu split key kvlen: %lu/%lu (%lf%%)",
@@ -470,6 +506,100 @@ out:
     return err;
 }
 
+merr_t
+cn_compact_range_keys(
+    struct cn_compaction_work *w,
+    uint                       rangec,
+    void                      *keyv,
+    uint                      *klenv,
+    uint                      *keycp)
+{
+    struct forward_wbt_leaf_iterator *iters;
+    struct element_source **srcs;
+    struct wbt_node_hdr_omf *wnode;
+    struct bin_heap *bh;
+    uint64_t total_kvlen = 0, seen_kvlen = 0;
+    void *buf, *nodev;
+    uint keyc = 0;
+    merr_t err;
+
+    INVARIANT(rangec > 1);
+
+    *keycp = 0;
+
+    err = bin_heap_create(w->cw_kvset_cnt, wbt_leaf_compare, &bh);
+    if (ev(err))
+        return err;
+
+    buf = malloc(w->cw_kvset_cnt * (sizeof(*iters) + sizeof(void *) + 2 * WBT_NODE_SIZE));
+    if (ev(!buf)) {
+        err = merr(ENOMEM);
+        goto out;
+    }
+
+    iters = buf;
+    srcs = buf + w->cw_kvset_cnt * sizeof(*iters);
+    nodev = buf + w->cw_kvset_cnt * (sizeof(*iters) + sizeof(void *));
+
+    for (uint i = 0; i < w->cw_kvset_cnt; i++) {
+        struct kvset *ks = kvset_from_iter(w->cw_inputv[i]);
+        struct kvset_metrics metrics;
+
+        kvset_get_metrics(ks, &metrics);
+        total_kvlen += metrics.tot_kvlen;
+
+        forward_wbt_leaf_iterator_init(&iters[i], ks, 0, nodev + i * 2 * WBT_NODE_SIZE);
+        srcs[i] = &iters[i].es;
+    }
+
+    err = bin_heap_prepare(bh, w->cw_kvset_cnt, srcs);
+    if (ev(err))
+        goto out;
+
+    /* Visit the wbt leaf nodes of all the input kvsets in key order and
+     * start a new range at the first leaf node past each 1/rangec-th of
+     * the key/value data.  Leaf nodes with the same first key (e.g., from
+     * different kvsets) cannot be separated, hence fewer ranges than
+     * requested may be found.
+     */
+    while (keyc < rangec - 1 && bin_heap_pop(bh, (void **)&wnode)) {
+        const uint64_t limit = total_kvlen / rangec * (keyc + 1);
+        const struct wbt_lfe_omf *lfe;
+        struct key_obj key, prev;
+        void *kbuf = keyv + keyc * HSE_KVS_KEY_LEN_MAX;
+
+        if (seen_kvlen >= limit && seen_kvlen > 0) {
+            lfe = wbt_lfe(wnode, 0);
+            wbt_node_pfx(wnode, &key.ko_pfx, &key.ko_pfx_len);
+            wbt_lfe_key(wnode, lfe, &key.ko_sfx, &key.ko_sfx_len);
+
+            if (keyc > 0)
+                key2kobj(&prev, kbuf - HSE_KVS_KEY_LEN_MAX, klenv[keyc - 1]);
+
+            if (keyc == 0 || key_obj_cmp(&prev, &key) < 0) {
+                key_obj_copy(kbuf, HSE_KVS_KEY_LEN_MAX, &klenv[keyc], &key);
+                keyc++;
+            }
+        }
+
+        seen_kvlen += omf_wbn_kvlen(wnode);
+    }
+
+    for (uint i = 0; i < w->cw_kvset_cnt; i++) {
+        err = iters[i].err;
+        if (ev(err))
+            goto out;
+    }
+
+    *keycp = keyc;
+
+out:
+    free(buf);
+    bin_heap_destroy(bh);
+
+    return err;
+}
+
 static void
 kvset_split_res_init(struct cn_compaction_work *w, struct kvset_split_res *result, uint ks_idx)
 {
@@ -715,3 +845,7 @@ cn_split_node_stats_dump(
         cn_ns_hblks(ns), cn_ns_kblks(ns), cn_ns_vblks(ns),
         cn_ns_alen(ns));
 }
+
+#if HSE_MOCKING
+#include "node_split_ut_impl.i"
+#endif /* HSE_MOCKING */
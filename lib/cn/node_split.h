@@ -15,6 +15,8 @@
 
 struct cn_tree_node;
 
+/* MTF_MOCK_DECL(node_split) */
+
 /**
  * Return an optimal key to split a node on.
  *
@@ -37,6 +39,32 @@ cn_tree_node_get_split_key(
     size_t key_buf_sz,
     unsigned int *key_len) HSE_NONNULL(1);
 
+/**
+ * Return keys that divide a compaction's input into key ranges.
+ *
+ * Like cn_tree_node_get_split_key(), the key ranges are found by walking
+ * the wbt leaf nodes of the input kvsets, such that each range holds about
+ * the same amount of key/value data.
+ *
+ * @param w: Compaction work (the input iterators must have been created).
+ * @param rangec: Number of key ranges desired.
+ * @param keyv: Buffer of (@p rangec - 1) * HSE_KVS_KEY_LEN_MAX bytes in which
+ *     to copy out the keys.  The i-th key is the first key of range i + 1.
+ * @param klenv: Lengths of the keys.
+ * @param keycp: (output) Number of keys found, at most @p rangec - 1.  The keys
+ *     are distinct and in ascending order.
+ *
+ * @returns Error status.
+ */
+/* MTF_MOCK */
+merr_t
+cn_compact_range_keys(
+    struct cn_compaction_work *w,
+    unsigned int rangec,
+    void *keyv,
+    unsigned int *klenv,
+    unsigned int *keycp) HSE_NONNULL(1, 3, 4, 5);
+
 /**
  * cn_split() - Build kvsets as part of a node split operation
  * @w: compaction work struct
@@ -93,4 +121,8 @@ cn_split_node_stats_dump(
     const struct cn_tree_node *node,
     const char                *pos);
 
+#if HSE_MOCKING
+#include "node_split_ut.h"
+#endif /* HSE_MOCKING */
+
 #endif
@@ -20,6 +20,8 @@
  * Wanna B-Tree (WBT) On-Media-Format
  *
  * Supported versions:
+ *     v7: Added optional leaf node compression (see below).  A v7 tree with
+ *         wbt_leaf_pgc == 0 is laid out exactly as a v6 tree.
  *     v6: Added support for compressed values. Uses a new value type
  *         (VTYPE_CVAL) which affects KMD format. Unfortunately,
  *         there is no version field for KMD, so we bump the WBTree
@@ -32,9 +34,28 @@
  */
 #define WBT_NODE_SIZE PAGE_SIZE /* must equal system page size */
 
+/* Compressed leaf nodes (v7, wbt_leaf_pgc > 0):
+ *
+ * The leaf nodes are replaced by a region of wbt_leaf_pgc pages which
+ * begins with a table of (wbt_leaf_cnt + 1) LE32 byte offsets, relative
+ * to the start of the region, followed by the compressed leaf nodes.
+ * Leaf i occupies bytes [off[i], off[i + 1]) of the region.  Internal
+ * nodes and kmd follow the leaf region, i.e., node N >= wbt_leaf_cnt is
+ * located at page (wbt_leaf_pgc + N - wbt_leaf_cnt) of the tree.
+ *
+ * Each leaf is first re-encoded by replacing each key suffix with the
+ * length of the prefix it shares with the previous key in the node (one
+ * byte, or 0xff followed by an LE16 length) followed by the unshared
+ * bytes.  The node header, node prefix and lfe array are kept verbatim,
+ * hence the original node can be reconstructed exactly.  The result is
+ * then compressed with lz4 and must not exceed WBT_CLEAF_LEN_MAX bytes.
+ */
+#define WBT_CLEAF_LEN_MAX   (2 * WBT_NODE_SIZE)
+#define WBT_CLEAF_SHARED_X  (0xffu)
+
 #define WBT_TREE_MAGIC ((uint32_t)0x4a3a2a1a)
 
-/* WBT header (v6) */
+/* WBT header (v7) */
 struct wbt_hdr_omf {
     uint32_t wbt_magic;
     uint32_t wbt_version;
@@ -42,7 +63,7 @@ struct wbt_hdr_omf {
     uint16_t wbt_leaf;     /* index of first wbtree leaf node */
     uint16_t wbt_leaf_cnt; /* number of wbtree leaf nodes */
     uint16_t wbt_kmd_pgc;  /* size of kmd region in pages */
-    uint32_t wbt_reserved1;
+    uint32_t wbt_leaf_pgc; /* size of compressed leaf region in pages (v7) */
     uint32_t wbt_reserved2;
 } HSE_PACKED;
 
@@ -52,6 +73,7 @@ OMF_SETGET(struct wbt_hdr_omf, wbt_root, 16);
 OMF_SETGET(struct wbt_hdr_omf, wbt_leaf, 16);
 OMF_SETGET(struct wbt_hdr_omf, wbt_leaf_cnt, 16);
 OMF_SETGET(struct wbt_hdr_omf, wbt_kmd_pgc, 16);
+OMF_SETGET(struct wbt_hdr_omf, wbt_leaf_pgc, 32);
 
 #define WBT_LFE_NODE_MAGIC ((uint16_t)0xabc0)
 #define WBT_INE_NODE_MAGIC ((uint16_t)0xabc1)
@@ -136,6 +158,11 @@ struct hblock_hdr_omf {
     uint32_t hbh_min_pfx_off;
     uint8_t hbh_min_pfx_len;
     uint8_t hbh_rsvd2[3];
+
+    /* range tombstones (v2) */
+    uint32_t hbh_num_rtombs;
+    uint32_t hbh_rtomb_off_pg;
+    uint32_t hbh_rtomb_len_pg;
 } HSE_PACKED;
 
 OMF_SETGET(struct hblock_hdr_omf, hbh_magic, 32)
@@ -155,6 +182,9 @@ OMF_SETGET(struct hblock_hdr_omf, hbh_max_pfx_off, 32)
 OMF_SETGET(struct hblock_hdr_omf, hbh_max_pfx_len, 8)
 OMF_SETGET(struct hblock_hdr_omf, hbh_min_pfx_off, 32)
 OMF_SETGET(struct hblock_hdr_omf, hbh_min_pfx_len, 8)
+OMF_SETGET(struct hblock_hdr_omf, hbh_num_rtombs, 32)
+OMF_SETGET(struct hblock_hdr_omf, hbh_rtomb_off_pg, 32)
+OMF_SETGET(struct hblock_hdr_omf, hbh_rtomb_len_pg, 32)
 
 static_assert(HSE_KVS_PFX_LEN_MAX <= UINT8_MAX,
     "uint8_t is not enough to hold HSE_KVS_PFX_LEN_MAX");
@@ -165,6 +195,20 @@ static_assert(HSE_KVS_PFX_LEN_MAX <= UINT8_MAX,
 
 static_assert(HBLOCK_HDR_PAGES == 1, "Hblock header spanning more than 1 page has not been tested");
 
+/* Range tombstone region entry (v2).  The region is a packed array of
+ * hbh_num_rtombs entries, each immediately followed by its start key and
+ * then its end key.
+ */
+struct rtomb_omf {
+    uint64_t rt_seqno;
+    uint16_t rt_start_len;
+    uint16_t rt_end_len;
+} HSE_PACKED;
+
+OMF_SETGET(struct rtomb_omf, rt_seqno, 64)
+OMF_SETGET(struct rtomb_omf, rt_start_len, 16)
+OMF_SETGET(struct rtomb_omf, rt_end_len, 16)
+
 
 /*****************************************************************
  *
@@ -247,6 +291,11 @@ struct kblock_hdr_omf {
     uint32_t kbh_blm_hlen;
     uint32_t kbh_blm_doff_pg;
     uint32_t kbh_blm_dlen_pg;
+
+    /* expiring values (version 7 and later) */
+    uint64_t kbh_ttl_bytes;
+    uint32_t kbh_ttl_min;
+    uint32_t kbh_ttl_max;
 } HSE_PACKED;
 
 /* Define set/get methods for kblock_hdr_omf */
@@ -276,6 +325,10 @@ OMF_SETGET(struct kblock_hdr_omf, kbh_blm_hlen, 32)
 OMF_SETGET(struct kblock_hdr_omf, kbh_blm_doff_pg, 32)
 OMF_SETGET(struct kblock_hdr_omf, kbh_blm_dlen_pg, 32)
 
+OMF_SETGET(struct kblock_hdr_omf, kbh_ttl_bytes, 64)
+OMF_SETGET(struct kblock_hdr_omf, kbh_ttl_min, 32)
+OMF_SETGET(struct kblock_hdr_omf, kbh_ttl_max, 32)
+
 /* Storing 2 keys in the header: min and max. */
 #define KBLOCK_HDR_PAGES \
     (roundup(sizeof(struct kblock_hdr_omf) + 2 * HSE_KVS_KEY_LEN_MAX, PAGE_SIZE) / PAGE_SIZE)
@@ -300,6 +353,12 @@ static_assert(KBLOCK_HDR_PAGES == 1, "Kblock header spanning more than 1 page ha
  * @bh_n_hashes:        number of hashes per bucket
  * @bh_bitmapsz:        size of bitmap in bytes
  * @bh_modulus:         modulus used to convert first hash to bucket
+ *
+ * Version 5 blooms scatter the probes for a key over a bucket of
+ * 2^bh_bktshift bits selected by (hash % bh_modulus).  Version 6 blooms
+ * confine all probes to one 64-byte block selected by multiply-shift,
+ * in which case bh_modulus is the number of blocks and bh_rotl is unused
+ * (see bf_blk_populate()).
  */
 struct bloom_hdr_omf {
     uint32_t bh_magic;
@@ -337,6 +396,11 @@ OMF_SETGET(struct bloom_hdr_omf, bh_n_hashes, 8)
  *
  * max_key is stored at offset VBLOCK_FOOTER_LEN - HSE_KVS_KEY_LEN_MAX
  * max key is exclusive in all but the last vblock
+ *
+ * Version 2 footers record in vbf_dict_len the length of the compression
+ * dictionary (if any) used by the values in the vblock.  The dictionary is
+ * stored in the pages immediately preceding the footer.  vbf_dict_len is
+ * reserved (zero) in version 1 footers.
  */
 struct vblock_footer_omf {
     uint32_t vbf_magic;
@@ -344,7 +408,7 @@ struct vblock_footer_omf {
     uint64_t vbf_vgroup;
     uint16_t vbf_min_klen;
     uint16_t vbf_max_klen;
-    uint32_t vbf_rsvd;
+    uint32_t vbf_dict_len;
 } HSE_PACKED;
 
 /* Storing 2 keys in the footer: min and max. */
@@ -354,11 +418,15 @@ struct vblock_footer_omf {
 
 static_assert(VBLOCK_FOOTER_PAGES == 1, "Vblock footer cannot span multiple pages");
 
+#define VBLOCK_DICT_LEN_MAX (32 * 1024)
+
+static_assert(VBLOCK_DICT_LEN_MAX % PAGE_SIZE == 0, "Vblock dictionary space must be page aligned");
+
 OMF_SETGET(struct vblock_footer_omf, vbf_magic, 32)
 OMF_SETGET(struct vblock_footer_omf, vbf_version, 32)
 OMF_SETGET(struct vblock_footer_omf, vbf_vgroup, 64)
 OMF_SETGET(struct vblock_footer_omf, vbf_min_klen, 16)
 OMF_SETGET(struct vblock_footer_omf, vbf_max_klen, 16)
-OMF_SETGET(struct vblock_footer_omf, vbf_rsvd, 32)
+OMF_SETGET(struct vblock_footer_omf, vbf_dict_len, 32)
 
 #endif
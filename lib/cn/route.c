@@ -12,6 +12,7 @@
 #include <hse/logging/logging.h>
 #include <hse_util/assert.h>
 #include <hse_util/keycmp.h>
+#include <hse_util/key_util.h>
 #include <hse_util/xrand.h>
 #include <hse_util/log2.h>
 #include <hse_util/byteorder.h>
@@ -21,13 +22,129 @@
 #include "cn_tree_internal.h"
 #include "route.h"
 
+/**
+ * struct route_map - routing table of a cn tree
+ * @rtm_root:   rb tree of route nodes ordered by edge key
+ * @rtm_nodec:  number of route nodes in %rtm_nodev
+ * @rtm_free:   free list of route nodes
+ * @rtm_idxc:   number of route nodes in the rb tree
+ * @rtm_lcp:    length of the prefix common to all but the last edge key
+ * @rtm_discv:  discriminators of all but the last edge key (see route_map_index())
+ * @rtm_nodepv: route nodes in edge key order
+ * @rtm_nodev:  route node cache
+ */
 struct route_map {
     struct rb_root        rtm_root;
     uint                  rtm_nodec;
     struct route_node    *rtm_free;
+    uint                  rtm_idxc;
+    uint                  rtm_lcp;
+    uint64_t             *rtm_discv;
+    struct route_node   **rtm_nodepv;
     struct route_node     rtm_nodev[] HSE_L1D_ALIGNED;
 };
 
+/* Return the first eight bytes of a key as an integer that compares
+ * like the bytes do, padding short keys with zeroes.
+ */
+static HSE_ALWAYS_INLINE uint64_t
+route_disc(const void *key, uint keylen)
+{
+    uint64_t disc = 0;
+
+    memcpy(&disc, key, min_t(uint, keylen, sizeof(disc)));
+
+    return be64_to_cpu(disc);
+}
+
+/* Rebuild the route index after the rb tree or an edge key has changed.
+ *
+ * The index is a dense array of the route nodes in edge key order, plus an
+ * array of discriminators formed from the eight bytes that follow the prefix
+ * common to all but the last edge key.  A lookup is then a binary search over
+ * a few cache lines of integers, whereas edge keys that share long prefixes
+ * would make every step of an rb tree search a pointer chase and a full key
+ * comparison.  The last edge needn't be indexed because every key greater
+ * than the other edges routes to it.
+ *
+ * The route map is modified only under the cn tree write lock, so the index
+ * is always consistent with the rb tree for readers.
+ */
+static void
+route_map_index(struct route_map *map)
+{
+    const struct route_node *first, *last;
+    struct rb_node *rbn;
+    uint n = 0;
+
+    for (rbn = rb_first(&map->rtm_root); rbn; rbn = rb_next(rbn))
+        map->rtm_nodepv[n++] = rb_entry(rbn, struct route_node, rtn_node);
+
+    map->rtm_idxc = n;
+    map->rtm_lcp = 0;
+
+    if (n < 2)
+        return;
+
+    /* The longest common prefix of a sorted set of keys is the longest
+     * common prefix of its first and last keys.
+     */
+    first = map->rtm_nodepv[0];
+    last = map->rtm_nodepv[n - 2];
+
+    map->rtm_lcp = memlcp(first->rtn_keybufp, last->rtn_keybufp,
+                          min_t(uint, first->rtn_keylen, last->rtn_keylen));
+
+    for (uint i = 0; i < n - 1; i++) {
+        const struct route_node *node = map->rtm_nodepv[i];
+
+        map->rtm_discv[i] = route_disc(node->rtn_keybufp + map->rtm_lcp,
+                                       node->rtn_keylen - map->rtm_lcp);
+    }
+}
+
+/* Return the index of the first edge key that is greater than or equal to
+ * %key, or the index of the last edge if there is no such key.
+ */
+static uint
+route_map_index_find(const struct route_map *map, const void *key, uint keylen)
+{
+    const uint n = map->rtm_idxc - 1;
+    const uint lcp = map->rtm_lcp;
+    uint lo = 0, hi = n;
+    uint64_t disc;
+    int rc;
+
+    if (n == 0)
+        return 0;
+
+    rc = memcmp(key, map->rtm_nodepv[0]->rtn_keybufp, min_t(uint, keylen, lcp));
+    if (rc < 0 || (rc == 0 && keylen < lcp))
+        return 0;
+
+    if (rc > 0)
+        return n;
+
+    disc = route_disc((const uint8_t *)key + lcp, keylen - lcp);
+
+    while (lo < hi) {
+        uint mid = (lo + hi) / 2;
+
+        if (map->rtm_discv[mid] < disc)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    /* Edge keys whose discriminators equal that of %key must be compared in full.
+     */
+    while (lo < n && map->rtm_discv[lo] == disc &&
+           route_node_keycmp(map->rtm_nodepv[lo], key, keylen) < 0)
+        ++lo;
+
+    return lo;
+}
+
 static merr_t
 route_node_keybuf_alloc(struct route_node *node, uint edge_klen)
 {
@@ -136,6 +253,7 @@ route_node_key_modify(
         return err;
 
     route_node_key_set(node, edge_key, edge_klen);
+    route_map_index(map);
 
     return 0;
 }
@@ -192,6 +310,8 @@ route_map_insert_by_node(struct route_map *map, struct route_node *node)
         }
     }
 
+    route_map_index(map);
+
     return NULL;
 }
 
@@ -247,42 +367,26 @@ route_map_delete(struct route_map *map, struct route_node *node)
 
         this->rtn_islast = true;
     }
+
+    route_map_index(map);
 }
 
 static struct route_node *
 route_map_find(struct route_map *map, const void *key, uint keylen, bool gt)
 {
-    struct rb_root *root = &map->rtm_root;
-    struct rb_node **link = &root->rb_node;
-    struct rb_node *node = *link;
-    int dir = 0;
-
-    /* The last node from which a left turn was taken in the traversal path is the
-     * in-order successor of the search key.  If there was no left turn taken in
-     * the traversal path then the in-order successor is the last parent node.
-     */
-    while (*link) {
-        struct route_node *this;
-        int rc;
+    struct route_node *node;
+    uint i;
 
-        this = rb_entry(*link, struct route_node, rtn_node);
+    if (map->rtm_idxc == 0)
+        return NULL;
 
-        rc = keycmp(key, keylen, this->rtn_keybufp, this->rtn_keylen);
+    i = route_map_index_find(map, key, keylen);
+    node = map->rtm_nodepv[i];
 
-        if (rc < 0) {
-            dir = -1;
-            node = *link;
-            link = &(*link)->rb_left;
-        } else if (rc > 0) {
-            link = &(*link)->rb_right;
-            if (dir >= 0 && *link)
-                node = *link;
-        } else {
-            return gt ? rb_entry(rb_next(*link), struct route_node, rtn_node) : this;
-        }
-    }
+    if (gt && route_node_keycmp(node, key, keylen) == 0)
+        return (i + 1 < map->rtm_idxc) ? map->rtm_nodepv[i + 1] : NULL;
 
-    return rb_entry(node, struct route_node, rtn_node);
+    return node;
 }
 
 struct route_node *
@@ -361,6 +465,7 @@ route_map_create(uint nodec)
         return NULL;
 
     sz = sizeof(*map) + sizeof(map->rtm_nodev[0]) * nodec;
+    sz += (sizeof(map->rtm_discv[0]) + sizeof(map->rtm_nodepv[0])) * nodec;
 
     map = aligned_alloc(4096, roundup(sz, 4096));
     if (!map)
@@ -368,6 +473,8 @@ route_map_create(uint nodec)
 
     memset(map, 0, sz);
     map->rtm_nodec = nodec;
+    map->rtm_discv = (void *)(map->rtm_nodev + nodec);
+    map->rtm_nodepv = (void *)(map->rtm_discv + nodec);
 
     /* Fill the route_node cache entries */
     for (uint i = nodec; i > 0; --i) {
@@ -18,6 +18,7 @@
 #include <hse_ikvdb/kvdb_perfc.h>
 #include <hse_ikvdb/cndb.h>
 #include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/kvs_rtomb.h>
 
 #define MTF_MOCK_IMPL_spill
 #include "spill.h"
@@ -100,8 +101,70 @@ struct spillctx {
     struct key_obj pt_kobj;
     u64            pt_seq; /* [HSE_REVISIT]: Need a list of seqnos to carry all ptombs across leaves. */
     bool           pt_set;
+
+    /* Range tombstones */
+    struct kvs_rtomb_vec rtombs;    /* all rtombs in the input kvsets */
+    struct kvs_rtomb_vec ss_rtombs; /* rtombs to add to the current child */
+    uint                 prev_eklen;
+    bool                 prev_ekey_set;
+    uint8_t              prev_ekey[HSE_KVS_KEY_LEN_MAX];
+
+    struct cn_compact_filter_ctx cfilter;
 };
 
+/* Gather the range tombstones that must be spilled to the child whose key
+ * range is (prev_ekey, ekey].  An rtomb that is copied to more than one child
+ * is harmless, whereas skipping a child in which it hides older values is not,
+ * so the end key test is conservative.  As with keys, rtombs from kvsets that
+ * the child already holds (i.e., whose dgen is not newer than node_dgen) are
+ * not spilled again.
+ */
+static merr_t
+cn_subspill_rtombs(struct spillctx *sctx, uint64_t node_dgen, const struct key_obj *ekobj)
+{
+    struct cn_compaction_work *w = sctx->work;
+    struct key_obj pkobj;
+    merr_t err = 0;
+
+    kvs_rtomb_vec_reset(&sctx->ss_rtombs);
+
+    key2kobj(&pkobj, sctx->prev_ekey, sctx->prev_eklen);
+
+    for (uint i = 0; i < w->cw_kvset_cnt && sctx->rtombs.krv_cnt > 0; i++) {
+        const struct kvset *ks = kvset_from_iter(w->cw_inputv[i]);
+        const struct kvs_rtomb *rtv;
+        uint rtc;
+
+        if (kvset_get_dgen(ks) <= node_dgen)
+            continue;
+
+        rtv = kvset_get_rtombs(ks, &rtc);
+
+        for (uint j = 0; j < rtc; j++) {
+            const struct kvs_rtomb *rt = rtv + j;
+            struct key_obj ko;
+
+            key2kobj(&ko, rt->kr_start, rt->kr_start_len);
+            if (key_obj_cmp(&ko, ekobj) > 0)
+                continue;
+
+            key2kobj(&ko, rt->kr_end, rt->kr_end_len);
+            if (sctx->prev_ekey_set && key_obj_cmp(&ko, &pkobj) <= 0)
+                continue;
+
+            err = kvs_rtomb_vec_add(&sctx->ss_rtombs, rt);
+            if (ev(err))
+                goto out;
+        }
+    }
+
+  out:
+    key_obj_copy(sctx->prev_ekey, sizeof(sctx->prev_ekey), &sctx->prev_eklen, ekobj);
+    sctx->prev_ekey_set = true;
+
+    return err;
+}
+
 merr_t
 cn_spill_create(struct cn_compaction_work *w, struct spillctx **sctx_out)
 {
@@ -132,6 +195,14 @@ cn_spill_create(struct cn_compaction_work *w, struct spillctx **sctx_out)
     if (err)
         goto out;
 
+    err = cn_compact_rtombs(w, &s->rtombs);
+    if (err)
+        goto out;
+
+    err = cn_compact_filter_init(w, &s->cfilter, HSE_KVS_VALUE_LEN_MAX);
+    if (err)
+        goto out;
+
     s->work = w;
     s->sgen = w->cw_sgen;
 
@@ -145,6 +216,8 @@ cn_spill_create(struct cn_compaction_work *w, struct spillctx **sctx_out)
 
 out:
     if (err) {
+        cn_compact_filter_fini(&s->cfilter);
+        kvs_rtomb_vec_fini(&s->rtombs);
         bin_heap_destroy(s->bh);
         free(s);
     }
@@ -158,6 +231,9 @@ cn_spill_destroy(struct spillctx *sctx)
     if (!sctx)
         return;
 
+    cn_compact_filter_fini(&sctx->cfilter);
+    kvs_rtomb_vec_fini(&sctx->ss_rtombs);
+    kvs_rtomb_vec_fini(&sctx->rtombs);
     bin_heap_destroy(sctx->bh);
     free(sctx);
 }
@@ -215,6 +291,7 @@ cn_subspill(
     bool dbg_dup HSE_MAYBE_UNUSED;
     uint seqno_errcnt = 0;
     bool new_key;
+    u64 rt_seq = 0;
     struct key_obj ekobj;
 
     key2kobj(&ekobj, ekey, eklen);
@@ -240,13 +317,17 @@ cn_subspill(
     ss->ss_added = false;
     ss->ss_work = w;
 
-    if (!sctx->more && !sctx->pt_set)
+    err = cn_subspill_rtombs(sctx, node_dgen, &ekobj);
+    if (err)
+        return err;
+
+    if (!sctx->more && !sctx->pt_set && !sctx->ss_rtombs.krv_cnt)
         return 0;
 
-    /* Proceed only if either the curr key belongs in this leaf node OR there's a ptomb that needs
-     * to be propagated to this child.
+    /* Proceed only if either the curr key belongs in this leaf node OR there's a ptomb or
+     * rtomb that needs to be propagated to this child.
      */
-    if (!sctx->pt_set && key_obj_cmp(&sctx->curr->kobj, &ekobj) > 0)
+    if (!sctx->pt_set && !sctx->ss_rtombs.krv_cnt && key_obj_cmp(&sctx->curr->kobj, &ekobj) > 0)
         return 0;
 
     w->cw_kvsetidv[0] = ss->ss_kvsetid = cndb_kvsetid_mint(cn_tree_get_cndb(w->cw_tree));
@@ -259,6 +340,7 @@ cn_subspill(
 
     kvset_builder_set_merge_stats(child, &w->cw_stats);
     kvset_builder_set_agegroup(child, HSE_MPOLICY_AGE_LEAF);
+    kvset_builder_set_wq(child, cn_get_wr_wq(cn_tree_get_cn(w->cw_tree)));
 
     /* Add ptomb to 'child' if a ptomb context is carried forward from the
      * previous node spill, i.e., this ptomb spans across multiple children.
@@ -305,6 +387,10 @@ cn_subspill(
 
             if (sctx->pt_set && key_obj_cmp_prefix(&sctx->pt_kobj, &sctx->curr->kobj) != 0)
                 sctx->pt_set = false; /* cached ptomb key is no longer valid */
+
+            if (sctx->rtombs.krv_cnt > 0)
+                rt_seq = kvs_rtomb_seq(sctx->rtombs.krv_rtv, sctx->rtombs.krv_cnt,
+                                       &sctx->curr->kobj, w->cw_horizon);
         }
 
         while (!bg_val) {
@@ -313,6 +399,7 @@ cn_subspill(
             enum kmd_vtype vtype;
             u32            vbidx;
             u32            vboff;
+            u32            expire;
             bool           direct;
 
             if (tstart > 0)
@@ -323,6 +410,14 @@ cn_subspill(
                                       &vboff, &vdata, &vlen, &complen))
                 break;
 
+            /* An expired value is spilled as a tombstone.
+             */
+            expire = sctx->curr->vctx.expire;
+            if (kvs_expired(expire)) {
+                vtype = VTYPE_TOMB;
+                vlen = complen = expire = 0;
+            }
+
             omlen = (vtype == VTYPE_UCVAL) ? vlen : ((vtype == VTYPE_CVAL) ? complen : 0);
 
             direct = omlen > direct_read_len;
@@ -365,6 +460,9 @@ cn_subspill(
             if (bg_val && sctx->pt_set && w->cw_horizon >= sctx->pt_seq && sctx->pt_seq > seq)
                 break; /* drop val if it and pt are beyond horizon */
 
+            if (bg_val && rt_seq > seq)
+                break; /* drop val hidden by a range tombstone beyond horizon */
+
             /* Set ptomb context irrespective of bg_val for tombstone propagation */
             if (HSE_CORE_IS_PTOMB(vdata)) {
                 sctx->pt_set = true;
@@ -386,7 +484,38 @@ cn_subspill(
                 if (w->cw_drop_tombs && HSE_CORE_IS_TOMB(vdata) && bg_val)
                     continue; /* skip value */
 
-                err = kvset_builder_add_val(child, &sctx->curr->kobj, vdata, vlen, seq, complen);
+                /* The newest value at or below the horizon is offered to the compaction
+                 * filter.  A deleted key is spilled as a tombstone as the child may hold
+                 * older values of the key.
+                 */
+                if (sctx->cfilter.cfc_filter && bg_val && vtype != VTYPE_MVAL &&
+                    !HSE_CORE_IS_TOMB(vdata)) {
+                    bool drop;
+
+                    err = cn_compact_filter(&sctx->cfilter, &sctx->curr->kobj, seq,
+                                            &vdata, &vlen, &complen, &drop);
+                    if (err)
+                        break;
+
+                    if (drop) {
+                        if (w->cw_drop_tombs)
+                            continue; /* skip value */
+
+                        vdata = HSE_CORE_TOMB_REG;
+                        vlen = complen = expire = 0;
+                    }
+                }
+
+                /* Merge operands are carried to the children unchanged, they
+                 * are folded by subsequent k/kv-compactions of the leaves.
+                 */
+                if (expire)
+                    kvset_builder_set_expire(child, expire);
+
+                if (vtype == VTYPE_MVAL)
+                    err = kvset_builder_add_mval(child, seq, vdata, vlen);
+                else
+                    err = kvset_builder_add_val(child, &sctx->curr->kobj, vdata, vlen, seq, complen);
                 if (err)
                     break;
 
@@ -473,7 +602,14 @@ cn_subspill(
         }
     }
 
-    err = kvset_builder_get_mblocks(child, &ss->ss_mblks);
+    if (!err && sctx->ss_rtombs.krv_cnt > 0) {
+        err = cn_compact_rtombs_emit(w, &sctx->ss_rtombs, child);
+        if (!err)
+            ss->ss_added = true;
+    }
+
+    if (!err)
+        err = kvset_builder_get_mblocks(child, &ss->ss_mblks);
 
 out:
 
@@ -37,15 +37,19 @@
 #include "cn_mblocks.h"
 #include "cn_metrics.h"
 #include "cn_perfc.h"
+#include "mblk_aio.h"
 
-#define WBUF_LEN_MAX      ((1024 * 1024) + VBLOCK_FOOTER_LEN)
+#define WBUF_LEN_MAX      ((1024 * 1024) + VBLOCK_DICT_LEN_MAX + VBLOCK_FOOTER_LEN)
 
 /**
  * struct vblock_builder - create vblocks from a stream of values
  * @ds:        mpool dataset
  * @pc:        performance counters
  * @vblk_list: list of vblocks
- * @wbuf:      write buffer
+ * @wbuf:      current write buffer (one of @wbufv)
+ * @wbufv:     write buffers, @wbufv[1] is NULL unless writes are asynchronous
+ * @aio:       mblock writer
+ * @wreq:      the write request in flight
  * @wbuf_off:  offset of next unused byte in write buffer
  * @wbuf_len:  length of next write to media
  * @vblk_off:  offset of next unused byte in vblock
@@ -55,6 +59,9 @@
  * @mblocksz:  mblock size of specified media class
  * @cur_minklen: min key length
  * @cur_minkey:  a copy of the min key referencing this vblock
+ * @dict:        compression dictionary stored in each vblock (may be NULL)
+ * @dict_len:    length of @dict
+ * @dict_rsvd:   true if space is reserved in each vblock for a dictionary
  *
  * WBUF_LEN_MAX is the allocated size of the write buffer.  Each mblock write
  * will be at most WBUF_LEN_MAX bytes.  Member @wbuf_len is the actual write
@@ -71,7 +78,8 @@
  *
  *   If current vblock has not been allocated, start a new vblock as follows:
  *     - allocate vblock
- *     - set @wbuf_len to WBUF_LEN_MAX - VBLOCK_FOOTER_LEN, reserving space for footer
+ *     - set @wbuf_len to WBUF_LEN_MAX - VBLOCK_DICT_LEN_MAX - VBLOCK_FOOTER_LEN,
+ *       reserving space for the dictionary (if any) and footer
  *
  *   If current vblock does not have room for new value:
  *     - write residual contents of @wbuf to mblock
@@ -86,7 +94,24 @@
  *       -- write @wbuf_len bytes to mblock
  *       -- set @wbuf_off to 0
  *       -- set @vblk_off += @wbuff_off
+ *
+ * A vblock that stores a dictionary is laid out as follows, where the
+ * dictionary and footer each start on a page boundary:
+ *
+ *   | values | pad | dictionary | pad | footer |
+ *
+ * If the builder was given a write workqueue via vbb_set_wq() then a second
+ * write buffer is allocated and each full buffer is written asynchronously
+ * while the builder fills the other one.  At most one write is in flight,
+ * and vbb_finish() waits for it to complete.
  */
+struct vblock_wreq {
+    struct vblock_builder *bld;
+    uint64_t               blkid;
+    void                  *buf;
+    unsigned int           len;
+};
+
 struct vblock_builder {
     struct mpool *             ds;
     struct cn *                cn;
@@ -101,8 +126,14 @@ struct vblock_builder {
     void *                     wbuf;
     off_t                      wbuf_off;
     unsigned int               wbuf_len;
+    void *                     wbufv[2];
+    struct mblk_aio            aio;
+    struct vblock_wreq         wreq;
     uint64_t                   vgroup;
     bool                       destruct;
+    bool                       dict_rsvd;
+    void *                     dict;
+    uint32_t                   dict_len;
     uint32_t                   cur_minklen;
     char                       cur_minkey[HSE_KVS_KEY_LEN_MAX];
 };
@@ -110,7 +141,9 @@ struct vblock_builder {
 static inline bool
 vblock_has_room(const struct vblock_builder *bld, size_t vlen)
 {
-    return bld->vblk_off + vlen <= (bld->max_size - VBLOCK_FOOTER_LEN);
+    size_t rsvd = VBLOCK_FOOTER_LEN + (bld->dict_rsvd ? VBLOCK_DICT_LEN_MAX : 0);
+
+    return bld->vblk_off + vlen <= (bld->max_size - rsvd);
 }
 
 static inline uint32_t HSE_MAYBE_UNUSED
@@ -163,7 +196,7 @@ vblock_start(struct vblock_builder *bld, const struct key_obj *min_kobj)
 
     bld->vblk_off = bld->wbuf_off = 0;
     bld->blkid = blkid;
-    bld->wbuf_len = WBUF_LEN_MAX - VBLOCK_FOOTER_LEN; /* Reserve space for footer */
+    bld->wbuf_len = WBUF_LEN_MAX - VBLOCK_DICT_LEN_MAX - VBLOCK_FOOTER_LEN;
 
     /* Store a copy of the first key referencing this vblock.
      * It is written later to the vblock footer as the min key.
@@ -174,17 +207,17 @@ vblock_start(struct vblock_builder *bld, const struct key_obj *min_kobj)
 }
 
 static merr_t
-vblock_write(struct vblock_builder *bld)
+vblock_write_cb(void *arg)
 {
-    merr_t                 err;
-    struct iovec           iov;
+    struct vblock_wreq    *wreq = arg;
+    struct vblock_builder *bld = wreq->bld;
     struct cn_merge_stats *stats = bld->mstats;
+    struct iovec           iov;
     u64                    tstart;
+    merr_t                 err;
 
-    assert(bld->blkid);
-
-    iov.iov_base = bld->wbuf;
-    iov.iov_len = bld->wbuf_len;
+    iov.iov_base = wreq->buf;
+    iov.iov_len = wreq->len;
 
     /* Function mblk_blow_chunks(), which is used in the kblock builder,
      * is not needed here because our write buffer is already
@@ -192,20 +225,54 @@ vblock_write(struct vblock_builder *bld)
      */
     tstart = get_time_ns();
 
-    err = mpool_mblock_write(bld->ds, bld->blkid, &iov, 1);
+    err = mpool_mblock_write(bld->ds, wreq->blkid, &iov, 1);
 
     if (stats)
         count_ops(&stats->ms_vblk_write, 1, iov.iov_len, get_time_ns() - tstart);
 
+    if (ev(err))
+        return err;
+
+    perfc_inc(bld->pc, PERFC_RA_CNCOMP_WREQS);
+    perfc_add(bld->pc, PERFC_RA_CNCOMP_WBYTES, iov.iov_len);
+
+    return 0;
+}
+
+static merr_t
+vblock_write(struct vblock_builder *bld)
+{
+    struct vblock_wreq *wreq = &bld->wreq;
+    merr_t              err;
+
+    assert(bld->blkid);
+
+    /* Wait for the previous write so that its request and buffer
+     * may be reused.
+     */
+    err = mblk_aio_wait(&bld->aio);
     if (ev(err)) {
         bld->destruct = true;
         return err;
     }
 
-    bld->wbuf_off = 0;
+    wreq->bld = bld;
+    wreq->blkid = bld->blkid;
+    wreq->buf = bld->wbuf;
+    wreq->len = bld->wbuf_len;
 
-    perfc_inc(bld->pc, PERFC_RA_CNCOMP_WREQS);
-    perfc_add(bld->pc, PERFC_RA_CNCOMP_WBYTES, bld->wbuf_len);
+    err = mblk_aio_submit(&bld->aio, vblock_write_cb, wreq);
+    if (ev(err)) {
+        bld->destruct = true;
+        return err;
+    }
+
+    /* Continue filling the other buffer while this one is in flight.
+     */
+    if (bld->wbufv[1])
+        bld->wbuf = (bld->wbuf == bld->wbufv[0]) ? bld->wbufv[1] : bld->wbufv[0];
+
+    bld->wbuf_off = 0;
 
     return 0;
 }
@@ -230,6 +297,18 @@ vblock_finish(struct vblock_builder *bld, const struct key_obj *max_kobj)
     assert(bld->wbuf_off <= bld->wbuf_len);
     assert(vblock_unused_media_space(bld) >= VBLOCK_FOOTER_LEN);
 
+    /* The dictionary goes between the values and the footer.
+     */
+    if (bld->dict_len > 0) {
+        assert(bld->dict_rsvd);
+        assert(vblock_unused_media_space(bld) >= VBLOCK_DICT_LEN_MAX + VBLOCK_FOOTER_LEN);
+
+        zfill_len = PAGE_ALIGN(bld->dict_len) - bld->dict_len;
+        memcpy(bld->wbuf + bld->wbuf_off, bld->dict, bld->dict_len);
+        memset(bld->wbuf + bld->wbuf_off + bld->dict_len, 0, zfill_len);
+        bld->wbuf_off += bld->dict_len + zfill_len;
+    }
+
     vbfomf = bld->wbuf + bld->wbuf_off;
     memset(vbfomf, 0, VBLOCK_FOOTER_LEN);
 
@@ -240,7 +319,7 @@ vblock_finish(struct vblock_builder *bld, const struct key_obj *max_kobj)
     max_klen = key_obj_len(max_kobj);
     omf_set_vbf_min_klen(vbfomf, bld->cur_minklen);
     omf_set_vbf_max_klen(vbfomf, max_klen);
-    omf_set_vbf_rsvd(vbfomf, 0);
+    omf_set_vbf_dict_len(vbfomf, bld->dict_len);
 
     min_koff = bld->wbuf_off + VBLOCK_FOOTER_LEN - (2 * HSE_KVS_KEY_LEN_MAX);
     memcpy(bld->wbuf + min_koff, bld->cur_minkey, bld->cur_minklen);
@@ -288,6 +367,9 @@ vbb_create(
     bld->vgroup = vgroup;
     bld->agegroup = HSE_MPOLICY_AGE_LEAF;
     bld->wbuf = wbuf;
+    bld->wbufv[0] = wbuf;
+
+    mblk_aio_init(&bld->aio, NULL);
 
     policy = cn_get_mclass_policy(bld->cn);
 
@@ -310,10 +392,17 @@ vbb_destroy(struct vblock_builder *bld)
     if (ev(!bld))
         return;
 
+    /* Wait for the in-flight write (if any) before deleting its mblock.
+     */
+    mblk_aio_fini(&bld->aio);
+
     delete_mblocks(bld->ds, &bld->vblk_list);
     blk_list_free(&bld->vblk_list);
 
-    vlb_free(bld->wbuf, WBUF_LEN_MAX + sizeof(*bld));
+    free(bld->dict);
+
+    vlb_free(bld->wbufv[1], WBUF_LEN_MAX);
+    vlb_free(bld->wbufv[0], WBUF_LEN_MAX + sizeof(*bld));
 }
 
 /* Add a value to vblock.  Create new vblock if needed. */
@@ -404,6 +493,10 @@ vbb_finish(struct vblock_builder *bld, struct blk_list *vblks, const struct key_
     if (ev(err))
         return err;
 
+    err = mblk_aio_wait(&bld->aio);
+    if (ev(err))
+        return err;
+
     /* Transfer ownership of blk_list and the mblocks in
      * the blk_list to caller  */
     *vblks = bld->vblk_list;
@@ -445,6 +538,45 @@ vbb_set_merge_stats(struct vblock_builder *bld, struct cn_merge_stats *stats)
     bld->mstats = stats;
 }
 
+void
+vbb_set_wq(struct vblock_builder *bld, struct workqueue_struct *wq)
+{
+    assert(!bld->blkid);
+
+    if (!wq || bld->wbufv[1])
+        return;
+
+    bld->wbufv[1] = vlb_alloc(WBUF_LEN_MAX);
+    if (ev(!bld->wbufv[1]))
+        return;
+
+    mblk_aio_set_wq(&bld->aio, wq);
+}
+
+merr_t
+vbb_set_dict(struct vblock_builder *bld, const void *dict, uint dictlen)
+{
+    if (!dict) {
+        if (ev(bld->blkid && !bld->dict_rsvd))
+            return merr(EINVAL);
+
+        bld->dict_rsvd = true;
+        return 0;
+    }
+
+    if (ev(!bld->dict_rsvd || bld->dict || !dictlen || dictlen > VBLOCK_DICT_LEN_MAX))
+        return merr(EINVAL);
+
+    bld->dict = malloc(dictlen);
+    if (ev(!bld->dict))
+        return merr(ENOMEM);
+
+    memcpy(bld->dict, dict, dictlen);
+    bld->dict_len = dictlen;
+
+    return 0;
+}
+
 #if HSE_MOCKING
 #include "vblock_builder_ut_impl.i"
 #endif /* HSE_MOCKING */
@@ -16,6 +16,7 @@ struct vblock_builder;
 struct blk_list;
 struct kvs_rparams;
 struct cn_merge_stats;
+struct workqueue_struct;
 
 enum hse_mclass;
 enum hse_mclass_policy_age;
@@ -124,6 +125,32 @@ vbb_get_agegroup(const struct vblock_builder *bld);
 void
 vbb_set_merge_stats(struct vblock_builder *bld, struct cn_merge_stats *stats);
 
+/**
+ * vbb_set_wq() - Issue vblock writes asynchronously
+ * @bld: vblock builder
+ * @wq:  write workqueue
+ *
+ * Must be called before the first value is added.  If the second write
+ * buffer cannot be allocated the builder silently remains synchronous.
+ */
+void
+vbb_set_wq(struct vblock_builder *bld, struct workqueue_struct *wq);
+
+/**
+ * vbb_set_dict() - Store a value compression dictionary in the vblocks
+ * @bld:     vblock builder
+ * @dict:    dictionary, or NULL to only reserve space for one
+ * @dictlen: length of @dict (at most VBLOCK_DICT_LEN_MAX)
+ *
+ * Space for the dictionary must be reserved (by calling with a NULL @dict)
+ * before the first value is added.  The dictionary itself may be set once,
+ * at any time thereafter, and is then stored in the current and all
+ * subsequent vblocks.  Values compressed with the dictionary must not be
+ * added until it has been set.
+ */
+merr_t
+vbb_set_dict(struct vblock_builder *bld, const void *dict, uint dictlen);
+
 #if HSE_MOCKING
 #include "vblock_builder_ut.h"
 #endif /* HSE_MOCKING */
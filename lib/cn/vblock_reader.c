@@ -16,6 +16,7 @@
 #include <mpool/mpool.h>
 
 #include <hse_ikvdb/tuple.h>
+#include <hse_util/compression_zstd.h>
 
 #include "omf.h"
 #include "vblock_reader.h"
@@ -34,7 +35,7 @@ vbr_desc_read(
     bool     supported;
     void    *base;
     u64      vgroup;
-    uint32_t vers;
+    uint32_t vers, dict_len;
 
     base = mpool_mcache_getbase(map, idx);
     if (ev(!base))
@@ -44,10 +45,15 @@ vbr_desc_read(
     vgroup = omf_vbf_vgroup(footer);
     vers = omf_vbf_version(footer);
 
-    supported = (omf_vbf_magic(footer) == VBLOCK_FOOTER_MAGIC && vers == VBLOCK_FOOTER_VERSION);
+    supported = (omf_vbf_magic(footer) == VBLOCK_FOOTER_MAGIC &&
+                 (vers == VBLOCK_FOOTER_VERSION || vers == VBLOCK_FOOTER_VERSION1));
     if (ev(!supported))
         return merr(EPROTO);
 
+    dict_len = (vers >= VBLOCK_FOOTER_VERSION2) ? omf_vbf_dict_len(footer) : 0;
+    if (ev(PAGE_ALIGN(dict_len) + VBLOCK_FOOTER_LEN > props->mpr_write_len))
+        return merr(EPROTO);
+
     memset(vblk_desc, 0, sizeof(*vblk_desc));
     vblk_desc->vbd_mblkdesc.map_base = base;
     vblk_desc->vbd_mblkdesc.mbid = props->mpr_objid;
@@ -55,18 +61,30 @@ vbr_desc_read(
     vblk_desc->vbd_mblkdesc.map_idx = idx;
     vblk_desc->vbd_mblkdesc.mclass = props->mpr_mclass;
     vblk_desc->vbd_off = 0;
-    vblk_desc->vbd_len = props->mpr_write_len - VBLOCK_FOOTER_LEN;
+    vblk_desc->vbd_len = props->mpr_write_len - VBLOCK_FOOTER_LEN - PAGE_ALIGN(dict_len);
+    vblk_desc->vbd_dict_off = vblk_desc->vbd_len;
+    vblk_desc->vbd_dict_len = dict_len;
     vblk_desc->vbd_vgroup = vgroup;
-    vblk_desc->vbd_min_koff = vblk_desc->vbd_len + VBLOCK_FOOTER_LEN - (2 * HSE_KVS_KEY_LEN_MAX);
+    vblk_desc->vbd_min_koff = props->mpr_write_len - (2 * HSE_KVS_KEY_LEN_MAX);
     vblk_desc->vbd_min_klen = omf_vbf_min_klen(footer);
     vblk_desc->vbd_max_koff = vblk_desc->vbd_min_koff + HSE_KVS_KEY_LEN_MAX;
     vblk_desc->vbd_max_klen = omf_vbf_max_klen(footer);
     atomic_set(&vblk_desc->vbd_vgidx, 1);
     atomic_set(&vblk_desc->vbd_refcnt, 0);
+    atomic_set(&vblk_desc->vbd_dict, 0);
 
     return 0;
 }
 
+void
+vbr_desc_fini(struct vblock_desc *vblk_desc)
+{
+#ifdef HAVE_ZSTD
+    compress_zstd_dict_destroy((void *)atomic_read(&vblk_desc->vbd_dict));
+#endif
+    atomic_set(&vblk_desc->vbd_dict, 0);
+}
+
 merr_t
 vbr_desc_update(
     struct mpool *           ds,
@@ -269,3 +287,37 @@ vbr_value(struct vblock_desc *vbd, uint vboff, uint vlen)
     assert(vboff + vlen <= vbd->vbd_len);
     return vbd->vbd_mblkdesc.map_base + vbd->vbd_off + vboff;
 }
+
+const struct compress_dict *
+vbr_dict(struct vblock_desc *vbd)
+{
+    struct compress_dict *dict = NULL;
+
+    if (!vbd->vbd_dict_len)
+        return NULL;
+
+    dict = (void *)atomic_read_acq(&vbd->vbd_dict);
+
+#ifdef HAVE_ZSTD
+    if (!dict) {
+        uintptr_t old = 0;
+        merr_t err;
+
+        assert(vbd->vbd_mblkdesc.map_base);
+
+        err = compress_zstd_dict_create(vbd->vbd_mblkdesc.map_base + vbd->vbd_dict_off,
+                                        vbd->vbd_dict_len, false, &dict);
+        if (ev(err))
+            return NULL;
+
+        /* Another thread may have raced us to digest the dictionary.
+         */
+        if (!atomic_cmpxchg(&vbd->vbd_dict, &old, (uintptr_t)dict)) {
+            compress_zstd_dict_destroy(dict);
+            dict = (void *)old;
+        }
+    }
+#endif
+
+    return dict;
+}
@@ -23,6 +23,7 @@
 struct mpool;
 struct mpool_mcache_map;
 struct mblock_props;
+struct compress_dict;
 
 /**
  * struct ra_hist - readahead history cache record
@@ -59,9 +60,12 @@ struct vblock_desc {
     uint32_t             vbd_max_koff; /* max key offset */
     uint16_t             vbd_min_klen; /* min key length */
     uint16_t             vbd_max_klen; /* max key length */
+    uint32_t             vbd_dict_off; /* compression dictionary offset */
+    uint32_t             vbd_dict_len; /* compression dictionary length */
     uint64_t             vbd_vgroup;   /* vblock group ID (kvset id) */
     atomic_int           vbd_vgidx;    /* vblock group index */
     atomic_int           vbd_refcnt;   /* vbr_madvise_async() refcnt */
+    atomic_uintptr_t     vbd_dict;     /* digested dictionary (see vbr_dict()) */
 };
 
 /**
@@ -78,6 +82,13 @@ vbr_desc_read(
     struct mblock_props *    props,
     struct vblock_desc *     vblock_desc);
 
+/**
+ * vbr_desc_fini() - Release resources cached in a vblock descriptor
+ * @vlock_desc:    vblock descriptor
+ */
+void
+vbr_desc_fini(struct vblock_desc *vblock_desc);
+
 merr_t
 vbr_desc_update(
     struct mpool *           ds,
@@ -135,4 +146,14 @@ vbr_madvise(struct vblock_desc *vbd, uint off, uint len, int advice);
 void *
 vbr_value(struct vblock_desc *vbd, uint vboff, uint vlen);
 
+/**
+ * vbr_dict() - Get the compression dictionary of a vblock
+ * @vbd:   vblock descriptor
+ *
+ * Returns NULL if the vblock has no dictionary.  The dictionary is
+ * digested on first use and cached in @vbd until vbr_desc_fini().
+ */
+const struct compress_dict *
+vbr_dict(struct vblock_desc *vbd);
+
 #endif
@@ -3,9 +3,40 @@
  * Copyright (C) 2020-2022 Micron Technology, Inc.  All rights reserved.
  */
 
+#include <hse_util/event_counter.h>
 #include <hse_ikvdb/vcomp_params.h>
 #include <hse_util/compression_lz4.h>
+#include <hse_util/compression_zstd.h>
 
 const struct compress_ops *vcomp_compress_ops[VCOMP_ALGO_COUNT] = {
-    &compress_lz4_ops,
+    [VCOMP_ALGO_LZ4] = &compress_lz4_ops,
+#ifdef HAVE_ZSTD
+    [VCOMP_ALGO_ZSTD] = &compress_zstd_ops,
+    [VCOMP_ALGO_ZSTD_DICT] = &compress_zstd_ops,
+#endif
 };
+
+bool
+vcomp_dict_tagged(const void *src)
+{
+    return compress_zstd_dict_tagged(src);
+}
+
+merr_t
+vcomp_decompress(
+    const void                 *src,
+    uint                        src_len,
+    const struct compress_dict *dict,
+    void                       *dst,
+    uint                        dst_capacity,
+    uint                       *dst_len)
+{
+    if (!compress_zstd_tagged(src))
+        return compress_lz4_ops.cop_decompress(src, src_len, dst, dst_capacity, dst_len);
+
+#ifdef HAVE_ZSTD
+    return compress_zstd_dict_decompress(dict, src, src_len, dst, dst_capacity, dst_len);
+#else
+    return merr(ev(ENOTSUP));
+#endif
+}
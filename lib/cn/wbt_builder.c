@@ -10,6 +10,7 @@
 #include <hse_util/vlb.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/key_util.h>
+#include <hse_util/compression_lz4.h>
 
 #include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/omf_kmd.h>
@@ -42,6 +43,10 @@
  * @wbt_first_kobj: first key (aka, min key in wb tree)
  * @wbt_last_kobj: last key (aka, max key in wb tree)
  * @sum_right_keys: total length of right-most keys in all leaf nodes
+ * @compress: compress leaf nodes when the tree is frozen
+ * @cleafv: output buffer for the compressed leaf region
+ * @cleafv_pgc: allocated length of cleafv in pages
+ * @cenc: scratch buffer for the prefix-delta encoding of a leaf node
  *
  * Notes:
  *   @max_pages tracks the max number of pages that can be used by the wbtree.
@@ -86,6 +91,11 @@ struct wbb {
 
     uint         kmd_iov_index;
     struct iovec kmd_iov[KMD_CHUNKS + 1];
+
+    bool  compress;
+    void *cleafv;
+    uint  cleafv_pgc;
+    void *cenc;
 };
 
 struct key_stage_entry_leaf {
@@ -498,6 +508,137 @@ wbb_add_entry(
     return 0;
 }
 
+/* Encode a published leaf node: The node header, prefix and lfe array
+ * are copied verbatim, each key suffix (in lfe order) is stored as the
+ * length of the prefix it shares with the preceding suffix followed by
+ * its optional 4-byte kmd offset and its unshared bytes.
+ *
+ * Returns the length of the encoding, or zero if it doesn't fit.
+ */
+static uint
+wbt_leaf_encode(const void *node, void *buf, uint bufsz)
+{
+    const struct wbt_node_hdr_omf *hdr = node;
+    const void *prev = NULL;
+    uint prevlen = 0, head, nkeys, end, i;
+    void *out = buf;
+
+    nkeys = omf_wbn_num_keys(hdr);
+    head = sizeof(*hdr) + omf_wbn_pfx_len(hdr) + nkeys * sizeof(struct wbt_lfe_omf);
+    if (head > bufsz)
+        return 0;
+
+    memcpy(out, node, head);
+    out += head;
+    end = WBT_NODE_SIZE;
+
+    for (i = 0; i < nkeys; i++) {
+        const struct wbt_lfe_omf *lfe = wbt_lfe(node, i);
+        uint koff = omf_lfe_koff(lfe);
+        uint extra = (omf_lfe_kmd(lfe) == U16_MAX) ? 4 : 0;
+        const void *sfx = node + koff + extra;
+        uint sfxlen = end - koff - extra;
+        uint shared;
+
+        shared = memlcp(prev, sfx, min_t(uint, prevlen, sfxlen));
+
+        if (out + 3 + extra + sfxlen - shared > buf + bufsz)
+            return 0;
+
+        if (shared < WBT_CLEAF_SHARED_X) {
+            *(uint8_t *)out++ = shared;
+        } else {
+            *(uint8_t *)out++ = WBT_CLEAF_SHARED_X;
+            *(uint8_t *)out++ = shared & 0xff;
+            *(uint8_t *)out++ = shared >> 8;
+        }
+
+        memcpy(out, node + koff, extra);
+        out += extra;
+        memcpy(out, sfx + shared, sfxlen - shared);
+        out += sfxlen - shared;
+
+        prev = sfx;
+        prevlen = sfxlen;
+        end = koff;
+    }
+
+    return out - buf;
+}
+
+/* Compress the leaf nodes into wbb->cleafv.  The compressed region
+ * comprises a table of (leafc + 1) leaf offsets followed by the
+ * lz4 compressed encodings of the leaves (see omf.h).
+ *
+ * Returns the size of the compressed region in pages, or zero if
+ * compression doesn't save at least one page.
+ */
+static uint
+wbb_leaf_compress(struct wbb *wbb, uint leafc)
+{
+    uint32_t *offv;
+    size_t    off, cap;
+    uint      i;
+
+    if (leafc < 2)
+        return 0;
+
+    if (wbb->cleafv_pgc < leafc) {
+        free(wbb->cleafv);
+
+        wbb->cleafv_pgc = 0;
+        wbb->cleafv = aligned_alloc(PAGE_SIZE, (size_t)leafc * PAGE_SIZE);
+        if (ev(!wbb->cleafv))
+            return 0;
+
+        wbb->cleafv_pgc = leafc;
+    }
+
+    if (!wbb->cenc) {
+        wbb->cenc = malloc(WBT_CLEAF_LEN_MAX);
+        if (ev(!wbb->cenc))
+            return 0;
+    }
+
+    /* The compressed region must be at least one page smaller than
+     * the uncompressed leaves for compression to be worthwhile.
+     */
+    cap = (size_t)(leafc - 1) * PAGE_SIZE;
+    offv = wbb->cleafv;
+    off = (leafc + 1) * sizeof(*offv);
+
+    for (i = 0; i < leafc; i++) {
+        uint len, clen;
+        merr_t err;
+
+        if (off >= cap)
+            return 0;
+
+        len = wbt_leaf_encode(wbb->nodev + (size_t)i * PAGE_SIZE, wbb->cenc, WBT_CLEAF_LEN_MAX);
+        if (!len)
+            return 0;
+
+        err = compress_lz4_ops.cop_compress(wbb->cenc, len, wbb->cleafv + off,
+                                            min_t(size_t, cap - off, WBT_CLEAF_LEN_MAX), &clen);
+        if (err)
+            return 0;
+
+        offv[i] = cpu_to_omf32(off);
+        off += clen;
+    }
+
+    offv[leafc] = cpu_to_omf32(off);
+    memset(wbb->cleafv + off, 0, PAGE_ALIGN(off) - off);
+
+    return PAGE_ALIGN(off) / PAGE_SIZE;
+}
+
+void
+wbb_set_compress(struct wbb *wbb, bool compress)
+{
+    wbb->compress = compress;
+}
+
 void
 wbb_hdr_init(struct wbt_hdr_omf *hdr)
 {
@@ -515,6 +656,7 @@ wbb_hdr_set(struct wbt_hdr_omf *hdr, struct wbt_desc *desc)
     omf_set_wbt_leaf_cnt(hdr, desc->wbd_leaf_cnt);
     omf_set_wbt_root(hdr, desc->wbd_root);
     omf_set_wbt_kmd_pgc(hdr, desc->wbd_kmd_pgc);
+    omf_set_wbt_leaf_pgc(hdr, desc->wbd_leaf_pgc);
 }
 
 merr_t
@@ -528,7 +670,7 @@ wbb_freeze(
     uint *              iov_cnt_out) /* out */
 {
     uint first_leaf_node, num_leaf_nodes, root_node;
-    uint i, kmd_pgc;
+    uint i, kmd_pgc, leaf_pgc = 0;
     uint iov_cnt = 0;
 
     assert(*wbt_pgc <= max_pgc);
@@ -563,6 +705,17 @@ wbb_freeze(
     iov[0].iov_base = wbb->nodev;
     iov[0].iov_len = num_leaf_nodes * PAGE_SIZE;
 
+    if (wbb->compress) {
+        leaf_pgc = wbb_leaf_compress(wbb, num_leaf_nodes);
+        if (leaf_pgc) {
+            assert(leaf_pgc < num_leaf_nodes);
+
+            iov[0].iov_base = wbb->cleafv;
+            iov[0].iov_len = leaf_pgc * PAGE_SIZE;
+            wbb->used_pgc -= num_leaf_nodes - leaf_pgc;
+        }
+    }
+
     root_node = wbb->lnodec + wbb->max_inodec - 1;
     wbb->used_pgc += wbb->max_inodec;
 
@@ -582,6 +735,7 @@ wbb_freeze(
     omf_set_wbt_leaf_cnt(hdr, num_leaf_nodes);
     omf_set_wbt_root(hdr, root_node);
     omf_set_wbt_kmd_pgc(hdr, kmd_pgc);
+    omf_set_wbt_leaf_pgc(hdr, leaf_pgc);
 
     for (i = 0; i <= wbb->kmd_iov_index; i++) {
         size_t len = wbb->kmd_iov[i].iov_len;
@@ -607,8 +761,10 @@ merr_t
 wbb_init(struct wbb *wbb, void *nodev, uint max_pgc, uint *wbt_pgc)
 {
     void  *kst_base, *kst_end, *iov_base[KMD_CHUNKS + 1];
+    void  *cleafv, *cenc;
     struct intern_builder *ibldr;
-    uint   kst_pgc;
+    uint   kst_pgc, cleafv_pgc;
+    bool   compress;
     uint   i;
     merr_t err;
 
@@ -620,6 +776,10 @@ wbb_init(struct wbb *wbb, void *nodev, uint max_pgc, uint *wbt_pgc)
     for (i = 0; wbb->kmd_iov[i].iov_base; i++)
         iov_base[i] = wbb->kmd_iov[i].iov_base;
     iov_base[i] = NULL;
+    compress = wbb->compress;
+    cleafv = wbb->cleafv;
+    cleafv_pgc = wbb->cleafv_pgc;
+    cenc = wbb->cenc;
 
     /* Reset */
     memset(wbb, 0, sizeof(*wbb));
@@ -630,6 +790,10 @@ wbb_init(struct wbb *wbb, void *nodev, uint max_pgc, uint *wbt_pgc)
     wbb->cnode_key_stage_pgc = kst_pgc;
     for (i = 0; iov_base[i]; i++)
         wbb->kmd_iov[i].iov_base = iov_base[i];
+    wbb->compress = compress;
+    wbb->cleafv = cleafv;
+    wbb->cleafv_pgc = cleafv_pgc;
+    wbb->cenc = cenc;
 
     /* Init new params */
     wbb->max_pgc = max_pgc;
@@ -747,6 +911,8 @@ wbb_destroy(struct wbb *wbb)
             vlb_free(wbb->kmd_iov[i].iov_base, KMD_CHUNK_LEN);
         free(wbb->nodev);
         free(wbb->cnode_key_stage_base);
+        free(wbb->cleafv);
+        free(wbb->cenc);
         free(wbb);
     }
 }
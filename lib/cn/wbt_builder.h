@@ -39,6 +39,12 @@ wbb_reset(struct wbb *wbb, uint *wbt_pgc);
 void
 wbb_destroy(struct wbb *wbb);
 
+/* Enable or disable compression of leaf nodes by wbb_freeze().  The
+ * setting persists across wbb_reset().
+ */
+void
+wbb_set_compress(struct wbb *wbb, bool compress);
+
 /* Get the number of keys stored in a wbtree under construction.
  */
 uint
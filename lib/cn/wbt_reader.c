@@ -3,6 +3,7 @@
  * Copyright (C) 2015-2022 Micron Technology, Inc.  All rights reserved.
  */
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <sys/mman.h>
 
@@ -14,12 +15,16 @@
 #include <hse_util/event_counter.h>
 #include <hse_util/keycmp.h>
 #include <hse_util/compiler.h>
+#include <hse_util/compression_lz4.h>
+#include <hse/logging/logging.h>
 
 #include <hse/limits.h>
 
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/omf_kmd.h>
 
+#include <mpool/mpool.h>
+
 #include "wbt_internal.h"
 #include "omf.h"
 #include "kvs_mblk_desc.h"
@@ -35,6 +40,259 @@
 
 static struct kmem_cache *wbti_cache HSE_READ_MOSTLY;
 
+/* Point lookups that go through the mpool block cache copy one wbtree node
+ * at a time into this buffer.  A lookup visits the nodes on its path from
+ * root to leaf strictly in order, so a single page suffices.
+ */
+static thread_local char wbtr_pgbuf[PAGE_SIZE] HSE_ALIGNED(PAGE_SIZE);
+
+/* Scratch buffer for the prefix-delta encoded form of a compressed leaf.
+ */
+static thread_local char wbtr_dbuf[WBT_CLEAF_LEN_MAX];
+
+/* Point lookups in trees with compressed leaves decode leaf nodes into a
+ * small per-thread cache tagged by tree generation and leaf index, so that
+ * lookups which repeatedly land in the same (hot) leaves decode them once.
+ */
+#define WBTR_LCACHE_SLOTS (32)
+
+struct wbtr_lcache {
+    char     lc_pagev[WBTR_LCACHE_SLOTS][WBT_NODE_SIZE];
+    char     lc_cbuf[WBT_CLEAF_LEN_MAX + PAGE_SIZE];
+    uint64_t lc_tagv[WBTR_LCACHE_SLOTS];
+};
+
+static thread_local struct wbtr_lcache *wbtr_lcache;
+
+static pthread_once_t wbtr_lcache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  wbtr_lcache_key;
+
+static atomic_ulong wbtr_gen;
+
+/**
+ * struct wbtr_pgsrc - source of wbtree node pages for point lookups
+ * @base: base address of the mcache map of the kblock
+ * @mp:   mpool for block cache reads (NULL to read via @base)
+ * @mbid: kblock mblock id
+ */
+struct wbtr_pgsrc {
+    const void   *base;
+    struct mpool *mp;
+    uint64_t      mbid;
+};
+
+static const void *
+wbtr_pgsrc_get(const struct wbtr_pgsrc *src, size_t pg)
+{
+    merr_t err;
+
+    if (!src->mp)
+        return src->base + pg * PAGE_SIZE;
+
+    err = mpool_mblock_read_cached(src->mp, src->mbid, wbtr_pgbuf, PAGE_SIZE, pg * PAGE_SIZE,
+                                   MPOOL_BCACHE_PRIO_INDEX);
+    if (ev(err))
+        return src->base + pg * PAGE_SIZE;
+
+    return wbtr_pgbuf;
+}
+
+static void
+wbtr_lcache_dtor(void *arg)
+{
+    free(arg);
+}
+
+static void
+wbtr_lcache_once_init(void)
+{
+    int rc HSE_MAYBE_UNUSED;
+
+    rc = pthread_key_create(&wbtr_lcache_key, wbtr_lcache_dtor);
+    assert(rc == 0);
+}
+
+static struct wbtr_lcache *
+wbtr_lcache_get(void)
+{
+    struct wbtr_lcache *lc = wbtr_lcache;
+
+    if (HSE_UNLIKELY(!lc)) {
+        lc = aligned_alloc(PAGE_SIZE, roundup(sizeof(*lc), PAGE_SIZE));
+        if (ev(!lc))
+            return NULL;
+
+        memset(lc->lc_tagv, 0, sizeof(lc->lc_tagv));
+
+        /* Register the destructor so that the cache is freed on thread exit.
+         */
+        pthread_once(&wbtr_lcache_once, wbtr_lcache_once_init);
+        pthread_setspecific(wbtr_lcache_key, lc);
+
+        wbtr_lcache = lc;
+    }
+
+    return lc;
+}
+
+merr_t
+wbt_leaf_span(const void *base, const struct wbt_desc *wbd, uint idx, size_t *off, uint *len)
+{
+    const uint32_t *offv = base + (size_t)wbd->wbd_first_page * PAGE_SIZE;
+    uint32_t        start, end;
+
+    assert(wbd->wbd_leaf_pgc > 0);
+    assert(idx < wbd->wbd_leaf_cnt);
+
+    start = omf32_to_cpu(offv[idx]);
+    end = omf32_to_cpu(offv[idx + 1]);
+
+    if (ev(start >= end || end - start > WBT_CLEAF_LEN_MAX ||
+           end > (size_t)wbd->wbd_leaf_pgc * PAGE_SIZE))
+        return merr(EPROTO);
+
+    *off = (size_t)wbd->wbd_first_page * PAGE_SIZE + start;
+    *len = end - start;
+
+    return 0;
+}
+
+merr_t
+wbt_leaf_decode(const void *src, uint srclen, void *node)
+{
+    const struct wbt_node_hdr_omf *hdr;
+    const uint8_t *in, *inend;
+    const void *prev = NULL;
+    uint prevlen = 0, head, nkeys, end, dlen, i;
+    merr_t err;
+
+    err = compress_lz4_ops.cop_decompress(src, srclen, wbtr_dbuf, sizeof(wbtr_dbuf), &dlen);
+    if (ev(err))
+        return err;
+
+    hdr = (const void *)wbtr_dbuf;
+    if (ev(dlen < sizeof(*hdr) || omf_wbn_magic(hdr) != WBT_LFE_NODE_MAGIC))
+        return merr(EPROTO);
+
+    nkeys = omf_wbn_num_keys(hdr);
+    head = sizeof(*hdr) + omf_wbn_pfx_len(hdr) + nkeys * sizeof(struct wbt_lfe_omf);
+    if (ev(head > dlen || head > WBT_NODE_SIZE))
+        return merr(EPROTO);
+
+    /* The node header, prefix and lfe array are stored verbatim, followed
+     * by the prefix-delta encoded key suffixes in lfe order.  Suffixes are
+     * placed exactly where wbt_leaf_publish() put them, i.e., descending
+     * from the end of the node.
+     */
+    memcpy(node, wbtr_dbuf, head);
+    memset(node + head, 0, WBT_NODE_SIZE - head);
+
+    in = (const uint8_t *)wbtr_dbuf + head;
+    inend = (const uint8_t *)wbtr_dbuf + dlen;
+    end = WBT_NODE_SIZE;
+
+    for (i = 0; i < nkeys; i++) {
+        const struct wbt_lfe_omf *lfe = wbt_lfe(node, i);
+        uint koff = omf_lfe_koff(lfe);
+        uint extra = (omf_lfe_kmd(lfe) == U16_MAX) ? 4 : 0;
+        uint shared, sfxlen;
+        void *dst;
+
+        if (ev(koff < head || koff + extra > end || in >= inend))
+            return merr(EPROTO);
+
+        sfxlen = end - koff - extra;
+
+        shared = *in++;
+        if (shared == WBT_CLEAF_SHARED_X) {
+            if (ev(inend - in < 2))
+                return merr(EPROTO);
+
+            shared = in[0] | (in[1] << 8);
+            in += 2;
+        }
+
+        if (ev(shared > prevlen || shared > sfxlen || inend - in < extra + sfxlen - shared))
+            return merr(EPROTO);
+
+        dst = node + koff;
+        memcpy(dst, in, extra);
+        in += extra;
+        dst += extra;
+
+        if (shared)
+            memcpy(dst, prev, shared);
+        memcpy(dst + shared, in, sfxlen - shared);
+        in += sfxlen - shared;
+
+        prev = dst;
+        prevlen = sfxlen;
+        end = koff;
+    }
+
+    return ev(in != inend) ? merr(EPROTO) : 0;
+}
+
+/* Get leaf node %node_num for a point lookup.
+ */
+static const struct wbt_node_hdr_omf *
+wbtr_leaf_get(const struct wbtr_pgsrc *src, const struct wbt_desc *wbd, uint node_num, merr_t *errp)
+{
+    struct wbtr_lcache *lc;
+    const void *cleaf;
+    uint64_t tag;
+    size_t off;
+    uint len, slot;
+    merr_t err;
+
+    if (!wbd->wbd_leaf_pgc)
+        return wbtr_pgsrc_get(src, wbt_node_pg(wbd, node_num));
+
+    lc = wbtr_lcache_get();
+    if (ev(!lc)) {
+        *errp = merr(ENOMEM);
+        return NULL;
+    }
+
+    assert(wbd->wbd_gen > 0);
+    tag = (wbd->wbd_gen << 16) | node_num;
+    slot = (wbd->wbd_gen * 31 + node_num) % WBTR_LCACHE_SLOTS;
+
+    if (lc->lc_tagv[slot] == tag)
+        return (const void *)lc->lc_pagev[slot];
+
+    lc->lc_tagv[slot] = 0;
+
+    err = wbt_leaf_span(src->base, wbd, node_num, &off, &len);
+    if (ev(err)) {
+        *errp = err;
+        return NULL;
+    }
+
+    cleaf = src->base + off;
+
+    if (src->mp) {
+        size_t pgoff = off & ~(PAGE_SIZE - 1);
+
+        err = mpool_mblock_read_cached(src->mp, src->mbid, lc->lc_cbuf,
+                                       PAGE_ALIGN(off + len) - pgoff, pgoff,
+                                       MPOOL_BCACHE_PRIO_INDEX);
+        if (!ev(err))
+            cleaf = lc->lc_cbuf + (off - pgoff);
+    }
+
+    err = wbt_leaf_decode(cleaf, len, lc->lc_pagev[slot]);
+    if (ev(err)) {
+        log_err("mbid 0x%lx leaf %u: corrupt compressed leaf node", src->mbid, node_num);
+        *errp = err;
+        return NULL;
+    }
+
+    lc->lc_tagv[slot] = tag;
+
+    return (const void *)lc->lc_pagev[slot];
+}
+
 void
 wbt_read_kmd_vref(
     const void            *kmd,
@@ -50,7 +308,7 @@ wbt_read_kmd_vref(
     uint           complen = 0;
     const void *   vdata = 0;
 
-    kmd_type_seq(kmd, off, &vtype, seq);
+    kmd_type_seq_expire(kmd, off, &vtype, seq, &vref->vr_expire);
 
     switch (vtype) {
         case VTYPE_UCVAL:
@@ -82,6 +340,25 @@ wbt_read_kmd_vref(
             assert(vlen <= U32_MAX);
             vref->vi.vr_data = vdata;
             vref->vi.vr_len = vlen;
+            vref->vi.vr_complen = 0;
+            break;
+        case VTYPE_LIVAL:
+            kmd_lival(kmd, off, &vdata, &vlen);
+            vref->vi.vr_data = vdata;
+            vref->vi.vr_len = vlen;
+            vref->vi.vr_complen = 0;
+            break;
+        case VTYPE_MVAL:
+            kmd_mval(kmd, off, &vdata, &vlen);
+            vref->vi.vr_data = vdata;
+            vref->vi.vr_len = vlen;
+            vref->vi.vr_complen = 0;
+            break;
+        case VTYPE_CIVAL:
+            kmd_cival(kmd, off, &vdata, &vlen, &complen);
+            vref->vi.vr_data = vdata;
+            vref->vi.vr_len = vlen;
+            vref->vi.vr_complen = complen;
             break;
         case VTYPE_ZVAL:
         case VTYPE_TOMB:
@@ -107,8 +384,26 @@ wbti_get_page(struct wbti *self, u32 node_idx)
 
     assert(node_idx != self->node_idx || self->node == NULL);
 
-    mblock_offset = PAGE_SIZE * (node_idx + self->wbd->wbd_first_page);
-    self->node = self->base + mblock_offset;
+    if (self->wbd->wbd_leaf_pgc) {
+        merr_t err;
+        uint   len;
+
+        /* Iterators cannot fail, hence a corrupt leaf is fatal (as is
+         * a corrupt kmd, see wbt_read_kmd_vref()).
+         */
+        err = wbt_leaf_span(self->base, self->wbd, node_idx, &mblock_offset, &len);
+        if (!err)
+            err = wbt_leaf_decode(self->base + mblock_offset, len, self->lbuf);
+        if (err) {
+            log_errx("corrupt compressed leaf node %u", err, node_idx);
+            abort();
+        }
+
+        self->node = self->lbuf;
+    } else {
+        mblock_offset = PAGE_SIZE * wbt_node_pg(self->wbd, node_idx);
+        self->node = self->base + mblock_offset;
+    }
 
     assert(omf_wbn_magic(self->node) == WBT_LFE_NODE_MAGIC);
 
@@ -117,8 +412,8 @@ wbti_get_page(struct wbti *self, u32 node_idx)
 }
 
 static int
-wbtr_seek_page(
-    const void *base,
+wbtr_seek_page_src(
+    const struct wbtr_pgsrc *src,
     const struct wbt_desc *wbd,
     const void *kt_data,
     uint kt_len,
@@ -129,24 +424,15 @@ wbtr_seek_page(
     uint                     cmplen;
     size_t                   pg;
 
-    /* pull struct derefs out of the loop */
-    uint first_page = wbd->wbd_first_page;
-
     /* search from root */
     node_num = wbd->wbd_root;
 
-    /* prefetch root node header */
-    __builtin_prefetch(base + (first_page + wbd->wbd_root) * PAGE_SIZE);
-
-    assert(0 <= node_num && node_num < wbd->wbd_n_pages);
-    pg = first_page + node_num;
-    node = base + pg * PAGE_SIZE;
-
-    while (omf_wbn_magic(node) == WBT_INE_NODE_MAGIC) {
+    /* Leaf nodes are numbered [0, wbd_leaf_cnt), internal nodes follow.
+     */
+    while (node_num >= wbd->wbd_leaf_cnt) {
         const struct wbt_ine_omf *ine;
 
-        int first = 0;
-        int last = omf_wbn_num_keys(node) - 1;
+        int first, last;
 
         const void *node_pfx;
         uint        node_pfx_len;
@@ -154,6 +440,14 @@ wbtr_seek_page(
         const void *kdata;
         uint        klen;
 
+        assert(0 <= node_num && node_num <= wbd->wbd_root);
+        pg = wbt_node_pg(wbd, node_num);
+        node = wbtr_pgsrc_get(src, pg);
+        assert(omf_wbn_magic(node) == WBT_INE_NODE_MAGIC);
+
+        first = 0;
+        last = omf_wbn_num_keys(node) - 1;
+
         wbt_node_pfx(node, &node_pfx, &node_pfx_len);
 
         /* Check if key's prefix lies within this node's range.
@@ -199,16 +493,27 @@ wbtr_seek_page(
 
         assert(omf_ine_left_child(ine) < node_num);
         node_num = omf_ine_left_child(ine);
-
-        assert(0 <= node_num && node_num < wbd->wbd_n_pages);
-        pg = first_page + node_num;
-        node = base + pg * PAGE_SIZE;
-        __builtin_prefetch(node);
     }
 
     return node_num;
 }
 
+static int
+wbtr_seek_page(
+    const void *base,
+    const struct wbt_desc *wbd,
+    const void *kt_data,
+    uint kt_len,
+    uint lcp)
+{
+    struct wbtr_pgsrc src = { .base = base };
+
+    /* prefetch root node header (the root immediately precedes kmd) */
+    __builtin_prefetch(base + (wbt_kmd_pg(wbd) - 1) * PAGE_SIZE);
+
+    return wbtr_seek_page_src(&src, wbd, kt_data, kt_len, lcp);
+}
+
 /*
  * Actions after prefix compare:
  *
@@ -270,7 +575,6 @@ wbti_seek_fwd(struct wbti *self, struct kvs_ktuple *kt)
     const struct wbt_node_hdr_omf *node;
     int                      j, cmp, node_num;
     int                      first, last, lfe_eof;
-    size_t                   pg;
     const void *             kdata, *kt_data;
     uint                     klen, kt_len, cmplen;
     const struct wbt_lfe_omf *lfe;
@@ -291,9 +595,8 @@ wbti_seek_fwd(struct wbti *self, struct kvs_ktuple *kt)
     node_num = wbtr_seek_page(self->base, wbd, kt_data, kt_len, 0);
     wbti_get_page(self, node_num);
 
-    assert(0 <= node_num && node_num < wbd->wbd_n_pages);
-    pg = wbd->wbd_first_page + node_num;
-    node = self->base + pg * PAGE_SIZE;
+    assert(0 <= node_num && node_num < wbd->wbd_leaf_cnt);
+    node = self->node;
 
     /* at leaf */
     assert(omf_wbn_magic(node) == WBT_LFE_NODE_MAGIC);
@@ -461,7 +764,6 @@ wbti_seek_rev(struct wbti *self, struct kvs_ktuple *kt)
     const struct wbt_node_hdr_omf *node;
     int                      cmp, node_num;
     int                      first, last, lfe_eof;
-    size_t                   pg;
     const void *             kdata, *kt_data;
     uint                     klen, kt_len, cmplen;
     const struct wbt_lfe_omf *lfe;
@@ -490,9 +792,8 @@ wbti_seek_rev(struct wbti *self, struct kvs_ktuple *kt)
 repeat:
     wbti_get_page(self, node_num);
 
-    assert(0 <= node_num && node_num < wbd->wbd_n_pages);
-    pg = wbd->wbd_first_page + node_num;
-    node = self->base + pg * PAGE_SIZE;
+    assert(0 <= node_num && node_num < wbd->wbd_leaf_cnt);
+    node = self->node;
 
     /* at leaf */
     assert(omf_wbn_magic(node) == WBT_LFE_NODE_MAGIC);
@@ -627,7 +928,7 @@ wbti_node_advance(struct wbti *self)
     if (self->node_idx + 1 < max_idx) {
         wbti_get_page(self, self->node_idx + 1);
 
-        if (self->node_idx + 2 < max_idx)
+        if (self->node_idx + 2 < max_idx && !self->wbd->wbd_leaf_pgc)
             __builtin_prefetch(self->node + PAGE_SIZE);
     } else {
         self->node_idx = NODE_EOF;
@@ -711,7 +1012,7 @@ wbti_next(struct wbti *self, const void **kdata, uint *klen, const void **kmd)
                          : wbti_next_fwd(self, kdata, klen, kmd);
 }
 
-void
+merr_t
 wbti_reset(
     struct wbti *self,
     const void *base,
@@ -720,12 +1021,21 @@ wbti_reset(
     bool reverse,
     bool cache)
 {
+    /* Leaves of compressed trees are decoded into a private buffer, which
+     * is retained across resets.
+     */
+    if (desc->wbd_leaf_pgc && !self->lbuf) {
+        self->lbuf = aligned_alloc(PAGE_SIZE, WBT_NODE_SIZE);
+        if (ev(!self->lbuf))
+            return merr(ENOMEM);
+    }
+
     /* self is not zeroed out so be sure to initialize all fields.
      */
     self->wbd = desc;
     self->base = base;
     self->node = NULL;
-    self->kmd = base + PAGE_SIZE * (self->wbd->wbd_first_page + self->wbd->wbd_root + 1);
+    self->kmd = base + PAGE_SIZE * wbt_kmd_pg(desc);
 
     self->node_idx = 0;
     self->lfe_idx = 0;
@@ -742,11 +1052,13 @@ wbti_reset(
             self->node_idx = desc->wbd_leaf + desc->wbd_leaf_cnt - 1;
         }
     }
+
+    return 0;
 }
 
-merr_t
-wbtr_read_vref(
-    const void              *base,
+static merr_t
+wbtr_read_vref_src(
+    const struct wbtr_pgsrc *src,
     const struct wbt_desc   *wbd,
     const struct kvs_ktuple *kt,
     uint64_t                 seq,
@@ -757,10 +1069,10 @@ wbtr_read_vref(
     const struct wbt_node_hdr_omf *node;
     int                      j, cmp, node_num;
     int                      first, last;
-    size_t                   pg;
     const void *             kdata, *kt_data;
     uint                     klen, kt_len;
     const struct wbt_lfe_omf *lfe;
+    merr_t                   err;
 
     const void *node_pfx;
     uint        node_pfx_len;
@@ -773,11 +1085,12 @@ wbtr_read_vref(
     if (HSE_UNLIKELY(!wbd->wbd_n_pages))
         goto done;
 
-    node_num = wbtr_seek_page(base, wbd, kt_data, kt_len, 0);
+    node_num = wbtr_seek_page_src(src, wbd, kt_data, kt_len, 0);
 
-    assert(0 <= node_num && node_num < wbd->wbd_n_pages);
-    pg = wbd->wbd_first_page + node_num;
-    node = base + pg * PAGE_SIZE;
+    assert(0 <= node_num && node_num < wbd->wbd_leaf_cnt);
+    node = wbtr_leaf_get(src, wbd, node_num, &err);
+    if (!node)
+        return err;
 
     /* at leaf */
     assert(omf_wbn_magic(node) == WBT_LFE_NODE_MAGIC);
@@ -818,7 +1131,10 @@ wbtr_read_vref(
             u64    vseq;
             uint   nvals;
 
-            kmd = base + PAGE_SIZE * (wbd->wbd_first_page + wbd->wbd_root + 1);
+            /* Inline values reference kmd memory directly, so kmd is
+             * always read via the mcache map.
+             */
+            kmd = src->base + PAGE_SIZE * wbt_kmd_pg(wbd);
 
             off = wbt_lfe_kmd(node, lfe);
             assert(off < wbd->wbd_kmd_pgc * PAGE_SIZE);
@@ -829,10 +1145,12 @@ wbtr_read_vref(
                 assert(off <= wbd->wbd_kmd_pgc * PAGE_SIZE);
                 if (seq >= vseq) {
                     vref->vr_seq = vseq;
-                    if (vref->vr_type == VTYPE_TOMB)
+                    if (vref->vr_type == VTYPE_TOMB || kvs_expired(vref->vr_expire))
                         *lookup_res = FOUND_TMB;
                     else if (vref->vr_type == VTYPE_PTOMB)
                         *lookup_res = FOUND_PTMB;
+                    else if (vref->vr_type == VTYPE_MVAL)
+                        *lookup_res = FOUND_MRG;
                     else
                         *lookup_res = FOUND_VAL;
 
@@ -848,6 +1166,37 @@ done:
     return 0;
 }
 
+merr_t
+wbtr_read_vref(
+    const void              *base,
+    const struct wbt_desc   *wbd,
+    const struct kvs_ktuple *kt,
+    uint64_t                 seq,
+    enum key_lookup_res     *lookup_res,
+    struct vgmap            *vgmap,
+    struct kvs_vtuple_ref   *vref)
+{
+    struct wbtr_pgsrc src = { .base = base };
+
+    return wbtr_read_vref_src(&src, wbd, kt, seq, lookup_res, vgmap, vref);
+}
+
+merr_t
+wbtr_read_vref_cached(
+    struct mpool               *mp,
+    const struct kvs_mblk_desc *kbd,
+    const struct wbt_desc      *wbd,
+    const struct kvs_ktuple    *kt,
+    uint64_t                    seq,
+    enum key_lookup_res        *lookup_res,
+    struct vgmap               *vgmap,
+    struct kvs_vtuple_ref      *vref)
+{
+    struct wbtr_pgsrc src = { .base = kbd->map_base, .mp = mp, .mbid = kbd->mbid };
+
+    return wbtr_read_vref_src(&src, wbd, kt, seq, lookup_res, vgmap, vref);
+}
+
 void
 wbti_prefix(struct wbti *self, const void **pfx, uint *pfx_len)
 {
@@ -863,6 +1212,8 @@ wbti_alloc(struct wbti **wbti_out)
     if (ev(!self))
         return merr(ENOMEM);
 
+    self->lbuf = NULL;
+
     *wbti_out = self;
 
     return 0;
@@ -884,7 +1235,11 @@ wbti_create(
     if (ev(err))
         return err;
 
-    wbti_reset(self, base, desc, seek, reverse, cache);
+    err = wbti_reset(self, base, desc, seek, reverse, cache);
+    if (ev(err)) {
+        wbti_destroy(self);
+        return err;
+    }
 
     *wbti_out = self;
     return 0;
@@ -893,6 +1248,10 @@ wbti_create(
 void
 wbti_destroy(struct wbti *self)
 {
+    if (!self)
+        return;
+
+    free(self->lbuf);
     kmem_cache_free(wbti_cache, self);
 }
 
@@ -923,7 +1282,13 @@ wbtr_hdr_valid(const struct wbt_hdr_omf *omf)
     const uint32_t version = omf_wbt_version(omf);
     const uint32_t magic = omf_wbt_magic(omf);
 
-    return HSE_LIKELY(version == WBT_TREE_VERSION && magic == WBT_TREE_MAGIC);
+    if (HSE_UNLIKELY(magic != WBT_TREE_MAGIC))
+        return false;
+
+    if (version == WBT_TREE_VERSION6)
+        return omf_wbt_leaf_pgc(omf) == 0;
+
+    return HSE_LIKELY(version == WBT_TREE_VERSION);
 }
 
 merr_t
@@ -935,11 +1300,24 @@ wbtr_read_desc(const struct wbt_hdr_omf *wbt_hdr, struct wbt_desc *desc)
     desc->wbd_version = omf_wbt_version(wbt_hdr);
 
     switch (desc->wbd_version) {
-    case WBT_TREE_VERSION:
+    case WBT_TREE_VERSION6:
+    case WBT_TREE_VERSION7:
         desc->wbd_root = omf_wbt_root(wbt_hdr);
         desc->wbd_leaf = omf_wbt_leaf(wbt_hdr);
         desc->wbd_leaf_cnt = omf_wbt_leaf_cnt(wbt_hdr);
         desc->wbd_kmd_pgc = omf_wbt_kmd_pgc(wbt_hdr);
+        desc->wbd_leaf_pgc = omf_wbt_leaf_pgc(wbt_hdr);
+        desc->wbd_gen = 0;
+
+        /* The leaf offset table must fit in the leaf region.
+         */
+        if (desc->wbd_leaf_pgc) {
+            if (ev((desc->wbd_leaf_cnt + 1) * sizeof(uint32_t) >
+                   (size_t)desc->wbd_leaf_pgc * PAGE_SIZE))
+                return merr(EINVAL);
+
+            desc->wbd_gen = atomic_inc_return(&wbtr_gen);
+        }
         break;
 
     default:
@@ -6,6 +6,7 @@
 #ifndef HSE_KVS_CN_WBT_READER_H
 #define HSE_KVS_CN_WBT_READER_H
 
+#include <hse_util/assert.h>
 #include <hse_util/inttypes.h>
 #include <hse_util/key_util.h>
 
@@ -28,6 +29,8 @@ struct vgmap;
  * @wbd_leaf: first leaf node (@wbd_leaf < @wbd_n_pages)
  * @wbd_leaf_cnt: number of leaf nodes
  * @wbd_kmd_pgc: size of key-metadata region in pages
+ * @wbd_leaf_pgc: size of compressed leaf region in pages (0 if uncompressed)
+ * @wbd_gen: unique id of a tree with compressed leaves (leaf cache tag)
  *
  * When a KBLOCK is opened for reading, the @wbt_hdr_omf struct is read from
  * media and the relevant information is stored in a @wbt_desc struct.
@@ -46,6 +49,8 @@ struct wbt_desc {
     uint16_t wbd_leaf_cnt;
     uint16_t wbd_kmd_pgc;
     uint16_t wbd_version;
+    uint32_t wbd_leaf_pgc;
+    uint64_t wbd_gen;
 };
 
 struct wbti {
@@ -57,8 +62,42 @@ struct wbti {
     uint32_t lfe_idx;
 
     bool reverse;
+    void *lbuf; /* decoded leaf node for compressed trees */
 };
 
+/* Page offset of node %node_num (which must not be a compressed leaf)
+ * from the start of the mblock.
+ */
+static inline uint32_t
+wbt_node_pg(const struct wbt_desc *wbd, uint node_num)
+{
+    if (wbd->wbd_leaf_pgc) {
+        assert(node_num >= wbd->wbd_leaf_cnt);
+        return wbd->wbd_first_page + wbd->wbd_leaf_pgc + node_num - wbd->wbd_leaf_cnt;
+    }
+
+    return wbd->wbd_first_page + node_num;
+}
+
+/* Page offset of the kmd region from the start of the mblock.
+ */
+static inline uint32_t
+wbt_kmd_pg(const struct wbt_desc *wbd)
+{
+    if (wbd->wbd_leaf_pgc)
+        return wbd->wbd_first_page + wbd->wbd_leaf_pgc + wbd->wbd_root + 1 - wbd->wbd_leaf_cnt;
+
+    return wbd->wbd_first_page + wbd->wbd_root + 1;
+}
+
+/* Size in pages of the leaf node region.
+ */
+static inline uint32_t
+wbt_leaf_region_pgc(const struct wbt_desc *wbd)
+{
+    return wbd->wbd_leaf_pgc ?: wbd->wbd_leaf_cnt;
+}
+
 /**
  * wbtr_read_vref() - Read the metadata data for the value associated with key
  * @base: base address of the block
@@ -79,6 +118,26 @@ wbtr_read_vref(
     struct vgmap *vgmap,
     struct kvs_vtuple_ref *vref);
 
+/**
+ * wbtr_read_vref_cached() - Like wbtr_read_vref(), but read wbtree nodes
+ *                           via the mpool block cache
+ * @mp:  mpool
+ * @kbd: kblock descriptor
+ *
+ * Key metadata is still read via the kblock's mcache map.
+ */
+/* MTF_MOCK */
+merr_t
+wbtr_read_vref_cached(
+    struct mpool *mp,
+    const struct kvs_mblk_desc *kbd,
+    const struct wbt_desc *wbd,
+    const struct kvs_ktuple *kt,
+    u64 seq,
+    enum key_lookup_res *lookup_res,
+    struct vgmap *vgmap,
+    struct kvs_vtuple_ref *vref);
+
 merr_t
 wbti_alloc(struct wbti **wbti_out);
 
@@ -91,7 +150,7 @@ wbti_alloc(struct wbti **wbti_out);
  * @reverse: whether to iterate backwards
  * @cache: whether to cache wbt node values
  */
-void
+merr_t
 wbti_reset(
     struct wbti *self,
     const void *base,
@@ -160,6 +219,26 @@ wbt_read_kmd_vref(
     u64 *seq,
     struct kvs_vtuple_ref *vref);
 
+/**
+ * wbt_leaf_span() - locate a compressed leaf node
+ * @base: base address of the mcache map of the mblock
+ * @wbd:  wbtree descriptor (tree must have compressed leaves)
+ * @idx:  leaf node index
+ * @off:  (output) byte offset of the leaf from the start of the mblock
+ * @len:  (output) compressed length of the leaf
+ */
+merr_t
+wbt_leaf_span(const void *base, const struct wbt_desc *wbd, uint idx, size_t *off, uint *len);
+
+/**
+ * wbt_leaf_decode() - reconstruct a leaf node from its compressed form
+ * @src:    compressed leaf
+ * @srclen: length of @src
+ * @node:   (output) WBT_NODE_SIZE buffer for the leaf node
+ */
+merr_t
+wbt_leaf_decode(const void *src, uint srclen, void *node);
+
 merr_t
 wbti_init(void);
 void
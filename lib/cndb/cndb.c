@@ -27,6 +27,7 @@
 struct cndb_cn {
     uint64_t            cnid;
     struct map         *kvset_map;
+    struct map         *ksum_map;
     struct kvs_cparams  cp;
     char                name[HSE_KVS_NAME_LEN_MAX];
 };
@@ -45,6 +46,7 @@ struct cndb {
 
     bool                 replaying;
     bool                 rdonly;
+    bool                 ksum_dirty;
 
     /* Mpool and mdc. */
     struct mpool     *mp;
@@ -179,14 +181,27 @@ cndb_cn_destroy(uint64_t key, uintptr_t val)
     struct cndb_kvset *kvset;
     struct map_iter kvset_iter;
 
+    struct kvset_summary *sum;
+
     map_iter_init(&kvset_iter, cn->kvset_map);
     while (map_iter_next_val(&kvset_iter, &kvset))
         free(kvset);
 
+    map_iter_init(&kvset_iter, cn->ksum_map);
+    while (map_iter_next_val(&kvset_iter, &sum))
+        free(sum);
+
     map_destroy(cn->kvset_map);
+    map_destroy(cn->ksum_map);
     free(cn);
 }
 
+static void
+cndb_kvset_summary_drop(struct cndb_cn *cn, uint64_t kvsetid)
+{
+    free(map_remove_ptr(cn->ksum_map, kvsetid));
+}
+
 static merr_t
 cndb_txn_free_cb(struct cndb_txn *tx, struct cndb_kvset *kvset, bool isadd, bool isacked, void *ctx)
 {
@@ -209,6 +224,18 @@ cndb_close(struct cndb *cndb)
     if (ev(!cndb))
         return 0;
 
+    /* Rewrite the log if kvset summaries were recorded since it was last
+     * compacted so that the next open finds a summary for every kvset.
+     */
+    if (!cndb->rdonly && cndb->ksum_dirty) {
+        mutex_lock(&cndb->mutex);
+        err = cndb_compact(cndb);
+        mutex_unlock(&cndb->mutex);
+
+        if (err)
+            log_errx("Failed to save kvset summaries at close", err);
+    }
+
     err = mpool_mdc_close(cndb->mdc);
     if (ev(err))
         return err;
@@ -319,7 +346,10 @@ cndb_record_kvs_add_inner(
     strlcpy(cn->name, name, NELEM(cn->name));
 
     cn->kvset_map = map_create(HSE_KVS_COUNT_MAX);
-    if (ev(!cn->kvset_map)) {
+    cn->ksum_map = map_create(0);
+    if (ev(!cn->kvset_map || !cn->ksum_map)) {
+        map_destroy(cn->kvset_map);
+        map_destroy(cn->ksum_map);
         free(cn);
         return merr(ENOMEM);
     }
@@ -349,6 +379,8 @@ out:
 
     if (err) {
         map_remove(cndb->cn_map, cn->cnid, NULL);
+        map_destroy(cn->kvset_map);
+        map_destroy(cn->ksum_map);
         free(cn);
     }
 
@@ -688,6 +720,7 @@ process_finished_del_txn_cb(
         goto errout;
     }
 
+    cndb_kvset_summary_drop(cn, delme->ck_kvsetid);
     free(delme);
 
 errout:
@@ -753,6 +786,27 @@ cndb_record_kvset_del_ack(struct cndb *cndb, struct cndb_txn *tx, void *cookie)
     return cndb_record_kvset_ack_cmn(cndb, tx, CNDB_ACK_TYPE_DEL, (uintptr_t)cookie);
 }
 
+static merr_t
+nak_drop_summary_cb(
+    struct cndb_txn   *tx,
+    struct cndb_kvset *kvset,
+    bool               isadd,
+    bool               isacked,
+    void              *ctx)
+{
+    struct cndb *cndb = ctx;
+    struct cndb_cn *cn;
+
+    if (!isadd)
+        return 0;
+
+    cn = map_lookup_ptr(cndb->cn_map, kvset->ck_cnid);
+    if (cn)
+        cndb_kvset_summary_drop(cn, kvset->ck_kvsetid);
+
+    return 0;
+}
+
 merr_t
 cndb_record_nak(struct cndb *cndb, struct cndb_txn *tx)
 {
@@ -760,6 +814,8 @@ cndb_record_nak(struct cndb *cndb, struct cndb_txn *tx)
 
     mutex_lock(&cndb->mutex);
 
+    cndb_txn_apply(tx, &nak_drop_summary_cb, cndb);
+
     if (!cndb->replaying) {
         if (cndb_needs_compaction(cndb)) {
             err = cndb_compact(cndb);
@@ -779,6 +835,65 @@ out:
     return err;
 }
 
+merr_t
+cndb_record_kvset_summary(
+    struct cndb                *cndb,
+    uint64_t                    cnid,
+    uint64_t                    kvsetid,
+    const struct kvset_summary *sum)
+{
+    struct kvset_summary *copy;
+    struct cndb_cn *cn;
+    size_t sz;
+    merr_t err;
+
+    if (cndb->rdonly)
+        return 0;
+
+    sz = kvset_summary_size(sum->ksum_minklen, sum->ksum_maxklen);
+
+    copy = malloc(sz);
+    if (ev(!copy))
+        return merr(ENOMEM);
+
+    memcpy(copy, sum, sz);
+
+    mutex_lock(&cndb->mutex);
+    cn = map_lookup_ptr(cndb->cn_map, cnid);
+    if (cn) {
+        cndb_kvset_summary_drop(cn, kvsetid);
+
+        err = map_insert_ptr(cn->ksum_map, kvsetid, copy);
+        if (!err)
+            cndb->ksum_dirty = true;
+    } else {
+        err = merr(EPROTO);
+    }
+    mutex_unlock(&cndb->mutex);
+
+    if (ev(err))
+        free(copy);
+
+    return err;
+}
+
+static merr_t
+log_summary_rec(struct cndb *cndb, struct cndb_kvset *kvset)
+{
+    struct kvset_summary *sum;
+    struct cndb_cn *cn;
+
+    cn = map_lookup_ptr(cndb->cn_map, kvset->ck_cnid);
+    if (!cn)
+        return 0;
+
+    sum = map_lookup_ptr(cn->ksum_map, kvset->ck_kvsetid);
+    if (!sum)
+        return 0;
+
+    return cndb_omf_kvset_sum_write(cndb->mdc, kvset->ck_cnid, kvset->ck_kvsetid, sum);
+}
+
 static merr_t
 compact_incomplete_intents(
     struct cndb_txn   *tx,
@@ -802,8 +917,10 @@ compact_incomplete_intents(
                                    kvset->ck_vused, kvset->ck_compc, kvset->ck_rule,
                                    kvset->ck_hblkid, kvset->ck_kblkc, kvset->ck_kblkv,
                                    kvset->ck_vblkc, kvset->ck_vblkv);
+    if (ev(err))
+        return err;
 
-    return err;
+    return log_summary_rec(cndb, kvset);
 }
 
 static merr_t
@@ -858,6 +975,10 @@ log_full_rec(
     if (ev(err))
         return err;
 
+    err = log_summary_rec(cndb, kvset);
+    if (ev(err))
+        return err;
+
     return 0;
 }
 
@@ -945,7 +1066,13 @@ cndb_compact(struct cndb *cndb)
             return err;
     }
 
-    return mpool_mdc_cend(cndb->mdc);
+    err = mpool_mdc_cend(cndb->mdc);
+    if (ev(err))
+        return err;
+
+    cndb->ksum_dirty = false;
+
+    return 0;
 }
 
 /* Replay */
@@ -1110,6 +1237,27 @@ cndb_read_record(struct cndb *cndb, struct cndb_reader *reader)
 
         err = cndb_record_nak(cndb, txid2tx(cndb, txid));
         ev(err);
+
+    } else if (rec_type == CNDB_TYPE_KVSET_SUM) {
+        struct kvset_summary *sum;
+        uint64_t cnid, kvsetid;
+        struct cndb_cn *cn;
+
+        err = cndb_omf_kvset_sum_read(reader->recbuf, &cnid, &kvsetid, &sum);
+        if (ev(err))
+            return err;
+
+        cn = map_lookup_ptr(cndb->cn_map, cnid);
+        if (cn) {
+            cndb_kvset_summary_drop(cn, kvsetid);
+            err = map_insert_ptr(cn->ksum_map, kvsetid, sum);
+        } else {
+            err = merr(EPROTO);
+        }
+
+        if (ev(err))
+            free(sum);
+
     } else {
         assert(0);
         return merr(EPROTO);
@@ -1285,6 +1433,7 @@ recover_incomplete_txn_cb(
 
         if (rctx->is_rollback) {
             err = kvset_mblock_delete(rctx->mp, rctx->mbid_map, kvset);
+            cndb_kvset_summary_drop(cn, kvset->ck_kvsetid);
             free(kvset);
         } else {
             err = map_insert_ptr(cn->kvset_map, kvset->ck_kvsetid, kvset);
@@ -1309,6 +1458,7 @@ recover_incomplete_txn_cb(
                                      CNDB_ACK_TYPE_DEL, delme->ck_kvsetid);
         }
 
+        cndb_kvset_summary_drop(cn, kvset->ck_kvsetid);
         free(delme);
     }
 
@@ -1422,6 +1572,7 @@ cndb_cn_instantiate(struct cndb *cndb, uint64_t cnid, void *ctx, cn_init_callbac
             .km_nodeid = kvset->ck_nodeid,
             .km_hblk.bk_blkid = kvset->ck_hblkid,
             .km_restored = true,
+            .km_summary = map_lookup_ptr(cn->ksum_map, kvset->ck_kvsetid),
         };
 
         int i;
@@ -1462,6 +1613,7 @@ cndb_kvset_delete(struct cndb *cndb, uint64_t cnid, uint64_t kvsetid)
     if (!kvset)
         return merr(EBUG);
 
+    cndb_kvset_summary_drop(cn, kvsetid);
     free(kvset);
 
     return 0;
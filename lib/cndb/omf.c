@@ -6,6 +6,7 @@
 #include <hse_ikvdb/omf_version.h>
 
 #include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/limits.h>
 
 #include <cn/kvset.h>
 
@@ -69,6 +70,7 @@ cndb_omf_kvs_add_write(
     omf_set_kvs_add_cnid(&omf, cnid);
     omf_set_kvs_add_flags(&omf, flags);
     omf_set_kvs_add_name(&omf, (unsigned char *)name, strlen(name));
+    omf_set_kvs_add_vinline(&omf, cp->vinline_len);
 
     return mpool_mdc_append(mdc, &omf, sizeof(omf), true);
 }
@@ -266,6 +268,56 @@ cndb_omf_nak_write(struct mpool_mdc *mdc, uint64_t txid)
     return mpool_mdc_append(mdc, &omf, sizeof(omf), true);
 }
 
+merr_t
+cndb_omf_kvset_sum_write(
+    struct mpool_mdc           *mdc,
+    uint64_t                    cnid,
+    uint64_t                    kvsetid,
+    const struct kvset_summary *sum)
+{
+    struct cndb_kvset_sum_omf *omf;
+    const struct kvset_stats *st = &sum->ksum_st;
+    uint8_t buf[sizeof(*omf) + 2 * HSE_KVS_KEY_LEN_MAX];
+    size_t klen, sz;
+
+    klen = sum->ksum_minklen + sum->ksum_maxklen;
+    sz = sizeof(*omf) + klen;
+
+    if (sz > sizeof(buf))
+        return merr(EINVAL);
+
+    omf = (void *)buf;
+
+    cndb_hdr_omf_init(&omf->hdr, CNDB_TYPE_KVSET_SUM, sz);
+
+    omf_set_kvset_sum_cnid(omf, cnid);
+    omf_set_kvset_sum_kvsetid(omf, kvsetid);
+    omf_set_kvset_sum_seqno_min(omf, sum->ksum_seqno_min);
+    omf_set_kvset_sum_seqno_max(omf, sum->ksum_seqno_max);
+    omf_set_kvset_sum_keys(omf, st->kst_keys);
+    omf_set_kvset_sum_tombs(omf, st->kst_tombs);
+    omf_set_kvset_sum_ptombs(omf, st->kst_ptombs);
+    omf_set_kvset_sum_halen(omf, st->kst_halen);
+    omf_set_kvset_sum_hwlen(omf, st->kst_hwlen);
+    omf_set_kvset_sum_kalen(omf, st->kst_kalen);
+    omf_set_kvset_sum_kwlen(omf, st->kst_kwlen);
+    omf_set_kvset_sum_valen(omf, st->kst_valen);
+    omf_set_kvset_sum_vwlen(omf, st->kst_vwlen);
+    omf_set_kvset_sum_vulen(omf, st->kst_vulen);
+    omf_set_kvset_sum_ttl_bytes(omf, st->kst_ttl_bytes);
+    omf_set_kvset_sum_ttl_min(omf, st->kst_ttl_min);
+    omf_set_kvset_sum_ttl_max(omf, st->kst_ttl_max);
+    omf_set_kvset_sum_kblks(omf, st->kst_kblks);
+    omf_set_kvset_sum_vblks(omf, st->kst_vblks);
+    omf_set_kvset_sum_vgroups(omf, sum->ksum_vgroups);
+    omf_set_kvset_sum_minklen(omf, sum->ksum_minklen);
+    omf_set_kvset_sum_maxklen(omf, sum->ksum_maxklen);
+
+    memcpy(omf + 1, sum->ksum_keyv, klen);
+
+    return mpool_mdc_append(mdc, omf, sz, false);
+}
+
 /*
  * OMF Read functions
  */
@@ -301,6 +353,14 @@ cndb_omf_kvs_add_read(
     cp->pfx_len = omf_kvs_add_pfxlen(omf);
     cp->kvs_ext01 = omf_kvs_add_flags(omf) & CN_CFLAG_CAPPED;
 
+    /* KVSes created before the inline value length was configurable
+     * used the then fixed threshold.
+     */
+    if (omf_cnhdr_len(&omf->hdr) + sizeof(omf->hdr) > CNDB_KVS_ADD_OMF_V1_LEN)
+        cp->vinline_len = omf_kvs_add_vinline(omf);
+    else
+        cp->vinline_len = CN_SMALL_VALUE_THRESHOLD;
+
     *cnid = omf_kvs_add_cnid(omf);
     omf_kvs_add_name(omf, namebuf, namebufsz);
 }
@@ -441,3 +501,62 @@ cndb_omf_nak_read(
 {
     *txid = omf_nak_txid(omf);
 }
+
+merr_t
+cndb_omf_kvset_sum_read(
+    struct cndb_kvset_sum_omf *omf,
+    uint64_t                  *cnid,
+    uint64_t                  *kvsetid,
+    struct kvset_summary     **sum_out)
+{
+    struct kvset_summary *sum;
+    struct kvset_stats *st;
+    uint minklen, maxklen;
+    size_t reclen;
+
+    reclen = omf_cnhdr_len(&omf->hdr) + sizeof(omf->hdr);
+    minklen = omf_kvset_sum_minklen(omf);
+    maxklen = omf_kvset_sum_maxklen(omf);
+
+    if (reclen < sizeof(*omf) + minklen + maxklen)
+        return merr(EPROTO);
+
+    sum = malloc(kvset_summary_size(minklen, maxklen));
+    if (!sum)
+        return merr(ENOMEM);
+
+    memset(sum, 0, sizeof(*sum));
+    st = &sum->ksum_st;
+
+    *cnid = omf_kvset_sum_cnid(omf);
+    *kvsetid = omf_kvset_sum_kvsetid(omf);
+
+    sum->ksum_seqno_min = omf_kvset_sum_seqno_min(omf);
+    sum->ksum_seqno_max = omf_kvset_sum_seqno_max(omf);
+    st->kst_keys = omf_kvset_sum_keys(omf);
+    st->kst_tombs = omf_kvset_sum_tombs(omf);
+    st->kst_ptombs = omf_kvset_sum_ptombs(omf);
+    st->kst_halen = omf_kvset_sum_halen(omf);
+    st->kst_hwlen = omf_kvset_sum_hwlen(omf);
+    st->kst_kalen = omf_kvset_sum_kalen(omf);
+    st->kst_kwlen = omf_kvset_sum_kwlen(omf);
+    st->kst_valen = omf_kvset_sum_valen(omf);
+    st->kst_vwlen = omf_kvset_sum_vwlen(omf);
+    st->kst_vulen = omf_kvset_sum_vulen(omf);
+    st->kst_ttl_bytes = omf_kvset_sum_ttl_bytes(omf);
+    st->kst_ttl_min = omf_kvset_sum_ttl_min(omf);
+    st->kst_ttl_max = omf_kvset_sum_ttl_max(omf);
+    st->kst_kvsets = 1;
+    st->kst_hblks = 1;
+    st->kst_kblks = omf_kvset_sum_kblks(omf);
+    st->kst_vblks = omf_kvset_sum_vblks(omf);
+    sum->ksum_vgroups = omf_kvset_sum_vgroups(omf);
+    sum->ksum_minklen = minklen;
+    sum->ksum_maxklen = maxklen;
+
+    memcpy(sum->ksum_keyv, omf + 1, minklen + maxklen);
+
+    *sum_out = sum;
+
+    return 0;
+}
@@ -29,6 +29,7 @@
  * CNDB_TYPE_KVSET_DEL: Delete a kvset.
  * CNDB_TYPE_ACK:       Acknowledge a CNDB_TYPE_KVSET_ADD or a CNDB_TYPE_KVSET_DEL record.
  * CNDB_TYPE_NAK:       Abort transaction.
+ * CNDB_TYPE_KVSET_SUM: Summary of a kvset (written only by cndb compaction).
  */
 enum cndb_rec_type {
     CNDB_TYPE_VERSION = 1,
@@ -41,8 +42,9 @@ enum cndb_rec_type {
     CNDB_TYPE_KVSET_MOVE = 8,
     CNDB_TYPE_ACK = 9,
     CNDB_TYPE_NAK = 10,
+    CNDB_TYPE_KVSET_SUM = 11,
 
-    CNDB_TYPE_CNT = 10,
+    CNDB_TYPE_CNT = 11,
 };
 
 /**
@@ -97,12 +99,18 @@ struct cndb_kvs_add_omf {
     uint32_t            kvs_add_flags;
     uint64_t            kvs_add_cnid;
     uint8_t             kvs_add_name[HSE_KVS_NAME_LEN_MAX];
+    uint32_t            kvs_add_vinline;
 } HSE_PACKED;
 
+/* Version 1 kvs_add records end at kvs_add_name.
+ */
+#define CNDB_KVS_ADD_OMF_V1_LEN  offsetof(struct cndb_kvs_add_omf, kvs_add_vinline)
+
 OMF_SETGET(struct cndb_kvs_add_omf, kvs_add_pfxlen, 32);
 OMF_SETGET(struct cndb_kvs_add_omf, kvs_add_flags, 32);
 OMF_SETGET(struct cndb_kvs_add_omf, kvs_add_cnid, 64);
 OMF_SETGET_CHBUF(struct cndb_kvs_add_omf, kvs_add_name);
+OMF_SETGET(struct cndb_kvs_add_omf, kvs_add_vinline, 32);
 
 struct cndb_kvs_del_omf {
     struct cndb_hdr_omf hdr;
@@ -289,10 +297,71 @@ struct cndb_nak_omf {
 
 OMF_SETGET(struct cndb_nak_omf, nak_txid, 64);
 
+
+/**
+ * struct cndb_kvset_sum_omf
+ *
+ * A KVSET_SUM record caches the metadata of a kvset that kvset_open() would
+ * otherwise gather from the kvset's hblock and kblocks (see struct
+ * kvset_summary).  It follows the kvset's KVSET_ADD record and is purely
+ * advisory: a kvset without one is simply opened the long way.
+ */
+struct cndb_kvset_sum_omf {
+    struct cndb_hdr_omf hdr;
+    uint64_t            kvset_sum_cnid;
+    uint64_t            kvset_sum_kvsetid;
+    uint64_t            kvset_sum_seqno_min;
+    uint64_t            kvset_sum_seqno_max;
+    uint64_t            kvset_sum_keys;
+    uint64_t            kvset_sum_tombs;
+    uint64_t            kvset_sum_ptombs;
+    uint64_t            kvset_sum_halen;
+    uint64_t            kvset_sum_hwlen;
+    uint64_t            kvset_sum_kalen;
+    uint64_t            kvset_sum_kwlen;
+    uint64_t            kvset_sum_valen;
+    uint64_t            kvset_sum_vwlen;
+    uint64_t            kvset_sum_vulen;
+    uint64_t            kvset_sum_ttl_bytes;
+    uint32_t            kvset_sum_ttl_min;
+    uint32_t            kvset_sum_ttl_max;
+    uint32_t            kvset_sum_kblks;
+    uint32_t            kvset_sum_vblks;
+    uint32_t            kvset_sum_vgroups;
+    uint16_t            kvset_sum_minklen;
+    uint16_t            kvset_sum_maxklen;
+    /* the min key followed by the max key appear here */
+} HSE_PACKED;
+
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_cnid, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_kvsetid, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_seqno_min, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_seqno_max, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_keys, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_tombs, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_ptombs, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_halen, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_hwlen, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_kalen, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_kwlen, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_valen, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_vwlen, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_vulen, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_ttl_bytes, 64);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_ttl_min, 32);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_ttl_max, 32);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_kblks, 32);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_vblks, 32);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_vgroups, 32);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_minklen, 16);
+OMF_SETGET(struct cndb_kvset_sum_omf, kvset_sum_maxklen, 16);
+
 /*
  * OMF Write functions
  */
 
+struct kvset_summary;
+
 merr_t
 cndb_omf_ver_write(struct mpool_mdc *mdc, size_t captgt);
 
@@ -364,6 +433,13 @@ cndb_omf_ack_write(
 merr_t
 cndb_omf_nak_write(struct mpool_mdc *mdc, uint64_t txid);
 
+merr_t
+cndb_omf_kvset_sum_write(
+    struct mpool_mdc           *mdc,
+    uint64_t                    cnid,
+    uint64_t                    kvsetid,
+    const struct kvset_summary *sum);
+
 /*
  * OMF Read functions
  */
@@ -450,4 +526,13 @@ cndb_omf_nak_read(
     struct cndb_nak_omf *omf,
     uint64_t            *txid);
 
+/* The summary is allocated with malloc() and must be freed by the caller.
+ */
+merr_t
+cndb_omf_kvset_sum_read(
+    struct cndb_kvset_sum_omf *omf,
+    uint64_t                  *cnid,
+    uint64_t                  *kvsetid,
+    struct kvset_summary     **sum_out);
+
 #endif /* HSE_KVS_CNDB_OMF_H */
@@ -22,11 +22,13 @@
 
 struct c0;
 struct c0_cursor;
+struct kvs_batch_op;
 struct cn;
 
 struct query_ctx;
 struct kvdb_ctxn;
 struct kc_filter;
+struct kvs_rtomb_vec;
 
 struct mpool;
 
@@ -113,6 +115,23 @@ c0_get_sfx_len(struct c0 *c0);
 merr_t
 c0_put(struct c0 *self, struct kvs_ktuple *key, const struct kvs_vtuple *value, uintptr_t seqnoref);
 
+/**
+ * c0_put_batch() - apply the ops of a write batch
+ * @self:      Any struct c0 of the kvdb to which the ops apply
+ * @opc:       Number of ops in @opv
+ * @opv:       Vector of write batch ops, applied in order
+ * @seqnoref:  seqnoref for all ops
+ *
+ * The ops may target different kvses of the same kvdb (each op's
+ * kbo_skidx identifies its c0), hence any c0 of the kvdb may be
+ * used to reach the shared c0sk.
+ *
+ * Return: 0 on success, otherwise the error from c0sk_put_batch()
+ */
+/* MTF_MOCK */
+merr_t
+c0_put_batch(struct c0 *self, uint opc, struct kvs_batch_op *opv, uintptr_t seqnoref);
+
 /**
  * c0_get() - retrieve the value associated with the given key,
  *            no newer than seqno
@@ -128,7 +147,7 @@ c0_put(struct c0 *self, struct kvs_ktuple *key, const struct kvs_vtuple *value,
 merr_t
 c0_get(
     struct c0 *              self,
-    const struct kvs_ktuple *key,
+    struct kvs_ktuple *      key,
     u64                      view_seqno,
     uintptr_t                seqnoref,
     enum key_lookup_res *    res,
@@ -169,6 +188,17 @@ c0_pfx_probe(
 merr_t
 c0_prefix_del(struct c0 *self, struct kvs_ktuple *key, uintptr_t seqnoref);
 
+/**
+ * c0_range_del() - delete all keys in the range [start, end)
+ * @self:      Instance of struct c0 from which to delete
+ * @start:     first key of the range
+ * @end:       end of the range (exclusive)
+ * @seqnoref:  seqnoref for range delete
+ */
+/* MTF_MOCK */
+merr_t
+c0_range_del(struct c0 *self, struct kvs_ktuple *start, struct kvs_ktuple *end, uintptr_t seqnoref);
+
 /**
  * c0_sync() - force ingest of existing c0 data and waits until ingest complete
  * @self:      Instance of struct c0 to flush
@@ -236,6 +266,15 @@ c0_cursor_update(
     u64                      seqno,
     u32 *                    flags_out);
 
+/**
+ * c0_cursor_rtombs() - collect the range tombstones in a c0 cursor's view
+ * @c0cur: Instance of struct c0_cursor
+ * @vec:   tombstone vector to which the tombstones are appended
+ */
+/* MTF_MOCK */
+merr_t
+c0_cursor_rtombs(struct c0_cursor *c0cur, struct kvs_rtomb_vec *vec);
+
 /**
  * c0_cursor_destroy() - destroy existing iterators over c0
  * @c0cur:     Instance of struct c0_cursor
@@ -42,6 +42,7 @@ struct c0_kvmultiset {
 /**
  * c0kvms_create() - allocate/initialize a struct c0_kvmultiset
  * @num_sets:        Max number of c0_kvsets to create
+ * @concurrent:      Create concurrent c0_kvsets (see c0kvs_create())
  * @alloc_sz:        Maximum cheap or malloc allocation size
  * @kvdb_seq:        ptr to kvdb seqno. Used only by non-txn KVMS.
  * @multiset:        Returned struct c0_kvset (on success)
@@ -59,6 +60,7 @@ struct c0_kvmultiset {
 merr_t
 c0kvms_create(
     u32                    num_sets,
+    bool                   concurrent,
     atomic_ulong          *kvdb_seq,
     void * _Atomic        *stashp,
     struct c0_kvmultiset **multiset);
@@ -18,6 +18,7 @@ struct c0_kvset {
 
 struct c0kvs_ingest_ctx;
 struct c0_kvset_iterator;
+struct kvs_rtomb_vec;
 
 struct c0_usage {
     size_t u_alloc;
@@ -65,18 +66,23 @@ c0kvs_fini(void) HSE_COLD;
  * @alloc_sz:   Maximum cheap or malloc allocation size
  * @kvdb_seq:   Ptr to kvdb seqno
  * @kvms_seq:   Ptr to kvms seqno.
+ * @concurrent: Index the kvset with a concurrent skiplist
  * @handlep:    Returned struct c0_kvset (on success)
  *
  * Passing HSE_C0KVS_ALLOC_MALLOC tells the implementation to use
  * malloc to allocate space to hold the key/value pairs, while
  * HSE_C0KVS_ALLOC_CURSOR causes the cursor heap allocator to be used.
  *
+ * A concurrent kvset allows puts and deletes to proceed in parallel
+ * rather than serializing them on the kvset's mutex.
+ *
  * Return: 0 on success, <0 otherwise
  */
 merr_t
 c0kvs_create(
     atomic_ulong     *kvdb_seq,
     atomic_ulong     *kvms_seq,
+    bool              concurrent,
     struct c0_kvset **handlep);
 
 /**
@@ -182,6 +188,77 @@ c0kvs_prefix_del(
     struct kvs_ktuple       *key,
     const uintptr_t          seqno);
 
+/**
+ * c0kvs_range_del() - insert a range tombstone
+ * @set:      c0 kvset (the kvms' ptomb c0kvset)
+ * @skidx:    kvs index
+ * @start:    first key of the range (inclusive)
+ * @end:      end of the range (exclusive)
+ * @seqnoref: seqno to use for the range delete
+ *
+ * Both keys are copied into the c0kvset.  On success, the seqno assigned
+ * to the tombstone is returned in %start->kt_seqno.
+ */
+merr_t
+c0kvs_range_del(
+    struct c0_kvset         *set,
+    u16                      skidx,
+    struct kvs_ktuple       *start,
+    const struct kvs_ktuple *end,
+    uintptr_t                seqnoref);
+
+/**
+ * c0kvs_rtomb_seq() - find the newest range tombstone that covers a key
+ * @set:        c0 kvset
+ * @skidx:      kvs index
+ * @kt:         key
+ * @view_seqno: ignore tombstones newer than this seqno
+ *
+ * Caller must hold the RCU read lock.
+ *
+ * Return: The tombstone's seqno, or zero if there is none.
+ */
+u64
+c0kvs_rtomb_seq(struct c0_kvset *set, u16 skidx, const struct kvs_ktuple *kt, u64 view_seqno);
+
+/**
+ * c0kvs_rtomb_collect() - append a kvs' range tombstones to a vector
+ * @set:        c0 kvset
+ * @skidx:      kvs index
+ * @view_seqno: ignore tombstones newer than this seqno
+ * @vec:        tombstone vector
+ *
+ * The tombstone keys remain valid until the c0kvset is reset.
+ */
+merr_t
+c0kvs_rtomb_collect(
+    struct c0_kvset      *set,
+    u16                   skidx,
+    u64                   view_seqno,
+    struct kvs_rtomb_vec *vec);
+
+/**
+ * c0kvs_putdel_batch() - insert a group of puts and deletes into a c0_kvset
+ * @set:      Struct c0_kvset to insert into
+ * @opv:      Vector of write batch ops
+ * @idxv:     Indices into @opv of the ops to insert, in batch order
+ * @idxc:     Number of elements in @idxv
+ * @seqnoref: seqnoref to use for all ops
+ * @donep:    (out) Number of ops from @idxv successfully inserted
+ *
+ * Equivalent to calling c0kvs_put() or c0kvs_del() for each op, but
+ * acquires the c0_kvset lock only once.  Prefix deletes are not
+ * allowed, they must go to the ptomb c0_kvset.
+ */
+merr_t
+c0kvs_putdel_batch(
+    struct c0_kvset     *set,
+    struct kvs_batch_op *opv,
+    const uint8_t       *idxv,
+    uint                 idxc,
+    uintptr_t            seqnoref,
+    uint                *donep);
+
 /**
  * c0kvs_get_rcu() - given a key, retrieve a value from a struct c0_kvset
  * @handle:     Struct c0_kvset to search
@@ -30,6 +30,7 @@ struct cursor_summary;
 struct kvset_builder;
 struct throttle_sensor;
 struct query_ctx;
+struct kvs_rtomb_vec;
 struct kvdb_ctxn_set;
 struct kvdb_callback;
 
@@ -161,6 +162,24 @@ c0sk_put(
     const struct kvs_vtuple *value,
     uintptr_t                seqnoref);
 
+/**
+ * c0sk_put_batch() - apply the ops of a write batch to the struct c0sk
+ * @self:      Instance of struct c0sk into which to insert
+ * @opc:       Number of ops in @opv
+ * @opv:       Vector of write batch ops, applied in order
+ * @seqnoref:  seqnoref for all ops
+ *
+ * All ops are inserted into the active kvms in a single pass, acquiring
+ * each c0_kvset lock at most once per run of puts and deletes.
+ *
+ * Return: 0 if all ops were applied, merr(EINVAL) if there is no active
+ * kvms, otherwise the error that stopped the batch.  Ops preceding the
+ * failed op remain applied.
+ */
+/* MTF_MOCK */
+merr_t
+c0sk_put_batch(struct c0sk *self, uint opc, struct kvs_batch_op *opv, uintptr_t seqnoref);
+
 /**
  * c0sk_get() - retrieve the value associated with the given key
  * @self:      Instance of struct c0sk from which to retrieve
@@ -180,7 +199,7 @@ c0sk_get(
     struct c0sk *            self,
     u16                      skidx,
     u32                      pfx_len,
-    const struct kvs_ktuple *key,
+    struct kvs_ktuple *      key,
     u64                      view_seq,
     uintptr_t                seqref,
     enum key_lookup_res *    res,
@@ -226,6 +245,23 @@ c0sk_pfx_probe(
 merr_t
 c0sk_prefix_del(struct c0sk *self, u16 skidx, struct kvs_ktuple *key, uintptr_t seqnoref);
 
+/**
+ * c0sk_range_del() - delete all keys in the range [start, end)
+ * @self:      Instance of struct c0sk from which to delete
+ * @skidx:     Structured key index
+ * @start:     First key of the range
+ * @end:       End of the range (exclusive)
+ * @seqnoref:  seqnoref for range delete
+ */
+/* MTF_MOCK */
+merr_t
+c0sk_range_del(
+    struct c0sk       *self,
+    u16                skidx,
+    struct kvs_ktuple *start,
+    struct kvs_ktuple *end,
+    uintptr_t          seqnoref);
+
 /**
  * c0sk_rparams() - Get a ptr to c0sk kvdb rparams
  * @self:       Instance of struct c0sk
@@ -301,6 +337,16 @@ c0sk_cursor_update(
     u64                      seqno,
     u32 *                    flags_out);
 
+/**
+ * c0sk_cursor_rtombs() - collect the range tombstones in a c0 cursor's view
+ * @c0cur: The existing cursor.
+ * @vec:   tombstone vector to which the tombstones are appended
+ *
+ * The tombstone keys remain valid until the cursor is next updated.
+ */
+merr_t
+c0sk_cursor_rtombs(struct c0_cursor *cur, struct kvs_rtomb_vec *vec);
+
 /**
  * c0sk_cursor_destroy() - destroy existing iterators over c0
  * @c0cur:      The existing cursor.
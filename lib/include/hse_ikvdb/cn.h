@@ -14,6 +14,7 @@
 #include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/kvdb_health.h>
 #include <hse_ikvdb/kvs.h>
+#include <hse_ikvdb/kvs_merge.h>
 
 /* MTF_MOCK_DECL(cn) */
 
@@ -103,6 +104,46 @@ cn_get_mclass_policy(const struct cn *cn);
 void
 cn_disable_maint(struct cn *handle, bool onoff);
 
+/**
+ * cn_merge_op_set() - register the kvs merge operator
+ * @cn:  cn handle
+ * @fn:  operator callback
+ * @arg: argument passed to @fn
+ *
+ * The operator may be registered only once per open.
+ */
+merr_t
+cn_merge_op_set(struct cn *cn, hse_kvs_merge_fn *fn, void *arg);
+
+/* MTF_MOCK */
+const struct kvs_merge_op *
+cn_get_merge_op(struct cn *cn);
+
+/**
+ * struct cn_compact_filter - a registered compaction filter
+ * @cf_fn:  filter callback
+ * @cf_arg: argument passed to each invocation of @cf_fn
+ */
+struct cn_compact_filter {
+    hse_kvs_compact_filter_fn *cf_fn;
+    void                      *cf_arg;
+};
+
+/**
+ * cn_compact_filter_set() - register the kvs compaction filter
+ * @cn:  cn handle
+ * @fn:  filter callback
+ * @arg: argument passed to @fn
+ *
+ * The filter may be registered only once per open.
+ */
+merr_t
+cn_compact_filter_set(struct cn *cn, hse_kvs_compact_filter_fn *fn, void *arg);
+
+/* MTF_MOCK */
+const struct cn_compact_filter *
+cn_get_compact_filter(struct cn *cn);
+
 /*
  * Note: Tombstones indicated by:
  *     return value == hse_success && res == FOUND_TOMB
@@ -116,6 +157,42 @@ cn_get(
     enum key_lookup_res *res,
     struct kvs_buf *     vbuf);
 
+/**
+ * cn_get_multi() - batched version of cn_get()
+ * @cn:    cn handle
+ * @ktv:   vector of keys
+ * @seq:   view sequence number
+ * @resv:  (output) vector of lookup results
+ * @vbufv: vector of value buffers
+ * @idxv:  indices into @ktv/@resv/@vbufv of the keys to look up, in key order
+ * @idxc:  number of entries in @idxv
+ */
+merr_t
+cn_get_multi(
+    struct cn *          cn,
+    struct kvs_ktuple *  ktv,
+    u64                  seq,
+    enum key_lookup_res *resv,
+    struct kvs_buf *     vbufv,
+    const uint *         idxv,
+    uint                 idxc);
+
+/**
+ * cn_scan_bounds() - find keys that divide a kvs into ranges for parallel scans
+ * @cn:     cn handle
+ * @rangec: number of key ranges desired
+ * @keyv:   buffer of (@rangec - 1) * HSE_KVS_KEY_LEN_MAX bytes for the keys
+ * @klenv:  (output) key lengths
+ * @keycp:  (output) number of keys found, at most @rangec - 1
+ *
+ * The keys are edge keys of the cn route map, chosen such that the leaf
+ * nodes between consecutive keys hold about the same amount of data.  Range
+ * i holds the keys greater than key i - 1 and less than or equal to key i.
+ * Fewer keys are found when there are too few leaf nodes.
+ */
+void
+cn_scan_bounds(struct cn *cn, uint rangec, void *keyv, uint *klenv, uint *keycp);
+
 struct query_ctx;
 
 merr_t
@@ -177,6 +254,10 @@ cn_ref_wait(struct cn *cn);
 struct workqueue_struct *
 cn_get_io_wq(struct cn *cn);
 
+/* MTF_MOCK */
+struct workqueue_struct *
+cn_get_wr_wq(struct cn *cn);
+
 /* MTF_MOCK */
 struct workqueue_struct *
 cn_get_maint_wq(struct cn *cn);
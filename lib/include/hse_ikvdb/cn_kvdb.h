@@ -18,6 +18,7 @@
 struct cn_kvdb {
     struct workqueue_struct *cn_maint_wq;
     struct workqueue_struct *cn_io_wq;
+    struct workqueue_struct *cn_wr_wq;
 };
 
 /* MTF_MOCK */
@@ -13,6 +13,7 @@
 
 struct mpool;
 struct kvset_meta;
+struct kvset_summary;
 struct kvdb_rparams;
 struct kvs_cparams;
 struct kvdb_health;
@@ -133,6 +134,26 @@ cndb_record_kvset_del_ack(struct cndb *cndb, struct cndb_txn *tx, void *cookie);
 merr_t
 cndb_record_nak(struct cndb *cndb, struct cndb_txn *tx);
 
+/**
+ * cndb_record_kvset_summary() - remember a kvset's summary
+ * @cndb:    cndb handle
+ * @cnid:    cnid of the kvset's kvs
+ * @kvsetid: kvset ID
+ * @sum:     summary (copied)
+ *
+ * Summaries are not logged when recorded.  They are written along with
+ * the kvsets they describe each time the cndb is compacted, including once
+ * more at close if any were recorded since the last compaction.  A kvset's
+ * summary is forgotten when the kvset is deleted.
+ */
+/* MTF_MOCK */
+merr_t
+cndb_record_kvset_summary(
+    struct cndb                *cndb,
+    uint64_t                    cnid,
+    uint64_t                    kvsetid,
+    const struct kvset_summary *sum);
+
 /* MTF_MOCK */
 uint
 cndb_kvs_count(struct cndb *cndb);
@@ -6,6 +6,7 @@
 #ifndef HSE_IKVDB_API_H
 #define HSE_IKVDB_API_H
 
+#include <hse/experimental.h>
 #include <hse/flags.h>
 
 #include <hse_ikvdb/tuple.h>
@@ -35,11 +36,13 @@ struct kvs_rparams;
 struct kvs_cparams;
 struct hse_kvdb_opspec;
 struct hse_kvs_cursor;
+struct hse_kvs_cursor_pair;
 struct mpool;
 struct c0sk;
 struct cndb;
 struct kvdb_diag_kvs_list;
 struct kvs;
+struct kvs_batch_op;
 struct ikvdb_kvs_hdl;
 enum hse_mclass;
 
@@ -403,6 +406,43 @@ ikvdb_kvs_put(
     struct kvs_ktuple *      kt,
     struct kvs_vtuple       *vt);
 
+/**
+ * ikvdb_kvs_put_expire() - as for ikvdb_kvs_put(), but the value expires
+ * @expire: expiry time in seconds since the epoch (zero if none)
+ */
+merr_t
+ikvdb_kvs_put_expire(
+    struct hse_kvs *         kvs,
+    unsigned int             flags,
+    struct hse_kvdb_txn *    txn,
+    struct kvs_ktuple *      kt,
+    struct kvs_vtuple       *vt,
+    uint32_t                 expire);
+
+/**
+ * ikvdb_kvs_merge() - add a merge operand to the value of a key
+ *
+ * Non-transactional merges are stored as operands and resolved lazily,
+ * transactional merges are resolved immediately.
+ */
+merr_t
+ikvdb_kvs_merge(
+    struct hse_kvs *     kvs,
+    unsigned int         flags,
+    struct hse_kvdb_txn *txn,
+    struct kvs_ktuple *  kt,
+    const void *         operand,
+    size_t               operand_len);
+
+merr_t
+ikvdb_kvs_merge_operator_set(struct hse_kvs *kvs, hse_kvs_merge_fn *fn, void *arg);
+
+/**
+ * ikvdb_kvs_compact_filter_set() - register the compaction filter of a kvs
+ */
+merr_t
+ikvdb_kvs_compact_filter_set(struct hse_kvs *kvs, hse_kvs_compact_filter_fn *fn, void *arg);
+
 /**
  * ikvdb_kvs_get() - search for the given key within the KVS. HSE allocates
  * memory for the result if vbuf->b_buf is NULL.
@@ -416,6 +456,28 @@ ikvdb_kvs_get(
     enum key_lookup_res *res,
     struct kvs_buf *     vbuf);
 
+/**
+ * ikvdb_kvs_get_multi() - search for a batch of keys within the KVS
+ * @handle: kvs handle
+ * @flags:  reserved, must be zero
+ * @txn:    optional transaction
+ * @cnt:    number of keys in @ktv (at most HSE_KVS_GET_MULTI_MAX)
+ * @ktv:    vector of keys
+ * @resv:   (output) vector of lookup results
+ * @vbufv:  vector of value buffers (see ikvdb_kvs_get())
+ *
+ * All keys are looked up against the same view seqno.
+ */
+merr_t
+ikvdb_kvs_get_multi(
+    struct hse_kvs *     handle,
+    unsigned int         flags,
+    struct hse_kvdb_txn *txn,
+    uint                 cnt,
+    struct kvs_ktuple *  ktv,
+    enum key_lookup_res *resv,
+    struct kvs_buf *     vbufv);
+
 /**
  * ikvdb_kvs_del() - remove the supplied key and associated value from the KVS
  * indexed by opspec->kop_index.
@@ -452,6 +514,37 @@ ikvdb_kvs_prefix_delete(
     struct hse_kvdb_txn *txn,
     struct kvs_ktuple *  kt);
 
+/**
+ * ikvdb_kvs_range_delete() - remove all key/value pairs in [start, end)
+ * from a non-transactional KVS
+ */
+merr_t
+ikvdb_kvs_range_delete(
+    struct hse_kvs *     kvs,
+    unsigned int         flags,
+    struct kvs_ktuple *  start,
+    struct kvs_ktuple *  end);
+
+/**
+ * ikvdb_kvs_write_batch() - apply a batch of puts, deletes and prefix deletes
+ * @handle: kvdb handle
+ * @flags:  put flags, applied to all puts
+ * @txn:    optional transaction
+ * @opc:    number of ops in @opv (at most HSE_KVS_WRITE_BATCH_MAX)
+ * @kvsv:   vector of kvs handles, one per op
+ * @opv:    vector of ops (kbo_kvs is set from @kvsv)
+ *
+ * Admission checks and throttling are performed once for the entire batch.
+ */
+merr_t
+ikvdb_kvs_write_batch(
+    struct ikvdb *          handle,
+    unsigned int            flags,
+    struct hse_kvdb_txn *   txn,
+    uint                    opc,
+    struct hse_kvs *const * kvsv,
+    struct kvs_batch_op *   opv);
+
 merr_t
 ikvdb_kvs_param_get(
     struct hse_kvs *kvs,
@@ -533,6 +626,20 @@ ikvdb_kvs_cursor_create(
     size_t                  pfx_len,
     struct hse_kvs_cursor **cursor);
 
+/**
+ * ikvdb_kvs_cursor_create_partitioned() - return up to @cursormax forward
+ * cursors over disjoint key ranges that together cover the KVS.  The ranges
+ * are taken from the cn route map and all the cursors share one view.
+ */
+merr_t
+ikvdb_kvs_cursor_create_partitioned(
+    struct hse_kvs *        kvs,
+    unsigned int            flags,
+    struct hse_kvdb_txn *   txn,
+    unsigned int            cursormax,
+    struct hse_kvs_cursor **cursorv,
+    unsigned int *          cursorc);
+
 /**
  * ikvdb_kvs_cursor_update() - incorporate updates since cursor created
  */
@@ -581,6 +688,23 @@ ikvdb_kvs_cursor_read_copy(
     size_t *               val_len,
     bool *                 eof);
 
+/**
+ * ikvdb_kvs_cursor_read_batch() - read a batch of elements into a buffer
+ *
+ * See hse_kvs_cursor_read_batch().
+ */
+merr_t
+ikvdb_kvs_cursor_read_batch(
+    struct hse_kvs_cursor      *cur,
+    unsigned int                flags,
+    void                       *buf,
+    size_t                      buf_sz,
+    size_t                      val_len_max,
+    struct hse_kvs_cursor_pair *pairv,
+    size_t                      pairmax,
+    size_t                     *pairc,
+    bool                       *eof);
+
 /**
  * ikvdb_kvs_cursor_destroy() - allow the caller to indicate that is is done
  * with the scan and release the associated cursor
@@ -678,6 +802,15 @@ ikvdb_wal_replay_prefix_del(
     u64                   seqno,
     struct kvs_ktuple    *kt);
 
+merr_t
+ikvdb_wal_replay_range_del(
+    struct ikvdb         *ikvdb,
+    struct ikvdb_kvs_hdl *ikvsh,
+    u64                   cnid,
+    u64                   seqno,
+    struct kvs_ktuple    *kt,
+    struct kvs_vtuple    *vt);
+
 void
 ikvdb_wal_replay_seqno_set(struct ikvdb *ikvdb, uint64_t seqno);
 
@@ -118,6 +118,19 @@ kvdb_ctxn_trylock_write(
     u64               pfxhash,
     u64               keyhash);
 
+/* Exclusively lock a txn for a batch of writes (e.g., write batch)  */
+/* MTF_MOCK */
+merr_t
+kvdb_ctxn_trylock_write_batch(
+    struct kvdb_ctxn *handle,
+    uintptr_t        *seqref,
+    u64              *view_seqno,
+    int64_t          *cookie,
+    uint              cnt,
+    const bool       *is_ptombv,
+    const u64        *pfxhashv,
+    const u64        *keyhashv);
+
 /* MTF_MOCK */
 void
 kvdb_ctxn_unlock(
@@ -34,6 +34,7 @@
  * @perfc_level:      perf counter engagement level
  * @c0_diag_mode:     disable c0 spill
  * @c0_debug:         c0 debug flags (see param_debug_flags.h)
+ * @c0_concurrent:    index c0 kvsets with a concurrent skiplist
  * @keylock_tables:   number of keylock hash tables
  * @txn_wkth_delay:        delay (msecs) to invoke transaction worker thread
  *
@@ -51,6 +52,7 @@ struct kvdb_rparams {
     uint8_t perfc_enable;
     bool    c0_diag_mode;
     uint8_t c0_debug;
+    bool    c0_concurrent;
 
     uint32_t c0_ingest_width;
 
@@ -66,6 +68,7 @@ struct kvdb_rparams {
     uint8_t  csched_gc_pct;
     uint8_t  csched_lscat_hwm;
     uint8_t  csched_lscat_runlen_max;
+    uint8_t  csched_subcomp_max;
     uint64_t csched_rspill_params;
     uint64_t csched_leaf_comp_params;
     uint64_t csched_leaf_len_params;
@@ -74,9 +77,12 @@ struct kvdb_rparams {
     uint32_t dur_bufsz_mb;
     uint32_t dur_intvl_ms;
     uint32_t dur_size_bytes;
+    uint32_t dur_gc_delay_max_us;
+    uint32_t dur_file_recycle_max;
     bool     dur_enable;
     bool     dur_buf_managed;
     bool     dur_replay_force;
+    bool     dur_gc_enable;
     uint8_t  dur_throttle_lo_th;
     uint8_t  dur_throttle_hi_th;
     uint8_t  dur_mclass;
@@ -94,6 +100,7 @@ struct kvdb_rparams {
     uint64_t txn_wkth_delay;
     uint32_t c0_maint_threads;
     uint32_t c0_ingest_threads;
+    uint32_t c0_build_threads;
     uint16_t cn_maint_threads;
     uint16_t cn_io_threads;
     uint32_t cndb_compact_hwm_pct;
@@ -101,6 +108,8 @@ struct kvdb_rparams {
     uint32_t keylock_tables;
 
     bool   dio_enable[HSE_MCLASS_COUNT];
+    uint8_t io_backend[HSE_MCLASS_COUNT];
+    uint32_t bcache_size_mb;
     struct mclass_policy mclass_policies[HSE_MPOLICY_COUNT];
 };
 
@@ -76,6 +76,28 @@ struct ikvs {
     const char *ikv_kvs_name;
 };
 
+enum kvs_batch_opcode {
+    KVS_BATCH_PUT,
+    KVS_BATCH_DEL,
+    KVS_BATCH_PDEL,
+};
+
+/**
+ * struct kvs_batch_op - a single mutation within a write batch
+ * @kbo_kvs:    kvs to which the mutation applies
+ * @kbo_op:     put, delete or prefix delete
+ * @kbo_skidx:  c0 index of @kbo_kvs (set by kvs_write_batch())
+ * @kbo_kt:     key (or prefix) of the mutation
+ * @kbo_vt:     value of the mutation (puts only)
+ */
+struct kvs_batch_op {
+    struct ikvs          *kbo_kvs;
+    enum kvs_batch_opcode kbo_op;
+    uint16_t              kbo_skidx;
+    struct kvs_ktuple     kbo_kt;
+    struct kvs_vtuple     kbo_vt;
+};
+
 /* kvs interfaces...
  */
 merr_t
@@ -127,6 +149,13 @@ kvs_cursor_seek(
 merr_t
 kvs_cursor_read(struct hse_kvs_cursor *cursor, unsigned int flags, bool *eof);
 
+/**
+ * kvs_cursor_unread() - return the element just read by the next read
+ * @cursor: cursor whose last operation was a successful kvs_cursor_read()
+ */
+void
+kvs_cursor_unread(struct hse_kvs_cursor *cursor);
+
 void
 kvs_cursor_key_copy(
     struct hse_kvs_cursor  *cursor,
@@ -185,9 +214,63 @@ kvs_get(
     enum key_lookup_res *res,
     struct kvs_buf *     vbuf);
 
+/**
+ * kvs_get_merge() - resolve a merge operand found by a lookup
+ * @kt:      key (kt_hash must be set)
+ * @seqno:   view seqno of the lookup
+ * @opnd:    the operand, or NULL to refetch it
+ * @opndlen: length of %opnd
+ * @opndseq: seqno of the operand
+ * @res:     (output) lookup result
+ * @vbuf:    (output) resolved value
+ *
+ * Folds the operand with all older operands of the key and applies the
+ * result to the key's value (or to nothing if there is none).  %opnd may
+ * point into %vbuf.
+ */
+merr_t
+kvs_get_merge(
+    struct ikvs *        ikvs,
+    struct hse_kvdb_txn *txn,
+    struct kvs_ktuple *  kt,
+    u64                  seqno,
+    const void *         opnd,
+    uint                 opndlen,
+    u64                  opndseq,
+    enum key_lookup_res *res,
+    struct kvs_buf *     vbuf);
+
+merr_t
+kvs_get_multi(
+    struct ikvs *        ikvs,
+    struct hse_kvdb_txn *txn,
+    uint                 cnt,
+    struct kvs_ktuple *  ktv,
+    u64                  seqno,
+    enum key_lookup_res *resv,
+    struct kvs_buf *     vbufv);
+
 merr_t
 kvs_del(struct ikvs *ikvs, struct hse_kvdb_txn *txn, struct kvs_ktuple *key, u64 seqno);
 
+/**
+ * kvs_write_batch() - apply a batch of mutations to one or more kvs
+ * @txn:        txn to which the mutations belong (optional)
+ * @opc:        number of mutations in @opv
+ * @opv:        vector of mutations, applied in order
+ * @seqnoref:   seqnoref for non-txn mutations, ignored if @txn is given
+ *
+ * All mutations are logged as a single WAL record and inserted into
+ * the active c0 kvms in a single pass.  All kvses in @opv must belong
+ * to the same kvdb.
+ *
+ * Return: 0 on success, merr(EINVAL) if a key is shorter than its kvs's
+ * prefix plus suffix length, otherwise an error from locking @txn, from
+ * logging the batch or from inserting it into c0.
+ */
+merr_t
+kvs_write_batch(struct hse_kvdb_txn *txn, uint opc, struct kvs_batch_op *opv, uintptr_t seqnoref);
+
 merr_t
 kvs_pfx_probe(
     struct ikvs *        kvs,
@@ -201,6 +284,16 @@ kvs_pfx_probe(
 merr_t
 kvs_prefix_del(struct ikvs *ikvs, struct hse_kvdb_txn *txn, struct kvs_ktuple *key, u64 seqno);
 
+/**
+ * kvs_range_del() - delete all keys in the range [start, end)
+ * @ikvs:     kvs handle
+ * @start:    first key of the range
+ * @end:      end of the range (exclusive)
+ * @seqnoref: seqnoref for the range delete (non-txn only)
+ */
+merr_t
+kvs_range_del(struct ikvs *ikvs, struct kvs_ktuple *start, struct kvs_ktuple *end, uintptr_t seqnoref);
+
 void
 kvs_maint_task(struct ikvs *ikvs, u64 now);
 
@@ -18,6 +18,7 @@ struct kvs_cparams {
     uint32_t  pfx_len;
     uint32_t  sfx_len;
     uint32_t  kvs_ext01;
+    uint32_t  vinline_len;
 };
 
 const struct param_spec *
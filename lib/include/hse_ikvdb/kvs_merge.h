@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_KVS_MERGE_H
+#define HSE_KVS_MERGE_H
+
+#include <hse/limits.h>
+#include <hse/experimental.h>
+
+#include <hse/error/merr.h>
+#include <hse_util/inttypes.h>
+#include <hse_util/key_util.h>
+
+/**
+ * struct kvs_merge_op - a registered merge operator
+ * @mo_fn:  operator callback
+ * @mo_arg: argument passed to each invocation of @mo_fn
+ */
+struct kvs_merge_op {
+    hse_kvs_merge_fn *mo_fn;
+    void             *mo_arg;
+};
+
+/**
+ * struct kvs_merge - merge operand accumulator
+ * @km_op:     merge operator (may be NULL)
+ * @km_buf:    accumulated operand or resolved value
+ * @km_tmp:    scratch buffer for the operator's output
+ * @km_len:    length of the data in %km_buf
+ * @km_seq:    seqno of the newest operand in the accumulator
+ * @km_opnd:   %km_buf holds an operand (not yet resolved)
+ * @km_active: accumulator has been started and not yet consumed
+ * @km_klen:   length of %km_key
+ * @km_key:    key to which the operands apply
+ *
+ * Operands are accumulated from newest to oldest.  kvs_merge_fold()
+ * combines the accumulator with an older operand, yielding an operand,
+ * while kvs_merge_resolve() applies the accumulator to the value it
+ * updates (or to nothing), yielding a value.  If either fails, the
+ * accumulator is left unchanged so that the caller may fall back to
+ * emitting the accumulated operand as-is.
+ */
+struct kvs_merge {
+    const struct kvs_merge_op *km_op;
+    void                      *km_buf;
+    void                      *km_tmp;
+    uint                       km_len;
+    u64                        km_seq;
+    bool                       km_opnd;
+    bool                       km_active;
+    uint                       km_klen;
+    char                       km_key[HSE_KVS_KEY_LEN_MAX];
+};
+
+/**
+ * kvs_merge_init() - allocate accumulator buffers
+ * @km: merge accumulator
+ *
+ * Each buffer is large enough to hold a max-sized value.
+ */
+merr_t
+kvs_merge_init(struct kvs_merge *km);
+
+void
+kvs_merge_fini(struct kvs_merge *km);
+
+/**
+ * kvs_merge_start() - start accumulating operands for a key
+ * @km:   merge accumulator
+ * @op:   merge operator (NULL if none is registered)
+ * @kobj: key
+ * @opnd: newest operand
+ * @len:  length of %opnd
+ * @seq:  seqno of %opnd
+ */
+void
+kvs_merge_start(
+    struct kvs_merge          *km,
+    const struct kvs_merge_op *op,
+    const struct key_obj      *kobj,
+    const void                *opnd,
+    uint                       len,
+    u64                        seq);
+
+/**
+ * kvs_merge_fold() - combine the accumulator with an older operand
+ * @km:     merge accumulator
+ * @opnd:   older operand
+ * @len:    length of %opnd
+ * @maxlen: max length of the combined operand
+ *
+ * Return: ENOTSUP if no operator is registered, EMSGSIZE if the result
+ * exceeds %maxlen, or the error returned by the operator.
+ */
+merr_t
+kvs_merge_fold(struct kvs_merge *km, const void *opnd, uint len, uint maxlen);
+
+/**
+ * kvs_merge_resolve() - apply the accumulator to the value it updates
+ * @km:     merge accumulator
+ * @base:   value (NULL if the key has no value)
+ * @len:    length of %base
+ * @maxlen: max length of the resolved value
+ *
+ * Return: As for kvs_merge_fold().  On success %km_buf holds a value.
+ */
+merr_t
+kvs_merge_resolve(struct kvs_merge *km, const void *base, uint len, uint maxlen);
+
+#endif
@@ -65,8 +65,11 @@ struct kvs_rparams {
     bool     cn_bloom_preload;
     uint64_t cn_bloom_prob;
     uint64_t cn_bloom_capped;
+    uint64_t cn_node_bloom_prob;
+    bool     cn_kblock_compress;
 
     uint64_t cn_kcachesz;
+    bool     cn_kvset_lazy_open;
 
     uint64_t capped_evict_ttl;
 
@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef HSE_KVS_RTOMB_H
+#define HSE_KVS_RTOMB_H
+
+#include <hse/error/merr.h>
+#include <hse_util/inttypes.h>
+#include <hse_util/key_util.h>
+
+/**
+ * struct kvs_rtomb - a range tombstone
+ * @kr_start:     first key of the deleted range (inclusive)
+ * @kr_end:       end of the deleted range (exclusive)
+ * @kr_seq:       seqno of the range delete
+ * @kr_start_len: length of %kr_start
+ * @kr_end_len:   length of %kr_end
+ *
+ * A range tombstone hides every value of every key in [start, end) whose
+ * seqno is less than %kr_seq.  The keys are not owned by the tombstone,
+ * they reference c0 cheap memory or the mapped hblock in which the
+ * tombstone is stored.
+ */
+struct kvs_rtomb {
+    const void *kr_start;
+    const void *kr_end;
+    u64         kr_seq;
+    u16         kr_start_len;
+    u16         kr_end_len;
+};
+
+/**
+ * struct kvs_rtomb_vec - a growable vector of range tombstones
+ * @krv_rtv: tombstone vector
+ * @krv_cnt: number of tombstones in %krv_rtv
+ * @krv_max: capacity of %krv_rtv
+ */
+struct kvs_rtomb_vec {
+    struct kvs_rtomb *krv_rtv;
+    uint              krv_cnt;
+    uint              krv_max;
+};
+
+/**
+ * kvs_rtomb_covers() - check whether a key lies within a range tombstone
+ * @rt:   range tombstone
+ * @kobj: key
+ */
+static inline bool
+kvs_rtomb_covers(const struct kvs_rtomb *rt, const struct key_obj *kobj)
+{
+    struct key_obj ko;
+
+    key2kobj(&ko, rt->kr_start, rt->kr_start_len);
+    if (key_obj_cmp(&ko, kobj) > 0)
+        return false;
+
+    key2kobj(&ko, rt->kr_end, rt->kr_end_len);
+
+    return key_obj_cmp(kobj, &ko) < 0;
+}
+
+/**
+ * kvs_rtomb_seq() - find the newest range tombstone that covers a key
+ * @rtv:  tombstone vector, as arranged by kvs_rtomb_vec_sort()
+ * @rtc:  number of tombstones in %rtv
+ * @kobj: key
+ * @view: ignore tombstones whose seqno is greater than %view
+ *
+ * Costs a binary search over the fragments of %rtv, plus a walk over the
+ * seqnos of the fragment that covers %kobj.
+ *
+ * Return: The seqno of the newest visible tombstone covering %kobj,
+ * or zero if there is none.
+ */
+u64
+kvs_rtomb_seq(const struct kvs_rtomb *rtv, uint rtc, const struct key_obj *kobj, u64 view);
+
+/**
+ * kvs_rtomb_vec_add() - append a range tombstone to a vector
+ * @vec: tombstone vector
+ * @rt:  tombstone (the keys are not copied)
+ */
+merr_t
+kvs_rtomb_vec_add(struct kvs_rtomb_vec *vec, const struct kvs_rtomb *rt);
+
+/**
+ * kvs_rtomb_vec_sort() - arrange a vector of range tombstones for lookups
+ * @vec: tombstone vector
+ *
+ * Splits the tombstones at each other's bounds so that any two of them
+ * cover either the same range or disjoint ranges, drops the duplicates,
+ * merges adjacent ranges that carry the same seqnos, and sorts the result
+ * by start key and then newest first.  The set of keys hidden at any view
+ * is unchanged.  The fragments reference the keys of the original
+ * tombstones.
+ */
+merr_t
+kvs_rtomb_vec_sort(struct kvs_rtomb_vec *vec);
+
+static inline void
+kvs_rtomb_vec_reset(struct kvs_rtomb_vec *vec)
+{
+    vec->krv_cnt = 0;
+}
+
+void
+kvs_rtomb_vec_fini(struct kvs_rtomb_vec *vec);
+
+#endif
@@ -22,6 +22,8 @@ struct kvs_rparams;
 struct perfc_set;
 struct cn_merge_stats;
 struct vgmap;
+struct workqueue_struct;
+struct kvs_rtomb;
 
 struct key_stats {
     uint nvals;
@@ -29,6 +31,9 @@ struct key_stats {
     uint nptombs;
     u64  tot_vlen;
     u64  tot_vused;
+    u64  ttl_bytes;
+    u32  ttl_min;
+    u32  ttl_max;
 };
 
 /* MTF_MOCK_DECL(kvset_builder) */
@@ -44,6 +49,39 @@ kvset_builder_create(
 merr_t
 kvset_builder_get_mblocks(struct kvset_builder *builder, struct kvset_mblocks *mblocks);
 
+/**
+ * kvset_builder_get_mblocks_concat() - build one kvset from several builders
+ * @bldv:    builders, ordered by key range (disjoint and ascending)
+ * @bldc:    number of builders in @bldv
+ * @mblocks: (output) mblocks of the new kvset
+ *
+ * The kblocks and vblocks of all the builders are concatenated in order,
+ * each builder's vblocks forming a vgroup, and a single hblock is written
+ * by @bldv[0].  Each builder must have been created with a distinct vgroup
+ * id and assigned a disjoint vblock index range with kvset_builder_set_vbidx().
+ * Only @bldv[0] may contain range tombstones, and none may contain prefix
+ * tombstones.  The builders must still be destroyed by the caller.
+ */
+/* MTF_MOCK */
+merr_t
+kvset_builder_get_mblocks_concat(
+    struct kvset_builder **bldv,
+    uint                   bldc,
+    struct kvset_mblocks  *mblocks);
+
+/**
+ * kvset_builder_set_vbidx() - reserve a range of vblock indexes
+ * @self: kvset builder
+ * @base: vblock index recorded in the kblocks for the builder's first vblock
+ * @max:  max number of vblocks the builder may create
+ *
+ * Adding a value that requires more than @max vblocks fails with EFBIG.
+ * Must be called before the first value is added.
+ */
+/* MTF_MOCK */
+void
+kvset_builder_set_vbidx(struct kvset_builder *self, uint base, uint max);
+
 /**
  * kvset_builder_add_key() - start a new kvset entry
  * @builder: kvset builder object
@@ -96,10 +134,39 @@ kvset_builder_add_vref(
     uint                    vlen,
     uint                    complen);
 
+/* MTF_MOCK */
+merr_t
+kvset_builder_add_mval(struct kvset_builder *self, u64 seq, const void *vdata, uint vlen);
+
+/**
+ * kvset_builder_set_expire() - set the expiry time of the next value
+ * @self:   kvset builder
+ * @expire: expiry time in seconds since the epoch (zero if none)
+ *
+ * The expiry time applies only to the value added by the next call to
+ * kvset_builder_add_val(), kvset_builder_add_vref() or
+ * kvset_builder_add_mval(), and is discarded if that value is a tombstone.
+ */
+/* MTF_MOCK */
+void
+kvset_builder_set_expire(struct kvset_builder *self, u32 expire);
+
 /* MTF_MOCK */
 merr_t
 kvset_builder_add_nonval(struct kvset_builder *self, u64 seq, enum kmd_vtype vtype);
 
+/**
+ * kvset_builder_add_rtomb() - add a range tombstone to a kvset
+ * @self: kvset builder
+ * @rt:   range tombstone (the keys are copied)
+ *
+ * Range tombstones are stored in the hblock and may be added at any
+ * time before the builder is finished.
+ */
+/* MTF_MOCK */
+merr_t
+kvset_builder_add_rtomb(struct kvset_builder *self, const struct kvs_rtomb *rt);
+
 /* MTF_MOCK */
 void
 kvset_builder_adopt_vblocks(
@@ -124,6 +191,31 @@ kvset_builder_set_agegroup(struct kvset_builder *self, enum hse_mclass_policy_ag
 void
 kvset_builder_set_merge_stats(struct kvset_builder *self, struct cn_merge_stats *stats);
 
+/**
+ * kvset_builder_set_wq() - overlap kblock/vblock writes with kvset building
+ * @self: kvset builder
+ * @wq:   write workqueue (if NULL, writes remain synchronous)
+ *
+ * Must be called before the first key is added.  All outstanding writes
+ * are waited on by kvset_builder_get_mblocks().
+ */
+/* MTF_MOCK */
+void
+kvset_builder_set_wq(struct kvset_builder *self, struct workqueue_struct *wq);
+
+/**
+ * kvset_builder_set_vdict() - store a value compression dictionary in the vblocks
+ * @self:    kvset builder
+ * @dict:    dictionary, or NULL to reserve space for a dictionary
+ * @dictlen: length of @dict
+ *
+ * Space must be reserved before the first value is added.  The dictionary
+ * may then be set once, after which values compressed with it may be added.
+ */
+/* MTF_MOCK */
+merr_t
+kvset_builder_set_vdict(struct kvset_builder *self, const void *dict, uint dictlen);
+
 #if HSE_MOCKING
 #include "kvset_builder_ut.h"
 #endif /* HSE_MOCKING */
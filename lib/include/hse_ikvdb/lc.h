@@ -63,7 +63,7 @@ lc_get(
     struct lc *              handle,
     u16                      skidx,
     u32                      pfxlen,
-    const struct kvs_ktuple *kt,
+    struct kvs_ktuple *      kt,
     u64                      view_seqno,
     uintptr_t                seqnoref,
     enum key_lookup_res *    res,
@@ -24,6 +24,10 @@
 #define HSE_C0_INGEST_THREADS_DFLT  (3)
 #define HSE_C0_INGEST_THREADS_MAX   (5)
 
+#define HSE_C0_BUILD_THREADS_MIN    (1)
+#define HSE_C0_BUILD_THREADS_DFLT   (4)
+#define HSE_C0_BUILD_THREADS_MAX    (16)
+
 #define HSE_C0_MAINT_THREADS_MIN    (1)
 #define HSE_C0_MAINT_THREADS_DFLT   (3)
 #define HSE_C0_MAINT_THREADS_MAX    (7)
@@ -85,6 +89,11 @@
 
 #define CN_SMALL_VALUE_THRESHOLD    (8)
 
+/* Upper bound on the per-kvs "value.inline_length" cparam, i.e., on the
+ * on-media length of a value stored in the kblock KMD rather than a vblock.
+ */
+#define CN_INLINE_VALUE_LEN_MAX     (1024)
+
 /*
  * Low memory limits.
  */
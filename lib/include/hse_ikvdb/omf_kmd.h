@@ -24,12 +24,31 @@
  *   clen    hg32_1024m   1   1   4   not present for tombs and
  *                                    non-compressed values
  *
+ * Immediate values (stored in the KMD itself) replace vbidx, vboff, vlen
+ * and clen with the following, followed by the on-media value bytes:
+ *
+ *   Member  Encoding    Min Typ Max  Notes
+ *   ------  --------    --- --- ---  -----
+ *   vlen    u8           1   1   1   VTYPE_IVAL
+ *   vlen    hg16_32k     1   2   2   VTYPE_LIVAL, VTYPE_MVAL
+ *   vlen    hg32_1024m   1   2   4   VTYPE_CIVAL, uncompressed length
+ *   clen    hg16_32k     1   2   2   VTYPE_CIVAL
+ *
+ * A value that expires is preceded by an expiry record, which is not
+ * counted as an entry:
+ *
+ *   Member  Encoding    Min Typ Max  Notes
+ *   ------  --------    --- --- ---  -----
+ *   marker  u8           1   1   1   KMD_EXPIRE
+ *   expire  be32         4   4   4   seconds since the epoch
+ *
  * Per-entry overhead:
  *
  *     Min  Typical  Max
  *      3      3      9     A key with 1 tombstone entry
  *      9      9     19     A key with a non-zero length value
  *     10     10     23     A compressed key
+ *     15     15     28     A compressed key that expires
  *
  * KMD List:
  *
@@ -56,7 +75,7 @@
  *
  *    count = kmd_count(mem, &off);
  *    for (i = 0; i < count; i++) {
- *            kmd_type_seq(mem, &off, &vtype, &seq);
+ *            kmd_type_seq_expire(mem, &off, &vtype, &seq, &expire);
  *            if (vtype == VTYPE_UCVAL) {
  *                    kmd_val(mem, &off, &vbidx, &vboff, &vlen);
  *            } else if (vtype == VTYPE_IVAL) {
@@ -72,9 +91,13 @@
 
 #define KMD_MAX_COUNT HG32_1024M_MAX
 
-#define KMD_MAX_ENCODED_ENTRY_LEN 23
+#define KMD_MAX_ENCODED_ENTRY_LEN 28
 #define KMD_MAX_ENCODED_COUNT_LEN 4
 
+/* Expiry record marker, distinct from all kmd_vtype values.
+ */
+#define KMD_EXPIRE 0x80u
+
 static inline uint
 kmd_storage_max(uint count)
 {
@@ -88,6 +111,18 @@ kmd_set_count(void *kmd, size_t *off, uint count)
     encode_hg32_1024m(kmd, off, count);
 }
 
+static inline void
+kmd_add_expire(void *kmd, size_t *off, u32 expire)
+{
+    __be32 val32;
+
+    ((u8 *)kmd)[*off] = KMD_EXPIRE;
+    *off += 1;
+    val32 = cpu_to_be32(expire);
+    memcpy(kmd + *off, &val32, sizeof(val32));
+    *off += sizeof(val32);
+}
+
 static inline void
 kmd_add_tomb(void *kmd, size_t *off, u64 seq)
 {
@@ -124,6 +159,40 @@ kmd_add_ival(void *kmd, size_t *off, u64 seq, const void *vdata, u8 vlen)
     *off += vlen;
 }
 
+static inline void
+kmd_add_lival(void *kmd, size_t *off, u64 seq, const void *vdata, uint vlen)
+{
+    ((u8 *)kmd)[*off] = VTYPE_LIVAL;
+    *off += 1;
+    encode_hg64(kmd, off, seq);
+    encode_hg16_32k(kmd, off, vlen);
+    memcpy(((u8 *)kmd) + *off, vdata, vlen);
+    *off += vlen;
+}
+
+static inline void
+kmd_add_mval(void *kmd, size_t *off, u64 seq, const void *vdata, uint vlen)
+{
+    ((u8 *)kmd)[*off] = VTYPE_MVAL;
+    *off += 1;
+    encode_hg64(kmd, off, seq);
+    encode_hg16_32k(kmd, off, vlen);
+    memcpy(((u8 *)kmd) + *off, vdata, vlen);
+    *off += vlen;
+}
+
+static inline void
+kmd_add_cival(void *kmd, size_t *off, u64 seq, const void *vdata, uint vlen, uint complen)
+{
+    ((u8 *)kmd)[*off] = VTYPE_CIVAL;
+    *off += 1;
+    encode_hg64(kmd, off, seq);
+    encode_hg32_1024m(kmd, off, vlen);
+    encode_hg16_32k(kmd, off, complen);
+    memcpy(((u8 *)kmd) + *off, vdata, complen);
+    *off += complen;
+}
+
 static inline void
 kmd_add_val(void *kmd, size_t *off, u64 seq, uint vbidx, uint vboff, uint vlen)
 {
@@ -162,13 +231,31 @@ kmd_count(const void *kmd, size_t *off)
 }
 
 static inline void
-kmd_type_seq(const void *kmd, size_t *off, enum kmd_vtype *vtype, u64 *seq)
+kmd_type_seq_expire(const void *kmd, size_t *off, enum kmd_vtype *vtype, u64 *seq, u32 *expire)
 {
+    *expire = 0;
+
+    if (((const u8 *)kmd)[*off] == KMD_EXPIRE) {
+        __be32 val32;
+
+        memcpy(&val32, kmd + *off + 1, sizeof(val32));
+        *expire = be32_to_cpu(val32);
+        *off += 1 + sizeof(val32);
+    }
+
     *vtype = ((const u8 *)kmd)[*off];
     *off += 1;
     *seq = decode_hg64(kmd, off);
 }
 
+static inline void
+kmd_type_seq(const void *kmd, size_t *off, enum kmd_vtype *vtype, u64 *seq)
+{
+    u32 expire;
+
+    kmd_type_seq_expire(kmd, off, vtype, seq, &expire);
+}
+
 static inline void
 kmd_val(const void *kmd, size_t *off, uint *vbidx, uint *vboff, uint *vlen)
 {
@@ -202,4 +289,27 @@ kmd_ival(const void *kmd, size_t *off, const void **vbase, uint *vlen)
     *vbase = ((const u8 *)kmd) + *off;
     *off += *vlen;
 }
+
+static inline void
+kmd_lival(const void *kmd, size_t *off, const void **vbase, uint *vlen)
+{
+    *vlen = decode_hg16_32k(kmd, off);
+    *vbase = ((const u8 *)kmd) + *off;
+    *off += *vlen;
+}
+
+static inline void
+kmd_mval(const void *kmd, size_t *off, const void **vbase, uint *vlen)
+{
+    kmd_lival(kmd, off, vbase, vlen);
+}
+
+static inline void
+kmd_cival(const void *kmd, size_t *off, const void **vbase, uint *vlen, uint *complen)
+{
+    *vlen = decode_hg32_1024m(kmd, off);
+    *complen = decode_hg16_32k(kmd, off);
+    *vbase = ((const u8 *)kmd) + *off;
+    *off += *complen;
+}
 #endif
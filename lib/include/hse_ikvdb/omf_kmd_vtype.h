@@ -17,8 +17,11 @@ enum kmd_vtype {
     VTYPE_PTOMB = 3,   // prefix tombstone
     VTYPE_IVAL = 4,    // immediate value, uncompressed, stored in a kblock
     VTYPE_CVAL = 5,    // an LZ4 compressed value stored in a vblock
+    VTYPE_LIVAL = 6,   // immediate value, uncompressed, longer than 255 bytes
+    VTYPE_CIVAL = 7,   // immediate value, compressed, stored in a kblock
+    VTYPE_MVAL = 8,    // immediate merge operand, uncompressed, stored in a kblock
 };
 
-#define NUM_KMD_VTYPES 6
+#define NUM_KMD_VTYPES 9
 
 #endif
@@ -11,14 +11,26 @@ enum {
     GLOBAL_OMF_VERSION2 = 2,
     GLOBAL_OMF_VERSION3 = 3,
     GLOBAL_OMF_VERSION4 = 4,
+    GLOBAL_OMF_VERSION5 = 5,
+    GLOBAL_OMF_VERSION6 = 6,
+    GLOBAL_OMF_VERSION7 = 7,
+    GLOBAL_OMF_VERSION8 = 8,
+    GLOBAL_OMF_VERSION9 = 9,
+    GLOBAL_OMF_VERSION10 = 10,
+    GLOBAL_OMF_VERSION11 = 11,
+    GLOBAL_OMF_VERSION12 = 12,
+    GLOBAL_OMF_VERSION13 = 13,
 };
 
 enum {
     CNDB_VERSION1 = 1,
+    CNDB_VERSION2 = 2,
+    CNDB_VERSION3 = 3,
 };
 
 enum {
-    HBLOCK_HDR_VERSION1 = 1
+    HBLOCK_HDR_VERSION1 = 1,
+    HBLOCK_HDR_VERSION2 = 2,
 };
 
 enum {
@@ -27,18 +39,22 @@ enum {
 
 enum {
     KBLOCK_HDR_VERSION6 = 6,
+    KBLOCK_HDR_VERSION7 = 7,
 };
 
 enum {
     VBLOCK_FOOTER_VERSION1 = 1,
+    VBLOCK_FOOTER_VERSION2 = 2,
 };
 
 enum {
     BLOOM_OMF_VERSION5 = 5,
+    BLOOM_OMF_VERSION6 = 6,
 };
 
 enum {
     WBT_TREE_VERSION6 = 6,
+    WBT_TREE_VERSION7 = 7,
 };
 
 enum {
@@ -59,6 +75,7 @@ enum {
 enum {
     WAL_VERSION1 = 1,
     WAL_VERSION2 = 2,
+    WAL_VERSION3 = 3,
 };
 
 enum {
@@ -66,23 +83,23 @@ enum {
     KVDB_META_VERSION2 = 2,
 };
 
-#define GLOBAL_OMF_VERSION     GLOBAL_OMF_VERSION4
+#define GLOBAL_OMF_VERSION     GLOBAL_OMF_VERSION13
 
 /* In the event one of the following versions in incremented, increment the
  * global OMF version.
  */
 
-#define CNDB_VERSION           CNDB_VERSION1
-#define HBLOCK_HDR_VERSION     HBLOCK_HDR_VERSION1
+#define CNDB_VERSION           CNDB_VERSION3
+#define HBLOCK_HDR_VERSION     HBLOCK_HDR_VERSION2
 #define VGROUP_MAP_VERSION     VGROUP_MAP_VERSION1
-#define KBLOCK_HDR_VERSION     KBLOCK_HDR_VERSION6
-#define VBLOCK_FOOTER_VERSION  VBLOCK_FOOTER_VERSION1
-#define BLOOM_OMF_VERSION      BLOOM_OMF_VERSION5
-#define WBT_TREE_VERSION       WBT_TREE_VERSION6
+#define KBLOCK_HDR_VERSION     KBLOCK_HDR_VERSION7
+#define VBLOCK_FOOTER_VERSION  VBLOCK_FOOTER_VERSION2
+#define BLOOM_OMF_VERSION      BLOOM_OMF_VERSION6
+#define WBT_TREE_VERSION       WBT_TREE_VERSION7
 #define CN_TSTATE_VERSION      CN_TSTATE_VERSION2
 #define MBLOCK_METAHDR_VERSION MBLOCK_METAHDR_VERSION2
 #define MDC_LOGHDR_VERSION     MDC_LOGHDR_VERSION2
-#define WAL_VERSION            WAL_VERSION2
+#define WAL_VERSION            WAL_VERSION3
 #define KVDB_META_VERSION      KVDB_META_VERSION2
 
 #endif
@@ -7,11 +7,14 @@
 #define HSE_KVS_QCTX_H
 
 #include <hse/error/merr.h>
+#include <hse_ikvdb/kvs_rtomb.h>
 
 #include <rbtree.h>
 
 #include <pthread.h>
 
+struct kvs_ktuple;
+
 extern pthread_key_t tomb_thread_key;
 
 /**
@@ -30,12 +33,14 @@ struct tomb_elem {
  * @pos:       current position in the memory region backing tomb elems
  * @ntombs:    number of tombstones encountered in current query
  * @seen:      number of unique keys seen
+ * @rtombs:    range tombstones that overlap the prefix, sorted for lookups
  */
 struct query_ctx {
-    int            pos;
-    uint           ntombs;
-    int            seen;
-    struct rb_root tomb_tree;
+    int                  pos;
+    uint                 ntombs;
+    int                  seen;
+    struct rb_root       tomb_tree;
+    struct kvs_rtomb_vec rtombs;
 };
 
 merr_t
@@ -44,6 +49,41 @@ qctx_tomb_insert(struct query_ctx *qctx, const void *sfx, size_t sfx_len);
 bool
 qctx_tomb_seen(struct query_ctx *qctx, const void *sfx, size_t sfx_len);
 
+/**
+ * qctx_rtombs_add() - add range tombstones to a prefix probe
+ * @qctx: query context
+ * @rtv:  range tombstones
+ * @rtc:  number of tombstones in %rtv
+ * @kt:   prefix being probed
+ * @view: view seqno of the probe
+ *
+ * Tombstones that are not visible at %view or that do not overlap the
+ * prefix are ignored.  The keys of the others are copied into the memory
+ * that backs the tomb elems, so that %rtv need not outlive the call.
+ */
+merr_t
+qctx_rtombs_add(
+    struct query_ctx *       qctx,
+    const struct kvs_rtomb * rtv,
+    uint                     rtc,
+    const struct kvs_ktuple *kt,
+    u64                      view);
+
+/**
+ * qctx_rtomb_seq() - find the newest range tombstone that covers a key
+ * @qctx: query context
+ * @kobj: key
+ * @view: view seqno of the probe
+ */
+static inline u64
+qctx_rtomb_seq(const struct query_ctx *qctx, const struct key_obj *kobj, u64 view)
+{
+    if (!qctx->rtombs.krv_cnt)
+        return 0;
+
+    return kvs_rtomb_seq(qctx->rtombs.krv_rtv, qctx->rtombs.krv_cnt, kobj, view);
+}
+
 void
 qctx_te_mem_reset(void);
 
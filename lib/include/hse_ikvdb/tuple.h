@@ -7,6 +7,7 @@
 #define HSE_CORE_TUPLE_H
 
 #include <stdint.h>
+#include <time.h>
 
 #include <hse/error/merr.h>
 #include <hse_util/key_util.h>
@@ -27,12 +28,30 @@
 #define HSE_CORE_IS_TOMB(ptr)   (((uintptr_t)(ptr) & ~0x1UL) == ~0x1UL)
 #define HSE_CORE_IS_PTOMB(ptr)  (((uintptr_t)(ptr) & ~0x0UL) == ~0x0UL)
 
+/* Merge operands (see hse_kvs_merge()) are flagged by the high bit of the
+ * uncompressed length word of an encoded value length.  Operands are never
+ * compressed, and value lengths never come close to 2GiB.
+ */
+#define HSE_CORE_XLEN_MERGE     (1ul << 31)
+#define HSE_CORE_IS_MERGE(xlen) (((xlen) & HSE_CORE_XLEN_MERGE) != 0)
+
+/* Values that expire (see hse_kvs_put_expire()) are flagged by the next bit
+ * of the uncompressed length word.  The expiry time (u32 seconds since the
+ * epoch, in host byte order) immediately follows the in-core value data and
+ * is included in the length returned by kvs_vtuple_vlen().
+ */
+#define HSE_CORE_XLEN_EXPIRE        (1ul << 30)
+#define HSE_CORE_HAS_EXPIRE(xlen)   (((xlen) & HSE_CORE_XLEN_EXPIRE) != 0)
+#define HSE_CORE_EXPIRE_LEN         (sizeof(uint32_t))
+#define HSE_CORE_XLEN_ULEN_MASK     (0x3ffffffful)
+
 enum key_lookup_res {
     NOT_FOUND = 1,
     FOUND_VAL = 2,
     FOUND_TMB = 3,
     FOUND_PTMB = 4,
     FOUND_MULTIPLE = 5,
+    FOUND_MRG = 6,
 };
 
 /* clang-format on */
@@ -81,11 +100,13 @@ struct kvs_vtuple_ref {
             uint32_t vr_complen;
         } vb;
         struct {
-            uint16_t    vr_len;
+            uint32_t    vr_len;
+            uint32_t    vr_complen;
             const void *vr_data;
         } vi;
     };
     uint64_t vr_seq;
+    uint32_t vr_expire;
 };
 
 static inline void
@@ -144,20 +165,36 @@ kvs_vtuple_cinit(struct kvs_vtuple *vt, void *val, uint vlen, uint clen)
     vt->vt_xlen = ((uint64_t)clen << 32) | vlen;
 }
 
+/**
+ * kvs_vtuple_minit() - initialize a merge operand value tuple
+ * @vt:   the vtuple to initialize
+ * @val:  pointer to the in-core operand
+ * @vlen: the operand length
+ */
+static inline void
+kvs_vtuple_minit(struct kvs_vtuple *vt, void *val, uint vlen)
+{
+    assert(!HSE_CORE_IS_TOMB(val));
+
+    vt->vt_data = val;
+    vt->vt_xlen = HSE_CORE_XLEN_MERGE | vlen;
+}
+
 /**
  * kvs_vtuple_vlen() - return in-core value length
  * @vt: ptr to a vtuple
  *
  * kvs_vtuple_vlen() returns the in-core length (in bytes) of the
- * given vtuple, irrespective of whether or not it is compressed.
+ * given vtuple, irrespective of whether or not it is compressed,
+ * including the expiry time of a value that expires.
  */
 static HSE_ALWAYS_INLINE uint32_t
 kvs_vtuple_vlen(const struct kvs_vtuple *vt)
 {
     const uint32_t clen = vt->vt_xlen >> 32;
-    const uint32_t vlen = vt->vt_xlen & 0xfffffffful;
+    const uint32_t vlen = vt->vt_xlen & HSE_CORE_XLEN_ULEN_MASK;
 
-    return clen ? clen : vlen;
+    return (clen ? clen : vlen) + (HSE_CORE_HAS_EXPIRE(vt->vt_xlen) ? HSE_CORE_EXPIRE_LEN : 0);
 }
 
 static HSE_ALWAYS_INLINE uint32_t
@@ -166,6 +203,16 @@ kvs_vtuple_clen(const struct kvs_vtuple *vt)
     return vt->vt_xlen >> 32;
 }
 
+/**
+ * kvs_expired() - test whether an expiry time has passed
+ * @expire: expiry time in seconds since the epoch (zero if none)
+ */
+static HSE_ALWAYS_INLINE bool
+kvs_expired(uint32_t expire)
+{
+    return expire && expire <= (uint32_t)time(NULL);
+}
+
 static inline void
 kvs_buf_init(struct kvs_buf *vbuf, void *buf, uint32_t buf_size)
 {
@@ -6,11 +6,17 @@
 #ifndef HSE_VCOMP_PARAMS_H
 #define HSE_VCOMP_PARAMS_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
+#include <hse/error/merr.h>
+#include <hse_util/inttypes.h>
+
 #define VCOMP_PARAM_OFF "off"
 #define VCOMP_PARAM_ON  "on"
 #define VCOMP_PARAM_LZ4 "lz4"
+#define VCOMP_PARAM_ZSTD "zstd"
+#define VCOMP_PARAM_ZSTD_DICT "zstd-dict"
 
 enum vcomp_default {
     VCOMP_DEFAULT_OFF,
@@ -21,14 +27,53 @@ enum vcomp_default {
 #define VCOMP_DEFAULT_MAX   VCOMP_DEFAULT_ON
 #define VCOMP_DEFAULT_COUNT (VCOMP_DEFAULT_MAX + 1)
 
+/* VCOMP_ALGO_ZSTD_DICT compresses values with zstd at ingest, and then
+ * recompresses values no larger than VCOMP_DICT_VLEN_MAX during kv-compaction
+ * using a dictionary trained from the values being compacted.
+ */
 enum vcomp_algorithm {
     VCOMP_ALGO_LZ4,
+    VCOMP_ALGO_ZSTD,
+    VCOMP_ALGO_ZSTD_DICT,
 };
 
 #define VCOMP_ALGO_MIN   VCOMP_ALGO_LZ4
-#define VCOMP_ALGO_MAX   VCOMP_ALGO_LZ4
+#define VCOMP_ALGO_MAX   VCOMP_ALGO_ZSTD_DICT
 #define VCOMP_ALGO_COUNT (VCOMP_ALGO_MAX + 1)
 
+#define VCOMP_DICT_VLEN_MAX (16 * 1024)
+
+struct compress_dict;
+
+/* Entries for algorithms not supported by the build are NULL.
+ */
 extern const struct compress_ops *vcomp_compress_ops[VCOMP_ALGO_COUNT];
 
+/**
+ * vcomp_decompress() - decompress a value compressed by any vcomp algorithm
+ * @src:          compressed value
+ * @src_len:      length of @src
+ * @dict:         dictionary of the vblock containing @src (may be NULL)
+ * @dst:          output buffer
+ * @dst_capacity: size of @dst, may be less than the uncompressed length
+ * @dst_len:      (output) number of bytes written to @dst
+ *
+ * Compressed values are self-describing, so @src may have been compressed
+ * with an algorithm other than the one currently configured for the kvs.
+ */
+merr_t
+vcomp_decompress(
+    const void                 *src,
+    uint                        src_len,
+    const struct compress_dict *dict,
+    void                       *dst,
+    uint                        dst_capacity,
+    uint                       *dst_len);
+
+/**
+ * vcomp_dict_tagged() - check whether a value was compressed with a dictionary
+ */
+bool
+vcomp_dict_tagged(const void *src);
+
 #endif
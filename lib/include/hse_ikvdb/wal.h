@@ -25,6 +25,14 @@
 #define HSE_WAL_DUR_BUFSZ_MB_DFLT  (4096ul)
 #define HSE_WAL_DUR_BUFSZ_MB_MAX   (8192ul)
 
+/* Bound on how long a group commit leader waits for followers */
+#define HSE_WAL_GC_DELAY_US_MIN    (0)
+#define HSE_WAL_GC_DELAY_US_DFLT   (500)
+#define HSE_WAL_GC_DELAY_US_MAX    (100 * 1000)
+
+/* Max number of reclaimed WAL files kept for reuse */
+#define HSE_WAL_FILE_RECYCLE_MAX   (16)
+
 struct wal;
 struct throttle_sensor;
 
@@ -97,6 +105,25 @@ wal_del_pfx(
     uint64_t txid,
     struct wal_record *recout);
 
+/* MTF_MOCK */
+merr_t
+wal_del_range(
+    struct wal *wal,
+    struct ikvs *kvs,
+    struct kvs_ktuple *start,
+    struct kvs_ktuple *end,
+    uint64_t txid,
+    struct wal_record *recout);
+
+/* MTF_MOCK */
+merr_t
+wal_batch(
+    struct wal *wal,
+    uint32_t opc,
+    struct kvs_batch_op *opv,
+    uint64_t txid,
+    struct wal_record *recout);
+
 /* MTF_MOCK */
 merr_t
 wal_txn_begin(struct wal *wal, uint64_t txid, int64_t *cookie);
@@ -112,6 +139,16 @@ wal_txn_commit(struct wal *wal, uint64_t txid, uint64_t seqno, uint64_t cid, int
 void
 wal_op_finish(struct wal *wal, struct wal_record *rec, uint64_t seqno, uint64_t gen, int rc);
 
+void
+wal_batch_finish(
+    struct wal *wal,
+    struct wal_record *rec,
+    uint32_t opc,
+    const struct kvs_batch_op *opv,
+    uint64_t seqno,
+    uint64_t gen,
+    int rc);
+
 void
 wal_cningest_cb(
     struct wal *wal,
@@ -129,6 +166,13 @@ wal_sync(struct wal *wal);
 void
 wal_throttle_sensor(struct wal *wal, struct throttle_sensor *sensor);
 
+/* Set up and tear down the interval tables of the WAL perf counters */
+void
+wal_perfc_init(void);
+
+void
+wal_perfc_fini(void);
+
 #if HSE_MOCKING
 #include "wal_ut.h"
 #endif /* HSE_MOCKING */
@@ -26,12 +26,15 @@
 #include <hse_util/xrand.h>
 #include <hse_util/bkv_collection.h>
 #include <hse_util/alloc.h>
+#include <hse_util/keycmp.h>
+#include <hse_util/key_util.h>
 
 #include <hse_ikvdb/config.h>
 #include <hse_ikvdb/argv.h>
 #include <hse_ikvdb/ikvdb.h>
 #include <hse_ikvdb/kvdb_health.h>
 #include <hse_ikvdb/kvs.h>
+#include <hse_ikvdb/kvs_merge.h>
 #include <hse_ikvdb/c0.h>
 #include <hse_ikvdb/c0sk.h>
 #include <hse_ikvdb/c0sk_perfc.h>
@@ -242,6 +245,7 @@ ikvdb_perfc_alloc(struct ikvdb_impl *self)
 
     perfc_alloc(ctxn_perfc_op, group, "set", self->ikdb_rp.perfc_level, &self->ikdb_ctxn_op);
     kvdb_keylock_perfc_init(self->ikdb_keylock, &self->ikdb_ctxn_op);
+    mpool_bcache_perfc_alloc(self->ikdb_mp, group, self->ikdb_rp.perfc_level);
 }
 
 static void
@@ -1068,8 +1072,11 @@ ikvdb_diag_open(
     if (ev(err))
         goto self_cleanup;
 
-    for (int i = HSE_MCLASS_BASE; i < HSE_MCLASS_COUNT; i++)
+    for (int i = HSE_MCLASS_BASE; i < HSE_MCLASS_COUNT; i++) {
         mparams.mclass[i].dio_disable = !params->dio_enable[i];
+        mparams.mclass[i].io_backend = params->io_backend[i];
+    }
+    mparams.bcache_size_mb = params->bcache_size_mb;
 
     flags = params->read_only ? O_RDONLY : O_RDWR;
     err = mpool_open(kvdb_home, &mparams, flags, &self->ikdb_mp);
@@ -1464,8 +1471,11 @@ ikvdb_open(
     if (ev(err))
         goto out;
 
-    for (i = HSE_MCLASS_BASE; i < HSE_MCLASS_COUNT; i++)
+    for (i = HSE_MCLASS_BASE; i < HSE_MCLASS_COUNT; i++) {
         mparams.mclass[i].dio_disable = !params->dio_enable[i];
+        mparams.mclass[i].io_backend = params->io_backend[i];
+    }
+    mparams.bcache_size_mb = params->bcache_size_mb;
 
     flags = params->read_only ? O_RDONLY : O_RDWR;
     err = mpool_open(kvdb_home, &mparams, flags, &self->ikdb_mp);
@@ -2448,17 +2458,18 @@ is_compression_allowed(const struct kvdb_kvs *const kk, const unsigned int flags
         (kk->kk_vcomp_default == VCOMP_DEFAULT_ON && !(flags & HSE_KVS_PUT_VCOMP_OFF));
 }
 
-merr_t
-ikvdb_kvs_put(
+static merr_t
+ikvdb_kvs_put_impl(
     struct hse_kvs *           handle,
     const unsigned int         flags,
     struct hse_kvdb_txn *const txn,
     struct kvs_ktuple *        kt,
-    struct kvs_vtuple *        vt)
+    struct kvs_vtuple *        vt,
+    uint32_t                   expire)
 {
-    void *vbuf;
+    void *vbuf, *ebuf;
     merr_t err;
-    size_t vbufsz;
+    size_t vbufsz, ebufsz;
     uint vlen, clen;
     uint64_t tstart;
     uint64_t seqnoref;
@@ -2517,12 +2528,42 @@ ikvdb_kvs_put(
         }
     }
 
+    /* The expiry time of a value that expires is appended to the in-core
+     * value data (see HSE_CORE_XLEN_EXPIRE), in place if the value was
+     * compressed into vbuf.
+     */
+    ebuf = NULL;
+    ebufsz = 0;
+
+    if (expire) {
+        if (vbuf && vt->vt_data == vbuf && vlen + HSE_CORE_EXPIRE_LEN <= vbufsz) {
+            ebuf = vbuf;
+        } else {
+            ebufsz = vlen + HSE_CORE_EXPIRE_LEN;
+            ebuf = (vbuf != tls_vbuf && ebufsz <= tls_vbufsz) ? tls_vbuf : vlb_alloc(ebufsz);
+            if (!ebuf) {
+                err = merr(ENOMEM);
+                goto out;
+            }
+
+            memcpy(ebuf, vt->vt_data, vlen);
+        }
+
+        memcpy(ebuf + vlen, &expire, HSE_CORE_EXPIRE_LEN);
+        vt->vt_data = ebuf;
+        vt->vt_xlen |= HSE_CORE_XLEN_EXPIRE;
+    }
+
     seqnoref = txn ? 0 : HSE_SQNREF_SINGLE;
 
     err = kvs_put(kk->kk_ikvs, txn, kt, vt, seqnoref);
 
+    if (ebuf && ebuf != vbuf && ebuf != tls_vbuf)
+        vlb_free(ebuf, ebufsz);
+
+out:
     if (vbuf && vbuf != tls_vbuf)
-        vlb_free(vbuf, (vbufsz > VLB_ALLOCSZ_MAX) ? vbufsz : clen);
+        vlb_free(vbuf, (vbufsz > VLB_ALLOCSZ_MAX) ? vbufsz : clen + (expire ? HSE_CORE_EXPIRE_LEN : 0));
 
     if (tstart > 0)
         ikvdb_throttle(parent, kt->kt_len + (clen ? clen : vlen), tstart);
@@ -2530,6 +2571,157 @@ ikvdb_kvs_put(
     return err;
 }
 
+merr_t
+ikvdb_kvs_put(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    struct kvs_ktuple *        kt,
+    struct kvs_vtuple *        vt)
+{
+    return ikvdb_kvs_put_impl(handle, flags, txn, kt, vt, 0);
+}
+
+merr_t
+ikvdb_kvs_put_expire(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    struct kvs_ktuple *        kt,
+    struct kvs_vtuple *        vt,
+    uint32_t                   expire)
+{
+    return ikvdb_kvs_put_impl(handle, flags, txn, kt, vt, expire);
+}
+
+merr_t
+ikvdb_kvs_merge_operator_set(struct hse_kvs *handle, hse_kvs_merge_fn *fn, void *arg)
+{
+    struct kvdb_kvs *kk = (struct kvdb_kvs *)handle;
+
+    if (ev(!handle || !fn))
+        return merr(EINVAL);
+
+    return cn_merge_op_set(kvs_cn(kk->kk_ikvs), fn, arg);
+}
+
+merr_t
+ikvdb_kvs_compact_filter_set(struct hse_kvs *handle, hse_kvs_compact_filter_fn *fn, void *arg)
+{
+    struct kvdb_kvs *kk = (struct kvdb_kvs *)handle;
+
+    if (ev(!handle || !fn))
+        return merr(EINVAL);
+
+    return cn_compact_filter_set(kvs_cn(kk->kk_ikvs), fn, arg);
+}
+
+/* Transactional merges are resolved eagerly within the transaction's view.
+ * All writes by a transaction share a single seqnoref, so leaving operands
+ * in c0 would have each one replace its predecessor rather than stack.
+ */
+static merr_t
+ikvdb_kvs_merge_txn(
+    struct kvdb_kvs *          kk,
+    const struct kvs_merge_op *mop,
+    struct hse_kvdb_txn *const txn,
+    struct kvs_ktuple *        kt,
+    const void *               operand,
+    size_t                     operand_len)
+{
+    enum key_lookup_res res;
+    struct kvs_merge    km;
+    struct kvs_vtuple   vt;
+    struct kvs_buf      vbuf;
+    struct key_obj      kobj;
+    merr_t              err;
+
+    err = kvs_merge_init(&km);
+    if (ev(err))
+        return err;
+
+    kvs_buf_init(&vbuf, vlb_alloc(HSE_KVS_VALUE_LEN_MAX), HSE_KVS_VALUE_LEN_MAX);
+    if (ev(!vbuf.b_buf)) {
+        kvs_merge_fini(&km);
+        return merr(ENOMEM);
+    }
+
+    err = kvs_get(kk->kk_ikvs, txn, kt, 0, &res, &vbuf);
+    if (!err) {
+        key2kobj(&kobj, kt->kt_data, kt->kt_len);
+        kvs_merge_start(&km, mop, &kobj, operand, operand_len, 0);
+
+        err = kvs_merge_resolve(&km, (res == FOUND_VAL) ? vbuf.b_buf : NULL, vbuf.b_len,
+                                HSE_KVS_VALUE_LEN_MAX);
+    }
+
+    if (!err) {
+        kvs_vtuple_init(&vt, km.km_buf, km.km_len);
+
+        err = kvs_put(kk->kk_ikvs, txn, kt, &vt, 0);
+    }
+
+    vlb_free(vbuf.b_buf, HSE_KVS_VALUE_LEN_MAX);
+    kvs_merge_fini(&km);
+
+    return err;
+}
+
+merr_t
+ikvdb_kvs_merge(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    struct kvs_ktuple *        kt,
+    const void *               operand,
+    size_t                     operand_len)
+{
+    const struct kvs_merge_op *mop;
+    struct kvdb_kvs *kk;
+    struct ikvdb_impl *parent;
+    struct kvs_ktuple ktbuf;
+    struct kvs_vtuple vt;
+    uint64_t tstart;
+    merr_t err;
+
+    INVARIANT(handle && kt && operand);
+
+    kk = (struct kvdb_kvs *)handle;
+
+    if (HSE_UNLIKELY(!is_write_allowed(kk->kk_ikvs, txn)))
+        return merr(EINVAL);
+
+    parent = kk->kk_parent;
+    if (HSE_UNLIKELY(parent->ikdb_read_only))
+        return merr(EROFS);
+
+    mop = cn_get_merge_op(kvs_cn(kk->kk_ikvs));
+    if (HSE_UNLIKELY(!mop))
+        return merr(ENOTSUP);
+
+    err = kvdb_health_check(&parent->ikdb_health, KVDB_HEALTH_FLAG_ALL);
+    if (err)
+        return err;
+
+    tstart = (flags & HSE_KVS_PUT_PRIO || parent->ikdb_rp.throttle_disable) ? 0 : get_time_ns();
+
+    ktbuf = *kt;
+    kt = &ktbuf;
+
+    if (txn) {
+        err = ikvdb_kvs_merge_txn(kk, mop, txn, kt, operand, operand_len);
+    } else {
+        kvs_vtuple_minit(&vt, (void *)operand, operand_len);
+
+        err = kvs_put(kk->kk_ikvs, NULL, kt, &vt, HSE_SQNREF_SINGLE);
+    }
+
+    if (tstart > 0)
+        ikvdb_throttle(parent, kt->kt_len + operand_len, tstart);
+
+    return err;
+}
+
 merr_t
 ikvdb_kvs_pfx_probe(
     struct hse_kvs *           handle,
@@ -2603,6 +2795,40 @@ ikvdb_kvs_get(
     return kvs_get(kk->kk_ikvs, txn, kt, view_seqno, res, vbuf);
 }
 
+merr_t
+ikvdb_kvs_get_multi(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    uint                       cnt,
+    struct kvs_ktuple *        ktv,
+    enum key_lookup_res *      resv,
+    struct kvs_buf *           vbufv)
+{
+    struct kvdb_kvs *  kk = (struct kvdb_kvs *)handle;
+    struct ikvdb_impl *p;
+    u64                view_seqno;
+
+    if (ev(!handle || cnt == 0 || cnt > HSE_KVS_GET_MULTI_MAX))
+        return merr(EINVAL);
+
+    if (ev(!is_read_allowed(kk->kk_ikvs, txn)))
+        return merr(EINVAL);
+
+    p = kk->kk_parent;
+
+    /* Establish one view for the entire batch (see ikvdb_kvs_get()).
+     */
+    if (txn) {
+        view_seqno = 0;
+    } else {
+        view_seqno = atomic_read(&p->ikdb_seqno);
+        kvdb_ctxn_set_wait_commits(p->ikdb_ctxn_set, 0);
+    }
+
+    return kvs_get_multi(kk->kk_ikvs, txn, cnt, ktv, view_seqno, resv, vbufv);
+}
+
 merr_t
 ikvdb_kvs_del(
     struct hse_kvs *           handle,
@@ -2675,6 +2901,137 @@ ikvdb_kvs_prefix_delete(
     return kvs_prefix_del(kk->kk_ikvs, txn, kt, seqnoref);
 }
 
+merr_t
+ikvdb_kvs_range_delete(
+    struct hse_kvs *   handle,
+    const unsigned int flags,
+    struct kvs_ktuple *start,
+    struct kvs_ktuple *end)
+{
+    struct kvdb_kvs *  kk = (struct kvdb_kvs *)handle;
+    struct ikvdb_impl *parent;
+    merr_t             err;
+
+    INVARIANT(handle);
+    INVARIANT(start->kt_data && end->kt_data);
+
+    /* Range tombstones are not supported in transactions. */
+    if (ev(!is_write_allowed(kk->kk_ikvs, NULL)))
+        return merr(EINVAL);
+
+    parent = kk->kk_parent;
+    if (ev(parent->ikdb_read_only))
+        return merr(EROFS);
+
+    err = kvdb_health_check(&parent->ikdb_health, KVDB_HEALTH_FLAG_ALL);
+    if (ev(err))
+        return err;
+
+    if (keycmp(start->kt_data, start->kt_len, end->kt_data, end->kt_len) >= 0)
+        return merr(EINVAL);
+
+    /* As with prefix tombstones, the range tombstone takes a unique seqno
+     * so that it hides only those keys written before it.
+     */
+    return kvs_range_del(kk->kk_ikvs, start, end, HSE_SQNREF_SINGLE);
+}
+
+merr_t
+ikvdb_kvs_write_batch(
+    struct ikvdb *              handle,
+    const unsigned int          flags,
+    struct hse_kvdb_txn *const  txn,
+    uint                        opc,
+    struct hse_kvs *const *     kvsv,
+    struct kvs_batch_op *       opv)
+{
+    struct ikvdb_impl *self = ikvdb_h2r(handle);
+    void *vbuf = NULL;
+    size_t vbufsz = 0, vbufoff = 0, bytes = 0;
+    uint64_t tstart;
+    uint64_t seqnoref;
+    merr_t err;
+    uint i;
+
+    INVARIANT(handle && kvsv && opv);
+    INVARIANT(opc > 0 && opc <= HSE_KVS_WRITE_BATCH_MAX);
+
+    if (HSE_UNLIKELY(self->ikdb_read_only))
+        return merr(EROFS);
+
+    for (i = 0; i < opc; i++) {
+        struct kvdb_kvs *kk = (struct kvdb_kvs *)kvsv[i];
+
+        if (ev(kk->kk_parent != self || !is_write_allowed(kk->kk_ikvs, txn)))
+            return merr(EINVAL);
+
+        /* See ikvdb_kvs_prefix_delete() */
+        if (opv[i].kbo_op == KVS_BATCH_PDEL && opv[i].kbo_kt.kt_len != kk->kk_cparams->pfx_len)
+            return merr(EINVAL);
+
+        opv[i].kbo_kvs = kk->kk_ikvs;
+
+        if (opv[i].kbo_op == KVS_BATCH_PUT) {
+            uint vlen = kvs_vtuple_vlen(&opv[i].kbo_vt);
+
+            if (vlen > CN_SMALL_VALUE_THRESHOLD && is_compression_allowed(kk, flags))
+                vbufsz += vlen;
+        }
+    }
+
+    err = kvdb_health_check(&self->ikdb_health, KVDB_HEALTH_FLAG_ALL);
+    if (err)
+        return err;
+
+    tstart = (flags & HSE_KVS_PUT_PRIO || self->ikdb_rp.throttle_disable) ? 0 : get_time_ns();
+
+    /* Compress eligible values into a single scratch buffer (see ikvdb_kvs_put()),
+     * which need only live until the batch has been copied into the WAL.
+     * Each value is given an output capacity equal to its length such that
+     * a value which does not compress is stored in its original form.
+     */
+    if (vbufsz > 0) {
+        vbuf = (vbufsz > tls_vbufsz) ? vlb_alloc(vbufsz) : tls_vbuf;
+        if (!vbuf)
+            vbufsz = 0;
+    }
+
+    for (i = 0; i < opc; i++) {
+        struct kvdb_kvs *kk = (struct kvdb_kvs *)kvsv[i];
+        struct kvs_vtuple *vt = &opv[i].kbo_vt;
+        uint vlen, clen;
+
+        bytes += opv[i].kbo_kt.kt_len;
+
+        if (opv[i].kbo_op != KVS_BATCH_PUT)
+            continue;
+
+        vlen = kvs_vtuple_vlen(vt);
+        bytes += vlen;
+
+        if (vbufsz > 0 && vlen > CN_SMALL_VALUE_THRESHOLD && is_compression_allowed(kk, flags)) {
+            err = kk->kk_vcompress(vt->vt_data, vlen, vbuf + vbufoff, vlen, &clen);
+            if (!err && clen < vlen) {
+                kvs_vtuple_cinit(vt, vbuf + vbufoff, vlen, clen);
+                vbufoff += clen;
+                bytes -= vlen - clen;
+            }
+        }
+    }
+
+    seqnoref = txn ? 0 : HSE_SQNREF_SINGLE;
+
+    err = kvs_write_batch(txn, opc, opv, seqnoref);
+
+    if (vbuf && vbuf != tls_vbuf)
+        vlb_free(vbuf, (vbufsz > VLB_ALLOCSZ_MAX) ? vbufsz : vbufoff);
+
+    if (tstart > 0)
+        ikvdb_throttle(self, bytes, tstart);
+
+    return err;
+}
+
 /*-  IKVDB Cursors --------------------------------------------------*/
 
 /*
@@ -2763,43 +3120,32 @@ cursor_unbind_txn(struct hse_kvs_cursor *cur)
     return 0;
 }
 
-merr_t
-ikvdb_kvs_cursor_create(
-    struct hse_kvs *           handle,
-    const unsigned int         flags,
-    struct hse_kvdb_txn *const txn,
-    const void *               prefix,
-    size_t                     pfx_len,
-    struct hse_kvs_cursor **   cursorp)
+/* Allocate and initialize a cursor.  If vseq is HSE_SQNREF_UNDEFINED the
+ * cursor gets a view of its own, otherwise the caller must hold a view at
+ * vseq (e.g., that of a txn) until this function returns.
+ */
+static merr_t
+cursor_create(
+    struct kvdb_kvs *       kk,
+    const unsigned int      flags,
+    struct kvdb_ctxn *      ctxn,
+    const void *            prefix,
+    size_t                  pfx_len,
+    u64                     vseq,
+    struct hse_kvs_cursor **cursorp)
 {
-    struct kvdb_kvs *      kk = (struct kvdb_kvs *)handle;
     struct ikvdb_impl *    ikvdb = kk->kk_parent;
-    struct kvdb_ctxn *     ctxn = 0;
     struct hse_kvs_cursor *cur = 0;
     merr_t                 err;
-    u64                    ts, vseq, tstart, tseqno;
+    u64                    ts, tstart, tseqno;
     struct perfc_set *     pkvsl_pc;
+    bool                   viewed;
 
     *cursorp = NULL;
 
-    if (ev(!is_read_allowed(kk->kk_ikvs, txn)))
-        return merr(EINVAL);
-
-    if (ev(atomic_read(&ikvdb->ikdb_curcnt) > ikvdb->ikdb_curcnt_max))
-        return merr(ECANCELED);
-
     pkvsl_pc = kvs_perfc_pkvsl(kk->kk_ikvs);
     tstart = perfc_lat_start(pkvsl_pc);
 
-    vseq = HSE_SQNREF_UNDEFINED;
-
-    if (txn) {
-        ctxn = kvdb_ctxn_h2h(txn);
-        err = kvdb_ctxn_get_view_seqno(ctxn, &vseq);
-        if (ev(err))
-            return err;
-    }
-
     /* The initialization sequence is driven by the way the sequence
      * number horizon is tracked, which requires atomically getting a
      * cursor's view sequence number and inserting the cursor at the head
@@ -2831,6 +3177,8 @@ ikvdb_kvs_cursor_create(
     if (ev(err))
         goto out;
 
+    viewed = cur->kc_on_list;
+
     ts = perfc_lat_start(pkvsl_pc);
     err = kvs_cursor_init(cur, ctxn);
     perfc_lat_record(pkvsl_pc, PERFC_LT_PKVSL_KVS_CURSOR_INIT, ts);
@@ -2843,7 +3191,7 @@ ikvdb_kvs_cursor_create(
      * to finish to ensure they never see partial txns.  This is not necessary
      * for txn cursors because their view is inherited from the txn.
      */
-    if (!txn)
+    if (viewed)
         kvdb_ctxn_set_wait_commits(ikvdb->ikdb_ctxn_set, tseqno);
 
     perfc_inc(&kvdb_metrics_pc, PERFC_BA_KVDBMETRICS_CURCNT);
@@ -2860,6 +3208,149 @@ out:
     return err;
 }
 
+merr_t
+ikvdb_kvs_cursor_create(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    const void *               prefix,
+    size_t                     pfx_len,
+    struct hse_kvs_cursor **   cursorp)
+{
+    struct kvdb_kvs *  kk = (struct kvdb_kvs *)handle;
+    struct ikvdb_impl *ikvdb = kk->kk_parent;
+    struct kvdb_ctxn * ctxn = 0;
+    merr_t             err;
+    u64                vseq;
+
+    *cursorp = NULL;
+
+    if (ev(!is_read_allowed(kk->kk_ikvs, txn)))
+        return merr(EINVAL);
+
+    if (ev(atomic_read(&ikvdb->ikdb_curcnt) > ikvdb->ikdb_curcnt_max))
+        return merr(ECANCELED);
+
+    vseq = HSE_SQNREF_UNDEFINED;
+
+    if (txn) {
+        ctxn = kvdb_ctxn_h2h(txn);
+        err = kvdb_ctxn_get_view_seqno(ctxn, &vseq);
+        if (ev(err))
+            return err;
+    }
+
+    return cursor_create(kk, flags, ctxn, prefix, pfx_len, vseq, cursorp);
+}
+
+merr_t
+ikvdb_kvs_cursor_create_partitioned(
+    struct hse_kvs *           handle,
+    const unsigned int         flags,
+    struct hse_kvdb_txn *const txn,
+    unsigned int               cursormax,
+    struct hse_kvs_cursor **   cursorv,
+    unsigned int *             cursorc)
+{
+    struct kvdb_kvs *  kk = (struct kvdb_kvs *)handle;
+    struct ikvdb_impl *ikvdb = kk->kk_parent;
+    struct kvdb_ctxn * ctxn = 0;
+    void *             cookie = NULL;
+    char *             keyv;
+    uint *             klenv;
+    uint               keyc, n = 0;
+    merr_t             err;
+    u64                vseq, tseqno = 0;
+
+    *cursorc = 0;
+
+    if (ev(!is_read_allowed(kk->kk_ikvs, txn)))
+        return merr(EINVAL);
+
+    if (ev(atomic_read(&ikvdb->ikdb_curcnt) + cursormax > ikvdb->ikdb_curcnt_max))
+        return merr(ECANCELED);
+
+    keyv = malloc(cursormax * (HSE_KVS_KEY_LEN_MAX + sizeof(*klenv)));
+    if (ev(!keyv))
+        return merr(ENOMEM);
+
+    klenv = (uint *)(keyv + cursormax * HSE_KVS_KEY_LEN_MAX);
+
+    /* Cursor i will read the keys in (key[i - 1], key[i]].
+     */
+    cn_scan_bounds(kvs_cn(kk->kk_ikvs), cursormax, keyv, klenv, &keyc);
+
+    /* All the cursors share one view, which is held until they all have
+     * refs on the kvsets they need.
+     */
+    vseq = HSE_SQNREF_UNDEFINED;
+
+    if (txn) {
+        ctxn = kvdb_ctxn_h2h(txn);
+        err = kvdb_ctxn_get_view_seqno(ctxn, &vseq);
+    } else {
+        err = viewset_insert(kk->kk_viewset, &vseq, &tseqno, &cookie);
+    }
+
+    if (ev(err))
+        goto out;
+
+    for (n = 0; n <= keyc; n++) {
+        const void *min = NULL, *max = NULL;
+        uint minlen = 0, maxlen = 0;
+
+        err = cursor_create(kk, flags, ctxn, NULL, 0, vseq, &cursorv[n]);
+        if (ev(err))
+            break;
+
+        if (n > 0) {
+            min = keyv + (n - 1) * HSE_KVS_KEY_LEN_MAX;
+            minlen = klenv[n - 1];
+
+            if (!key_successor((void *)min, &minlen)) {
+                ikvdb_kvs_cursor_destroy(cursorv[n]);
+                break;
+            }
+        }
+
+        if (n < keyc) {
+            max = keyv + n * HSE_KVS_KEY_LEN_MAX;
+            maxlen = klenv[n];
+        }
+
+        if (!min && !max)
+            continue;
+
+        err = kvs_cursor_seek(cursorv[n], min, minlen, max, maxlen, NULL);
+        if (ev(err)) {
+            ikvdb_kvs_cursor_destroy(cursorv[n]);
+            break;
+        }
+    }
+
+    if (cookie) {
+        u64 minview;
+        u32 minchg;
+
+        viewset_remove(kk->kk_viewset, cookie, &minchg, &minview);
+
+        if (!err)
+            kvdb_ctxn_set_wait_commits(ikvdb->ikdb_ctxn_set, tseqno);
+    }
+
+    if (err) {
+        while (n-- > 0)
+            ikvdb_kvs_cursor_destroy(cursorv[n]);
+    } else {
+        *cursorc = n;
+    }
+
+out:
+    free(keyv);
+
+    return err;
+}
+
 merr_t
 ikvdb_kvs_cursor_update_view(struct hse_kvs_cursor *cur, unsigned int flags)
 {
@@ -3053,6 +3544,95 @@ ikvdb_kvs_cursor_read_copy(
     return 0;
 }
 
+merr_t
+ikvdb_kvs_cursor_read_batch(
+    struct hse_kvs_cursor      *cur,
+    unsigned int                flags,
+    void                       *buf,
+    size_t                      buf_sz,
+    size_t                      val_len_max,
+    struct hse_kvs_cursor_pair *pairv,
+    size_t                      pairmax,
+    size_t                     *pairc,
+    bool                       *eof)
+{
+    const bool key_only = flags & HSE_CURSOR_READ_KEY_ONLY;
+    char      *bufp = buf;
+    size_t     n = 0;
+    merr_t     err = 0;
+    u64        tstart;
+
+    tstart = perfc_lat_start(cur->kc_pkvsl_pc);
+
+    *pairc = 0;
+    *eof = false;
+
+    if (ev(cur->kc_err))
+        return cur->kc_err;
+
+    if (cur->kc_bind) {
+        cur->kc_err = cursor_refresh(cur);
+        if (ev(cur->kc_err))
+            return cur->kc_err;
+    }
+
+    while (n < pairmax) {
+        struct hse_kvs_cursor_pair *pair = pairv + n;
+        size_t avail = buf_sz - (bufp - (char *)buf);
+        size_t klen, vlen, vcopy = 0;
+
+        err = kvs_cursor_read(cur, 0, eof);
+        if (ev(err) || *eof)
+            break;
+
+        /* The key and value are copied straight into the caller's buffer,
+         * and if they turn out not to fit the cursor is rewound so that the
+         * next read returns them.
+         */
+        kvs_cursor_key_copy(cur, bufp, avail, NULL, &klen);
+
+        if (klen <= avail) {
+            if (key_only) {
+                err = kvs_cursor_val_copy(cur, NULL, 0, NULL, &vlen);
+            } else {
+                vcopy = min_t(size_t, avail - klen, val_len_max);
+                err = kvs_cursor_val_copy(cur, bufp + klen, vcopy, NULL, &vlen);
+                vcopy = min_t(size_t, vlen, val_len_max);
+            }
+            if (ev(err))
+                break;
+        }
+
+        if (klen + vcopy > avail) {
+            kvs_cursor_unread(cur);
+            if (n == 0)
+                err = merr(ENOSPC);
+            break;
+        }
+
+        pair->key = bufp;
+        pair->key_len = klen;
+        pair->val = key_only ? NULL : bufp + klen;
+        pair->val_len = vlen;
+
+        bufp += klen + vcopy;
+        n++;
+    }
+
+    *pairc = n;
+
+    if (err)
+        return err;
+
+    perfc_lat_record(
+        cur->kc_pkvsl_pc,
+        cur->kc_flags & HSE_CURSOR_CREATE_REV ? PERFC_LT_PKVSL_KVS_CURSOR_READREV
+                                                : PERFC_LT_PKVSL_KVS_CURSOR_READFWD,
+        tstart);
+
+    return 0;
+}
+
 merr_t
 ikvdb_kvs_cursor_destroy(struct hse_kvs_cursor *cur)
 {
@@ -3446,6 +4026,35 @@ ikvdb_wal_replay_prefix_del(
     return err;
 }
 
+merr_t
+ikvdb_wal_replay_range_del(
+    struct ikvdb         *ikvdb,
+    struct ikvdb_kvs_hdl *ikvsh,
+    u64                   cnid,
+    u64                   seqno,
+    struct kvs_ktuple    *kt,
+    struct kvs_vtuple    *vt)
+{
+    struct kvs_ktuple end;
+    struct kvdb_kvs *kk;
+    merr_t err;
+
+    assert(ikvdb && ikvsh);
+
+    kk = ikvdb_wal_replay_kvs_get(ikvsh, cnid);
+    if (ev(!kk))
+        return 0; /* Possible that the kvs is dropped just prior to crash */
+
+    /* The end key of the range is logged as the record's value. */
+    kvs_ktuple_init_nohash(&end, vt->vt_data, kvs_vtuple_vlen(vt));
+
+    err = kvs_range_del(kk->kk_ikvs, kt, &end, HSE_ORDNL_TO_SQNREF(seqno));
+    if (!err)
+        ikvdb_wal_replay_seqno_set(ikvdb, seqno);
+
+    return err;
+}
+
 void
 ikvdb_wal_replay_seqno_set(struct ikvdb *ikvdb, uint64_t seqno)
 {
@@ -3562,11 +4171,13 @@ kvdb_perfc_initialize(void)
     kvs_perfc_init();
     c0sk_perfc_init();
     cn_perfc_init();
+    wal_perfc_init();
 }
 
 static void
 kvdb_perfc_finish(void)
 {
+    wal_perfc_fini();
     cn_perfc_fini();
     c0sk_perfc_fini();
     kvs_perfc_fini();
@@ -840,22 +840,10 @@ kvdb_ctxn_trylock_read(struct kvdb_ctxn *handle, uintptr_t *seqref, u64 *view_se
     return 0;
 }
 
-merr_t
-kvdb_ctxn_trylock_write(
-    struct kvdb_ctxn *handle,
-    uintptr_t *       seqref,
-    u64 *             view_seqno,
-    int64_t          *cookie,
-    bool              is_ptomb,
-    u64               pfxhash,
-    u64               hash)
+static merr_t
+kvdb_ctxn_trylock_write_impl(struct kvdb_ctxn_impl *ctxn)
 {
-    struct kvdb_ctxn_impl *ctxn;
-    merr_t                 err;
-
-    assert(handle);
-
-    ctxn = kvdb_ctxn_h2r(handle);
+    merr_t err;
 
     err = kvdb_ctxn_trylock_impl(ctxn);
     if (err)
@@ -863,21 +851,28 @@ kvdb_ctxn_trylock_write(
 
     if (HSE_UNLIKELY(!ctxn->ctxn_can_insert)) {
         err = wal_txn_begin(ctxn->ctxn_wal, ctxn->ctxn_view_seqno, &ctxn->ctxn_wal_cookie);
-        if (err)
-            goto errout;
+        if (!err)
+            err = kvdb_ctxn_enable_inserts(ctxn);
 
-        err = kvdb_ctxn_enable_inserts(ctxn);
         if (err)
-            goto errout;
+            kvdb_ctxn_unlock_impl(ctxn);
     }
 
+    return err;
+}
+
+static merr_t
+kvdb_ctxn_write_lock(struct kvdb_ctxn_impl *ctxn, bool is_ptomb, u64 pfxhash, u64 hash)
+{
+    merr_t err;
+
     if (pfxhash) {
         struct kvdb_ctxn_pfxlock *pl = ctxn->ctxn_pfxlock_handle;
 
         err = is_ptomb ? kvdb_ctxn_pfxlock_excl(pl, pfxhash) :
                          kvdb_ctxn_pfxlock_shared(pl, pfxhash);
         if (err)
-            goto errout;
+            return err;
     }
 
     if (HSE_LIKELY(!is_ptomb)) {
@@ -885,7 +880,37 @@ kvdb_ctxn_trylock_write(
             ctxn->ctxn_kvdb_keylock, ctxn->ctxn_locks_handle, hash, ctxn->ctxn_view_seqno);
 
         if (err)
-            goto errout;
+            return err;
+    }
+
+    return 0;
+}
+
+merr_t
+kvdb_ctxn_trylock_write(
+    struct kvdb_ctxn *handle,
+    uintptr_t *       seqref,
+    u64 *             view_seqno,
+    int64_t          *cookie,
+    bool              is_ptomb,
+    u64               pfxhash,
+    u64               hash)
+{
+    struct kvdb_ctxn_impl *ctxn;
+    merr_t                 err;
+
+    assert(handle);
+
+    ctxn = kvdb_ctxn_h2r(handle);
+
+    err = kvdb_ctxn_trylock_write_impl(ctxn);
+    if (err)
+        return err;
+
+    err = kvdb_ctxn_write_lock(ctxn, is_ptomb, pfxhash, hash);
+    if (err) {
+        kvdb_ctxn_unlock_impl(ctxn);
+        return err;
     }
 
     if (ctxn->ctxn_bind)
@@ -895,11 +920,51 @@ kvdb_ctxn_trylock_write(
     *seqref = ctxn->ctxn_seqref;
     *cookie = ctxn->ctxn_wal_cookie;
 
-  errout:
+    return 0;
+}
+
+merr_t
+kvdb_ctxn_trylock_write_batch(
+    struct kvdb_ctxn *handle,
+    uintptr_t *       seqref,
+    u64 *             view_seqno,
+    int64_t          *cookie,
+    uint              cnt,
+    const bool *      is_ptombv,
+    const u64 *       pfxhashv,
+    const u64 *       hashv)
+{
+    struct kvdb_ctxn_impl *ctxn;
+    merr_t                 err;
+    uint                   i;
+
+    assert(handle);
+
+    ctxn = kvdb_ctxn_h2r(handle);
+
+    err = kvdb_ctxn_trylock_write_impl(ctxn);
     if (err)
-        kvdb_ctxn_unlock_impl(ctxn);
+        return err;
 
-    return err;
+    /* Write locks acquired before a collision is detected remain held
+     * by the txn until it commits or aborts, same as for a failed put.
+     */
+    for (i = 0; i < cnt; ++i) {
+        err = kvdb_ctxn_write_lock(ctxn, is_ptombv[i], pfxhashv[i], hashv[i]);
+        if (err) {
+            kvdb_ctxn_unlock_impl(ctxn);
+            return err;
+        }
+    }
+
+    if (ctxn->ctxn_bind)
+        kvdb_ctxn_bind_invalidate(ctxn->ctxn_bind);
+
+    *view_seqno = ctxn->ctxn_view_seqno;
+    *seqref = ctxn->ctxn_seqref;
+    *cookie = ctxn->ctxn_wal_cookie;
+
+    return 0;
 }
 
 void
@@ -426,6 +426,78 @@ dur_mclass_jsonify(const struct param_spec *const ps, const void *const value)
     return cJSON_CreateString(name);
 }
 
+static bool HSE_NONNULL(1, 2, 3)
+io_backend_converter(
+    const struct param_spec *const ps,
+    const cJSON *const             node,
+    void *const                    data)
+{
+    INVARIANT(ps);
+    INVARIANT(node);
+    INVARIANT(data);
+
+    if (!cJSON_IsString(node))
+        return false;
+
+    const char *value = cJSON_GetStringValue(node);
+
+    if (!strcmp(value, "sync")) {
+        *(uint8_t *)data = MPOOL_IO_SYNC;
+    } else if (!strcmp(value, "io_uring")) {
+        *(uint8_t *)data = MPOOL_IO_URING;
+    } else {
+        log_err("Invalid value: %s, must be one of sync or io_uring", value);
+        return false;
+    }
+
+    return true;
+}
+
+static const char *
+io_backend_name(uint8_t backend)
+{
+    switch (backend) {
+    case MPOOL_IO_SYNC:
+        return "sync";
+    case MPOOL_IO_URING:
+        return "io_uring";
+    default:
+        abort();
+    }
+}
+
+static merr_t
+io_backend_stringify(
+    const struct param_spec *const ps,
+    const void *const              value,
+    char *const                    buf,
+    const size_t                   buf_sz,
+    size_t *const                  needed_sz)
+{
+    int n;
+
+    INVARIANT(ps);
+    INVARIANT(value);
+
+    n = snprintf(buf, buf_sz, "\"%s\"", io_backend_name(*(const uint8_t *)value));
+    if (n < 0)
+        return merr(EBADMSG);
+
+    if (needed_sz)
+        *needed_sz = n;
+
+    return 0;
+}
+
+static cJSON * HSE_NONNULL(1, 2)
+io_backend_jsonify(const struct param_spec *const ps, const void *const value)
+{
+    INVARIANT(ps);
+    INVARIANT(value);
+
+    return cJSON_CreateString(io_backend_name(*(const uint8_t *)value));
+}
+
 static bool HSE_NONNULL(1, 2, 3)
 throttle_init_policy_converter(
     const struct param_spec *const ps,
@@ -609,6 +681,21 @@ static const struct param_spec pspecs[] = {
             .as_uscalar = false,
         },
     },
+    {
+        .ps_name = "c0_concurrent",
+        .ps_description = "index c0 kvsets with a concurrent skiplist",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_BOOL,
+        .ps_offset = offsetof(struct kvdb_rparams, c0_concurrent),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, c0_concurrent),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = false,
+        },
+    },
     {
         .ps_name = "c0_ingest_width",
         .ps_description = "set c0 kvms width",
@@ -861,6 +948,27 @@ static const struct param_spec pspecs[] = {
             },
         },
     },
+    {
+        .ps_name = "csched_subcomp_max",
+        .ps_description = "max parallel key ranges per kv-compaction",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL | PARAM_FLAG_WRITABLE,
+        .ps_type = PARAM_TYPE_U8,
+        .ps_offset = offsetof(struct kvdb_rparams, csched_subcomp_max),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, csched_subcomp_max),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = 4,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = 1,
+                .ps_max = 8,
+            },
+        },
+    },
     {
         .ps_name = "csched_qthreads",
         .ps_description = "csched queue threads",
@@ -1002,6 +1110,63 @@ static const struct param_spec pspecs[] = {
             },
         },
     },
+    {
+        .ps_name = "durability.files.recycle_max",
+        .ps_description = "Max number of reclaimed WAL files kept for reuse (0 disables reuse)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvdb_rparams, dur_file_recycle_max),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, dur_file_recycle_max),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = 0,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = 0,
+                .ps_max = HSE_WAL_FILE_RECYCLE_MAX,
+            },
+        },
+    },
+    {
+        .ps_name = "durability.group_commit.enabled",
+        .ps_description = "Coalesce concurrent syncs into one flush per WAL buffer",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_BOOL,
+        .ps_offset = offsetof(struct kvdb_rparams, dur_gc_enable),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, dur_gc_enable),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_bool = false,
+        },
+    },
+    {
+        .ps_name = "durability.group_commit.delay_max_us",
+        .ps_description = "Max time a group commit waits for more syncs (us)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvdb_rparams, dur_gc_delay_max_us),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, dur_gc_delay_max_us),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = HSE_WAL_GC_DELAY_US_DFLT,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = HSE_WAL_GC_DELAY_US_MIN,
+                .ps_max = HSE_WAL_GC_DELAY_US_MAX,
+            },
+        },
+    },
     {
         .ps_name = "durability.replay.force",
         .ps_description = "Force WAL to attempt a best-effort recovery with potential data loss",
@@ -1341,6 +1506,27 @@ static const struct param_spec pspecs[] = {
             },
         },
     },
+    {
+        .ps_name = "c0_build_threads",
+        .ps_description = "max number of threads building kvsets for c0 ingests",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvdb_rparams, c0_build_threads),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, c0_build_threads),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = HSE_C0_BUILD_THREADS_DFLT,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = HSE_C0_BUILD_THREADS_MIN,
+                .ps_max = HSE_C0_BUILD_THREADS_MAX,
+            },
+        },
+    },
     {
         .ps_name = "cn_maint_threads",
         .ps_description = "max number of cn maintenance threads",
@@ -1469,6 +1655,90 @@ static const struct param_spec pspecs[] = {
             .as_uscalar = true,
         },
     },
+    {
+        .ps_name = "storage.capacity.io_backend",
+        .ps_description = "I/O backend (sync or io_uring) for capacity mclass data",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U8,
+        .ps_offset = offsetof(struct kvdb_rparams, io_backend[HSE_MCLASS_CAPACITY]),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, io_backend[HSE_MCLASS_CAPACITY]),
+        .ps_convert = io_backend_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = io_backend_stringify,
+        .ps_jsonify = io_backend_jsonify,
+        .ps_default_value = {
+            .as_uscalar = MPOOL_IO_SYNC,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = MPOOL_IO_SYNC,
+                .ps_max = MPOOL_IO_BACKEND_MAX,
+            },
+        },
+    },
+    {
+        .ps_name = "storage.staging.io_backend",
+        .ps_description = "I/O backend (sync or io_uring) for staging mclass data",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U8,
+        .ps_offset = offsetof(struct kvdb_rparams, io_backend[HSE_MCLASS_STAGING]),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, io_backend[HSE_MCLASS_STAGING]),
+        .ps_convert = io_backend_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = io_backend_stringify,
+        .ps_jsonify = io_backend_jsonify,
+        .ps_default_value = {
+            .as_uscalar = MPOOL_IO_SYNC,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = MPOOL_IO_SYNC,
+                .ps_max = MPOOL_IO_BACKEND_MAX,
+            },
+        },
+    },
+    {
+        .ps_name = "storage.pmem.io_backend",
+        .ps_description = "I/O backend (sync or io_uring) for pmem mclass data",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U8,
+        .ps_offset = offsetof(struct kvdb_rparams, io_backend[HSE_MCLASS_PMEM]),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, io_backend[HSE_MCLASS_PMEM]),
+        .ps_convert = io_backend_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = io_backend_stringify,
+        .ps_jsonify = io_backend_jsonify,
+        .ps_default_value = {
+            .as_uscalar = MPOOL_IO_SYNC,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = MPOOL_IO_SYNC,
+                .ps_max = MPOOL_IO_BACKEND_MAX,
+            },
+        },
+    },
+    {
+        .ps_name = "storage.bcache.size",
+        .ps_description = "size in MiB of the cn block cache (0 disables the cache)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvdb_rparams, bcache_size_mb),
+        .ps_size = PARAM_SZ(struct kvdb_rparams, bcache_size_mb),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = 0,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = 0,
+                .ps_max = 1024 * 1024,
+            },
+        },
+    },
 };
 
 const struct param_spec *
@@ -7,6 +7,7 @@
  * Exported API of the HSE struct ikvs
  */
 
+#include <hse/experimental.h>
 #include <hse/kvdb_perfc.h>
 
 #include <hse_util/assert.h>
@@ -19,12 +20,15 @@
 #include <hse_util/byteorder.h>
 #include <hse_util/slab.h>
 #include <hse_util/table.h>
+#include <hse_util/keycmp.h>
+#include <hse_util/vlb.h>
 #include <hse/logging/logging.h>
 
 #include <hse_ikvdb/c0.h>
 #include <hse_ikvdb/lc.h>
 #include <hse_ikvdb/cn.h>
 #include <hse_ikvdb/kvs.h>
+#include <hse_ikvdb/kvs_merge.h>
 #include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/key_hash.h>
 #include <hse_ikvdb/kvdb_ctxn.h>
@@ -56,6 +60,9 @@ struct perfc_name kvs_pkvsl_perfc_op[] _dt_section = {
     NE(PERFC_LT_PKVSL_KVS_DEL,            5, "kvs_delete latency",         "kvs_del_lat", 7),
     NE(PERFC_LT_PKVSL_KVS_PFX_PROBE,      5, "kvs_prefix_probe latency",   "kvs_pfx_probe_lat", 7),
     NE(PERFC_LT_PKVSL_KVS_PFX_DEL,        5, "kvs_prefix_delete latency",  "kvs_pfx_del_lat", 7),
+    NE(PERFC_LT_PKVSL_KVS_RANGE_DEL,      5, "kvs_range_delete latency",   "kvs_range_del_lat", 7),
+    NE(PERFC_LT_PKVSL_KVS_GET_MULTI,      5, "kvs_get_multi latency",      "kvs_get_multi_lat", 7),
+    NE(PERFC_LT_PKVSL_KVS_WRITE_BATCH,    5, "kvs_write_batch latency",    "kvs_wbatch_lat", 7),
 };
 
 /* clang-format on */
@@ -348,6 +355,150 @@ kvs_put(
     return err;
 }
 
+/**
+ * kvs_get_view() - look up a key in c0, lc and cn
+ * @seqno_max: upper bound on the view seqno (e.g., to find the values
+ *             older than a given merge operand)
+ */
+static merr_t
+kvs_get_view(
+    struct ikvs *        kvs,
+    struct kvdb_ctxn *   ctxn,
+    struct kvs_ktuple *  kt,
+    u64                  seqno,
+    u64                  seqno_max,
+    enum key_lookup_res *res,
+    struct kvs_buf *     vbuf)
+{
+    struct c0 *c0 = kvs->ikv_c0;
+    uintptr_t  seqnoref = 0;
+    merr_t     err;
+
+    /* Exclusively lock txn for query.
+     * seqnoref is invalid ater lock is released.
+     */
+    if (ctxn) {
+        err = kvdb_ctxn_trylock_read(ctxn, &seqnoref, &seqno);
+        if (err)
+            return err;
+    }
+
+    seqno = min_t(u64, seqno, seqno_max);
+
+    err = c0_get(c0, kt, seqno, seqnoref, res, vbuf);
+
+    if (!err && *res == NOT_FOUND)
+        err = lc_get(kvs->ikv_lc, c0_index(c0), kvs->ikv_pfx_len, kt, seqno, seqnoref, res, vbuf);
+
+    if (ctxn)
+        kvdb_ctxn_unlock(ctxn);
+
+    if (!err && *res == NOT_FOUND)
+        err = cn_get(kvs->ikv_cn, kt, seqno, res, vbuf);
+
+    return err;
+}
+
+static void
+kvs_buf_copy(struct kvs_buf *vbuf, const void *data, uint len)
+{
+    vbuf->b_len = len;
+
+    if (vbuf->b_buf)
+        memcpy(vbuf->b_buf, data, min_t(uint, len, vbuf->b_buf_sz));
+}
+
+merr_t
+kvs_get_merge(
+    struct ikvs *              kvs,
+    struct hse_kvdb_txn *const txn,
+    struct kvs_ktuple *        kt,
+    u64                        seqno,
+    const void *               opnd,
+    uint                       opndlen,
+    u64                        opndseq,
+    enum key_lookup_res *      res,
+    struct kvs_buf *           vbuf)
+{
+    struct kvdb_ctxn *ctxn = txn ? kvdb_ctxn_h2h(txn) : 0;
+    struct kvs_merge  km;
+    struct kvs_buf    fbuf;
+    struct key_obj    kobj;
+    u64               fseq;
+    merr_t            err;
+
+    err = kvs_merge_init(&km);
+    if (ev(err))
+        return err;
+
+    kvs_buf_init(&fbuf, vlb_alloc(HSE_KVS_VALUE_LEN_MAX), HSE_KVS_VALUE_LEN_MAX);
+    if (ev(!fbuf.b_buf)) {
+        kvs_merge_fini(&km);
+        return merr(ENOMEM);
+    }
+
+    key2kobj(&kobj, kt->kt_data, kt->kt_len);
+
+    /* If the caller couldn't supply the operand (e.g., its buffer was too
+     * small) then start by fetching it.
+     */
+    if (opnd) {
+        kvs_merge_start(&km, cn_get_merge_op(kvs->ikv_cn), &kobj, opnd, opndlen, opndseq);
+        fseq = opndseq - 1;
+    } else {
+        fseq = opndseq;
+    }
+
+    /* Walk back through the older versions of the key, folding operands
+     * until a value, tombstone or the end of the key's history is found.
+     */
+    while (1) {
+        err = kvs_get_view(kvs, ctxn, kt, seqno, fseq, res, &fbuf);
+        if (ev(err))
+            break;
+
+        if (*res == FOUND_MRG) {
+            if (!km.km_active)
+                kvs_merge_start(&km, cn_get_merge_op(kvs->ikv_cn), &kobj,
+                                fbuf.b_buf, fbuf.b_len, kt->kt_seqno);
+            else
+                err = kvs_merge_fold(&km, fbuf.b_buf, fbuf.b_len, HSE_KVS_VALUE_LEN_MAX);
+
+            if (err || kt->kt_seqno == 0)
+                break;
+
+            fseq = kt->kt_seqno - 1;
+            continue;
+        }
+
+        /* The operand was resolved by compaction in the meantime.
+         */
+        if (!km.km_active) {
+            kvs_buf_copy(vbuf, fbuf.b_buf, fbuf.b_len);
+            goto out;
+        }
+
+        break;
+    }
+
+    if (!err && km.km_opnd) {
+        const void *base = (*res == FOUND_VAL) ? fbuf.b_buf : NULL;
+
+        err = kvs_merge_resolve(&km, base, fbuf.b_len, HSE_KVS_VALUE_LEN_MAX);
+    }
+
+    if (!err) {
+        kvs_buf_copy(vbuf, km.km_buf, km.km_len);
+        *res = FOUND_VAL;
+    }
+
+out:
+    vlb_free(fbuf.b_buf, HSE_KVS_VALUE_LEN_MAX);
+    kvs_merge_fini(&km);
+
+    return err;
+}
+
 merr_t
 kvs_get(
     struct ikvs *              kvs,
@@ -359,10 +510,6 @@ kvs_get(
 {
     struct kvdb_ctxn *ctxn = txn ? kvdb_ctxn_h2h(txn) : 0;
     struct perfc_set *pkvsl_pc = kvs_perfc_pkvsl(kvs);
-    struct c0 *       c0 = kvs->ikv_c0;
-    struct lc *       lc = kvs->ikv_lc;
-    struct cn *       cn = kvs->ikv_cn;
-    uintptr_t         seqnoref = 0;
     size_t            hashlen;
     u64               tstart;
     merr_t            err;
@@ -372,27 +519,130 @@ kvs_get(
     hashlen = kt->kt_len - kvs->ikv_sfx_len;
     kt->kt_hash = key_hash64(kt->kt_data, hashlen);
 
-    /* Exclusively lock txn for query.
-     * seqnoref is invalid ater lock is released.
+    err = kvs_get_view(kvs, ctxn, kt, seqno, U64_MAX, res, vbuf);
+
+    /* Resolve a merge operand by applying it to the older versions
+     * of the key.  Reuse the operand if it fit in the caller's buffer.
+     */
+    if (!err && *res == FOUND_MRG) {
+        const bool whole = vbuf->b_buf && vbuf->b_len <= vbuf->b_buf_sz;
+
+        err = kvs_get_merge(kvs, txn, kt, seqno, whole ? vbuf->b_buf : NULL, vbuf->b_len,
+                            kt->kt_seqno, res, vbuf);
+    }
+
+    perfc_lat_record(pkvsl_pc, PERFC_LT_PKVSL_KVS_GET, tstart);
+
+    return err;
+}
+
+static int
+kvs_ktuple_ptr_cmp(const void *lhs, const void *rhs)
+{
+    const struct kvs_ktuple *kt1 = *(const struct kvs_ktuple *const *)lhs;
+    const struct kvs_ktuple *kt2 = *(const struct kvs_ktuple *const *)rhs;
+
+    return keycmp(kt1->kt_data, kt1->kt_len, kt2->kt_data, kt2->kt_len);
+}
+
+/**
+ * kvs_get_multi() - batched point lookup
+ *
+ * The batch is sorted once by key so that c0/lc are probed in key order and
+ * so that cn can traverse each tree node once per run of keys that route to
+ * it.  Keys not resolved by c0/lc are handed to cn in a single call.
+ */
+merr_t
+kvs_get_multi(
+    struct ikvs *              kvs,
+    struct hse_kvdb_txn *const txn,
+    uint                       cnt,
+    struct kvs_ktuple *        ktv,
+    u64                        seqno,
+    enum key_lookup_res *      resv,
+    struct kvs_buf *           vbufv)
+{
+    struct kvdb_ctxn *ctxn = txn ? kvdb_ctxn_h2h(txn) : 0;
+    struct perfc_set *pkvsl_pc = kvs_perfc_pkvsl(kvs);
+    struct kvs_ktuple **sortv;
+    uint              *idxv;
+    struct c0 *       c0 = kvs->ikv_c0;
+    struct lc *       lc = kvs->ikv_lc;
+    struct cn *       cn = kvs->ikv_cn;
+    uintptr_t         seqnoref = 0;
+    uint              idxc, i;
+    u64               tstart;
+    merr_t            err = 0;
+
+    assert(cnt > 0 && cnt <= HSE_KVS_GET_MULTI_MAX);
+
+    sortv = malloc(cnt * (sizeof(*sortv) + sizeof(*idxv)));
+    if (ev(!sortv))
+        return merr(ENOMEM);
+
+    idxv = (uint *)(sortv + cnt);
+
+    tstart = perfc_lat_start(pkvsl_pc);
+
+    for (i = 0; i < cnt; i++) {
+        struct kvs_ktuple *kt = ktv + i;
+
+        kt->kt_hash = key_hash64(kt->kt_data, kt->kt_len - kvs->ikv_sfx_len);
+        resv[i] = NOT_FOUND;
+        sortv[i] = kt;
+    }
+
+    if (cnt > 1)
+        qsort(sortv, cnt, sizeof(*sortv), kvs_ktuple_ptr_cmp);
+
+    /* Exclusively lock txn for the duration of the c0/lc queries.
+     * seqnoref is invalid after lock is released.
      */
     if (ctxn) {
         err = kvdb_ctxn_trylock_read(ctxn, &seqnoref, &seqno);
-        if (err)
+        if (err) {
+            free(sortv);
             return err;
+        }
     }
 
-    err = c0_get(c0, kt, seqno, seqnoref, res, vbuf);
+    for (i = idxc = 0; i < cnt; i++) {
+        uint idx = sortv[i] - ktv;
 
-    if (!err && *res == NOT_FOUND)
-        err = lc_get(lc, c0_index(c0), kvs->ikv_pfx_len, kt, seqno, seqnoref, res, vbuf);
+        err = c0_get(c0, ktv + idx, seqno, seqnoref, resv + idx, vbufv + idx);
+
+        if (!err && resv[idx] == NOT_FOUND)
+            err = lc_get(lc, c0_index(c0), kvs->ikv_pfx_len, ktv + idx, seqno, seqnoref,
+                         resv + idx, vbufv + idx);
+        if (err)
+            break;
+
+        if (resv[idx] == NOT_FOUND)
+            idxv[idxc++] = idx;
+    }
 
     if (ctxn)
         kvdb_ctxn_unlock(ctxn);
 
-    if (!err && *res == NOT_FOUND)
-        err = cn_get(cn, kt, seqno, res, vbuf);
+    if (!err && idxc > 0)
+        err = cn_get_multi(cn, ktv, seqno, resv, vbufv, idxv, idxc);
 
-    perfc_lat_record(pkvsl_pc, PERFC_LT_PKVSL_KVS_GET, tstart);
+    free(sortv);
+
+    for (i = 0; i < cnt && !err; i++) {
+        struct kvs_buf *vbuf = vbufv + i;
+        bool whole;
+
+        if (resv[i] != FOUND_MRG)
+            continue;
+
+        whole = vbuf->b_buf && vbuf->b_len <= vbuf->b_buf_sz;
+
+        err = kvs_get_merge(kvs, txn, ktv + i, seqno, whole ? vbuf->b_buf : NULL, vbuf->b_len,
+                            ktv[i].kt_seqno, resv + i, vbuf);
+    }
+
+    perfc_lat_record(pkvsl_pc, PERFC_LT_PKVSL_KVS_GET_MULTI, tstart);
 
     return err;
 }
@@ -515,6 +765,132 @@ kvs_prefix_del(
     return ev(err);
 }
 
+merr_t
+kvs_range_del(struct ikvs *kvs, struct kvs_ktuple *start, struct kvs_ktuple *end, uintptr_t seqnoref)
+{
+    struct perfc_set *pkvsl_pc = kvs_perfc_pkvsl(kvs);
+    struct wal_record rec;
+    u64               tstart;
+    merr_t            err;
+
+    tstart = perfc_lat_start(pkvsl_pc);
+
+    rec.cookie = -1;
+
+    err = wal_del_range(kvs->ikv_wal, kvs, start, end, 0, &rec);
+    if (!err) {
+        err = c0_range_del(kvs->ikv_c0, start, end, seqnoref);
+
+        wal_op_finish(kvs->ikv_wal, &rec, start->kt_seqno, start->kt_dgen, merr_errno(err));
+    }
+
+    perfc_lat_record(pkvsl_pc, PERFC_LT_PKVSL_KVS_RANGE_DEL, tstart);
+
+    return ev(err);
+}
+
+merr_t
+kvs_write_batch(
+    struct hse_kvdb_txn *const txn,
+    uint                       opc,
+    struct kvs_batch_op *      opv,
+    uintptr_t                  seqnoref)
+{
+    struct kvdb_ctxn *ctxn = txn ? kvdb_ctxn_h2h(txn) : 0;
+    struct ikvs *     kvs0 = opv[0].kbo_kvs;
+    struct perfc_set *pkvsl_pc = kvs_perfc_pkvsl(kvs0);
+    struct wal_record rec;
+    u64               tstart;
+    u64               seqno, dgen;
+    merr_t            err;
+    uint              i;
+
+    tstart = perfc_lat_start(pkvsl_pc);
+
+    for (i = 0; i < opc; i++) {
+        struct ikvs       *kvs = opv[i].kbo_kvs;
+        struct kvs_ktuple *kt = &opv[i].kbo_kt;
+        size_t             sfx_len = kvs->ikv_sfx_len;
+
+        opv[i].kbo_skidx = c0_index(kvs->ikv_c0);
+
+        if (opv[i].kbo_op == KVS_BATCH_PDEL) {
+            kt->kt_hash = key_hash64(kt->kt_data, kt->kt_len);
+            continue;
+        }
+
+        /* See kvs_put() */
+        if (HSE_UNLIKELY(sfx_len && kt->kt_len < sfx_len + kvs->ikv_pfx_len))
+            return merr(EINVAL);
+
+        kt->kt_hash = key_hash64(kt->kt_data, kt->kt_len - sfx_len);
+    }
+
+    seqno = 0;
+    rec.cookie = -1;
+
+    /* Exclusively lock txn once for the entire batch and acquire the write
+     * locks for all keys (see kvs_put() and kvs_prefix_del()).
+     */
+    if (ctxn) {
+        u64  *hashv, *pfxhashv;
+        bool *is_ptombv;
+
+        hashv = malloc(opc * (2 * sizeof(*hashv) + sizeof(*is_ptombv)));
+        if (ev(!hashv))
+            return merr(ENOMEM);
+
+        pfxhashv = hashv + opc;
+        is_ptombv = (bool *)(pfxhashv + opc);
+
+        for (i = 0; i < opc; i++) {
+            struct ikvs       *kvs = opv[i].kbo_kvs;
+            struct kvs_ktuple *kt = &opv[i].kbo_kt;
+
+            is_ptombv[i] = (opv[i].kbo_op == KVS_BATCH_PDEL);
+            hashv[i] = is_ptombv[i] ? 0 : kt->kt_hash ^ kvs->ikv_gen;
+            pfxhashv[i] = 0;
+
+            if (!is_ptombv[i] && kvs->ikv_sfx_len > 0)
+                hashv[i] = key_hash64_seed(kt->kt_data, kt->kt_len, kvs->ikv_gen);
+
+            if (kvs->ikv_pfx_len && kt->kt_len >= kvs->ikv_pfx_len)
+                pfxhashv[i] = key_hash64_seed(kt->kt_data, kvs->ikv_pfx_len, kvs->ikv_gen);
+        }
+
+        err = kvdb_ctxn_trylock_write_batch(
+            ctxn, &seqnoref, &seqno, &rec.cookie, opc, is_ptombv, pfxhashv, hashv);
+        free(hashv);
+        if (err)
+            return err;
+    }
+
+    err = wal_batch(kvs0->ikv_wal, opc, opv, seqno, &rec);
+
+    if (HSE_LIKELY(!err)) {
+        err = c0_put_batch(kvs0->ikv_c0, opc, opv, seqnoref);
+
+        /* The batch is logged as a single record, hence it must carry the
+         * highest seqno and gen of all its ops.  Otherwise, replay could
+         * skip the record after a partial ingest of the batch.  The seqno
+         * of each non-txn op is logged along with the op.
+         */
+        for (i = seqno = dgen = 0; i < opc && !err; i++) {
+            seqno = max_t(u64, seqno, opv[i].kbo_kt.kt_seqno);
+            dgen = max_t(u64, dgen, opv[i].kbo_kt.kt_dgen);
+        }
+
+        wal_batch_finish(kvs0->ikv_wal, &rec, opc, opv, seqno, dgen, merr_errno(err));
+    }
+
+    if (ctxn)
+        kvdb_ctxn_unlock(ctxn);
+
+    perfc_lat_record(pkvsl_pc, PERFC_LT_PKVSL_KVS_WRITE_BATCH, tstart);
+
+    return err;
+}
+
 merr_t
 kvs_pfx_probe(
     struct ikvs *              kvs,
@@ -547,6 +923,7 @@ kvs_pfx_probe(
 
     qctx.pos = qctx.ntombs = qctx.seen = 0;
     qctx.tomb_tree = RB_ROOT;
+    memset(&qctx.rtombs, 0, sizeof(qctx.rtombs));
 
     if (!kt->kt_hash)
         kt->kt_hash = key_hash64(kt->kt_data, kt->kt_len);
@@ -579,6 +956,8 @@ exit:
     if (ctxn)
         kvdb_ctxn_unlock(ctxn);
 
+    kvs_rtomb_vec_fini(&qctx.rtombs);
+
     if (ev(err))
         return err;
 
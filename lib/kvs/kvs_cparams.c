@@ -75,7 +75,28 @@ static const struct param_spec pspecs[] = {
                 .ps_max = UINT32_MAX,
             }
         }
-    }
+    },
+    {
+        .ps_name = "value.inline_length",
+        .ps_description = "Max on-media value length stored inline with its key",
+        .ps_flags = 0,
+        .ps_type = PARAM_TYPE_U32,
+        .ps_offset = offsetof(struct kvs_cparams, vinline_len),
+        .ps_size = PARAM_SZ(struct kvs_cparams, vinline_len),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = CN_SMALL_VALUE_THRESHOLD,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = 0,
+                .ps_max = CN_INLINE_VALUE_LEN_MAX,
+            },
+        },
+    },
 };
 
 const struct param_spec *
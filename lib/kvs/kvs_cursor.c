@@ -4,7 +4,6 @@
  */
 
 #include <hse/logging/logging.h>
-#include <hse_util/compression_lz4.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/fmt.h>
 #include <hse_util/keycmp.h>
@@ -19,11 +18,13 @@
 #include <hse_ikvdb/lc.h>
 #include <hse_ikvdb/cn.h>
 #include <hse_ikvdb/kvs.h>
+#include <hse_ikvdb/kvs_rtomb.h>
 #include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/kvdb_ctxn.h>
 #include <hse_ikvdb/kvdb_perfc.h>
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/cursor.h>
+#include <hse_ikvdb/vcomp_params.h>
 
 #include <c0/c0_cursor.h>
 #include <cn/cn_cursor.h>
@@ -162,6 +163,7 @@ struct kvs_cursor_impl {
 
     struct kvs_cursor_element  kci_elem_last;
     struct kvs_cursor_element  kci_ptomb;
+    struct kvs_rtomb_vec       kci_rtombs;
     struct key_obj             kci_last_kobj;
     struct key_obj *           kci_last;
     u8 *                       kci_last_kbuf;
@@ -724,6 +726,24 @@ kvs_cursor_bh_create(struct hse_kvs_cursor *cursor)
     return 0;
 }
 
+/* Collect the range tombstones in c0 within the cursor's view.  These may
+ * hide elements from any source, whereas the cn cursor applies the range
+ * tombstones it finds in cn (which can only hide older elements in cn).
+ */
+static merr_t
+kvs_cursor_rtombs_update(struct kvs_cursor_impl *cur)
+{
+    merr_t err;
+
+    kvs_rtomb_vec_reset(&cur->kci_rtombs);
+
+    err = c0_cursor_rtombs(cur->kci_c0cur, &cur->kci_rtombs);
+    if (!err)
+        err = kvs_rtomb_vec_sort(&cur->kci_rtombs);
+
+    return err;
+}
+
 merr_t
 kvs_cursor_init(struct hse_kvs_cursor *cursor, struct kvdb_ctxn *ctxn)
 {
@@ -833,6 +853,10 @@ kvs_cursor_init(struct hse_kvs_cursor *cursor, struct kvdb_ctxn *ctxn)
 
     assert(cur->kci_cncur);
 
+    err = kvs_cursor_rtombs_update(cur);
+    if (ev(err))
+        goto error;
+
     cur->kci_need_toss = 0;
     cur->kci_need_seek = 1;
 
@@ -883,6 +907,8 @@ kvs_cursor_destroy(struct hse_kvs_cursor *handle)
     if (cursor->kci_bh)
         bin_heap_destroy(cursor->kci_bh);
 
+    kvs_rtomb_vec_fini(&cursor->kci_rtombs);
+
     vlb_free(cursor, kvs_cursor_impl_alloc_sz);
 }
 
@@ -934,6 +960,10 @@ kvs_cursor_update(struct hse_kvs_cursor *handle, struct kvdb_ctxn *ctxn, u64 seq
     if (flags & CURSOR_FLAG_SEQNO_CHANGE)
         perfc_inc(cursor->kci_cc_pc, PERFC_BA_CC_UPDATED_C0);
 
+    cursor->kci_err = kvs_cursor_rtombs_update(cursor);
+    if (ev(cursor->kci_err))
+        return cursor->kci_err;
+
     /* Update lc cursor */
     cursor->kci_err =
         lc_cursor_update(cursor->kci_lccur, cursor->kci_last_kbuf, cursor->kci_last_klen, seqno);
@@ -1006,6 +1036,27 @@ ikvs_cursor_should_drop(struct kvs_cursor_element *item, struct kvs_cursor_eleme
     return true;
 }
 
+static bool
+ikvs_cursor_rtomb_hides(struct kvs_cursor_impl *cursor, struct kvs_cursor_element *item)
+{
+    const struct kvs_rtomb_vec *vec = &cursor->kci_rtombs;
+    u64                         elem_seqno = 0, rt_seqno;
+
+    if (!vec->krv_cnt)
+        return false;
+
+    /* Range deletes are not transactional, so an item from an active txn
+     * is always newer than any range tombstone in the cursor's view.
+     */
+    if (seqnoref_to_seqno(item->kce_seqnoref, &elem_seqno) != HSE_SQNREF_STATE_DEFINED)
+        return false;
+
+    rt_seqno = kvs_rtomb_seq(vec->krv_rtv, vec->krv_cnt, &item->kce_kobj,
+                             cursor->kci_handle.kc_seq);
+
+    return rt_seqno > elem_seqno;
+}
+
 merr_t
 ikvs_cursor_replenish(struct kvs_cursor_impl *cursor)
 {
@@ -1047,6 +1098,11 @@ ikvs_cursor_replenish(struct kvs_cursor_impl *cursor)
             }
         }
 
+        if (!is_ptomb && ikvs_cursor_rtomb_hides(cursor, &cursor->kci_elem_last)) {
+            is_tomb = true;
+            continue;
+        }
+
         if (is_ptomb) {
             cursor->kci_ptomb = cursor->kci_elem_last;
             cursor->kci_ptomb_set = 1;
@@ -1134,6 +1190,55 @@ kvs_cursor_key_copy(
         *key_out = key;
 }
 
+/* Resolve the merge operand at the cursor's current position by applying
+ * it to the older versions of the key within the cursor's view.
+ */
+static merr_t
+kvs_cursor_merge_copy(
+    struct kvs_cursor_impl *cur,
+    void *buf,
+    size_t bufsz,
+    const void **val_out,
+    size_t *vlen_out)
+{
+    const struct kvs_cursor_element *elem = &cur->kci_elem_last;
+    char kbuf[HSE_KVS_KEY_LEN_MAX];
+    struct kvs_ktuple kt;
+    struct kvs_buf vbuf;
+    enum key_lookup_res res;
+    uintptr_t seqnoref;
+    u64 seq;
+    uint klen;
+    merr_t err;
+
+    if (!buf) {
+        buf = cur->kci_buf + HSE_KVS_KEY_LEN_MAX;
+        bufsz = HSE_KVS_VALUE_LEN_MAX;
+    }
+
+    key_obj_copy(kbuf, sizeof(kbuf), &klen, &elem->kce_kobj);
+    kvs_ktuple_init_nohash(&kt, kbuf, klen);
+    kt.kt_hash = key_hash64(kbuf, klen - cur->kci_kvs->ikv_sfx_len);
+
+    seqnoref = elem->kce_seqnoref;
+    seq = HSE_SQNREF_ORDNL_P(seqnoref) ? HSE_SQNREF_TO_ORDNL(seqnoref) : cur->kci_handle.kc_seq;
+
+    kvs_buf_init(&vbuf, buf, bufsz);
+
+    err = kvs_get_merge(cur->kci_kvs, NULL, &kt, cur->kci_handle.kc_seq, elem->kce_vt.vt_data,
+                        kvs_vtuple_vlen(&elem->kce_vt), seq, &res, &vbuf);
+    if (ev(err))
+        return err;
+
+    if (val_out)
+        *val_out = buf;
+
+    if (vlen_out)
+        *vlen_out = vbuf.b_len;
+
+    return 0;
+}
+
 merr_t
 kvs_cursor_val_copy(
     struct hse_kvs_cursor *cursor,
@@ -1155,6 +1260,9 @@ kvs_cursor_val_copy(
     vt = &cur->kci_elem_last.kce_vt;
     clen = cur->kci_elem_last.kce_complen;
 
+    if (cur->kci_elem_last.kce_is_merge)
+        return kvs_cursor_merge_copy(cur, buf, bufsz, val_out, vlen_out);
+
     if (!buf && !val_out)
         goto out;
 
@@ -1166,7 +1274,7 @@ kvs_cursor_val_copy(
     if (clen) {
         uint outlen;
 
-        err = compress_lz4_ops.cop_decompress(vt->vt_data, clen, buf, bufsz, &outlen);
+        err = vcomp_decompress(vt->vt_data, clen, NULL, buf, bufsz, &outlen);
         if (ev(err))
             return err;
 
@@ -1248,6 +1356,18 @@ kvs_cursor_read(struct hse_kvs_cursor *handle, unsigned int flags, bool *eofp)
     return cursor->kci_err;
 }
 
+void
+kvs_cursor_unread(struct hse_kvs_cursor *handle)
+{
+    struct kvs_cursor_impl *cursor = (void *)handle;
+
+    assert(!cursor->kci_need_seek && !cursor->kci_eof && cursor->kci_last);
+
+    /* Same state as after a seek to the current element.
+     */
+    cursor->kci_need_toss = 0;
+}
+
 merr_t
 kvs_cursor_seek(
     struct hse_kvs_cursor *handle,
@@ -0,0 +1,108 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/assert.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/minmax.h>
+#include <hse_util/vlb.h>
+
+#include <hse_ikvdb/kvs_merge.h>
+
+merr_t
+kvs_merge_init(struct kvs_merge *km)
+{
+    memset(km, 0, sizeof(*km));
+
+    km->km_buf = vlb_alloc(HSE_KVS_VALUE_LEN_MAX * 2);
+    if (ev(!km->km_buf))
+        return merr(ENOMEM);
+
+    km->km_tmp = km->km_buf + HSE_KVS_VALUE_LEN_MAX;
+
+    return 0;
+}
+
+void
+kvs_merge_fini(struct kvs_merge *km)
+{
+    void *mem;
+
+    if (!km || !km->km_buf)
+        return;
+
+    mem = (km->km_buf < km->km_tmp) ? km->km_buf : km->km_tmp;
+
+    vlb_free(mem, HSE_KVS_VALUE_LEN_MAX * 2);
+    km->km_buf = km->km_tmp = NULL;
+}
+
+void
+kvs_merge_start(
+    struct kvs_merge          *km,
+    const struct kvs_merge_op *op,
+    const struct key_obj      *kobj,
+    const void                *opnd,
+    uint                       len,
+    u64                        seq)
+{
+    assert(km->km_buf && len <= HSE_KVS_VALUE_LEN_MAX);
+
+    km->km_op = op;
+    km->km_seq = seq;
+    km->km_len = len;
+    km->km_opnd = true;
+    km->km_active = true;
+
+    key_obj_copy(km->km_key, sizeof(km->km_key), &km->km_klen, kobj);
+    memcpy(km->km_buf, opnd, len);
+}
+
+static merr_t
+kvs_merge_apply(struct kvs_merge *km, const void *base, uint len, uint maxlen)
+{
+    size_t rlen = 0;
+    void  *tmp;
+    int    rc;
+
+    assert(km->km_active && km->km_opnd);
+
+    if (!km->km_op)
+        return merr(ENOTSUP);
+
+    maxlen = min_t(uint, maxlen, HSE_KVS_VALUE_LEN_MAX);
+
+    rc = km->km_op->mo_fn(km->km_op->mo_arg, km->km_key, km->km_klen, base, len,
+                          km->km_buf, km->km_len, km->km_tmp, maxlen, &rlen);
+    if (rc)
+        return merr(rc);
+
+    if (rlen > maxlen)
+        return merr(EMSGSIZE);
+
+    tmp = km->km_buf;
+    km->km_buf = km->km_tmp;
+    km->km_tmp = tmp;
+    km->km_len = rlen;
+
+    return 0;
+}
+
+merr_t
+kvs_merge_fold(struct kvs_merge *km, const void *opnd, uint len, uint maxlen)
+{
+    return kvs_merge_apply(km, opnd, len, maxlen);
+}
+
+merr_t
+kvs_merge_resolve(struct kvs_merge *km, const void *base, uint len, uint maxlen)
+{
+    merr_t err;
+
+    err = kvs_merge_apply(km, base, base ? len : 0, maxlen);
+    if (!err)
+        km->km_opnd = false;
+
+    return err;
+}
@@ -120,7 +120,9 @@ compression_algorithm_converter(
     void *const                    data)
 {
     static const char *algos[VCOMP_ALGO_COUNT] = {
-        VCOMP_PARAM_LZ4
+        VCOMP_PARAM_LZ4,
+        VCOMP_PARAM_ZSTD,
+        VCOMP_PARAM_ZSTD_DICT,
     };
 
     assert(ps);
@@ -134,6 +136,11 @@ compression_algorithm_converter(
 
     for (size_t i = VCOMP_ALGO_MIN; i < VCOMP_ALGO_COUNT; i++) {
         if (!strcmp(algos[i], value)) {
+            if (!vcomp_compress_ops[i]) {
+                log_err("Compression algorithm not supported by this build: %s", value);
+                return false;
+            }
+
             *(enum vcomp_algorithm *)data = i;
             return true;
         }
@@ -165,6 +172,12 @@ compression_algorithm_stringify(
         case VCOMP_ALGO_LZ4:
             param = VCOMP_PARAM_LZ4;
             break;
+        case VCOMP_ALGO_ZSTD:
+            param = VCOMP_PARAM_ZSTD;
+            break;
+        case VCOMP_ALGO_ZSTD_DICT:
+            param = VCOMP_PARAM_ZSTD_DICT;
+            break;
     }
 
     assert(param);
@@ -190,6 +203,10 @@ compression_algorithm_jsonify(const struct param_spec *const ps, const void *con
     switch (algo) {
         case VCOMP_ALGO_LZ4:
             return cJSON_CreateString(VCOMP_PARAM_LZ4);
+        case VCOMP_ALGO_ZSTD:
+            return cJSON_CreateString(VCOMP_PARAM_ZSTD);
+        case VCOMP_ALGO_ZSTD_DICT:
+            return cJSON_CreateString(VCOMP_PARAM_ZSTD_DICT);
     }
 
     abort();
@@ -623,6 +640,42 @@ static const struct param_spec pspecs[] = {
             },
         },
     },
+    {
+        .ps_name = "cn_node_bloom_prob",
+        .ps_description = "leaf node aggregate bloom probability (0: disabled)",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_U64,
+        .ps_offset = offsetof(struct kvs_rparams, cn_node_bloom_prob),
+        .ps_size = PARAM_SZ(struct kvs_rparams, cn_node_bloom_prob),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = 0,
+        },
+        .ps_bounds = {
+            .as_uscalar = {
+                .ps_min = 0,
+                .ps_max = UINT64_MAX,
+            },
+        },
+    },
+    {
+        .ps_name = "cn_kblock_compress",
+        .ps_description = "compress kblock wbtree leaf nodes",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_BOOL,
+        .ps_offset = offsetof(struct kvs_rparams, cn_kblock_compress),
+        .ps_size = PARAM_SZ(struct kvs_rparams, cn_kblock_compress),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_bool = false,
+        },
+    },
     {
         .ps_name = "cn_compaction_debug",
         .ps_description = "cn compaction debug flags",
@@ -701,6 +754,21 @@ static const struct param_spec pspecs[] = {
             },
         },
     },
+    {
+        .ps_name = "cn_kvset_lazy_open",
+        .ps_description = "defer mapping restored kvsets until first access",
+        .ps_flags = PARAM_FLAG_EXPERIMENTAL,
+        .ps_type = PARAM_TYPE_BOOL,
+        .ps_offset = offsetof(struct kvs_rparams, cn_kvset_lazy_open),
+        .ps_size = PARAM_SZ(struct kvs_rparams, cn_kvset_lazy_open),
+        .ps_convert = param_default_converter,
+        .ps_validate = param_default_validator,
+        .ps_stringify = param_default_stringify,
+        .ps_jsonify = param_default_jsonify,
+        .ps_default_value = {
+            .as_uscalar = false,
+        },
+    },
     {
         .ps_name = "capped_evict_ttl",
         .ps_description = "",
@@ -780,7 +848,7 @@ static const struct param_spec pspecs[] = {
     },
     {
         .ps_name = "compression.algorithm",
-        .ps_description = "Value compression algorithm (lz4)",
+        .ps_description = "Value compression algorithm (lz4, zstd, zstd-dict)",
         .ps_flags = 0,
         .ps_type = PARAM_TYPE_ENUM,
         .ps_offset = offsetof(struct kvs_rparams, compression.algorithm),
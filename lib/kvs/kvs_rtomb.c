@@ -0,0 +1,242 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <hse_util/assert.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/keycmp.h>
+
+#include <hse_ikvdb/kvs_rtomb.h>
+
+static HSE_ALWAYS_INLINE bool
+rtomb_start_eq(const struct kvs_rtomb *a, const struct kvs_rtomb *b)
+{
+    return !keycmp(a->kr_start, a->kr_start_len, b->kr_start, b->kr_start_len);
+}
+
+u64
+kvs_rtomb_seq(const struct kvs_rtomb *rtv, uint rtc, const struct key_obj *kobj, u64 view)
+{
+    const struct kvs_rtomb *rt;
+    struct key_obj ko;
+    uint lo = 0, hi = rtc;
+    u64 seq = 0;
+
+    /* Find the last fragment that starts at or before the key.
+     */
+    while (lo < hi) {
+        uint mid = lo + (hi - lo) / 2;
+
+        key2kobj(&ko, rtv[mid].kr_start, rtv[mid].kr_start_len);
+        if (key_obj_cmp(&ko, kobj) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == 0)
+        return 0;
+
+    rt = rtv + lo - 1;
+
+    key2kobj(&ko, rt->kr_end, rt->kr_end_len);
+    if (key_obj_cmp(kobj, &ko) >= 0)
+        return 0;
+
+    /* The fragments of a range are ordered newest first, so walk back
+     * from the oldest until one is newer than the view.
+     */
+    while (rt->kr_seq <= view) {
+        seq = rt->kr_seq;
+
+        if (rt == rtv || !rtomb_start_eq(rt - 1, rt))
+            break;
+        rt--;
+    }
+
+    return seq;
+}
+
+struct rtomb_key {
+    const void *rk_data;
+    u16         rk_len;
+};
+
+static int
+rtomb_key_cmp(const void *lhs, const void *rhs)
+{
+    const struct rtomb_key *a = lhs, *b = rhs;
+
+    return keycmp(a->rk_data, a->rk_len, b->rk_data, b->rk_len);
+}
+
+static int
+rtomb_frag_cmp(const void *lhs, const void *rhs)
+{
+    const struct kvs_rtomb *a = lhs, *b = rhs;
+    int rc;
+
+    rc = keycmp(a->kr_start, a->kr_start_len, b->kr_start, b->kr_start_len);
+    if (rc)
+        return rc;
+
+    return (a->kr_seq < b->kr_seq) - (a->kr_seq > b->kr_seq);
+}
+
+/* Merge each run of fragments with the run that follows it if the two are
+ * adjacent and carry the same seqnos.  Returns the new fragment count.
+ */
+static uint
+rtomb_frags_coalesce(struct kvs_rtomb *rtv, uint rtc)
+{
+    uint prev = 0, prevc = 0, outc = 0, i = 0;
+
+    while (i < rtc) {
+        uint runc = 1, j;
+
+        while (i + runc < rtc && rtomb_start_eq(rtv + i, rtv + i + runc))
+            runc++;
+
+        if (prevc == runc &&
+            !keycmp(rtv[prev].kr_end, rtv[prev].kr_end_len, rtv[i].kr_start, rtv[i].kr_start_len)) {
+
+            for (j = 0; j < runc && rtv[prev + j].kr_seq == rtv[i + j].kr_seq; j++)
+                ;
+
+            if (j == runc) {
+                for (j = 0; j < runc; j++) {
+                    rtv[prev + j].kr_end = rtv[i].kr_end;
+                    rtv[prev + j].kr_end_len = rtv[i].kr_end_len;
+                }
+
+                i += runc;
+                continue;
+            }
+        }
+
+        memmove(rtv + outc, rtv + i, runc * sizeof(*rtv));
+        prev = outc;
+        prevc = runc;
+        outc += runc;
+        i += runc;
+    }
+
+    return outc;
+}
+
+merr_t
+kvs_rtomb_vec_sort(struct kvs_rtomb_vec *vec)
+{
+    struct kvs_rtomb_vec frags = { 0 };
+    struct rtomb_key *keyv;
+    uint keyc = 0, i, j;
+    merr_t err = 0;
+
+    if (vec->krv_cnt == 0)
+        return 0;
+
+    keyv = malloc(2 * vec->krv_cnt * sizeof(*keyv));
+    if (ev(!keyv))
+        return merr(ENOMEM);
+
+    for (i = 0; i < vec->krv_cnt; i++) {
+        const struct kvs_rtomb *rt = vec->krv_rtv + i;
+
+        keyv[keyc].rk_data = rt->kr_start;
+        keyv[keyc++].rk_len = rt->kr_start_len;
+        keyv[keyc].rk_data = rt->kr_end;
+        keyv[keyc++].rk_len = rt->kr_end_len;
+    }
+
+    qsort(keyv, keyc, sizeof(*keyv), rtomb_key_cmp);
+
+    for (i = 1, j = 0; i < keyc; i++) {
+        if (rtomb_key_cmp(keyv + j, keyv + i))
+            keyv[++j] = keyv[i];
+    }
+    keyc = j + 1;
+
+    /* Split each tombstone at every bound that falls within it, such that
+     * any two fragments cover either the same range or disjoint ranges.
+     */
+    for (i = 0; i < vec->krv_cnt && !err; i++) {
+        const struct kvs_rtomb *rt = vec->krv_rtv + i;
+        struct rtomb_key end = { rt->kr_end, rt->kr_end_len };
+        struct rtomb_key start = { rt->kr_start, rt->kr_start_len };
+        const struct rtomb_key *k;
+
+        k = bsearch(&start, keyv, keyc, sizeof(*keyv), rtomb_key_cmp);
+        assert(k);
+
+        for (j = k - keyv; j + 1 < keyc && rtomb_key_cmp(keyv + j, &end) < 0 && !err; j++) {
+            struct kvs_rtomb frag = {
+                .kr_start = keyv[j].rk_data,
+                .kr_start_len = keyv[j].rk_len,
+                .kr_end = keyv[j + 1].rk_data,
+                .kr_end_len = keyv[j + 1].rk_len,
+                .kr_seq = rt->kr_seq,
+            };
+
+            err = kvs_rtomb_vec_add(&frags, &frag);
+        }
+    }
+
+    free(keyv);
+
+    if (ev(err)) {
+        kvs_rtomb_vec_fini(&frags);
+        return err;
+    }
+
+    if (frags.krv_cnt > 1) {
+        qsort(frags.krv_rtv, frags.krv_cnt, sizeof(*frags.krv_rtv), rtomb_frag_cmp);
+
+        /* Drop the duplicates, a range needs only one fragment per seqno */
+        for (i = 1, j = 0; i < frags.krv_cnt; i++) {
+            if (rtomb_frag_cmp(frags.krv_rtv + j, frags.krv_rtv + i))
+                frags.krv_rtv[++j] = frags.krv_rtv[i];
+        }
+        frags.krv_cnt = j + 1;
+
+        frags.krv_cnt = rtomb_frags_coalesce(frags.krv_rtv, frags.krv_cnt);
+    }
+
+    kvs_rtomb_vec_fini(vec);
+    *vec = frags;
+
+    return 0;
+}
+
+merr_t
+kvs_rtomb_vec_add(struct kvs_rtomb_vec *vec, const struct kvs_rtomb *rt)
+{
+    if (vec->krv_cnt >= vec->krv_max) {
+        uint              max = vec->krv_max ? vec->krv_max * 2 : 8;
+        struct kvs_rtomb *rtv;
+
+        rtv = realloc(vec->krv_rtv, max * sizeof(*rtv));
+        if (ev(!rtv))
+            return merr(ENOMEM);
+
+        vec->krv_rtv = rtv;
+        vec->krv_max = max;
+    }
+
+    vec->krv_rtv[vec->krv_cnt++] = *rt;
+
+    return 0;
+}
+
+void
+kvs_rtomb_vec_fini(struct kvs_rtomb_vec *vec)
+{
+    if (!vec)
+        return;
+
+    free(vec->krv_rtv);
+    memset(vec, 0, sizeof(*vec));
+}
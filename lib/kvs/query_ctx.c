@@ -12,6 +12,7 @@
 #include <hse_util/event_counter.h>
 
 #include <hse_ikvdb/query_ctx.h>
+#include <hse_ikvdb/tuple.h>
 
 pthread_key_t tomb_thread_key;
 
@@ -51,11 +52,10 @@ qctx_thread_dtor(void *mem)
     free(tem);
 }
 
-static struct tomb_elem *
-alloc_tomb_mem(struct query_ctx *qctx, size_t bytes)
+static void *
+alloc_qctx_mem(struct query_ctx *qctx, size_t sz)
 {
-    struct tomb_elem *  te;
-    size_t              sz = sizeof(*te) + bytes;
+    void *              mem;
     struct te_mem *     ptr;
     struct te_page_hdr *hdr;
     unsigned int        min_offset = (sizeof(*hdr) + 0x0f) & (~0x0e);
@@ -112,10 +112,18 @@ alloc_tomb_mem(struct query_ctx *qctx, size_t bytes)
         qctx->pos = min_offset;
     }
 
-    te = (void *)(ptr->curr_pg + qctx->pos);
+    mem = ptr->curr_pg + qctx->pos;
     qctx->pos += (sz + 0x08) & ~0x07;
 
-    return te;
+    return mem;
+}
+
+static struct tomb_elem *
+alloc_tomb_mem(struct query_ctx *qctx, size_t bytes)
+{
+    struct tomb_elem *te;
+
+    return alloc_qctx_mem(qctx, sizeof(*te) + bytes);
 }
 
 merr_t
@@ -200,6 +208,52 @@ qctx_tomb_seen(struct query_ctx *qctx, const void *sfx, size_t sfx_len)
     return false;
 }
 
+merr_t
+qctx_rtombs_add(
+    struct query_ctx *       qctx,
+    const struct kvs_rtomb * rtv,
+    uint                     rtc,
+    const struct kvs_ktuple *kt,
+    u64                      view)
+{
+    bool   added = false;
+    merr_t err;
+    uint   i;
+
+    for (i = 0; i < rtc; i++) {
+        const struct kvs_rtomb *rt = rtv + i;
+        struct kvs_rtomb        copy;
+        void *                  start, *end;
+
+        if (rt->kr_seq > view)
+            continue;
+
+        /* Skip the range if it ends at or before the prefix, or begins
+         * after every key that has the prefix.
+         */
+        if (keycmp(rt->kr_end, rt->kr_end_len, kt->kt_data, kt->kt_len) <= 0 ||
+            keycmp_prefix(kt->kt_data, kt->kt_len, rt->kr_start, rt->kr_start_len) < 0)
+            continue;
+
+        start = alloc_qctx_mem(qctx, rt->kr_start_len);
+        end = alloc_qctx_mem(qctx, rt->kr_end_len);
+        if (ev(!start || !end))
+            return merr(ENOMEM);
+
+        copy = *rt;
+        copy.kr_start = memcpy(start, rt->kr_start, rt->kr_start_len);
+        copy.kr_end = memcpy(end, rt->kr_end, rt->kr_end_len);
+
+        err = kvs_rtomb_vec_add(&qctx->rtombs, &copy);
+        if (ev(err))
+            return err;
+
+        added = true;
+    }
+
+    return added ? kvs_rtomb_vec_sort(&qctx->rtombs) : 0;
+}
+
 merr_t
 qctx_te_mem_init(void)
 {
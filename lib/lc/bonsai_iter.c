@@ -165,6 +165,15 @@ bonsai_iter_next(struct element_source *es, void **element)
     elem->kce_seqnoref = val->bv_seqnoref;
     elem->kce_complen = bonsai_val_clen(val);
     elem->kce_is_ptomb = iter->bi_is_ptomb;
+    elem->kce_is_merge = HSE_CORE_IS_MERGE(val->bv_xlen);
+
+    /* Present an expired value as a tombstone so that it hides older values.
+     */
+    if (!HSE_CORE_IS_TOMB(val->bv_value) && kvs_expired(bonsai_val_expire(val))) {
+        kvs_vtuple_init(&elem->kce_vt, HSE_CORE_TOMB_REG, 0);
+        elem->kce_complen = 0;
+        elem->kce_is_merge = false;
+    }
 
     *element = &iter->bi_elem;
 
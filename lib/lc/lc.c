@@ -77,12 +77,12 @@
 #include <hse_ikvdb/c0_kvset.h>
 #include <hse_ikvdb/c0snr_set.h>
 #include <hse_ikvdb/kvdb_health.h>
+#include <hse_ikvdb/vcomp_params.h>
 
 #include <hse_util/alloc.h>
 #include <hse_util/slab.h>
 #include <hse_util/vlb.h>
 #include <hse_util/bonsai_tree.h>
-#include <hse_util/compression_lz4.h>
 #include <hse_util/rmlock.h>
 #include <hse_util/bin_heap.h>
 #include <hse_util/bkv_collection.h>
@@ -610,7 +610,10 @@ lc_get_main(
     *val_out = val;
     *oseqnoref = val->bv_seqnoref;
 
-    *res = HSE_CORE_IS_TOMB(val->bv_value) ? FOUND_TMB : FOUND_VAL;
+    if (HSE_CORE_IS_TOMB(val->bv_value) || kvs_expired(bonsai_val_expire(val)))
+        *res = FOUND_TMB;
+    else
+        *res = HSE_CORE_IS_MERGE(val->bv_xlen) ? FOUND_MRG : FOUND_VAL;
 }
 
 static merr_t
@@ -632,8 +635,8 @@ copy_val(struct kvs_buf *vbuf, struct bonsai_val *val)
         ulen = bonsai_val_ulen(val);
 
         if (clen > 0) {
-            err = compress_lz4_ops.cop_decompress(
-                val->bv_value, clen, vbuf->b_buf, vbuf->b_buf_sz, &outlen);
+            err = vcomp_decompress(
+                val->bv_value, clen, NULL, vbuf->b_buf, vbuf->b_buf_sz, &outlen);
             if (ev(err))
                 return err;
 
@@ -672,7 +675,7 @@ lc_get(
     struct lc *              handle,
     u16                      skidx,
     u32                      pfxlen,
-    const struct kvs_ktuple *kt,
+    struct kvs_ktuple *      kt,
     u64                      view_seqno,
     uintptr_t                seqnoref,
     enum key_lookup_res *    res,
@@ -717,10 +720,14 @@ lc_get(
             goto not_found;
     }
 
-    if (*res == FOUND_TMB)
+    if (*res == FOUND_TMB) {
         vbuf->b_len = 0;
-    else if (*res == FOUND_VAL)
+    } else if (*res == FOUND_VAL) {
+        err = copy_val(vbuf, val);
+    } else if (*res == FOUND_MRG) {
+        kt->kt_seqno = val_seq;
         err = copy_val(vbuf, val);
+    }
 
     rcu_read_unlock();
     return err;
@@ -429,6 +429,52 @@ mpool_mblock_write(struct mpool *mp, uint64_t mbid, const struct iovec *iov, int
 merr_t
 mpool_mblock_read(struct mpool *mp, uint64_t mbid, const struct iovec *iov, int iovc, off_t offset);
 
+/**
+ * mpool_mblock_read_cached() - read data from an mblock via the block cache
+ *
+ * @mp:   mpool
+ * @mbid: mblock object ID
+ * @buf:  PAGE aligned output buffer
+ * @len:  length of the read, a multiple of PAGE_SIZE
+ * @off:  PAGE aligned offset into the mblock
+ * @prio: caching priority of the pages read
+ *
+ * Pages not found in the block cache are read from media and inserted.
+ * Equivalent to mpool_mblock_read() if the block cache is disabled.
+ *
+ * Return: %0 on success, merr_t on failure
+ */
+/* MTF_MOCK */
+merr_t
+mpool_mblock_read_cached(
+    struct mpool          *mp,
+    uint64_t               mbid,
+    void                  *buf,
+    size_t                 len,
+    off_t                  off,
+    enum mpool_bcache_prio prio);
+
+/**
+ * mpool_bcache_enabled() - check whether the block cache is enabled
+ *
+ * @mp: mpool
+ */
+/* MTF_MOCK */
+bool
+mpool_bcache_enabled(struct mpool *mp);
+
+/**
+ * mpool_bcache_perfc_alloc() - allocate block cache performance counters
+ *
+ * @mp:    mpool
+ * @group: perfc group name
+ * @prio:  perfc priority
+ *
+ * The counters are freed by mpool_close().  No-op if the cache is disabled.
+ */
+void
+mpool_bcache_perfc_alloc(struct mpool *mp, const char *group, uint prio);
+
 /**
  * mpool_mblock_clone() - clone the specified mblock
  *
@@ -618,6 +664,17 @@ mpool_file_close(struct mpool_file *file);
 merr_t
 mpool_file_destroy(struct mpool *mp, enum hse_mclass mclass, const char *name);
 
+/**
+ * mpool_file_rename() - Rename an mpool file
+ *
+ * @mp:      mpool handle
+ * @mclass:  media class
+ * @oldname: current file name
+ * @newname: new file name
+ */
+merr_t
+mpool_file_rename(struct mpool *mp, enum hse_mclass mclass, const char *oldname, const char *newname);
+
 /**
  * mpool_file_read() - Read an mpool file
  *
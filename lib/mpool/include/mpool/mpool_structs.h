@@ -33,6 +33,30 @@
 #define MPOOL_MBLOCK_PREALLOC   (1u << 0)   /* advisory */
 #define MPOOL_MBLOCK_PUNCH_HOLE (1u << 1)
 
+/**
+ * enum mpool_io_backend - I/O backend used for mblock data reads and writes
+ *
+ * @MPOOL_IO_SYNC:  blocking preadv(2)/pwritev(2)
+ * @MPOOL_IO_URING: io_uring with batched submission and polled completion
+ */
+enum mpool_io_backend {
+    MPOOL_IO_SYNC = 0,
+    MPOOL_IO_URING = 1,
+};
+
+#define MPOOL_IO_BACKEND_MAX MPOOL_IO_URING
+
+/**
+ * enum mpool_bcache_prio - block cache priority tiers
+ *
+ * @MPOOL_BCACHE_PRIO_DATA:  value (vblock) pages
+ * @MPOOL_BCACHE_PRIO_INDEX: hblock, bloom and wbtree node pages
+ */
+enum mpool_bcache_prio {
+    MPOOL_BCACHE_PRIO_DATA = 0,
+    MPOOL_BCACHE_PRIO_INDEX = 1,
+};
+
 /**
  * struct mpool_cparams - mpool create params
  *
@@ -53,13 +77,18 @@ struct mpool_cparams {
 /**
  * struct mpool_rparams - mpool run params
  *
- * @path:      storage path
+ * @dio_disable:    disable direct I/O
+ * @io_backend:     mblock data I/O backend (enum mpool_io_backend)
+ * @path:           storage path
+ * @bcache_size_mb: block cache size in MiB (0 disables the cache)
  */
 struct mpool_rparams {
     struct {
-        bool dio_disable;
-        char path[PATH_MAX];
+        bool    dio_disable;
+        uint8_t io_backend;
+        char    path[PATH_MAX];
     } mclass[HSE_MCLASS_COUNT];
+    uint32_t bcache_size_mb;
 };
 
 /**
@@ -0,0 +1,420 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <stdlib.h>
+#include <sys/uio.h>
+
+#include <hse/kvdb_perfc.h>
+#include <hse/logging/logging.h>
+
+#include <hse_util/platform.h>
+#include <hse_util/assert.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/hash.h>
+#include <hse_util/log2.h>
+#include <hse_util/minmax.h>
+#include <hse_util/page.h>
+#include <hse_util/perfc.h>
+#include <hse_util/spinlock.h>
+
+#include "bcache.h"
+
+/* Each shard manages at least BCACHE_SHARD_PAGES_MIN pages, and the number
+ * of shards is a power of two no larger than BCACHE_SHARDS_MAX.
+ */
+#define BCACHE_SHARDS_MAX      (64)
+#define BCACHE_SHARD_PAGES_MIN (256)
+
+/* Maximum CLOCK usage count for each priority tier.  A page is evicted only
+ * after the clock hand has passed over it (usage count + 1) times without an
+ * intervening hit.
+ */
+#define BCACHE_REF_MAX_DATA  (1)
+#define BCACHE_REF_MAX_INDEX (3)
+
+#define BCACHE_NIL (UINT32_MAX)
+
+/* clang-format off */
+
+struct perfc_name bcache_perfc[] _dt_section = {
+    NE(PERFC_RA_BCACHE_IDX_HIT,   2, "bcache index page hit rate",   "r_idx_hit(/s)"),
+    NE(PERFC_RA_BCACHE_IDX_MISS,  2, "bcache index page miss rate",  "r_idx_miss(/s)"),
+    NE(PERFC_RA_BCACHE_DATA_HIT,  2, "bcache data page hit rate",    "r_data_hit(/s)"),
+    NE(PERFC_RA_BCACHE_DATA_MISS, 2, "bcache data page miss rate",   "r_data_miss(/s)"),
+    NE(PERFC_RA_BCACHE_EVICT,     3, "bcache page eviction rate",    "r_evict(/s)"),
+};
+
+NE_CHECK(bcache_perfc, PERFC_EN_BCACHE, "bcache_perfc table/enum mismatch");
+
+/* clang-format on */
+
+/**
+ * struct bcache_ent - cached page descriptor
+ * @be_mbid: mblock id (zero if the entry is free)
+ * @be_pgno: page number within the mblock
+ * @be_next: index of next entry in hash chain
+ * @be_ref:  CLOCK usage count
+ * @be_prio: highest priority with which the page has been accessed
+ */
+struct bcache_ent {
+    uint64_t be_mbid;
+    uint32_t be_pgno;
+    uint32_t be_next;
+    uint8_t  be_ref;
+    uint8_t  be_prio;
+};
+
+/**
+ * struct bcache_shard - an independently locked partition of the cache
+ * @bs_lock:    protects all shard state and page contents
+ * @bs_hand:    CLOCK hand (index into @bs_entv)
+ * @bs_entc:    number of entries (and pages) in the shard
+ * @bs_bktmask: number of hash buckets minus one
+ * @bs_bktv:    hash bucket heads
+ * @bs_entv:    page descriptors
+ * @bs_pages:   page frames, page i is described by @bs_entv[i]
+ */
+struct bcache_shard {
+    spinlock_t         bs_lock HSE_L1D_ALIGNED;
+    uint32_t           bs_hand;
+    uint32_t           bs_entc;
+    uint32_t           bs_bktmask;
+    uint32_t          *bs_bktv;
+    struct bcache_ent *bs_entv;
+    char              *bs_pages;
+};
+
+/**
+ * struct bcache - sharded page cache
+ * @bc_shardmask: number of shards minus one
+ * @bc_pc:        performance counters
+ * @bc_shardv:    shards
+ */
+struct bcache {
+    uint32_t            bc_shardmask;
+    struct perfc_set    bc_pc;
+    struct bcache_shard bc_shardv[];
+};
+
+static const uint8_t bcache_ref_max[] = {
+    [MPOOL_BCACHE_PRIO_DATA] = BCACHE_REF_MAX_DATA,
+    [MPOOL_BCACHE_PRIO_INDEX] = BCACHE_REF_MAX_INDEX,
+};
+
+static HSE_ALWAYS_INLINE uint64_t
+bcache_hash(uint64_t mbid, uint32_t pgno)
+{
+    return hse_hash64v(&mbid, sizeof(mbid), &pgno, sizeof(pgno));
+}
+
+static HSE_ALWAYS_INLINE struct bcache_shard *
+bcache_shard(struct bcache *bc, uint64_t hash)
+{
+    return bc->bc_shardv + (hash & bc->bc_shardmask);
+}
+
+static HSE_ALWAYS_INLINE uint32_t *
+bcache_bkt(struct bcache_shard *bs, uint64_t hash)
+{
+    return bs->bs_bktv + ((hash >> 32) & bs->bs_bktmask);
+}
+
+static uint32_t
+bcache_lookup(struct bcache_shard *bs, uint32_t *bkt, uint64_t mbid, uint32_t pgno)
+{
+    uint32_t idx;
+
+    for (idx = *bkt; idx != BCACHE_NIL; idx = bs->bs_entv[idx].be_next) {
+        const struct bcache_ent *ent = bs->bs_entv + idx;
+
+        if (ent->be_mbid == mbid && ent->be_pgno == pgno)
+            break;
+    }
+
+    return idx;
+}
+
+static void
+bcache_unlink(struct bcache_shard *bs, uint32_t idx)
+{
+    struct bcache_ent *ent = bs->bs_entv + idx;
+    uint32_t          *pp;
+
+    pp = bcache_bkt(bs, bcache_hash(ent->be_mbid, ent->be_pgno));
+
+    while (*pp != idx) {
+        assert(*pp != BCACHE_NIL);
+        pp = &bs->bs_entv[*pp].be_next;
+    }
+
+    *pp = ent->be_next;
+    ent->be_mbid = 0;
+}
+
+/* Advance the clock hand until a free or unreferenced entry is found,
+ * decrementing the usage count of each referenced entry passed over.
+ */
+static uint32_t
+bcache_evict(struct bcache *bc, struct bcache_shard *bs)
+{
+    while (true) {
+        uint32_t           idx = bs->bs_hand;
+        struct bcache_ent *ent = bs->bs_entv + idx;
+
+        if (++bs->bs_hand >= bs->bs_entc)
+            bs->bs_hand = 0;
+
+        if (!ent->be_mbid)
+            return idx;
+
+        if (ent->be_ref > 0) {
+            ent->be_ref--;
+            continue;
+        }
+
+        bcache_unlink(bs, idx);
+        perfc_inc(&bc->bc_pc, PERFC_RA_BCACHE_EVICT);
+
+        return idx;
+    }
+}
+
+static bool
+bcache_get(struct bcache *bc, uint64_t mbid, uint32_t pgno, void *buf, enum mpool_bcache_prio prio)
+{
+    struct bcache_shard *bs;
+    uint64_t             hash;
+    uint32_t             idx;
+
+    hash = bcache_hash(mbid, pgno);
+    bs = bcache_shard(bc, hash);
+
+    spin_lock(&bs->bs_lock);
+    idx = bcache_lookup(bs, bcache_bkt(bs, hash), mbid, pgno);
+    if (idx != BCACHE_NIL) {
+        struct bcache_ent *ent = bs->bs_entv + idx;
+
+        ent->be_prio = max_t(uint8_t, ent->be_prio, prio);
+        if (ent->be_ref < bcache_ref_max[ent->be_prio])
+            ent->be_ref++;
+
+        memcpy(buf, bs->bs_pages + (size_t)idx * PAGE_SIZE, PAGE_SIZE);
+    }
+    spin_unlock(&bs->bs_lock);
+
+    return idx != BCACHE_NIL;
+}
+
+static void
+bcache_put(struct bcache *bc, uint64_t mbid, uint32_t pgno, const void *buf, enum mpool_bcache_prio prio)
+{
+    struct bcache_shard *bs;
+    struct bcache_ent   *ent;
+    uint64_t             hash;
+    uint32_t            *bkt;
+    uint32_t             idx;
+
+    hash = bcache_hash(mbid, pgno);
+    bs = bcache_shard(bc, hash);
+    bkt = bcache_bkt(bs, hash);
+
+    spin_lock(&bs->bs_lock);
+
+    /* Another thread may have inserted the page while we were reading it.
+     */
+    if (bcache_lookup(bs, bkt, mbid, pgno) != BCACHE_NIL) {
+        spin_unlock(&bs->bs_lock);
+        return;
+    }
+
+    idx = bcache_evict(bc, bs);
+    ent = bs->bs_entv + idx;
+
+    ent->be_mbid = mbid;
+    ent->be_pgno = pgno;
+    ent->be_prio = prio;
+    ent->be_ref = (prio == MPOOL_BCACHE_PRIO_INDEX) ? 1 : 0;
+    ent->be_next = *bkt;
+    *bkt = idx;
+
+    memcpy(bs->bs_pages + (size_t)idx * PAGE_SIZE, buf, PAGE_SIZE);
+
+    spin_unlock(&bs->bs_lock);
+}
+
+/* Read pages [first, last) of the request from media and insert them.
+ */
+static merr_t
+bcache_fill(
+    struct bcache         *bc,
+    struct mpool          *mp,
+    uint64_t               mbid,
+    void                  *buf,
+    uint32_t               pgno,
+    uint32_t               first,
+    uint32_t               last,
+    enum mpool_bcache_prio prio)
+{
+    struct iovec iov;
+    uint32_t     i;
+    merr_t       err;
+
+    iov.iov_base = buf + (size_t)first * PAGE_SIZE;
+    iov.iov_len = (size_t)(last - first) * PAGE_SIZE;
+
+    err = mpool_mblock_read(mp, mbid, &iov, 1, (off_t)(pgno + first) * PAGE_SIZE);
+    if (ev(err))
+        return err;
+
+    for (i = first; i < last; i++)
+        bcache_put(bc, mbid, pgno + i, buf + (size_t)i * PAGE_SIZE, prio);
+
+    return 0;
+}
+
+merr_t
+bcache_read(
+    struct bcache         *bc,
+    struct mpool          *mp,
+    uint64_t               mbid,
+    void                  *buf,
+    size_t                 len,
+    off_t                  off,
+    enum mpool_bcache_prio prio)
+{
+    uint32_t pgno, pgc, first, i;
+    uint     hits = 0;
+    merr_t   err;
+
+    if (!len || !IS_ALIGNED(len, PAGE_SIZE) || !IS_ALIGNED(off, PAGE_SIZE) ||
+        !IS_ALIGNED((uintptr_t)buf, PAGE_SIZE) || prio > MPOOL_BCACHE_PRIO_INDEX)
+        return merr(EINVAL);
+
+    pgno = off / PAGE_SIZE;
+    pgc = len / PAGE_SIZE;
+    first = BCACHE_NIL;
+
+    /* Copy out cached pages and coalesce each run of missing pages
+     * into a single read.
+     */
+    for (i = 0; i < pgc; i++) {
+        if (bcache_get(bc, mbid, pgno + i, buf + (size_t)i * PAGE_SIZE, prio)) {
+            hits++;
+
+            if (first != BCACHE_NIL) {
+                err = bcache_fill(bc, mp, mbid, buf, pgno, first, i, prio);
+                if (err)
+                    return err;
+
+                first = BCACHE_NIL;
+            }
+        } else if (first == BCACHE_NIL) {
+            first = i;
+        }
+    }
+
+    if (first != BCACHE_NIL) {
+        err = bcache_fill(bc, mp, mbid, buf, pgno, first, pgc, prio);
+        if (err)
+            return err;
+    }
+
+    if (prio == MPOOL_BCACHE_PRIO_INDEX)
+        perfc_add2(&bc->bc_pc, PERFC_RA_BCACHE_IDX_HIT, hits, PERFC_RA_BCACHE_IDX_MISS, pgc - hits);
+    else
+        perfc_add2(&bc->bc_pc, PERFC_RA_BCACHE_DATA_HIT, hits, PERFC_RA_BCACHE_DATA_MISS, pgc - hits);
+
+    return 0;
+}
+
+void
+bcache_perfc_alloc(struct bcache *bc, const char *group, uint prio)
+{
+    perfc_alloc(bcache_perfc, group, "bcache", prio, &bc->bc_pc);
+}
+
+void
+bcache_perfc_free(struct bcache *bc)
+{
+    perfc_free(&bc->bc_pc);
+}
+
+merr_t
+bcache_create(size_t size, struct bcache **bcout)
+{
+    struct bcache *bc;
+    size_t         pgc, shardc, sz;
+    uint32_t       i;
+
+    if (!bcout)
+        return merr(EINVAL);
+
+    *bcout = NULL;
+
+    pgc = size / PAGE_SIZE;
+    if (pgc < BCACHE_SHARD_PAGES_MIN || pgc / BCACHE_SHARDS_MAX >= BCACHE_NIL)
+        return merr(EINVAL);
+
+    shardc = rounddown_pow_of_two(pgc / BCACHE_SHARD_PAGES_MIN);
+    shardc = min_t(size_t, shardc, BCACHE_SHARDS_MAX);
+
+    sz = sizeof(*bc) + shardc * sizeof(bc->bc_shardv[0]);
+
+    bc = aligned_alloc(__alignof__(*bc), roundup(sz, __alignof__(*bc)));
+    if (ev(!bc))
+        return merr(ENOMEM);
+
+    memset(bc, 0, sz);
+    bc->bc_shardmask = shardc - 1;
+
+    for (i = 0; i < shardc; i++) {
+        struct bcache_shard *bs = bc->bc_shardv + i;
+        uint32_t             entc, bktc, j;
+
+        entc = pgc / shardc;
+        bktc = roundup_pow_of_two(entc);
+
+        spin_lock_init(&bs->bs_lock);
+        bs->bs_entc = entc;
+        bs->bs_bktmask = bktc - 1;
+
+        bs->bs_bktv = malloc(bktc * sizeof(*bs->bs_bktv));
+        bs->bs_entv = calloc(entc, sizeof(*bs->bs_entv));
+        bs->bs_pages = aligned_alloc(PAGE_SIZE, (size_t)entc * PAGE_SIZE);
+
+        if (ev(!bs->bs_bktv || !bs->bs_entv || !bs->bs_pages)) {
+            bcache_destroy(bc);
+            return merr(ENOMEM);
+        }
+
+        for (j = 0; j < bktc; j++)
+            bs->bs_bktv[j] = BCACHE_NIL;
+    }
+
+    log_info("block cache enabled: %zu MiB, %zu shards", (pgc * PAGE_SIZE) >> 20, shardc);
+
+    *bcout = bc;
+
+    return 0;
+}
+
+void
+bcache_destroy(struct bcache *bc)
+{
+    uint32_t i;
+
+    if (!bc)
+        return;
+
+    for (i = 0; i <= bc->bc_shardmask; i++) {
+        struct bcache_shard *bs = bc->bc_shardv + i;
+
+        free(bs->bs_pages);
+        free(bs->bs_entv);
+        free(bs->bs_bktv);
+    }
+
+    free(bc);
+}
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef MPOOL_BCACHE_H
+#define MPOOL_BCACHE_H
+
+#include <hse/error/merr.h>
+
+#include <mpool/mpool.h>
+
+struct bcache;
+struct perfc_set;
+
+/**
+ * bcache_create() - create a sharded page cache for mblock data
+ *
+ * @size:  cache size in bytes (rounded down to a whole number of pages)
+ * @bcout: bcache handle (output)
+ *
+ * The cache is keyed by (mblock id, page number) and uses a generalized CLOCK
+ * replacement policy in which each page carries a small usage count.  Pages
+ * cached with MPOOL_BCACHE_PRIO_INDEX may accrue a higher usage count than
+ * MPOOL_BCACHE_PRIO_DATA pages and hence survive more sweeps of the clock
+ * hand, which keeps hot index pages resident in the face of a stream of
+ * value reads.
+ *
+ * The cache is copy-through: bcache_read() copies cached pages into the
+ * caller's buffer.  cn reads two kinds of pages through it, wbtree and ptree
+ * nodes (one page per node visited) and values of at most four pages that
+ * are read for point gets.  A page copy is cheap next to a media read, and
+ * the caller's buffer is private, so no page needs pinning while in use.
+ * Key metadata and bloom pages are not cached and remain mapped via mcache.
+ * Inline values and key references point directly into kmd memory, which a
+ * copy-through cache cannot back.  A bloom probe touches only a cache line
+ * or two, so copying a whole page to probe it would cost more than it saves.
+ */
+merr_t
+bcache_create(size_t size, struct bcache **bcout);
+
+/**
+ * bcache_destroy() - destroy a bcache
+ *
+ * @bc: bcache handle
+ */
+void
+bcache_destroy(struct bcache *bc);
+
+/**
+ * bcache_read() - read page-aligned mblock data through the cache
+ *
+ * @bc:   bcache handle
+ * @mp:   mpool used to read pages not found in the cache
+ * @mbid: mblock id
+ * @buf:  page-aligned output buffer
+ * @len:  length of the read (multiple of PAGE_SIZE)
+ * @off:  page-aligned offset into the mblock
+ * @prio: caching priority of the pages read
+ */
+merr_t
+bcache_read(
+    struct bcache         *bc,
+    struct mpool          *mp,
+    uint64_t               mbid,
+    void                  *buf,
+    size_t                 len,
+    off_t                  off,
+    enum mpool_bcache_prio prio);
+
+/**
+ * bcache_perfc_alloc() - allocate the bcache's performance counters
+ *
+ * @bc:    bcache handle
+ * @group: perfc group name
+ * @prio:  perfc priority
+ */
+void
+bcache_perfc_alloc(struct bcache *bc, const char *group, uint prio);
+
+/**
+ * bcache_perfc_free() - free the bcache's performance counters
+ *
+ * @bc: bcache handle
+ */
+void
+bcache_perfc_free(struct bcache *bc);
+
+#endif /* MPOOL_BCACHE_H */
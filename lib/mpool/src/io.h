@@ -28,6 +28,11 @@ struct io_ops {
 /* sync backend */
 extern const struct io_ops io_sync_ops;
 
+/* io_uring backend */
+#ifdef HAVE_LIBURING
+extern const struct io_ops io_uring_ops;
+#endif /* HAVE_LIBURING */
+
 /* pmem backend */
 #ifdef HAVE_PMEM
 extern const struct io_ops io_pmem_ops;
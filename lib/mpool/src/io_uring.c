@@ -0,0 +1,342 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <pthread.h>
+#include <sys/uio.h>
+
+#include <liburing.h>
+
+#include <hse_util/platform.h>
+#include <hse_util/arch.h>
+#include <hse_util/minmax.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/assert.h>
+#include <hse/logging/logging.h>
+
+#include "io.h"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/* An mblock read or write is split into chunks of at most IO_URING_IOV_MAX
+ * iovecs, and up to IO_URING_QDEPTH chunks are submitted to the ring with a
+ * single io_uring_enter().  Completions are first reaped by spinning on the
+ * completion queue (which avoids a syscall and a context switch for fast
+ * devices), falling back to a blocking wait after IO_URING_SPIN_MAX polls.
+ */
+#define IO_URING_QDEPTH   (32)
+#define IO_URING_IOV_MAX  min_t(int, IOV_MAX, 256)
+#define IO_URING_SPIN_MAX (4096)
+
+/**
+ * struct io_ring_tls - per-thread io_uring context
+ *
+ * @ring:   submission/completion ring owned by the calling thread
+ * @inited: ring has been successfully initialized
+ * @failed: ring setup failed, use the sync backend for this thread
+ */
+struct io_ring_tls {
+    struct io_uring ring;
+    bool            inited;
+    bool            failed;
+};
+
+static thread_local struct io_ring_tls io_ring_tls;
+
+static pthread_once_t io_ring_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  io_ring_key;
+
+static void
+io_ring_tls_dtor(void *arg)
+{
+    struct io_ring_tls *tls = arg;
+
+    if (tls && tls->inited) {
+        io_uring_queue_exit(&tls->ring);
+        tls->inited = false;
+    }
+}
+
+static void
+io_ring_once_init(void)
+{
+    int rc HSE_MAYBE_UNUSED;
+
+    rc = pthread_key_create(&io_ring_key, io_ring_tls_dtor);
+    assert(rc == 0);
+}
+
+static struct io_uring *
+io_ring_get(void)
+{
+    struct io_ring_tls *tls = &io_ring_tls;
+    int rc;
+
+    if (HSE_LIKELY(tls->inited))
+        return &tls->ring;
+
+    if (tls->failed)
+        return NULL;
+
+    pthread_once(&io_ring_once, io_ring_once_init);
+
+    rc = io_uring_queue_init(IO_URING_QDEPTH, &tls->ring, 0);
+    if (rc) {
+        static bool warned;
+
+        if (!warned) {
+            warned = true;
+            log_warn("io_uring setup failed (%d), reverting to sync I/O", -rc);
+        }
+
+        tls->failed = true;
+        return NULL;
+    }
+
+    /* Register the destructor so that the ring is torn down on thread exit.
+     */
+    pthread_setspecific(io_ring_key, tls);
+    tls->inited = true;
+
+    return &tls->ring;
+}
+
+static size_t
+iolen(const struct iovec *iov, int cnt)
+{
+    size_t len = 0;
+
+    while (cnt-- > 0)
+        len += iov[cnt].iov_len;
+
+    return len;
+}
+
+static int
+io_ring_cqe_reap(struct io_uring *ring, struct io_uring_cqe **cqe)
+{
+    int spins = IO_URING_SPIN_MAX;
+    int rc;
+
+    while (spins-- > 0) {
+        rc = io_uring_peek_cqe(ring, cqe);
+        if (rc != -EAGAIN)
+            return rc;
+
+        cpu_relax();
+    }
+
+    return io_uring_wait_cqe(ring, cqe);
+}
+
+/**
+ * io_ring_rw() - submit a vectored read or write as a batch of SQEs
+ *
+ * @fd:     file descriptor
+ * @off:    starting file offset
+ * @iov:    iovec array
+ * @iovcnt: number of iovecs
+ * @write:  true for write, false for read
+ * @iolenp: number of bytes transferred (output)
+ *
+ * Mirrors the short I/O semantics of the sync backend: on a short transfer
+ * of any chunk, *iolenp reflects only the bytes transferred by contiguous
+ * fully completed chunks plus the short chunk, and no error is returned.
+ */
+static merr_t
+io_ring_rw(
+    int                 fd,
+    off_t               off,
+    const struct iovec *iov,
+    int                 iovcnt,
+    bool                write,
+    size_t             *iolenp)
+{
+    const int chunkmax = IO_URING_IOV_MAX;
+    struct io_uring *ring;
+    size_t total = 0;
+    merr_t err = 0;
+    bool   shortio = false;
+
+    ring = io_ring_get();
+    if (!ring) {
+        return write ? io_sync_ops.write(fd, off, iov, iovcnt, 0, iolenp)
+                     : io_sync_ops.read(fd, off, iov, iovcnt, 0, iolenp);
+    }
+
+    while (iovcnt > 0 && !err && !shortio) {
+        size_t expect[IO_URING_QDEPTH];
+        ssize_t done[IO_URING_QDEPTH];
+        int nsqe = 0, nsub, ncqe, rc, i;
+
+        /* Fill the submission queue with up to IO_URING_QDEPTH chunks.
+         */
+        while (iovcnt > 0 && nsqe < IO_URING_QDEPTH) {
+            struct io_uring_sqe *sqe;
+            int cnt = min_t(int, iovcnt, chunkmax);
+
+            sqe = io_uring_get_sqe(ring);
+            assert(sqe);
+
+            if (write)
+                io_uring_prep_writev(sqe, fd, iov, cnt, off);
+            else
+                io_uring_prep_readv(sqe, fd, iov, cnt, off);
+
+            io_uring_sqe_set_data(sqe, (void *)(uintptr_t)nsqe);
+
+            expect[nsqe] = iolen(iov, cnt);
+            done[nsqe] = 0;
+            ++nsqe;
+
+            off += expect[nsqe - 1];
+            iov += cnt;
+            iovcnt -= cnt;
+        }
+
+        assert(nsqe > 0);
+
+        /* io_uring_submit() may consume fewer SQEs than were queued, keep
+         * submitting until the kernel has accepted all of them.
+         */
+        nsub = 0;
+        while (nsub < nsqe) {
+            rc = io_uring_submit(ring);
+            if (rc < 0) {
+                if (rc == -EINTR)
+                    continue;
+
+                err = merr(-rc);
+                break;
+            }
+
+            if (ev(rc == 0)) {
+                err = merr(EAGAIN);
+                break;
+            }
+
+            nsub += rc;
+        }
+
+        /* Reap all submitted completions, even on error, so that the
+         * caller's iovecs are no longer referenced by the kernel when
+         * we return.
+         */
+        for (ncqe = 0; ncqe < nsub; ++ncqe) {
+            struct io_uring_cqe *cqe;
+            uintptr_t idx;
+
+            rc = io_ring_cqe_reap(ring, &cqe);
+            if (rc < 0) {
+                if (rc == -EINTR) {
+                    --ncqe;
+                    continue;
+                }
+
+                if (!err)
+                    err = merr(-rc);
+                break;
+            }
+
+            idx = (uintptr_t)io_uring_cqe_get_data(cqe);
+            assert(idx < nsqe);
+
+            done[idx] = cqe->res;
+            io_uring_cqe_seen(ring, cqe);
+        }
+
+        /* SQEs the kernel never accepted are still queued in the ring,
+         * and CQEs we failed to reap are still pending.  Tear down the
+         * ring in either case so that the kernel cancels whatever is
+         * still in flight, and so that the next request on this thread
+         * starts with an empty ring rather than reaping stale CQEs and
+         * mistaking their user_data for indexes into its own batch.
+         */
+        if (nsub < nsqe || ncqe < nsub) {
+            assert(err);
+            io_uring_queue_exit(ring);
+            io_ring_tls.inited = false;
+            break;
+        }
+
+        for (i = 0; i < nsqe && !err; ++i) {
+            if (done[i] < 0) {
+                err = merr(-done[i]);
+                break;
+            }
+
+            total += done[i];
+
+            if (done[i] != expect[i]) {
+                ev(1);
+                shortio = true;
+                break;
+            }
+        }
+    }
+
+    if (iolenp)
+        *iolenp = total;
+
+    return err;
+}
+
+merr_t
+io_ring_read(
+    int                 src_fd,
+    off_t               off,
+    const struct iovec *iov,
+    int                 iovcnt,
+    int                 flags,
+    size_t             *rdlen)
+{
+    return io_ring_rw(src_fd, off, iov, iovcnt, false, rdlen);
+}
+
+merr_t
+io_ring_write(
+    int                 dst_fd,
+    off_t               off,
+    const struct iovec *iov,
+    int                 iovcnt,
+    int                 flags,
+    size_t             *wrlen)
+{
+    return io_ring_rw(dst_fd, off, iov, iovcnt, true, wrlen);
+}
+
+merr_t
+io_ring_mmap(void **addr, size_t len, int prot, int flags, int fd, off_t offset)
+{
+    return io_sync_ops.mmap(addr, len, prot, flags, fd, offset);
+}
+
+merr_t
+io_ring_munmap(void *addr, size_t len)
+{
+    return io_sync_ops.munmap(addr, len);
+}
+
+merr_t
+io_ring_msync(void *addr, size_t len, int flags)
+{
+    return io_sync_ops.msync(addr, len, flags);
+}
+
+merr_t
+io_ring_clone(int src_fd, off_t src_off, int tgt_fd, off_t tgt_off, size_t len, int flags)
+{
+    return io_sync_ops.clone(src_fd, src_off, tgt_fd, tgt_off, len, flags);
+}
+
+const struct io_ops io_uring_ops = {
+    .read = io_ring_read,
+    .write = io_ring_write,
+    .mmap = io_ring_mmap,
+    .munmap = io_ring_munmap,
+    .msync = io_ring_msync,
+    .clone = io_ring_clone,
+};
@@ -35,6 +35,8 @@
  *
  * @fidx:      next file index to use for allocation
  * @filev:     vector of mblock file handles
+ * @io:        io backend for metadata operations
+ * @dataio:    io backend for mblock data reads and writes
  *
  * @ug_maddr:   upgrade target mapped addr
  * @ug_mname:   upgrade target meta file name
@@ -56,6 +58,7 @@ struct mblock_fset {
     struct mblock_file   **filev;
     struct mblock_metahdr  mhdr;
     struct io_ops          io;
+    struct io_ops          dataio;
 
     char  *ug_maddr;
     char  *ug_mname;
@@ -455,6 +458,7 @@ mblock_fset_open(
     mbfsp->mhdr.mblksz = mclass_mblocksz_get(mc);
 
     mclass_io_ops_set(mcid_to_mclass(mclass_id(mc)), &mbfsp->io);
+    mclass_dataio_ops_set(mc, &mbfsp->dataio);
 
     flags &= (O_RDWR | O_RDONLY | O_WRONLY | O_CREAT | O_DIRECT);
     create = (flags & O_CREAT);
@@ -523,6 +527,7 @@ mblock_fset_open(
         }
 
         fparams.metaio = &mbfsp->io;
+        fparams.dataio = &mbfsp->dataio;
 
         err = mblock_file_open(mbfsp, mc, &fparams, flags, mbfsp->mhdr.vers, &mbfsp->filev[i]);
         if (err)
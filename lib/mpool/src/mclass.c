@@ -28,6 +28,8 @@
  * @mblocksz: mblock size configured for this mclass
  * @mcid:     mclass ID (persisted in mblock/mdc metadata)
  * @gclose:   was mclass closed gracefully in prior instance
+ * @directio: is direct I/O enabled on this mclass
+ * @iobkend:  mblock data I/O backend (enum mpool_io_backend)
  * @dpath:    mclass directory path
  * @upath:    mclass user-provided path
  */
@@ -38,6 +40,7 @@ struct media_class {
     enum mclass_id      mcid;
     bool                gclose;
     bool                directio;
+    uint8_t             iobkend;
     char *              dpath;
     char *              upath;
 };
@@ -71,6 +74,7 @@ mclass_open(
 
     mc->dirp = dirp;
     mc->mcid = mclass_to_mcid(mclass);
+    mc->iobkend = params->iobkend;
 
     mc->mblocksz = powerof2(params->mblocksz) ? params->mblocksz : MPOOL_MBLOCK_SIZE_DEFAULT;
 
@@ -405,6 +409,22 @@ mclass_io_ops_set(enum hse_mclass mclass, struct io_ops *io)
 #endif
 }
 
+void
+mclass_dataio_ops_set(struct media_class *mc, struct io_ops *io)
+{
+    INVARIANT(mc);
+    INVARIANT(io);
+
+#ifdef HAVE_LIBURING
+    if (mc->iobkend == MPOOL_IO_URING) {
+        *io = io_uring_ops;
+        return;
+    }
+#endif
+
+    *io = io_sync_ops;
+}
+
 merr_t
 mclass_info_get(struct media_class *mc, struct hse_mclass_info *info)
 {
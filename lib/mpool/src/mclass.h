@@ -37,12 +37,14 @@ enum mclass_id {
  * @fmaxsz:   max file size
  * @mblocksz: mblock size
  * @filecnt:  number of files in an mclass fileset
+ * @iobkend:  mblock data I/O backend (enum mpool_io_backend)
  * @path:     storage path
  */
 struct mclass_params {
     size_t  fmaxsz;
     size_t  mblocksz;
     uint8_t filecnt;
+    uint8_t iobkend;
     char    path[PATH_MAX];
 };
 
@@ -185,6 +187,18 @@ mclass_gclose_get(struct media_class *mc);
 void
 mclass_io_ops_set(enum hse_mclass mclass, struct io_ops *io);
 
+/**
+ * mclass_dataio_ops_set() - set io ops for mblock data I/O on the specified mclass
+ *
+ * Selects the backend configured via storage.<mclass>.io_backend, falling back
+ * to mclass_io_ops_set() if the requested backend is not available.
+ *
+ * @mc: mclass handle
+ * @io: io_ops (output)
+ */
+void
+mclass_dataio_ops_set(struct media_class *mc, struct io_ops *io);
+
 /**
  * mclass_info_get() - get media class info
  *
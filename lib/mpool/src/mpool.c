@@ -7,6 +7,7 @@
 
 #include <limits.h>
 #include <bsd/string.h>
+#include <sys/uio.h>
 #include <sys/vfs.h>
 
 #if __linux__
@@ -29,17 +30,20 @@
 #include "mpool_internal.h"
 #include "mblock_fset.h"
 #include "mblock_file.h"
+#include "bcache.h"
 
 /**
  * struct mpool - mpool handle
  *
  * @mc:   media class handles
+ * @bc:   block cache (NULL if disabled)
  * @home: kvdb home
  *
  * [HSE_REVISIT]: Remove home member when logging is reworked
  */
 struct mpool {
     struct media_class *mc[HSE_MCLASS_COUNT];
+    struct bcache      *bc;
     const char          home[]; /* flexible array */
 };
 
@@ -354,6 +358,15 @@ mpool_open(
         if (err)
             goto errout;
 
+        mcp.iobkend = rparams->mclass[i].io_backend;
+#ifndef HAVE_LIBURING
+        if (mcp.iobkend == MPOOL_IO_URING) {
+            log_warn("io_uring backend not supported by this build, using sync I/O for mclass (%d)",
+                     i);
+            mcp.iobkend = MPOOL_IO_SYNC;
+        }
+#endif
+
         if (!rparams->mclass[i].dio_disable) {
             bool tmpfs;
 
@@ -373,6 +386,12 @@ mpool_open(
             goto errout;
     }
 
+    if (rparams->bcache_size_mb > 0) {
+        err = bcache_create((size_t)rparams->bcache_size_mb << 20, &mp->bc);
+        if (err)
+            goto errout;
+    }
+
     *handle = mp;
 
     return 0;
@@ -395,6 +414,11 @@ mpool_close(struct mpool *mp)
     if (!mp)
         return 0;
 
+    if (mp->bc) {
+        bcache_perfc_free(mp->bc);
+        bcache_destroy(mp->bc);
+    }
+
     for (i = HSE_MCLASS_COUNT - 1; i >= HSE_MCLASS_BASE; i--) {
         if (mp->mc[i]) {
             err = mclass_close(mp->mc[i]);
@@ -525,6 +549,42 @@ mpool_info_get(struct mpool *mp, struct mpool_info *info)
     return 0;
 }
 
+merr_t
+mpool_mblock_read_cached(
+    struct mpool          *mp,
+    uint64_t               mbid,
+    void                  *buf,
+    size_t                 len,
+    off_t                  off,
+    enum mpool_bcache_prio prio)
+{
+    struct iovec iov;
+
+    if (!mp || !buf)
+        return merr(EINVAL);
+
+    if (mp->bc)
+        return bcache_read(mp->bc, mp, mbid, buf, len, off, prio);
+
+    iov.iov_base = buf;
+    iov.iov_len = len;
+
+    return mpool_mblock_read(mp, mbid, &iov, 1, off);
+}
+
+bool
+mpool_bcache_enabled(struct mpool *mp)
+{
+    return mp && mp->bc;
+}
+
+void
+mpool_bcache_perfc_alloc(struct mpool *mp, const char *group, uint prio)
+{
+    if (mp && mp->bc)
+        bcache_perfc_alloc(mp->bc, group, prio);
+}
+
 struct media_class *
 mpool_mclass_handle(struct mpool *mp, enum hse_mclass mclass)
 {
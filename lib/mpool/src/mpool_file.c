@@ -58,7 +58,7 @@ mpool_file_open(
         rc = 0;
     }
 
-    flags &= (O_RDWR | O_RDONLY | O_WRONLY | O_CREAT | O_DIRECT | O_SYNC);
+    flags &= (O_RDWR | O_RDONLY | O_WRONLY | O_CREAT | O_DIRECT | O_SYNC | O_DSYNC);
     if (create)
         flags |= (O_CREAT | O_EXCL);
 
@@ -162,6 +162,31 @@ mpool_file_destroy(struct mpool *mp, enum hse_mclass mclass, const char *name)
     return 0;
 }
 
+merr_t
+mpool_file_rename(struct mpool *mp, enum hse_mclass mclass, const char *oldname, const char *newname)
+{
+    struct media_class *mc;
+    int  dirfd, rc;
+
+    if (!mp || !oldname || !newname || mclass > HSE_MCLASS_COUNT)
+        return merr(EINVAL);
+
+    mc = mpool_mclass_handle(mp, mclass);
+    if (!mc)
+        return merr(ENOENT);
+    dirfd = mclass_dirfd(mc);
+
+    rc = renameat(dirfd, oldname, dirfd, newname);
+    if (rc < 0)
+        return merr(errno);
+
+    rc = fsync(dirfd);
+    if (rc == -1)
+        return merr(errno);
+
+    return 0;
+}
+
 merr_t
 mpool_file_read(struct mpool_file *file, off_t offset, char *buf, size_t buflen, size_t *rdlen)
 {
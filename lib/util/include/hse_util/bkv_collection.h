@@ -34,6 +34,34 @@ bkv_collection_apply(struct bkv_collection *bkvc);
 merr_t
 bkv_collection_finish_pair(struct bkv_collection *bkvc1, struct bkv_collection *bkvc2);
 
+/**
+ * bkv_collection_skidx_bound() - find where a kvs' entries start
+ * @bkvc:  collection whose entries were added in key order
+ * @skidx: kvs index
+ *
+ * Return: index of the first entry whose kvs index is at least %skidx
+ */
+size_t
+bkv_collection_skidx_bound(struct bkv_collection *bkvc, uint skidx);
+
+/**
+ * bkv_collection_finish_pair_range() - merge a range of entries of two collections
+ * @bkvc1:  first collection
+ * @bkvc2:  second collection
+ * @startv: index of the first entry to merge from each collection
+ * @endv:   index one past the last entry to merge from each collection
+ * @rock:   argument passed to the callback in place of the collections' cbarg
+ *
+ * Disjoint ranges of the same pair of collections may be merged concurrently.
+ */
+merr_t
+bkv_collection_finish_pair_range(
+    struct bkv_collection *bkvc1,
+    struct bkv_collection *bkvc2,
+    const size_t           startv[static 2],
+    const size_t           endv[static 2],
+    void                  *rock);
+
 merr_t
 bkv_collection_init(void);
 
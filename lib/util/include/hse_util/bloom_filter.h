@@ -12,6 +12,12 @@
 #include <hse_util/inttypes.h>
 #include <hse_util/bitmap.h>
 
+#include <string.h>
+
+#if __ARM_NEON
+#include <arm_neon.h>
+#endif
+
 /* [HSE_REVISIT] This block bloom implementation is less of an abstraction
  * than it is a loose collection of parts from which a client may construct
  * and manage a bloom filter.  Going forward, we should endeavor to move
@@ -39,14 +45,33 @@ struct bf_bithash_desc {
     u32 bhd_num_hashes;
 };
 
+/* The partitioned, cache-line blocked bloom layout confines all the probes
+ * for a given key to one block of 2^BF_BLK_SHIFT bits, which is further
+ * divided into BF_BLK_LANES 32-bit lanes.  Each probe sets one bit in its
+ * own lane, hence at most BF_BLK_LANES probes are supported (see
+ * bf_blk_populate()).
+ */
+#define BF_BLK_SHIFT       (9)
+#define BF_BLK_BITS        (1u << BF_BLK_SHIFT)
+#define BF_BLK_BYTES       (BF_BLK_BITS >> BYTE_SHIFT)
+#define BF_BLK_LANES       (BF_BLK_BITS / 32)
+#define BF_BLK_HASHES_MAX  (BF_BLK_LANES)
+
+_Static_assert(BF_BLK_BITS == 512, "BF_BLK_BITS must match the SIMD probe width");
+
+/**
+ * struct bloom_filter -
+ * @bf_blocked: cache-line blocked layout (@bf_modulus is number of blocks)
+ */
 struct bloom_filter {
-    u8 *bf_bitmap;
-    u32 bf_bitmapsz;
-    u32 bf_modulus;
-    u32 bf_n_hashes;
-    u32 bf_bktshift;
-    u32 bf_bktmask;
-    u32 bf_rotl;
+    u8  *bf_bitmap;
+    u32  bf_bitmapsz;
+    u32  bf_modulus;
+    u32  bf_n_hashes;
+    u32  bf_bktshift;
+    u32  bf_bktmask;
+    u32  bf_rotl;
+    bool bf_blocked;
 };
 
 struct bloom_filter_stats {
@@ -158,6 +183,201 @@ bf_populate(const struct bloom_filter *bf, u64 hash)
         hse_bitmap_set32(bitmap, bf_hash2bit(&hash, rotl, mask));
 }
 
+/* Odd multipliers used to derive the probe bit index for each lane from
+ * the low 32 bits of the key hash.
+ */
+static const u32 bf_blk_saltv[BF_BLK_LANES] HSE_ALIGNED(64) = {
+    0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+    0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u,
+    0x8e1e5b4du, 0x3bd1a7e5u, 0xc2b2ae35u, 0x27d4eb2fu,
+    0x165667b1u, 0x85ebca77u, 0x9e3779b1u, 0xd6e8feb9u,
+};
+
+/**
+ * bf_blk_hash2blk() - determine byte offset of block which contains %hash
+ * @hash:   hash used to select the block
+ * @nblks:  number of blocks in the bitmap
+ *
+ * Maps the upper 32 bits of the hash onto [0, nblks) with a multiply
+ * and shift rather than a division.
+ */
+static HSE_ALWAYS_INLINE size_t
+bf_blk_hash2blk(u64 hash, u32 nblks)
+{
+    return (((hash >> 32) * nblks) >> 32) * BF_BLK_BYTES;
+}
+
+/* The n probes for a key occupy n consecutive lanes (modulo BF_BLK_LANES)
+ * starting at the lane given by hash bits 32-35, so that every lane of the
+ * block is used even when n < BF_BLK_LANES.
+ */
+static HSE_ALWAYS_INLINE u32
+bf_blk_hash2lane(u64 hash)
+{
+    return (hash >> 32) & (BF_BLK_LANES - 1);
+}
+
+/**
+ * bf_blk_pattern() - compute the block bit pattern for %hash
+ * @hash:   key hash
+ * @n:      number of probes (at most BF_BLK_HASHES_MAX)
+ * @patv:   (output) bit pattern, one little-endian word per lane
+ */
+static HSE_ALWAYS_INLINE void
+bf_blk_pattern(u64 hash, u32 n, u32 *patv)
+{
+    const u32 h = hash;
+    const u32 first = bf_blk_hash2lane(hash);
+    u32       i;
+
+    assert(n <= BF_BLK_HASHES_MAX);
+
+    for (i = 0; i < BF_BLK_LANES; ++i) {
+        u32 bit = (h * bf_blk_saltv[i]) >> 27;
+
+        patv[i] = (((i - first) & (BF_BLK_LANES - 1)) < n) ? (1u << bit) : 0;
+    }
+}
+
+/**
+ * bf_blk_test() - check whether all bits of a pattern are set in a block
+ * @blk:    base address of the block (need not be aligned)
+ * @patv:   bit pattern from bf_blk_pattern()
+ */
+static HSE_ALWAYS_INLINE bool
+bf_blk_test(const u8 *blk, const u32 *patv)
+{
+    u32 miss = 0, w;
+    int i;
+
+    for (i = 0; i < BF_BLK_LANES; ++i) {
+        memcpy(&w, blk + i * 4, sizeof(w));
+        miss |= patv[i] & ~w;
+    }
+
+    return miss == 0;
+}
+
+/**
+ * bf_blk_lookup() - check to see if hash is in a cache-line blocked bloom
+ * @hash:   key hash
+ * @bitmap: base address of the bitmap
+ * @nblks:  number of blocks in the bitmap
+ * @n:      number of probes
+ *
+ * When built for AVX2 or aarch64 NEON the probe pattern is computed and
+ * tested entirely in vector registers (eight or four lanes at a time) with
+ * no data dependent branches.  Otherwise the probes are tested one lane at
+ * a time, stopping at the first clear bit.
+ */
+static HSE_ALWAYS_INLINE bool
+bf_blk_lookup(u64 hash, const u8 *bitmap, u32 nblks, u32 n)
+{
+    const u8 *blk = bitmap + bf_blk_hash2blk(hash, nblks);
+
+#if __AVX2__
+    const __m256i hv = _mm256_set1_epi32((u32)hash);
+    const __m256i fv = _mm256_set1_epi32(bf_blk_hash2lane(hash));
+    const __m256i nv = _mm256_set1_epi32(n);
+    const __m256i lmask = _mm256_set1_epi32(BF_BLK_LANES - 1);
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i       lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    int           hit = 1;
+    int           i;
+
+    for (i = 0; i < BF_BLK_LANES / 8; ++i) {
+        __m256i salt, pat, act, b;
+
+        salt = _mm256_load_si256((const void *)(bf_blk_saltv + i * 8));
+        pat = _mm256_sllv_epi32(one, _mm256_srli_epi32(_mm256_mullo_epi32(hv, salt), 27));
+        act = _mm256_cmpgt_epi32(nv, _mm256_and_si256(_mm256_sub_epi32(lane, fv), lmask));
+        pat = _mm256_and_si256(pat, act);
+
+        b = _mm256_loadu_si256((const void *)(blk + i * 32));
+
+        /* testc yields 1 iff (~b & pat) == 0 */
+        hit &= _mm256_testc_si256(b, pat);
+
+        lane = _mm256_add_epi32(lane, _mm256_set1_epi32(8));
+    }
+
+    return hit;
+#elif __ARM_NEON && __aarch64__
+    const uint32x4_t hv = vdupq_n_u32((u32)hash);
+    const uint32x4_t fv = vdupq_n_u32(bf_blk_hash2lane(hash));
+    const uint32x4_t nv = vdupq_n_u32(n);
+    const uint32x4_t lmask = vdupq_n_u32(BF_BLK_LANES - 1);
+    const uint32x4_t one = vdupq_n_u32(1);
+    static const u32 lane0v[4] = { 0, 1, 2, 3 };
+    uint32x4_t       lane = vld1q_u32(lane0v);
+    uint32x4_t       miss = vdupq_n_u32(0);
+    int              i;
+
+    for (i = 0; i < BF_BLK_LANES / 4; ++i) {
+        uint32x4_t salt, bit, pat, act, b;
+
+        salt = vld1q_u32(bf_blk_saltv + i * 4);
+        bit = vshrq_n_u32(vmulq_u32(hv, salt), 27);
+        pat = vshlq_u32(one, vreinterpretq_s32_u32(bit));
+        act = vcltq_u32(vandq_u32(vsubq_u32(lane, fv), lmask), nv);
+        pat = vandq_u32(pat, act);
+
+        b = vreinterpretq_u32_u8(vld1q_u8(blk + i * 16));
+        miss = vorrq_u32(miss, vbicq_u32(pat, b));
+
+        lane = vaddq_u32(lane, vdupq_n_u32(4));
+    }
+
+    return vmaxvq_u32(miss) == 0;
+#else
+    const u32 h = hash;
+    u32       lane = bf_blk_hash2lane(hash);
+    u32       w;
+
+    while (n-- > 0) {
+        memcpy(&w, blk + lane * 4, sizeof(w));
+
+        if (!(w & (1u << ((h * bf_blk_saltv[lane]) >> 27))))
+            return false;
+
+        lane = (lane + 1) & (BF_BLK_LANES - 1);
+    }
+
+    return true;
+#endif
+}
+
+/**
+ * bf_blk_populate() - populate a cache-line blocked bloom with given %hash
+ * @bf:     bloom filter initialized by bf_filter_init_blocked()
+ * @hash:   key hash
+ *
+ * The upper 32 bits of the hash select a 64-byte block and the first of
+ * n consecutive lanes within it.  Each of those lanes gets the bit selected
+ * by the top five bits of the product of the lower 32 bits of the hash and
+ * the lane's salt.  Hence a lookup touches exactly one cache line, needs
+ * no division, and all n probes can be evaluated in parallel.
+ */
+static HSE_ALWAYS_INLINE void
+bf_blk_populate(const struct bloom_filter *bf, u64 hash)
+{
+    u32 patv[BF_BLK_LANES];
+    u8 *blk;
+    int i;
+
+    bf_blk_pattern(hash, bf->bf_n_hashes, patv);
+
+    blk = bf->bf_bitmap + bf_blk_hash2blk(hash, bf->bf_modulus);
+
+    for (i = 0; i < BF_BLK_LANES; ++i) {
+        u32 w;
+
+        memcpy(&w, blk + i * 4, sizeof(w));
+        w |= patv[i];
+        memcpy(blk + i * 4, &w, sizeof(w));
+    }
+}
+
 struct bf_bithash_desc
 bf_compute_bithash_est(u32 probability);
 
@@ -175,6 +395,20 @@ bf_filter_init(
     u8 *                   storage,
     size_t                 storage_sz);
 
+/**
+ * bf_filter_init_blocked() - initialize a cache-line blocked bloom filter
+ *
+ * Same as bf_filter_init() but for the layout used by bf_blk_populate().
+ * The number of hashes is capped at BF_BLK_HASHES_MAX.
+ */
+void
+bf_filter_init_blocked(
+    struct bloom_filter *  filter,
+    struct bf_bithash_desc desc,
+    u32                    exp_elmts,
+    u8 *                   storage,
+    size_t                 storage_sz);
+
 void
 bf_filter_insert_by_hash(struct bloom_filter *filter, u64 hash);
 
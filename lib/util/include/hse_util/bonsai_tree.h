@@ -31,6 +31,14 @@
 #define HSE_BT_NODESPERSLAB \
     ((HSE_BT_SLABSZ - sizeof(struct bonsai_slab)) / sizeof(struct bonsai_node))
 
+/* Skiplist (concurrent) index static config params...
+ *
+ * Towers grow with probability 1/4 per level, so sixteen levels
+ * comfortably index far more keys than a c0 kvset can hold.
+ */
+#define HSE_BT_SKIP_HEIGHT_MAX      (16)
+#define HSE_BT_SKIP_LOCKS           (64)
+
 /* Bonsai node RCU generation count special values...
  *
  * The RCU generation count is a monotonically increasing integer which marks
@@ -97,7 +105,10 @@ struct bonsai_skey {
  *
  * Note that the value length (@bv_xlen) is an opaque encoding of compressed
  * and uncompressed value lengths so one must use the bonsai_val_*len()
- * functions to decode it.
+ * functions to decode it.  The two high bits of the uncompressed length are
+ * reserved for use by the caller (e.g., to flag merge operands).  If
+ * BONSAI_XLEN_EXPIRE is set then a u32 expiry time follows the value data
+ * (see bonsai_val_expire()).
  */
 struct bonsai_val {
     uintptr_t          bv_seqnoref;
@@ -120,7 +131,7 @@ struct bonsai_val {
 static HSE_ALWAYS_INLINE uint
 bonsai_val_ulen(const struct bonsai_val *bv)
 {
-    return bv->bv_xlen & 0xfffffffful;
+    return bv->bv_xlen & 0x3ffffffful;
 }
 
 /**
@@ -151,6 +162,29 @@ bonsai_val_vlen(const struct bonsai_val *bv)
     return bonsai_val_clen(bv) ?: bonsai_val_ulen(bv);
 }
 
+#define BONSAI_XLEN_EXPIRE (1ul << 30)
+
+/**
+ * bonsai_val_expire() - return value expiry time
+ * @bv: ptr to a bonsai val
+ *
+ * bonsai_val_expire() returns the expiry time (seconds since the epoch)
+ * stored after the data of the given bonsai value, or zero if the value
+ * does not expire.
+ */
+static HSE_ALWAYS_INLINE u32
+bonsai_val_expire(const struct bonsai_val *bv)
+{
+    u32 expire;
+
+    if (!(bv->bv_xlen & BONSAI_XLEN_EXPIRE))
+        return 0;
+
+    memcpy(&expire, (const char *)bv->bv_value + bonsai_val_vlen(bv), sizeof(expire));
+
+    return expire;
+}
+
 /**
  * struct bonsai_sval - input value argument
  * @bsv_val:      pointer to value data
@@ -178,7 +212,10 @@ static HSE_ALWAYS_INLINE uint
 bonsai_sval_vlen(const struct bonsai_sval *bsv)
 {
     uint clen = bsv->bsv_xlen >> 32;
-    uint vlen = bsv->bsv_xlen & 0xfffffffful;
+    uint vlen = bsv->bsv_xlen & 0x3ffffffful;
+
+    if (bsv->bsv_xlen & BONSAI_XLEN_EXPIRE)
+        return (clen ?: vlen) + sizeof(u32);
 
     return clen ?: vlen;
 }
@@ -199,12 +236,18 @@ bonsai_sval_vlen(const struct bonsai_sval *bsv)
  * @bkv_next:       sorted key list linkage
  * @bkv_es:         user-managed element source pointer
  * @bkv_free:       free list linkage
+ * @bkv_tower:      skiplist levels 1..n-1 linkage (skiplist trees only)
  * @bkv_freevals:   list of freed values (may still be visible)
  * @bkv_keybuf:     key data (zero length if caller-managed)
  *
  * A bonsai_kv includes the key and a list of bonsai_val objects.
  * The bonsai_kv and initial bonsai_val are allocated in one chunk
  * as recorded by %bkv_allocsz.
+ *
+ * Keys are never deleted from a skiplist tree, so %bkv_free is never
+ * needed and its space holds the key's skiplist tower instead.  Note
+ * that %bkv_prev is only a hint in a skiplist tree until the tree is
+ * finalized (see bn_kv_prev()).
  */
 struct bonsai_kv {
     struct key_immediate    bkv_key_imm;
@@ -217,7 +260,10 @@ struct bonsai_kv {
     struct bonsai_kv *      bkv_next;
     struct bonsai_val      *bkv_freevals;
     struct element_source  *bkv_es;
-    struct bonsai_kv       *bkv_free;
+    union {
+        struct bonsai_kv   *bkv_free;
+        struct bonsai_kv  **bkv_tower;
+    };
     char                    bkv_keybuf[];
 };
 
@@ -312,6 +358,13 @@ struct bonsai_slabinfo {
  * This callback is invoked during insert or replace and is implemented by
  * the client.
  */
+/* struct bonsai_skip_lock - skiplist key update lock
+ * @bsl_lock:   serializes value updates to keys that hash to this lock
+ */
+struct bonsai_skip_lock {
+    spinlock_t bsl_lock;
+} HSE_L1D_ALIGNED;
+
 typedef void bonsai_ior_cb(
     void *                rock,
     enum bonsai_ior_code *code,
@@ -324,6 +377,7 @@ typedef void bonsai_ior_cb(
  * struct bonsai_root - bonsai tree parameters
  * @br_bounds:          indicates bounds are established and lcp
  * @br_magic:           used for sanity checking
+ * @br_skiplist:        tree is indexed by a concurrent skiplist
  * @br_height:          tree current max height
  * @br_root:            pointer to the root of bonsai_tree
  * @br_cheap:           ptr to cheap (or nil for malloc backed tree)
@@ -334,6 +388,10 @@ typedef void bonsai_ior_cb(
  * @br_slabbase:        ptr to base of slabs embedded in bonsai_root
  * @br_key_alloc:       total number of keys ever allocated
  * @br_val_alloc:       total number of values ever allocated
+ * @br_skip_height:     skiplist current max height
+ * @br_alloc_lock:      serializes cheap allocations (skiplist trees only)
+ * @br_skip_headv:      skiplist levels 1..n-1 head pointers
+ * @br_skip_lockv:      skiplist key update locks
  * @br_kv:              a circular k/v list, next=head, prev=tail
  * @br_gc_lock:         protects gc queues between user and rcu callback
  * @br_gc_waitq:        list of slabs waiting to get on the ready queue
@@ -349,6 +407,7 @@ typedef void bonsai_ior_cb(
 struct bonsai_root {
     atomic_int              br_bounds HSE_ACP_ALIGNED;
     uint                    br_magic;
+    bool                    br_skiplist;
     struct bonsai_node     *br_root;
     struct cheap           *br_cheap;
     bonsai_ior_cb          *br_ior_cb;
@@ -390,6 +449,15 @@ struct bonsai_root {
      */
     struct bonsai_slabinfo  br_slabinfov[8 + 2];
 
+    /* A skiplist tree doesn't use any of the node slabs, but instead links
+     * each k/v node into a tower of lists whose bottom level is br_kv.
+     */
+    atomic_int              br_skip_height HSE_L1D_ALIGNED;
+    spinlock_t              br_alloc_lock;
+    struct bonsai_kv       *br_skip_headv[HSE_BT_SKIP_HEIGHT_MAX - 1];
+
+    struct bonsai_skip_lock br_skip_lockv[HSE_BT_SKIP_LOCKS];
+
     /* br_kv must be last as it contains a flexible array member.
      */
     struct bonsai_kv        br_kv;
@@ -413,6 +481,31 @@ bn_create(
     void                *cbarg,
     struct bonsai_root **tree);
 
+/**
+ * bn_skiplist_create() - Initialize a concurrent tree and client info.
+ * @cheap:     memory allocator
+ * @cb:        insert or replace callback
+ * @rock:      per-tree rock entity for client
+ * @tree:      bonsai tree instance (output parameter)
+ *
+ * Like bn_create(), but the tree is indexed by a lock-free skiplist
+ * rather than a balanced binary tree such that bn_insert_or_replace()
+ * may be called concurrently without external serialization.  Updates
+ * to an existing key are serialized by a striped spinlock, such that
+ * the callback is never invoked concurrently for the same key (but it
+ * may be invoked concurrently for different keys).  Keys cannot be
+ * deleted from a skiplist tree.
+ *
+ * Return: 0 on success, EINVAL if @cb or @tree is NULL, ENOMEM if out
+ * of memory
+ */
+merr_t
+bn_skiplist_create(
+    struct cheap        *cheap,
+    bonsai_ior_cb       *cb,
+    void                *cbarg,
+    struct bonsai_root **tree);
+
 /**
  * bn_reset() - Resets bonsai tree.
  * @tree: bonsai tree instance
@@ -458,6 +551,8 @@ bn_insert_or_replace(
  * bn_delete() - remove and delete the given key from the tree
  * @tree: bonsai tree instance
  * @skey: bonsai_skey instance containing the key and its related info
+ *
+ * Not supported by skiplist trees.
  */
 merr_t
 bn_delete(struct bonsai_root *tree, const struct bonsai_skey *skey);
@@ -563,6 +658,22 @@ bn_summary(struct bonsai_root *tree, char *buf, size_t bufsz);
 void
 bn_finalize(struct bonsai_root *tree);
 
+/**
+ * bn_memalign() - allocate caller memory from the tree's cheap
+ * @tree:  bonsai tree instance
+ * @align: alignment
+ * @sz:    size
+ *
+ * Allocations from a skiplist tree's cheap are serialized with respect to
+ * concurrent tree updates.  Otherwise, the caller must provide the same
+ * serialization as for bn_insert_or_replace().
+ *
+ * Return: ptr to memory, or NULL if the tree isn't cheap-backed or if
+ * the cheap is exhausted
+ */
+void *
+bn_memalign(struct bonsai_root *tree, size_t align, size_t sz);
+
 /**
  * Accessor functions for bonsai client specific fields
  */
@@ -597,6 +708,31 @@ bn_sval_init(void *val, u64 xlen, uintptr_t seqnoref, struct bonsai_sval *sval)
     sval->bsv_seqnoref = seqnoref;
 }
 
+/**
+ * bn_kv_prev() - return the predecessor of the given key in the k/v list
+ * @kv: ptr to a bonsai key/value object (or the tree's br_kv list head)
+ *
+ * A skiplist tree maintains %bkv_prev only as a hint (i.e., a node that
+ * preceded %kv in the list at the time it was inserted) until the tree is
+ * finalized.  Since keys are never deleted from a skiplist tree, the true
+ * predecessor is found by walking forward from the hint.  For a balanced
+ * tree the hint is always exact.
+ *
+ * Caller must hold the rcu read lock, or the tree must be quiescent.
+ */
+static HSE_ALWAYS_INLINE struct bonsai_kv *
+bn_kv_prev(struct bonsai_kv *kv)
+{
+    struct bonsai_kv *prev, *next;
+
+    prev = rcu_dereference(kv->bkv_prev);
+
+    while (( next = rcu_dereference(prev->bkv_next) ) != kv)
+        prev = next;
+
+    return prev;
+}
+
 static inline s32
 bn_kv_cmp(const void *lhs, const void *rhs)
 {
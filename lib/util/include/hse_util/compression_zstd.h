@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+#ifndef HSE_UTIL_COMPRESS_ZSTD_H
+#define HSE_UTIL_COMPRESS_ZSTD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <hse_util/compression.h>
+
+/* Values compressed by zstd are prefixed with a one byte tag which
+ * distinguishes them from lz4 compressed values:  An lz4 block compressed
+ * from a non-empty input always starts with a sequence token that has at
+ * least one literal, hence its high nibble is never zero.
+ *
+ * COMPRESS_ZSTD_TAG       plain zstd frame
+ * COMPRESS_ZSTD_TAG_DICT  zstd frame compressed with a trained dictionary
+ */
+#define COMPRESS_ZSTD_TAG       (0x01u)
+#define COMPRESS_ZSTD_TAG_DICT  (0x02u)
+
+/* Max size of a dictionary produced by compress_zstd_dict_train().
+ */
+#define COMPRESS_ZSTD_DICT_LEN_MAX  (32 * 1024)
+
+struct compress_dict;
+
+extern struct compress_ops compress_zstd_ops;
+
+static inline bool
+compress_zstd_tagged(const void *src)
+{
+    return (*(const unsigned char *)src & 0xf0) == 0;
+}
+
+static inline bool
+compress_zstd_dict_tagged(const void *src)
+{
+    return *(const unsigned char *)src == COMPRESS_ZSTD_TAG_DICT;
+}
+
+/**
+ * compress_zstd_dict_train() - train a dictionary from a set of samples
+ * @samples:  concatenated sample buffers
+ * @samplev:  vector of sample lengths
+ * @samplec:  number of samples
+ * @dict:     output buffer for the dictionary
+ * @dictcap:  capacity of @dict
+ * @dictlen:  (output) length of the dictionary
+ *
+ * Returns ENODATA if the samples are not sufficient to train a dictionary.
+ */
+merr_t
+compress_zstd_dict_train(
+    const void   *samples,
+    const size_t *samplev,
+    uint          samplec,
+    void         *dict,
+    uint          dictcap,
+    uint         *dictlen);
+
+/**
+ * compress_zstd_dict_create() - digest a dictionary for (de)compression
+ * @dict:     dictionary content
+ * @dictlen:  length of @dict
+ * @compress: digest for compression if true, otherwise for decompression
+ * @dictp:    (output) dictionary handle
+ *
+ * The dictionary content is copied, the caller may free @dict on return.
+ */
+merr_t
+compress_zstd_dict_create(
+    const void            *dict,
+    uint                   dictlen,
+    bool                   compress,
+    struct compress_dict **dictp);
+
+void
+compress_zstd_dict_destroy(struct compress_dict *dict);
+
+/**
+ * compress_zstd_dict_compress() - compress a value with a dictionary
+ *
+ * The output is tagged with COMPRESS_ZSTD_TAG_DICT.  @dict must have
+ * been created for compression.
+ */
+merr_t
+compress_zstd_dict_compress(
+    const struct compress_dict *dict,
+    const void                 *src,
+    uint                        src_len,
+    void                       *dst,
+    uint                        dst_capacity,
+    uint                       *dst_len);
+
+/**
+ * compress_zstd_dict_decompress() - decompress a zstd tagged value
+ *
+ * Handles both plain and dictionary tagged values.  @dict may be NULL
+ * if @src is not dictionary tagged, otherwise it must be the dictionary
+ * (created for decompression) with which @src was compressed.
+ */
+merr_t
+compress_zstd_dict_decompress(
+    const struct compress_dict *dict,
+    const void                 *src,
+    uint                        src_len,
+    void                       *dst,
+    uint                        dst_capacity,
+    uint                       *dst_len);
+
+#endif
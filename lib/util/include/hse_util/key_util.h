@@ -6,6 +6,8 @@
 #ifndef HSE_KEY_UTIL_H
 #define HSE_KEY_UTIL_H
 
+#include <stdbool.h>
+
 #include <hse_util/inttypes.h>
 #include <hse_util/minmax.h>
 #include <hse_util/assert.h>
@@ -216,6 +218,21 @@ memlcp(const void *s1, const void *s2, size_t len);
 size_t
 memlcpq(const void *s1, const void *s2, size_t len);
 
+/**
+ * key_successor() - replace a key with the smallest key greater than it
+ * @key:    key buffer of at least HSE_KVS_KEY_LEN_MAX bytes
+ * @klen:   (in/out) key length
+ *
+ * A key shorter than HSE_KVS_KEY_LEN_MAX is extended by a zero byte.
+ * A key of maximum length drops its trailing 0xff bytes and increments
+ * the last remaining byte.
+ *
+ * Return: false if %key is the largest possible key, in which case
+ * neither %key nor %klen are modified.
+ */
+bool
+key_successor(void *key, uint *klen);
+
 /**
  * struct key_obj - A composite key representation with a prefix and a suffix.
  * @ko_pfx:       pointer to prefix.
@@ -6,6 +6,7 @@
 #include <hse_util/bitmap.h>
 #include <hse_util/bloom_filter.h>
 #include <hse/logging/logging.h>
+#include <hse_util/minmax.h>
 #include <hse_util/page.h>
 
 #include "bf_size2bits.i"
@@ -145,6 +146,7 @@ bf_filter_init(
     assert(IS_ALIGNED(storage_sz, PAGE_SIZE));
     assert(storage_sz >= PAGE_SIZE);
 
+    filter->bf_blocked = false;
     filter->bf_n_hashes = desc.bhd_num_hashes;
     filter->bf_bktshift = BF_BKTSHIFT;
     filter->bf_bktmask = (1u << BF_BKTSHIFT) - 1;
@@ -161,10 +163,34 @@ bf_filter_init(
     assert(filter->bf_modulus > (storage_sz - PAGE_SIZE) << BYTE_SHIFT);
 }
 
+void
+bf_filter_init_blocked(
+    struct bloom_filter *  filter,
+    struct bf_bithash_desc desc,
+    u32                    exp_elmts,
+    u8 *                   storage,
+    size_t                 storage_sz)
+{
+    assert(IS_ALIGNED(storage_sz, PAGE_SIZE));
+    assert(storage_sz >= PAGE_SIZE);
+
+    filter->bf_blocked = true;
+    filter->bf_n_hashes = min_t(u32, desc.bhd_num_hashes, BF_BLK_HASHES_MAX);
+    filter->bf_bktshift = BF_BLK_SHIFT;
+    filter->bf_bktmask = BF_BLK_BITS - 1;
+    filter->bf_rotl = 0;
+    filter->bf_bitmap = storage;
+    filter->bf_bitmapsz = storage_sz;
+    filter->bf_modulus = storage_sz / BF_BLK_BYTES;
+}
+
 void
 bf_filter_insert_by_hash(struct bloom_filter *bf, u64 hash)
 {
-    bf_populate(bf, hash);
+    if (bf->bf_blocked)
+        bf_blk_populate(bf, hash);
+    else
+        bf_populate(bf, hash);
 }
 
 void
@@ -172,6 +198,12 @@ bf_filter_insert_by_hashv(struct bloom_filter *bf, u64 *keyv, u32 keyc)
 {
     int i;
 
+    if (bf->bf_blocked) {
+        for (i = 0; i < keyc; ++i)
+            bf_blk_populate(bf, keyv[i]);
+        return;
+    }
+
     for (i = 0; i < keyc; ++i)
         bf_populate(bf, keyv[i]);
 }
@@ -4,6 +4,7 @@
  */
 
 #include <hse_util/log2.h>
+#include <hse_util/xrand.h>
 #include <hse/logging/logging.h>
 
 #include "bonsai_tree_pvt.h"
@@ -380,6 +381,282 @@ bn_delete_impl(
     return 0;
 }
 
+/* A skiplist tree links each key into a tower of singly linked sorted
+ * lists, the bottom of which is the circular br_kv list shared with
+ * balanced trees (levels above zero are nil terminated).  A new key is
+ * published by a single compare-and-swap at level zero, after which it
+ * is linked into the upper levels one level at a time.  Keys are never
+ * removed, so a node once found remains a valid predecessor forever,
+ * which is what allows both searches and inserts to proceed without
+ * a tree-wide lock.
+ */
+static HSE_ALWAYS_INLINE struct bonsai_kv **
+bn_skip_nextp(struct bonsai_kv *kv, int level)
+{
+    return (level > 0) ? kv->bkv_tower + level - 1 : &kv->bkv_next;
+}
+
+static HSE_ALWAYS_INLINE bool
+bn_skip_end(struct bonsai_root *tree, const struct bonsai_kv *kv)
+{
+    return !kv || kv == &tree->br_kv;
+}
+
+static HSE_ALWAYS_INLINE spinlock_t *
+bn_skip_lock(struct bonsai_root *tree, const struct bonsai_kv *kv)
+{
+    return &tree->br_skip_lockv[((uintptr_t)kv >> 6) % HSE_BT_SKIP_LOCKS].bsl_lock;
+}
+
+static uint
+bn_skip_height_rand(void)
+{
+    uint64_t r = xrand64_tls();
+    uint height = 1;
+
+    while ((r & 3) == 0 && height < HSE_BT_SKIP_HEIGHT_MAX) {
+        r >>= 2;
+        ++height;
+    }
+
+    return height;
+}
+
+/* Find the predecessor and successor of the given key at each level,
+ * and return the key's node if it's in the tree.
+ */
+static struct bonsai_kv *
+bn_skip_search(
+    struct bonsai_root       *tree,
+    const struct bonsai_skey *skey,
+    struct bonsai_kv         *predv[static HSE_BT_SKIP_HEIGHT_MAX],
+    struct bonsai_kv         *succv[static HSE_BT_SKIP_HEIGHT_MAX])
+{
+    const struct key_immediate *ki = &skey->bsk_key_imm;
+    const void *key = skey->bsk_key;
+    struct bonsai_kv *pred, *next;
+    int height, level;
+    s32 res = 1;
+
+    pred = &tree->br_kv;
+    height = atomic_read_acq(&tree->br_skip_height);
+
+    /* Levels above the current height are presumed empty, which is
+     * verified by the compare-and-swap should we insert at them.
+     */
+    for (level = HSE_BT_SKIP_HEIGHT_MAX - 1; level >= height; --level) {
+        predv[level] = pred;
+        succv[level] = NULL;
+    }
+
+    for (; level >= 0; --level) {
+        while (1) {
+            next = rcu_dereference(*bn_skip_nextp(pred, level));
+            if (bn_skip_end(tree, next)) {
+                res = 1;
+                break;
+            }
+
+            res = key_full_cmp(ki, key, &next->bkv_key_imm, next->bkv_key);
+            if (res <= 0)
+                break;
+
+            pred = next;
+        }
+
+        predv[level] = pred;
+        succv[level] = next;
+    }
+
+    return (res == 0) ? succv[0] : NULL;
+}
+
+static struct bonsai_kv *
+bn_skip_find(struct bonsai_root *tree, const struct bonsai_skey *skey, enum bonsai_match_type mtype)
+{
+    struct bonsai_kv *predv[HSE_BT_SKIP_HEIGHT_MAX];
+    struct bonsai_kv *succv[HSE_BT_SKIP_HEIGHT_MAX];
+    struct bonsai_kv *kv;
+
+    kv = bn_skip_search(tree, skey, predv, succv);
+    if (kv || mtype == B_MATCH_EQ)
+        return kv;
+
+    if (mtype == B_MATCH_GE)
+        return bn_skip_end(tree, succv[0]) ? NULL : succv[0];
+
+    return bn_skip_end(tree, predv[0]) ? NULL : predv[0];
+}
+
+/* Find the smallest key whose prefix of the search key's length is
+ * greater than the search key (GT), or the largest key whose prefix
+ * is less than or equal to it (LT).  Prefix order is monotonic in the
+ * full key order, so this is simply a search for the last key whose
+ * prefix is not greater than the search key.
+ */
+static struct bonsai_kv *
+bn_skip_find_pfx(
+    struct bonsai_root       *tree,
+    const struct bonsai_skey *skey,
+    enum bonsai_match_type    mtype)
+{
+    const struct key_immediate *ki = &skey->bsk_key_imm;
+    const void *key = skey->bsk_key;
+    struct bonsai_kv *pred, *next;
+    u32 skidx = key_immediate_index(ki);
+    uint klen = key_imm_klen(ki);
+    int level;
+    s32 res;
+
+    pred = &tree->br_kv;
+    next = NULL;
+
+    for (level = atomic_read_acq(&tree->br_skip_height) - 1; level >= 0; --level) {
+        while (1) {
+            next = rcu_dereference(*bn_skip_nextp(pred, level));
+            if (bn_skip_end(tree, next))
+                break;
+
+            res = skidx - key_immediate_index(&next->bkv_key_imm);
+            if (res == 0)
+                res = key_inner_cmp(key, klen, next->bkv_key,
+                                    min_t(uint, klen, key_imm_klen(&next->bkv_key_imm)));
+            if (res < 0)
+                break;
+
+            pred = next;
+        }
+    }
+
+    if (mtype == B_MATCH_GT)
+        return bn_skip_end(tree, next) ? NULL : next;
+
+    return bn_skip_end(tree, pred) ? NULL : pred;
+}
+
+static merr_t
+bn_skip_ior(struct bonsai_root *tree, const struct bonsai_skey *skey, struct bonsai_sval *sval)
+{
+    struct bonsai_kv *predv[HSE_BT_SKIP_HEIGHT_MAX];
+    struct bonsai_kv *succv[HSE_BT_SKIP_HEIGHT_MAX];
+    struct bonsai_kv *kv, *nkv = NULL;
+    enum bonsai_ior_code code;
+    spinlock_t *lock;
+    uint height = 0;
+    int cur, i;
+    merr_t err;
+
+again:
+    kv = bn_skip_search(tree, skey, predv, succv);
+    if (kv) {
+        struct bonsai_val *oldv = NULL, *v = NULL;
+
+        /* If we lost a race to insert this key then reclaim the node
+         * we allocated, reusing its embedded value if possible.
+         */
+        if (nkv)
+            v = bn_kv_reclaim(tree, nkv);
+
+        if (!v) {
+            v = bn_val_alloc(tree, sval, skey->bsk_flags & HSE_BTF_MANAGED);
+            if (!v)
+                return merr(ENOMEM);
+        }
+
+        SET_IOR_REPORADD(code);
+
+        lock = bn_skip_lock(tree, kv);
+        spin_lock(lock);
+        tree->br_ior_cb(tree->br_ior_cbarg, &code, kv, v, &oldv,
+                        atomic_read(&tree->br_skip_height));
+
+        if (oldv)
+            bn_val_rcufree(kv, oldv);
+        spin_unlock(lock);
+
+        sval->bsv_seqnoref = v->bv_seqnoref;
+
+        return 0;
+    }
+
+    if (!nkv) {
+        height = bn_skip_height_rand();
+
+        err = bn_kv_alloc(tree, skey, sval, height, &nkv);
+        if (err)
+            return err;
+    }
+
+    for (i = 0; i < height; ++i)
+        *bn_skip_nextp(nkv, i) = succv[i];
+
+    nkv->bkv_prev = predv[0];
+
+    /* Acquire the new key's update lock before it becomes visible so
+     * that no other thread can add a value to it until the callback
+     * has initialized it.
+     */
+    lock = bn_skip_lock(tree, nkv);
+    spin_lock(lock);
+
+    if (rcu_cmpxchg_pointer(&predv[0]->bkv_next, succv[0], nkv) != succv[0]) {
+        spin_unlock(lock);
+        goto again;
+    }
+
+    /* The successor's prev ptr is only a hint, so failure here simply
+     * means a more recent insert already updated it.
+     */
+    (void)rcu_cmpxchg_pointer(&succv[0]->bkv_prev, predv[0], nkv);
+
+    SET_IOR_INS(code);
+    tree->br_ior_cb(tree->br_ior_cbarg, &code, nkv, NULL, NULL,
+                    atomic_read(&tree->br_skip_height));
+
+    sval->bsv_seqnoref = rcu_dereference(nkv->bkv_values)->bv_seqnoref;
+    spin_unlock(lock);
+
+    /* Now link the new key into the upper levels, advancing past any
+     * keys concurrently inserted after the search.
+     */
+    for (i = 1; i < height; ++i) {
+        struct bonsai_kv *pred = predv[i], *succ = succv[i];
+
+        while (rcu_cmpxchg_pointer(bn_skip_nextp(pred, i), succ, nkv) != succ) {
+            while (1) {
+                succ = rcu_dereference(*bn_skip_nextp(pred, i));
+                if (bn_skip_end(tree, succ) || bn_kv_cmp(nkv, succ) < 0)
+                    break;
+
+                pred = succ;
+            }
+
+            *bn_skip_nextp(nkv, i) = succ;
+        }
+    }
+
+    cur = atomic_read(&tree->br_skip_height);
+
+    while (cur < height && !atomic_cmpxchg(&tree->br_skip_height, &cur, height))
+        continue;
+
+    return 0;
+}
+
+/* Replace the prev hint in each key with its true predecessor.
+ */
+static void
+bn_skip_finalize(struct bonsai_root *tree)
+{
+    struct bonsai_kv *prev = &tree->br_kv, *kv;
+
+    do {
+        kv = prev->bkv_next;
+        kv->bkv_prev = prev;
+        prev = kv;
+    } while (kv != &tree->br_kv);
+}
+
 static inline struct bonsai_kv *
 bn_find_next_pfx(struct bonsai_root *tree, const struct bonsai_skey *skey, enum bonsai_match_type mtype)
 {
@@ -394,6 +671,9 @@ bn_find_next_pfx(struct bonsai_root *tree, const struct bonsai_skey *skey, enum
 
     /* [HSE_REVISIT] Optimize using lcp */
 
+    if (tree->br_skiplist)
+        return bn_skip_find_pfx(tree, skey, mtype);
+
     ki = &skey->bsk_key_imm;
     key = skey->bsk_key;
     klen = key_imm_klen(ki);
@@ -487,6 +767,9 @@ bn_find_impl(struct bonsai_root *tree, const struct bonsai_skey *skey, enum bons
     }
 
 search:
+    if (tree->br_skiplist)
+        return bn_skip_find(tree, skey, mtype);
+
     node = rcu_dereference(tree->br_root);
     node_le = node_ge = NULL;
 
@@ -537,6 +820,9 @@ bn_insert_or_replace(
     if (atomic_read(&tree->br_bounds))
         return merr(ENOMEM);
 
+    if (tree->br_skiplist)
+        return bn_skip_ior(tree, skey, sval);
+
     newroot = bn_ior_impl(tree, skey, sval);
     if (!newroot)
         return merr(ENOMEM);
@@ -561,6 +847,9 @@ bn_delete(
     if (atomic_read(&tree->br_bounds))
         return merr(ENOMEM);
 
+    if (tree->br_skiplist)
+        return merr(EINVAL);
+
     err = bn_delete_impl(tree, skey, &newroot);
     if (err)
         return err;
@@ -673,6 +962,9 @@ bn_finalize(struct bonsai_root *tree)
     const struct bonsai_kv *kmin, *kmax;
     uint                    lcp, set_lcp = 0;
 
+    if (tree->br_skiplist)
+        bn_skip_finalize(tree);
+
     kmin = rcu_dereference(tree->br_kv.bkv_next);
     kmax = rcu_dereference(tree->br_kv.bkv_prev);
 
@@ -720,10 +1012,14 @@ bn_reset_impl(struct bonsai_root *tree)
         bn_kv_free(kv);
     }
 
+    if (tree->br_skiplist)
+        bn_skip_finalize(tree);
+
     tree->br_kv.bkv_prev->bkv_next = NULL;
 
     while (( kv = tree->br_kv.bkv_next )) {
         tree->br_kv.bkv_next = kv->bkv_next;
+        kv->bkv_free = NULL; /* clobber bkv_tower */
         bn_kv_free(kv);
     }
 
@@ -778,6 +1074,13 @@ bn_reset(struct bonsai_root *tree)
 
     tree->br_kv.bkv_prev = &tree->br_kv;
     tree->br_kv.bkv_next = &tree->br_kv;
+    tree->br_kv.bkv_tower = tree->br_skip_headv;
+
+    atomic_set(&tree->br_skip_height, 1);
+    spin_lock_init(&tree->br_alloc_lock);
+
+    for (int i = 0; i < NELEM(tree->br_skip_lockv); ++i)
+        spin_lock_init(&tree->br_skip_lockv[i].bsl_lock);
 
     spin_lock_init(&tree->br_gc_lock);
     atomic_set(&tree->br_gc_rcugen_start, 1);
@@ -804,11 +1107,12 @@ bn_reset(struct bonsai_root *tree)
     rcu_assign_pointer(tree->br_root, NULL);
 }
 
-merr_t
-bn_create(
+static merr_t
+bn_create_impl(
     struct cheap        *cheap,
     bonsai_ior_cb        cb,
     void                *cbarg,
+    bool                 skiplist,
     struct bonsai_root **tree)
 {
     struct bonsai_root *r;
@@ -835,6 +1139,7 @@ bn_create(
     r->br_cheap = cheap;
     r->br_ior_cb = cb;
     r->br_ior_cbarg = cbarg;
+    r->br_skiplist = skiplist;
     r->br_slabbase = (r + 1);
     r->br_slabbase = PTR_ALIGN(r->br_slabbase, PAGE_SIZE);
     r->br_magic = (uint)(uintptr_t)r;
@@ -846,6 +1151,26 @@ bn_create(
     return 0;
 }
 
+merr_t
+bn_create(
+    struct cheap        *cheap,
+    bonsai_ior_cb        cb,
+    void                *cbarg,
+    struct bonsai_root **tree)
+{
+    return bn_create_impl(cheap, cb, cbarg, false, tree);
+}
+
+merr_t
+bn_skiplist_create(
+    struct cheap        *cheap,
+    bonsai_ior_cb        cb,
+    void                *cbarg,
+    struct bonsai_root **tree)
+{
+    return bn_create_impl(cheap, cb, cbarg, true, tree);
+}
+
 void
 bn_destroy(struct bonsai_root *tree)
 {
@@ -41,8 +41,38 @@ bn_kvnode_alloc(
     const struct bonsai_skey *skey,
     const struct bonsai_sval *sval);
 
+/**
+ * bn_kv_alloc() - allocate and initialize a key plus value
+ * @tree:    bonsai tree instance
+ * @skey:
+ * @sval:
+ * @height:  skiplist tower height (1 if none)
+ * @kv_out:  new key/value object (output parameter)
+ *
+ * Return: 0 on success, ENOMEM if out of memory
+ */
+merr_t
+bn_kv_alloc(
+    struct bonsai_root        *tree,
+    const struct bonsai_skey  *skey,
+    const struct bonsai_sval  *sval,
+    uint                       height,
+    struct bonsai_kv         **kv_out);
+
 void bn_kv_free(struct bonsai_kv *freekeys);
 
+/**
+ * bn_kv_reclaim() - reclaim a skiplist kv that was never inserted
+ * @tree:  bonsai tree instance
+ * @kv:    kv allocated by bn_kv_alloc() but never made visible
+ *
+ * Return: The kv's embedded value (already initialized from the sval
+ * given to bn_kv_alloc()) if it may be added to another key, otherwise
+ * NULL after the kv has been freed.
+ */
+struct bonsai_val *
+bn_kv_reclaim(struct bonsai_root *tree, struct bonsai_kv *kv);
+
 /**
  * bn_val_alloc() - allocate and initialize a value
  * @tree:       bonsai tree instance
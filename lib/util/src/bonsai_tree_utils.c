@@ -350,12 +350,47 @@ bn_node_alloc(struct bonsai_root *tree, int height, uint skidx)
 }
 
 static void *
-bn_alloc(struct bonsai_root *tree, size_t sz)
+bn_alloc(struct bonsai_root *tree, size_t sz, ulong *allocp)
 {
-    if (tree->br_cheap)
-        return cheap_malloc(tree->br_cheap, sz);
+    void *mem;
 
-    return malloc(sz);
+    /* Concurrent updates to a skiplist tree must serialize their use
+     * of the cheap (and the allocation stats), but otherwise needn't
+     * synchronize with each other.
+     */
+    if (tree->br_skiplist) {
+        spin_lock(&tree->br_alloc_lock);
+        mem = tree->br_cheap ? cheap_malloc(tree->br_cheap, sz) : malloc(sz);
+        if (mem)
+            ++*allocp;
+        spin_unlock(&tree->br_alloc_lock);
+
+        return mem;
+    }
+
+    mem = tree->br_cheap ? cheap_malloc(tree->br_cheap, sz) : malloc(sz);
+    if (mem)
+        ++*allocp;
+
+    return mem;
+}
+
+void *
+bn_memalign(struct bonsai_root *tree, size_t align, size_t sz)
+{
+    void *mem;
+
+    if (!tree->br_cheap)
+        return NULL;
+
+    if (!tree->br_skiplist)
+        return cheap_memalign(tree->br_cheap, align, sz);
+
+    spin_lock(&tree->br_alloc_lock);
+    mem = cheap_memalign(tree->br_cheap, align, sz);
+    spin_unlock(&tree->br_alloc_lock);
+
+    return mem;
 }
 
 static struct bonsai_val *
@@ -385,11 +420,9 @@ bn_val_alloc(struct bonsai_root *tree, const struct bonsai_sval *sval, bool mana
     if (!managed)
         sz += bonsai_sval_vlen(sval);
 
-    v = bn_alloc(tree, sz);
-    if (v) {
+    v = bn_alloc(tree, sz, &tree->br_val_alloc);
+    if (v)
         v = bn_val_init(v, sval, sz);
-        tree->br_val_alloc++;
-    }
 
     return v;
 }
@@ -434,16 +467,17 @@ bn_kv_free(struct bonsai_kv *kvlist)
     }
 }
 
-static merr_t
+merr_t
 bn_kv_alloc(
     struct bonsai_root        *tree,
     const struct bonsai_skey  *skey,
     const struct bonsai_sval  *sval,
+    uint                       height,
     struct bonsai_kv         **kv_out)
 {
     struct bonsai_val *v;
     struct bonsai_kv *kv;
-    size_t ksz, vsz;
+    size_t ksz, vsz, tsz, toffset;
     bool managed;
     u16 voffset;
 
@@ -458,7 +492,12 @@ bn_kv_alloc(
 
     voffset = roundup(ksz, sizeof(uintptr_t));
 
-    kv = bn_alloc(tree, voffset + vsz);
+    /* A skiplist tower (if any) follows the embedded value.
+     */
+    toffset = voffset + roundup(vsz, sizeof(uintptr_t));
+    tsz = (height - 1) * sizeof(kv->bkv_tower[0]);
+
+    kv = bn_alloc(tree, toffset + tsz, &tree->br_key_alloc);
     if (!kv)
         return merr(ENOMEM);
 
@@ -475,13 +514,40 @@ bn_kv_alloc(
     v = (void *)kv + voffset;
     kv->bkv_values = bn_val_init(v, sval, vsz);
 
-    tree->br_key_alloc++;
+    if (tsz > 0)
+        kv->bkv_tower = (void *)kv + toffset;
 
     *kv_out = kv;
 
     return 0;
 }
 
+struct bonsai_val *
+bn_kv_reclaim(struct bonsai_root *tree, struct bonsai_kv *kv)
+{
+    struct bonsai_val *v = (void *)kv + kv->bkv_voffset;
+
+    assert(tree->br_skiplist);
+
+    spin_lock(&tree->br_alloc_lock);
+    --tree->br_key_alloc;
+
+    /* A value embedded in a kv can be put on another kv's list only if
+     * values are never freed individually (i.e., the tree uses a cheap).
+     */
+    if (tree->br_cheap) {
+        ++tree->br_val_alloc;
+        spin_unlock(&tree->br_alloc_lock);
+
+        return v;
+    }
+
+    spin_unlock(&tree->br_alloc_lock);
+    free(kv);
+
+    return NULL;
+}
+
 static struct bonsai_node *
 bn_node_make(
     struct bonsai_root *        tree,
@@ -516,7 +582,7 @@ bn_kvnode_alloc(
     struct bonsai_kv *kv = NULL;
     merr_t err;
 
-    err = bn_kv_alloc(tree, skey, sval, &kv);
+    err = bn_kv_alloc(tree, skey, sval, 1, &kv);
     if (err)
         return NULL;
 
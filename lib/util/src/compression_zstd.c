@@ -0,0 +1,355 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <pthread.h>
+
+#include <zstd.h>
+#include <zdict.h>
+
+#include <hse_util/assert.h>
+#include <hse_util/alloc.h>
+#include <hse_util/event_counter.h>
+#include <hse_util/compression_zstd.h>
+#include <hse/logging/logging.h>
+
+#if ZSTD_VERSION_NUMBER < (10000 + 400 + 0)
+#error "Need zstd 1.4.0 or higher"
+#endif
+
+/* Values are compressed at ingest time in the caller's context, so use the
+ * fastest regular level.  Dictionaries are only used by compaction, which
+ * can afford to spend more cycles on a better ratio.
+ */
+#define COMPRESS_ZSTD_LEVEL       (1)
+#define COMPRESS_ZSTD_DICT_LEVEL  (3)
+
+struct compress_dict {
+    ZSTD_CDict *cd_cdict;
+    ZSTD_DDict *cd_ddict;
+};
+
+/**
+ * struct zstd_tls - per-thread zstd contexts
+ *
+ * @cctx:  compression context
+ * @dctx:  decompression context
+ */
+struct zstd_tls {
+    ZSTD_CCtx *cctx;
+    ZSTD_DCtx *dctx;
+};
+
+static thread_local struct zstd_tls zstd_tls;
+
+static pthread_once_t zstd_once = PTHREAD_ONCE_INIT;
+static pthread_key_t  zstd_key;
+
+/* Runs at exit of every thread that created a zstd context.  A level 1
+ * compression context carries several hundred KiB of match state, so
+ * leaking one per exited worker thread adds up quickly.  pthreads calls
+ * this only for a non-NULL key value, and ZSTD_free[CD]Ctx() accept NULL,
+ * so a thread that only compressed or only decompressed needs no special
+ * handling.
+ */
+static void
+zstd_tls_dtor(void *arg)
+{
+    struct zstd_tls *tls = arg;
+
+    ZSTD_freeCCtx(tls->cctx);
+    ZSTD_freeDCtx(tls->dctx);
+    tls->cctx = NULL;
+    tls->dctx = NULL;
+}
+
+static void
+zstd_once_init(void)
+{
+    int rc HSE_MAYBE_UNUSED;
+
+    rc = pthread_key_create(&zstd_key, zstd_tls_dtor);
+    assert(rc == 0);
+}
+
+static void
+zstd_tls_register(struct zstd_tls *tls)
+{
+    /* Both contexts share one key, set it when the first of them is made */
+    if (!tls->cctx && !tls->dctx) {
+        pthread_once(&zstd_once, zstd_once_init);
+        pthread_setspecific(zstd_key, tls);
+    }
+}
+
+static ZSTD_CCtx *
+zstd_cctx_get(void)
+{
+    struct zstd_tls *tls = &zstd_tls;
+
+    if (HSE_UNLIKELY(!tls->cctx)) {
+        zstd_tls_register(tls);
+        tls->cctx = ZSTD_createCCtx();
+    }
+
+    return tls->cctx;
+}
+
+static ZSTD_DCtx *
+zstd_dctx_get(void)
+{
+    struct zstd_tls *tls = &zstd_tls;
+
+    if (HSE_UNLIKELY(!tls->dctx)) {
+        zstd_tls_register(tls);
+        tls->dctx = ZSTD_createDCtx();
+    }
+
+    return tls->dctx;
+}
+
+static
+uint
+compress_zstd_estimate(
+    const void *data,
+    uint        len)
+{
+    if (!len)
+        return 0;
+
+    return ZSTD_compressBound(len) + 1;
+}
+
+static merr_t
+compress_zstd_compress_impl(
+    const struct compress_dict *dict,
+    const void                 *src,
+    uint                        src_len,
+    void                       *dst,
+    uint                        dst_capacity,
+    uint                       *dst_len)
+{
+    ZSTD_CCtx *cctx;
+    size_t len;
+
+    assert(src && dst && dst_len);
+    assert(src_len && dst_capacity);
+
+    *dst_len = 0;
+
+    if (dst_capacity < 2)
+        return merr(EFBIG);
+
+    cctx = zstd_cctx_get();
+    if (ev(!cctx))
+        return merr(ENOMEM);
+
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+
+    /* The value length is recorded in the kvset/c0 metadata, so there's
+     * no need to spend header bytes on the content size or dictionary ID.
+     */
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_contentSizeFlag, 0);
+    ZSTD_CCtx_setParameter(cctx, ZSTD_c_dictIDFlag, 0);
+
+    if (dict)
+        ZSTD_CCtx_refCDict(cctx, dict->cd_cdict);
+    else
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, COMPRESS_ZSTD_LEVEL);
+
+    len = ZSTD_compress2(cctx, dst + 1, dst_capacity - 1, src, src_len);
+    if (ZSTD_isError(len))
+        return merr(EFBIG);
+
+    *(unsigned char *)dst = dict ? COMPRESS_ZSTD_TAG_DICT : COMPRESS_ZSTD_TAG;
+    *dst_len = len + 1;
+
+    return 0;
+}
+
+static
+merr_t
+compress_zstd_compress(
+    const void *src,
+    uint        src_len,
+    void       *dst,
+    uint        dst_capacity,
+    uint       *dst_len)
+{
+    return compress_zstd_compress_impl(NULL, src, src_len, dst, dst_capacity, dst_len);
+}
+
+merr_t
+compress_zstd_dict_decompress(
+    const struct compress_dict *dict,
+    const void                 *src,
+    uint                        src_len,
+    void                       *dst,
+    uint                        dst_capacity,
+    uint                       *dst_len)
+{
+    ZSTD_inBuffer  in;
+    ZSTD_outBuffer out;
+    ZSTD_DCtx *dctx;
+    size_t rc;
+
+    assert(src && dst && dst_len);
+    assert(src_len && dst_capacity);
+
+    switch (*(const unsigned char *)src) {
+        case COMPRESS_ZSTD_TAG:
+            dict = NULL;
+            break;
+
+        case COMPRESS_ZSTD_TAG_DICT:
+            if (ev(!dict || !dict->cd_ddict))
+                return merr(EPROTO);
+            break;
+
+        default:
+            return merr(EPROTO);
+    }
+
+    dctx = zstd_dctx_get();
+    if (ev(!dctx))
+        return merr(ENOMEM);
+
+    ZSTD_DCtx_reset(dctx, ZSTD_reset_session_and_parameters);
+
+    if (dict)
+        ZSTD_DCtx_refDDict(dctx, dict->cd_ddict);
+
+    in.src = src + 1;
+    in.size = src_len - 1;
+    in.pos = 0;
+
+    out.dst = dst;
+    out.size = dst_capacity;
+    out.pos = 0;
+
+    /* Stream rather than decompress in one shot so that, as with lz4,
+     * the caller may ask for just the leading part of the value.
+     */
+    while (1) {
+        size_t ipos = in.pos, opos = out.pos;
+
+        rc = ZSTD_decompressStream(dctx, &out, &in);
+        if (!ZSTD_isError(rc) && (rc == 0 || out.pos == out.size))
+            break;
+
+        /* An error or a lack of progress means the value is corrupt.
+         */
+        if (HSE_UNLIKELY(ZSTD_isError(rc) || (in.pos == ipos && out.pos == opos))) {
+            log_err("slen %u, cap %u, src %p, dst %p, ver %s: %s",
+                    src_len, dst_capacity, src, dst, ZSTD_versionString(),
+                    ZSTD_isError(rc) ? ZSTD_getErrorName(rc) : "truncated");
+
+            return merr(EFBIG);
+        }
+    }
+
+    *dst_len = out.pos;
+
+    return 0;
+}
+
+static
+merr_t
+compress_zstd_decompress(
+    const void *src,
+    uint        src_len,
+    void       *dst,
+    uint        dst_capacity,
+    uint       *dst_len)
+{
+    return compress_zstd_dict_decompress(NULL, src, src_len, dst, dst_capacity, dst_len);
+}
+
+merr_t
+compress_zstd_dict_train(
+    const void   *samples,
+    const size_t *samplev,
+    uint          samplec,
+    void         *dict,
+    uint          dictcap,
+    uint         *dictlen)
+{
+    size_t len;
+
+    if (ev(!samples || !samplev || !dict || !dictcap || !dictlen))
+        return merr(EINVAL);
+
+    len = ZDICT_trainFromBuffer(dict, dictcap, samples, samplev, samplec);
+    if (ZDICT_isError(len)) {
+        log_debug("samples %u, cap %u: %s", samplec, dictcap, ZDICT_getErrorName(len));
+        return merr(ENODATA);
+    }
+
+    *dictlen = len;
+
+    return 0;
+}
+
+merr_t
+compress_zstd_dict_create(
+    const void            *dict,
+    uint                   dictlen,
+    bool                   compress,
+    struct compress_dict **dictp)
+{
+    struct compress_dict *cd;
+
+    if (ev(!dict || !dictlen || !dictp))
+        return merr(EINVAL);
+
+    cd = calloc(1, sizeof(*cd));
+    if (ev(!cd))
+        return merr(ENOMEM);
+
+    if (compress)
+        cd->cd_cdict = ZSTD_createCDict(dict, dictlen, COMPRESS_ZSTD_DICT_LEVEL);
+    else
+        cd->cd_ddict = ZSTD_createDDict(dict, dictlen);
+
+    if (ev(!cd->cd_cdict && !cd->cd_ddict)) {
+        free(cd);
+        return merr(ENOMEM);
+    }
+
+    *dictp = cd;
+
+    return 0;
+}
+
+void
+compress_zstd_dict_destroy(struct compress_dict *dict)
+{
+    if (!dict)
+        return;
+
+    ZSTD_freeCDict(dict->cd_cdict);
+    ZSTD_freeDDict(dict->cd_ddict);
+    free(dict);
+}
+
+merr_t
+compress_zstd_dict_compress(
+    const struct compress_dict *dict,
+    const void                 *src,
+    uint                        src_len,
+    void                       *dst,
+    uint                        dst_capacity,
+    uint                       *dst_len)
+{
+    if (ev(!dict || !dict->cd_cdict))
+        return merr(EINVAL);
+
+    return compress_zstd_compress_impl(dict, src, src_len, dst, dst_capacity, dst_len);
+}
+
+struct compress_ops compress_zstd_ops HSE_READ_MOSTLY = {
+    .cop_estimate   = compress_zstd_estimate,
+    .cop_compress   = compress_zstd_compress,
+    .cop_decompress = compress_zstd_decompress,
+};
@@ -94,3 +94,27 @@ key_disc_cmp(const struct key_disc *lhs, const struct key_disc *rhs)
 
     return 0;
 }
+
+bool
+key_successor(void *key, uint *klen)
+{
+    uint8_t *kdata = key;
+    uint len = *klen;
+
+    if (len < HSE_KVS_KEY_LEN_MAX) {
+        kdata[len] = 0;
+        *klen = len + 1;
+        return true;
+    }
+
+    while (len > 0 && kdata[len - 1] == UINT8_MAX)
+        len--;
+
+    if (len == 0)
+        return false;
+
+    kdata[len - 1]++;
+    *klen = len;
+
+    return true;
+}
@@ -6,9 +6,11 @@
 #define MTF_MOCK_IMPL_wal
 
 #include <hse/error/merr.h>
+#include <hse/kvdb_perfc.h>
 #include <hse_util/bonsai_tree.h>
 #include <hse_util/event_counter.h>
 #include <hse_util/log2.h>
+#include <hse_util/perfc.h>
 
 #include <hse_ikvdb/ikvdb.h>
 #include <hse_ikvdb/kvs.h>
@@ -25,6 +27,7 @@
 #include "wal.h"
 #include "wal_buffer.h"
 #include "wal_file.h"
+#include "wal_gc.h"
 #include "wal_omf.h"
 #include "wal_mdc.h"
 #include "wal_replay.h"
@@ -48,6 +51,8 @@ struct wal {
     struct mutex     sync_mutex HSE_L1D_ALIGNED;
     struct list_head sync_waiters;
     struct cv        sync_cv;
+    bool             gc_leader;
+    struct wal_gc    gc;
 
     struct mutex timer_mutex HSE_L1D_ALIGNED;
     bool         sync_pending;
@@ -69,6 +74,8 @@ struct wal {
     uint32_t   version;
     bool       buf_managed;
     uint32_t   buf_flags;
+    bool       gc_enable;
+    struct perfc_set gc_pc;
     struct kvdb_health *health;
     struct ikvdb *ikvdb;
     struct wal_iocb wiocb;
@@ -77,14 +84,24 @@ struct wal {
 struct wal_sync_waiter {
     struct list_head ws_link;
     merr_t           ws_err;
+    bool             ws_flushed;
     uint32_t         ws_bufcnt;
     uint64_t         ws_offv[WAL_BUF_MAX];
+    uint64_t         ws_start;
     struct cv        ws_cv;
 };
 
 
 #define recoverable_error(rc)  (rc == EAGAIN || rc == ECANCELED)
 
+struct perfc_name wal_perfc[] _dt_section = {
+    NE(PERFC_RA_WAL_GC_COMMIT, 2, "WAL group commit rate",          "r_gc_commit(/s)"),
+    NE(PERFC_DI_WAL_GC_BATCH,  2, "WAL syncs per group commit",     "d_gc_batch"),
+    NE(PERFC_LT_WAL_GC_SYNC,   2, "WAL group commit sync latency",  "l_gc_sync"),
+};
+
+NE_CHECK(wal_perfc, PERFC_EN_WAL, "wal_perfc table/enum mismatch");
+
 /* clang-format on */
 
 /* Forward decls */
@@ -301,27 +318,136 @@ wal_ionotify_cb(void *cbarg, merr_t err)
     mutex_unlock(&wal->sync_mutex);
 }
 
+/*
+ * Group commit
+ *
+ * When enabled, the sync caller that finds no commit in progress becomes the
+ * leader and flushes the WAL buffers itself on behalf of every sync waiting
+ * behind it, rather than waking the timer thread once per sync.  Before
+ * flushing, a leader with company (other syncs queued behind it, or recent
+ * commits that covered more than one sync) lingers for about one expected
+ * inter-arrival gap at a time, for as long as new syncs keep arriving and up
+ * to the configured maximum delay in total (see wal_gc_linger()).  Hence a
+ * lone syncer commits immediately, whereas bursts of concurrent syncs share
+ * one write per WAL buffer.  WAL files are opened O_SYNC, so each such write
+ * is itself the durability point.
+ */
+static bool
+wal_gc_flushed(const struct wal_sync_waiter *swait, const uint64_t *flushv)
+{
+    for (uint32_t i = 0; i < swait->ws_bufcnt; i++) {
+        if (flushv[i] < swait->ws_offv[i])
+            return false;
+    }
+
+    return true;
+}
+
+static void
+wal_gc_lead(struct wal *wal)
+{
+    struct wal_sync_waiter *swait, *next = NULL;
+    struct wal_flush_stats stats;
+    uint64_t flushv[WAL_BUF_MAX], linger_ns, waited_ns = 0;
+    uint32_t batch = 0, waiters = 0;
+    merr_t err;
+
+    wal->gc_leader = true;
+
+    list_for_each_entry(swait, &wal->sync_waiters, ws_link)
+        waiters += swait->ws_flushed ? 0 : 1;
+
+    while ((linger_ns = wal_gc_linger(&wal->gc, waiters, waited_ns)) > 0) {
+        uint64_t arrivals = wal->gc.gc_arrivals;
+
+        mutex_unlock(&wal->sync_mutex);
+        usleep(max_t(uint64_t, linger_ns / 1000, 1));
+        mutex_lock(&wal->sync_mutex);
+
+        waited_ns += linger_ns;
+
+        if (wal->gc.gc_arrivals == arrivals)
+            break;
+
+        waiters += wal->gc.gc_arrivals - arrivals;
+    }
+
+    mutex_unlock(&wal->sync_mutex);
+    err = wal_bufset_flush(wal->wbs, &stats);
+    if (!err)
+        wal_throttle_sensor_set(wal, stats.bufsz, stats.max_buflen);
+    mutex_lock(&wal->sync_mutex);
+
+    if (err)
+        atomic_set(&wal->error, err);
+
+    wal_bufset_flushoff(wal->wbs, WAL_BUF_MAX, flushv);
+
+    /* Count the syncs covered by this flush, and hand leadership to the
+     * first one that isn't (e.g., it arrived after the flush started).
+     */
+    list_for_each_entry(swait, &wal->sync_waiters, ws_link) {
+        if (err) {
+            swait->ws_err = err;
+            cv_signal(&swait->ws_cv);
+        } else if (wal_gc_flushed(swait, flushv)) {
+            batch += swait->ws_flushed ? 0 : 1;
+            swait->ws_flushed = true;
+        } else if (!next) {
+            next = swait;
+        }
+    }
+
+    wal->gc_leader = false;
+    wal_gc_commit(&wal->gc, batch);
+
+    if (next)
+        cv_signal(&next->ws_cv);
+
+    perfc_inc(&wal->gc_pc, PERFC_RA_WAL_GC_COMMIT);
+    perfc_dis_record(&wal->gc_pc, PERFC_DI_WAL_GC_BATCH, batch);
+}
+
 static merr_t
 wal_sync_impl(struct wal *wal, struct wal_sync_waiter *swait)
 {
     mutex_lock(&wal->sync_mutex);
     list_add_tail(&swait->ws_link, &wal->sync_waiters);
 
-    /* Notify the timer worker */
-    mutex_lock(&wal->timer_mutex);
-    wal->sync_pending = true;
-    cv_signal(&wal->timer_cv);
-    mutex_unlock(&wal->timer_mutex);
+    if (wal->gc_enable) {
+        wal_gc_arrival(&wal->gc, get_time_ns());
+        swait->ws_start = perfc_lat_start(&wal->gc_pc);
+    } else {
+        /* Notify the timer worker */
+        mutex_lock(&wal->timer_mutex);
+        wal->sync_pending = true;
+        cv_signal(&wal->timer_cv);
+        mutex_unlock(&wal->timer_mutex);
+    }
 
     while (swait->ws_bufcnt > wal_bufset_durcnt(wal->wbs, WAL_BUF_MAX, swait->ws_offv) &&
-           !swait->ws_err)
+           !swait->ws_err) {
+        if (wal->gc_enable && !wal->gc_leader) {
+            uint64_t flushv[WAL_BUF_MAX];
+
+            wal_bufset_flushoff(wal->wbs, WAL_BUF_MAX, flushv);
+            if (!wal_gc_flushed(swait, flushv)) {
+                wal_gc_lead(wal);
+                continue;
+            }
+        }
+
         cv_timedwait(&swait->ws_cv, &wal->sync_mutex, wal->dur_ms, "walsync");
+    }
 
     list_del(&swait->ws_link);
     mutex_unlock(&wal->sync_mutex);
 
     cv_destroy(&swait->ws_cv);
 
+    if (!swait->ws_err)
+        perfc_lat_record(&wal->gc_pc, PERFC_LT_WAL_GC_SYNC, swait->ws_start);
+
     return swait->ws_err;
 }
 
@@ -371,14 +497,15 @@ wal_cond_sync(struct wal *wal, uint64_t gen)
  * WAL data plane
  */
 
-merr_t
-wal_put(
+static merr_t
+wal_put_impl(
     struct wal *wal,
     struct ikvs *kvs,
     struct kvs_ktuple *kt,
     struct kvs_vtuple *vt,
     uint64_t txid,
-    struct wal_record *recout)
+    struct wal_record *recout,
+    enum wal_op op)
 {
     const size_t kvalign = sizeof(uint64_t);
     struct wal_rec_omf *rec;
@@ -411,7 +538,7 @@ wal_put(
     rtype = (txid > 0) ? WAL_RT_TX : WAL_RT_NONTX;
     wal_rechdr_pack(rtype, rid, len, 0, rec);
 
-    wal_rec_pack(WAL_OP_PUT, kvs->ikv_cnid, txid, klen, vt->vt_xlen, rec);
+    wal_rec_pack(op, kvs->ikv_cnid, txid, klen, vt->vt_xlen, rec);
 
     kvdata = (char *)rec + rlen;
     memcpy(kvdata, kt->kt_data, klen);
@@ -427,6 +554,18 @@ wal_put(
     return 0;
 }
 
+merr_t
+wal_put(
+    struct wal *wal,
+    struct ikvs *kvs,
+    struct kvs_ktuple *kt,
+    struct kvs_vtuple *vt,
+    uint64_t txid,
+    struct wal_record *recout)
+{
+    return wal_put_impl(wal, kvs, kt, vt, txid, recout, WAL_OP_PUT);
+}
+
 static merr_t
 wal_del_impl(
     struct wal *wal,
@@ -498,6 +637,123 @@ wal_del_pfx(
     return wal_del_impl(wal, kvs, kt, txid, recout, true);
 }
 
+merr_t
+wal_del_range(
+    struct wal *wal,
+    struct ikvs *kvs,
+    struct kvs_ktuple *start,
+    struct kvs_ktuple *end,
+    uint64_t txid,
+    struct wal_record *recout)
+{
+    struct kvs_vtuple vt;
+
+    /* A range delete record is laid out like a put whose value is the
+     * end key of the range.
+     */
+    kvs_vtuple_init(&vt, (void *)end->kt_data, end->kt_len);
+
+    return wal_put_impl(wal, kvs, start, &vt, txid, recout, WAL_OP_RDEL);
+}
+
+/*
+ * A write batch is logged as a single record so that it is replayed either
+ * in its entirety or not at all, and so that it costs only one buffer
+ * reservation and one record completion regardless of the number of ops.
+ */
+merr_t
+wal_batch(
+    struct wal *wal,
+    uint32_t opc,
+    struct kvs_batch_op *opv,
+    uint64_t txid,
+    struct wal_record *recout)
+{
+    const size_t kvalign = sizeof(uint64_t);
+    struct wal_rec_omf *rec;
+    uint64_t rid;
+    size_t rlen, len;
+    char *opdata;
+    uint32_t rtype, i;
+    merr_t err;
+
+    if (!wal)
+        return 0;
+
+    assert(opc > 0);
+
+    rlen = wal_reclen(wal->version);
+    len = rlen;
+
+    for (i = 0; i < opc; i++)
+        len += wal_batchop_len(opv[i].kbo_kt.kt_len, kvs_vtuple_vlen(&opv[i].kbo_vt));
+
+    /* The record must fit within the buffer's wrap-around slack. */
+    if (ev(len - rlen > HSE_KVS_KEY_LEN_MAX + HSE_KVS_VALUE_LEN_MAX))
+        return merr(EMSGSIZE);
+
+    rec = wal_bufset_alloc(wal->wbs, len, &recout->offset, &recout->wbidx, &recout->cookie);
+    if (!rec) {
+        err = merr(ENOMEM); /* unrecoverable error */
+        kvdb_health_error(wal->health, err);
+        return err;
+    }
+
+    recout->recbuf = rec;
+    recout->len = len;
+
+    /* Reserve one rid per op, the ops are assigned consecutive rids at replay */
+    rid = atomic_fetch_add(&wal->wal_rid, opc) + 1;
+    rtype = (txid > 0) ? WAL_RT_TX : WAL_RT_NONTX;
+    wal_rechdr_pack(rtype, rid, len, 0, rec);
+
+    wal_rec_pack(WAL_OP_BATCH, 0, txid, opc, len - rlen, rec);
+
+    opdata = (char *)rec + rlen;
+
+    for (i = 0; i < opc; i++) {
+        struct kvs_ktuple *kt = &opv[i].kbo_kt;
+        struct kvs_vtuple *vt = &opv[i].kbo_vt;
+        size_t klen = kt->kt_len, vlen = 0;
+        enum wal_op op;
+        char *kvdata;
+
+        switch (opv[i].kbo_op) {
+        case KVS_BATCH_PUT:
+            op = WAL_OP_PUT;
+            vlen = kvs_vtuple_vlen(vt);
+            break;
+
+        case KVS_BATCH_DEL:
+            op = WAL_OP_DEL;
+            break;
+
+        default:
+            op = WAL_OP_PDEL;
+            break;
+        }
+
+        kvdata = wal_batchop_pack(op, opv[i].kbo_kvs->ikv_cnid, klen,
+                                  vlen > 0 ? vt->vt_xlen : 0, opdata);
+
+        memcpy(kvdata, kt->kt_data, klen);
+        kt->kt_data = kvdata;
+        kt->kt_flags = wal->buf_flags;
+
+        if (vlen > 0) {
+            kvdata = PTR_ALIGN(kvdata + klen, kvalign);
+            memcpy(kvdata, vt->vt_data, vlen);
+            vt->vt_data = kvdata;
+        }
+
+        opdata += wal_batchop_len(klen, vlen);
+    }
+
+    assert(opdata == (char *)rec + len);
+
+    return 0;
+}
+
 static merr_t
 wal_txn(
     struct wal *wal,
@@ -579,6 +835,32 @@ wal_op_finish(struct wal *wal, struct wal_record *rec, uint64_t seqno, uint64_t
     }
 }
 
+void
+wal_batch_finish(
+    struct wal *wal,
+    struct wal_record *rec,
+    uint32_t opc,
+    const struct kvs_batch_op *opv,
+    uint64_t seqno,
+    uint64_t gen,
+    int rc)
+{
+    if (!wal)
+        return;
+
+    /* Each op of a non-tx batch was assigned its own seqno by c0, record it
+     * so that replay does not collapse the ops onto the batch's seqno.
+     */
+    if (!rc && omf_rh_type(rec->recbuf) == WAL_RT_NONTX) {
+        uint32_t i;
+
+        for (i = 0; i < opc; i++)
+            wal_batchop_seqno_pack(opv[i].kbo_kt.kt_data, opv[i].kbo_kt.kt_seqno);
+    }
+
+    wal_op_finish(wal, rec, seqno, gen, rc);
+}
+
 /*
  * WAL control plane
  */
@@ -744,6 +1026,16 @@ wal_open(
     }
 
     wal_fileset_flags_set(wal->wfset, rp->dio_enable[wal->dur_mclass] ? O_DIRECT : 0);
+    wal_fileset_recycle_set(wal->wfset, rp->dur_file_recycle_max);
+
+    wal->gc_enable = rp->dur_gc_enable;
+    wal_gc_init(&wal->gc, min_t(uint32_t, rp->dur_gc_delay_max_us, HSE_WAL_GC_DELAY_US_MAX));
+    if (wal->gc_enable && ikdb) {
+        char group[128];
+
+        snprintf(group, sizeof(group), "kvdb/%s", ikvdb_alias(ikdb));
+        perfc_alloc(wal_perfc, group, "wal", rp->perfc_level, &wal->gc_pc);
+    }
 
     err = wal_mdc_compact(wal->mdc, wal);
     if (err)
@@ -830,6 +1122,8 @@ wal_close(struct wal *wal)
     mutex_destroy(&wal->timer_mutex);
     cv_destroy(&wal->timer_cv);
 
+    perfc_free(&wal->gc_pc);
+
     free(wal);
 }
 
@@ -862,6 +1156,39 @@ wal_bufrel_cb(struct wal *wal, uint64_t gen)
         wal_bufset_reclaim(wal->wbs, gen);
 }
 
+void
+wal_perfc_init(void)
+{
+    struct perfc_ivl *ivl;
+    uint64_t boundv[PERFC_IVL_MAX];
+    merr_t err;
+
+    /* Group commit batch sizes: 1, 2, 4, ... */
+    boundv[0] = 1;
+    for (int i = 1; i < PERFC_IVL_MAX; i++)
+        boundv[i] = boundv[i - 1] * 2;
+
+    err = perfc_ivl_create(PERFC_IVL_MAX, boundv, &ivl);
+    if (err) {
+        log_errx("unable to allocate pow2 ivl", err);
+        return;
+    }
+
+    wal_perfc[PERFC_DI_WAL_GC_BATCH].pcn_ivl = ivl;
+}
+
+void
+wal_perfc_fini(void)
+{
+    struct perfc_ivl *ivl;
+
+    ivl = wal_perfc[PERFC_DI_WAL_GC_BATCH].pcn_ivl;
+    if (ivl) {
+        wal_perfc[PERFC_DI_WAL_GC_BATCH].pcn_ivl = 0;
+        perfc_ivl_destroy(ivl);
+    }
+}
+
 void
 wal_throttle_sensor(struct wal *wal, struct throttle_sensor *sensor)
 {
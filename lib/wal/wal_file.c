@@ -24,6 +24,7 @@
 #define WAL_FILE_HDR_LEN       (PAGE_SIZE)
 #define WAL_FILE_HDR_OFF       (0)
 #define WAL_FILE_NAME_LEN_MAX  (64)
+#define WAL_FILE_FREE_TAG      "free"
 
 
 struct wal_fileset {
@@ -40,6 +41,13 @@ struct wal_fileset {
     uint32_t flags;
     merr_t   err;
     void    *repbuf;
+
+    /* Pool of preallocated files retired by reclaim, awaiting reuse */
+    uint32_t recycle_max;
+    uint32_t recycle_busy;
+    uint32_t recyclec;
+    uint64_t recycle_id;
+    uint64_t recyclev[HSE_WAL_FILE_RECYCLE_MAX];
 };
 
 struct wal_file {
@@ -94,6 +102,123 @@ wal_file_minmax_update(struct wal_file *wfile, struct wal_minmax_info *info)
     winfo->max_txid = max_t(uint64_t, winfo->max_txid, info->max_txid);
 }
 
+static void
+wal_file_free_name(uint64_t id, char *name, size_t namesz)
+{
+    snprintf(name, namesz, "%s-%s-%lu", WAL_FILE_PFX, WAL_FILE_FREE_TAG, id);
+}
+
+/*
+ * Retire a reclaimed file into the recycle pool rather than destroying it.
+ * Its header is reset first so that the stale records, all of which have
+ * been ingested by now, are never mistaken for a closed file's contents.
+ *
+ * The stale records are deliberately left in place.  Zeroing them, be it
+ * with FALLOC_FL_ZERO_RANGE or by truncating and reallocating, turns the
+ * extents back into unwritten extents on ext4 and XFS, so that every O_DSYNC
+ * write into the reused file would again commit an extent conversion.
+ * Instead, each record carries the gen of the file it was written to (see
+ * wal_recs_fgen_pack()), and replay stops at the first record that belongs
+ * to an earlier use of the file.
+ *
+ * Drops the caller's reference on success, otherwise the caller must destroy
+ * the file.
+ */
+static bool
+wal_file_recycle(struct wal_fileset *wfset, struct wal_file *wfile)
+{
+    char name[WAL_FILE_NAME_LEN_MAX], fname[WAL_FILE_NAME_LEN_MAX];
+    uint64_t id;
+    merr_t err;
+
+    mutex_lock(&wfset->lock);
+    if (wfset->recyclec + wfset->recycle_busy >= wfset->recycle_max) {
+        mutex_unlock(&wfset->lock);
+        wal_file_put(wfile);
+        return false;
+    }
+    wfset->recycle_busy++;
+    id = wfset->recycle_id++;
+    mutex_unlock(&wfset->lock);
+
+    strlcpy(name, wfile->name, sizeof(name));
+    wal_file_free_name(id, fname, sizeof(fname));
+
+    wal_file_minmax_init(&wfile->info);
+    err = wal_file_format(wfile, 0, 0, false);
+    if (!err)
+        err = mpool_file_sync(wfile->mpf);
+    wal_file_put(wfile);
+
+    if (!err)
+        err = mpool_file_rename(wfset->mp, wfset->mclass, name, fname);
+
+    mutex_lock(&wfset->lock);
+    if (!err)
+        wfset->recyclev[wfset->recyclec++] = id;
+    wfset->recycle_busy--;
+    mutex_unlock(&wfset->lock);
+
+    if (ev(err)) {
+        log_errx("Unable to recycle wal file %s", err, name);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Take a file from the recycle pool, if any, and rename it to @name so that
+ * the subsequent open neither creates nor allocates space for it.
+ */
+static void
+wal_file_reuse(struct wal_fileset *wfset, const char *name)
+{
+    char fname[WAL_FILE_NAME_LEN_MAX];
+    uint64_t id;
+    merr_t err;
+
+    mutex_lock(&wfset->lock);
+    if (wfset->recyclec == 0) {
+        mutex_unlock(&wfset->lock);
+        return;
+    }
+    id = wfset->recyclev[--wfset->recyclec];
+    mutex_unlock(&wfset->lock);
+
+    wal_file_free_name(id, fname, sizeof(fname));
+
+    err = mpool_file_rename(wfset->mp, wfset->mclass, fname, name);
+    if (ev(err)) {
+        log_errx("Unable to reuse wal file %s", err, fname);
+        mpool_file_destroy(wfset->mp, wfset->mclass, fname);
+    }
+}
+
+void
+wal_fileset_recycle_set(struct wal_fileset *wfset, uint32_t max)
+{
+    char fname[WAL_FILE_NAME_LEN_MAX];
+    uint64_t id;
+
+    max = min_t(uint32_t, max, HSE_WAL_FILE_RECYCLE_MAX);
+
+    mutex_lock(&wfset->lock);
+    wfset->recycle_max = max;
+
+    /* Release the files found at replay in excess of the new limit */
+    while (wfset->recyclec > max) {
+        id = wfset->recyclev[--wfset->recyclec];
+        mutex_unlock(&wfset->lock);
+
+        wal_file_free_name(id, fname, sizeof(fname));
+        ev(mpool_file_destroy(wfset->mp, wfset->mclass, fname));
+
+        mutex_lock(&wfset->lock);
+    }
+    mutex_unlock(&wfset->lock);
+}
+
 merr_t
 wal_fileset_reclaim(
     struct wal_fileset *wfset,
@@ -150,8 +275,9 @@ wal_fileset_reclaim(
 
         list_del(&cur->link);
         assert(atomic_read(&cur->ref) == 1);
-        wal_file_put(cur);
-        wal_file_destroy(wfset, gen, fileid);
+
+        if (!wal_file_recycle(wfset, cur))
+            wal_file_destroy(wfset, gen, fileid);
     }
 
     return 0;
@@ -160,6 +286,10 @@ wal_fileset_reclaim(
 void
 wal_fileset_mclass_set(struct wal_fileset *wfset, enum hse_mclass mclass)
 {
+    /* Files recycled in the previous mclass cannot be reused in the new one */
+    if (mclass != wfset->mclass)
+        wal_fileset_recycle_set(wfset, 0);
+
     wfset->mclass = mclass;
 }
 
@@ -244,7 +374,15 @@ wal_file_open(
 
     snprintf(name, sizeof(name), "%s-%lu-%d", WAL_FILE_PFX, gen, fileid);
 
-    flags = replay ? O_RDONLY : wfset->flags | O_RDWR | O_SYNC;
+    /* A recycled file is fully allocated and written, hence O_DSYNC spares
+     * each write the inode update that O_SYNC would incur.
+     */
+    if (replay) {
+        flags = O_RDONLY;
+    } else {
+        wal_file_reuse(wfset, name);
+        flags = wfset->flags | O_RDWR | (wfset->recycle_max > 0 ? O_DSYNC : O_SYNC);
+    }
 
     err = mpool_file_open(wfset->mp, wfset->mclass, name, flags, wfset->capacity, sparse, &mpf);
     if (err)
@@ -421,6 +559,8 @@ wal_file_write(struct wal_file *wfile, char *buf, size_t len, bool bufwrap)
     if (!wfile)
         return merr(EINVAL);
 
+    wal_recs_fgen_pack(buf, len, wfile->gen);
+
     /* rounddown the buf and file offset to 4K alignment */
     abuf = (char *)((uintptr_t)buf & PAGE_MASK);
     off = wfile->woff;
@@ -490,6 +630,31 @@ wal_file_write(struct wal_file *wfile, char *buf, size_t len, bool bufwrap)
  * WAL fileset replay interfaces
  */
 
+static merr_t
+wal_file_free_add(struct wal_fileset *wfset, const char *tok)
+{
+    char *end = NULL;
+    uint64_t id;
+
+    /* Parse recycled file id */
+    errno = 0;
+    id = strtoull(tok ? tok : "", &end, 10);
+    if (errno || *end || end == tok)
+        return merr(EINVAL);
+
+    wfset->recycle_id = max_t(uint64_t, wfset->recycle_id, id + 1);
+    if (wfset->recyclec < HSE_WAL_FILE_RECYCLE_MAX) {
+        wfset->recyclev[wfset->recyclec++] = id;
+    } else {
+        char fname[WAL_FILE_NAME_LEN_MAX];
+
+        wal_file_free_name(id, fname, sizeof(fname));
+        ev(mpool_file_destroy(wfset->mp, wfset->mclass, fname));
+    }
+
+    return 0;
+}
+
 static void
 wal_file_cb(void *wfset, const char *path)
 {
@@ -513,8 +678,17 @@ wal_file_cb(void *wfset, const char *path)
         goto err_exit;
     }
 
-    /* Parse gen */
     tok = strsep(&name, delim);
+    if (tok && !strcmp(tok, WAL_FILE_FREE_TAG)) {
+        err = wal_file_free_add(wfset, strsep(&name, delim));
+        if (err)
+            goto err_exit;
+
+        free(pathdup);
+        return;
+    }
+
+    /* Parse gen */
     errno = 0;
     gen = strtoull(tok, &end, 10);
     if (errno || *end || gen == 0) {
@@ -532,12 +706,15 @@ wal_file_cb(void *wfset, const char *path)
     }
 
     err = wal_file_open(wfset, gen, fileid, true, &wfile);
+    if (err)
+        goto err_exit;
 
-err_exit:
     free(pathdup);
+    return;
 
-    if (err)
-        ((struct wal_fileset *)wfset)->err = err;
+err_exit:
+    free(pathdup);
+    ((struct wal_fileset *)wfset)->err = err;
 }
 
 merr_t
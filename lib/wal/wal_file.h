@@ -40,6 +40,10 @@ wal_fileset_version_set(struct wal_fileset *wfset, uint32_t version);
 void
 wal_fileset_flags_set(struct wal_fileset *wfset, uint32_t flags);
 
+/* Keep up to @max reclaimed files for reuse instead of destroying them */
+void
+wal_fileset_recycle_set(struct wal_fileset *wfset, uint32_t max);
+
 merr_t
 wal_file_open(
     struct wal_fileset *wfset,
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <hse_util/minmax.h>
+
+#include "wal_gc.h"
+
+void
+wal_gc_init(struct wal_gc *gc, uint32_t delay_max_us)
+{
+    gc->gc_delay_max_ns = 1000ul * delay_max_us;
+    gc->gc_arrivals = 0;
+    gc->gc_arrival_ns = 0;
+    gc->gc_gap_ns = 0;
+    gc->gc_batch_avg = WAL_GC_BATCH_ONE;
+}
+
+void
+wal_gc_arrival(struct wal_gc *gc, uint64_t now)
+{
+    if (gc->gc_arrival_ns) {
+        uint64_t gap = now - gc->gc_arrival_ns;
+
+        /* Don't let an idle period skew the average for long */
+        gap = min_t(uint64_t, gap, 2 * gc->gc_delay_max_ns);
+
+        gc->gc_gap_ns = gc->gc_gap_ns ? (gc->gc_gap_ns * 7 + gap) / 8 : gap;
+    }
+
+    gc->gc_arrival_ns = now;
+    gc->gc_arrivals++;
+}
+
+uint64_t
+wal_gc_linger(const struct wal_gc *gc, uint32_t waiters, uint64_t waited_ns)
+{
+    uint64_t gap_ns = gc->gc_gap_ns;
+
+    if (gap_ns == 0 || waited_ns + gap_ns > gc->gc_delay_max_ns)
+        return 0;
+
+    if (waiters < 2 && gc->gc_batch_avg <= WAL_GC_BATCH_ONE)
+        return 0;
+
+    return gap_ns;
+}
+
+void
+wal_gc_commit(struct wal_gc *gc, uint32_t batch)
+{
+    gc->gc_batch_avg = (gc->gc_batch_avg * 7 + batch * WAL_GC_BATCH_ONE) / 8;
+}
@@ -0,0 +1,74 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#ifndef WAL_GC_H
+#define WAL_GC_H
+
+#include <stdint.h>
+
+/* clang-format off */
+
+/* Fixed point unit of wal_gc.gc_batch_avg, i.e., one sync per commit */
+#define WAL_GC_BATCH_ONE    (16u)
+
+/* clang-format on */
+
+/**
+ * struct wal_gc - group commit batching policy
+ *
+ * @gc_delay_max_ns: upper bound on the time a leader lingers before flushing
+ * @gc_arrivals:     number of syncs seen so far
+ * @gc_arrival_ns:   time of the most recent sync
+ * @gc_gap_ns:       EWMA of the gap between consecutive syncs
+ * @gc_batch_avg:    EWMA of syncs per commit, in units of WAL_GC_BATCH_ONE
+ *
+ * Not thread safe, the caller serializes access (see wal->sync_mutex).
+ */
+struct wal_gc {
+    uint64_t gc_delay_max_ns;
+    uint64_t gc_arrivals;
+    uint64_t gc_arrival_ns;
+    uint64_t gc_gap_ns;
+    uint32_t gc_batch_avg;
+};
+
+void
+wal_gc_init(struct wal_gc *gc, uint32_t delay_max_us);
+
+/**
+ * wal_gc_arrival() - account for a new sync
+ *
+ * @gc:  group commit state
+ * @now: arrival time in nanoseconds
+ */
+void
+wal_gc_arrival(struct wal_gc *gc, uint64_t now);
+
+/**
+ * wal_gc_linger() - decide how long a leader waits before it flushes
+ *
+ * @gc:        group commit state
+ * @waiters:   number of unflushed syncs queued, including the leader
+ * @waited_ns: time the leader has lingered so far
+ *
+ * A leader lingers only if it has company, that is if other syncs are
+ * queued behind it or if recent commits covered more than one sync.
+ * A lone syncer with no such history flushes immediately.
+ *
+ * Return: time to linger in nanoseconds, 0 to flush now
+ */
+uint64_t
+wal_gc_linger(const struct wal_gc *gc, uint32_t waiters, uint64_t waited_ns);
+
+/**
+ * wal_gc_commit() - account for a completed group commit
+ *
+ * @gc:    group commit state
+ * @batch: number of syncs covered by the commit
+ */
+void
+wal_gc_commit(struct wal_gc *gc, uint32_t batch);
+
+#endif /* WAL_GC_H */
@@ -46,7 +46,8 @@ wal_rechdr_len(uint32_t version)
     case WAL_VERSION1:
         return sizeof(struct wal_rechdr_omf_v1);
 
-    case WAL_VERSION:
+    case WAL_VERSION2:
+    case WAL_VERSION3:
         return sizeof(struct wal_rechdr_omf);
 
     default:
@@ -93,7 +94,8 @@ wal_reclen(uint32_t version)
     case WAL_VERSION1:
         return sizeof(struct wal_rec_omf_v1);
 
-    case WAL_VERSION:
+    case WAL_VERSION2:
+    case WAL_VERSION3:
         return sizeof(struct wal_rec_omf);
 
     default:
@@ -101,6 +103,47 @@ wal_reclen(uint32_t version)
     }
 }
 
+void *
+wal_batchop_pack(enum wal_op op, uint64_t cnid, uint32_t klen, size_t vxlen, void *outbuf)
+{
+    struct wal_batchop_omf *bomf = outbuf;
+
+    omf_set_bo_op(bomf, op);
+    omf_set_bo_klen(bomf, klen);
+    omf_set_bo_cnid(bomf, cnid);
+    omf_set_bo_seqno(bomf, 0);
+    omf_set_bo_vxlen(bomf, vxlen);
+
+    return bomf->bo_data;
+}
+
+void
+wal_batchop_seqno_pack(const void *kvdata, uint64_t seqno)
+{
+    struct wal_batchop_omf *bomf;
+
+    bomf = (void *)((char *)kvdata - offsetof(struct wal_batchop_omf, bo_data));
+    omf_set_bo_seqno(bomf, seqno);
+}
+
+uint32_t
+wal_batchop_len(uint32_t klen, size_t vlen)
+{
+    const size_t kvalign = sizeof(uint64_t);
+
+    return sizeof(struct wal_batchop_omf) + ALIGN(klen, kvalign) + ALIGN(vlen, kvalign);
+}
+
+static const struct wal_batchop_omf *
+wal_batchop_next(const struct wal_batchop_omf *bomf)
+{
+    struct kvs_vtuple vt;
+
+    kvs_vtuple_init(&vt, NULL, omf_bo_vxlen(bomf));
+
+    return (const void *)((const char *)bomf + wal_batchop_len(omf_bo_klen(bomf), kvs_vtuple_vlen(&vt)));
+}
+
 void
 wal_rec_finish(struct wal_record *rec, uint64_t seqno, uint64_t gen)
 {
@@ -115,6 +158,28 @@ wal_rec_finish(struct wal_record *rec, uint64_t seqno, uint64_t gen)
     atomic_set((atomic_ulong *)&rhomf->rh_off, cpu_to_omf64(rec->offset));
 }
 
+/* Stamp the gen of the file they are about to be written to into the
+ * complete records of @buf.
+ */
+void
+wal_recs_fgen_pack(char *buf, size_t len, uint64_t fgen)
+{
+    const uint32_t rhlen = wal_rechdr_len(WAL_VERSION);
+    size_t off = 0;
+
+    while (off < len) {
+        struct wal_rechdr_omf *rhomf = (void *)(buf + off);
+        uint64_t flags;
+
+        flags = omf_rh_flags(rhomf) & ~WAL_FLAGS_FGEN_MASK;
+        flags |= (fgen << WAL_FLAGS_FGEN_SHIFT) & WAL_FLAGS_FGEN_MASK;
+        omf_set_rh_flags(rhomf, flags);
+
+        off += rhlen + omf_rh_len(rhomf);
+    }
+    assert(off == len);
+}
+
 /* Record unpack routines */
 
 bool
@@ -164,7 +229,8 @@ wal_rec_cksum_valid(const char *inbuf, uint32_t version)
     case WAL_VERSION1:
         return wal_rec_cksum_valid_v1(inbuf);
 
-    case WAL_VERSION:
+    case WAL_VERSION2:
+    case WAL_VERSION3:
         return wal_rec_cksum_valid_latest(inbuf);
 
     default:
@@ -187,6 +253,20 @@ wal_update_minmax_seqno(const void *buf, uint32_t rtype, struct wal_minmax_info
 
         info->min_seqno = min_t(uint64_t, info->min_seqno, seqno);
         info->max_seqno = max_t(uint64_t, info->max_seqno, seqno);
+
+        /* The header of a non-tx batch record holds the highest seqno of its
+         * ops, the lowest is found only by walking the ops.
+         */
+        if (nontx && omf_r_op(r) == WAL_OP_BATCH) {
+            const struct wal_batchop_omf *bomf = (const void *)(r + 1);
+            uint32_t opc = omf_r_klen(r);
+
+            while (opc-- > 0) {
+                seqno = omf_bo_seqno(bomf);
+                info->min_seqno = min_t(uint64_t, info->min_seqno, seqno);
+                bomf = wal_batchop_next(bomf);
+            }
+        }
     }
 }
 
@@ -235,8 +315,16 @@ wal_rec_is_valid(
     if (*recoff != 0 && roff != WAL_ROFF_RECOV_ERR && roff != *recoff)
         return false;
 
-    if ((hdr->flags & WAL_FLAGS_MASK) != 0)
+    if (version >= WAL_VERSION3) {
+        /* A record left over from an earlier use of a recycled file */
+        if ((hdr->flags >> WAL_FLAGS_FGEN_SHIFT) != (gen & UINT32_MAX))
+            return false;
+
+        if ((hdr->flags & ~WAL_FLAGS_FGEN_MASK & WAL_FLAGS_MASK) != 0)
+            return false;
+    } else if ((hdr->flags & WAL_FLAGS_MASK) != 0) {
         return false;
+    }
 
     if (hdr->type > WAL_RT_TYPE_MAX)
         return false;
@@ -310,7 +398,8 @@ wal_rechdr_unpack(const void *inbuf, uint32_t version, struct wal_rechdr *hdr)
         wal_rechdr_unpack_v1(inbuf, hdr);
         break;
 
-    case WAL_VERSION:
+    case WAL_VERSION2:
+    case WAL_VERSION3:
         wal_rechdr_unpack_latest(inbuf, hdr);
         break;
 
@@ -381,7 +470,8 @@ wal_rec_unpack(const char *inbuf, struct wal_rechdr *hdr, uint32_t version, stru
         wal_rec_unpack_v1(inbuf, hdr, rec);
         break;
 
-    case WAL_VERSION:
+    case WAL_VERSION2:
+    case WAL_VERSION3:
         wal_rec_unpack_latest(inbuf, hdr, rec);
         break;
 
@@ -390,6 +480,54 @@ wal_rec_unpack(const char *inbuf, struct wal_rechdr *hdr, uint32_t version, stru
     }
 }
 
+uint32_t
+wal_batch_rec_unpack(const char *inbuf, uint32_t version, const char **opbuf)
+{
+    const struct wal_rec_omf *romf = (const void *)inbuf;
+
+    assert(version >= WAL_VERSION3);
+    assert(omf_r_op(romf) == WAL_OP_BATCH);
+
+    *opbuf = inbuf + wal_reclen(version);
+
+    return omf_r_klen(romf);
+}
+
+const char *
+wal_batchop_unpack(const char *inbuf, const struct wal_rec *brec, uint32_t idx, struct wal_rec *rec)
+{
+    const struct wal_batchop_omf *bomf = (const void *)inbuf;
+    size_t kvalign = sizeof(uint64_t);
+    size_t klen, vxlen, vlen;
+    const void *kdata;
+    void *vdata = NULL;
+
+    /* Each op inherits the header and txid of the batch record.  The batch
+     * record reserved one rid per op so that the ops replay in order.  A
+     * non-tx op carries its own seqno, a tx op takes the commit seqno.
+     */
+    rec->hdr = brec->hdr;
+    rec->hdr.rid += idx;
+    rec->txid = brec->txid;
+    rec->seqno = wal_rectype_nontxn(brec->hdr.type) ? omf_bo_seqno(bomf) : brec->seqno;
+    rec->cnid = omf_bo_cnid(bomf);
+    rec->op = omf_bo_op(bomf);
+
+    klen = omf_bo_klen(bomf);
+    assert(klen != 0);
+    kdata = bomf->bo_data;
+    kvs_ktuple_init(&rec->kt, kdata, klen);
+
+    vxlen = omf_bo_vxlen(bomf);
+    if (vxlen > 0)
+        vdata = PTR_ALIGN((void *)rec->kt.kt_data + klen, kvalign);
+    kvs_vtuple_init(&rec->vt, vdata, vxlen);
+
+    vlen = kvs_vtuple_vlen(&rec->vt);
+
+    return inbuf + wal_batchop_len(klen, vlen);
+}
+
 void
 wal_txn_rechdr_finish(void *recbuf, size_t len, uint64_t offset)
 {
@@ -441,7 +579,8 @@ wal_txn_rec_unpack(const void *inbuf, struct wal_rechdr *hdr, uint32_t version,
         wal_txn_rec_unpack_v1(inbuf, hdr, trec);
         break;
 
-    case WAL_VERSION:
+    case WAL_VERSION2:
+    case WAL_VERSION3:
         wal_txn_rec_unpack_latest(inbuf, hdr, trec);
         break;
 
@@ -457,7 +596,8 @@ wal_txn_reclen(uint32_t version)
     case WAL_VERSION1:
         return sizeof(struct wal_txnrec_omf_v1);
 
-    case WAL_VERSION:
+    case WAL_VERSION2:
+    case WAL_VERSION3:
         return sizeof(struct wal_txnrec_omf);
 
     default:
@@ -542,6 +682,7 @@ static merr_t
 wal_filehdr_unpack_latest(
     const void             *inbuf,
     uint32_t                magic,
+    uint32_t                version,
     bool                   *close,
     off_t                  *soff,
     off_t                  *eoff,
@@ -572,7 +713,7 @@ wal_filehdr_unpack_latest(
         return ((memcmp(fhomf, &ref, sizeof(*fhomf)) == 0) ? merr(ENODATA) : merr(EBADMSG));
     }
 
-    if ((magic != omf_fh_magic(fhomf)) || (WAL_VERSION != omf_fh_version(fhomf)))
+    if ((magic != omf_fh_magic(fhomf)) || (version != omf_fh_version(fhomf)))
         return merr(EBADMSG);
 
     return 0;
@@ -595,8 +736,9 @@ wal_filehdr_unpack(
         err = wal_filehdr_unpack_v1(inbuf, magic, close, soff, eoff, info);
         break;
 
-    case WAL_VERSION:
-        err = wal_filehdr_unpack_latest(inbuf, magic, close, soff, eoff, info);
+    case WAL_VERSION2:
+    case WAL_VERSION3:
+        err = wal_filehdr_unpack_latest(inbuf, magic, version, close, soff, eoff, info);
         break;
 
     default:
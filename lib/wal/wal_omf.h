@@ -41,6 +41,8 @@ enum wal_op {
     WAL_OP_PUT = 500,
     WAL_OP_DEL = 501,
     WAL_OP_PDEL = 502,
+    WAL_OP_BATCH = 503, /* WAL_VERSION3 and later */
+    WAL_OP_RDEL = 504,  /* WAL_VERSION3 and later */
 };
 
 enum wal_flags {
@@ -52,6 +54,14 @@ enum wal_flags {
 #define WAL_FLAGS_ALL   (WAL_FLAGS_BORG | WAL_FLAGS_MORG | WAL_FLAGS_EORG)
 #define WAL_FLAGS_MASK ~(WAL_FLAGS_ALL)
 
+/* From WAL_VERSION3 on, the upper half of rh_flags holds the low 32 bits of
+ * the gen of the file that the record was written to.  It is stamped just
+ * before the write, outside of the record checksum, and lets replay tell the
+ * records of a recycled file from those left over from its previous use.
+ */
+#define WAL_FLAGS_FGEN_SHIFT  (32)
+#define WAL_FLAGS_FGEN_MASK   (0xffffffff00000000ul)
+
 
 /*
  * WAL MDC OMF
@@ -242,6 +252,28 @@ OMF_SETGET(struct wal_rec_omf, r_txid, 64);
 OMF_SETGET(struct wal_rec_omf, r_seqno, 64);
 OMF_SETGET(struct wal_rec_omf, r_vxlen, 64);
 
+/* A batch record is a wal_rec_omf whose r_op is WAL_OP_BATCH, r_klen is the
+ * number of ops in the batch and r_vxlen is the length of the op vector that
+ * follows.  Each op is a wal_batchop_omf followed by its key and value, each
+ * aligned to 8 bytes.  bo_seqno is the op's own seqno in a non-tx batch, it is
+ * zero in a tx batch.  Batch records exist only in WAL_VERSION3 and later.
+ */
+struct wal_batchop_omf {
+    uint32_t bo_op;
+    uint32_t bo_klen;
+    uint64_t bo_cnid;
+    uint64_t bo_seqno;
+    uint64_t bo_vxlen;
+    uint8_t  bo_data[0];
+} __attribute__((packed,aligned(sizeof(uint64_t))));
+
+/* Define set/get methods for wal_batchop_omf */
+OMF_SETGET(struct wal_batchop_omf, bo_op, 32);
+OMF_SETGET(struct wal_batchop_omf, bo_klen, 32);
+OMF_SETGET(struct wal_batchop_omf, bo_cnid, 64);
+OMF_SETGET(struct wal_batchop_omf, bo_seqno, 64);
+OMF_SETGET(struct wal_batchop_omf, bo_vxlen, 64);
+
 struct wal_txnrec_omf_v1 {
     struct wal_rechdr_omf_v1 tr_hdr;
     uint64_t                 tr_txid;
@@ -302,6 +334,9 @@ wal_rechdr_len(uint32_t version);
 void
 wal_rec_finish(struct wal_record *rec, uint64_t seqno, uint64_t gen);
 
+void
+wal_recs_fgen_pack(char *buf, size_t len, uint64_t fgen);
+
 void
 wal_rec_pack(
     enum wal_op op,
@@ -314,6 +349,21 @@ wal_rec_pack(
 uint32_t
 wal_reclen(uint32_t version);
 
+void *
+wal_batchop_pack(enum wal_op op, uint64_t cnid, uint32_t klen, size_t vxlen, void *outbuf);
+
+void
+wal_batchop_seqno_pack(const void *kvdata, uint64_t seqno);
+
+uint32_t
+wal_batchop_len(uint32_t klen, size_t vlen);
+
+uint32_t
+wal_batch_rec_unpack(const char *inbuf, uint32_t version, const char **opbuf);
+
+const char *
+wal_batchop_unpack(const char *inbuf, const struct wal_rec *brec, uint32_t idx, struct wal_rec *rec);
+
 bool
 wal_rec_is_txnmeta(struct wal_rechdr *hdr);
 
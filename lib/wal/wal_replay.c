@@ -77,6 +77,10 @@ struct wal_rec_iter {
     size_t                  size;
     merr_t                  err;
     bool                    eof;
+    struct wal_rec         *batch;
+    const char             *bopbuf;
+    uint32_t                bopc;
+    uint32_t                bidx;
 };
 
 
@@ -211,6 +215,9 @@ wal_rec_iter_init(struct wal_replay_work *rw, struct wal_rec_iter *iter)
     iter->size = rw->rw_rginfo->size;
     iter->err = 0;
     iter->rw = rw;
+    iter->batch = NULL;
+    iter->bopbuf = NULL;
+    iter->bopc = iter->bidx = 0;
 }
 
 #ifndef NDEBUG
@@ -241,6 +248,38 @@ wal_txmrec_rb_search(struct wal_replay *rep, uint64_t txid)
     return NULL;
 }
 
+/* Expand the next op of the batch record currently being iterated over.
+ */
+static struct wal_rec *
+wal_rec_iter_batch_next(struct wal_rec_iter *iter)
+{
+    struct wal_rec *brec = iter->batch;
+    struct wal_rec *rec;
+
+    rec = kmem_cache_alloc(iter->rcache);
+    if (rec) {
+        iter->bopbuf = wal_batchop_unpack(iter->bopbuf, brec, iter->bidx, rec);
+
+        /* Non-txn ops carry their own seqno, which may fall in an older gen */
+        if (rec->hdr.type == WAL_RT_NONTX && rec->seqno != brec->seqno) {
+            struct wal_replay_gen *rgen;
+
+            rgen = wal_replay_gen_getbyseqno(iter->rw->rw_rep, rec->seqno);
+            if (rgen)
+                rec->hdr.gen = rgen->rg_gen;
+        }
+    } else {
+        iter->err = merr(ENOMEM);
+    }
+
+    if (!rec || ++iter->bidx == iter->bopc) {
+        kmem_cache_free(iter->rcache, brec);
+        iter->batch = NULL;
+    }
+
+    return rec;
+}
+
 static struct wal_rec *
 wal_rec_iter_next(struct wal_rec_iter *iter)
 {
@@ -249,6 +288,9 @@ wal_rec_iter_next(struct wal_rec_iter *iter)
     const char *buf;
     uint32_t version = wal_version_get(iter->rw->rw_rep->r_wal);
 
+    if (iter->batch)
+        return wal_rec_iter_batch_next(iter);
+
 next_rec:
     if (iter->eof)
         return NULL;
@@ -303,6 +345,21 @@ next_rec:
             rec->hdr.gen = rgen->rg_gen;
     }
 
+    /* Batch and range delete records exist only in WAL_VERSION3 and later */
+    if (version < WAL_VERSION3 && (rec->op == WAL_OP_BATCH || rec->op == WAL_OP_RDEL)) {
+        kmem_cache_free(iter->rcache, rec);
+        iter->err = merr(EPROTO);
+        return NULL;
+    }
+
+    if (rec->op == WAL_OP_BATCH) {
+        iter->batch = rec;
+        iter->bopc = wal_batch_rec_unpack(buf, version, &iter->bopbuf);
+        iter->bidx = 0;
+
+        return wal_rec_iter_batch_next(iter);
+    }
+
     return rec;
 }
 
@@ -546,6 +603,10 @@ wal_replay_gen_impl(struct wal_replay *rep, struct wal_replay_gen *rgen, bool fl
             err = ikvdb_wal_replay_prefix_del(ikvdb, ikvsh, rec->cnid, rec->seqno, kt);
             break;
 
+          case WAL_OP_RDEL:
+            err = ikvdb_wal_replay_range_del(ikvdb, ikvsh, rec->cnid, rec->seqno, kt, vt);
+            break;
+
           default:
             err = merr(EINVAL);
             break;
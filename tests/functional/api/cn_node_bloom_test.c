@@ -0,0 +1,255 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+/* Node blooms are built over the keys of real leaf kvsets, hence these
+ * tests run against a kvdb and inspect its cn tree through the internal API.
+ */
+
+#include <unistd.h>
+
+#include <hse/hse.h>
+#include <hse/experimental.h>
+#include <hse/test/fixtures/kvdb.h>
+
+#include <mtf/framework.h>
+
+#include <hse_util/base.h>
+#include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/ikvdb.h>
+
+#include <cn/cn_tree.h>
+#include <cn/cn_tree_internal.h>
+#include <cn/kvset.h>
+#include <cn/node_bloom.h>
+
+#define KVS_NAME    "kvs"
+#define NBATCH      (3)
+#define NKEYS       (2000)
+#define VLEN        (64)
+#define GETC        (64)
+#define KEY_FMT     "k%d-%06d"
+
+struct hse_kvdb *kvdb_handle;
+struct hse_kvs  *kvs_handle;
+
+/* One in a thousand false positives, so that a filter built over the
+ * wrong hashes misses nearly every key.
+ */
+static const char *kvs_rparamv[] = { "cn_node_bloom_prob=1000" };
+
+static int
+key_fmt(char *buf, size_t bufsz, int batch, int i)
+{
+    return snprintf(buf, bufsz, KEY_FMT, batch, i);
+}
+
+static hse_err_t
+reopen(size_t rparamc, const char **rparamv)
+{
+    hse_err_t err;
+
+    err = hse_kvdb_open(mtf_kvdb_home, rparamc, rparamv, &kvdb_handle);
+    if (err)
+        return err;
+
+    return hse_kvdb_kvs_open(kvdb_handle, KVS_NAME, NELEM(kvs_rparamv), kvs_rparamv, &kvs_handle);
+}
+
+static void
+close_all(void)
+{
+    hse_kvdb_kvs_close(kvs_handle);
+    hse_kvdb_close(kvdb_handle);
+
+    kvs_handle = NULL;
+    kvdb_handle = NULL;
+}
+
+static uint
+root_kvsets(struct cn_tree *tree)
+{
+    struct kvset_list_entry *le;
+    void *lock;
+    uint n = 0;
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    list_for_each_entry(le, &tree->ct_root->tn_kvset_list, le_link)
+        n++;
+    rmlock_runlock(lock);
+
+    return n;
+}
+
+/* Count the leaf kvsets covered by a node bloom */
+static uint
+covered_kvsets(struct cn_tree *tree)
+{
+    struct cn_tree_node *tn;
+    void *lock;
+    uint n = 0;
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    cn_tree_foreach_leaf(tn, tree) {
+        struct kvset_list_entry *le;
+
+        if (!tn->tn_nbloom)
+            continue;
+
+        list_for_each_entry(le, &tn->tn_kvset_list, le_link)
+            n += (le->le_nbgen == tn->tn_nbloom->nb_gen);
+    }
+    rmlock_runlock(lock);
+
+    return n;
+}
+
+/* Write NBATCH disjoint key ranges into a kvs with a key suffix, one kvset
+ * each, spill them one at a time into the leaves, then reopen the kvdb so
+ * that leaf node blooms are built over the spilled kvsets.
+ */
+int
+populate(struct mtf_test_info *lcl_ti)
+{
+    const char *cparamv[] = { "prefix.length=3", "suffix.length=2" };
+    const char *rparamv[] = { "durability.enabled=false", "csched_rspill_params=0x0101" };
+    const char *kvdb_rparamv[] = { "durability.enabled=false" };
+    char key[32], val[VLEN];
+    hse_err_t err;
+    int i;
+
+    err = fxt_kvdb_setup(mtf_kvdb_home, NELEM(kvdb_rparamv), kvdb_rparamv, 0, NULL, &kvdb_handle);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    err = hse_kvdb_kvs_create(kvdb_handle, KVS_NAME, NELEM(cparamv), cparamv);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    err = hse_kvdb_kvs_open(kvdb_handle, KVS_NAME, 0, NULL, &kvs_handle);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    for (int b = 0; b < NBATCH; b++) {
+        for (i = 0; i < NKEYS; i++) {
+            int klen = key_fmt(key, sizeof(key), b, i);
+
+            memset(val, 0, sizeof(val));
+            snprintf(val, sizeof(val), "%s", key);
+
+            err = hse_kvs_put(kvs_handle, 0, NULL, key, klen, val, sizeof(val));
+            ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+        }
+
+        err = hse_kvdb_sync(kvdb_handle, 0);
+        ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+    }
+
+    close_all();
+
+    err = reopen(NELEM(rparamv), rparamv);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    for (i = 0; i < 600; i++) {
+        if (root_kvsets(cn_get_tree(ikvdb_kvs_get_cn(kvs_handle))) == 0)
+            break;
+        usleep(100 * 1000);
+    }
+    ASSERT_LT_RET(i, 600, ETIMEDOUT);
+
+    close_all();
+
+    err = reopen(NELEM(kvdb_rparamv), kvdb_rparamv);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    return 0;
+}
+
+int
+teardown(struct mtf_test_info *lcl_ti)
+{
+    hse_err_t err;
+
+    if (kvs_handle)
+        hse_kvdb_kvs_close(kvs_handle);
+
+    err = fxt_kvdb_teardown(mtf_kvdb_home, kvdb_handle);
+
+    kvs_handle = NULL;
+    kvdb_handle = NULL;
+
+    return hse_err_to_errno(err);
+}
+
+MTF_BEGIN_UTEST_COLLECTION(cn_node_bloom_test)
+
+MTF_DEFINE_UTEST_PREPOST(cn_node_bloom_test, suffixed_get, populate, teardown)
+{
+    struct cn_tree *tree = cn_get_tree(ikvdb_kvs_get_cn(kvs_handle));
+    char key[32], val[VLEN], expect[VLEN];
+    hse_err_t err;
+    size_t vlen;
+    bool found;
+    int i, klen;
+
+    /* Node blooms are built by a background task at open */
+    for (i = 0; i < 600; i++) {
+        if (covered_kvsets(tree) > 1)
+            break;
+        usleep(100 * 1000);
+    }
+    ASSERT_LT(i, 600);
+
+    /* Every key lives in a covered kvset, and the node bloom must not
+     * rule out any of them even though the kvs hashes keys without
+     * their suffix.
+     */
+    for (int b = 0; b < NBATCH; b++) {
+        for (i = 0; i < NKEYS; i++) {
+            klen = key_fmt(key, sizeof(key), b, i);
+            memset(expect, 0, sizeof(expect));
+            snprintf(expect, sizeof(expect), "%s", key);
+
+            err = hse_kvs_get(kvs_handle, 0, NULL, key, klen, &found, val, sizeof(val), &vlen);
+            ASSERT_EQ(0, hse_err_to_errno(err));
+            ASSERT_TRUE(found);
+            ASSERT_EQ(sizeof(val), vlen);
+            ASSERT_EQ(0, memcmp(expect, val, vlen));
+        }
+    }
+
+    /* Likewise for batched gets, which probe the node bloom once per key */
+    for (int b = 0; b < NBATCH; b++) {
+        for (i = 0; i < NKEYS; i += GETC) {
+            char keyv[GETC][32], valv[GETC][VLEN];
+            const void *kptrv[GETC];
+            void *vptrv[GETC];
+            size_t klenv[GETC], vszv[GETC], vlenv[GETC];
+            bool foundv[GETC];
+            int n;
+
+            for (n = 0; n < GETC && i + n < NKEYS; n++) {
+                klenv[n] = key_fmt(keyv[n], sizeof(keyv[n]), b, i + n);
+                kptrv[n] = keyv[n];
+                vptrv[n] = valv[n];
+                vszv[n] = sizeof(valv[n]);
+            }
+
+            err = hse_kvs_get_multi(kvs_handle, 0, NULL, n, kptrv, klenv, foundv, vptrv, vszv,
+                                    vlenv);
+            ASSERT_EQ(0, hse_err_to_errno(err));
+
+            for (int j = 0; j < n; j++) {
+                ASSERT_TRUE(foundv[j]);
+                ASSERT_EQ(VLEN, vlenv[j]);
+                ASSERT_EQ(0, strcmp(keyv[j], valv[j]));
+            }
+        }
+    }
+
+    /* A key that was never written is still a miss */
+    klen = key_fmt(key, sizeof(key), 0, NKEYS);
+    err = hse_kvs_get(kvs_handle, 0, NULL, key, klen, &found, val, sizeof(val), &vlen);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+    ASSERT_FALSE(found);
+}
+
+MTF_END_UTEST_COLLECTION(cn_node_bloom_test)
@@ -3,7 +3,10 @@
  * Copyright (C) 2021-2022 Micron Technology, Inc.  All rights reserved.
  */
 
+#include <unistd.h>
+
 #include <hse/hse.h>
+#include <hse/experimental.h>
 
 #include <mtf/framework.h>
 #include <hse/test/fixtures/kvdb.h>
@@ -23,6 +26,14 @@ const char      *kvs_name = "kvs";
 #define KEY_FMT     (PFX "%d")
 #define VALUE_FMT   "value%d"
 
+/* Enough keys, ingested in several batches, to be spread over many cn
+ * leaves when every leaf that holds a key is split.
+ */
+#define LEAF_BATCHES 4
+#define LEAF_KEYS    20000
+#define LEAF_KEY_FMT (PFX "%08d")
+#define LEAF_KEY_LEN (PFX_LEN + 8)
+
 int
 test_collection_setup(struct mtf_test_info *lcl_ti)
 {
@@ -140,6 +151,54 @@ kvs_teardown(struct mtf_test_info *lcl_ti)
     return hse_err_to_errno(err);
 }
 
+static hse_err_t
+kvdb_reopen(size_t rparamc, const char *const *rparamv)
+{
+    hse_err_t err;
+
+    err = hse_kvdb_close(kvdb_handle);
+    kvdb_handle = NULL;
+    if (err)
+        return err;
+
+    return hse_kvdb_open(mtf_kvdb_home, rparamc, rparamv, &kvdb_handle);
+}
+
+/* Root spills run on every new kvset and any leaf with a key is split, so
+ * a modest amount of data quickly spreads over many leaves.
+ */
+int
+kvs_setup_split(struct mtf_test_info *lcl_ti)
+{
+    const char *rparamv[] = {
+        "durability.enabled=false",
+        "csched_rspill_params=0x01ff",
+        "csched_leaf_comp_params=0x0001ff",
+    };
+    hse_err_t err;
+
+    err = kvdb_reopen(NELEM(rparamv), rparamv);
+    if (err)
+        return hse_err_to_errno(err);
+
+    return kvs_setup(lcl_ti);
+}
+
+int
+kvs_teardown_split(struct mtf_test_info *lcl_ti)
+{
+    hse_err_t err;
+    int       rc;
+
+    rc = kvs_teardown(lcl_ti);
+
+    err = kvdb_reopen(0, NULL);
+    if (err && !rc)
+        rc = hse_err_to_errno(err);
+
+    return rc;
+}
+
 MTF_DEFINE_UTEST(cursor_api_test, create_null_kvs)
 {
     hse_err_t              err;
@@ -1000,6 +1059,155 @@ MTF_DEFINE_UTEST_PREPOST(
     ASSERT_EQ(0, err);
 }
 
+MTF_DEFINE_UTEST(cursor_api_test, read_batch_null_cursor)
+{
+    hse_err_t err;
+    size_t    pairc;
+    bool      eof;
+
+    err = hse_kvs_cursor_read_batch(
+        NULL, 0, (void *)-1, 8, 8, (struct hse_kvs_cursor_pair *)-1, 1, &pairc, &eof);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST(cursor_api_test, read_batch_invalid_flags)
+{
+    hse_err_t err;
+    size_t    pairc;
+    bool      eof;
+
+    err = hse_kvs_cursor_read_batch(
+        (struct hse_kvs_cursor *)-1,
+        81,
+        (void *)-1,
+        8,
+        8,
+        (struct hse_kvs_cursor_pair *)-1,
+        1,
+        &pairc,
+        &eof);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST(cursor_api_test, read_batch_zero_pairmax)
+{
+    hse_err_t err;
+    size_t    pairc;
+    bool      eof;
+
+    err = hse_kvs_cursor_read_batch(
+        (struct hse_kvs_cursor *)-1,
+        0,
+        (void *)-1,
+        8,
+        8,
+        (struct hse_kvs_cursor_pair *)-1,
+        0,
+        &pairc,
+        &eof);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST_PREPOST(cursor_api_test, read_batch_success, kvs_setup_with_data, kvs_teardown)
+{
+    struct hse_kvs_cursor_pair pairv[NUM_ENTRIES + 1];
+    struct hse_kvs_cursor     *cursor;
+    hse_err_t                  err;
+    size_t                     pairc;
+    bool                       eof;
+    char                       buf[25], key_buf[8], val_buf[8];
+    int                        i = 0;
+
+    err = hse_kvs_cursor_create(kvs_handle, 0, NULL, NULL, 0, &cursor);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    /* Each pair takes 10 bytes, so each batch is cut short by the buffer.
+     */
+    do {
+        err = hse_kvs_cursor_read_batch(
+            cursor, 0, buf, sizeof(buf), SIZE_MAX, pairv, NELEM(pairv), &pairc, &eof);
+        ASSERT_EQ(0, hse_err_to_errno(err));
+        ASSERT_LE(pairc, 2);
+
+        for (size_t j = 0; j < pairc; j++, i++) {
+            snprintf(key_buf, sizeof(key_buf), KEY_FMT, i);
+            snprintf(val_buf, sizeof(val_buf), VALUE_FMT, i);
+
+            ASSERT_EQ(strlen(key_buf), pairv[j].key_len);
+            ASSERT_EQ(0, memcmp(pairv[j].key, key_buf, pairv[j].key_len));
+            ASSERT_EQ(strlen(val_buf), pairv[j].val_len);
+            ASSERT_EQ(0, memcmp(pairv[j].val, val_buf, pairv[j].val_len));
+        }
+    } while (!eof);
+
+    ASSERT_EQ(NUM_ENTRIES, i);
+
+    err = hse_kvs_cursor_destroy(cursor);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST_PREPOST(cursor_api_test, read_batch_key_only, kvs_setup_with_data, kvs_teardown)
+{
+    struct hse_kvs_cursor_pair pairv[NUM_ENTRIES + 1];
+    struct hse_kvs_cursor     *cursor;
+    hse_err_t                  err;
+    size_t                     pairc;
+    bool                       eof;
+    char                       buf[64], key_buf[8];
+
+    err = hse_kvs_cursor_create(kvs_handle, 0, NULL, NULL, 0, &cursor);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = hse_kvs_cursor_read_batch(
+        cursor, HSE_CURSOR_READ_KEY_ONLY, buf, sizeof(buf), SIZE_MAX, pairv, NELEM(pairv),
+        &pairc, &eof);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+    ASSERT_EQ(NUM_ENTRIES, pairc);
+    ASSERT_TRUE(eof);
+
+    for (int i = 0; i < NUM_ENTRIES; i++) {
+        snprintf(key_buf, sizeof(key_buf), KEY_FMT, i);
+
+        ASSERT_EQ(0, memcmp(pairv[i].key, key_buf, pairv[i].key_len));
+        ASSERT_EQ(NULL, pairv[i].val);
+        ASSERT_EQ(strlen("value0"), pairv[i].val_len);
+    }
+
+    err = hse_kvs_cursor_destroy(cursor);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST_PREPOST(cursor_api_test, read_batch_nospace, kvs_setup_with_data, kvs_teardown)
+{
+    struct hse_kvs_cursor_pair pairv[1];
+    struct hse_kvs_cursor     *cursor;
+    hse_err_t                  err;
+    size_t                     pairc;
+    bool                       eof;
+    char                       buf[8];
+
+    err = hse_kvs_cursor_create(kvs_handle, 0, NULL, NULL, 0, &cursor);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = hse_kvs_cursor_read_batch(cursor, 0, buf, 4, SIZE_MAX, pairv, 1, &pairc, &eof);
+    ASSERT_EQ(ENOSPC, hse_err_to_errno(err));
+    ASSERT_EQ(0, pairc);
+
+    /* The pair that did not fit is returned again, with its value
+     * truncated to val_len_max.
+     */
+    err = hse_kvs_cursor_read_batch(cursor, 0, buf, sizeof(buf), 2, pairv, 1, &pairc, &eof);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+    ASSERT_EQ(1, pairc);
+    ASSERT_FALSE(eof);
+    ASSERT_EQ(0, memcmp(pairv[0].key, "key0", pairv[0].key_len));
+    ASSERT_EQ(strlen("value0"), pairv[0].val_len);
+    ASSERT_EQ(0, memcmp(pairv[0].val, "va", 2));
+
+    err = hse_kvs_cursor_destroy(cursor);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+}
+
 MTF_DEFINE_UTEST(cursor_api_test, seek_null_cursor)
 {
     hse_err_t err;
@@ -1193,6 +1401,182 @@ MTF_DEFINE_UTEST_PREPOST(
     ASSERT_EQ(0, hse_err_to_errno(err));
 }
 
+MTF_DEFINE_UTEST(cursor_api_test, create_partitioned_null_kvs)
+{
+    struct hse_kvs_cursor *cursorv[4];
+    unsigned int           cursorc;
+    hse_err_t              err;
+
+    err = hse_kvs_cursor_create_partitioned(NULL, 0, NULL, NELEM(cursorv), cursorv, &cursorc);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST(cursor_api_test, create_partitioned_invalid_flags)
+{
+    struct hse_kvs_cursor *cursorv[4];
+    unsigned int           cursorc;
+    hse_err_t              err;
+
+    err = hse_kvs_cursor_create_partitioned(
+        (struct hse_kvs *)-1, HSE_CURSOR_CREATE_REV, NULL, NELEM(cursorv), cursorv, &cursorc);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST(cursor_api_test, create_partitioned_zero_cursormax)
+{
+    struct hse_kvs_cursor *cursorv[4];
+    unsigned int           cursorc;
+    hse_err_t              err;
+
+    err = hse_kvs_cursor_create_partitioned((struct hse_kvs *)-1, 0, NULL, 0, cursorv, &cursorc);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST_PREPOST(
+    cursor_api_test,
+    create_partitioned_success,
+    kvs_setup_with_data,
+    kvs_teardown)
+{
+    struct hse_kvs_cursor *cursorv[4];
+    unsigned int           cursorc;
+    hse_err_t              err;
+    const void            *key, *val;
+    size_t                 key_len, val_len;
+    bool                   eof;
+    char                   key_buf[8], val_buf[8];
+    int                    i = 0;
+
+    /* All the data is in c0 and cn has a single leaf, so there is nothing
+     * to partition by (see create_partitioned_multi_leaf).
+     */
+    err = hse_kvs_cursor_create_partitioned(kvs_handle, 0, NULL, NELEM(cursorv), cursorv, &cursorc);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+    ASSERT_EQ(1, cursorc);
+
+    /* The key ranges are disjoint and ascending, so reading the cursors
+     * one after another must return every key once and in order.
+     */
+    for (unsigned int c = 0; c < cursorc; c++) {
+        while (true) {
+            err = hse_kvs_cursor_read(cursorv[c], 0, &key, &key_len, &val, &val_len, &eof);
+            ASSERT_EQ(0, hse_err_to_errno(err));
+            if (eof)
+                break;
+
+            ASSERT_LT(i, NUM_ENTRIES);
+
+            snprintf(key_buf, sizeof(key_buf), KEY_FMT, i);
+            snprintf(val_buf, sizeof(val_buf), VALUE_FMT, i);
+
+            ASSERT_EQ(strlen(key_buf), key_len);
+            ASSERT_EQ(0, memcmp(key, key_buf, key_len));
+            ASSERT_EQ(0, memcmp(val, val_buf, val_len));
+            i++;
+        }
+
+        err = hse_kvs_cursor_destroy(cursorv[c]);
+        ASSERT_EQ(0, hse_err_to_errno(err));
+    }
+
+    ASSERT_EQ(NUM_ENTRIES, i);
+}
+
+MTF_DEFINE_UTEST_PREPOST(
+    cursor_api_test,
+    create_partitioned_multi_leaf,
+    kvs_setup_split,
+    kvs_teardown_split)
+{
+    struct hse_kvs_cursor *cursor, *cursorv[8];
+    unsigned int           cursorc = 0, c;
+    hse_err_t              err;
+    const void            *key, *val;
+    size_t                 key_len, val_len;
+    bool                   eof;
+    char                   key_buf[LEAF_KEY_LEN + 1], val_buf[16];
+    char                 (*scanv)[LEAF_KEY_LEN];
+    int                    i, n;
+
+    for (int b = 0; b < LEAF_BATCHES; b++) {
+        for (i = b; i < LEAF_KEYS; i += LEAF_BATCHES) {
+            snprintf(key_buf, sizeof(key_buf), LEAF_KEY_FMT, i);
+            snprintf(val_buf, sizeof(val_buf), VALUE_FMT, i);
+
+            err = hse_kvs_put(kvs_handle, 0, NULL, key_buf, LEAF_KEY_LEN, val_buf, strlen(val_buf));
+            ASSERT_EQ(0, hse_err_to_errno(err));
+        }
+
+        err = hse_kvdb_sync(kvdb_handle, 0);
+        ASSERT_EQ(0, hse_err_to_errno(err));
+    }
+
+    /* Wait for the spills and splits to give cn several leaves */
+    for (n = 0; n < 600; n++) {
+        err = hse_kvs_cursor_create_partitioned(
+            kvs_handle, 0, NULL, NELEM(cursorv), cursorv, &cursorc);
+        ASSERT_EQ(0, hse_err_to_errno(err));
+        ASSERT_GE(cursorc, 1);
+        ASSERT_LE(cursorc, NELEM(cursorv));
+
+        if (cursorc > 1)
+            break;
+
+        err = hse_kvs_cursor_destroy(cursorv[0]);
+        ASSERT_EQ(0, hse_err_to_errno(err));
+        usleep(100 * 1000);
+    }
+    ASSERT_GT(cursorc, 1);
+
+    /* A plain cursor gives the reference scan */
+    scanv = calloc(LEAF_KEYS, sizeof(*scanv));
+    ASSERT_NE(NULL, scanv);
+
+    err = hse_kvs_cursor_create(kvs_handle, 0, NULL, NULL, 0, &cursor);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    for (n = 0; true; n++) {
+        err = hse_kvs_cursor_read(cursor, 0, &key, &key_len, &val, &val_len, &eof);
+        ASSERT_EQ(0, hse_err_to_errno(err));
+        if (eof)
+            break;
+
+        ASSERT_LT(n, LEAF_KEYS);
+        ASSERT_EQ(LEAF_KEY_LEN, key_len);
+        memcpy(scanv[n], key, key_len);
+    }
+    ASSERT_EQ(LEAF_KEYS, n);
+
+    err = hse_kvs_cursor_destroy(cursor);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    /* Read back to back, the partitions must reproduce the reference scan
+     * exactly: no key may be missing (a gap) or repeated (an overlap).
+     */
+    i = 0;
+
+    for (c = 0; c < cursorc; c++) {
+        while (true) {
+            err = hse_kvs_cursor_read(cursorv[c], 0, &key, &key_len, &val, &val_len, &eof);
+            ASSERT_EQ(0, hse_err_to_errno(err));
+            if (eof)
+                break;
+
+            ASSERT_LT(i, n);
+            ASSERT_EQ(LEAF_KEY_LEN, key_len);
+            ASSERT_EQ(0, memcmp(key, scanv[i], key_len));
+            i++;
+        }
+
+        err = hse_kvs_cursor_destroy(cursorv[c]);
+        ASSERT_EQ(0, hse_err_to_errno(err));
+    }
+
+    ASSERT_EQ(n, i);
+
+    free(scanv);
+}
+
 MTF_DEFINE_UTEST_PREPOST(cursor_api_test, update_view_null_cursor, kvs_setup, kvs_teardown)
 {
     hse_err_t err;
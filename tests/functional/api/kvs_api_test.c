@@ -526,6 +526,175 @@ MTF_DEFINE_UTEST_PREPOST(
     ASSERT_EQ(0, memcmp(valbuf, "value0", val_len));
 }
 
+MTF_DEFINE_UTEST(kvs_api_test, get_multi_null_kvs)
+{
+    const void *keyv[] = { "key0" };
+    size_t      key_lenv[] = { 4 };
+    bool        foundv[1];
+    size_t      val_lenv[1];
+    hse_err_t   err;
+
+    err = hse_kvs_get_multi(NULL, 0, NULL, 1, keyv, key_lenv, foundv, NULL, NULL, val_lenv);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST(kvs_api_test, get_multi_invalid_count)
+{
+    const void *keyv[] = { "key0" };
+    size_t      key_lenv[] = { 4 };
+    bool        foundv[1];
+    size_t      val_lenv[1];
+    hse_err_t   err;
+
+    err = hse_kvs_get_multi(
+        (struct hse_kvs *)-1, 0, NULL, 0, keyv, key_lenv, foundv, NULL, NULL, val_lenv);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+
+    err = hse_kvs_get_multi(
+        (struct hse_kvs *)-1, 0, NULL, HSE_KVS_GET_MULTI_MAX + 1, keyv, key_lenv, foundv, NULL,
+        NULL, val_lenv);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST(kvs_api_test, get_multi_key_len_is_0)
+{
+    const void *keyv[] = { "key0" };
+    size_t      key_lenv[] = { 0 };
+    bool        foundv[1];
+    size_t      val_lenv[1];
+    hse_err_t   err;
+
+    err = hse_kvs_get_multi(
+        (struct hse_kvs *)-1, 0, NULL, 1, keyv, key_lenv, foundv, NULL, NULL, val_lenv);
+    ASSERT_EQ(ENOENT, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvs_api_test, get_multi_success, kvs_setup_with_data, kvs_teardown)
+{
+    const void *keyv[] = { "key3", "xyz0", "key1", "key3", "key0" };
+    size_t      key_lenv[] = { 4, 4, 4, 4, 4 };
+    const char *expectv[] = { "value3", NULL, "value1", "value3", "value0" };
+    char        bufv[NELEM(keyv)][8];
+    void       *valbufv[NELEM(keyv)];
+    size_t      valbuf_szv[NELEM(keyv)];
+    bool        foundv[NELEM(keyv)];
+    size_t      val_lenv[NELEM(keyv)];
+    hse_err_t   err;
+
+    for (size_t i = 0; i < NELEM(keyv); i++) {
+        valbufv[i] = bufv[i];
+        valbuf_szv[i] = sizeof(bufv[i]);
+    }
+
+    err = hse_kvs_get_multi(
+        kvs_handle, 0, NULL, NELEM(keyv), keyv, key_lenv, foundv, valbufv, valbuf_szv, val_lenv);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    for (size_t i = 0; i < NELEM(keyv); i++) {
+        if (!expectv[i]) {
+            ASSERT_FALSE(foundv[i]);
+            continue;
+        }
+
+        ASSERT_TRUE(foundv[i]);
+        ASSERT_EQ(strlen(expectv[i]), val_lenv[i]);
+        ASSERT_EQ(0, memcmp(bufv[i], expectv[i], val_lenv[i]));
+    }
+
+    /* Probe for existence and value lengths only.
+     */
+    err = hse_kvs_get_multi(
+        kvs_handle, 0, NULL, NELEM(keyv), keyv, key_lenv, foundv, NULL, NULL, val_lenv);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    for (size_t i = 0; i < NELEM(keyv); i++) {
+        ASSERT_EQ(!!expectv[i], foundv[i]);
+        if (expectv[i])
+            ASSERT_EQ(strlen(expectv[i]), val_lenv[i]);
+    }
+}
+
+/* Closing the kvdb ingests everything in c0 into cn, so after reopening it
+ * all lookups are served by cn.
+ */
+static hse_err_t
+kvdb_reopen(void)
+{
+    hse_err_t err;
+
+    err = hse_kvdb_kvs_close(kvs_handle);
+    if (err)
+        return err;
+
+    err = hse_kvdb_close(kvdb_handle);
+    if (err)
+        return err;
+
+    err = hse_kvdb_open(mtf_kvdb_home, 0, NULL, &kvdb_handle);
+    if (err)
+        return err;
+
+    return hse_kvdb_kvs_open(kvdb_handle, kvs_name, 0, NULL, &kvs_handle);
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvs_api_test, get_multi_from_cn, kvs_setup_with_data, kvs_teardown)
+{
+    const void *keyv[] = { "key4", "key2", "xyz0", "key0", "key9", "key3", "key1", "abc0" };
+    size_t      key_lenv[] = { 4, 4, 4, 4, 4, 4, 4, 4 };
+    const char *expectv[] = { "value4", NULL, NULL, "value0", NULL, "VALUE3", "value1", NULL };
+    char        bufv[NELEM(keyv)][8];
+    void       *valbufv[NELEM(keyv)];
+    size_t      valbuf_szv[NELEM(keyv)];
+    bool        foundv[NELEM(keyv)];
+    size_t      val_lenv[NELEM(keyv)];
+    hse_err_t   err;
+
+    err = kvdb_reopen();
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    /* Tombstone one key and update another in a newer kvset, so that the
+     * lookups must resolve them against the older kvset in the same node.
+     */
+    err = hse_kvs_delete(kvs_handle, 0, NULL, "key2", 4);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = hse_kvs_put(kvs_handle, 0, NULL, "key3", 4, "VALUE3", 6);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = kvdb_reopen();
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    for (size_t i = 0; i < NELEM(keyv); i++) {
+        valbufv[i] = bufv[i];
+        valbuf_szv[i] = sizeof(bufv[i]);
+    }
+
+    err = hse_kvs_get_multi(
+        kvs_handle, 0, NULL, NELEM(keyv), keyv, key_lenv, foundv, valbufv, valbuf_szv, val_lenv);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    for (size_t i = 0; i < NELEM(keyv); i++) {
+        size_t vlen;
+        bool   found;
+
+        /* The batched and the single-key lookups must agree.
+         */
+        err = hse_kvs_get(kvs_handle, 0, NULL, keyv[i], key_lenv[i], &found, NULL, 0, &vlen);
+        ASSERT_EQ(0, hse_err_to_errno(err));
+        ASSERT_EQ(!!expectv[i], found);
+
+        if (!expectv[i]) {
+            ASSERT_FALSE(foundv[i]);
+            continue;
+        }
+
+        ASSERT_TRUE(foundv[i]);
+        ASSERT_EQ(strlen(expectv[i]), val_lenv[i]);
+        ASSERT_EQ(vlen, val_lenv[i]);
+        ASSERT_EQ(0, memcmp(bufv[i], expectv[i], val_lenv[i]));
+    }
+}
+
 MTF_DEFINE_UTEST(kvs_api_test, name_null_kvs)
 {
     const char *name;
@@ -776,6 +945,180 @@ MTF_DEFINE_UTEST_PREPOST(kvs_api_test, put_vcomp_exclusivity, kvs_setup_with_dat
     ASSERT_EQ(EINVAL, merr_errno(err));
 }
 
+MTF_DEFINE_UTEST(kvs_api_test, write_batch_null_kvdb)
+{
+    struct hse_kvs_batch_op opv[] = {
+        { (struct hse_kvs *)-1, HSE_KVS_BATCH_PUT, "key0", 4, "value0", 6 },
+    };
+    hse_err_t err;
+
+    err = hse_kvs_write_batch(NULL, 0, NULL, NELEM(opv), opv);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST(kvs_api_test, write_batch_invalid_count)
+{
+    struct hse_kvs_batch_op opv[] = {
+        { (struct hse_kvs *)-1, HSE_KVS_BATCH_PUT, "key0", 4, "value0", 6 },
+    };
+    hse_err_t err;
+
+    err = hse_kvs_write_batch((struct hse_kvdb *)-1, 0, NULL, 0, opv);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+
+    err = hse_kvs_write_batch((struct hse_kvdb *)-1, 0, NULL, HSE_KVS_WRITE_BATCH_MAX + 1, opv);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+
+    err = hse_kvs_write_batch((struct hse_kvdb *)-1, 0, NULL, 1, NULL);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST(kvs_api_test, write_batch_invalid_op)
+{
+    struct hse_kvs_batch_op opv[] = {
+        { NULL, HSE_KVS_BATCH_PUT, "key0", 4, "value0", 6 },
+    };
+    hse_err_t err;
+
+    err = hse_kvs_write_batch((struct hse_kvdb *)-1, 0, NULL, NELEM(opv), opv);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+
+    opv[0].kbo_kvs = (struct hse_kvs *)-1;
+    opv[0].kbo_type = HSE_KVS_BATCH_PREFIX_DELETE + 1;
+    err = hse_kvs_write_batch((struct hse_kvdb *)-1, 0, NULL, NELEM(opv), opv);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+
+    opv[0].kbo_type = HSE_KVS_BATCH_PUT;
+    opv[0].kbo_val = NULL;
+    err = hse_kvs_write_batch((struct hse_kvdb *)-1, 0, NULL, NELEM(opv), opv);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST(kvs_api_test, write_batch_key_len_is_0)
+{
+    struct hse_kvs_batch_op opv[] = {
+        { (struct hse_kvs *)-1, HSE_KVS_BATCH_DELETE, "key0", 0, NULL, 0 },
+    };
+    hse_err_t err;
+
+    err = hse_kvs_write_batch((struct hse_kvdb *)-1, 0, NULL, NELEM(opv), opv);
+    ASSERT_EQ(ENOENT, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST(kvs_api_test, write_batch_len_too_long)
+{
+    struct hse_kvs_batch_op opv[] = {
+        { (struct hse_kvs *)-1, HSE_KVS_BATCH_PUT, "key0", HSE_KVS_KEY_LEN_MAX + 1, "v", 1 },
+    };
+    hse_err_t err;
+
+    err = hse_kvs_write_batch((struct hse_kvdb *)-1, 0, NULL, NELEM(opv), opv);
+    ASSERT_EQ(ENAMETOOLONG, hse_err_to_errno(err));
+
+    opv[0].kbo_type = HSE_KVS_BATCH_PREFIX_DELETE;
+    opv[0].kbo_key_len = HSE_KVS_PFX_LEN_MAX + 1;
+    err = hse_kvs_write_batch((struct hse_kvdb *)-1, 0, NULL, NELEM(opv), opv);
+    ASSERT_EQ(ENAMETOOLONG, hse_err_to_errno(err));
+
+    opv[0].kbo_type = HSE_KVS_BATCH_PUT;
+    opv[0].kbo_key_len = 4;
+    opv[0].kbo_val_len = HSE_KVS_VALUE_LEN_MAX + 1;
+    err = hse_kvs_write_batch((struct hse_kvdb *)-1, 0, NULL, NELEM(opv), opv);
+    ASSERT_EQ(EMSGSIZE, hse_err_to_errno(err));
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvs_api_test, write_batch_success, kvs_setup_with_data, kvs_teardown)
+{
+    struct hse_kvs_batch_op opv[] = {
+        { kvs_handle, HSE_KVS_BATCH_PUT, "key7", 4, "value7", 6 },
+        { kvs_handle, HSE_KVS_BATCH_DELETE, "key1", 4, NULL, 0 },
+        { kvs_handle, HSE_KVS_BATCH_PUT, "key3", 4, "value33", 7 },
+        { kvs_handle, HSE_KVS_BATCH_PUT, "abc0", 4, "abc", 3 },
+    };
+    const char *keyv[] = { "key0", "key1", "key3", "key7", "abc0" };
+    const char *expectv[] = { "value0", NULL, "value33", "value7", "abc" };
+    char        val_buf[8];
+    size_t      val_len;
+    bool        found;
+    hse_err_t   err;
+
+    err = hse_kvs_write_batch(kvdb_handle, 0, NULL, NELEM(opv), opv);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    for (size_t i = 0; i < NELEM(keyv); i++) {
+        err = hse_kvs_get(
+            kvs_handle, 0, NULL, keyv[i], strlen(keyv[i]), &found, val_buf, sizeof(val_buf),
+            &val_len);
+        ASSERT_EQ(0, hse_err_to_errno(err));
+        ASSERT_EQ(!!expectv[i], found);
+        if (expectv[i]) {
+            ASSERT_EQ(strlen(expectv[i]), val_len);
+            ASSERT_EQ(0, memcmp(val_buf, expectv[i], val_len));
+        }
+    }
+
+    opv[0].kbo_type = HSE_KVS_BATCH_PREFIX_DELETE;
+    opv[0].kbo_key = PFX;
+    opv[0].kbo_key_len = PFX_LEN;
+
+    err = hse_kvs_write_batch(kvdb_handle, 0, NULL, 1, opv);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    for (size_t i = 0; i < NELEM(keyv); i++) {
+        err = hse_kvs_get(
+            kvs_handle, 0, NULL, keyv[i], strlen(keyv[i]), &found, NULL, 0, &val_len);
+        ASSERT_EQ(0, hse_err_to_errno(err));
+        ASSERT_EQ(i == NELEM(keyv) - 1, found);
+    }
+}
+
+MTF_DEFINE_UTEST_PREPOST(
+    kvs_api_test,
+    write_batch_transactional,
+    transactional_kvs_setup_with_data,
+    kvs_teardown)
+{
+    struct hse_kvs_batch_op opv[] = {
+        { kvs_handle, HSE_KVS_BATCH_PUT, "key7", 4, "value7", 6 },
+        { kvs_handle, HSE_KVS_BATCH_DELETE, "key0", 4, NULL, 0 },
+    };
+    struct hse_kvdb_txn *txn;
+    size_t               val_len;
+    bool                 found;
+    hse_err_t            err;
+
+    /* Non-transactional batches are not allowed on a transactional KVS. */
+    err = hse_kvs_write_batch(kvdb_handle, 0, NULL, NELEM(opv), opv);
+    ASSERT_EQ(EINVAL, hse_err_to_errno(err));
+
+    txn = hse_kvdb_txn_alloc(kvdb_handle);
+    ASSERT_NE(NULL, txn);
+
+    err = hse_kvdb_txn_begin(kvdb_handle, txn);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = hse_kvs_write_batch(kvdb_handle, 0, txn, NELEM(opv), opv);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    /* Not visible outside the txn until commit. */
+    err = hse_kvs_get(kvs_handle, 0, NULL, "key7", 4, &found, NULL, 0, &val_len);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+    ASSERT_FALSE(found);
+
+    err = hse_kvdb_txn_commit(kvdb_handle, txn);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = hse_kvs_get(kvs_handle, 0, NULL, "key7", 4, &found, NULL, 0, &val_len);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+    ASSERT_TRUE(found);
+
+    err = hse_kvs_get(kvs_handle, 0, NULL, "key0", 4, &found, NULL, 0, &val_len);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+    ASSERT_FALSE(found);
+
+    hse_kvdb_txn_free(kvdb_handle, txn);
+}
+
 MTF_DEFINE_UTEST(kvs_api_test, prefix_probe_null_kvs)
 {
     hse_err_t err;
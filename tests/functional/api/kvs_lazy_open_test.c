@@ -0,0 +1,530 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+/* Lazily opened kvsets need real mblocks behind them, hence these tests
+ * run against a kvdb and inspect its cn tree through the internal API.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <hse/hse.h>
+#include <hse/experimental.h>
+#include <hse/test/fixtures/kvdb.h>
+
+#include <mtf/framework.h>
+
+#include <hse_util/base.h>
+#include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/ikvdb.h>
+#include <hse_ikvdb/limits.h>
+#include <hse_ikvdb/tuple.h>
+#include <mpool/mpool.h>
+
+#include <cn/cn_tree.h>
+#include <cn/cn_tree_internal.h>
+#include <cn/kvset.h>
+
+#define KVS_NAME    "kvs"
+#define NBATCH      (3)
+#define NKEYS       (2000)
+#define NTHREADS    (8)
+#define VLEN        (256)
+#define KEY_FMT     "k%d-%06d"
+
+struct hse_kvdb *kvdb_handle;
+struct hse_kvs  *kvs_handle;
+
+static const char *kvdb_rparamv[] = { "durability.enabled=false" };
+static const char *kvs_rparamv[] = { "cn_kvset_lazy_open=true" };
+
+static int
+key_fmt(char *buf, size_t bufsz, int batch, int i)
+{
+    return snprintf(buf, bufsz, KEY_FMT, batch, i);
+}
+
+static void
+val_fmt(char *buf, int batch, int i)
+{
+    memset(buf, 'a' + (batch * NKEYS + i) % 26, VLEN);
+    key_fmt(buf, VLEN, batch, i);
+}
+
+/* Write NBATCH disjoint key ranges, one kvset each (the root spills only
+ * at five or more kvsets), then close the kvdb so that the cndb records a
+ * summary for every kvset.
+ */
+int
+populate(struct mtf_test_info *lcl_ti)
+{
+    const char *cparamv[] = { "prefix.length=3", "suffix.length=1" };
+    char key[32], val[VLEN];
+    hse_err_t err;
+
+    err = fxt_kvdb_setup(mtf_kvdb_home, NELEM(kvdb_rparamv), kvdb_rparamv, 0, NULL, &kvdb_handle);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    err = hse_kvdb_kvs_create(kvdb_handle, KVS_NAME, NELEM(cparamv), cparamv);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    err = hse_kvdb_kvs_open(kvdb_handle, KVS_NAME, 0, NULL, &kvs_handle);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    for (int b = 0; b < NBATCH; b++) {
+        for (int i = 0; i < NKEYS; i++) {
+            int klen = key_fmt(key, sizeof(key), b, i);
+
+            val_fmt(val, b, i);
+
+            err = hse_kvs_put(kvs_handle, 0, NULL, key, klen, val, sizeof(val));
+            ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+        }
+
+        err = hse_kvdb_sync(kvdb_handle, 0);
+        ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+    }
+
+    err = hse_kvdb_kvs_close(kvs_handle);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    err = hse_kvdb_close(kvdb_handle);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    kvs_handle = NULL;
+    kvdb_handle = NULL;
+
+    return 0;
+}
+
+static hse_err_t
+reopen(size_t rparamc, const char **rparamv)
+{
+    hse_err_t err;
+
+    err = hse_kvdb_open(mtf_kvdb_home, rparamc, rparamv, &kvdb_handle);
+    if (err)
+        return err;
+
+    return hse_kvdb_kvs_open(kvdb_handle, KVS_NAME, NELEM(kvs_rparamv), kvs_rparamv, &kvs_handle);
+}
+
+int
+populate_reopen(struct mtf_test_info *lcl_ti)
+{
+    hse_err_t err;
+    int rc;
+
+    rc = populate(lcl_ti);
+    if (rc)
+        return rc;
+
+    err = reopen(NELEM(kvdb_rparamv), kvdb_rparamv);
+
+    return hse_err_to_errno(err);
+}
+
+int
+teardown(struct mtf_test_info *lcl_ti)
+{
+    hse_err_t err;
+
+    if (kvs_handle)
+        hse_kvdb_kvs_close(kvs_handle);
+
+    err = fxt_kvdb_teardown(mtf_kvdb_home, kvdb_handle);
+
+    kvs_handle = NULL;
+    kvdb_handle = NULL;
+
+    return hse_err_to_errno(err);
+}
+
+static struct cn_tree *
+tree_get(void)
+{
+    return cn_get_tree(ikvdb_kvs_get_cn(kvs_handle));
+}
+
+/* Batch whose key range the kvset covers */
+static int
+kvset_batch(struct kvset *ks)
+{
+    const void *key;
+    u16 klen;
+
+    kvset_minkey(ks, &key, &klen);
+
+    return ((const char *)key)[1] - '0';
+}
+
+/* Collect the kvsets of the whole tree, indexed by batch if ksv is given */
+static uint
+kvsets_get(struct kvset **ksv, uint *loaded, uint *rootc)
+{
+    struct cn_tree *tree = tree_get();
+    struct cn_tree_node *tn;
+    void *lock;
+    uint n = 0;
+
+    *loaded = 0;
+    if (rootc)
+        *rootc = 0;
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    cn_tree_foreach_node(tn, tree) {
+        struct kvset_list_entry *le;
+
+        list_for_each_entry(le, &tn->tn_kvset_list, le_link) {
+            if (kvset_is_loaded(le->le_kvset))
+                (*loaded)++;
+            if (ksv)
+                ksv[kvset_batch(le->le_kvset)] = le->le_kvset;
+            if (rootc && tn == tree->ct_root)
+                (*rootc)++;
+            n++;
+        }
+    }
+    rmlock_runlock(lock);
+
+    return n;
+}
+
+static int
+get_check(int batch, int i, bool *found)
+{
+    char key[32], val[VLEN], expect[VLEN];
+    size_t vlen;
+    hse_err_t err;
+    int klen;
+
+    klen = key_fmt(key, sizeof(key), batch, i);
+
+    err = hse_kvs_get(kvs_handle, 0, NULL, key, klen, found, val, sizeof(val), &vlen);
+    if (err)
+        return hse_err_to_errno(err);
+
+    if (!*found)
+        return 0;
+
+    val_fmt(expect, batch, i);
+
+    return (vlen == sizeof(val) && !memcmp(val, expect, vlen)) ? 0 : EBADMSG;
+}
+
+static int
+scan_check(void)
+{
+    struct hse_kvs_cursor *cur;
+    const void *key, *val;
+    size_t klen, vlen;
+    char expect[32];
+    bool eof = false;
+    hse_err_t err;
+    int n = 0;
+
+    err = hse_kvs_cursor_create(kvs_handle, 0, NULL, NULL, 0, &cur);
+    if (err)
+        return -1;
+
+    while (!err) {
+        err = hse_kvs_cursor_read(cur, 0, &key, &klen, &val, &vlen, &eof);
+        if (err || eof)
+            break;
+
+        key_fmt(expect, sizeof(expect), n / NKEYS, n % NKEYS);
+        if (klen != strlen(expect) || memcmp(key, expect, klen) || vlen != VLEN)
+            break;
+        n++;
+    }
+
+    hse_kvs_cursor_destroy(cur);
+
+    return n;
+}
+
+MTF_BEGIN_UTEST_COLLECTION(kvs_lazy_open_test)
+
+MTF_DEFINE_UTEST_PREPOST(kvs_lazy_open_test, point_get, populate_reopen, teardown)
+{
+    struct kvset *ksv[NBATCH] = { 0 };
+    char val[VLEN];
+    size_t vlen;
+    uint loaded, n;
+    bool found;
+    int rc;
+
+    n = kvsets_get(ksv, &loaded, NULL);
+    ASSERT_EQ(NBATCH, n);
+    ASSERT_EQ(0, loaded);
+
+    /* A key outside every kvset's bounds loads nothing */
+    rc = hse_err_to_errno(hse_kvs_get(kvs_handle, 0, NULL, "a", 1, &found, val, sizeof(val), &vlen));
+    ASSERT_EQ(0, rc);
+    ASSERT_FALSE(found);
+
+    kvsets_get(NULL, &loaded, NULL);
+    ASSERT_EQ(0, loaded);
+
+    /* A key within a kvset's bounds loads that kvset only */
+    rc = get_check(1, 10, &found);
+    ASSERT_EQ(0, rc);
+    ASSERT_TRUE(found);
+
+    kvsets_get(NULL, &loaded, NULL);
+    ASSERT_EQ(1, loaded);
+    ASSERT_TRUE(kvset_is_loaded(ksv[1]));
+
+    /* A miss between two kvsets' bounds loads neither of them */
+    rc = get_check(1, NKEYS, &found);
+    ASSERT_EQ(0, rc);
+    ASSERT_FALSE(found);
+
+    kvsets_get(NULL, &loaded, NULL);
+    ASSERT_EQ(1, loaded);
+
+    for (int b = 0; b < NBATCH; b++) {
+        rc = get_check(b, NKEYS - 1, &found);
+        ASSERT_EQ(0, rc);
+        ASSERT_TRUE(found);
+    }
+
+    kvsets_get(NULL, &loaded, NULL);
+    ASSERT_EQ(NBATCH, loaded);
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvs_lazy_open_test, prefix_probe, populate_reopen, teardown)
+{
+    struct kvset *ksv[NBATCH] = { 0 };
+    char kbuf[HSE_KVS_KEY_LEN_MAX], vbuf[VLEN], key[32];
+    struct kvs_buf kb, vb;
+    struct kvs_ktuple kt;
+    enum key_lookup_res res;
+    uint loaded;
+    merr_t err;
+    int klen;
+
+    kvsets_get(ksv, &loaded, NULL);
+    ASSERT_EQ(0, loaded);
+
+    /* Ten keys share this prefix (the suffix is one byte), all in the
+     * newest kvset, so the probe stops there.
+     */
+    klen = key_fmt(key, sizeof(key), NBATCH - 1, 10);
+    kvs_ktuple_init(&kt, key, klen - 1);
+    kvs_buf_init(&kb, kbuf, sizeof(kbuf));
+    kvs_buf_init(&vb, vbuf, sizeof(vbuf));
+
+    err = ikvdb_kvs_pfx_probe(kvs_handle, 0, NULL, &kt, &res, &kb, &vb);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(FOUND_MULTIPLE, res);
+
+    kvsets_get(NULL, &loaded, NULL);
+    ASSERT_EQ(1, loaded);
+    ASSERT_TRUE(kvset_is_loaded(ksv[NBATCH - 1]));
+
+    /* A probe that must reach the oldest kvset loads every kvset it
+     * passes on the way.
+     */
+    klen = key_fmt(key, sizeof(key), 0, 10);
+    kvs_ktuple_init(&kt, key, klen - 1);
+    kvs_buf_init(&kb, kbuf, sizeof(kbuf));
+    kvs_buf_init(&vb, vbuf, sizeof(vbuf));
+
+    err = ikvdb_kvs_pfx_probe(kvs_handle, 0, NULL, &kt, &res, &kb, &vb);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(FOUND_MULTIPLE, res);
+
+    kvsets_get(NULL, &loaded, NULL);
+    ASSERT_EQ(NBATCH, loaded);
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvs_lazy_open_test, cursor_create, populate_reopen, teardown)
+{
+    uint loaded;
+    int n;
+
+    kvsets_get(NULL, &loaded, NULL);
+    ASSERT_EQ(0, loaded);
+
+    n = scan_check();
+    ASSERT_EQ(NBATCH * NKEYS, n);
+
+    kvsets_get(NULL, &loaded, NULL);
+    ASSERT_EQ(NBATCH, loaded);
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvs_lazy_open_test, compaction, populate, teardown)
+{
+    const char *rparamv[] = { "durability.enabled=false", "csched_rspill_params=0x0101" };
+    uint loaded, rootc, n;
+    hse_err_t err;
+    bool found;
+    int i, rc;
+
+    /* Let the root spill one kvset at a time, each of them unloaded */
+    err = reopen(NELEM(rparamv), rparamv);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    for (i = 0; i < 600; i++) {
+        kvsets_get(NULL, &loaded, &rootc);
+        if (rootc == 0)
+            break;
+        usleep(100 * 1000);
+    }
+    ASSERT_EQ(0, rootc);
+
+    /* Spill outputs are built, hence loaded, kvsets */
+    n = kvsets_get(NULL, &loaded, NULL);
+    ASSERT_GT(n, 0);
+    ASSERT_EQ(n, loaded);
+
+    for (int b = 0; b < NBATCH; b++) {
+        for (i = 0; i < NKEYS; i += 97) {
+            rc = get_check(b, i, &found);
+            ASSERT_EQ(0, rc);
+            ASSERT_TRUE(found);
+        }
+    }
+
+    ASSERT_EQ(NBATCH * NKEYS, scan_check());
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvs_lazy_open_test, delete_unloaded, populate_reopen, teardown)
+{
+    struct cn_tree *tree = tree_get();
+    struct kvset_list_entry *le;
+    struct mblock_props props;
+    struct kvset *ks;
+    struct mpool *mp;
+    uint64_t vblkidv[64];
+    uint vblkc, loaded, i, n;
+    bool found;
+    merr_t err;
+    int rc;
+
+    n = kvsets_get(NULL, &loaded, NULL);
+    ASSERT_EQ(NBATCH, n);
+    ASSERT_EQ(0, loaded);
+
+    mp = cn_get_dataset(ikvdb_kvs_get_cn(kvs_handle));
+
+    /* The oldest kvset, at the tail of the root's list */
+    le = list_last_entry(&tree->ct_root->tn_kvset_list, struct kvset_list_entry, le_link);
+    ks = le->le_kvset;
+    ASSERT_EQ(0, kvset_batch(ks));
+
+    vblkc = kvset_get_num_vblocks(ks);
+    ASSERT_GT(vblkc, 0);
+    ASSERT_LE(vblkc, NELEM(vblkidv));
+
+    for (i = 0; i < vblkc; i++) {
+        vblkidv[i] = kvset_get_nth_vblock_id(ks, i);
+
+        err = mpool_mblock_props_get(mp, vblkidv[i], &props);
+        ASSERT_EQ(0, err);
+    }
+
+    /* Retire the oldest kvset the way a compaction would, without ever
+     * loading it.  Its vblocks have no mbset, the kvset must delete them.
+     */
+    rmlock_wlock(&tree->ct_lock);
+    list_del_init(&le->le_link);
+    rmlock_wunlock(&tree->ct_lock);
+
+    ASSERT_FALSE(kvset_is_loaded(ks));
+    kvset_mark_mblocks_for_delete(ks, false);
+    kvset_put_ref(ks);
+
+    /* The final put closes the kvset asynchronously */
+    for (n = 0; n < 100; n++) {
+        for (i = 0; i < vblkc; i++) {
+            if (!mpool_mblock_props_get(mp, vblkidv[i], &props))
+                break;
+        }
+        if (i == vblkc)
+            break;
+        usleep(100 * 1000);
+    }
+    ASSERT_EQ(vblkc, i);
+
+    /* The other kvsets are unaffected */
+    kvsets_get(NULL, &loaded, NULL);
+    ASSERT_EQ(0, loaded);
+
+    rc = get_check(1, 0, &found);
+    ASSERT_EQ(0, rc);
+    ASSERT_TRUE(found);
+
+    rc = get_check(0, 0, &found);
+    ASSERT_EQ(0, rc);
+    ASSERT_FALSE(found);
+}
+
+static pthread_barrier_t load_barrier;
+static struct kvset     *load_ksv[NBATCH];
+
+static void *
+load_worker(void *arg)
+{
+    long id = (long)arg;
+    merr_t err = 0;
+    bool found;
+    int rc = 0;
+
+    pthread_barrier_wait(&load_barrier);
+
+    /* Half the threads load directly, the others through lookups */
+    for (int b = 0; b < NBATCH && !err && !rc; b++) {
+        if (id % 2)
+            err = kvset_load(load_ksv[(b + id) % NBATCH]);
+        else
+            rc = get_check((b + id) % NBATCH, id, &found);
+
+        if (!rc && !(id % 2) && !found)
+            rc = ENOENT;
+    }
+
+    return (void *)(long)(err ? merr_errno(err) : rc);
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvs_lazy_open_test, load_race, populate_reopen, teardown)
+{
+    pthread_t tidv[NTHREADS];
+    uint loaded;
+    void *rval;
+    int rc;
+
+    kvsets_get(load_ksv, &loaded, NULL);
+    ASSERT_EQ(0, loaded);
+
+    rc = pthread_barrier_init(&load_barrier, NULL, NTHREADS);
+    ASSERT_EQ(0, rc);
+
+    for (long i = 0; i < NTHREADS; i++) {
+        rc = pthread_create(&tidv[i], NULL, load_worker, (void *)i);
+        ASSERT_EQ(0, rc);
+    }
+
+    for (int i = 0; i < NTHREADS; i++) {
+        rc = pthread_join(tidv[i], &rval);
+        ASSERT_EQ(0, rc);
+        ASSERT_EQ(0, (long)rval);
+    }
+
+    pthread_barrier_destroy(&load_barrier);
+
+    kvsets_get(NULL, &loaded, NULL);
+    ASSERT_EQ(NBATCH, loaded);
+
+    /* Loading an already loaded kvset is a no-op */
+    for (int b = 0; b < NBATCH; b++)
+        ASSERT_EQ(0, kvset_load(load_ksv[b]));
+
+    ASSERT_EQ(NBATCH * NKEYS, scan_check());
+}
+
+MTF_END_UTEST_COLLECTION(kvs_lazy_open_test)
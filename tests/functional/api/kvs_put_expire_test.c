@@ -0,0 +1,522 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+/* An expired value must read as deleted wherever it lives, compaction must
+ * turn it into a tombstone, and a value that has yet to expire must keep its
+ * expiry time as it moves through the cn tree.
+ */
+
+#include <time.h>
+#include <unistd.h>
+
+#include <hse/hse.h>
+#include <hse/experimental.h>
+#include <hse/test/fixtures/kvdb.h>
+
+#include <mtf/framework.h>
+
+#include <hse_util/base.h>
+#include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/ikvdb.h>
+#include <hse_ikvdb/limits.h>
+
+#include <cn/cn_metrics.h>
+#include <cn/cn_tree.h>
+#include <cn/cn_tree_internal.h>
+#include <cn/kvset.h>
+
+#define KVS_NAME    "kvs"
+#define NGRP        (3)
+#define NKEYS       (6)
+#define KEY_FMT     "g%02d.%04d"
+#define PFX_FMT     "g%02d."
+#define SOON_SECS   (3)
+
+struct hse_kvdb *kvdb_handle;
+struct hse_kvs  *kvs_handle;
+
+static const char *kvs_cparamv[] = { "prefix.length=3", "suffix.length=4" };
+
+static uint64_t soon_expire, far_expire;
+
+enum key_kind {
+    KEY_NONE, /* never expires */
+    KEY_FAR,  /* expires long after the test */
+    KEY_SOON, /* expires during the test */
+};
+
+/* Group 0 keeps two keys, group 1 loses all of its keys and
+ * group 2 keeps only its first key once the SOON keys expire.
+ */
+static enum key_kind
+key_kind(int g, int i)
+{
+    switch (g) {
+    case 0:
+        return i == 0 ? KEY_NONE : (i == 1 ? KEY_FAR : KEY_SOON);
+    case 1:
+        return KEY_SOON;
+    default:
+        return i == 0 ? KEY_FAR : KEY_SOON;
+    }
+}
+
+static bool
+key_visible(int g, int i, bool expired)
+{
+    return !expired || key_kind(g, i) != KEY_SOON;
+}
+
+static uint
+key_count(enum key_kind kind)
+{
+    uint n = 0;
+
+    for (int g = 0; g < NGRP; g++)
+        for (int i = 0; i < NKEYS; i++)
+            n += (key_kind(g, i) == kind);
+
+    return n;
+}
+
+static int
+key_fmt(char *buf, size_t bufsz, int g, int i)
+{
+    return snprintf(buf, bufsz, KEY_FMT, g, i);
+}
+
+static hse_err_t
+load_keys(void)
+{
+    char key[32];
+    hse_err_t err;
+
+    soon_expire = time(NULL) + SOON_SECS;
+    far_expire = time(NULL) + 3600;
+
+    for (int g = 0; g < NGRP; g++) {
+        for (int i = 0; i < NKEYS; i++) {
+            int klen = key_fmt(key, sizeof(key), g, i);
+
+            switch (key_kind(g, i)) {
+            case KEY_NONE:
+                err = hse_kvs_put(kvs_handle, 0, NULL, key, klen, key, klen);
+                break;
+            case KEY_FAR:
+                err = hse_kvs_put_expire(kvs_handle, 0, NULL, key, klen, key, klen, far_expire);
+                break;
+            default:
+                err = hse_kvs_put_expire(kvs_handle, 0, NULL, key, klen, key, klen, soon_expire);
+                break;
+            }
+
+            if (err)
+                return err;
+        }
+    }
+
+    return 0;
+}
+
+static void
+wait_expired(void)
+{
+    while (time(NULL) <= soon_expire)
+        usleep(100 * 1000);
+}
+
+static int
+verify_get(struct mtf_test_info *lcl_ti, bool expired)
+{
+    char key[32], val[32];
+    hse_err_t err;
+    size_t vlen;
+    bool found;
+
+    for (int g = 0; g < NGRP; g++) {
+        for (int i = 0; i < NKEYS; i++) {
+            int klen = key_fmt(key, sizeof(key), g, i);
+
+            err = hse_kvs_get(kvs_handle, 0, NULL, key, klen, &found, val, sizeof(val), &vlen);
+            ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+            ASSERT_EQ_RET(key_visible(g, i, expired), found, -1);
+
+            if (found) {
+                ASSERT_EQ_RET(klen, vlen, -1);
+                ASSERT_EQ_RET(0, memcmp(key, val, vlen), -1);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int
+verify_cursor(struct mtf_test_info *lcl_ti, bool expired)
+{
+    struct hse_kvs_cursor *cursor;
+    const void *key, *val;
+    size_t klen, vlen;
+    char expect[32];
+    hse_err_t err;
+    bool eof;
+
+    err = hse_kvs_cursor_create(kvs_handle, 0, NULL, NULL, 0, &cursor);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+
+    for (int g = 0; g < NGRP; g++) {
+        for (int i = 0; i < NKEYS; i++) {
+            int elen;
+
+            if (!key_visible(g, i, expired))
+                continue;
+
+            elen = key_fmt(expect, sizeof(expect), g, i);
+
+            err = hse_kvs_cursor_read(cursor, 0, &key, &klen, &val, &vlen, &eof);
+            ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+            ASSERT_FALSE_RET(eof, -1);
+            ASSERT_EQ_RET(elen, klen, -1);
+            ASSERT_EQ_RET(0, memcmp(expect, key, klen), -1);
+            ASSERT_EQ_RET(elen, vlen, -1);
+            ASSERT_EQ_RET(0, memcmp(expect, val, vlen), -1);
+        }
+    }
+
+    err = hse_kvs_cursor_read(cursor, 0, &key, &klen, &val, &vlen, &eof);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+    ASSERT_TRUE_RET(eof, -1);
+
+    err = hse_kvs_cursor_destroy(cursor);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+
+    return 0;
+}
+
+static int
+verify_probe(struct mtf_test_info *lcl_ti, bool expired)
+{
+    char pfx[32], kbuf[HSE_KVS_KEY_LEN_MAX], vbuf[32], expect[32];
+    enum hse_kvs_pfx_probe_cnt found;
+    size_t klen, vlen;
+    hse_err_t err;
+
+    for (int g = 0; g < NGRP; g++) {
+        int pfxlen, n = 0, first = -1;
+
+        for (int i = 0; i < NKEYS; i++) {
+            if (key_visible(g, i, expired)) {
+                if (first < 0)
+                    first = i;
+                n++;
+            }
+        }
+
+        pfxlen = snprintf(pfx, sizeof(pfx), PFX_FMT, g);
+
+        err = hse_kvs_prefix_probe(kvs_handle, 0, NULL, pfx, pfxlen, &found, kbuf, sizeof(kbuf),
+                                   &klen, vbuf, sizeof(vbuf), &vlen);
+        ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+
+        if (n == 0) {
+            ASSERT_EQ_RET(HSE_KVS_PFX_FOUND_ZERO, found, -1);
+        } else if (n == 1) {
+            int elen = key_fmt(expect, sizeof(expect), g, first);
+
+            ASSERT_EQ_RET(HSE_KVS_PFX_FOUND_ONE, found, -1);
+            ASSERT_EQ_RET(elen, klen, -1);
+            ASSERT_EQ_RET(0, memcmp(expect, kbuf, klen), -1);
+            ASSERT_EQ_RET(elen, vlen, -1);
+            ASSERT_EQ_RET(0, memcmp(expect, vbuf, vlen), -1);
+        } else {
+            ASSERT_EQ_RET(HSE_KVS_PFX_FOUND_MUL, found, -1);
+        }
+    }
+
+    return 0;
+}
+
+static int
+verify(struct mtf_test_info *lcl_ti, bool expired)
+{
+    ASSERT_EQ_RET(0, verify_get(lcl_ti, expired), -1);
+    ASSERT_EQ_RET(0, verify_cursor(lcl_ti, expired), -1);
+    ASSERT_EQ_RET(0, verify_probe(lcl_ti, expired), -1);
+
+    return 0;
+}
+
+static hse_err_t
+reopen(size_t rparamc, const char **rparamv)
+{
+    hse_err_t err;
+
+    err = hse_kvdb_open(mtf_kvdb_home, rparamc, rparamv, &kvdb_handle);
+    if (err)
+        return err;
+
+    return hse_kvdb_kvs_open(kvdb_handle, KVS_NAME, 0, NULL, &kvs_handle);
+}
+
+static void
+close_all(void)
+{
+    hse_kvdb_kvs_close(kvs_handle);
+    hse_kvdb_close(kvdb_handle);
+
+    kvs_handle = NULL;
+    kvdb_handle = NULL;
+}
+
+static struct cn_tree *
+kvs_tree(void)
+{
+    return cn_get_tree(ikvdb_kvs_get_cn(kvs_handle));
+}
+
+/* Sum the stats of the kvsets in the root (leaves == false) or in the leaves,
+ * tracking the earliest and latest expiry times across all of them.
+ */
+static uint
+tree_stats(struct cn_tree *tree, bool leaves, struct kvset_stats *st)
+{
+    struct cn_tree_node *tn;
+    uint kvsets = 0;
+    void *lock;
+
+    memset(st, 0, sizeof(*st));
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    cn_tree_foreach_node(tn, tree) {
+        struct kvset_list_entry *le;
+
+        if (leaves == (tn == tree->ct_root))
+            continue;
+
+        list_for_each_entry(le, &tn->tn_kvset_list, le_link) {
+            const struct kvset_stats *ks = kvset_statsp(le->le_kvset);
+
+            st->kst_keys += ks->kst_keys;
+            st->kst_tombs += ks->kst_tombs;
+
+            if (ks->kst_ttl_min && (!st->kst_ttl_min || ks->kst_ttl_min < st->kst_ttl_min))
+                st->kst_ttl_min = ks->kst_ttl_min;
+            if (ks->kst_ttl_max > st->kst_ttl_max)
+                st->kst_ttl_max = ks->kst_ttl_max;
+
+            kvsets++;
+        }
+    }
+    rmlock_runlock(lock);
+
+    return kvsets;
+}
+
+/* Return true once the root is empty and no leaf has more than one kvset */
+static bool
+tree_settled(struct cn_tree *tree)
+{
+    struct cn_tree_node *tn;
+    bool settled;
+    void *lock;
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    settled = list_empty(&tree->ct_root->tn_kvset_list);
+
+    cn_tree_foreach_leaf(tn, tree) {
+        if (cn_ns_kvsets(&tn->tn_ns) > 1)
+            settled = false;
+    }
+    rmlock_runlock(lock);
+
+    return settled;
+}
+
+int
+setup(struct mtf_test_info *lcl_ti)
+{
+    const char *rparamv[] = { "durability.enabled=false" };
+    hse_err_t err;
+
+    err = fxt_kvdb_setup(mtf_kvdb_home, NELEM(rparamv), rparamv, 0, NULL, &kvdb_handle);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    err = hse_kvdb_kvs_create(kvdb_handle, KVS_NAME, NELEM(kvs_cparamv), kvs_cparamv);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    err = hse_kvdb_kvs_open(kvdb_handle, KVS_NAME, 0, NULL, &kvs_handle);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    return 0;
+}
+
+int
+teardown(struct mtf_test_info *lcl_ti)
+{
+    hse_err_t err;
+
+    if (kvs_handle)
+        hse_kvdb_kvs_close(kvs_handle);
+
+    err = fxt_kvdb_teardown(mtf_kvdb_home, kvdb_handle);
+
+    kvs_handle = NULL;
+    kvdb_handle = NULL;
+
+    return hse_err_to_errno(err);
+}
+
+MTF_BEGIN_UTEST_COLLECTION(kvs_put_expire_test)
+
+MTF_DEFINE_UTEST_PREPOST(kvs_put_expire_test, c0, setup, teardown)
+{
+    char key[32], val[32];
+    hse_err_t err;
+    size_t vlen;
+    bool found;
+    int klen;
+
+    err = load_keys();
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    ASSERT_EQ(0, verify(lcl_ti, false));
+
+    wait_expired();
+
+    ASSERT_EQ(0, verify(lcl_ti, true));
+
+    /* A put whose expiry time has already passed hides the key at once */
+    klen = key_fmt(key, sizeof(key), 0, 0);
+    err = hse_kvs_put_expire(kvs_handle, 0, NULL, key, klen, key, klen, time(NULL) - 1);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = hse_kvs_get(kvs_handle, 0, NULL, key, klen, &found, val, sizeof(val), &vlen);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+    ASSERT_FALSE(found);
+
+    err = hse_kvs_put(kvs_handle, 0, NULL, key, klen, key, klen);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    ASSERT_EQ(0, verify(lcl_ti, true));
+}
+
+/* The values are ingested before they expire, hence they expire in cn */
+MTF_DEFINE_UTEST_PREPOST(kvs_put_expire_test, cn, setup, teardown)
+{
+    struct kvset_stats st;
+    hse_err_t err;
+
+    err = load_keys();
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    ASSERT_EQ(1, tree_stats(kvs_tree(), false, &st));
+    ASSERT_EQ(NGRP * NKEYS, st.kst_keys);
+    ASSERT_EQ(0, st.kst_tombs);
+    ASSERT_EQ(soon_expire, st.kst_ttl_min);
+    ASSERT_EQ(far_expire, st.kst_ttl_max);
+
+    ASSERT_EQ(0, verify(lcl_ti, false));
+
+    wait_expired();
+
+    ASSERT_EQ(0, verify(lcl_ti, true));
+}
+
+/* A spill rewrites the expired values as tombstones, and keeps the
+ * expiry time of those that have yet to expire.
+ */
+MTF_DEFINE_UTEST_PREPOST(kvs_put_expire_test, spill, setup, teardown)
+{
+    const char *rparamv[] = { "durability.enabled=false", "csched_rspill_params=0x0101" };
+    struct kvset_stats st;
+    hse_err_t err;
+    int i;
+
+    err = load_keys();
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    wait_expired();
+
+    close_all();
+
+    err = reopen(NELEM(rparamv), rparamv);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    for (i = 0; i < 600; i++) {
+        if (tree_stats(kvs_tree(), false, &st) == 0)
+            break;
+        usleep(100 * 1000);
+    }
+    ASSERT_LT(i, 600);
+
+    /* The spilled kvset holds a tombstone for each expired value, unless a
+     * leaf garbage compaction already got to it and dropped them all.
+     */
+    ASSERT_EQ(1, tree_stats(kvs_tree(), true, &st));
+    ASSERT_EQ(key_count(KEY_NONE) + key_count(KEY_FAR), st.kst_keys - st.kst_tombs);
+    if (st.kst_tombs > 0)
+        ASSERT_EQ(key_count(KEY_SOON), st.kst_tombs);
+    ASSERT_EQ(far_expire, st.kst_ttl_min);
+    ASSERT_EQ(far_expire, st.kst_ttl_max);
+
+    ASSERT_EQ(0, verify(lcl_ti, true));
+}
+
+/* Both root kvsets are spilled into a leaf where the leaf length rule
+ * kv-compacts them, dropping the tombstones of the expired values.
+ */
+MTF_DEFINE_UTEST_PREPOST(kvs_put_expire_test, kvcompact, setup, teardown)
+{
+    const char *rparamv[] = { "durability.enabled=false", "csched_rspill_params=0x0101",
+                              "csched_leaf_len_params=0x0202" };
+    struct kvset_stats st;
+    char key[32];
+    hse_err_t err;
+    int i, klen;
+
+    err = load_keys();
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    /* A second root kvset, which overwrites the value that never expires */
+    klen = key_fmt(key, sizeof(key), 0, 0);
+    err = hse_kvs_put(kvs_handle, 0, NULL, key, klen, key, klen);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    wait_expired();
+
+    close_all();
+
+    err = reopen(NELEM(rparamv), rparamv);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    for (i = 0; i < 600; i++) {
+        if (tree_settled(kvs_tree()))
+            break;
+        usleep(100 * 1000);
+    }
+    ASSERT_LT(i, 600);
+
+    ASSERT_EQ(1, tree_stats(kvs_tree(), true, &st));
+    ASSERT_EQ(key_count(KEY_NONE) + key_count(KEY_FAR), st.kst_keys);
+    ASSERT_EQ(0, st.kst_tombs);
+    ASSERT_EQ(far_expire, st.kst_ttl_min);
+    ASSERT_EQ(far_expire, st.kst_ttl_max);
+
+    ASSERT_EQ(0, verify(lcl_ti, true));
+}
+
+MTF_END_UTEST_COLLECTION(kvs_put_expire_test)
@@ -0,0 +1,484 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+/* Range deletes must hide the keys they cover from every read path, no
+ * matter where the tombstone and the keys it covers live: c0, cn root,
+ * cn leaves after spill and kv-compaction, or c0 again after WAL replay.
+ */
+
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <hse/hse.h>
+#include <hse/experimental.h>
+#include <hse/test/fixtures/kvdb.h>
+
+#include <mtf/framework.h>
+
+#include <hse_util/base.h>
+#include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/ikvdb.h>
+#include <hse_ikvdb/limits.h>
+
+#include <cn/cn_tree.h>
+#include <cn/cn_tree_internal.h>
+
+#define KVS_NAME    "kvs"
+#define NGRP        (6)
+#define NKEYS       (8)
+#define KEY_FMT     "g%02d.%04d"
+#define PFX_FMT     "g%02d."
+
+struct hse_kvdb *kvdb_handle;
+struct hse_kvs  *kvs_handle;
+
+static const char *kvs_cparamv[] = { "prefix.length=3", "suffix.length=4" };
+
+static int
+key_fmt(char *buf, size_t bufsz, int g, int i)
+{
+    return snprintf(buf, bufsz, KEY_FMT, g, i);
+}
+
+/* [g01, g03) deletes groups 1 and 2, after which g02.0003 is put again.
+ * [g04.0001, g04.0008) deletes all but the first key of group 4.
+ */
+static bool
+key_visible(int g, int i)
+{
+    switch (g) {
+    case 1:
+        return false;
+    case 2:
+        return i == 3;
+    case 4:
+        return i == 0;
+    default:
+        return true;
+    }
+}
+
+static hse_err_t
+put_key(int g, int i)
+{
+    char key[32];
+    int  klen;
+
+    klen = key_fmt(key, sizeof(key), g, i);
+
+    return hse_kvs_put(kvs_handle, 0, NULL, key, klen, key, klen);
+}
+
+static hse_err_t
+load_keys(void)
+{
+    hse_err_t err;
+
+    for (int g = 0; g < NGRP; g++) {
+        for (int i = 0; i < NKEYS; i++) {
+            err = put_key(g, i);
+            if (err)
+                return err;
+        }
+    }
+
+    return 0;
+}
+
+static hse_err_t
+range_delete(void)
+{
+    hse_err_t err;
+
+    err = hse_kvs_range_delete(kvs_handle, 0, "g01", 3, "g03", 3);
+    if (err)
+        return err;
+
+    err = hse_kvs_range_delete(kvs_handle, 0, "g04.0001", 8, "g04.0008", 8);
+    if (err)
+        return err;
+
+    return put_key(2, 3);
+}
+
+static int
+verify_get(struct mtf_test_info *lcl_ti)
+{
+    char key[32], val[32];
+    hse_err_t err;
+    size_t vlen;
+    bool found;
+
+    for (int g = 0; g < NGRP; g++) {
+        for (int i = 0; i < NKEYS; i++) {
+            int klen = key_fmt(key, sizeof(key), g, i);
+
+            err = hse_kvs_get(kvs_handle, 0, NULL, key, klen, &found, val, sizeof(val), &vlen);
+            ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+            ASSERT_EQ_RET(key_visible(g, i), found, -1);
+
+            if (found) {
+                ASSERT_EQ_RET(klen, vlen, -1);
+                ASSERT_EQ_RET(0, memcmp(key, val, vlen), -1);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int
+verify_get_multi(struct mtf_test_info *lcl_ti)
+{
+    for (int g = 0; g < NGRP; g++) {
+        char keyv[NKEYS][32], valv[NKEYS][32];
+        size_t klenv[NKEYS], vszv[NKEYS], vlenv[NKEYS];
+        const void *kptrv[NKEYS];
+        void *vptrv[NKEYS];
+        bool foundv[NKEYS];
+        hse_err_t err;
+
+        for (int i = 0; i < NKEYS; i++) {
+            klenv[i] = key_fmt(keyv[i], sizeof(keyv[i]), g, i);
+            kptrv[i] = keyv[i];
+            vptrv[i] = valv[i];
+            vszv[i] = sizeof(valv[i]);
+        }
+
+        err = hse_kvs_get_multi(kvs_handle, 0, NULL, NKEYS, kptrv, klenv, foundv, vptrv, vszv,
+                                vlenv);
+        ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+
+        for (int i = 0; i < NKEYS; i++) {
+            ASSERT_EQ_RET(key_visible(g, i), foundv[i], -1);
+
+            if (foundv[i]) {
+                ASSERT_EQ_RET(klenv[i], vlenv[i], -1);
+                ASSERT_EQ_RET(0, memcmp(keyv[i], valv[i], vlenv[i]), -1);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int
+verify_cursor(struct mtf_test_info *lcl_ti)
+{
+    struct hse_kvs_cursor *cursor;
+    const void *key, *val;
+    size_t klen, vlen;
+    char expect[32];
+    hse_err_t err;
+    bool eof;
+
+    err = hse_kvs_cursor_create(kvs_handle, 0, NULL, NULL, 0, &cursor);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+
+    for (int g = 0; g < NGRP; g++) {
+        for (int i = 0; i < NKEYS; i++) {
+            int elen;
+
+            if (!key_visible(g, i))
+                continue;
+
+            elen = key_fmt(expect, sizeof(expect), g, i);
+
+            err = hse_kvs_cursor_read(cursor, 0, &key, &klen, &val, &vlen, &eof);
+            ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+            ASSERT_FALSE_RET(eof, -1);
+            ASSERT_EQ_RET(elen, klen, -1);
+            ASSERT_EQ_RET(0, memcmp(expect, key, klen), -1);
+            ASSERT_EQ_RET(elen, vlen, -1);
+        }
+    }
+
+    err = hse_kvs_cursor_read(cursor, 0, &key, &klen, &val, &vlen, &eof);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+    ASSERT_TRUE_RET(eof, -1);
+
+    err = hse_kvs_cursor_destroy(cursor);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+
+    return 0;
+}
+
+static int
+verify_probe(struct mtf_test_info *lcl_ti)
+{
+    char pfx[32], kbuf[HSE_KVS_KEY_LEN_MAX], vbuf[32], expect[32];
+    enum hse_kvs_pfx_probe_cnt found;
+    size_t klen, vlen;
+    hse_err_t err;
+
+    for (int g = 0; g < NGRP; g++) {
+        int pfxlen, n = 0, first = -1;
+
+        for (int i = 0; i < NKEYS; i++) {
+            if (key_visible(g, i)) {
+                if (first < 0)
+                    first = i;
+                n++;
+            }
+        }
+
+        pfxlen = snprintf(pfx, sizeof(pfx), PFX_FMT, g);
+
+        err = hse_kvs_prefix_probe(kvs_handle, 0, NULL, pfx, pfxlen, &found, kbuf, sizeof(kbuf),
+                                   &klen, vbuf, sizeof(vbuf), &vlen);
+        ASSERT_EQ_RET(0, hse_err_to_errno(err), -1);
+
+        if (n == 0) {
+            ASSERT_EQ_RET(HSE_KVS_PFX_FOUND_ZERO, found, -1);
+        } else if (n == 1) {
+            int elen = key_fmt(expect, sizeof(expect), g, first);
+
+            ASSERT_EQ_RET(HSE_KVS_PFX_FOUND_ONE, found, -1);
+            ASSERT_EQ_RET(elen, klen, -1);
+            ASSERT_EQ_RET(0, memcmp(expect, kbuf, klen), -1);
+            ASSERT_EQ_RET(elen, vlen, -1);
+            ASSERT_EQ_RET(0, memcmp(expect, vbuf, vlen), -1);
+        } else {
+            ASSERT_EQ_RET(HSE_KVS_PFX_FOUND_MUL, found, -1);
+        }
+    }
+
+    return 0;
+}
+
+static int
+verify(struct mtf_test_info *lcl_ti)
+{
+    ASSERT_EQ_RET(0, verify_get(lcl_ti), -1);
+    ASSERT_EQ_RET(0, verify_get_multi(lcl_ti), -1);
+    ASSERT_EQ_RET(0, verify_cursor(lcl_ti), -1);
+    ASSERT_EQ_RET(0, verify_probe(lcl_ti), -1);
+
+    return 0;
+}
+
+static hse_err_t
+reopen(size_t rparamc, const char **rparamv)
+{
+    hse_err_t err;
+
+    err = hse_kvdb_open(mtf_kvdb_home, rparamc, rparamv, &kvdb_handle);
+    if (err)
+        return err;
+
+    return hse_kvdb_kvs_open(kvdb_handle, KVS_NAME, 0, NULL, &kvs_handle);
+}
+
+static void
+close_all(void)
+{
+    hse_kvdb_kvs_close(kvs_handle);
+    hse_kvdb_close(kvdb_handle);
+
+    kvs_handle = NULL;
+    kvdb_handle = NULL;
+}
+
+/* Return true once the root is empty and no leaf has more than one kvset */
+static bool
+tree_settled(struct cn_tree *tree)
+{
+    struct cn_tree_node *tn;
+    bool settled;
+    void *lock;
+
+    rmlock_rlock(&tree->ct_lock, &lock);
+    settled = list_empty(&tree->ct_root->tn_kvset_list);
+
+    cn_tree_foreach_leaf(tn, tree) {
+        if (cn_ns_kvsets(&tn->tn_ns) > 1)
+            settled = false;
+    }
+    rmlock_runlock(lock);
+
+    return settled;
+}
+
+int
+setup(struct mtf_test_info *lcl_ti)
+{
+    const char *rparamv[] = { "durability.enabled=false" };
+    hse_err_t err;
+
+    err = fxt_kvdb_setup(mtf_kvdb_home, NELEM(rparamv), rparamv, 0, NULL, &kvdb_handle);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    err = hse_kvdb_kvs_create(kvdb_handle, KVS_NAME, NELEM(kvs_cparamv), kvs_cparamv);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    err = hse_kvdb_kvs_open(kvdb_handle, KVS_NAME, 0, NULL, &kvs_handle);
+    ASSERT_EQ_RET(0, hse_err_to_errno(err), hse_err_to_errno(err));
+
+    return 0;
+}
+
+int
+teardown(struct mtf_test_info *lcl_ti)
+{
+    hse_err_t err;
+
+    if (kvs_handle)
+        hse_kvdb_kvs_close(kvs_handle);
+
+    err = fxt_kvdb_teardown(mtf_kvdb_home, kvdb_handle);
+
+    kvs_handle = NULL;
+    kvdb_handle = NULL;
+
+    return hse_err_to_errno(err);
+}
+
+MTF_BEGIN_UTEST_COLLECTION(kvs_range_delete_test)
+
+/* The tombstones and the keys they cover are all in c0 */
+MTF_DEFINE_UTEST_PREPOST(kvs_range_delete_test, c0, setup, teardown)
+{
+    hse_err_t err;
+
+    err = load_keys();
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = range_delete();
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    ASSERT_EQ(0, verify(lcl_ti));
+}
+
+/* The keys are ingested into cn, first with the tombstones in c0
+ * and then with the tombstones in a newer root kvset.
+ */
+MTF_DEFINE_UTEST_PREPOST(kvs_range_delete_test, ingest, setup, teardown)
+{
+    hse_err_t err;
+
+    err = load_keys();
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = range_delete();
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    ASSERT_EQ(0, verify(lcl_ti));
+
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    ASSERT_EQ(0, verify(lcl_ti));
+}
+
+/* Both root kvsets are spilled into the leaves, where the leaf length
+ * rule then kv-compacts the tombstones together with the keys they cover.
+ */
+MTF_DEFINE_UTEST_PREPOST(kvs_range_delete_test, spill_kvcompact, setup, teardown)
+{
+    const char *rparamv[] = { "durability.enabled=false", "csched_rspill_params=0x0101",
+                              "csched_leaf_len_params=0x0202" };
+    hse_err_t err;
+    int i;
+
+    err = load_keys();
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = hse_kvdb_sync(kvdb_handle, 0);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    err = range_delete();
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    close_all();
+
+    err = reopen(NELEM(rparamv), rparamv);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    for (i = 0; i < 600; i++) {
+        if (tree_settled(cn_get_tree(ikvdb_kvs_get_cn(kvs_handle))))
+            break;
+        usleep(100 * 1000);
+    }
+    ASSERT_LT(i, 600);
+
+    ASSERT_EQ(0, verify(lcl_ti));
+
+    /* And once more after a reopen with the default compaction settings */
+    close_all();
+
+    err = reopen(0, NULL);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    ASSERT_EQ(0, verify(lcl_ti));
+}
+
+/* A child process logs the keys and the range deletes to the WAL and exits
+ * without closing the kvdb, which then has to replay them at open.
+ */
+MTF_DEFINE_UTEST_POST(kvs_range_delete_test, wal_replay, teardown)
+{
+    const char *paramv[] = { "socket.enabled=false" };
+    hse_err_t err;
+    pid_t pid;
+    int wstatus;
+
+    hse_fini();
+
+    pid = fork();
+    ASSERT_GE(pid, 0);
+
+    if (pid == 0) {
+        err = hse_init(NULL, NELEM(paramv), paramv);
+        if (err)
+            _exit(1);
+
+        err = fxt_kvdb_setup(mtf_kvdb_home, 0, NULL, 0, NULL, &kvdb_handle);
+        if (err)
+            _exit(2);
+
+        err = hse_kvdb_kvs_create(kvdb_handle, KVS_NAME, NELEM(kvs_cparamv), kvs_cparamv);
+        if (!err)
+            err = hse_kvdb_kvs_open(kvdb_handle, KVS_NAME, 0, NULL, &kvs_handle);
+        if (err)
+            _exit(3);
+
+        err = load_keys();
+        if (!err)
+            err = range_delete();
+        if (err)
+            _exit(4);
+
+        /* With durability enabled this only flushes the WAL */
+        err = hse_kvdb_sync(kvdb_handle, 0);
+        _exit(err ? 5 : 0);
+    }
+
+    ASSERT_EQ(pid, waitpid(pid, &wstatus, 0));
+
+    err = hse_init(NULL, NELEM(paramv), paramv);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    ASSERT_TRUE(WIFEXITED(wstatus));
+    ASSERT_EQ(0, WEXITSTATUS(wstatus));
+
+    err = reopen(0, NULL);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    ASSERT_EQ(0, verify(lcl_ti));
+
+    /* A clean close ingests the replayed tombstones into cn */
+    close_all();
+
+    err = reopen(0, NULL);
+    ASSERT_EQ(0, hse_err_to_errno(err));
+
+    ASSERT_EQ(0, verify(lcl_ti));
+}
+
+MTF_END_UTEST_COLLECTION(kvs_range_delete_test)
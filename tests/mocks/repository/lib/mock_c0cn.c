@@ -319,7 +319,7 @@ _c0_put(
 static merr_t
 _c0_get(
     struct c0 *              handle,
-    const struct kvs_ktuple *kt,
+    struct kvs_ktuple *      kt,
     u64                      view_seqno,
     uintptr_t                seqnoref,
     enum key_lookup_res *    res,
@@ -663,6 +663,8 @@ static struct mapi_injection cn_inject_list[] = {
     { mapi_idx_cn_get_dataset,       MAPI_RC_PTR, NULL },
     { mapi_idx_cn_get_mclass_policy, MAPI_RC_PTR, NULL },
     { mapi_idx_cn_get_ingest_perfc,  MAPI_RC_PTR, NULL },
+    { mapi_idx_cn_get_merge_op,      MAPI_RC_PTR, NULL },
+    { mapi_idx_cn_get_compact_filter, MAPI_RC_PTR, NULL },
 
     { -1 },
 };
@@ -728,6 +730,7 @@ mock_cn_unset()
 static struct mapi_injection c0_inject_list[] = {
     { mapi_idx_c0_cursor_update,    MAPI_RC_SCALAR, 0 },
     { mapi_idx_c0_cursor_bind_txn,  MAPI_RC_SCALAR, 0 },
+    { mapi_idx_c0_cursor_rtombs,    MAPI_RC_SCALAR, 0 },
     { -1 },
 };
 
@@ -876,6 +879,7 @@ static struct mapi_injection cndb_inject_list[] = {
     { mapi_idx_cndb_record_kvset_add_ack, MAPI_RC_SCALAR, 0 },
     { mapi_idx_cndb_record_kvset_del_ack, MAPI_RC_SCALAR, 0 },
     { mapi_idx_cndb_record_nak,           MAPI_RC_SCALAR, 0 },
+    { mapi_idx_cndb_record_kvset_summary, MAPI_RC_SCALAR, 0 },
     { -1 },
 };
 
@@ -903,6 +907,7 @@ static struct mapi_injection wal_inject_list[] = {
     { mapi_idx_wal_open,       MAPI_RC_SCALAR, 0 },
     { mapi_idx_wal_close,      MAPI_RC_SCALAR, 0 },
     { mapi_idx_wal_put,        MAPI_RC_SCALAR, 0 },
+    { mapi_idx_wal_batch,      MAPI_RC_SCALAR, 0 },
     { mapi_idx_wal_del,        MAPI_RC_SCALAR, 0 },
     { mapi_idx_wal_del_pfx,    MAPI_RC_SCALAR, 0 },
     { mapi_idx_wal_txn_begin,  MAPI_RC_SCALAR, 0 },
@@ -50,13 +50,18 @@ _vbb_create(
 static struct mapi_injection inject_list[] = {
     /* hblock builder */
     { mapi_idx_hbb_add_ptomb, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_hbb_add_rtomb, MAPI_RC_SCALAR, 0 },
     { mapi_idx_hbb_destroy, MAPI_RC_SCALAR, 0 },
     { mapi_idx_hbb_finish, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_hbb_get_nptombs, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_hbb_get_nrtombs, MAPI_RC_SCALAR, 0 },
     /* kblock builder */
     { mapi_idx_kbb_destroy, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kbb_add_entry, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kbb_finish, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kbb_is_empty, MAPI_RC_SCALAR, 1},
+    { mapi_idx_kbb_curr_kblk_min_max_keys, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kbb_get_composite_hlog, MAPI_RC_PTR, NULL },
     /* vblock builder */
     { mapi_idx_vbb_destroy, MAPI_RC_SCALAR, 0 },
     { mapi_idx_vbb_add_entry, MAPI_RC_SCALAR, 0 },
@@ -489,6 +489,7 @@ _kvset_iter_next_key(struct kv_iterator *kvi, struct key_obj *kobj, struct kvset
     vc->next = 0;
     vc->kmd = 0;
     vc->nvals = 1;
+    vc->expire = 0;
 
     d += vc->off;
 
@@ -692,6 +693,14 @@ _kvset_iter_seek(struct kv_iterator *kvi, const void *key, int len, bool *eof)
     return 0;
 }
 
+static const struct kvs_rtomb *
+_kvset_get_rtombs(const struct kvset *ks, uint *rtc)
+{
+    *rtc = 0;
+
+    return NULL;
+}
+
 /* Prefer the mapi_inject_list method for mocking functions over the
  * MOCK_SET/MOCK_UNSET macros if the mock simply needs to return a
  * constant value.  The advantage of the mapi_inject_list approach is
@@ -731,6 +740,7 @@ mock_kvset_set(void)
     MOCK_SET(kvset, _kvset_iter_next_key);
     MOCK_SET(kvset, _kvset_iter_val_get);
     MOCK_SET(kvset, _kvset_iter_next_vref);
+    MOCK_SET(kvset, _kvset_get_rtombs);
 
     MOCK_SET(kvset_view, _kvset_get_dgen);
     MOCK_SET(kvset_view, _kvset_get_nodeid);
@@ -764,6 +774,7 @@ mock_kvset_unset(void)
     MOCK_UNSET(kvset, _kvset_iter_next_key);
     MOCK_UNSET(kvset, _kvset_iter_val_get);
     MOCK_UNSET(kvset, _kvset_iter_next_vref);
+    MOCK_UNSET(kvset, _kvset_get_rtombs);
 
     MOCK_UNSET(kvset_view, _kvset_get_num_kblocks);
     MOCK_UNSET(kvset_view, _kvset_get_nth_kblock_id);
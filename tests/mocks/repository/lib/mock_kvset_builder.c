@@ -46,11 +46,18 @@ _kvset_builder_destroy(struct kvset_builder *bld)
  */
 static struct mapi_injection inject_list[] = {
     { mapi_idx_kvset_builder_add_key, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_builder_add_mval, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kvset_builder_add_nonval, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_builder_add_rtomb, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kvset_builder_add_val, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kvset_builder_add_vref, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kvset_builder_get_mblocks, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_builder_get_mblocks_concat, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kvset_builder_set_agegroup, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_builder_set_expire, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_builder_set_wq, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_builder_set_vdict, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_builder_set_vbidx, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kvset_builder_adopt_vblocks, MAPI_RC_SCALAR, 0},
     { -1},
 };
@@ -432,6 +432,26 @@ _mpool_mblock_write(struct mpool *mp, uint64_t id, const struct iovec *iovec, in
     return mblock_rw(id, iovec, niov, 0, false);
 }
 
+static merr_t
+_mpool_mblock_read_cached(
+    struct mpool          *mp,
+    uint64_t               id,
+    void                  *buf,
+    size_t                 len,
+    off_t                  off,
+    enum mpool_bcache_prio prio)
+{
+    struct iovec iov = { .iov_base = buf, .iov_len = len };
+
+    return mblock_rw(id, &iov, 1, off, true);
+}
+
+static bool
+_mpool_bcache_enabled(struct mpool *mp)
+{
+    return false;
+}
+
 /*
  * MDC mocking concept:
  * The backing mocked_mblock holds the original data from file.
@@ -821,6 +841,8 @@ mock_mpool_set(void)
     MOCK_SET(mpool, _mpool_mblock_props_get);
     MOCK_SET(mpool, _mpool_mblock_read);
     MOCK_SET(mpool, _mpool_mblock_write);
+    MOCK_SET(mpool, _mpool_mblock_read_cached);
+    MOCK_SET(mpool, _mpool_bcache_enabled);
 
     MOCK_SET(mpool, _mpool_mcache_getbase);
     MOCK_SET(mpool, _mpool_mcache_getpages);
@@ -853,6 +875,8 @@ mock_mpool_unset(void)
     MOCK_UNSET(mpool, _mpool_mblock_props_get);
     MOCK_UNSET(mpool, _mpool_mblock_read);
     MOCK_UNSET(mpool, _mpool_mblock_write);
+    MOCK_UNSET(mpool, _mpool_mblock_read_cached);
+    MOCK_UNSET(mpool, _mpool_bcache_enabled);
 
     MOCK_UNSET(mpool, _mpool_mcache_getbase);
     MOCK_UNSET(mpool, _mpool_mcache_getpages);
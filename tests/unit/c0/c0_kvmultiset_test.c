@@ -60,7 +60,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvmultiset_test, basic, no_fail_pre, no_fail_post)
     merr_t                err;
     u32                   rc;
 
-    err = c0kvms_create(1, 0, NULL, &kvms);
+    err = c0kvms_create(1, false, 0, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE((struct c0_kvmultiset *)0, kvms);
 
@@ -82,7 +82,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvmultiset_test, basic_create, no_fail_pre, no_fail_
 
     const int WIDTH = 8;
 
-    err = c0kvms_create(WIDTH, 0, NULL, &kvms);
+    err = c0kvms_create(WIDTH, false, 0, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE((struct c0_kvmultiset *)0, kvms);
 
@@ -101,7 +101,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvmultiset_test, limit_create, no_fail_pre, no_fail_
 
     const int WIDTH = -1;
 
-    err = c0kvms_create(WIDTH, 0, NULL, &kvms);
+    err = c0kvms_create(WIDTH, false, 0, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE((struct c0_kvmultiset *)0, kvms);
 
@@ -120,7 +120,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvmultiset_test, create_insert_check, no_fail_pre, n
 
     ASSERT_LT(WIDTH, 256);
 
-    err = c0kvms_create(WIDTH, 0, NULL, &kvms);
+    err = c0kvms_create(WIDTH, false, 0, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE((struct c0_kvmultiset *)0, kvms);
 
@@ -208,7 +208,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvmultiset_test, ingest_sk, no_fail_pre, no_fail_pos
 
     ASSERT_LT(WIDTH, 200);
 
-    err = c0kvms_create(WIDTH, 0, NULL, &kvms);
+    err = c0kvms_create(WIDTH, false, 0, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE((struct c0_kvmultiset *)NULL, kvms);
 
@@ -59,7 +59,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, basic, no_fail_pre, no_fail_post)
     struct c0_kvset *kvs;
     merr_t           err = 0;
 
-    err = c0kvs_create(NULL, NULL, &kvs);
+    err = c0kvs_create(NULL, NULL, false, &kvs);
     ASSERT_EQ(0, err);
     ASSERT_NE((struct c0_kvset *)0, kvs);
 
@@ -77,7 +77,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, basic_put_get, no_fail_pre, no_fail_post
     int              i;
     int              seq;
 
-    err = c0kvs_create(NULL, NULL, &kvs);
+    err = c0kvs_create(NULL, NULL, false, &kvs);
     ASSERT_NE((struct c0_kvset *)0, kvs);
 
     for (i = 0; i < 10; ++i) {
@@ -193,7 +193,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, basic_put_get_fail, no_fail_pre, no_fail
 
     /* Allocate largest possible kvs.
      */
-    err = c0kvs_create(NULL, NULL, &kvs);
+    err = c0kvs_create(NULL, NULL, false, &kvs);
     ASSERT_NE(NULL, kvs);
 
     avail = c0kvs_avail(kvs);
@@ -281,7 +281,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, basic_repeated_put, no_fail_pre, no_fail
     u64                 view_seqno;
     int                 i;
 
-    err = c0kvs_create(NULL, NULL, &kvs);
+    err = c0kvs_create(NULL, NULL, false, &kvs);
     ASSERT_NE((struct c0_kvset *)0, kvs);
 
     kvs_ktuple_init(&kt, kbuf, 1);
@@ -400,7 +400,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, ctxn_put, no_fail_pre, no_fail_post)
     u64                 ctxn_priv_1[10], ctxn_priv_2[10];
     int                 i;
 
-    err = c0kvs_create(NULL, NULL, &kvs);
+    err = c0kvs_create(NULL, NULL, false, &kvs);
     ASSERT_NE((struct c0_kvset *)0, kvs);
 
     kvs_ktuple_init(&kt, kbuf, 1);
@@ -580,7 +580,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, advanced_repeated_put, no_fail_pre, no_f
     ASSERT_TRUE(rcu_thrd);
     set_thread_call_rcu_data(rcu_thrd);
 
-    err = c0kvs_create(NULL, NULL, &kvs);
+    err = c0kvs_create(NULL, NULL, false, &kvs);
     ASSERT_NE((struct c0_kvset *)0, kvs);
 
     kvs_ktuple_init(&kt, kbuf, sizeof(kbuf));
@@ -719,7 +719,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, basic_put_get_del, no_fail_pre, no_fail_
     uintptr_t           iseqnoref, oseqnoref;
     u64                 view_seqno;
 
-    err = c0kvs_create(NULL, NULL, &kvs);
+    err = c0kvs_create(NULL, NULL, false, &kvs);
     ASSERT_NE((struct c0_kvset *)0, kvs);
 
     for (i = 0; i < 10; ++i) {
@@ -867,7 +867,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, get_content_metrics, no_fail_pre, no_fai
     const int         delete_step = 3;
     uintptr_t         seqno;
 
-    err = c0kvs_create(NULL, NULL, &kvs);
+    err = c0kvs_create(NULL, NULL, false, &kvs);
     ASSERT_NE((struct c0_kvset *)0, kvs);
 
     c0kvs_get_content_metrics(
@@ -959,7 +959,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, finalize, no_fail_pre, no_fail_post)
     int                 i;
     uintptr_t           iseqno, oseqno;
 
-    err = c0kvs_create(NULL, NULL, &kvs);
+    err = c0kvs_create(NULL, NULL, false, &kvs);
     ASSERT_NE((struct c0_kvset *)0, kvs);
 
     kvs_ktuple_init(&kt, kbuf, 0);
@@ -1075,7 +1075,7 @@ MTF_DEFINE_UTEST_PREPOST(c0_kvset_test, iterator, no_fail_pre, no_fail_post)
     int               i;
     char              c;
 
-    err = c0kvs_create(NULL, NULL, &kvs);
+    err = c0kvs_create(NULL, NULL, false, &kvs);
     ASSERT_NE(NULL, kvs);
 
     iseqno = HSE_ORDNL_TO_SQNREF(0);
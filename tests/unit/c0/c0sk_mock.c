@@ -95,7 +95,7 @@ _c0sk_get(
     struct c0sk *            self,
     u16                      skidx,
     u32                      pfx_len,
-    const struct kvs_ktuple *key,
+    struct kvs_ktuple *      key,
     u64                      view_seqno,
     uintptr_t                seqnoref,
     enum key_lookup_res *    res,
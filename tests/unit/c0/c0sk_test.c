@@ -3,6 +3,8 @@
  * Copyright (C) 2015-2021 Micron Technology, Inc.  All rights reserved.
  */
 
+#include <pthread.h>
+
 #include <mtf/framework.h>
 
 #include <hse/logging/logging.h>
@@ -87,6 +89,8 @@ static struct mapi_injection inject_list[] = {
     { mapi_idx_kvset_builder_get_mblocks, MAPI_RC_SCALAR, 0},
     { mapi_idx_kvset_builder_add_key, MAPI_RC_SCALAR, 0},
     { mapi_idx_kvset_builder_add_val, MAPI_RC_SCALAR, 0},
+    { mapi_idx_kvset_builder_add_mval, MAPI_RC_SCALAR, 0},
+    { mapi_idx_kvset_builder_set_expire, MAPI_RC_SCALAR, 0},
     { mapi_idx_kvset_builder_add_nonval, MAPI_RC_SCALAR, 0},
     { mapi_idx_kvset_builder_add_vref, MAPI_RC_SCALAR, 0},
     { mapi_idx_kvset_builder_destroy, MAPI_RC_SCALAR, 0},
@@ -236,7 +240,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, ingest, no_fail_pre, no_fail_post)
 
     self = c0sk_h2r(mkvdb.ikdb_c0sk);
 
-    err = c0kvms_create(1, &seqno, NULL, &kvms);
+    err = c0kvms_create(1, false, &seqno, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE(NULL, kvms);
 
@@ -303,7 +307,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, ingest_debug, no_fail_pre, no_fail_post)
 
     self = c0sk_h2r(mkvdb.ikdb_c0sk);
 
-    err = c0kvms_create(1, &seqno, NULL, &kvms);
+    err = c0kvms_create(1, false, &seqno, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE(NULL, kvms);
 
@@ -426,7 +430,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, t_sync, no_fail_pre, no_fail_post)
 
     self = c0sk_h2r(mkvdb.ikdb_c0sk);
 
-    err = c0kvms_create(1, &seqno, NULL, &kvms);
+    err = c0kvms_create(1, false, &seqno, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE(NULL, kvms);
 
@@ -522,7 +526,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, ingest_fail, no_fail_pre, no_fail_post)
 
     self = c0sk_h2r(mkvdb.ikdb_c0sk);
 
-    err = c0kvms_create(1, &seqno, NULL, &kvms);
+    err = c0kvms_create(1, false, &seqno, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE(NULL, kvms);
 
@@ -579,7 +583,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, open_test, no_fail_pre, no_fail_post)
     self = c0sk_h2r(mkvdb.ikdb_c0sk);
 
     for (i = 0; i < num_kvs; i++) {
-        err = c0kvms_create(1, &seqno, NULL, &kvms[i]);
+        err = c0kvms_create(1, false, &seqno, NULL, &kvms[i]);
         ASSERT_EQ(0, err);
         ASSERT_NE(NULL, kvms[i]);
 
@@ -645,7 +649,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, serial_put1, no_fail_pre, no_fail_post)
         err = c0sk_c0_register(mkvdb.ikdb_c0sk, mock_cn, &skidx[i]);
         ASSERT_EQ(0, err);
 
-        err = c0kvms_create(1, &seqno, NULL, &kvms[i]);
+        err = c0kvms_create(1, false, &seqno, NULL, &kvms[i]);
         ASSERT_EQ(0, err);
         ASSERT_NE(NULL, kvms[i]);
 
@@ -730,7 +734,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, serial_put2, no_fail_pre, no_fail_post)
         err = c0sk_c0_register(mkvdb.ikdb_c0sk, mock_cn, &skidx[i]);
         ASSERT_EQ(0, err);
 
-        err = c0kvms_create(1, &seqno, NULL, &kvms[i]);
+        err = c0kvms_create(1, false, &seqno, NULL, &kvms[i]);
         ASSERT_EQ(0, err);
         ASSERT_NE(NULL, kvms[i]);
 
@@ -879,7 +883,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, ctxn_put, no_fail_ctxn_pre, no_fail_post)
     self = c0sk_h2r(mkvdb.ikdb_c0sk);
 
     for (i = 0; i < num_kvs; i++) {
-        err = c0kvms_create(1, &seqno, NULL, &kvms[i]);
+        err = c0kvms_create(1, false, &seqno, NULL, &kvms[i]);
         ASSERT_EQ(0, err);
         ASSERT_NE(NULL, kvms[i]);
 
@@ -1070,7 +1074,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, parallel_put1, no_fail_pre, no_fail_post)
         err = c0sk_c0_register(mkvdb.ikdb_c0sk, mock_cn, &skidx[i]);
         ASSERT_EQ(0, err);
 
-        err = c0kvms_create(1, &seqno, NULL, &kvms[i]);
+        err = c0kvms_create(1, false, &seqno, NULL, &kvms[i]);
         ASSERT_EQ(0, err);
         ASSERT_NE(NULL, kvms[i]);
 
@@ -1157,7 +1161,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, parallel_put2, no_fail_pre, no_fail_post)
         err = c0sk_c0_register(mkvdb.ikdb_c0sk, mock_cn, &skidx[i]);
         ASSERT_EQ(0, err);
 
-        err = c0kvms_create(1, &seqno, NULL, &kvms[i]);
+        err = c0kvms_create(1, false, &seqno, NULL, &kvms[i]);
         ASSERT_EQ(0, err);
         ASSERT_NE(NULL, kvms[i]);
 
@@ -1244,7 +1248,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, parallel_put3, no_fail_pre, no_fail_post)
         err = c0sk_c0_register(mkvdb.ikdb_c0sk, mock_cn, &skidx[i]);
         ASSERT_EQ(0, err);
 
-        err = c0kvms_create(1, &seqno, NULL, &kvms[i]);
+        err = c0kvms_create(1, false, &seqno, NULL, &kvms[i]);
         ASSERT_EQ(0, err);
         ASSERT_NE(NULL, kvms[i]);
 
@@ -1347,7 +1351,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, parallel_ctxn_put, no_fail_ctxn_pre, no_fail
         err = c0sk_c0_register(mkvdb.ikdb_c0sk, mock_cn, &skidx[i]);
         ASSERT_EQ(0, err);
 
-        err = c0kvms_create(1, &seqno, NULL, &kvms[i]);
+        err = c0kvms_create(1, false, &seqno, NULL, &kvms[i]);
         ASSERT_EQ(0, err);
         ASSERT_NE(NULL, kvms[i]);
 
@@ -1449,7 +1453,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, parallel_put_cheap, no_fail_pre, no_fail_pos
         err = c0sk_c0_register(mkvdb.ikdb_c0sk, mock_cn, &skidx[i]);
         ASSERT_EQ(0, err);
 
-        err = c0kvms_create(1, &seqno, NULL, &kvms[i]);
+        err = c0kvms_create(1, false, &seqno, NULL, &kvms[i]);
         ASSERT_EQ(0, err);
         ASSERT_NE(NULL, kvms[i]);
 
@@ -1585,7 +1589,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, parallel_get_put, no_fail_pre, no_fail_post)
         err = c0sk_c0_register(mkvdb.ikdb_c0sk, mock_cn, &skidx[i]);
         ASSERT_EQ(0, err);
 
-        err = c0kvms_create(1, &seqno, NULL, &kvms[i]);
+        err = c0kvms_create(1, false, &seqno, NULL, &kvms[i]);
         ASSERT_EQ(0, err);
         ASSERT_NE(NULL, kvms[i]);
 
@@ -1682,7 +1686,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, c0sk_get_test, no_fail_pre, no_fail_post)
 
     self = c0sk_h2r(mkvdb.ikdb_c0sk);
 
-    err = c0kvms_create(1, &seqno, NULL, &kvms);
+    err = c0kvms_create(1, false, &seqno, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE(NULL, kvms);
 
@@ -1833,7 +1837,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, c0_cursor_robust, no_fail_pre, no_fail_post)
     _ikvdb_get_c0sk((struct ikvdb *)&mkvdb, &c0sk);
     ASSERT_EQ(c0sk, mkvdb.ikdb_c0sk);
 
-    err = c0kvms_create(1, &seqno, NULL, &kvms);
+    err = c0kvms_create(1, false, &seqno, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE(NULL, kvms);
 
@@ -2036,7 +2040,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, c0_cursor_eagain, no_fail_pre, no_fail_post)
     _ikvdb_get_c0sk((struct ikvdb *)&mkvdb, &c0sk);
     ASSERT_EQ(c0sk, mkvdb.ikdb_c0sk);
 
-    err = c0kvms_create(1, &seqno, NULL, &kvms);
+    err = c0kvms_create(1, false, &seqno, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE(NULL, kvms);
 
@@ -2170,7 +2174,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, c0_rcursor_robust, no_fail_pre, no_fail_post
     _ikvdb_get_c0sk((struct ikvdb *)&mkvdb, &c0sk);
     ASSERT_EQ(c0sk, mkvdb.ikdb_c0sk);
 
-    err = c0kvms_create(1, &seqno, NULL, &kvms);
+    err = c0kvms_create(1, false, &seqno, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE(NULL, kvms);
 
@@ -2433,7 +2437,7 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, c0_cursor_ptombs, no_fail_pre, no_fail_post)
     _ikvdb_get_c0sk((struct ikvdb *)&mkvdb, &c0sk);
     ASSERT_EQ(c0sk, mkvdb.ikdb_c0sk);
 
-    err = c0kvms_create(1, &seqno, NULL, &kvms);
+    err = c0kvms_create(1, false, &seqno, NULL, &kvms);
     ASSERT_EQ(0, err);
     ASSERT_NE(NULL, kvms);
 
@@ -2615,4 +2619,213 @@ MTF_DEFINE_UTEST_PREPOST(c0sk_test, c0_deregister, no_fail_pre, no_fail_post)
     destroy_mock_cn(mock_cn);
 }
 
+/* The kvses of an ingest are divided into parts built on separate threads.
+ * Each fake builder records the keys it is fed, keyed by the kvs index that
+ * prefixes every key.
+ */
+#define PART_KVS_CNT (8)
+#define PART_KEY_CNT (1000)
+
+struct part_bldr {
+    int  kvs;
+    u8   kdata[8];
+    uint klen;
+};
+
+struct part_kvs {
+    uint      keyc;
+    uint      mbc;
+    bool      unsorted;
+    bool      mixed;
+    pthread_t tid;
+};
+
+static struct part_kvs part_kvsv[HSE_KVS_COUNT_MAX];
+static atomic_int      part_bldrc;
+
+static merr_t
+part_bldr_create(struct kvset_builder **bldr_out, struct cn *cn, struct perfc_set *pc, u64 vgroup)
+{
+    struct part_bldr *bldr;
+
+    bldr = calloc(1, sizeof(*bldr));
+    if (!bldr)
+        return merr(ENOMEM);
+
+    bldr->kvs = -1;
+    atomic_inc(&part_bldrc);
+
+    *bldr_out = (void *)bldr;
+
+    return 0;
+}
+
+static merr_t
+part_bldr_add_key(struct kvset_builder *handle, const struct key_obj *ko)
+{
+    struct part_bldr *bldr = (void *)handle;
+    u8   kdata[sizeof(bldr->kdata)];
+    uint klen;
+
+    key_obj_copy(kdata, sizeof(kdata), &klen, ko);
+
+    if (bldr->kvs < 0) {
+        bldr->kvs = kdata[0];
+    } else {
+        if (bldr->kvs != kdata[0])
+            part_kvsv[bldr->kvs].mixed = true;
+        if (keycmp(bldr->kdata, bldr->klen, kdata, klen) >= 0)
+            part_kvsv[bldr->kvs].unsorted = true;
+    }
+
+    memcpy(bldr->kdata, kdata, klen);
+    bldr->klen = klen;
+    part_kvsv[bldr->kvs].keyc++;
+
+    return 0;
+}
+
+static merr_t
+part_bldr_get_mblocks(struct kvset_builder *handle, struct kvset_mblocks *mblocks)
+{
+    struct part_bldr *bldr = (void *)handle;
+
+    memset(mblocks, 0, sizeof(*mblocks));
+
+    if (bldr->kvs >= 0) {
+        part_kvsv[bldr->kvs].mbc++;
+        part_kvsv[bldr->kvs].tid = pthread_self();
+    }
+
+    return 0;
+}
+
+static void
+part_bldr_destroy(struct kvset_builder *handle)
+{
+    free(handle);
+    atomic_dec(&part_bldrc);
+}
+
+MTF_DEFINE_UTEST_PREPOST(c0sk_test, ingest_parts, no_fail_pre, no_fail_post)
+{
+    struct kvdb_rparams   kvdb_rp;
+    struct kvs_rparams    kvs_rp;
+    struct c0_kvmultiset *kvms;
+    struct kvs_ktuple     kt;
+    struct kvs_vtuple     vt;
+    struct mock_kvdb      mkvdb;
+    struct c0sk_impl *    self;
+    struct cn *           mock_cn;
+    atomic_ulong          seqno;
+    u16                   skidx[PART_KVS_CNT];
+    u8                    kdata[5];
+    u64                   val = 0;
+    uint                  tidc;
+    merr_t                err;
+    int                   i, j;
+
+    kvdb_rp = kvdb_rparams_defaults();
+    kvs_rp = kvs_rparams_defaults();
+
+    kvdb_rp.c0_ingest_width = 2;
+    kvdb_rp.c0_build_threads = 4;
+
+    memset(part_kvsv, 0, sizeof(part_kvsv));
+    atomic_set(&part_bldrc, 0);
+
+    mapi_inject_unset(mapi_idx_kvset_builder_add_key);
+    mapi_inject_unset(mapi_idx_kvset_builder_get_mblocks);
+    mapi_inject_unset(mapi_idx_kvset_builder_destroy);
+
+    MOCK_SET_FN(kvset_builder, kvset_builder_create, part_bldr_create);
+    MOCK_SET_FN(kvset_builder, kvset_builder_add_key, part_bldr_add_key);
+    MOCK_SET_FN(kvset_builder, kvset_builder_get_mblocks, part_bldr_get_mblocks);
+    MOCK_SET_FN(kvset_builder, kvset_builder_destroy, part_bldr_destroy);
+
+    atomic_set(&seqno, 0);
+    err = c0sk_open(&kvdb_rp, 0, "mock_mp", &mock_health, &seqno, 0, &mkvdb.ikdb_c0sk);
+    ASSERT_EQ(0, err);
+
+    err = create_mock_cn(&mock_cn, false, false, &kvs_rp, 0);
+    ASSERT_EQ(0, err);
+
+    self = c0sk_h2r(mkvdb.ikdb_c0sk);
+
+    for (i = 0; i < PART_KVS_CNT; i++) {
+        err = c0sk_c0_register(mkvdb.ikdb_c0sk, mock_cn, &skidx[i]);
+        ASSERT_EQ(0, err);
+    }
+
+    err = c0kvms_create(1, false, &seqno, NULL, &kvms);
+    ASSERT_EQ(0, err);
+
+    err = c0sk_install_c0kvms(self, NULL, kvms);
+    ASSERT_EQ(0, err);
+
+    /* Each key is prefixed by its kvs index, and the keys of each kvs
+     * are put in a scrambled order.
+     */
+    kvs_ktuple_init(&kt, kdata, sizeof(kdata));
+    kvs_vtuple_init(&vt, &val, sizeof(val));
+
+    for (i = 0; i < PART_KEY_CNT; i++) {
+        u32 knum = htonl((i * 7919) % PART_KEY_CNT);
+
+        memcpy(kdata + 1, &knum, sizeof(knum));
+
+        for (j = 0; j < PART_KVS_CNT; j++) {
+            kdata[0] = skidx[j];
+            kvs_ktuple_init(&kt, kdata, sizeof(kdata));
+
+            err = c0sk_put(mkvdb.ikdb_c0sk, skidx[j], &kt, &vt, HSE_SQNREF_SINGLE);
+            ASSERT_EQ(0, err);
+        }
+    }
+
+    err = c0sk_sync(mkvdb.ikdb_c0sk, 0);
+    ASSERT_EQ(0, err);
+
+    c0kvms_putref(kvms);
+
+    err = c0sk_close(mkvdb.ikdb_c0sk);
+    ASSERT_EQ(0, err);
+
+    /* Every kvs got one kvset holding all its keys in order, built by
+     * a builder that no other kvs shared.
+     */
+    tidc = 0;
+    for (i = 0; i < PART_KVS_CNT; i++) {
+        struct part_kvs *pk = &part_kvsv[skidx[i]];
+
+        ASSERT_EQ(PART_KEY_CNT, pk->keyc);
+        ASSERT_EQ(1, pk->mbc);
+        ASSERT_FALSE(pk->unsorted);
+        ASSERT_FALSE(pk->mixed);
+
+        for (j = 0; j < i; j++) {
+            if (pthread_equal(pk->tid, part_kvsv[skidx[j]].tid))
+                break;
+        }
+        if (j == i)
+            tidc++;
+    }
+
+    /* The kvses were split into several parts built on distinct threads */
+    ASSERT_GT(tidc, 1);
+    ASSERT_LE(tidc, kvdb_rp.c0_build_threads);
+    ASSERT_EQ(0, atomic_read(&part_bldrc));
+
+    MOCK_UNSET_FN(kvset_builder, kvset_builder_add_key);
+    MOCK_UNSET_FN(kvset_builder, kvset_builder_get_mblocks);
+    MOCK_UNSET_FN(kvset_builder, kvset_builder_destroy);
+    MOCK_SET(kvset_builder, _kvset_builder_create);
+
+    mapi_inject(mapi_idx_kvset_builder_add_key, 0);
+    mapi_inject(mapi_idx_kvset_builder_get_mblocks, 0);
+    mapi_inject(mapi_idx_kvset_builder_destroy, 0);
+
+    destroy_mock_cn(mock_cn);
+}
+
 MTF_END_UTEST_COLLECTION(c0sk_test)
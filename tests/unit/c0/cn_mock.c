@@ -105,6 +105,8 @@ struct mapi_injection inject_list[] = {
     { mapi_idx_cn_disable_maint, MAPI_RC_SCALAR, 0},
     { mapi_idx_cn_get_cnid, MAPI_RC_SCALAR, 1},
     { mapi_idx_cn_get_rp, MAPI_RC_SCALAR, 0},
+    { mapi_idx_cn_get_merge_op, MAPI_RC_SCALAR, 0},
+    { mapi_idx_cn_get_compact_filter, MAPI_RC_SCALAR, 0},
     { mapi_idx_cn_disable_maint, MAPI_RC_SCALAR, 0},
     { -1 }
 };
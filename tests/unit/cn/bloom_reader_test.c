@@ -106,7 +106,8 @@ read_blooms(struct mtf_test_info *lcl_ti, char *kblock_file)
     mpm_mblock_read(blkid, &blm_hdr, omf_kbh_blm_hoff(&kb_hdr), omf_kbh_blm_hlen(&kb_hdr));
 
     ASSERT_EQ(omf_bh_magic(&blm_hdr), BLOOM_OMF_MAGIC);
-    ASSERT_EQ(omf_bh_version(&blm_hdr), BLOOM_OMF_VERSION);
+    /* The kblock images predate the cache-line blocked layout. */
+    ASSERT_EQ(omf_bh_version(&blm_hdr), BLOOM_OMF_VERSION5);
 
     ASSERT_GE(omf_bh_bktshift(&blm_hdr), 9);
     ASSERT_LE(omf_bh_bktshift(&blm_hdr), 16);
@@ -124,6 +125,7 @@ read_blooms(struct mtf_test_info *lcl_ti, char *kblock_file)
     rgndesc.bd_bktmask = (1u << rgndesc.bd_bktshift) - 1;
     rgndesc.bd_rotl = omf_bh_rotl(&blm_hdr);
     rgndesc.bd_n_hashes = omf_bh_n_hashes(&blm_hdr);
+    rgndesc.bd_version = omf_bh_version(&blm_hdr);
 
     blm_pages = mapi_safe_malloc(omf_bh_bitmapsz(&blm_hdr));
     ASSERT_TRUE(blm_pages != NULL);
@@ -3,10 +3,13 @@
  * Copyright (C) 2015-2021 Micron Technology, Inc.  All rights reserved.
  */
 
+#include <unistd.h>
+
 #include <mtf/framework.h>
 #include <mock/api.h>
 
 #include <hse/error/merr.h>
+#include <hse_util/atomic.h>
 #include <hse_util/inttypes.h>
 
 #include <hse_ikvdb/kvs_cparams.h>
@@ -18,6 +21,8 @@
 #include <cn/cn_tree_create.h>
 #include <cn/cn_internal.h>
 #include <cn/cn_perfc.h>
+#include <cn/cn_tree_internal.h>
+#include <cn/kvset.h>
 
 static int
 init(struct mtf_test_info *lcl_ti)
@@ -75,6 +80,140 @@ struct mapi_injection inject_list[] = {
     { -1 }
 };
 
+/*----------------------------------------------------------------
+ * Mocked kvsets, restored from a mocked cndb
+ */
+#define KVSET_CNT 64
+
+struct fake_kvset {
+    struct kvset_list_entry kle;
+    uint64_t                kvsetid;
+    uint64_t                dgen;
+    struct kvset_stats      stats;
+};
+
+static uint64_t   kvset_fail_id;
+static atomic_int kvset_opened;
+
+static merr_t
+_cndb_cn_instantiate(struct cndb *cndb, u64 cnid, void *ctx, cn_init_callback *cb)
+{
+    merr_t err;
+    uint   i;
+
+    for (i = 0; i < KVSET_CNT; i++) {
+        struct kvset_meta km = { 0 };
+
+        km.km_nodeid = 0;
+        km.km_dgen_hi = km.km_dgen_lo = i + 1;
+
+        err = cb(ctx, &km, i + 1);
+        if (err)
+            return err;
+    }
+
+    return 0;
+}
+
+static merr_t
+_kvset_open(struct cn_tree *tree, u64 kvsetid, struct kvset_meta *km, struct kvset **ksp)
+{
+    struct fake_kvset *ks;
+
+    /* Complete the opens out of order */
+    usleep((kvsetid % 7) * 100);
+
+    if (kvsetid == kvset_fail_id)
+        return merr(EIO);
+
+    ks = calloc(1, sizeof(*ks));
+    if (!ks)
+        return merr(ENOMEM);
+
+    ks->kle.le_kvset = (void *)ks;
+    ks->kvsetid = kvsetid;
+    ks->dgen = km->km_dgen_hi;
+    ks->stats.kst_keys = 1;
+    ks->stats.kst_kvsets = 1;
+
+    atomic_inc(&kvset_opened);
+    *ksp = (void *)ks;
+
+    return 0;
+}
+
+static void
+_kvset_put_ref(struct kvset *ks)
+{
+    atomic_dec(&kvset_opened);
+    free(ks);
+}
+
+static u64
+_kvset_get_dgen(const struct kvset *ks)
+{
+    return ((struct fake_kvset *)ks)->dgen;
+}
+
+static u64
+_kvset_get_dgen_lo(const struct kvset *ks)
+{
+    return ((struct fake_kvset *)ks)->dgen;
+}
+
+static bool
+_kvset_younger(const struct kvset *ks1, const struct kvset *ks2)
+{
+    return _kvset_get_dgen(ks1) >= _kvset_get_dgen(ks2);
+}
+
+static void
+_kvset_list_add_tail(struct kvset *ks, struct list_head *head)
+{
+    list_add_tail(&((struct fake_kvset *)ks)->kle.le_link, head);
+}
+
+static const struct kvset_stats *
+_kvset_statsp(const struct kvset *ks)
+{
+    return &((struct fake_kvset *)ks)->stats;
+}
+
+static void
+setup_kvset_mocks(void)
+{
+    mapi_inject(mapi_idx_kvset_get_hlog, 0);
+
+    MOCK_SET(cndb, _cndb_cn_instantiate);
+
+    MOCK_SET(kvset, _kvset_open);
+    MOCK_SET(kvset, _kvset_put_ref);
+    MOCK_SET(kvset, _kvset_get_dgen_lo);
+    MOCK_SET(kvset, _kvset_younger);
+    MOCK_SET(kvset, _kvset_list_add_tail);
+    MOCK_SET(kvset, _kvset_statsp);
+
+    MOCK_SET(kvset_view, _kvset_get_dgen);
+
+    kvset_fail_id = 0;
+    atomic_set(&kvset_opened, 0);
+}
+
+static void
+unset_kvset_mocks(void)
+{
+    MOCK_UNSET(cndb, _cndb_cn_instantiate);
+
+    MOCK_UNSET(kvset, _kvset_open);
+    MOCK_UNSET(kvset, _kvset_put_ref);
+    MOCK_UNSET(kvset, _kvset_get_dgen_lo);
+    MOCK_UNSET(kvset, _kvset_younger);
+    MOCK_UNSET(kvset, _kvset_list_add_tail);
+    MOCK_UNSET(kvset, _kvset_statsp);
+
+    MOCK_UNSET(kvset_view, _kvset_get_dgen);
+}
+
 static void
 setup_mocks(void)
 {
@@ -194,4 +333,67 @@ MTF_DEFINE_UTEST_PREPOST(cn_open_test, cn_open_err_path, pre, post)
     ASSERT_EQ(err, 123);
 }
 
+MTF_DEFINE_UTEST_PREPOST(cn_open_test, cn_open_kvsets, pre, post)
+{
+    struct kvset_list_entry *le;
+    struct cn_tree *tree;
+    struct cn *cn;
+    uint64_t dgen;
+    merr_t err;
+    uint cnt;
+
+    setup_kvset_mocks();
+    rp->cn_maint_disable = true;
+
+    /* The kvsets are opened in parallel and must all land in the root,
+     * youngest first, whatever order their opens complete in.
+     */
+    err = cn_open(CN_OPEN_ARGS, &cn);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(KVSET_CNT, atomic_read(&kvset_opened));
+
+    tree = cn_get_tree(cn);
+    dgen = KVSET_CNT;
+    cnt = 0;
+
+    list_for_each_entry(le, &tree->ct_root->tn_kvset_list, le_link) {
+        struct fake_kvset *ks = (void *)le->le_kvset;
+
+        ASSERT_EQ(dgen, ks->dgen);
+        ASSERT_EQ(dgen, ks->kvsetid);
+        dgen--;
+        cnt++;
+    }
+    ASSERT_EQ(KVSET_CNT, cnt);
+
+    cn_close(cn);
+    ASSERT_EQ(0, atomic_read(&kvset_opened));
+
+    unset_kvset_mocks();
+}
+
+MTF_DEFINE_UTEST_PREPOST(cn_open_test, cn_open_kvset_err, pre, post)
+{
+    static const uint64_t failv[] = { 1, KVSET_CNT / 2, KVSET_CNT };
+    struct cn *cn;
+    merr_t err;
+    uint i;
+
+    setup_kvset_mocks();
+    rp->cn_maint_disable = true;
+
+    /* A failed open fails cn_open() once all the opens have finished,
+     * and the kvsets that did open are released.
+     */
+    for (i = 0; i < NELEM(failv); i++) {
+        kvset_fail_id = failv[i];
+
+        err = cn_open(CN_OPEN_ARGS, &cn);
+        ASSERT_EQ(EIO, merr_errno(err));
+        ASSERT_EQ(0, atomic_read(&kvset_opened));
+    }
+
+    unset_kvset_mocks();
+}
+
 MTF_END_UTEST_COLLECTION(cn_open_test)
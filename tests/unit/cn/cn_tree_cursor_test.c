@@ -86,6 +86,7 @@ _bin_heap_pop(struct bin_heap *bh, void **item)
     curr->item.vctx.kmd = curr;
     curr->item.vctx.next = 0;
     curr->item.vctx.nvals = 1;
+    curr->item.vctx.expire = 0;
     curr->item.src = &dummy_kviter.kvi_es;
 
     *item = &curr->item;
@@ -152,6 +153,9 @@ _kvset_iter_val_get(
 
     switch (vtype) {
     case VTYPE_IVAL:
+    case VTYPE_LIVAL:
+    case VTYPE_CIVAL:
+    case VTYPE_MVAL:
     case VTYPE_UCVAL:
     case VTYPE_CVAL:
         *vdata = kv->kdata;
@@ -3,6 +3,8 @@
  * Copyright (C) 2015-2022 Micron Technology, Inc.  All rights reserved.
  */
 
+#include <ctype.h>
+
 #include <mtf/framework.h>
 
 #include <hse/error/merr.h>
@@ -288,6 +290,8 @@ struct mapi_injection inject_list[] = {
     { mapi_idx_kvset_kblk_start, MAPI_RC_SCALAR, KVSET_MISS_KEY_TOO_SMALL },
     { mapi_idx_kvset_get_seqno_max, MAPI_RC_SCALAR, 1234 },
     { mapi_idx_kvset_get_hlog, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_load, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_is_loaded, MAPI_RC_SCALAR, 1 },
     { mapi_idx_kvset_get_vbsetv, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kvset_get_vgroups, MAPI_RC_SCALAR, 1 },
     { mapi_idx_vgmap_vbidx_out_end, MAPI_RC_SCALAR, 0},
@@ -305,6 +309,7 @@ struct mapi_injection inject_list[] = {
     { mapi_idx_cn_get_flags, MAPI_RC_SCALAR, 0 },
     { mapi_idx_cn_get_sched, MAPI_RC_SCALAR, 0 },
     { mapi_idx_cn_get_maint_wq, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_cn_get_wr_wq, MAPI_RC_PTR, NULL },
     { mapi_idx_cn_inc_ingest_dgen, MAPI_RC_SCALAR, 0 },
     { mapi_idx_cn_mpool_dev_zone_alloc_unit_default, MAPI_RC_SCALAR, 32 << 20 },
     { mapi_idx_cn_ref_get, MAPI_RC_SCALAR, 0 },
@@ -358,6 +363,7 @@ struct mapi_injection inject_list[] = {
     { mapi_idx_kvset_builder_create, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kvset_builder_set_merge_stats, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kvset_builder_set_agegroup, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_builder_set_wq, MAPI_RC_SCALAR, 0 },
     { mapi_idx_kvset_builder_get_mblocks, MAPI_RC_SCALAR, 0 },
 
     { -1 },
@@ -841,6 +847,102 @@ MTF_DEFINE_UTEST_PRE(test, cn_node_get_minmax, test_setup)
     test_tree_destroy(&t);
 }
 
+/* Drops keys that start with 'd', upper cases values of keys that start
+ * with 'c' and keeps everything else.
+ */
+static enum hse_kvs_compact_filter_res
+test_filter(
+    void *      arg,
+    const void *key,
+    size_t      key_len,
+    const void *value,
+    size_t      value_len,
+    uint64_t    seqno,
+    void *      new_value,
+    size_t      new_value_sz,
+    size_t *    new_value_len)
+{
+    const char *k = key;
+
+    ++*(int *)arg;
+
+    if (k[0] == 'd')
+        return HSE_KVS_COMPACT_FILTER_DROP;
+
+    if (k[0] != 'c' || value_len > new_value_sz)
+        return HSE_KVS_COMPACT_FILTER_KEEP;
+
+    for (size_t i = 0; i < value_len; i++)
+        ((char *)new_value)[i] = toupper(((const char *)value)[i]);
+
+    *new_value_len = value_len;
+
+    return HSE_KVS_COMPACT_FILTER_CHANGE;
+}
+
+MTF_DEFINE_UTEST_PRE(test, t_compact_filter, test_setup)
+{
+    struct cn_compact_filter_ctx ctx = { 0 };
+    struct cn_compact_filter filter;
+    struct key_obj kobj;
+    const void *vdata;
+    uint vlen, complen;
+    int calls = 0;
+    bool drop;
+    merr_t err;
+
+    filter.cf_fn = test_filter;
+    filter.cf_arg = &calls;
+
+    ctx.cfc_filter = &filter;
+    ctx.cfc_nbufsz = 8;
+    ctx.cfc_nbuf = malloc(ctx.cfc_nbufsz);
+    ASSERT_NE(NULL, ctx.cfc_nbuf);
+
+    /* keep */
+    key2kobj(&kobj, "keep", 4);
+    vdata = "value";
+    vlen = 5;
+    complen = 0;
+    err = cn_compact_filter(&ctx, &kobj, 1, &vdata, &vlen, &complen, &drop);
+    ASSERT_EQ(0, err);
+    ASSERT_FALSE(drop);
+    ASSERT_EQ(0, memcmp(vdata, "value", 5));
+
+    /* drop */
+    key2kobj(&kobj, "drop", 4);
+    err = cn_compact_filter(&ctx, &kobj, 2, &vdata, &vlen, &complen, &drop);
+    ASSERT_EQ(0, err);
+    ASSERT_TRUE(drop);
+
+    /* change, the key is passed as a single buffer */
+    kobj.ko_pfx = "ch";
+    kobj.ko_pfx_len = 2;
+    kobj.ko_sfx = "ange";
+    kobj.ko_sfx_len = 4;
+    err = cn_compact_filter(&ctx, &kobj, 3, &vdata, &vlen, &complen, &drop);
+    ASSERT_EQ(0, err);
+    ASSERT_FALSE(drop);
+    ASSERT_EQ(ctx.cfc_nbuf, vdata);
+    ASSERT_EQ(5, vlen);
+    ASSERT_EQ(0, complen);
+    ASSERT_EQ(0, memcmp(vdata, "VALUE", 5));
+
+    /* a replacement that doesn't fit is declined by the filter */
+    key2kobj(&kobj, "change", 6);
+    vdata = "long value";
+    vlen = 10;
+    err = cn_compact_filter(&ctx, &kobj, 4, &vdata, &vlen, &complen, &drop);
+    ASSERT_EQ(0, err);
+    ASSERT_FALSE(drop);
+    ASSERT_EQ(10, vlen);
+    ASSERT_EQ(0, memcmp(vdata, "long value", 10));
+
+    ASSERT_EQ(4, calls);
+
+    free(ctx.cfc_nbuf);
+}
+
 #define MY_TEST1(NAME, N1, V1, VERBOSE)                     \
     MTF_DEFINE_UTEST_PRE(test, NAME##_##N1##V1, test_setup) \
     {                                                       \
@@ -474,4 +474,57 @@ MTF_DEFINE_UTEST_PREPOST(hblock_reader_test, corrupt_version, test_pre, test_pos
     ASSERT_EQ(0, merr_errno(err));
 }
 
+/* Version 1 hblocks predate range tombstones, whatever lies where a version 2
+ * header keeps the range tombstone region must be ignored.
+ */
+MTF_DEFINE_UTEST_PREPOST(hblock_reader_test, read_rtombs_v1, test_pre, test_post)
+{
+    merr_t err;
+    struct mpool *mpool = (void *)-1;
+    struct mpool_mcache_map *map;
+    struct hdr hdr;
+    uint64_t blkid;
+    struct kvs_mblk_desc desc;
+    struct mblock_props props;
+    struct kvs_rtomb *rtv = (void *)-1;
+    uint32_t rtc = 1;
+    uint64_t min_seqno, max_seqno;
+
+    err = mpm_mblock_alloc(FAKE_BLOCK_SIZE, &blkid);
+    ASSERT_EQ(0, merr_errno(err));
+
+    err = mpm_mblock_write(blkid, fake_mblock_buf, 0, FAKE_BLOCK_SIZE);
+    ASSERT_EQ(0, merr_errno(err));
+
+    err = mpool_mcache_mmap(mpool, 1, &blkid, &map);
+    ASSERT_EQ(0, merr_errno(err));
+
+    err = mpool_mblock_props_get(mpool, blkid, &props);
+    ASSERT_EQ(0, merr_errno(err));
+
+    init_hdr(&hdr);
+    omf_set_hbh_version(hdr.hblk_hdr, HBLOCK_HDR_VERSION1);
+    omf_set_hbh_num_rtombs(hdr.hblk_hdr, 7);
+    omf_set_hbh_rtomb_off_pg(hdr.hblk_hdr, 1000);
+    omf_set_hbh_rtomb_len_pg(hdr.hblk_hdr, 1000);
+    err = mpm_mblock_write(blkid, hdr.data, 0, HBLOCK_HDR_PAGES * PAGE_SIZE);
+    ASSERT_EQ(0, merr_errno(err));
+
+    err = hbr_read_desc(mpool, map, &props, blkid, &desc);
+    ASSERT_EQ(0, merr_errno(err));
+
+    err = hbr_read_seqno_range(&desc, &min_seqno, &max_seqno);
+    ASSERT_EQ(0, merr_errno(err));
+    ASSERT_EQ(11, min_seqno);
+    ASSERT_EQ(101, max_seqno);
+
+    err = hbr_read_rtombs(&desc, &rtv, &rtc);
+    ASSERT_EQ(0, merr_errno(err));
+    ASSERT_EQ(NULL, rtv);
+    ASSERT_EQ(0, rtc);
+
+    err = mpool_mblock_delete(mpool, blkid);
+    ASSERT_EQ(0, merr_errno(err));
+}
+
 MTF_END_UTEST_COLLECTION(hblock_reader_test)
@@ -666,6 +666,7 @@ pre(struct mtf_test_info *info)
     mapi_inject(mapi_idx_cndb_kvsetid_mint, 1);
     mapi_inject(mapi_idx_kvset_builder_set_agegroup, 0);
     mapi_inject(mapi_idx_kvset_builder_set_merge_stats, 0);
+    mapi_inject(mapi_idx_kvset_builder_set_wq, 0);
 
     return 0;
 }
@@ -0,0 +1,620 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <mtf/framework.h>
+#include <mock/api.h>
+
+#include <unistd.h>
+
+#include <hse_util/platform.h>
+#include <hse_util/keycmp.h>
+#include <hse_util/workqueue.h>
+
+#include <hse_ikvdb/cn.h>
+#include <hse_ikvdb/cndb.h>
+#include <hse_ikvdb/encoders.h>
+#include <hse_ikvdb/kvs_cparams.h>
+#include <hse_ikvdb/kvs_rparams.h>
+#include <hse_ikvdb/kvset_builder.h>
+#include <hse_ikvdb/tuple.h>
+
+#include <cn/cn_metrics.h>
+#include <cn/cn_tree.h>
+#include <cn/cn_tree_compact.h>
+#include <cn/kvcompact.h>
+#include <cn/kvset.h>
+#include <cn/node_split.h>
+
+#include <mocks/mock_kvset.h>
+
+/*
+ * The kvset builders are replaced by mocks that record the keys and values
+ * they are given, so that the output of a kv-compaction split into several
+ * key ranges can be compared to that of a serial kv-compaction of the same
+ * input kvsets.  The range keys are supplied by a mocked
+ * cn_compact_range_keys().
+ */
+
+#define KVSET_CNT  4
+#define KEY_MAX    2048
+#define RKEY_MAX   8
+
+/* Newest kvset first, with overlapping key ranges and a kvset of tombstones */
+static struct nkv_tab nkv_tabv[KVSET_CNT] = {
+    { 300, 100, 1000, VMX_S32, KVDATA_BE_KEY, 4 },
+    { 500, 10, 2000, VMX_S32, KVDATA_BE_KEY, 3 },
+    { 500, 250, -1, VMX_S32, KVDATA_BE_KEY, 2 },
+    { 110, 900, 3000, VMX_S32, KVDATA_BE_KEY, 1 },
+};
+
+struct test_kv {
+    uint kvc;
+    int  keyv[KEY_MAX];
+    int  valv[KEY_MAX];
+};
+
+struct test_bldr {
+    uint           vbidx_base;
+    uint           vbidx_max;
+    int            val;
+    bool           val_set;
+    struct test_kv kv;
+};
+
+static struct workqueue_struct *io_wq;
+
+static struct test_kv output;
+static uint           concat_bldc;
+static int            bldr_live;
+static int            efbig_range;
+
+static int  rkeyv[RKEY_MAX];
+static uint rkeyc;
+
+static u64  prog_interval;
+static uint progc;
+static u64  prog_keys_out;
+static uint add_key_delay_us;
+
+static merr_t
+_kvset_builder_create(
+    struct kvset_builder **builder_out,
+    struct cn *            cn,
+    struct perfc_set *     pc,
+    u64                    vgroup)
+{
+    struct test_bldr *bld;
+
+    bld = calloc(1, sizeof(*bld));
+    if (!bld)
+        return merr(ENOMEM);
+
+    bld->vbidx_max = HG16_32K_MAX + 1;
+    bldr_live++;
+
+    *builder_out = (void *)bld;
+
+    return 0;
+}
+
+static void
+_kvset_builder_destroy(struct kvset_builder *builder)
+{
+    if (!builder)
+        return;
+
+    bldr_live--;
+    free(builder);
+}
+
+static void
+_kvset_builder_set_vbidx(struct kvset_builder *self, uint base, uint max)
+{
+    struct test_bldr *bld = (void *)self;
+
+    bld->vbidx_base = base;
+    bld->vbidx_max = max;
+}
+
+static merr_t
+_kvset_builder_add_val(
+    struct kvset_builder *self,
+    const struct key_obj *kobj,
+    const void *          vdata,
+    uint                  vlen,
+    u64                   seq,
+    uint                  complen)
+{
+    struct test_bldr *bld = (void *)self;
+
+    /* Pretend that the chosen range ran out of vblock indexes */
+    if (efbig_range >= 0 && bld->vbidx_max <= HG16_32K_MAX &&
+        bld->vbidx_base == efbig_range * bld->vbidx_max)
+        return merr(EFBIG);
+
+    VERIFY_FALSE_RET(bld->val_set, merr(EINVAL));
+
+    if (HSE_CORE_IS_TOMB(vdata)) {
+        bld->val = -1;
+    } else {
+        VERIFY_EQ_RET(sizeof(int), vlen, merr(EINVAL));
+        bld->val = *(const int *)vdata;
+    }
+
+    bld->val_set = true;
+
+    return 0;
+}
+
+static merr_t
+_kvset_builder_add_key(struct kvset_builder *self, const struct key_obj *kobj)
+{
+    struct test_bldr *bld = (void *)self;
+    uint klen;
+    int key;
+
+    VERIFY_TRUE_RET(bld->val_set, merr(EINVAL));
+    VERIFY_LT_RET(bld->kv.kvc, KEY_MAX, merr(EINVAL));
+
+    key_obj_copy(&key, sizeof(key), &klen, kobj);
+    VERIFY_EQ_RET(sizeof(key), klen, merr(EINVAL));
+
+    if (add_key_delay_us)
+        usleep(add_key_delay_us);
+
+    bld->kv.keyv[bld->kv.kvc] = ntohl(key);
+    bld->kv.valv[bld->kv.kvc] = bld->val;
+    bld->kv.kvc++;
+    bld->val_set = false;
+
+    return 0;
+}
+
+static void
+output_append(const struct test_kv *kv)
+{
+    for (uint i = 0; i < kv->kvc && output.kvc < KEY_MAX; i++) {
+        output.keyv[output.kvc] = kv->keyv[i];
+        output.valv[output.kvc] = kv->valv[i];
+        output.kvc++;
+    }
+}
+
+static merr_t
+_kvset_builder_get_mblocks(struct kvset_builder *builder, struct kvset_mblocks *mblocks)
+{
+    struct test_bldr *bld = (void *)builder;
+
+    output_append(&bld->kv);
+
+    return 0;
+}
+
+static merr_t
+_kvset_builder_get_mblocks_concat(
+    struct kvset_builder **bldv,
+    uint                   bldc,
+    struct kvset_mblocks  *mblocks)
+{
+    uint vbidx_max = (HG16_32K_MAX + 1) / bldc;
+
+    for (uint i = 0; i < bldc; i++) {
+        struct test_bldr *bld = (void *)bldv[i];
+
+        /* Each range must own a distinct slice of the vblock index space */
+        VERIFY_EQ_RET(i * vbidx_max, bld->vbidx_base, merr(EINVAL));
+        VERIFY_EQ_RET(vbidx_max, bld->vbidx_max, merr(EINVAL));
+
+        output_append(&bld->kv);
+    }
+
+    concat_bldc = bldc;
+
+    return 0;
+}
+
+static merr_t
+_cn_compact_range_keys(
+    struct cn_compaction_work *w,
+    unsigned int rangec,
+    void *keyv,
+    unsigned int *klenv,
+    unsigned int *keycp)
+{
+    uint keyc = min_t(uint, rkeyc, rangec - 1);
+
+    for (uint i = 0; i < keyc; i++) {
+        int key = htonl(rkeyv[i]);
+
+        memcpy((char *)keyv + i * HSE_KVS_KEY_LEN_MAX, &key, sizeof(key));
+        klenv[i] = sizeof(key);
+    }
+
+    *keycp = keyc;
+
+    return 0;
+}
+
+static struct workqueue_struct *
+_cn_get_io_wq(struct cn *cn)
+{
+    return io_wq;
+}
+
+static struct mapi_injection inject_list[] = {
+    { mapi_idx_cn_tree_get_cn, MAPI_RC_PTR, NULL },
+    { mapi_idx_cn_tree_get_cndb, MAPI_RC_PTR, NULL },
+    { mapi_idx_cndb_kvsetid_mint, MAPI_RC_SCALAR, 1 },
+    { mapi_idx_cn_get_flags, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_cn_get_maint_wq, MAPI_RC_PTR, NULL },
+    { mapi_idx_cn_get_wr_wq, MAPI_RC_PTR, NULL },
+    { mapi_idx_cn_get_merge_op, MAPI_RC_PTR, NULL },
+    { mapi_idx_cn_get_compact_filter, MAPI_RC_PTR, NULL },
+    { mapi_idx_kvset_get_ref, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_iter_set_stats, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_has_ptree, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_builder_set_merge_stats, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_builder_set_agegroup, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_builder_set_wq, MAPI_RC_SCALAR, 0 },
+    { mapi_idx_kvset_builder_set_expire, MAPI_RC_SCALAR, 0 },
+    { -1 },
+};
+
+static int
+collection_pre(struct mtf_test_info *info)
+{
+    /* The mocked kvset iterators share static value buffers, so the
+     * ranges must run one at a time.
+     */
+    io_wq = alloc_workqueue("kvcompact_test", 0, 1, 1);
+
+    return io_wq ? 0 : -1;
+}
+
+static int
+collection_post(struct mtf_test_info *info)
+{
+    destroy_workqueue(io_wq);
+
+    return 0;
+}
+
+static int
+pre(struct mtf_test_info *info)
+{
+    memset(&output, 0, sizeof(output));
+    concat_bldc = 0;
+    bldr_live = 0;
+    efbig_range = -1;
+    rkeyc = 0;
+    prog_interval = 0;
+    progc = 0;
+    prog_keys_out = 0;
+    add_key_delay_us = 0;
+
+    mock_kvset_set();
+
+    mapi_inject_list_set(inject_list);
+
+    MOCK_SET(kvset_builder, _kvset_builder_create);
+    MOCK_SET(kvset_builder, _kvset_builder_destroy);
+    MOCK_SET(kvset_builder, _kvset_builder_set_vbidx);
+    MOCK_SET(kvset_builder, _kvset_builder_add_val);
+    MOCK_SET(kvset_builder, _kvset_builder_add_key);
+    MOCK_SET(kvset_builder, _kvset_builder_get_mblocks);
+    MOCK_SET(kvset_builder, _kvset_builder_get_mblocks_concat);
+    MOCK_SET(node_split, _cn_compact_range_keys);
+    MOCK_SET(cn, _cn_get_io_wq);
+
+    return 0;
+}
+
+static int
+post(struct mtf_test_info *info)
+{
+    MOCK_UNSET(kvset_builder, _kvset_builder_create);
+    MOCK_UNSET(kvset_builder, _kvset_builder_destroy);
+    MOCK_UNSET(kvset_builder, _kvset_builder_set_vbidx);
+    MOCK_UNSET(kvset_builder, _kvset_builder_add_val);
+    MOCK_UNSET(kvset_builder, _kvset_builder_add_key);
+    MOCK_UNSET(kvset_builder, _kvset_builder_get_mblocks);
+    MOCK_UNSET(kvset_builder, _kvset_builder_get_mblocks_concat);
+    MOCK_UNSET(node_split, _cn_compact_range_keys);
+    MOCK_UNSET(cn, _cn_get_io_wq);
+
+    mapi_inject_list_unset(inject_list);
+
+    mock_kvset_unset();
+
+    return 0;
+}
+
+static void
+set_range_keys(uint keyc, const int *keyv)
+{
+    assert(keyc <= RKEY_MAX);
+
+    memcpy(rkeyv, keyv, keyc * sizeof(*keyv));
+    rkeyc = keyc;
+}
+
+/* The value of @key in the newest kvset that contains it, -1 if a tombstone */
+static bool
+expected(int key, int *val)
+{
+    for (uint i = 0; i < KVSET_CNT; i++) {
+        const struct nkv_tab *nkv = nkv_tabv + i;
+
+        if (key >= nkv->key1 && key < nkv->key1 + nkv->nkeys) {
+            *val = (nkv->val1 == -1) ? -1 : nkv->val1 + key - nkv->key1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int
+verify_output(void)
+{
+    uint i = 0;
+    int val;
+
+    for (int key = 0; key < KEY_MAX; key++) {
+        if (!expected(key, &val))
+            continue;
+
+        VERIFY_LT_RET(i, output.kvc, __LINE__);
+        VERIFY_EQ_RET(key, output.keyv[i], __LINE__);
+        VERIFY_EQ_RET(val, output.valv[i], __LINE__);
+        i++;
+    }
+
+    VERIFY_EQ_RET(i, output.kvc, __LINE__);
+
+    return 0;
+}
+
+static void
+report_progress(struct cn_compaction_work *w)
+{
+    /* Reports from the caller of a parallel compaction must never go
+     * backwards.
+     */
+    if (w->cw_stats.ms_keys_out >= prog_keys_out)
+        prog_keys_out = w->cw_stats.ms_keys_out;
+    else
+        prog_keys_out = UINT64_MAX;
+
+    progc++;
+}
+
+static merr_t
+run_kvcompact(uint subc, struct cn_merge_stats *stats)
+{
+    struct kvs_rparams        rp = kvs_rparams_defaults();
+    struct kvs_cparams        cp = kvs_cparams_defaults();
+    struct cn_compaction_work w = { 0 };
+    struct kv_iterator *      itv[KVSET_CNT] = { 0 };
+    struct kvset_mblocks      outv[1] = { 0 };
+    struct cn_tree_node *     output_nodev[1] = { 0 };
+    uint64_t                  kvsetidv[1] = { 0 };
+    atomic_int                cancel;
+    merr_t                    err = 0;
+    uint                      i;
+
+    atomic_set(&cancel, 0);
+
+    for (i = 0; i < KVSET_CNT && !err; i++)
+        err = mock_make_kvi(&itv[i], i, &rp, &nkv_tabv[i]);
+
+    if (!err) {
+        w.cw_rp = &rp;
+        w.cw_cp = &cp;
+        w.cw_kvset_cnt = KVSET_CNT;
+        w.cw_inputv = itv;
+        w.cw_cancel_request = &cancel;
+        w.cw_outv = outv;
+        w.cw_output_nodev = output_nodev;
+        w.cw_kvsetidv = kvsetidv;
+        w.cw_horizon = UINT64_MAX;
+        w.cw_subc = subc;
+        w.cw_action = CN_ACTION_COMPACT_KV;
+        w.cw_prog_interval = prog_interval;
+        w.cw_progress = prog_interval ? report_progress : NULL;
+
+        err = cn_kvcompact(&w);
+        *stats = w.cw_stats;
+    }
+
+    for (i = 0; i < KVSET_CNT; i++) {
+        struct mock_kv_iterator *iter;
+
+        if (!itv[i])
+            continue;
+
+        iter = container_of(itv[i], typeof(*iter), kvi);
+        kvset_put_ref((struct kvset *)iter->kvset);
+        kvset_iter_release(itv[i]);
+    }
+
+    return err;
+}
+
+static int
+verify_stats(const struct cn_merge_stats *want, const struct cn_merge_stats *have)
+{
+    VERIFY_EQ_RET(want->ms_keys_in, have->ms_keys_in, __LINE__);
+    VERIFY_EQ_RET(want->ms_keys_out, have->ms_keys_out, __LINE__);
+    VERIFY_EQ_RET(want->ms_key_bytes_in, have->ms_key_bytes_in, __LINE__);
+    VERIFY_EQ_RET(want->ms_key_bytes_out, have->ms_key_bytes_out, __LINE__);
+    VERIFY_EQ_RET(want->ms_val_bytes_out, have->ms_val_bytes_out, __LINE__);
+
+    return 0;
+}
+
+MTF_BEGIN_UTEST_COLLECTION_PREPOST(kvcompact_test, collection_pre, collection_post)
+
+MTF_DEFINE_UTEST_PREPOST(kvcompact_test, serial, pre, post)
+{
+    struct cn_merge_stats stats;
+    merr_t err;
+
+    err = run_kvcompact(1, &stats);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, verify_output());
+    ASSERT_EQ(0, concat_bldc);
+    ASSERT_EQ(0, bldr_live);
+
+    ASSERT_EQ(output.kvc, stats.ms_keys_out);
+    ASSERT_EQ(output.kvc * sizeof(int), stats.ms_key_bytes_out);
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvcompact_test, ranges, pre, post)
+{
+    static const struct {
+        uint subc;
+        uint keyc;
+        int  keyv[RKEY_MAX];
+    } tv[] = {
+        { 4, 3, { 260, 510, 760 } },
+        { 2, 1, { 100 } },
+        { 8, 7, { 50, 150, 250, 350, 450, 550, 950 } },
+        { 8, 3, { 11, 400, 901 } },
+    };
+    struct cn_merge_stats serial, stats;
+    merr_t err;
+
+    err = run_kvcompact(1, &serial);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, verify_output());
+
+    for (uint i = 0; i < NELEM(tv); i++) {
+        memset(&output, 0, sizeof(output));
+        concat_bldc = 0;
+        set_range_keys(tv[i].keyc, tv[i].keyv);
+
+        err = run_kvcompact(tv[i].subc, &stats);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(tv[i].keyc + 1, concat_bldc);
+        ASSERT_EQ(0, bldr_live);
+
+        ASSERT_EQ(0, verify_output());
+        ASSERT_EQ(0, verify_stats(&serial, &stats));
+    }
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvcompact_test, degenerate_ranges, pre, post)
+{
+    /* Range keys before, after or on the first or last key leave ranges
+     * empty, as do duplicates.  None of them may lose or repeat a key.
+     */
+    static const struct {
+        uint keyc;
+        int  keyv[RKEY_MAX];
+    } tv[] = {
+        { 1, { 5 } },
+        { 1, { 5000 } },
+        { 2, { 5, 5000 } },
+        { 1, { 800 } },
+        { 1, { 10 } },
+        { 1, { 1009 } },
+        { 2, { 300, 300 } },
+        { 4, { 300, 300, 300, 700 } },
+    };
+    struct cn_merge_stats serial, stats;
+    merr_t err;
+
+    err = run_kvcompact(1, &serial);
+    ASSERT_EQ(0, err);
+
+    for (uint i = 0; i < NELEM(tv); i++) {
+        memset(&output, 0, sizeof(output));
+        concat_bldc = 0;
+        set_range_keys(tv[i].keyc, tv[i].keyv);
+
+        err = run_kvcompact(tv[i].keyc + 1, &stats);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(tv[i].keyc + 1, concat_bldc);
+        ASSERT_EQ(0, bldr_live);
+
+        ASSERT_EQ(0, verify_output());
+        ASSERT_EQ(0, verify_stats(&serial, &stats));
+    }
+
+    /* No range keys at all, the compaction runs serially */
+    memset(&output, 0, sizeof(output));
+    concat_bldc = 0;
+    set_range_keys(0, NULL);
+
+    err = run_kvcompact(4, &stats);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, concat_bldc);
+    ASSERT_EQ(0, bldr_live);
+
+    ASSERT_EQ(0, verify_output());
+    ASSERT_EQ(0, verify_stats(&serial, &stats));
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvcompact_test, efbig_fallback, pre, post)
+{
+    static const int keyv[] = { 260, 510, 760 };
+    static const int rangev[] = { 0, 2, 3 };
+    struct cn_merge_stats serial, stats;
+    merr_t err;
+
+    err = run_kvcompact(1, &serial);
+    ASSERT_EQ(0, err);
+
+    /* A range that runs out of vblock indexes fails the parallel compaction
+     * with EFBIG, which is then redone serially from scratch.
+     */
+    for (uint i = 0; i < NELEM(rangev); i++) {
+        memset(&output, 0, sizeof(output));
+        concat_bldc = 0;
+        efbig_range = rangev[i];
+        set_range_keys(NELEM(keyv), keyv);
+
+        err = run_kvcompact(NELEM(keyv) + 1, &stats);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(0, concat_bldc);
+        ASSERT_EQ(0, bldr_live);
+
+        ASSERT_EQ(0, verify_output());
+        ASSERT_EQ(0, verify_stats(&serial, &stats));
+    }
+}
+
+MTF_DEFINE_UTEST_PREPOST(kvcompact_test, progress, pre, post)
+{
+    static const int keyv[] = { 260, 510, 760 };
+    struct cn_merge_stats serial, stats;
+    merr_t err;
+
+    err = run_kvcompact(1, &serial);
+    ASSERT_EQ(0, err);
+
+    /* Slow the ranges down so that the caller wakes up to report progress
+     * several times while it waits for them.
+     */
+    memset(&output, 0, sizeof(output));
+    concat_bldc = 0;
+    set_range_keys(NELEM(keyv), keyv);
+    prog_interval = 1;
+    add_key_delay_us = 50;
+
+    err = run_kvcompact(NELEM(keyv) + 1, &stats);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(NELEM(keyv) + 1, concat_bldc);
+    ASSERT_EQ(0, bldr_live);
+
+    ASSERT_EQ(0, verify_output());
+    ASSERT_EQ(0, verify_stats(&serial, &stats));
+
+    ASSERT_GT(progc, 1);
+    ASSERT_EQ(serial.ms_keys_out, prog_keys_out);
+}
+
+MTF_END_UTEST_COLLECTION(kvcompact_test)
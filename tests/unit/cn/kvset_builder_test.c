@@ -7,13 +7,24 @@
 
 #include <hse/error/merr.h>
 #include <hse_util/inttypes.h>
+#include <hse_util/compression_zstd.h>
+#include <hse_util/hlog.h>
 
 #include <hse_ikvdb/kvset_builder.h>
+#include <hse_ikvdb/omf_kmd.h>
 #include <hse_ikvdb/kvs_rparams.h>
+#include <hse_ikvdb/kvs_cparams.h>
+#include <hse_ikvdb/limits.h>
 #include <hse_ikvdb/cn.h>
 
 #include <hse/limits.h>
 
+#include <cn/blk_list.h>
+#include <cn/hblock_builder.h>
+#include <cn/kblock_builder.h>
+#include <cn/kvset.h>
+#include <cn/vblock_builder.h>
+
 #include <mocks/mock_kbb_vbb.h>
 
 static struct key_obj kobj;
@@ -33,6 +44,7 @@ fini(struct mtf_test_info *mtf)
 #define TEST_DEF_UTAG 1001
 
 static struct kvs_rparams mocked_kvs_rp;
+static struct kvs_cparams mocked_kvs_cp;
 
 struct kvs_rparams *
 mocked_cn_get_rp(const struct cn *cn)
@@ -40,6 +52,12 @@ mocked_cn_get_rp(const struct cn *cn)
     return &mocked_kvs_rp;
 }
 
+struct kvs_cparams *
+mocked_cn_get_cparams(const struct cn *cn)
+{
+    return &mocked_kvs_cp;
+}
+
 int
 pre(struct mtf_test_info *mtf)
 {
@@ -52,6 +70,9 @@ pre(struct mtf_test_info *mtf)
     mocked_kvs_rp = kvs_rparams_defaults();
     MOCK_SET_FN(cn, cn_get_rp, mocked_cn_get_rp);
 
+    mocked_kvs_cp = kvs_cparams_defaults();
+    MOCK_SET_FN(cn, cn_get_cparams, mocked_cn_get_cparams);
+
     mock_kbb_vbb_set();
 
     key2kobj(&kobj, &key, sizeof(key));
@@ -217,6 +238,165 @@ MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_add_val_fail1, pre, post)
     kvset_builder_destroy(bld);
 }
 
+MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_add_val_inline, pre, post)
+{
+    struct kvset_builder *bld = 0;
+    char                  value[2 * CN_INLINE_VALUE_LEN_MAX];
+    merr_t                err;
+    u64                   seq = 10;
+
+    memset(value, 'x', sizeof(value));
+    value[0] = 0x80; /* not a dictionary tag */
+
+    /* With the default threshold, only tiny values are stored in the kmd.
+     */
+    err = KVSET_BUILDER_CREATE();
+    ASSERT_EQ(0, err);
+
+    err = kvset_builder_add_val(bld, &kobj, value, CN_SMALL_VALUE_THRESHOLD, seq--, 0);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, mapi_calls(mapi_idx_vbb_add_entry));
+
+    err = kvset_builder_add_val(bld, &kobj, value, 300, seq--, 0);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(1, mapi_calls(mapi_idx_vbb_add_entry));
+
+    err = kvset_builder_add_val(bld, &kobj, value, 300, seq--, 100);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(2, mapi_calls(mapi_idx_vbb_add_entry));
+
+    kvset_builder_destroy(bld);
+
+    /* Raise the threshold, now short, long and compressed values up to
+     * the threshold are all stored in the kmd.
+     */
+    mocked_kvs_cp.vinline_len = CN_INLINE_VALUE_LEN_MAX;
+    mapi_calls_clear(mapi_idx_vbb_add_entry);
+    seq = 10;
+
+    err = KVSET_BUILDER_CREATE();
+    ASSERT_EQ(0, err);
+
+    err = kvset_builder_add_val(bld, &kobj, value, 200, seq--, 0);
+    ASSERT_EQ(0, err);
+    err = kvset_builder_add_val(bld, &kobj, value, CN_INLINE_VALUE_LEN_MAX, seq--, 0);
+    ASSERT_EQ(0, err);
+    err = kvset_builder_add_val(bld, &kobj, value, 4 * CN_INLINE_VALUE_LEN_MAX, seq--, 900);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, mapi_calls(mapi_idx_vbb_add_entry));
+
+    err = kvset_builder_add_val(bld, &kobj, value, CN_INLINE_VALUE_LEN_MAX + 1, seq--, 0);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(1, mapi_calls(mapi_idx_vbb_add_entry));
+
+    /* Dictionary compressed values must stay with their vblock.
+     */
+    value[0] = COMPRESS_ZSTD_TAG_DICT;
+    err = kvset_builder_add_val(bld, &kobj, value, 300, seq--, 100);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(2, mapi_calls(mapi_idx_vbb_add_entry));
+
+    kvset_builder_destroy(bld);
+}
+
+static u8               expire_kmd[4096];
+static uint             expire_kmd_len;
+static struct key_stats expire_stats;
+
+static merr_t
+_kbb_add_entry(
+    struct kblock_builder *bld,
+    const struct key_obj * kobj,
+    const void *           kmd,
+    uint                   kmd_len,
+    struct key_stats *     stats)
+{
+    memcpy(expire_kmd, kmd, kmd_len);
+    expire_kmd_len = kmd_len;
+    expire_stats = *stats;
+
+    return 0;
+}
+
+MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_expire, pre, post)
+{
+    struct kvset_builder *bld = 0;
+    const char *          value = "abcdefg";
+    enum kmd_vtype        vtype;
+    const void *          vdata;
+    size_t                off = 0;
+    merr_t                err;
+    uint                  vlen;
+    u64                   seq;
+    u32                   expire;
+
+    mapi_inject_unset(mapi_idx_kbb_add_entry);
+    MOCK_SET_FN(kblock_builder, kbb_add_entry, _kbb_add_entry);
+
+    err = KVSET_BUILDER_CREATE();
+    ASSERT_EQ(0, err);
+
+    /* An expiry time applies to the next value only and is
+     * discarded by a tombstone.
+     */
+    kvset_builder_set_expire(bld, 2000);
+    err = kvset_builder_add_val(bld, &kobj, value, strlen(value), 40, 0);
+    ASSERT_EQ(0, err);
+
+    kvset_builder_set_expire(bld, 3000);
+    err = kvset_builder_add_val(bld, &kobj, HSE_CORE_TOMB_REG, 0, 30, 0);
+    ASSERT_EQ(0, err);
+
+    err = kvset_builder_add_val(bld, &kobj, value, strlen(value), 20, 0);
+    ASSERT_EQ(0, err);
+
+    kvset_builder_set_expire(bld, 1000);
+    err = kvset_builder_add_val(bld, &kobj, value, 3, 10, 0);
+    ASSERT_EQ(0, err);
+
+    err = kvset_builder_add_key(bld, &kobj);
+    ASSERT_EQ(0, err);
+
+    ASSERT_EQ(4, expire_stats.nvals);
+    ASSERT_EQ(strlen(value) + 3, expire_stats.ttl_bytes);
+    ASSERT_EQ(1000, expire_stats.ttl_min);
+    ASSERT_EQ(2000, expire_stats.ttl_max);
+
+    kmd_type_seq_expire(expire_kmd, &off, &vtype, &seq, &expire);
+    ASSERT_EQ(VTYPE_IVAL, vtype);
+    ASSERT_EQ(40, seq);
+    ASSERT_EQ(2000, expire);
+    kmd_ival(expire_kmd, &off, &vdata, &vlen);
+    ASSERT_EQ(strlen(value), vlen);
+    ASSERT_EQ(0, memcmp(value, vdata, vlen));
+
+    kmd_type_seq_expire(expire_kmd, &off, &vtype, &seq, &expire);
+    ASSERT_EQ(VTYPE_TOMB, vtype);
+    ASSERT_EQ(0, expire);
+
+    kmd_type_seq_expire(expire_kmd, &off, &vtype, &seq, &expire);
+    ASSERT_EQ(VTYPE_IVAL, vtype);
+    ASSERT_EQ(0, expire);
+    kmd_ival(expire_kmd, &off, &vdata, &vlen);
+
+    /* kmd_type_seq() skips the expiry record.
+     */
+    kmd_type_seq(expire_kmd, &off, &vtype, &seq);
+    ASSERT_EQ(VTYPE_IVAL, vtype);
+    ASSERT_EQ(10, seq);
+    kmd_ival(expire_kmd, &off, &vdata, &vlen);
+    ASSERT_EQ(3, vlen);
+    ASSERT_EQ(expire_kmd_len, off);
+
+    ASSERT_FALSE(kvs_expired(0));
+    ASSERT_TRUE(kvs_expired(1000));
+    ASSERT_FALSE(kvs_expired(UINT32_MAX));
+
+    kvset_builder_destroy(bld);
+
+    MOCK_UNSET_FN(kblock_builder, kbb_add_entry);
+}
+
 MTF_DEFINE_UTEST_PREPOST(test, t_reserve_kmd1, pre, post)
 {
     merr_t err;
@@ -348,6 +528,243 @@ MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_get_mblocks, pre, post)
     kvset_builder_destroy(bld);
 }
 
+static uint vbb_add_cnt;
+
+static merr_t
+_vbb_add_entry(
+    struct vblock_builder *bld,
+    const struct key_obj  *kobj,
+    const void *           vdata,
+    uint                   vlen,
+    u64 *                  vbidout,
+    uint *                 vbidxout,
+    uint *                 vboffout)
+{
+    /* One value per vblock */
+    *vbidout = 0x2000 + vbb_add_cnt;
+    *vbidxout = vbb_add_cnt++;
+    *vboffout = 0;
+
+    return 0;
+}
+
+MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_vbidx, pre, post)
+{
+    struct kvset_builder *bld = 0;
+    char                  value[CN_INLINE_VALUE_LEN_MAX + 1];
+    enum kmd_vtype        vtype;
+    size_t                off = 0;
+    uint                  vbidx, vboff, vlen;
+    merr_t                err;
+    u64                   seq;
+
+    memset(value, 'x', sizeof(value));
+    vbb_add_cnt = 0;
+
+    mapi_inject_unset(mapi_idx_vbb_add_entry);
+    MOCK_SET_FN(vblock_builder, vbb_add_entry, _vbb_add_entry);
+    mapi_inject_unset(mapi_idx_kbb_add_entry);
+    MOCK_SET_FN(kblock_builder, kbb_add_entry, _kbb_add_entry);
+
+    err = KVSET_BUILDER_CREATE();
+    ASSERT_EQ(0, err);
+
+    kvset_builder_set_vbidx(bld, 100, 2);
+
+    err = kvset_builder_add_val(bld, &kobj, value, sizeof(value), 20, 0);
+    ASSERT_EQ(0, err);
+    err = kvset_builder_add_val(bld, &kobj, value, sizeof(value), 10, 0);
+    ASSERT_EQ(0, err);
+    err = kvset_builder_add_key(bld, &kobj);
+    ASSERT_EQ(0, err);
+
+    /* The kblocks record vblock indexes relative to the base.
+     */
+    kmd_type_seq(expire_kmd, &off, &vtype, &seq);
+    ASSERT_EQ(VTYPE_UCVAL, vtype);
+    ASSERT_EQ(20, seq);
+    kmd_val(expire_kmd, &off, &vbidx, &vboff, &vlen);
+    ASSERT_EQ(100, vbidx);
+    ASSERT_EQ(sizeof(value), vlen);
+
+    kmd_type_seq(expire_kmd, &off, &vtype, &seq);
+    ASSERT_EQ(VTYPE_UCVAL, vtype);
+    ASSERT_EQ(10, seq);
+    kmd_val(expire_kmd, &off, &vbidx, &vboff, &vlen);
+    ASSERT_EQ(101, vbidx);
+    ASSERT_EQ(expire_kmd_len, off);
+
+    /* A third vblock is past the builder's share of the index space,
+     * but values stored in the kmd still fit.
+     */
+    err = kvset_builder_add_val(bld, &kobj, value, sizeof(value), 5, 0);
+    ASSERT_EQ(EFBIG, merr_errno(err));
+
+    err = kvset_builder_add_val(bld, &kobj, value, CN_SMALL_VALUE_THRESHOLD, 4, 0);
+    ASSERT_EQ(0, err);
+
+    kvset_builder_destroy(bld);
+
+    MOCK_UNSET_FN(kblock_builder, kbb_add_entry);
+    MOCK_UNSET_FN(vblock_builder, vbb_add_entry);
+}
+
+#define CONCAT_BLDC 3
+
+static const uint concat_nvblks[CONCAT_BLDC] = { 2, 0, 3 };
+static uint           concat_kbbc, concat_vbbc;
+static uint8_t       *concat_hlog;
+
+static struct {
+    uint32_t nkblks;
+    uint32_t nvblks;
+    uint32_t nvgroups;
+    uint16_t vbidx_out[CONCAT_BLDC];
+    uint16_t vbidx_adj[CONCAT_BLDC];
+    uint16_t vbidx_src[CONCAT_BLDC];
+} concat_hblk;
+
+static merr_t
+_kbb_finish(struct kblock_builder *bld, struct blk_list *kblks)
+{
+    return blk_list_append(kblks, 0x1000 + concat_kbbc++);
+}
+
+static merr_t
+_vbb_finish(struct vblock_builder *bld, struct blk_list *vblks, const struct key_obj *max_kobj)
+{
+    merr_t err = 0;
+
+    for (uint i = 0; i < concat_nvblks[concat_vbbc] && !err; i++)
+        err = blk_list_append(vblks, 0x2000 + 0x100 * concat_vbbc + i);
+
+    concat_vbbc++;
+
+    return err;
+}
+
+static const uint8_t *
+_kbb_get_composite_hlog(const struct kblock_builder *bld)
+{
+    return concat_hlog;
+}
+
+static merr_t
+_hbb_finish(
+    struct hblock_builder *bld,
+    struct kvs_block      *blk,
+    const struct vgmap    *vgmap,
+    struct key_obj        *min_pfxp,
+    struct key_obj        *max_pfxp,
+    const uint64_t         min_seqno,
+    const uint64_t         max_seqno,
+    const uint32_t         num_kblocks,
+    const uint32_t         num_vblocks,
+    const uint32_t         num_ptombs,
+    const uint8_t         *hlog,
+    const uint8_t         *ptree,
+    struct wbt_desc       *ptree_desc,
+    uint32_t               ptree_pgc)
+{
+    concat_hblk.nkblks = num_kblocks;
+    concat_hblk.nvblks = num_vblocks;
+    concat_hblk.nvgroups = vgmap ? vgmap->nvgroups : 0;
+
+    for (uint i = 0; i < concat_hblk.nvgroups && i < CONCAT_BLDC; i++) {
+        concat_hblk.vbidx_out[i] = vgmap->vbidx_out[i];
+        concat_hblk.vbidx_adj[i] = vgmap->vbidx_adj[i];
+        concat_hblk.vbidx_src[i] = vgmap->vbidx_src[i];
+    }
+
+    return 0;
+}
+
+MTF_DEFINE_UTEST_PREPOST(test, t_kvset_builder_get_mblocks_concat, pre, post)
+{
+    struct kvset_builder *bldv[CONCAT_BLDC] = { 0 };
+    struct kvset_mblocks  blks = { 0 };
+    struct vgmap          vgmap;
+    uint16_t              vbidx;
+    merr_t                err;
+    uint                  i;
+
+    concat_kbbc = concat_vbbc = 0;
+    memset(&concat_hblk, 0, sizeof(concat_hblk));
+
+    concat_hlog = calloc(1, HLOG_SIZE);
+    ASSERT_NE(NULL, concat_hlog);
+
+    mapi_inject(mapi_idx_kbb_is_empty, 0);
+    mapi_inject_unset(mapi_idx_kbb_finish);
+    MOCK_SET_FN(kblock_builder, kbb_finish, _kbb_finish);
+    mapi_inject_unset(mapi_idx_kbb_get_composite_hlog);
+    MOCK_SET_FN(kblock_builder, kbb_get_composite_hlog, _kbb_get_composite_hlog);
+    mapi_inject_unset(mapi_idx_vbb_finish);
+    MOCK_SET_FN(vblock_builder, vbb_finish, _vbb_finish);
+    mapi_inject_unset(mapi_idx_hbb_finish);
+    MOCK_SET_FN(hblock_builder, hbb_finish, _hbb_finish);
+
+    for (i = 0; i < CONCAT_BLDC; i++) {
+        err = kvset_builder_create(&bldv[i], (void *)-1, 0, i + 1);
+        ASSERT_EQ(0, err);
+
+        kvset_builder_set_vbidx(bldv[i], i * 100, 100);
+    }
+
+    err = kvset_builder_get_mblocks_concat(bldv, CONCAT_BLDC, &blks);
+    ASSERT_EQ(0, err);
+
+    /* One kblock per builder, all the vblocks in builder order.
+     */
+    ASSERT_EQ(CONCAT_BLDC, blks.kblks.n_blks);
+    for (i = 0; i < CONCAT_BLDC; i++)
+        ASSERT_EQ(0x1000 + i, blks.kblks.blks[i].bk_blkid);
+
+    ASSERT_EQ(5, blks.vblks.n_blks);
+    ASSERT_EQ(0x2000, blks.vblks.blks[0].bk_blkid);
+    ASSERT_EQ(0x2001, blks.vblks.blks[1].bk_blkid);
+    ASSERT_EQ(0x2200, blks.vblks.blks[2].bk_blkid);
+    ASSERT_EQ(0x2202, blks.vblks.blks[4].bk_blkid);
+
+    ASSERT_EQ(CONCAT_BLDC, concat_hblk.nkblks);
+    ASSERT_EQ(5, concat_hblk.nvblks);
+
+    /* A builder without vblocks gets no vgroup, and the vgroup map
+     * translates each builder's kblock indexes to the output list.
+     */
+    ASSERT_EQ(2, concat_hblk.nvgroups);
+
+    vgmap.nvgroups = concat_hblk.nvgroups;
+    vgmap.vbidx_out = concat_hblk.vbidx_out;
+    vgmap.vbidx_adj = concat_hblk.vbidx_adj;
+    vgmap.vbidx_src = concat_hblk.vbidx_src;
+
+    err = vgmap_vbidx_src2out(&vgmap, 0, &vbidx);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, vbidx);
+    err = vgmap_vbidx_src2out(&vgmap, 1, &vbidx);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(1, vbidx);
+    err = vgmap_vbidx_src2out(&vgmap, 200, &vbidx);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(2, vbidx);
+    err = vgmap_vbidx_src2out(&vgmap, 202, &vbidx);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(4, vbidx);
+
+    for (i = 0; i < CONCAT_BLDC; i++)
+        kvset_builder_destroy(bldv[i]);
+
+    blk_list_free(&blks.kblks);
+    blk_list_free(&blks.vblks);
+    free(concat_hlog);
+
+    MOCK_UNSET_FN(hblock_builder, hbb_finish);
+    MOCK_UNSET_FN(vblock_builder, vbb_finish);
+    MOCK_UNSET_FN(kblock_builder, kbb_get_composite_hlog);
+    MOCK_UNSET_FN(kblock_builder, kbb_finish);
+}
+
 MTF_DEFINE_UTEST_PREPOST(test, t_kvset_build_destroy, pre, post)
 {
     kvset_builder_destroy(NULL);
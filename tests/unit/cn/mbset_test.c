@@ -339,6 +339,38 @@ MTF_DEFINE_UTEST_PREPOST(test, t_mbset_create_alloc_fail, pre, post)
     mapi_safe_free(idv);
 }
 
+static uint t_udata_fini_calls;
+
+static void
+t_udata_fini(void *udata)
+{
+    struct udata *u = udata;
+
+    u->id = 0;
+    t_udata_fini_calls++;
+}
+
+MTF_DEFINE_UTEST_PREPOST(test, t_mbset_udata_fini, pre, post)
+{
+    u64 *         idv;
+    uint          idc = 7;
+    struct mbset *mbs;
+
+    t_mbs_create(lcl_ti, idc, &idv, &mbs);
+    mbset_set_udata_fini(mbs, t_udata_fini);
+
+    t_udata_fini_calls = 0;
+
+    /* The destructor must not be called until the last ref is dropped.
+     */
+    mbset_get_ref(mbs);
+    mbset_put_ref(mbs);
+    ASSERT_EQ(0, t_udata_fini_calls);
+
+    t_mbs_destroy(lcl_ti, idv, mbs);
+    ASSERT_EQ(idc, t_udata_fini_calls);
+}
+
 MTF_DEFINE_UTEST_PREPOST(test, t_mbset_getters, pre, post)
 {
     u64 *idv = NULL;
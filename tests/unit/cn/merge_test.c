@@ -725,6 +725,15 @@ _kvset_builder_add_val_internal(
             case VTYPE_CVAL:
                 tag = "c";
                 break;
+            case VTYPE_LIVAL:
+                tag = "li";
+                break;
+            case VTYPE_CIVAL:
+                tag = "ci";
+                break;
+            case VTYPE_MVAL:
+                tag = "m";
+                break;
             case VTYPE_ZVAL:
                 tag = "z";
                 break;
@@ -888,6 +897,7 @@ _kvset_iter_next_key(struct kv_iterator *kvi, struct key_obj *kobj, struct kvset
     vc->nvals = 0;
     vc->off = nth_key;
     vc->next = 0;
+    vc->expire = 0;
     /* Spill is always called with a node_dgen of 0, set the kv-pair's dgen to something larger than 0.
      */
     vc->dgen = 10;
@@ -947,6 +957,9 @@ _kvset_iter_next_vref(
             *vlen_out = vlen;
             break;
         case VTYPE_CVAL:
+        case VTYPE_LIVAL:
+        case VTYPE_CIVAL:
+        case VTYPE_MVAL:
             /* not used by this test */
             assert(0);
             break;
@@ -1001,6 +1014,9 @@ _kvset_iter_val_get(
 
     switch (vtype) {
         case VTYPE_CVAL:
+        case VTYPE_LIVAL:
+        case VTYPE_CIVAL:
+        case VTYPE_MVAL:
             /* not used by this test */
             assert(0);
             break;
@@ -1477,6 +1493,7 @@ test_prehook(struct mtf_test_info *info)
     /* Neuter the following APIs */
     mapi_inject_ptr(mapi_idx_cn_tree_get_cn, NULL);
     mapi_inject(mapi_idx_kvset_builder_set_merge_stats, 0);
+    mapi_inject(mapi_idx_kvset_builder_set_wq, 0);
     mapi_inject(mapi_idx_cndb_kvsetid_mint, 1);
     mapi_inject(mapi_idx_cn_tree_get_cndb, 0);
 
@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <mtf/framework.h>
+#include <mock/api.h>
+
+#include <hse_util/bloom_filter.h>
+#include <hse_util/xrand.h>
+
+#include <cn/cn_metrics.h>
+#include <cn/kvset.h>
+#include <cn/node_bloom.h>
+
+#define KEYS_PER_KVSET (10 * 1000)
+#define PROB           (10 * 1000)
+
+static struct kvset_stats fake_kvset_stats = {
+    .kst_keys = KEYS_PER_KVSET,
+    .kst_kvsets = 1,
+};
+
+/* Each fake kvset is just a small integer, which is used to seed the
+ * stream of key hashes it contains.
+ */
+static uint64_t
+fake_hash(uintptr_t ks, uint i)
+{
+    struct xrand xr;
+
+    xrand_init(&xr, (ks << 32) | i);
+
+    return xrand64(&xr);
+}
+
+static const struct kvset_stats *
+_kvset_statsp(const struct kvset *ks)
+{
+    return &fake_kvset_stats;
+}
+
+static merr_t
+_kvset_bloom_insert(struct kvset *ks, struct bloom_filter *bf)
+{
+    for (uint i = 0; i < KEYS_PER_KVSET; i++)
+        bf_filter_insert_by_hash(bf, fake_hash((uintptr_t)ks, i));
+
+    return 0;
+}
+
+static int
+test_pre(struct mtf_test_info *lcl_ti)
+{
+    mapi_inject_clear();
+
+    MOCK_SET(kvset, _kvset_statsp);
+    MOCK_SET(kvset, _kvset_bloom_insert);
+
+    return 0;
+}
+
+MTF_BEGIN_UTEST_COLLECTION(node_bloom_test)
+
+MTF_DEFINE_UTEST_PRE(node_bloom_test, create_invalid, test_pre)
+{
+    struct kvset *kvsetv[] = { (void *)1 };
+    struct node_bloom *nb = NULL;
+    merr_t err;
+
+    err = node_bloom_create(NULL, 1, PROB, &nb);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    err = node_bloom_create(kvsetv, 0, PROB, &nb);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    err = node_bloom_create(kvsetv, 1, 0, &nb);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    err = node_bloom_create(kvsetv, 1, PROB, NULL);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    ASSERT_EQ(NULL, nb);
+
+    node_bloom_destroy(NULL);
+}
+
+MTF_DEFINE_UTEST_PRE(node_bloom_test, create_fail, test_pre)
+{
+    struct kvset *kvsetv[] = { (void *)1, (void *)2 };
+    struct node_bloom *nb = NULL;
+    merr_t err;
+
+    MOCK_UNSET(kvset, _kvset_bloom_insert);
+    mapi_inject(mapi_idx_kvset_bloom_insert, merr(EIO));
+
+    err = node_bloom_create(kvsetv, NELEM(kvsetv), PROB, &nb);
+    ASSERT_EQ(EIO, merr_errno(err));
+    ASSERT_EQ(NULL, nb);
+
+    mapi_inject_unset(mapi_idx_kvset_bloom_insert);
+}
+
+MTF_DEFINE_UTEST_PRE(node_bloom_test, lookup, test_pre)
+{
+    struct kvset *kvsetv[] = { (void *)1, (void *)2, (void *)3, (void *)4 };
+    struct node_bloom *nb, *nb2;
+    uint i, fp = 0;
+    merr_t err;
+
+    err = node_bloom_create(kvsetv, NELEM(kvsetv), PROB, &nb);
+    ASSERT_EQ(0, err);
+    ASSERT_NE(NULL, nb);
+    ASSERT_NE(0, nb->nb_gen);
+    ASSERT_EQ(NELEM(kvsetv) * KEYS_PER_KVSET, nb->nb_keys);
+    ASSERT_TRUE(nb->nb_bf.bf_blocked);
+
+    /* No false negatives...
+     */
+    for (uintptr_t ks = 1; ks <= NELEM(kvsetv); ks++) {
+        for (i = 0; i < KEYS_PER_KVSET; i++)
+            ASSERT_TRUE(node_bloom_lookup(nb, fake_hash(ks, i)));
+    }
+
+    /* ...and roughly the requested false positive rate for keys
+     * that are not in any of the kvsets.
+     */
+    for (i = 0; i < KEYS_PER_KVSET * 10; i++)
+        fp += node_bloom_lookup(nb, fake_hash(NELEM(kvsetv) + 1, i));
+
+    ASSERT_LE(fp, (KEYS_PER_KVSET * 10) * 2 * PROB / 1000000);
+
+    /* Each filter gets a unique generation number.
+     */
+    err = node_bloom_create(kvsetv, 1, PROB, &nb2);
+    ASSERT_EQ(0, err);
+    ASSERT_NE(nb->nb_gen, nb2->nb_gen);
+
+    node_bloom_destroy(nb2);
+    node_bloom_destroy(nb);
+}
+
+MTF_END_UTEST_COLLECTION(node_bloom_test)
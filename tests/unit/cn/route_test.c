@@ -8,6 +8,7 @@
 #include <mock/api.h>
 
 #include <hse_util/inttypes.h>
+#include <hse_util/keycmp.h>
 
 #include <hse_ikvdb/cn.h>
 
@@ -163,4 +164,99 @@ MTF_DEFINE_UTEST(route_test, route_api_test)
     route_map_destroy(map);
 }
 
+/* Reference lookup by linear search over edge keys in ascending order.
+ */
+static uint
+route_ref_find(char ekeyv[][32], uint *eklenv, uint ekeyc, const void *key, uint klen, bool gt)
+{
+    for (uint i = 0; i < ekeyc; i++) {
+        int rc = keycmp(ekeyv[i], eklenv[i], key, klen);
+
+        if (rc > 0 || (rc == 0 && !gt))
+            return i;
+        if (rc == 0)
+            return i + 1; /* ekeyc if %key is the last edge */
+    }
+
+    return ekeyc - 1;
+}
+
+MTF_DEFINE_UTEST(route_test, route_lookup_pfx_test)
+{
+    static const char pfx[] = "tenant/0042/object/";
+    static const uint ekeyc = 48;
+    char ekeyv[ekeyc][32], kbuf[32];
+    uint eklenv[ekeyc], klen;
+    struct route_node *rnodev[ekeyc], *rnode;
+    struct route_map *map;
+    struct cn_tree_node tn;
+
+    map = route_map_create(ekeyc);
+    ASSERT_NE(NULL, map);
+
+    /* Edge keys share a 19-byte prefix, and the last edge is the max key.
+     */
+    for (uint i = 0; i < ekeyc - 1; i++)
+        eklenv[i] = snprintf(ekeyv[i], sizeof(ekeyv[i]), "%s%06u", pfx, i * 10);
+
+    memset(ekeyv[ekeyc - 1], 0xff, sizeof(ekeyv[0]));
+    eklenv[ekeyc - 1] = sizeof(ekeyv[0]);
+
+    /* Insert in an order other than ascending to exercise the index rebuild.
+     */
+    for (uint i = 0; i < ekeyc; i++) {
+        uint j = (i * 7) % ekeyc;
+
+        rnodev[j] = route_map_insert(map, &tn, ekeyv[j], eklenv[j]);
+        ASSERT_NE(NULL, rnodev[j]);
+    }
+
+    for (uint i = 0; i < ekeyc * 10 + 20; i++) {
+        for (uint k = 0; k < 4; k++) {
+            uint ge, gt;
+
+            klen = snprintf(kbuf, sizeof(kbuf), "%s%06u", pfx, i);
+            if (k == 1)
+                kbuf[klen++] = 0; /* edge key plus a trailing NUL */
+            else if (k == 2)
+                klen = (i % (sizeof(pfx) - 1)); /* a prefix of the common prefix */
+            else if (k == 3)
+                kbuf[i % (sizeof(pfx) - 1)] += (i & 1) ? 1 : -1; /* outside the common prefix */
+
+            ge = route_ref_find(ekeyv, eklenv, ekeyc, kbuf, klen, false);
+            gt = route_ref_find(ekeyv, eklenv, ekeyc, kbuf, klen, true);
+
+            rnode = route_map_lookup(map, kbuf, klen);
+            ASSERT_EQ(rnodev[ge], rnode);
+
+            rnode = route_map_lookupGT(map, kbuf, klen);
+            ASSERT_EQ(gt < ekeyc ? rnodev[gt] : NULL, rnode);
+        }
+    }
+
+    for (uint i = 0; i < ekeyc; i++) {
+        rnode = route_map_lookup(map, ekeyv[i], eklenv[i]);
+        ASSERT_EQ(rnodev[i], rnode);
+
+        rnode = route_map_lookupGT(map, ekeyv[i], eklenv[i]);
+        ASSERT_EQ(i + 1 < ekeyc ? rnodev[i + 1] : NULL, rnode);
+    }
+
+    /* Deleting an edge rebuilds the index.
+     */
+    route_map_delete(map, rnodev[0]);
+
+    klen = snprintf(kbuf, sizeof(kbuf), "%s%06u", pfx, 0);
+    rnode = route_map_lookup(map, kbuf, klen);
+    ASSERT_EQ(rnodev[1], rnode);
+
+    for (uint i = 1; i < ekeyc; i++)
+        route_map_delete(map, rnodev[i]);
+
+    rnode = route_map_lookup(map, kbuf, klen);
+    ASSERT_EQ(NULL, rnode);
+
+    route_map_destroy(map);
+}
+
 MTF_END_UTEST_COLLECTION(route_test);
@@ -10,6 +10,7 @@
 #include <hse_util/inttypes.h>
 #include <hse/logging/logging.h>
 #include <hse_util/page.h>
+#include <hse_util/workqueue.h>
 
 #include <hse_ikvdb/tuple.h>
 #include <hse_ikvdb/limits.h>
@@ -27,6 +28,7 @@
 struct kvs_rparams kvsrp;
 int                salt;
 void *             workbuf;
+struct workqueue_struct *wr_wq;
 
 #define WORKBUF_SIZE (2 * HSE_KVS_VALUE_LEN_MAX)
 
@@ -101,6 +103,9 @@ initial_setup(struct mtf_test_info *lcl_ti)
 
     key2kobj(&max_kobj, max_key, strlen(max_key));
 
+    wr_wq = alloc_workqueue("vbb_test_wr", 0, 1, 1);
+    ASSERT_TRUE_RET(wr_wq, -1);
+
     return 0;
 }
 
@@ -108,6 +113,7 @@ int
 final_teardown(struct mtf_test_info *lcl_ti)
 {
     mock_mpool_unset();
+    destroy_workqueue(wr_wq);
     free(workbuf);
     return 0;
 }
@@ -207,7 +213,7 @@ verify_vblock_footer(struct mtf_test_info *lcl_ti, uint64_t blkid, off_t off)
     ASSERT_EQ(klen, omf_vbf_min_klen(vbfomf));
     ASSERT_EQ(klen, omf_vbf_max_klen(vbfomf));
 
-    ASSERT_EQ(0, omf_vbf_rsvd(vbfomf));
+    ASSERT_EQ(0, omf_vbf_dict_len(vbfomf));
 
     ASSERT_EQ(0, memcmp(max_key, &vbf[VBLOCK_FOOTER_LEN - 2 * HSE_KVS_KEY_LEN_MAX], klen));
     ASSERT_EQ(0, memcmp(max_key, &vbf[VBLOCK_FOOTER_LEN - HSE_KVS_KEY_LEN_MAX], klen));
@@ -236,6 +242,65 @@ MTF_DEFINE_UTEST_PRE(test, t_vbb_finish_exact, test_setup)
     vbb_destroy(vbb);
 }
 
+/* Test: a dictionary is stored in the pages between the values and the footer */
+MTF_DEFINE_UTEST_PRE(test, t_vbb_set_dict, test_setup)
+{
+    struct vblock_footer_omf *vbfomf;
+    struct vblock_builder    *vbb;
+    struct blk_list           blks;
+    char                      dict[PAGE_SIZE + 100], buf[sizeof(dict)];
+    char                      vbf[VBLOCK_FOOTER_LEN];
+    merr_t                    err = 0;
+    int                       i;
+
+    for (i = 0; i < sizeof(dict); i++)
+        dict[i] = i;
+
+    err = vbb_create(VBB_CREATE_ARGS);
+    ASSERT_EQ(err, 0);
+
+    /* Space for the dictionary must be reserved first...
+     */
+    err = vbb_set_dict(vbb, dict, sizeof(dict));
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    err = vbb_set_dict(vbb, NULL, 0);
+    ASSERT_EQ(err, 0);
+
+    err = vbb_set_dict(vbb, dict, VBLOCK_DICT_LEN_MAX + 1);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    err = add_entry(lcl_ti, vbb, 123, 0);
+    ASSERT_EQ(err, 0);
+
+    /* ...and it may be set after values have been added, but only once.
+     */
+    err = vbb_set_dict(vbb, dict, sizeof(dict));
+    ASSERT_EQ(err, 0);
+
+    err = vbb_set_dict(vbb, dict, sizeof(dict));
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    err = vbb_finish(vbb, &blks, &max_kobj);
+    ASSERT_EQ(err, 0);
+    ASSERT_EQ(blks.n_blks, 1);
+
+    err = mpm_mblock_read(blks.blks->bk_blkid, buf, PAGE_SIZE, sizeof(buf));
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, memcmp(dict, buf, sizeof(dict)));
+
+    err = mpm_mblock_read(blks.blks->bk_blkid, vbf, PAGE_SIZE + PAGE_ALIGN(sizeof(dict)),
+                          VBLOCK_FOOTER_LEN);
+    ASSERT_EQ(0, err);
+
+    vbfomf = (void *)vbf;
+    ASSERT_EQ(VBLOCK_FOOTER_MAGIC, omf_vbf_magic(vbfomf));
+    ASSERT_EQ(sizeof(dict), omf_vbf_dict_len(vbfomf));
+
+    blk_list_free(&blks);
+    vbb_destroy(vbb);
+}
+
 /* Test: vbb_add_entry, mblock allocation failure */
 MTF_DEFINE_UTEST_PRE(test, t_vbb_add_entry_fail_mblock_alloc, test_setup)
 {
@@ -442,6 +507,34 @@ MTF_DEFINE_UTEST_PRE(test, t_vbb_finish_fail_mblock_write, test_setup)
     vbb_destroy(vbb);
 }
 
+/* Test: asynchronous write errors are reported by vbb_finish */
+MTF_DEFINE_UTEST_PRE(test, t_vbb_async_fail_mblock_write, test_setup)
+{
+    merr_t                 err = 0;
+    struct vblock_builder *vbb = 0;
+    struct blk_list        blks;
+
+    err = vbb_create(VBB_CREATE_ARGS);
+    ASSERT_EQ(err, 0);
+
+    vbb_set_wq(vbb, wr_wq);
+
+    mapi_inject(mapi_idx_mpool_mblock_write, 666);
+
+    /* Fill the write buffer exactly.  The resulting write is issued
+     * asynchronously, so the error is not seen until vbb_finish().
+     */
+    err = add_entry(lcl_ti, vbb, HSE_KVS_VALUE_LEN_MAX, 0);
+    ASSERT_EQ(err, 0);
+
+    err = vbb_finish(vbb, &blks, &max_kobj);
+    ASSERT_EQ(merr_errno(err), 666);
+
+    mapi_inject_unset(mapi_idx_mpool_mblock_write);
+
+    vbb_destroy(vbb);
+}
+
 static int
 check_err(struct mtf_test_info *lcl_ti, merr_t err, int expected_errno)
 {
@@ -524,6 +617,7 @@ fill_exact(struct mtf_test_info *lcl_ti, struct vblock_builder *vbb, uint space,
 
 enum test_case {
     tc_finish,
+    tc_finish_async,
     tc_destroy,
 };
 
@@ -561,6 +655,9 @@ run_test_case(struct mtf_test_info *lcl_ti, enum test_case tc, size_t n_vblocks)
     err = vbb_create(VBB_CREATE_ARGS);
     ASSERT_EQ_RET(err, 0, 1);
 
+    if (tc == tc_finish_async)
+        vbb_set_wq(vbb, wr_wq);
+
     log_info("Adding %zu values, expect %zu vblocks to be created", add_count, n_vblocks);
 
     if (add_entries(lcl_ti, vbb, add_count, vlen, 0))
@@ -569,6 +666,7 @@ run_test_case(struct mtf_test_info *lcl_ti, enum test_case tc, size_t n_vblocks)
     switch (tc) {
 
         case tc_finish:
+        case tc_finish_async:
 
             err = vbb_finish(vbb, &blks, &max_kobj);
             ASSERT_EQ_RET(0, err, 1);
@@ -618,6 +716,11 @@ MTF_DEFINE_UTEST_PRE(test, t_finish_with_3_vblock, test_setup)
     run_test_case(lcl_ti, tc_finish, 3);
 }
 
+MTF_DEFINE_UTEST_PRE(test, t_finish_async_with_3_vblock, test_setup)
+{
+    run_test_case(lcl_ti, tc_finish_async, 3);
+}
+
 MTF_DEFINE_UTEST_PRE(test, t_destroy_with_1_vblock, test_setup)
 {
     run_test_case(lcl_ti, tc_destroy, 1);
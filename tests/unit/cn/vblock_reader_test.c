@@ -91,6 +91,74 @@ MTF_DEFINE_UTEST_PRE(vblock_reader_test, t_vbr_desc_read, pre)
     mpool_mcache_munmap(map);
 }
 
+MTF_DEFINE_UTEST_PRE(vblock_reader_test, t_vbr_desc_read_dict, pre)
+{
+    merr_t                   err;
+    struct mpool *           ds = (void *)-1;
+    struct mpool_mcache_map *map;
+    struct vblock_desc       vblk_desc;
+    struct vblock_footer_omf vbftr;
+    u64                      blkid;
+    struct mblock_props      props;
+    uint                     vgroups = 0;
+    u64                      argv[1];
+    uint                     vbsz = 4 * PAGE_SIZE;
+    uint                     dict_len = PAGE_SIZE + 17;
+
+    err = mpm_mblock_alloc(vbsz, &blkid);
+    ASSERT_EQ(0, err);
+
+    /* One page of values, two pages of dictionary, and the footer.
+     */
+    memset(&vbftr, 0, sizeof(vbftr));
+    omf_set_vbf_magic(&vbftr, VBLOCK_FOOTER_MAGIC);
+    omf_set_vbf_version(&vbftr, VBLOCK_FOOTER_VERSION);
+    omf_set_vbf_vgroup(&vbftr, get_time_ns());
+    omf_set_vbf_dict_len(&vbftr, dict_len);
+    set_props(&props, blkid, vbsz);
+
+    err = mpm_mblock_write(blkid, (void *)&vbftr, 3 * PAGE_SIZE, sizeof(vbftr));
+    ASSERT_EQ(0, err);
+
+    err = mpool_mcache_mmap(ds, 1, &blkid, &map);
+    ASSERT_EQ(0, err);
+
+    err = vbr_desc_read(ds, map, 0, &vgroups, argv, &props, &vblk_desc);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(PAGE_SIZE, vblk_desc.vbd_len);
+    ASSERT_EQ(PAGE_SIZE, vblk_desc.vbd_dict_off);
+    ASSERT_EQ(dict_len, vblk_desc.vbd_dict_len);
+    ASSERT_EQ(vbsz - 2 * HSE_KVS_KEY_LEN_MAX, vblk_desc.vbd_min_koff);
+
+    /* Version 1 footers have no dictionary.
+     */
+    omf_set_vbf_version(&vbftr, VBLOCK_FOOTER_VERSION1);
+    omf_set_vbf_dict_len(&vbftr, 0);
+
+    err = mpm_mblock_write(blkid, (void *)&vbftr, 3 * PAGE_SIZE, sizeof(vbftr));
+    ASSERT_EQ(0, err);
+
+    err = vbr_desc_read(ds, map, 0, &vgroups, argv, &props, &vblk_desc);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(vbsz - VBLOCK_FOOTER_LEN, vblk_desc.vbd_len);
+    ASSERT_EQ(0, vblk_desc.vbd_dict_len);
+    ASSERT_EQ(NULL, vbr_dict(&vblk_desc));
+
+    /* A dictionary that doesn't fit in the vblock is detected.
+     */
+    omf_set_vbf_version(&vbftr, VBLOCK_FOOTER_VERSION);
+    omf_set_vbf_dict_len(&vbftr, vbsz);
+
+    err = mpm_mblock_write(blkid, (void *)&vbftr, 3 * PAGE_SIZE, sizeof(vbftr));
+    ASSERT_EQ(0, err);
+
+    err = vbr_desc_read(ds, map, 0, &vgroups, argv, &props, &vblk_desc);
+    ASSERT_EQ(EPROTO, merr_errno(err));
+
+    vbr_desc_fini(&vblk_desc);
+    mpool_mcache_munmap(map);
+}
+
 MTF_DEFINE_UTEST_PRE(vblock_reader_test, t_vbr_desc_update, pre)
 {
     merr_t                   err;
@@ -230,7 +298,7 @@ MTF_DEFINE_UTEST_PRE(vblock_reader_test, t_detect_bad_version, pre)
     ASSERT_EQ(0, err);
 
     for (i = -1; i <= VBLOCK_FOOTER_VERSION + 1; i++) {
-        if (i != VBLOCK_FOOTER_VERSION) {
+        if (i != VBLOCK_FOOTER_VERSION && i != VBLOCK_FOOTER_VERSION1) {
             omf_set_vbf_magic(&vbftr, VBLOCK_FOOTER_MAGIC);
             /* vbf_version is wrong, and should be detected in vbr_desc_read */
             omf_set_vbf_version(&vbftr, i);
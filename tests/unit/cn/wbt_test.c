@@ -177,6 +177,20 @@ tree_construct(struct mtf_test_info *lcl_ti, void **tree_out, struct wbt_hdr_omf
     return 0;
 }
 
+int
+tree_desc(struct mtf_test_info *lcl_ti, struct wbt_hdr_omf *hdr, struct wbt_desc *wbd)
+{
+    merr_t err;
+
+    err = wbtr_read_desc(hdr, wbd);
+    ASSERT_EQ_RET(0, err, 1);
+
+    wbd->wbd_first_page = 0;
+    wbd->wbd_n_pages = wbt_pgc;
+
+    return 0;
+}
+
 int
 cursor_verify(
     struct mtf_test_info *lcl_ti,
@@ -189,15 +203,7 @@ cursor_verify(
         .map_base = tree,
     };
 
-    struct wbt_desc wbd = {
-        .wbd_first_page = 0,
-        .wbd_n_pages = wbt_pgc,
-        .wbd_version = WBT_TREE_VERSION, /* The current version */
-        .wbd_root = omf_wbt_root(hdr),
-        .wbd_leaf = omf_wbt_leaf(hdr),
-        .wbd_leaf_cnt = omf_wbt_leaf_cnt(hdr),
-        .wbd_kmd_pgc = omf_wbt_kmd_pgc(hdr),
-    };
+    struct wbt_desc wbd;
 
     struct wbti *     wbti;
     struct kvs_ktuple kt;
@@ -207,6 +213,9 @@ cursor_verify(
     int               i;
     struct key_iter * k = kl->buf;
 
+    if (tree_desc(lcl_ti, hdr, &wbd))
+        return 1;
+
     k = kl->buf;
     for (i = 0; i < kl->nkeys; i++) {
         merr_t err;
@@ -265,15 +274,7 @@ get_verify(struct mtf_test_info *lcl_ti, void *tree, struct wbt_hdr_omf *hdr, st
         .map_base = tree,
     };
 
-    struct wbt_desc wbd = {
-        .wbd_first_page = 0,
-        .wbd_n_pages = wbt_pgc,
-        .wbd_version = WBT_TREE_VERSION, /* The current version */
-        .wbd_root = omf_wbt_root(hdr),
-        .wbd_leaf = omf_wbt_leaf(hdr),
-        .wbd_leaf_cnt = omf_wbt_leaf_cnt(hdr),
-        .wbd_kmd_pgc = omf_wbt_kmd_pgc(hdr),
-    };
+    struct wbt_desc wbd;
 
     struct kvs_ktuple kt;
     struct key_obj    ko_ref;
@@ -283,6 +284,9 @@ get_verify(struct mtf_test_info *lcl_ti, void *tree, struct wbt_hdr_omf *hdr, st
     struct kvs_vtuple_ref vref;
     struct key_iter *     k = kl->buf;
 
+    if (tree_desc(lcl_ti, hdr, &wbd))
+        return 1;
+
     k = kl->buf;
     for (i = 0; i < kl->nkeys; i++) {
         merr_t err;
@@ -572,4 +576,121 @@ MTF_DEFINE_UTEST_PREPOST(wbt_test, skip_keys, pre_test, post_test)
     free(ql.buf);
 }
 
+MTF_DEFINE_UTEST_PREPOST(wbt_test, compressed, pre_test, post_test)
+{
+    struct wbt_hdr_omf hdr;
+    struct wbt_desc    wbd;
+    char               buf[HSE_KVS_KEY_LEN_MAX];
+    uint               leaf_cnt;
+    void *             tree;
+    int                i, rc;
+
+    /* Long keys with long common prefixes exercise the escaped (> 254 bytes)
+     * shared prefix encoding.
+     */
+    memset(buf, 0xfe, sizeof(buf));
+
+    for (i = 0; i < 2000; i++) {
+        size_t klen = (i % 3 == 0) ? sizeof(buf) : 64;
+        bool   added;
+
+        snprintf(buf, sizeof(buf), "key-%020d", i);
+        added = add_key(&key_list, buf, klen);
+        ASSERT_TRUE(added);
+        added = ref_tree_insert(rtree, buf, klen, 0);
+        ASSERT_TRUE(added);
+    }
+
+    wbb_set_compress(wbb, true);
+
+    rc = tree_construct(lcl_ti, &tree, &hdr);
+    ASSERT_EQ(0, rc);
+
+    leaf_cnt = omf_wbt_leaf_cnt(&hdr);
+    ASSERT_EQ(WBT_TREE_VERSION, omf_wbt_version(&hdr));
+    ASSERT_GT(omf_wbt_leaf_pgc(&hdr), 0);
+    ASSERT_LT(omf_wbt_leaf_pgc(&hdr), leaf_cnt);
+    ASSERT_EQ(wbt_pgc, omf_wbt_root(&hdr) + 1 - (leaf_cnt - omf_wbt_leaf_pgc(&hdr)) +
+              omf_wbt_kmd_pgc(&hdr));
+
+    rc = tree_desc(lcl_ti, &hdr, &wbd);
+    ASSERT_EQ(0, rc);
+    ASSERT_NE(0, wbd.wbd_gen);
+
+    /* Every leaf must decode to a valid leaf node.
+     */
+    for (i = 0; i < leaf_cnt; i++) {
+        char   node[WBT_NODE_SIZE];
+        size_t off;
+        uint   len;
+        merr_t err;
+
+        err = wbt_leaf_span(tree, &wbd, i, &off, &len);
+        ASSERT_EQ(0, err);
+
+        err = wbt_leaf_decode(tree + off, len, node);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(WBT_LFE_NODE_MAGIC, omf_wbn_magic((struct wbt_node_hdr_omf *)node));
+
+        /* A truncated leaf must be rejected.
+         */
+        err = wbt_leaf_decode(tree + off, len - 1, node);
+        ASSERT_NE(0, err);
+    }
+
+    rc = cursor_verify(lcl_ti, tree, &hdr, &key_list, false);
+    ASSERT_EQ(0, rc);
+    rc = cursor_verify(lcl_ti, tree, &hdr, &key_list, true);
+    ASSERT_EQ(0, rc);
+
+    /* Run point gets twice so that the second pass is served from
+     * the per-thread decoded leaf cache.
+     */
+    rc = get_verify(lcl_ti, tree, &hdr, &key_list);
+    ASSERT_EQ(0, rc);
+    rc = get_verify(lcl_ti, tree, &hdr, &key_list);
+    ASSERT_EQ(0, rc);
+
+    free(tree);
+}
+
+MTF_DEFINE_UTEST_PREPOST(wbt_test, compressed_skip_keys, pre_test, post_test)
+{
+    int             i, rc;
+    char            buf[HSE_KVS_KEY_LEN_MAX];
+    size_t          nkeys = 10 * 1000;
+    size_t          klen = 64;
+    struct key_list ql = { 0 }; /* query list */
+
+    memset(buf, 0xfe, sizeof(buf));
+    ql.bufsz = BUF_SIZE;
+    ql.buf = aligned_alloc(8, ql.bufsz);
+    ASSERT_NE(NULL, ql.buf);
+
+    for (i = 0; i < 2 * nkeys; i++) {
+        bool added;
+
+        snprintf(buf, sizeof(buf), "key-%032d", i);
+
+        /* Add only even numbered keys to the wbtree */
+        if (i % 2 == 0) {
+            added = add_key(&key_list, buf, klen);
+            ASSERT_TRUE(added);
+            added = ref_tree_insert(rtree, buf, klen, 0);
+            ASSERT_TRUE(added);
+        }
+
+        /* Add all keys to query list */
+        added = add_key(&ql, buf, klen);
+        ASSERT_TRUE(added);
+    }
+
+    wbb_set_compress(wbb, true);
+
+    rc = load_and_test(lcl_ti, &ql);
+    ASSERT_EQ(0, rc);
+
+    free(ql.buf);
+}
+
 MTF_END_UTEST_COLLECTION(wbt_test)
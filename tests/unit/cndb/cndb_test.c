@@ -920,4 +920,105 @@ MTF_DEFINE_UTEST_PREPOST(cndb_test, only_deletes_rollforward, test_pre, test_pos
     ASSERT_EQ(1, g_cb_ctr); /* Only kvsetid1 */
 }
 
+uint64_t g_sum_kvsetid;
+
+static merr_t
+replay_summary_cb(void *ctx, struct kvset_meta *km, uint64_t kvsetid)
+{
+    const struct kvset_summary *sum = km->km_summary;
+
+    ++g_cb_ctr;
+
+    if (kvsetid != g_sum_kvsetid)
+        return sum ? merr(EBUG) : 0;
+
+    if (!sum || sum->ksum_seqno_min != 3 || sum->ksum_seqno_max != 7 ||
+        sum->ksum_st.kst_keys != 100 || sum->ksum_st.kst_kblks != 2 ||
+        sum->ksum_vgroups != 1 || sum->ksum_minklen != 2 || sum->ksum_maxklen != 3 ||
+        memcmp(sum->ksum_keyv, "aazzz", 5))
+        return merr(EBUG);
+
+    return 0;
+}
+
+MTF_DEFINE_UTEST_PREPOST(cndb_test, kvset_summary, test_pre, test_post)
+{
+    struct mpool *mp = (void *)-1;
+    struct kvset_summary *sum;
+    struct cndb_txn *tx;
+    uint64_t kvsetid[3];
+    void *cookie[3];
+    merr_t err;
+
+    struct t_kvset k[] = {
+        {.nid = 0, .kb = BLKS(1, 2), .vb = BLKS(10)},
+        {.nid = 0, .kb = BLKS(3), .vb = BLKS(20)},
+        {.nid = 0, .kb = BLKS(4), .vb = BLKS(30)},
+    };
+
+    sum = calloc(1, kvset_summary_size(2, 3));
+    ASSERT_NE(NULL, sum);
+
+    sum->ksum_seqno_min = 3;
+    sum->ksum_seqno_max = 7;
+    sum->ksum_st.kst_keys = 100;
+    sum->ksum_st.kst_kblks = 2;
+    sum->ksum_vgroups = 1;
+    sum->ksum_minklen = 2;
+    sum->ksum_maxklen = 3;
+    memcpy(sum->ksum_keyv, "aazzz", 5);
+
+    err = txstart(cndb, 3, 0, &tx);
+    ASSERT_EQ(0, err);
+
+    for (size_t i = 0; i < NELEM(k); i++) {
+        cookie[i] = kvset_add(cndb, tx, i + 1, k[i], &kvsetid[i]);
+        ASSERT_NE(0, cookie[i]);
+    }
+
+    for (size_t i = 0; i < NELEM(k); i++) {
+        err = cndb_record_kvset_add_ack(cndb, tx, cookie[i]);
+        ASSERT_EQ(0, err);
+    }
+
+    /* Summarize kvsets 0 and 2, then delete kvset 2.
+     */
+    err = cndb_record_kvset_summary(cndb, cnid, kvsetid[0], sum);
+    ASSERT_EQ(0, err);
+
+    err = cndb_record_kvset_summary(cndb, cnid, kvsetid[2], sum);
+    ASSERT_EQ(0, err);
+
+    err = txstart(cndb, 0, 1, &tx);
+    ASSERT_EQ(0, err);
+
+    cookie[2] = kvset_del(cndb, tx, kvsetid[2]);
+    ASSERT_NE(0, cookie[2]);
+
+    err = cndb_record_kvset_del_ack(cndb, tx, cookie[2]);
+    ASSERT_EQ(0, err);
+
+    free(sum);
+
+    /* Closing the cndb compacts it to save the summaries.
+     */
+    err = cndb_close(cndb);
+    ASSERT_EQ(0, err);
+
+    struct kvdb_rparams rp = kvdb_rparams_defaults();
+    err = cndb_open(mp, 0, 0, &rp, &cndb);
+    ASSERT_EQ(0, err);
+
+    uint64_t seqno_out, ingestid_out, txhorizon_out;
+
+    err = cndb_replay(cndb, &seqno_out, &ingestid_out, &txhorizon_out);
+    ASSERT_EQ(0, err);
+
+    g_cb_ctr = 0;
+    g_sum_kvsetid = kvsetid[0];
+    err = cndb_cn_instantiate(cndb, cnid, NULL, (void *)replay_summary_cb);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(2, g_cb_ctr);
+}
+
 MTF_END_UTEST_COLLECTION(cndb_test)
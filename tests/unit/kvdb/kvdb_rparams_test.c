@@ -133,6 +133,23 @@ MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, c0_debug, test_pre)
     ASSERT_EQ(UINT8_MAX, ps->ps_bounds.as_uscalar.ps_max);
 }
 
+MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, c0_concurrent, test_pre)
+{
+    const struct param_spec *ps = ps_get("c0_concurrent");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_BOOL, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvdb_rparams, c0_concurrent), ps->ps_offset);
+    ASSERT_EQ(sizeof(bool), ps->ps_size);
+    ASSERT_EQ((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_EQ((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_EQ((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(false, params.c0_concurrent);
+}
+
 MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, c0_ingest_width, test_pre)
 {
     const struct param_spec *ps = ps_get("c0_ingest_width");
@@ -342,6 +359,25 @@ MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, csched_lscat_runlen_max, test_pre)
     ASSERT_EQ(8, ps->ps_bounds.as_uscalar.ps_max);
 }
 
+MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, csched_subcomp_max, test_pre)
+{
+    const struct param_spec *ps = ps_get("csched_subcomp_max");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL | PARAM_FLAG_WRITABLE, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_U8, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvdb_rparams, csched_subcomp_max), ps->ps_offset);
+    ASSERT_EQ(sizeof(uint8_t), ps->ps_size);
+    ASSERT_EQ((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_EQ((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_EQ((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(4, params.csched_subcomp_max);
+    ASSERT_EQ(1, ps->ps_bounds.as_uscalar.ps_min);
+    ASSERT_EQ(8, ps->ps_bounds.as_uscalar.ps_max);
+}
+
 MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, csched_qthreads, test_pre)
 {
     const struct param_spec *ps = ps_get("csched_qthreads");
@@ -473,6 +509,61 @@ MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, durability_interval, test_pre)
     ASSERT_EQ(HSE_WAL_DUR_MS_MAX, ps->ps_bounds.as_uscalar.ps_max);
 }
 
+MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, durability_files_recycle_max, test_pre)
+{
+    const struct param_spec *ps = ps_get("durability.files.recycle_max");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_U32, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvdb_rparams, dur_file_recycle_max), ps->ps_offset);
+    ASSERT_EQ(sizeof(uint32_t), ps->ps_size);
+    ASSERT_EQ((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_EQ((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_EQ((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(0, params.dur_file_recycle_max);
+    ASSERT_EQ(0, ps->ps_bounds.as_uscalar.ps_min);
+    ASSERT_EQ(HSE_WAL_FILE_RECYCLE_MAX, ps->ps_bounds.as_uscalar.ps_max);
+}
+
+MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, durability_group_commit_enabled, test_pre)
+{
+    const struct param_spec *ps = ps_get("durability.group_commit.enabled");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_BOOL, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvdb_rparams, dur_gc_enable), ps->ps_offset);
+    ASSERT_EQ(sizeof(bool), ps->ps_size);
+    ASSERT_EQ((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_EQ((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_EQ((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(false, params.dur_gc_enable);
+}
+
+MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, durability_group_commit_delay_max, test_pre)
+{
+    const struct param_spec *ps = ps_get("durability.group_commit.delay_max_us");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_U32, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvdb_rparams, dur_gc_delay_max_us), ps->ps_offset);
+    ASSERT_EQ(sizeof(uint32_t), ps->ps_size);
+    ASSERT_EQ((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_EQ((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_EQ((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(HSE_WAL_GC_DELAY_US_DFLT, params.dur_gc_delay_max_us);
+    ASSERT_EQ(HSE_WAL_GC_DELAY_US_MIN, ps->ps_bounds.as_uscalar.ps_min);
+    ASSERT_EQ(HSE_WAL_GC_DELAY_US_MAX, ps->ps_bounds.as_uscalar.ps_max);
+}
+
 MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, durability_replay_force, test_pre)
 {
     const struct param_spec *ps = ps_get("durability.replay.force");
@@ -796,6 +887,25 @@ MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, c0_ingest_threads, test_pre)
     ASSERT_EQ(HSE_C0_INGEST_THREADS_MAX, ps->ps_bounds.as_uscalar.ps_max);
 }
 
+MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, c0_build_threads, test_pre)
+{
+    const struct param_spec *ps = ps_get("c0_build_threads");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_U32, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvdb_rparams, c0_build_threads), ps->ps_offset);
+    ASSERT_EQ(sizeof(uint32_t), ps->ps_size);
+    ASSERT_EQ((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_EQ((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_EQ((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(HSE_C0_BUILD_THREADS_DFLT, params.c0_build_threads);
+    ASSERT_EQ(HSE_C0_BUILD_THREADS_MIN, ps->ps_bounds.as_uscalar.ps_min);
+    ASSERT_EQ(HSE_C0_BUILD_THREADS_MAX, ps->ps_bounds.as_uscalar.ps_max);
+}
+
 MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, cn_maint_threads, test_pre)
 {
     const struct param_spec *ps = ps_get("cn_maint_threads");
@@ -904,6 +1014,148 @@ MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, storage_pmem_directio_enabled, test_pre)
     ASSERT_EQ(true, params.dio_enable[HSE_MCLASS_PMEM]);
 }
 
+MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, storage_capacity_io_backend, test_pre)
+{
+    merr_t                   err;
+    char                     buf[128];
+    size_t                   needed_sz;
+    const struct param_spec *ps = ps_get("storage.capacity.io_backend");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_U8, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvdb_rparams, io_backend[HSE_MCLASS_CAPACITY]), ps->ps_offset);
+    ASSERT_EQ(sizeof(uint8_t), ps->ps_size);
+    ASSERT_NE((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_NE((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_NE((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(MPOOL_IO_SYNC, params.io_backend[HSE_MCLASS_CAPACITY]);
+    ASSERT_EQ(MPOOL_IO_SYNC, ps->ps_bounds.as_uscalar.ps_min);
+    ASSERT_EQ(MPOOL_IO_BACKEND_MAX, ps->ps_bounds.as_uscalar.ps_max);
+
+    ps->ps_stringify(ps, &params.io_backend[HSE_MCLASS_CAPACITY], buf, sizeof(buf), &needed_sz);
+    ASSERT_STREQ("\"sync\"", buf);
+    ASSERT_EQ(6, needed_sz);
+
+    /* clang-format off */
+    err = check(
+        "storage.capacity.io_backend=aio", false,
+        "storage.capacity.io_backend=sync", true,
+        "storage.capacity.io_backend=io_uring", true,
+        NULL
+    );
+    /* clang-format on */
+
+    ASSERT_EQ(0, merr_errno(err));
+}
+
+MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, storage_staging_io_backend, test_pre)
+{
+    merr_t                   err;
+    char                     buf[128];
+    size_t                   needed_sz;
+    const struct param_spec *ps = ps_get("storage.staging.io_backend");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_U8, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvdb_rparams, io_backend[HSE_MCLASS_STAGING]), ps->ps_offset);
+    ASSERT_EQ(sizeof(uint8_t), ps->ps_size);
+    ASSERT_NE((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_NE((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_NE((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(MPOOL_IO_SYNC, params.io_backend[HSE_MCLASS_STAGING]);
+    ASSERT_EQ(MPOOL_IO_SYNC, ps->ps_bounds.as_uscalar.ps_min);
+    ASSERT_EQ(MPOOL_IO_BACKEND_MAX, ps->ps_bounds.as_uscalar.ps_max);
+
+    ps->ps_stringify(ps, &params.io_backend[HSE_MCLASS_STAGING], buf, sizeof(buf), &needed_sz);
+    ASSERT_STREQ("\"sync\"", buf);
+    ASSERT_EQ(6, needed_sz);
+
+    /* clang-format off */
+    err = check(
+        "storage.staging.io_backend=aio", false,
+        "storage.staging.io_backend=sync", true,
+        "storage.staging.io_backend=io_uring", true,
+        NULL
+    );
+    /* clang-format on */
+
+    ASSERT_EQ(0, merr_errno(err));
+}
+
+MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, storage_pmem_io_backend, test_pre)
+{
+    merr_t                   err;
+    char                     buf[128];
+    size_t                   needed_sz;
+    const struct param_spec *ps = ps_get("storage.pmem.io_backend");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_U8, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvdb_rparams, io_backend[HSE_MCLASS_PMEM]), ps->ps_offset);
+    ASSERT_EQ(sizeof(uint8_t), ps->ps_size);
+    ASSERT_NE((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_NE((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_NE((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(MPOOL_IO_SYNC, params.io_backend[HSE_MCLASS_PMEM]);
+    ASSERT_EQ(MPOOL_IO_SYNC, ps->ps_bounds.as_uscalar.ps_min);
+    ASSERT_EQ(MPOOL_IO_BACKEND_MAX, ps->ps_bounds.as_uscalar.ps_max);
+
+    ps->ps_stringify(ps, &params.io_backend[HSE_MCLASS_PMEM], buf, sizeof(buf), &needed_sz);
+    ASSERT_STREQ("\"sync\"", buf);
+    ASSERT_EQ(6, needed_sz);
+
+    /* clang-format off */
+    err = check(
+        "storage.pmem.io_backend=aio", false,
+        "storage.pmem.io_backend=sync", true,
+        "storage.pmem.io_backend=io_uring", true,
+        NULL
+    );
+    /* clang-format on */
+
+    ASSERT_EQ(0, merr_errno(err));
+}
+
+MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, storage_bcache_size, test_pre)
+{
+    merr_t                   err;
+    const struct param_spec *ps = ps_get("storage.bcache.size");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_U32, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvdb_rparams, bcache_size_mb), ps->ps_offset);
+    ASSERT_EQ(sizeof(uint32_t), ps->ps_size);
+    ASSERT_EQ((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_EQ((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_EQ((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(0, params.bcache_size_mb);
+    ASSERT_EQ(0, ps->ps_bounds.as_uscalar.ps_min);
+    ASSERT_EQ(1024 * 1024, ps->ps_bounds.as_uscalar.ps_max);
+
+    /* clang-format off */
+    err = check(
+        "storage.bcache.size=0", true,
+        "storage.bcache.size=4096", true,
+        "storage.bcache.size=2097152", false,
+        NULL
+    );
+    /* clang-format on */
+
+    ASSERT_EQ(0, merr_errno(err));
+}
+
 MTF_DEFINE_UTEST_PRE(kvdb_rparams_test, mclass_policies, test_pre)
 {
     /* [HSE_REVISIT]: mclass_policies has its own test. It should maybe be moved
@@ -97,6 +97,25 @@ MTF_DEFINE_UTEST_PRE(kvs_cparams_test, suffix_length, test_pre)
     ASSERT_EQ(UINT32_MAX, ps->ps_bounds.as_uscalar.ps_max);
 }
 
+MTF_DEFINE_UTEST_PRE(kvs_cparams_test, value_inline_length, test_pre)
+{
+    const struct param_spec *ps = ps_get("value.inline_length");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(0, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_U32, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvs_cparams, vinline_len), ps->ps_offset);
+    ASSERT_EQ(sizeof(uint32_t), ps->ps_size);
+    ASSERT_EQ((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_EQ((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_EQ((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(CN_SMALL_VALUE_THRESHOLD, params.vinline_len);
+    ASSERT_EQ(0, ps->ps_bounds.as_uscalar.ps_min);
+    ASSERT_EQ(CN_INLINE_VALUE_LEN_MAX, ps->ps_bounds.as_uscalar.ps_max);
+}
+
 MTF_DEFINE_UTEST(kvs_cparams_test, get)
 {
     merr_t err;
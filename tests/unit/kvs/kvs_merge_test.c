@@ -0,0 +1,204 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <mtf/framework.h>
+
+#include <hse_ikvdb/kvs_merge.h>
+
+/* Counter operator: operands and values are little-endian u64 deltas/totals.
+ */
+static int
+add_merge(
+    void       *arg,
+    const void *key,
+    size_t      key_len,
+    const void *base,
+    size_t      base_len,
+    const void *opnd,
+    size_t      opnd_len,
+    void       *result,
+    size_t      result_sz,
+    size_t     *result_len)
+{
+    uint64_t a = 0, b;
+
+    if (base_len != 0 && base_len != sizeof(a))
+        return EINVAL;
+
+    if (base_len)
+        memcpy(&a, base, sizeof(a));
+    memcpy(&b, opnd, sizeof(b));
+
+    a += b;
+
+    *result_len = sizeof(a);
+    if (result_sz >= sizeof(a))
+        memcpy(result, &a, sizeof(a));
+
+    return 0;
+}
+
+/* Append operator: the result is base followed by operand.
+ */
+static int
+append_merge(
+    void       *arg,
+    const void *key,
+    size_t      key_len,
+    const void *base,
+    size_t      base_len,
+    const void *opnd,
+    size_t      opnd_len,
+    void       *result,
+    size_t      result_sz,
+    size_t     *result_len)
+{
+    *result_len = base_len + opnd_len;
+    if (*result_len > result_sz)
+        return 0;
+
+    if (base_len)
+        memcpy(result, base, base_len);
+    memcpy((char *)result + base_len, opnd, opnd_len);
+
+    return 0;
+}
+
+static const struct kvs_merge_op add_op = { .mo_fn = add_merge };
+static const struct kvs_merge_op append_op = { .mo_fn = append_merge };
+
+MTF_BEGIN_UTEST_COLLECTION(kvs_merge_test)
+
+MTF_DEFINE_UTEST(kvs_merge_test, counter)
+{
+    struct kvs_merge km;
+    struct key_obj   kobj;
+    uint64_t         v, total;
+    merr_t           err;
+
+    err = kvs_merge_init(&km);
+    ASSERT_EQ(0, err);
+
+    key2kobj(&kobj, "counter", 7);
+
+    v = 3;
+    kvs_merge_start(&km, &add_op, &kobj, &v, sizeof(v), 30);
+    ASSERT_TRUE(km.km_active);
+    ASSERT_TRUE(km.km_opnd);
+    ASSERT_EQ(30, km.km_seq);
+    ASSERT_EQ(7, km.km_klen);
+    ASSERT_EQ(0, memcmp(km.km_key, "counter", 7));
+
+    v = 4;
+    err = kvs_merge_fold(&km, &v, sizeof(v), HSE_KVS_MERGE_OPERAND_LEN_MAX);
+    ASSERT_EQ(0, err);
+    ASSERT_TRUE(km.km_opnd);
+    ASSERT_EQ(30, km.km_seq);
+
+    v = 100;
+    err = kvs_merge_resolve(&km, &v, sizeof(v), HSE_KVS_VALUE_LEN_MAX);
+    ASSERT_EQ(0, err);
+    ASSERT_FALSE(km.km_opnd);
+    ASSERT_EQ(sizeof(total), km.km_len);
+
+    memcpy(&total, km.km_buf, sizeof(total));
+    ASSERT_EQ(107, total);
+
+    kvs_merge_fini(&km);
+    ASSERT_EQ(NULL, km.km_buf);
+}
+
+MTF_DEFINE_UTEST(kvs_merge_test, no_base)
+{
+    struct kvs_merge km;
+    struct key_obj   kobj;
+    uint64_t         v, total;
+    merr_t           err;
+
+    err = kvs_merge_init(&km);
+    ASSERT_EQ(0, err);
+
+    key2kobj(&kobj, "k", 1);
+
+    v = 5;
+    kvs_merge_start(&km, &add_op, &kobj, &v, sizeof(v), 1);
+
+    err = kvs_merge_resolve(&km, NULL, 0, HSE_KVS_VALUE_LEN_MAX);
+    ASSERT_EQ(0, err);
+    ASSERT_FALSE(km.km_opnd);
+
+    memcpy(&total, km.km_buf, sizeof(total));
+    ASSERT_EQ(5, total);
+
+    kvs_merge_fini(&km);
+}
+
+MTF_DEFINE_UTEST(kvs_merge_test, too_large)
+{
+    struct kvs_merge km;
+    struct key_obj   kobj;
+    char             buf[HSE_KVS_MERGE_OPERAND_LEN_MAX];
+    merr_t           err;
+
+    err = kvs_merge_init(&km);
+    ASSERT_EQ(0, err);
+
+    key2kobj(&kobj, "log", 3);
+    memset(buf, 'a', sizeof(buf));
+
+    kvs_merge_start(&km, &append_op, &kobj, buf, 600, 9);
+
+    /* The combined operand would exceed the operand limit, the accumulator
+     * must be left unchanged so that the caller can emit it as-is.
+     */
+    err = kvs_merge_fold(&km, buf, 600, HSE_KVS_MERGE_OPERAND_LEN_MAX);
+    ASSERT_EQ(EMSGSIZE, merr_errno(err));
+    ASSERT_TRUE(km.km_opnd);
+    ASSERT_EQ(600, km.km_len);
+
+    /* ...but values may be as large as any other value.
+     */
+    err = kvs_merge_resolve(&km, buf, sizeof(buf), HSE_KVS_VALUE_LEN_MAX);
+    ASSERT_EQ(0, err);
+    ASSERT_FALSE(km.km_opnd);
+    ASSERT_EQ(sizeof(buf) + 600, km.km_len);
+
+    kvs_merge_fini(&km);
+}
+
+MTF_DEFINE_UTEST(kvs_merge_test, errors)
+{
+    struct kvs_merge km;
+    struct key_obj   kobj;
+    uint64_t         v = 1;
+    char             c = 'x';
+    merr_t           err;
+
+    err = kvs_merge_init(&km);
+    ASSERT_EQ(0, err);
+
+    key2kobj(&kobj, "k", 1);
+
+    /* No operator registered.
+     */
+    kvs_merge_start(&km, NULL, &kobj, &v, sizeof(v), 1);
+    err = kvs_merge_fold(&km, &v, sizeof(v), HSE_KVS_MERGE_OPERAND_LEN_MAX);
+    ASSERT_EQ(ENOTSUP, merr_errno(err));
+    err = kvs_merge_resolve(&km, NULL, 0, HSE_KVS_VALUE_LEN_MAX);
+    ASSERT_EQ(ENOTSUP, merr_errno(err));
+    ASSERT_TRUE(km.km_opnd);
+
+    /* Errors returned by the operator are propagated.
+     */
+    kvs_merge_start(&km, &add_op, &kobj, &v, sizeof(v), 1);
+    err = kvs_merge_resolve(&km, &c, sizeof(c), HSE_KVS_VALUE_LEN_MAX);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+    ASSERT_TRUE(km.km_opnd);
+    ASSERT_EQ(sizeof(v), km.km_len);
+
+    kvs_merge_fini(&km);
+}
+
+MTF_END_UTEST_COLLECTION(kvs_merge_test)
@@ -496,6 +496,42 @@ MTF_DEFINE_UTEST_PRE(kvs_rparams_test, cn_bloom_capped, test_pre)
     ASSERT_EQ(UINT64_MAX, ps->ps_bounds.as_uscalar.ps_max);
 }
 
+MTF_DEFINE_UTEST_PRE(kvs_rparams_test, cn_node_bloom_prob, test_pre)
+{
+    const struct param_spec *ps = ps_get("cn_node_bloom_prob");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_U64, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvs_rparams, cn_node_bloom_prob), ps->ps_offset);
+    ASSERT_EQ(sizeof(uint64_t), ps->ps_size);
+    ASSERT_EQ((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_EQ((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_EQ((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_EQ(0, params.cn_node_bloom_prob);
+    ASSERT_EQ(0, ps->ps_bounds.as_uscalar.ps_min);
+    ASSERT_EQ(UINT64_MAX, ps->ps_bounds.as_uscalar.ps_max);
+}
+
+MTF_DEFINE_UTEST_PRE(kvs_rparams_test, cn_kblock_compress, test_pre)
+{
+    const struct param_spec *ps = ps_get("cn_kblock_compress");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_BOOL, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvs_rparams, cn_kblock_compress), ps->ps_offset);
+    ASSERT_EQ(sizeof(bool), ps->ps_size);
+    ASSERT_EQ((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_EQ((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_EQ((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_FALSE(params.cn_kblock_compress);
+}
+
 MTF_DEFINE_UTEST_PRE(kvs_rparams_test, cn_compaction_debug, test_pre)
 {
     const struct param_spec *ps = ps_get("cn_compaction_debug");
@@ -570,6 +606,23 @@ MTF_DEFINE_UTEST_PRE(kvs_rparams_test, cn_kcachesz, test_pre)
     ASSERT_EQ(UINT64_MAX, ps->ps_bounds.as_uscalar.ps_max);
 }
 
+MTF_DEFINE_UTEST_PRE(kvs_rparams_test, cn_kvset_lazy_open, test_pre)
+{
+    const struct param_spec *ps = ps_get("cn_kvset_lazy_open");
+
+    ASSERT_NE(NULL, ps);
+    ASSERT_NE(NULL, ps->ps_description);
+    ASSERT_EQ(PARAM_FLAG_EXPERIMENTAL, ps->ps_flags);
+    ASSERT_EQ(PARAM_TYPE_BOOL, ps->ps_type);
+    ASSERT_EQ(offsetof(struct kvs_rparams, cn_kvset_lazy_open), ps->ps_offset);
+    ASSERT_EQ(sizeof(bool), ps->ps_size);
+    ASSERT_EQ((uintptr_t)ps->ps_convert, (uintptr_t)param_default_converter);
+    ASSERT_EQ((uintptr_t)ps->ps_validate, (uintptr_t)param_default_validator);
+    ASSERT_EQ((uintptr_t)ps->ps_stringify, (uintptr_t)param_default_stringify);
+    ASSERT_EQ((uintptr_t)ps->ps_jsonify, (uintptr_t)param_default_jsonify);
+    ASSERT_FALSE(params.cn_kvset_lazy_open);
+}
+
 MTF_DEFINE_UTEST_PRE(kvs_rparams_test, capped_evict_ttl, test_pre)
 {
     const struct param_spec *ps = ps_get("capped_evict_ttl");
@@ -689,6 +742,13 @@ MTF_DEFINE_UTEST_PRE(kvs_rparams_test, compression_algorithm, test_pre)
     /* clang-format off */
     err = check(
         "compression.algorithm=lz4", true,
+#ifdef HAVE_ZSTD
+        "compression.algorithm=zstd", true,
+        "compression.algorithm=zstd-dict", true,
+#else
+        "compression.algorithm=zstd", false,
+        "compression.algorithm=zstd-dict", false,
+#endif
         "compression.algorithm=does-not-exist", false,
         NULL
     );
@@ -0,0 +1,223 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <mtf/framework.h>
+
+#include <hse_util/keycmp.h>
+
+#include <hse_ikvdb/kvs_rtomb.h>
+
+static void
+rtomb_init(struct kvs_rtomb *rt, const char *start, const char *end, u64 seq)
+{
+    rt->kr_start = start;
+    rt->kr_start_len = strlen(start);
+    rt->kr_end = end;
+    rt->kr_end_len = strlen(end);
+    rt->kr_seq = seq;
+}
+
+static u64
+rtomb_seq(const struct kvs_rtomb *rtv, uint rtc, const char *key, u64 view)
+{
+    struct key_obj kobj;
+
+    key2kobj(&kobj, key, strlen(key));
+
+    return kvs_rtomb_seq(rtv, rtc, &kobj, view);
+}
+
+MTF_BEGIN_UTEST_COLLECTION(kvs_rtomb_test)
+
+MTF_DEFINE_UTEST(kvs_rtomb_test, covers)
+{
+    struct kvs_rtomb rt;
+    struct key_obj   kobj;
+
+    rtomb_init(&rt, "ts.0100", "ts.0200", 10);
+
+    key2kobj(&kobj, "ts.0100", 7);
+    ASSERT_TRUE(kvs_rtomb_covers(&rt, &kobj));
+
+    key2kobj(&kobj, "ts.01999", 8);
+    ASSERT_TRUE(kvs_rtomb_covers(&rt, &kobj));
+
+    /* The end key is excluded. */
+    key2kobj(&kobj, "ts.0200", 7);
+    ASSERT_FALSE(kvs_rtomb_covers(&rt, &kobj));
+
+    key2kobj(&kobj, "ts.01", 5);
+    ASSERT_FALSE(kvs_rtomb_covers(&rt, &kobj));
+
+    /* A split key object compares as its concatenation. */
+    kobj.ko_pfx = "ts.";
+    kobj.ko_pfx_len = 3;
+    kobj.ko_sfx = "0150";
+    kobj.ko_sfx_len = 4;
+    ASSERT_TRUE(kvs_rtomb_covers(&rt, &kobj));
+}
+
+MTF_DEFINE_UTEST(kvs_rtomb_test, seq)
+{
+    struct kvs_rtomb_vec vec = { 0 };
+    struct kvs_rtomb     rt;
+    merr_t               err;
+
+    rtomb_init(&rt, "a", "m", 10);
+    err = kvs_rtomb_vec_add(&vec, &rt);
+    ASSERT_EQ(0, err);
+    rtomb_init(&rt, "f", "z", 20);
+    err = kvs_rtomb_vec_add(&vec, &rt);
+    ASSERT_EQ(0, err);
+    rtomb_init(&rt, "g", "h", 30);
+    err = kvs_rtomb_vec_add(&vec, &rt);
+    ASSERT_EQ(0, err);
+
+    err = kvs_rtomb_vec_sort(&vec);
+    ASSERT_EQ(0, err);
+
+    ASSERT_EQ(10, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "b", UINT64_MAX));
+    ASSERT_EQ(20, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "f", UINT64_MAX));
+    ASSERT_EQ(30, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "g", UINT64_MAX));
+    ASSERT_EQ(20, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "h", UINT64_MAX));
+    ASSERT_EQ(20, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "m", UINT64_MAX));
+    ASSERT_EQ(0, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "z", UINT64_MAX));
+    ASSERT_EQ(0, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "0", UINT64_MAX));
+
+    /* Tombstones newer than the view are ignored. */
+    ASSERT_EQ(20, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "g", 29));
+    ASSERT_EQ(10, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "g", 19));
+    ASSERT_EQ(0, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "g", 9));
+    ASSERT_EQ(10, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "b", 19));
+    ASSERT_EQ(0, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "n", 19));
+
+    kvs_rtomb_vec_fini(&vec);
+}
+
+MTF_DEFINE_UTEST(kvs_rtomb_test, sort_merge)
+{
+    struct kvs_rtomb_vec vec = { 0 };
+    struct kvs_rtomb     rt;
+    merr_t               err;
+
+    /* Duplicates and adjacent ranges with the same seqno collapse into one
+     * fragment, an empty range vanishes.
+     */
+    rtomb_init(&rt, "c", "e", 5);
+    err = kvs_rtomb_vec_add(&vec, &rt);
+    ASSERT_EQ(0, err);
+    rtomb_init(&rt, "a", "c", 5);
+    err = kvs_rtomb_vec_add(&vec, &rt);
+    ASSERT_EQ(0, err);
+    rtomb_init(&rt, "a", "e", 5);
+    err = kvs_rtomb_vec_add(&vec, &rt);
+    ASSERT_EQ(0, err);
+    rtomb_init(&rt, "x", "x", 9);
+    err = kvs_rtomb_vec_add(&vec, &rt);
+    ASSERT_EQ(0, err);
+
+    err = kvs_rtomb_vec_sort(&vec);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(1, vec.krv_cnt);
+    ASSERT_EQ(5, vec.krv_rtv[0].kr_seq);
+    ASSERT_EQ(0, keycmp(vec.krv_rtv[0].kr_start, vec.krv_rtv[0].kr_start_len, "a", 1));
+    ASSERT_EQ(0, keycmp(vec.krv_rtv[0].kr_end, vec.krv_rtv[0].kr_end_len, "e", 1));
+
+    /* A gap between ranges is kept */
+    rtomb_init(&rt, "f", "g", 5);
+    err = kvs_rtomb_vec_add(&vec, &rt);
+    ASSERT_EQ(0, err);
+
+    err = kvs_rtomb_vec_sort(&vec);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(2, vec.krv_cnt);
+    ASSERT_EQ(0, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "e", UINT64_MAX));
+    ASSERT_EQ(5, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "f", UINT64_MAX));
+
+    kvs_rtomb_vec_fini(&vec);
+}
+
+/* Compare lookups in a sorted vector with a scan of the original tombstones
+ * at every view, for random overlapping tombstones.
+ */
+MTF_DEFINE_UTEST(kvs_rtomb_test, sort_random)
+{
+    static char          keyv[64][4];
+    struct kvs_rtomb     rtv[48];
+    struct kvs_rtomb_vec vec = { 0 };
+    merr_t               err;
+    uint                 i, k;
+
+    for (i = 0; i < NELEM(keyv); i++)
+        snprintf(keyv[i], sizeof(keyv[i]), "%02u", i);
+
+    srand(4);
+
+    for (i = 0; i < NELEM(rtv); i++) {
+        uint a = rand() % (NELEM(keyv) - 1);
+        uint b = a + 1 + rand() % 12;
+
+        b = min_t(uint, b, NELEM(keyv) - 1);
+        rtomb_init(&rtv[i], keyv[a], keyv[b], 1 + rand() % 16);
+
+        err = kvs_rtomb_vec_add(&vec, &rtv[i]);
+        ASSERT_EQ(0, err);
+    }
+
+    err = kvs_rtomb_vec_sort(&vec);
+    ASSERT_EQ(0, err);
+
+    for (k = 0; k < NELEM(keyv); k++) {
+        struct key_obj kobj;
+
+        key2kobj(&kobj, keyv[k], strlen(keyv[k]));
+
+        for (u64 view = 0; view <= 17; view++) {
+            u64 want = 0;
+
+            for (i = 0; i < NELEM(rtv); i++) {
+                if (rtv[i].kr_seq > want && rtv[i].kr_seq <= view &&
+                    kvs_rtomb_covers(&rtv[i], &kobj))
+                    want = rtv[i].kr_seq;
+            }
+
+            ASSERT_EQ(want, kvs_rtomb_seq(vec.krv_rtv, vec.krv_cnt, &kobj, view));
+        }
+    }
+
+    kvs_rtomb_vec_fini(&vec);
+}
+
+MTF_DEFINE_UTEST(kvs_rtomb_test, vec)
+{
+    struct kvs_rtomb_vec vec = { 0 };
+    struct kvs_rtomb     rt;
+    merr_t               err;
+
+    for (uint i = 0; i < 100; i++) {
+        rtomb_init(&rt, "a", "b", i + 1);
+
+        err = kvs_rtomb_vec_add(&vec, &rt);
+        ASSERT_EQ(0, err);
+    }
+
+    ASSERT_EQ(100, vec.krv_cnt);
+    ASSERT_GE(vec.krv_max, vec.krv_cnt);
+
+    err = kvs_rtomb_vec_sort(&vec);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(100, vec.krv_cnt);
+    ASSERT_EQ(100, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "a", UINT64_MAX));
+    ASSERT_EQ(42, rtomb_seq(vec.krv_rtv, vec.krv_cnt, "a", 42));
+
+    kvs_rtomb_vec_reset(&vec);
+    ASSERT_EQ(0, vec.krv_cnt);
+
+    kvs_rtomb_vec_fini(&vec);
+    ASSERT_EQ(NULL, vec.krv_rtv);
+    ASSERT_EQ(0, vec.krv_max);
+}
+
+MTF_END_UTEST_COLLECTION(kvs_rtomb_test)
@@ -0,0 +1,252 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include <mtf/framework.h>
+#include <support/random_buffer.h>
+
+#include <hse/error/merr.h>
+#include <hse_util/base.h>
+#include <hse_util/page.h>
+
+#include <mpool/mpool.h>
+#include <bcache.h>
+
+#include "common.h"
+
+MTF_BEGIN_UTEST_COLLECTION_PRE(bcache_test, mpool_collection_pre)
+
+#define MBLOCK_PAGES (128)
+
+static merr_t
+mblock_write_pages(struct mpool *mp, uint64_t mbid, char *buf, int pgc)
+{
+    struct iovec iov[MBLOCK_PAGES];
+    int          i;
+
+    for (i = 0; i < pgc; i++) {
+        iov[i].iov_base = buf + (size_t)i * PAGE_SIZE;
+        iov[i].iov_len = PAGE_SIZE;
+    }
+
+    return mpool_mblock_write(mp, mbid, iov, pgc);
+}
+
+static void
+setup_mblocks(
+    struct mtf_test_info *lcl_ti,
+    struct mpool         *mp,
+    uint64_t             *mbidv,
+    int                   mbidc,
+    char                **bufvp)
+{
+    size_t bufsz = (size_t)mbidc * MBLOCK_PAGES * PAGE_SIZE;
+    char  *bufv;
+    merr_t err;
+    int    rc, i;
+
+    rc = posix_memalign((void **)&bufv, PAGE_SIZE, bufsz);
+    ASSERT_EQ(0, rc);
+
+    randomize_buffer(bufv, bufsz, bufsz + 31);
+
+    for (i = 0; i < mbidc; i++) {
+        err = mpool_mblock_alloc(mp, HSE_MCLASS_CAPACITY, 0, &mbidv[i], NULL);
+        ASSERT_EQ(0, err);
+
+        err = mblock_write_pages(mp, mbidv[i], bufv + (size_t)i * MBLOCK_PAGES * PAGE_SIZE,
+                                 MBLOCK_PAGES);
+        ASSERT_EQ(0, err);
+
+        err = mpool_mblock_commit(mp, mbidv[i]);
+        ASSERT_EQ(0, err);
+    }
+
+    *bufvp = bufv;
+}
+
+MTF_DEFINE_UTEST(bcache_test, create_destroy)
+{
+    struct bcache *bc;
+    merr_t         err;
+
+    err = bcache_create(1 << 20, NULL);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    err = bcache_create(PAGE_SIZE, &bc);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+    ASSERT_EQ(NULL, bc);
+
+    err = bcache_create(1 << 20, &bc);
+    ASSERT_EQ(0, err);
+    ASSERT_NE(NULL, bc);
+
+    bcache_destroy(bc);
+    bcache_destroy(NULL);
+
+    err = bcache_create(64ul << 20, &bc);
+    ASSERT_EQ(0, err);
+
+    bcache_destroy(bc);
+}
+
+MTF_DEFINE_UTEST_PREPOST(bcache_test, cache_disabled, mpool_test_pre, mpool_test_post)
+{
+    struct mpool *mp;
+    uint64_t      mbid;
+    char         *bufv, *buf;
+    merr_t        err;
+    int           rc;
+
+    err = mpool_create(mtf_kvdb_home, &tcparams);
+    ASSERT_EQ(0, err);
+
+    trparams.bcache_size_mb = 0;
+
+    err = mpool_open(mtf_kvdb_home, &trparams, O_RDWR, &mp);
+    ASSERT_EQ(0, err);
+
+    ASSERT_FALSE(mpool_bcache_enabled(mp));
+
+    setup_mblocks(lcl_ti, mp, &mbid, 1, &bufv);
+
+    rc = posix_memalign((void **)&buf, PAGE_SIZE, 4 * PAGE_SIZE);
+    ASSERT_EQ(0, rc);
+
+    err = mpool_mblock_read_cached(mp, mbid, buf, 4 * PAGE_SIZE, 8 * PAGE_SIZE,
+                                   MPOOL_BCACHE_PRIO_INDEX);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, memcmp(buf, bufv + 8 * PAGE_SIZE, 4 * PAGE_SIZE));
+
+    free(buf);
+    free(bufv);
+
+    err = mpool_close(mp);
+    ASSERT_EQ(0, err);
+
+    err = mpool_destroy(mtf_kvdb_home, &tdparams);
+    ASSERT_EQ(0, err);
+}
+
+MTF_DEFINE_UTEST_PREPOST(bcache_test, cached_read, mpool_test_pre, mpool_test_post)
+{
+    struct mpool *mp;
+    uint64_t      mbid;
+    char         *bufv, *buf;
+    merr_t        err;
+    int           rc, i, j;
+
+    err = mpool_create(mtf_kvdb_home, &tcparams);
+    ASSERT_EQ(0, err);
+
+    trparams.bcache_size_mb = 8;
+
+    err = mpool_open(mtf_kvdb_home, &trparams, O_RDWR, &mp);
+    ASSERT_EQ(0, err);
+
+    ASSERT_TRUE(mpool_bcache_enabled(mp));
+
+    setup_mblocks(lcl_ti, mp, &mbid, 1, &bufv);
+
+    rc = posix_memalign((void **)&buf, PAGE_SIZE, MBLOCK_PAGES * PAGE_SIZE);
+    ASSERT_EQ(0, rc);
+
+    err = mpool_mblock_read_cached(mp, mbid, buf + 1, PAGE_SIZE, 0, MPOOL_BCACHE_PRIO_DATA);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    err = mpool_mblock_read_cached(mp, mbid, buf, PAGE_SIZE - 1, 0, MPOOL_BCACHE_PRIO_DATA);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    err = mpool_mblock_read_cached(mp, mbid, buf, PAGE_SIZE, 17, MPOOL_BCACHE_PRIO_DATA);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    /* Populate every other page, then read the whole mblock so that
+     * the read is a mix of cache hits and coalesced misses.
+     */
+    for (i = 0; i < MBLOCK_PAGES; i += 2) {
+        err = mpool_mblock_read_cached(mp, mbid, buf, PAGE_SIZE, i * PAGE_SIZE,
+                                       MPOOL_BCACHE_PRIO_INDEX);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(0, memcmp(buf, bufv + (size_t)i * PAGE_SIZE, PAGE_SIZE));
+    }
+
+    for (j = 0; j < 2; j++) {
+        memset(buf, 0, MBLOCK_PAGES * PAGE_SIZE);
+
+        err = mpool_mblock_read_cached(mp, mbid, buf, MBLOCK_PAGES * PAGE_SIZE, 0,
+                                       MPOOL_BCACHE_PRIO_DATA);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(0, memcmp(buf, bufv, MBLOCK_PAGES * PAGE_SIZE));
+    }
+
+    free(buf);
+    free(bufv);
+
+    err = mpool_close(mp);
+    ASSERT_EQ(0, err);
+
+    trparams.bcache_size_mb = 0;
+
+    err = mpool_destroy(mtf_kvdb_home, &tdparams);
+    ASSERT_EQ(0, err);
+}
+
+MTF_DEFINE_UTEST_PREPOST(bcache_test, cached_read_evict, mpool_test_pre, mpool_test_post)
+{
+    struct mpool *mp;
+    uint64_t      mbidv[8];
+    char         *bufv, *buf;
+    merr_t        err;
+    int           rc, i, j, pass;
+
+    err = mpool_create(mtf_kvdb_home, &tcparams);
+    ASSERT_EQ(0, err);
+
+    /* A 1 MiB cache is much smaller than the 8 mblocks read below,
+     * so pages are continually evicted and re-read.
+     */
+    trparams.bcache_size_mb = 1;
+
+    err = mpool_open(mtf_kvdb_home, &trparams, O_RDWR, &mp);
+    ASSERT_EQ(0, err);
+
+    setup_mblocks(lcl_ti, mp, mbidv, NELEM(mbidv), &bufv);
+
+    rc = posix_memalign((void **)&buf, PAGE_SIZE, 4 * PAGE_SIZE);
+    ASSERT_EQ(0, rc);
+
+    for (pass = 0; pass < 3; pass++) {
+        for (i = 0; i < NELEM(mbidv); i++) {
+            char *exp = bufv + (size_t)i * MBLOCK_PAGES * PAGE_SIZE;
+
+            for (j = 0; j < MBLOCK_PAGES; j += 4) {
+                enum mpool_bcache_prio prio;
+
+                prio = (j % 16) ? MPOOL_BCACHE_PRIO_DATA : MPOOL_BCACHE_PRIO_INDEX;
+
+                err = mpool_mblock_read_cached(mp, mbidv[i], buf, 4 * PAGE_SIZE,
+                                               j * PAGE_SIZE, prio);
+                ASSERT_EQ(0, err);
+                ASSERT_EQ(0, memcmp(buf, exp + (size_t)j * PAGE_SIZE, 4 * PAGE_SIZE));
+            }
+        }
+    }
+
+    free(buf);
+    free(bufv);
+
+    err = mpool_close(mp);
+    ASSERT_EQ(0, err);
+
+    trparams.bcache_size_mb = 0;
+
+    err = mpool_destroy(mtf_kvdb_home, &tdparams);
+    ASSERT_EQ(0, err);
+}
+
+MTF_END_UTEST_COLLECTION(bcache_test);
@@ -0,0 +1,208 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <mtf/framework.h>
+#include <support/random_buffer.h>
+
+#include <hse/error/merr.h>
+#include <hse_util/compiler.h>
+#include <hse_util/page.h>
+
+#include <mpool/mpool.h>
+#include <io.h>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "common.h"
+
+/* io_ring_rw() splits a request into chunks of 256 iovecs and queues up
+ * to 32 chunks per submission.
+ */
+#define CHUNK_IOVS   (256)
+#define QDEPTH       (32)
+
+static int
+iov_setup(struct iovec *iov, int iovc, char *buf, size_t len)
+{
+    for (int i = 0; i < iovc; i++) {
+        iov[i].iov_base = buf + i * len;
+        iov[i].iov_len = len;
+    }
+
+    return iovc;
+}
+
+MTF_BEGIN_UTEST_COLLECTION_PRE(io_uring_test, mpool_collection_pre)
+
+/* Read and write an mblock through the io_uring backend, with more iovecs
+ * than fit in one chunk.
+ */
+MTF_DEFINE_UTEST_PREPOST(io_uring_test, mblock_rw, mpool_test_pre, mpool_test_post)
+{
+    const int iovc = CHUNK_IOVS + 44;
+    const size_t len = iovc * PAGE_SIZE;
+    struct mpool_rparams rparams = trparams;
+    struct iovec *iov;
+    struct mpool *mp;
+    uint64_t mbid;
+    char *wbuf, *rbuf;
+    merr_t err;
+    int rc;
+
+    rparams.mclass[HSE_MCLASS_CAPACITY].io_backend = MPOOL_IO_URING;
+
+    rc = posix_memalign((void **)&wbuf, PAGE_SIZE, len);
+    ASSERT_EQ(0, rc);
+
+    rc = posix_memalign((void **)&rbuf, PAGE_SIZE, len);
+    ASSERT_EQ(0, rc);
+
+    iov = calloc(iovc, sizeof(*iov));
+    ASSERT_NE(NULL, iov);
+
+    randomize_buffer(wbuf, len, iovc);
+
+    err = mpool_create(mtf_kvdb_home, &tcparams);
+    ASSERT_EQ(0, err);
+
+    err = mpool_open(mtf_kvdb_home, &rparams, O_RDWR, &mp);
+    ASSERT_EQ(0, err);
+
+    err = mpool_mblock_alloc(mp, HSE_MCLASS_CAPACITY, 0, &mbid, NULL);
+    ASSERT_EQ(0, err);
+
+    err = mpool_mblock_write(mp, mbid, iov, iov_setup(iov, iovc, wbuf, PAGE_SIZE));
+    ASSERT_EQ(0, err);
+
+    err = mpool_mblock_commit(mp, mbid);
+    ASSERT_EQ(0, err);
+
+    memset(rbuf, 0, len);
+    err = mpool_mblock_read(mp, mbid, iov, iov_setup(iov, iovc, rbuf, PAGE_SIZE), 0);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, memcmp(wbuf, rbuf, len));
+
+    /* A read at an offset that ends at the end of the mblock */
+    memset(rbuf, 0, len);
+    err = mpool_mblock_read(mp, mbid, iov, iov_setup(iov, iovc - 7, rbuf, PAGE_SIZE),
+                            7 * PAGE_SIZE);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, memcmp(wbuf + 7 * PAGE_SIZE, rbuf, len - 7 * PAGE_SIZE));
+
+    err = mpool_mblock_delete(mp, mbid);
+    ASSERT_EQ(0, err);
+
+    err = mpool_close(mp);
+    ASSERT_EQ(0, err);
+
+    mpool_destroy(mtf_kvdb_home, &tdparams);
+
+    free(iov);
+    free(rbuf);
+    free(wbuf);
+}
+
+#ifdef HAVE_LIBURING
+
+/* Enough small iovecs to need more than one full submission queue */
+MTF_DEFINE_UTEST(io_uring_test, many_chunks)
+{
+    const int iovc = CHUNK_IOVS * (QDEPTH + 3) + 17;
+    const size_t iolen = 64, len = iovc * iolen;
+    struct iovec *iov;
+    char *wbuf, *rbuf, path[PATH_MAX];
+    size_t xlen;
+    merr_t err;
+    int fd;
+
+    wbuf = malloc(len);
+    ASSERT_NE(NULL, wbuf);
+
+    rbuf = malloc(len);
+    ASSERT_NE(NULL, rbuf);
+
+    iov = calloc(iovc, sizeof(*iov));
+    ASSERT_NE(NULL, iov);
+
+    randomize_buffer(wbuf, len, iovc);
+
+    snprintf(path, sizeof(path), "%s/io_uring_many_chunks", mtf_kvdb_home);
+    fd = open(path, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    ASSERT_GE(fd, 0);
+
+    err = io_uring_ops.write(fd, 0, iov, iov_setup(iov, iovc, wbuf, iolen), 0, &xlen);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(len, xlen);
+
+    memset(rbuf, 0, len);
+    err = io_uring_ops.read(fd, 0, iov, iov_setup(iov, iovc, rbuf, iolen), 0, &xlen);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(len, xlen);
+    ASSERT_EQ(0, memcmp(wbuf, rbuf, len));
+
+    close(fd);
+    unlink(path);
+
+    free(iov);
+    free(rbuf);
+    free(wbuf);
+}
+
+/* A read past EOF reports only the bytes up to EOF, without error, even
+ * when the short chunk is followed by chunks that read nothing.
+ */
+MTF_DEFINE_UTEST(io_uring_test, short_read)
+{
+    const int iovc = CHUNK_IOVS * 4;
+    const size_t iolen = 512, len = iovc * iolen;
+    const size_t flen = CHUNK_IOVS * iolen + 3 * iolen + 100;
+    struct iovec *iov;
+    char *wbuf, *rbuf, path[PATH_MAX];
+    size_t xlen;
+    merr_t err;
+    int fd;
+
+    wbuf = malloc(len);
+    ASSERT_NE(NULL, wbuf);
+
+    rbuf = malloc(len);
+    ASSERT_NE(NULL, rbuf);
+
+    iov = calloc(iovc, sizeof(*iov));
+    ASSERT_NE(NULL, iov);
+
+    randomize_buffer(wbuf, len, iovc);
+
+    snprintf(path, sizeof(path), "%s/io_uring_short_read", mtf_kvdb_home);
+    fd = open(path, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    ASSERT_GE(fd, 0);
+
+    ASSERT_EQ(flen, pwrite(fd, wbuf, flen, 0));
+
+    memset(rbuf, 0, len);
+    err = io_uring_ops.read(fd, 0, iov, iov_setup(iov, iovc, rbuf, iolen), 0, &xlen);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(flen, xlen);
+    ASSERT_EQ(0, memcmp(wbuf, rbuf, flen));
+
+    /* Starting at EOF reads nothing */
+    err = io_uring_ops.read(fd, flen, iov, iov_setup(iov, iovc, rbuf, iolen), 0, &xlen);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(0, xlen);
+
+    close(fd);
+    unlink(path);
+
+    free(iov);
+    free(rbuf);
+    free(wbuf);
+}
+
+#endif /* HAVE_LIBURING */
+
+MTF_END_UTEST_COLLECTION(io_uring_test)
@@ -138,6 +138,128 @@ MTF_DEFINE_UTEST(bloom_filter_basic, BasicInsert)
     }
 }
 
+MTF_DEFINE_UTEST(bloom_filter_basic, BlockedInsert)
+{
+    struct bf_bithash_desc desc;
+    struct bloom_filter    f;
+    u8 *                   bits;
+    u32                    n_elts;
+    u32                    i, n, prob;
+    u64                    hash;
+    char                   buf[100];
+
+    n_elts = 10000;
+
+    for (prob = 1000; prob < 90000; prob += 1773) {
+        u32    fpc = 0;
+        size_t sz;
+
+        desc = bf_compute_bithash_est(prob);
+
+        sz = ALIGN(bf_size_estimate(desc, n_elts), PAGE_SIZE);
+        bits = aligned_alloc(PAGE_SIZE, sz);
+        ASSERT_NE(NULL, bits);
+        memset(bits, 0, sz);
+
+        bf_filter_init_blocked(&f, desc, n_elts, bits, sz);
+        ASSERT_TRUE(f.bf_blocked);
+        ASSERT_EQ(sz / BF_BLK_BYTES, f.bf_modulus);
+        ASSERT_LE(f.bf_n_hashes, BF_BLK_HASHES_MAX);
+
+        for (i = 0; i < n_elts; ++i) {
+            n = sprintf(buf, "%x:%d", i, i);
+            hash = hse_hash64(buf, n);
+            bf_filter_insert_by_hash(&f, hash);
+        }
+
+        for (i = 0; i < n_elts; ++i) {
+            bool hit;
+
+            n = sprintf(buf, "%x:%d", i, i);
+            hash = hse_hash64(buf, n);
+
+            hit = bf_blk_lookup(hash, bits, f.bf_modulus, f.bf_n_hashes);
+            ASSERT_TRUE(hit);
+
+            hit = bf_blk_lookup(~hash, bits, f.bf_modulus, f.bf_n_hashes);
+            if (hit)
+                ++fpc;
+        }
+
+        /* Blocking costs a little accuracy relative to a classic bloom
+         * of the same size, but page rounding more than makes up for it.
+         */
+        ASSERT_LE(fpc, (2 * prob * n_elts) / 1000000);
+
+        free(bits);
+    }
+}
+
+MTF_DEFINE_UTEST(bloom_filter_basic, BlockedPattern)
+{
+    u32 patv[BF_BLK_LANES];
+    u8  blk[BF_BLK_BYTES] HSE_ALIGNED(BF_BLK_BYTES);
+    u64 hash = 0x0123456789abcdefull;
+    u32 n;
+    int i, bits;
+
+    for (n = 1; n <= BF_BLK_HASHES_MAX; ++n) {
+        bf_blk_pattern(hash, n, patv);
+
+        /* One bit in each of n lanes */
+        for (i = bits = 0; i < BF_BLK_LANES; ++i) {
+            ASSERT_LE(__builtin_popcount(patv[i]), 1);
+            bits += __builtin_popcount(patv[i]);
+        }
+        ASSERT_EQ(n, bits);
+
+        memset(blk, 0, sizeof(blk));
+        ASSERT_FALSE(bf_blk_test(blk, patv));
+        ASSERT_FALSE(bf_blk_lookup(hash, blk, 1, n));
+
+        memcpy(blk, patv, sizeof(blk));
+        ASSERT_TRUE(bf_blk_test(blk, patv));
+        ASSERT_TRUE(bf_blk_lookup(hash, blk, 1, n));
+
+        /* Clearing any one bit of the pattern must cause a miss. */
+        for (i = 0; i < BF_BLK_BITS; ++i) {
+            if (!(patv[i / 32] & (1u << (i % 32))))
+                continue;
+
+            blk[i / 8] &= ~(1u << (i % 8));
+            ASSERT_FALSE(bf_blk_test(blk, patv));
+            ASSERT_FALSE(bf_blk_lookup(hash, blk, 1, n));
+            blk[i / 8] |= (1u << (i % 8));
+        }
+
+        memset(blk, 0xff, sizeof(blk));
+        ASSERT_TRUE(bf_blk_lookup(hash, blk, 1, n));
+    }
+}
+
+MTF_DEFINE_UTEST(bloom_filter_basic, BlockedLookupMatchesPattern)
+{
+    u32 patv[BF_BLK_LANES];
+    u8  blk[BF_BLK_BYTES];
+    u64 hash;
+    int i, j;
+
+    /* bf_blk_lookup() may use a vectorized path, verify that it agrees
+     * with the scalar pattern for sparse random blocks.
+     */
+    for (i = 0; i < 100000; ++i) {
+        u32 n = 1 + (i % BF_BLK_HASHES_MAX);
+
+        hash = hse_hash64(&i, sizeof(i));
+
+        for (j = 0; j < BF_BLK_BYTES; ++j)
+            blk[j] = hse_hash64v(&i, sizeof(i), &j, sizeof(j)) | (i & 0x3 ? 0x55 : 0xee);
+
+        bf_blk_pattern(hash, n, patv);
+        ASSERT_EQ(bf_blk_test(blk, patv), bf_blk_lookup(hash, blk, 1, n));
+    }
+}
+
 MTF_DEFINE_UTEST(bloom_filter_basic, RepeatableBasic)
 {
     const char *buf1 = "The cow jumped over the moon";
@@ -8,6 +8,7 @@
 
 #include <hse_util/atomic.h>
 #include <hse_util/bonsai_tree.h>
+#include <hse_util/byteorder.h>
 #include <hse_util/compiler.h>
 #include <hse_util/cursor_heap.h>
 #include <hse_util/keycmp.h>
@@ -1845,6 +1846,210 @@ again:
         goto again;
 }
 
+struct skiplist_arg {
+    struct bonsai_root *tree;
+    pthread_barrier_t  *barrier;
+    uint                tid;
+    uint                nthreads;
+    uint                nkeys;
+};
+
+static void *
+skiplist_inserter(void *arg)
+{
+    struct skiplist_arg *sa = arg;
+    merr_t err = 0;
+
+    BONSAI_RCU_REGISTER();
+
+    pthread_barrier_wait(sa->barrier);
+
+    /* Each thread inserts its own stripe of keys plus all the keys in
+     * the first quarter of the range, so that inserts race both to
+     * link adjacent keys and to insert the same keys.
+     */
+    for (uint i = 0; i < sa->nkeys && !err; ++i) {
+        struct bonsai_skey skey;
+        struct bonsai_sval sval;
+        uint64_t key;
+
+        if (i % sa->nthreads != sa->tid && i >= sa->nkeys / 4)
+            continue;
+
+        key = cpu_to_be64(i);
+        bn_skey_init(&key, sizeof(key), 0, 0, &skey);
+        bn_sval_init(&key, sizeof(key), HSE_ORDNL_TO_SQNREF(sa->tid + 1), &sval);
+
+        rcu_read_lock();
+        err = bn_insert_or_replace(sa->tree, &skey, &sval);
+        rcu_read_unlock();
+    }
+
+    BONSAI_RCU_UNREGISTER();
+
+    return err ? arg : NULL;
+}
+
+MTF_DEFINE_UTEST_PREPOST(bonsai_tree_test, skiplist_concurrent, no_fail_pre, no_fail_post)
+{
+    struct skiplist_arg argv[8];
+    pthread_t tidv[NELEM(argv)];
+    pthread_barrier_t barrier;
+    struct bonsai_root *tree;
+    struct bonsai_kv *kv, *prev;
+    const uint nkeys = 64 * 1024;
+    uint i, n;
+    merr_t err;
+    int rc;
+
+    cheap = cheap_create(16, 256 * MB);
+    ASSERT_NE(NULL, cheap);
+
+    err = bn_skiplist_create(cheap, bonsai_client_insert_callback, NULL, &tree);
+    ASSERT_EQ(0, err);
+
+    rc = pthread_barrier_init(&barrier, NULL, NELEM(argv));
+    ASSERT_EQ(0, rc);
+
+    for (i = 0; i < NELEM(argv); ++i) {
+        argv[i].tree = tree;
+        argv[i].barrier = &barrier;
+        argv[i].tid = i;
+        argv[i].nthreads = NELEM(argv);
+        argv[i].nkeys = nkeys;
+
+        rc = pthread_create(tidv + i, NULL, skiplist_inserter, argv + i);
+        ASSERT_EQ(0, rc);
+    }
+
+    for (i = 0; i < NELEM(argv); ++i) {
+        void *res;
+
+        rc = pthread_join(tidv[i], &res);
+        ASSERT_EQ(0, rc);
+        ASSERT_EQ(NULL, res);
+    }
+
+    pthread_barrier_destroy(&barrier);
+
+    rcu_read_lock();
+
+    /* Every key must be present exactly once and in order, and each
+     * key in the first quarter must have a value from every thread.
+     */
+    n = 0;
+    for (kv = tree->br_kv.bkv_next; kv != &tree->br_kv; kv = kv->bkv_next) {
+        struct bonsai_skey skey;
+        struct bonsai_kv *found;
+        uint64_t key;
+
+        key = cpu_to_be64(n);
+        ASSERT_EQ(sizeof(key), key_imm_klen(&kv->bkv_key_imm));
+        ASSERT_EQ(0, memcmp(kv->bkv_key, &key, sizeof(key)));
+        ASSERT_EQ(n < nkeys / 4 ? NELEM(argv) : 1, kv->bkv_valcnt);
+        ASSERT_EQ(kv, bn_kv_prev(kv->bkv_next));
+
+        bn_skey_init(&key, sizeof(key), 0, 0, &skey);
+        ASSERT_TRUE(bn_find(tree, &skey, &found));
+        ASSERT_EQ(kv, found);
+        ++n;
+    }
+
+    rcu_read_unlock();
+
+    ASSERT_EQ(nkeys, n);
+
+    /* Nodes allocated by the losers of insert races must be reclaimed.
+     */
+    ASSERT_EQ(nkeys, tree->br_key_alloc);
+
+    /* Finalizing the tree must leave exact prev links.
+     */
+    bn_finalize(tree);
+
+    prev = &tree->br_kv;
+    for (kv = tree->br_kv.bkv_next; kv != &tree->br_kv; kv = kv->bkv_next) {
+        ASSERT_EQ(prev, kv->bkv_prev);
+        prev = kv;
+    }
+
+    ASSERT_EQ(prev, tree->br_kv.bkv_prev);
+
+    bn_destroy(tree);
+    cheap_destroy(cheap);
+    cheap = NULL;
+}
+
+MTF_DEFINE_UTEST_PREPOST(bonsai_tree_test, skiplist_pfx, no_fail_pre, no_fail_post)
+{
+    struct bonsai_root *tree;
+    struct bonsai_skey skey;
+    struct bonsai_sval sval;
+    const uint nkeys = 4096;
+    uint32_t key, pfx;
+    merr_t err;
+    uint i;
+
+    cheap = cheap_create(16, 64 * MB);
+    ASSERT_NE(NULL, cheap);
+
+    err = bn_create(cheap, bonsai_client_insert_callback, NULL, &broot);
+    ASSERT_EQ(0, err);
+
+    err = bn_skiplist_create(NULL, bonsai_client_insert_callback, NULL, &tree);
+    ASSERT_EQ(0, err);
+
+    for (i = 0; i < nkeys; ++i) {
+        key = cpu_to_be32(i * 977);
+        bn_skey_init(&key, sizeof(key), 0, 0, &skey);
+        bn_sval_init(&key, sizeof(key), HSE_ORDNL_TO_SQNREF(i), &sval);
+
+        rcu_read_lock();
+        err = bn_insert_or_replace(broot, &skey, &sval);
+        if (!err)
+            err = bn_insert_or_replace(tree, &skey, &sval);
+        rcu_read_unlock();
+
+        ASSERT_EQ(0, err);
+    }
+
+    /* Prefix lookups in a skiplist tree must find the same keys as in
+     * a balanced tree, for prefixes both shorter than and equal to the
+     * key length, before, between, and beyond all the keys.
+     */
+    rcu_read_lock();
+    for (i = 0; i < (nkeys * 977 >> 8) + 2; i += 3) {
+        uint klen;
+
+        for (klen = 2; klen <= sizeof(key); ++klen) {
+            struct bonsai_kv *expect, *kv;
+            bool found;
+
+            pfx = cpu_to_be32(i << 8);
+            bn_skey_init(&pfx, klen, 0, 0, &skey);
+
+            expect = kv = NULL;
+            found = bn_find_pfx_GT(broot, &skey, &expect);
+            ASSERT_EQ(found, bn_find_pfx_GT(tree, &skey, &kv));
+            if (found)
+                ASSERT_EQ(0, memcmp(expect->bkv_key, kv->bkv_key, sizeof(key)));
+
+            expect = kv = NULL;
+            found = bn_find_pfx_LT(broot, &skey, &expect);
+            ASSERT_EQ(found, bn_find_pfx_LT(tree, &skey, &kv));
+            if (found)
+                ASSERT_EQ(0, memcmp(expect->bkv_key, kv->bkv_key, sizeof(key)));
+        }
+    }
+    rcu_read_unlock();
+
+    bn_destroy(tree);
+    bn_destroy(broot);
+    broot = NULL;
+    cheap_destroy(cheap);
+    cheap = NULL;
+}
+
 #if 0
 /* TODO: Fix me...
  */
@@ -5,6 +5,8 @@
 
 #include <hse_util/platform.h>
 #include <hse_util/compression_lz4.h>
+#include <hse_util/compression_zstd.h>
+#include <hse_util/xrand.h>
 #include <hse/logging/logging.h>
 
 #include <mtf/framework.h>
@@ -163,5 +165,183 @@ MTF_DEFINE_UTEST(compression_test, mongo)
     free(cbuf);
 }
 
+/* Every lz4 compressed value must be distinguishable from a zstd
+ * compressed value by its first byte.
+ */
+MTF_DEFINE_UTEST(compression_test, lz4_untagged)
+{
+    char src[256], cbuf[512];
+    uint cbuflen;
+    merr_t err;
+    int i, j;
+
+    for (i = 1; i < sizeof(src); ++i) {
+        for (j = 0; j < i; ++j)
+            src[j] = (i & 1) ? j : 'a';
+
+        err = compress_lz4_ops.cop_compress(src, i, cbuf, sizeof(cbuf), &cbuflen);
+        ASSERT_EQ(0, err);
+        ASSERT_FALSE(compress_zstd_tagged(cbuf));
+    }
+}
+
+#ifdef HAVE_ZSTD
+
+MTF_DEFINE_UTEST(compression_test, zstd)
+{
+    size_t srcsz, cbufsz;
+    char *src, *cbuf, *dbuf;
+    uint cbuflen, dbuflen;
+    merr_t err;
+    int i;
+
+    srcsz = HSE_KVS_VALUE_LEN_MAX;
+    src = malloc(srcsz);
+    ASSERT_NE(NULL, src);
+
+    dbuf = malloc(srcsz);
+    ASSERT_NE(NULL, dbuf);
+
+    cbufsz = compress_zstd_ops.cop_estimate(NULL, srcsz);
+    ASSERT_GT(cbufsz, srcsz);
+
+    cbuf = malloc(cbufsz);
+    ASSERT_NE(NULL, cbuf);
+
+    for (i = 0; i < srcsz; ++i)
+        src[i] = i / 7;
+
+    err = compress_zstd_ops.cop_compress(src, srcsz, cbuf, cbufsz, &cbuflen);
+    ASSERT_EQ(0, err);
+    ASSERT_LT(cbuflen, srcsz);
+    ASSERT_TRUE(compress_zstd_tagged(cbuf));
+    ASSERT_FALSE(compress_zstd_dict_tagged(cbuf));
+
+    err = compress_zstd_ops.cop_decompress(cbuf, cbuflen, dbuf, srcsz, &dbuflen);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(srcsz, dbuflen);
+    ASSERT_EQ(0, memcmp(src, dbuf, dbuflen));
+
+    /* As with lz4, a short output buffer yields the leading part of
+     * the value.
+     */
+    for (i = 1; i < srcsz; i *= 3) {
+        memset(dbuf, 0xaa, i);
+
+        err = compress_zstd_ops.cop_decompress(cbuf, cbuflen, dbuf, i, &dbuflen);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(i, dbuflen);
+        ASSERT_EQ(0, memcmp(src, dbuf, i));
+    }
+
+    /* Corrupt and truncated input.
+     */
+    err = compress_zstd_ops.cop_decompress(cbuf, cbuflen / 2, dbuf, srcsz, &dbuflen);
+    ASSERT_NE(0, err);
+
+    cbuf[0] = 0x0f;
+    err = compress_zstd_ops.cop_decompress(cbuf, cbuflen, dbuf, srcsz, &dbuflen);
+    ASSERT_EQ(EPROTO, merr_errno(err));
+
+    free(cbuf);
+    free(dbuf);
+    free(src);
+}
+
+MTF_DEFINE_UTEST(compression_test, zstd_dict)
+{
+    const uint samplec = 2048, vlen = 200;
+    struct compress_dict *cdict, *ddict;
+    char *samples, dict[8192];
+    char cbuf[1024], dbuf[1024], pbuf[1024];
+    uint dictlen, cbuflen, pbuflen, dbuflen;
+    size_t *samplev;
+    struct xrand xr;
+    merr_t err;
+    int i, j;
+
+    samples = malloc(samplec * vlen);
+    ASSERT_NE(NULL, samples);
+
+    samplev = malloc(samplec * sizeof(*samplev));
+    ASSERT_NE(NULL, samplev);
+
+    /* Small json-like records which share most of their structure but
+     * little within each record.
+     */
+    xrand_init(&xr, 42);
+
+    for (i = 0; i < samplec; ++i) {
+        char *s = samples + i * vlen;
+
+        snprintf(s, vlen, "{\"user\":%lu,\"name\":\"user%lu\",\"email\":\"u%lu@example.com\","
+                 "\"created\":%lu,\"flags\":[%lu,%lu],\"status\":\"active\"}",
+                 xrand64(&xr) % 1000000, xrand64(&xr) % 100000, xrand64(&xr) % 100000,
+                 xrand64(&xr), xrand64(&xr) % 7, xrand64(&xr) % 9);
+        for (j = strlen(s); j < vlen; ++j)
+            s[j] = ' ';
+        samplev[i] = vlen;
+    }
+
+    err = compress_zstd_dict_train(samples, samplev, 1, dict, sizeof(dict), &dictlen);
+    ASSERT_EQ(ENODATA, merr_errno(err));
+
+    err = compress_zstd_dict_train(samples, samplev, samplec, dict, sizeof(dict), &dictlen);
+    ASSERT_EQ(0, err);
+    ASSERT_GT(dictlen, 0);
+    ASSERT_LE(dictlen, sizeof(dict));
+
+    err = compress_zstd_dict_create(dict, dictlen, true, &cdict);
+    ASSERT_EQ(0, err);
+
+    err = compress_zstd_dict_create(dict, dictlen, false, &ddict);
+    ASSERT_EQ(0, err);
+
+    /* A decompression dictionary can't be used to compress.
+     */
+    err = compress_zstd_dict_compress(ddict, samples, vlen, cbuf, sizeof(cbuf), &cbuflen);
+    ASSERT_EQ(EINVAL, merr_errno(err));
+
+    for (i = 0; i < samplec; i += 97) {
+        const char *src = samples + i * vlen;
+
+        err = compress_zstd_dict_compress(cdict, src, vlen, cbuf, sizeof(cbuf), &cbuflen);
+        ASSERT_EQ(0, err);
+        ASSERT_TRUE(compress_zstd_tagged(cbuf));
+        ASSERT_TRUE(compress_zstd_dict_tagged(cbuf));
+
+        /* The dictionary should do better than plain zstd on small values.
+         */
+        err = compress_zstd_ops.cop_compress(src, vlen, pbuf, sizeof(pbuf), &pbuflen);
+        ASSERT_EQ(0, err);
+        ASSERT_LT(cbuflen, pbuflen);
+
+        err = compress_zstd_dict_decompress(ddict, cbuf, cbuflen, dbuf, vlen, &dbuflen);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(vlen, dbuflen);
+        ASSERT_EQ(0, memcmp(src, dbuf, vlen));
+
+        /* Plain zstd values don't need the dictionary.
+         */
+        err = compress_zstd_dict_decompress(ddict, pbuf, pbuflen, dbuf, vlen, &dbuflen);
+        ASSERT_EQ(0, err);
+        ASSERT_EQ(vlen, dbuflen);
+
+        err = compress_zstd_dict_decompress(NULL, cbuf, cbuflen, dbuf, vlen, &dbuflen);
+        ASSERT_EQ(EPROTO, merr_errno(err));
+
+        err = compress_zstd_ops.cop_decompress(cbuf, cbuflen, dbuf, vlen, &dbuflen);
+        ASSERT_EQ(EPROTO, merr_errno(err));
+    }
+
+    compress_zstd_dict_destroy(ddict);
+    compress_zstd_dict_destroy(cdict);
+    compress_zstd_dict_destroy(NULL);
+
+    free(samplev);
+    free(samples);
+}
+
+#endif /* HAVE_ZSTD */
 
 MTF_END_UTEST_COLLECTION(compression_test)
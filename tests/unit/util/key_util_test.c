@@ -5,6 +5,8 @@
 
 #include <mtf/framework.h>
 
+#include <hse/limits.h>
+
 #include <hse_util/inttypes.h>
 #include <hse_util/key_util.h>
 #include <hse_util/minmax.h>
@@ -583,4 +585,58 @@ MTF_DEFINE_UTEST(key_util_test, null_pointers)
     ASSERT_LT(rc, 0);
 }
 
+MTF_DEFINE_UTEST(key_util_test, key_successor_test)
+{
+    u8   key[HSE_KVS_KEY_LEN_MAX], orig[HSE_KVS_KEY_LEN_MAX];
+    uint klen;
+    bool found;
+
+    /* A short key is followed by itself plus a zero byte */
+    memcpy(key, "ab", 2);
+    klen = 2;
+    found = key_successor(key, &klen);
+    ASSERT_TRUE(found);
+    ASSERT_EQ(3, klen);
+    ASSERT_EQ(0, memcmp(key, "ab\0", 3));
+
+    /* ...even if it is all 0xff */
+    memset(key, 0xff, sizeof(key));
+    klen = 10;
+    found = key_successor(key, &klen);
+    ASSERT_TRUE(found);
+    ASSERT_EQ(11, klen);
+    ASSERT_EQ(0, key[10]);
+    ASSERT_EQ(0xff, key[9]);
+
+    /* A max-length key increments its last byte */
+    memset(key, 0x55, sizeof(key));
+    memcpy(orig, key, sizeof(key));
+    klen = HSE_KVS_KEY_LEN_MAX;
+    found = key_successor(key, &klen);
+    ASSERT_TRUE(found);
+    ASSERT_EQ(HSE_KVS_KEY_LEN_MAX, klen);
+    ASSERT_EQ(0x56, key[HSE_KVS_KEY_LEN_MAX - 1]);
+    ASSERT_GT(key_inner_cmp(key, klen, orig, HSE_KVS_KEY_LEN_MAX), 0);
+
+    /* ...after dropping its trailing 0xff bytes */
+    memset(key + HSE_KVS_KEY_LEN_MAX - 3, 0xff, 3);
+    memcpy(orig, key, sizeof(key));
+    klen = HSE_KVS_KEY_LEN_MAX;
+    found = key_successor(key, &klen);
+    ASSERT_TRUE(found);
+    ASSERT_EQ(HSE_KVS_KEY_LEN_MAX - 3, klen);
+    ASSERT_EQ(0x56, key[klen - 1]);
+    ASSERT_EQ(0, memcmp(key, orig, klen - 1));
+    ASSERT_GT(key_inner_cmp(key, klen, orig, HSE_KVS_KEY_LEN_MAX), 0);
+
+    /* A max-length key of all 0xff is the largest key */
+    memset(key, 0xff, sizeof(key));
+    klen = HSE_KVS_KEY_LEN_MAX;
+    found = key_successor(key, &klen);
+    ASSERT_FALSE(found);
+    ASSERT_EQ(HSE_KVS_KEY_LEN_MAX, klen);
+    for (uint i = 0; i < HSE_KVS_KEY_LEN_MAX; i++)
+        ASSERT_EQ(0xff, key[i]);
+}
+
 MTF_END_UTEST_COLLECTION(key_util_test)
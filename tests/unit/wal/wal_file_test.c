@@ -0,0 +1,252 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <fcntl.h>
+#include <libgen.h>
+#include <stdint.h>
+
+#include <mtf/framework.h>
+
+#include <hse/error/merr.h>
+#include <hse_util/page.h>
+
+#include <hse_ikvdb/cndb.h>
+#include <hse_ikvdb/wal.h>
+#include <mpool/mpool.h>
+
+#include <wal/wal.h>
+#include <wal/wal_file.h>
+#include <wal/wal_omf.h>
+#include <wal/wal_replay.h>
+
+#include "../mpool/common.h"
+
+#define WAL_TEST_CAP     (1ul << 20)
+#define WAL_TEST_BUFSZ   (64ul << 10)
+#define WAL_TEST_RECOFF  (PAGE_SIZE)
+#define WAL_TEST_KLEN    (8)
+
+static const char *ftw_prefix;
+static int         ftw_count;
+
+static void
+count_cb(void *arg, const char *path)
+{
+    char *pathdup = strdup(path);
+
+    if (pathdup && !strncmp(basename(pathdup), ftw_prefix, strlen(ftw_prefix)))
+        ftw_count++;
+
+    free(pathdup);
+}
+
+/* Count the files in the capacity mclass whose name begins with @prefix */
+static int
+count_files(struct mpool *mp, const char *prefix)
+{
+    struct mpool_file_cb cb = { .cbarg = NULL, .cbfunc = count_cb };
+    merr_t err;
+
+    ftw_prefix = prefix;
+    ftw_count = 0;
+
+    err = mpool_mclass_ftw(mp, HSE_MCLASS_CAPACITY, WAL_FILE_PFX, &cb);
+
+    return err ? -1 : ftw_count;
+}
+
+static size_t
+rec_len(void)
+{
+    return wal_reclen(WAL_VERSION) + 2 * WAL_TEST_KLEN;
+}
+
+/*
+ * Format @cnt non-tx put records into @buf, starting at the same logical
+ * buffer offset regardless of gen so that the records of every gen line up.
+ */
+static size_t
+recs_pack(char *buf, int cnt, uint64_t gen, uint64_t seqno)
+{
+    size_t len = rec_len();
+    int i;
+
+    memset(buf, 0, WAL_TEST_BUFSZ);
+
+    for (i = 0; i < cnt; i++) {
+        struct wal_record rec = { 0 };
+        char *recbuf = buf + i * len;
+        uint64_t key = seqno + i;
+
+        wal_rechdr_pack(WAL_RT_NONTX, seqno + i, len, gen, recbuf);
+        wal_rec_pack(WAL_OP_PUT, 1, 0, WAL_TEST_KLEN, WAL_TEST_KLEN, recbuf);
+        memcpy(recbuf + wal_reclen(WAL_VERSION), &key, sizeof(key));
+        memcpy(recbuf + wal_reclen(WAL_VERSION) + WAL_TEST_KLEN, &key, sizeof(key));
+
+        rec.recbuf = recbuf;
+        rec.offset = WAL_TEST_RECOFF + i * len;
+        rec.len = len;
+        wal_rec_finish(&rec, seqno + i, gen);
+    }
+
+    return cnt * len;
+}
+
+static merr_t
+file_write(
+    struct wal_fileset *wfset,
+    uint64_t            gen,
+    int                 fileid,
+    uint64_t            seqno,
+    int                 cnt,
+    char               *buf,
+    struct wal_file   **wfile_out)
+{
+    struct wal_minmax_info info;
+    struct wal_file *wfile;
+    size_t len;
+    merr_t err;
+
+    err = wal_file_open(wfset, gen, fileid, false, &wfile);
+    if (err)
+        return err;
+
+    len = recs_pack(buf, cnt, gen, seqno);
+
+    err = wal_file_write(wfile, buf, len, false);
+    if (err)
+        return err;
+
+    info.min_seqno = seqno;
+    info.max_seqno = seqno + cnt - 1;
+    info.min_gen = info.max_gen = gen;
+    info.min_txid = UINT64_MAX;
+    info.max_txid = 0;
+    wal_file_minmax_update(wfile, &info);
+
+    *wfile_out = wfile;
+
+    return 0;
+}
+
+MTF_BEGIN_UTEST_COLLECTION_PRE(wal_file_test, mpool_collection_pre)
+
+MTF_DEFINE_UTEST_PREPOST(wal_file_test, recycle_reuse_replay, mpool_test_pre, mpool_test_post)
+{
+    struct wal_replay_info rinfo = { 0 };
+    struct wal_replay_gen_info *rginfo;
+    struct wal_fileset *wfset;
+    struct wal_file *wfile;
+    struct wal_rechdr hdr;
+    struct mpool *mp;
+    uint64_t recoff = 0;
+    const int cnt1 = 64, cnt2 = 8;
+    const char *rbuf;
+    off_t curoff;
+    uint32_t rgcnt;
+    char *buf;
+    merr_t err;
+    size_t i;
+
+    buf = aligned_alloc(PAGE_SIZE, WAL_TEST_BUFSZ);
+    ASSERT_NE(NULL, buf);
+
+    err = mpool_create(mtf_kvdb_home, &tcparams);
+    ASSERT_EQ(0, err);
+
+    err = mpool_open(mtf_kvdb_home, &trparams, O_RDWR, &mp);
+    ASSERT_EQ(0, err);
+
+    wfset = wal_fileset_open(mp, HSE_MCLASS_CAPACITY, WAL_TEST_CAP, WAL_MAGIC, WAL_VERSION);
+    ASSERT_NE(NULL, wfset);
+
+    wal_fileset_recycle_set(wfset, 2);
+
+    /* Fill two gen 1 files, complete them, then reclaim both into the recycle pool */
+    for (i = 0; i < 2; i++) {
+        err = file_write(wfset, 1, i, 1, cnt1, buf, &wfile);
+        ASSERT_EQ(0, err);
+
+        err = wal_file_complete(wfset, wfile);
+        ASSERT_EQ(0, err);
+    }
+
+    ASSERT_EQ(2, count_files(mp, WAL_FILE_PFX "-1-"));
+    ASSERT_EQ(0, count_files(mp, WAL_FILE_PFX "-free-"));
+
+    err = wal_fileset_reclaim(wfset, cnt1, 1, CNDB_INVAL_HORIZON, false);
+    ASSERT_EQ(0, err);
+
+    ASSERT_EQ(0, count_files(mp, WAL_FILE_PFX "-1-"));
+    ASSERT_EQ(2, count_files(mp, WAL_FILE_PFX "-free-"));
+
+    /* Gen 2 reuses a recycled file and crashes after a few records */
+    err = file_write(wfset, 2, 0, cnt1 + 1, cnt2, buf, &wfile);
+    ASSERT_EQ(0, err);
+
+    ASSERT_EQ(1, count_files(mp, WAL_FILE_PFX "-2-"));
+    ASSERT_EQ(1, count_files(mp, WAL_FILE_PFX "-free-"));
+
+    wal_fileset_close(wfset, 0, 0, 0);
+
+    /* Excess recycled files found at replay are released */
+    wfset = wal_fileset_open(mp, HSE_MCLASS_CAPACITY, WAL_TEST_CAP, WAL_MAGIC, WAL_VERSION);
+    ASSERT_NE(NULL, wfset);
+
+    rinfo.txhorizon = CNDB_INVAL_HORIZON;
+    err = wal_fileset_replay(wfset, &rinfo, &rgcnt, &rginfo);
+    ASSERT_EQ(0, err);
+    ASSERT_EQ(1, rgcnt);
+
+    wal_fileset_recycle_set(wfset, 0);
+    ASSERT_EQ(0, count_files(mp, WAL_FILE_PFX "-free-"));
+
+    /* The reused file kept its allocation but has no trusted end offset */
+    ASSERT_EQ(2, rginfo[0].gen);
+    ASSERT_EQ(0, rginfo[0].eoff);
+    ASSERT_FALSE(rginfo[0].info_valid);
+    ASSERT_EQ(WAL_TEST_CAP, rginfo[0].size);
+
+    /* Only the new records are valid.  The stale gen 1 records that follow
+     * them were not zeroed at recycle, and they line up with the new ones,
+     * but they were written to the file under its previous gen.
+     */
+    rbuf = rginfo[0].buf;
+    curoff = 0;
+    i = 0;
+    while (wal_rec_is_valid(rbuf + curoff, curoff + rginfo[0].soff, rginfo[0].size, &recoff,
+                            rginfo[0].gen, WAL_VERSION, &hdr, NULL)) {
+        ASSERT_EQ(WAL_TEST_RECOFF + curoff, hdr.off);
+        ASSERT_EQ(cnt1 + 1 + i, hdr.rid);
+        ASSERT_EQ(rginfo[0].gen, hdr.flags >> WAL_FLAGS_FGEN_SHIFT);
+        curoff += wal_rechdr_len(WAL_VERSION) + hdr.len;
+        i++;
+    }
+    ASSERT_EQ(cnt2, i);
+    ASSERT_EQ(cnt2 * rec_len(), curoff);
+
+    ASSERT_EQ(WAL_TEST_RECOFF + curoff, hdr.off);
+    ASSERT_EQ(1 + cnt2, hdr.rid);
+    ASSERT_EQ(1, hdr.gen);
+    ASSERT_EQ(1, hdr.flags >> WAL_FLAGS_FGEN_SHIFT);
+
+    /* The same record passes validation for the gen it was written under */
+    recoff = 0;
+    ASSERT_TRUE(wal_rec_is_valid(rbuf + curoff, curoff + rginfo[0].soff, rginfo[0].size, &recoff,
+                                 1, WAL_VERSION, &hdr, NULL));
+
+    wal_fileset_replay_free(wfset, false);
+    ASSERT_EQ(0, count_files(mp, WAL_FILE_PFX "-"));
+
+    wal_fileset_close(wfset, 0, 0, 0);
+
+    err = mpool_close(mp);
+    ASSERT_EQ(0, err);
+
+    mpool_destroy(mtf_kvdb_home, &tdparams);
+    free(buf);
+}
+
+MTF_END_UTEST_COLLECTION(wal_file_test)
@@ -0,0 +1,142 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+#include <mtf/framework.h>
+
+#include <wal/wal_gc.h>
+
+#define GAP_NS     (100ul * 1000)
+#define DELAY_US   (500)
+
+/* Feed the policy a stream of syncs spaced exactly GAP_NS apart */
+static void
+arrivals(struct wal_gc *gc, uint64_t *now, int cnt)
+{
+    while (cnt-- > 0) {
+        wal_gc_arrival(gc, *now);
+        *now += GAP_NS;
+    }
+}
+
+/* Run the leader's linger loop, assuming syncs keep arriving */
+static uint
+linger_rounds(const struct wal_gc *gc, uint32_t waiters, uint64_t *waited_ns)
+{
+    uint64_t linger_ns;
+    uint rounds = 0;
+
+    *waited_ns = 0;
+
+    while ((linger_ns = wal_gc_linger(gc, waiters, *waited_ns)) > 0) {
+        *waited_ns += linger_ns;
+        rounds++;
+    }
+
+    return rounds;
+}
+
+MTF_BEGIN_UTEST_COLLECTION(wal_gc_test)
+
+MTF_DEFINE_UTEST(wal_gc_test, single_syncer)
+{
+    struct wal_gc gc;
+    uint64_t now = 1;
+    int i;
+
+    wal_gc_init(&gc, DELAY_US);
+
+    /* No arrival history, nothing to wait for */
+    ASSERT_EQ(0, wal_gc_linger(&gc, 1, 0));
+
+    arrivals(&gc, &now, 8);
+    ASSERT_EQ(GAP_NS, gc.gc_gap_ns);
+
+    /* A lone syncer must not pay the inter-arrival gap in latency, no
+     * matter how regular the arrivals are.
+     */
+    for (i = 0; i < 16; i++) {
+        ASSERT_EQ(0, wal_gc_linger(&gc, 1, 0));
+        wal_gc_commit(&gc, 1);
+    }
+
+    ASSERT_EQ(WAL_GC_BATCH_ONE, gc.gc_batch_avg);
+}
+
+MTF_DEFINE_UTEST(wal_gc_test, queued_waiters)
+{
+    struct wal_gc gc;
+    uint64_t now = 1, waited_ns;
+    uint rounds;
+
+    wal_gc_init(&gc, DELAY_US);
+    arrivals(&gc, &now, 8);
+
+    ASSERT_EQ(GAP_NS, wal_gc_linger(&gc, 2, 0));
+
+    /* The leader lingers one gap at a time, up to the delay cap */
+    rounds = linger_rounds(&gc, 4, &waited_ns);
+    ASSERT_EQ(DELAY_US * 1000ul / GAP_NS, rounds);
+    ASSERT_LE(waited_ns, DELAY_US * 1000ul);
+}
+
+MTF_DEFINE_UTEST(wal_gc_test, batch_history)
+{
+    struct wal_gc gc;
+    uint64_t now = 1;
+    int i;
+
+    wal_gc_init(&gc, DELAY_US);
+    arrivals(&gc, &now, 8);
+
+    /* Commits that covered several syncs make a lone leader linger */
+    wal_gc_commit(&gc, 4);
+    ASSERT_GT(gc.gc_batch_avg, WAL_GC_BATCH_ONE);
+    ASSERT_EQ(GAP_NS, wal_gc_linger(&gc, 1, 0));
+
+    /* ...until the load goes back to single syncs */
+    for (i = 0; i < 64 && wal_gc_linger(&gc, 1, 0) > 0; i++)
+        wal_gc_commit(&gc, 1);
+
+    ASSERT_LT(i, 64);
+    ASSERT_EQ(0, wal_gc_linger(&gc, 1, 0));
+
+    /* Queued waiters still count */
+    ASSERT_EQ(GAP_NS, wal_gc_linger(&gc, 2, 0));
+}
+
+MTF_DEFINE_UTEST(wal_gc_test, idle_gap)
+{
+    struct wal_gc gc;
+    uint64_t now = 1;
+
+    wal_gc_init(&gc, DELAY_US);
+
+    /* Sparse syncs, the gap is clamped and exceeds the delay cap */
+    wal_gc_arrival(&gc, now);
+    now += 10ul * 1000 * 1000 * 1000;
+    wal_gc_arrival(&gc, now);
+
+    ASSERT_EQ(2ul * DELAY_US * 1000, gc.gc_gap_ns);
+    ASSERT_EQ(0, wal_gc_linger(&gc, 8, 0));
+
+    /* A burst pulls the average back under the cap */
+    arrivals(&gc, &now, 64);
+    ASSERT_LE(gc.gc_gap_ns, DELAY_US * 1000ul);
+    ASSERT_GT(wal_gc_linger(&gc, 8, 0), 0);
+}
+
+MTF_DEFINE_UTEST(wal_gc_test, no_delay)
+{
+    struct wal_gc gc;
+    uint64_t now = 1;
+
+    wal_gc_init(&gc, 0);
+    arrivals(&gc, &now, 8);
+    wal_gc_commit(&gc, 8);
+
+    ASSERT_EQ(0, wal_gc_linger(&gc, 8, 0));
+}
+
+MTF_END_UTEST_COLLECTION(wal_gc_test)
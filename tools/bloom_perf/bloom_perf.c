@@ -0,0 +1,217 @@
+/* SPDX-License-Identifier: Apache-2.0 */
+/*
+ * Copyright (C) 2022 Micron Technology, Inc.  All rights reserved.
+ */
+
+/* Compare the false positive rate and probe cost of the legacy (bucketed)
+ * kblock bloom layout with that of the cache-line blocked layout.
+ *
+ * A set of filters is built from random hashes (standing in for the xxhash
+ * of each key), and lookups are issued round-robin across the filters so
+ * that, as with a point miss in a deep cn node, successive probes touch
+ * different filters.  Using more filters than fit in the LLC approximates
+ * the cold-cache behavior of cn_tree_lookup().
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <hse_util/platform.h>
+#include <hse_util/arch.h>
+#include <hse_util/bloom_filter.h>
+#include <hse_util/page.h>
+#include <hse_util/xrand.h>
+
+struct bloom {
+    struct bloom_filter bf;
+    u64                *hashv;
+};
+
+static uint  nkeys = 100 * 1000;
+static uint  nfilters = 64;
+static uint  nlookups = 10 * 1000 * 1000;
+static uint  prob = 10000;
+static u64   seed;
+
+static bool
+legacy_lookup(const struct bloom_filter *bf, u64 hash)
+{
+    const u8 *bitmap = bf->bf_bitmap;
+
+    bitmap += bf_hash2bkt(hash, bf->bf_modulus, bf->bf_bktshift);
+
+    return bf_lookup(hash, bitmap, bf->bf_n_hashes, bf->bf_rotl, bf->bf_bktmask);
+}
+
+static bool
+blocked_lookup(const struct bloom_filter *bf, u64 hash)
+{
+    return bf_blk_lookup(hash, bf->bf_bitmap, bf->bf_modulus, bf->bf_n_hashes);
+}
+
+static int
+build(struct bloom *bv, bool blocked)
+{
+    struct bf_bithash_desc desc;
+    struct xrand           xr;
+    size_t                 sz;
+    uint                   i, j;
+
+    desc = bf_compute_bithash_est(prob);
+    sz = ALIGN(bf_size_estimate(desc, nkeys), PAGE_SIZE);
+
+    xrand_init(&xr, seed);
+
+    for (i = 0; i < nfilters; ++i) {
+        struct bloom *b = bv + i;
+        u8           *bitmap;
+
+        bitmap = aligned_alloc(PAGE_SIZE, sz);
+        if (!bitmap)
+            return ENOMEM;
+
+        memset(bitmap, 0, sz);
+
+        if (blocked)
+            bf_filter_init_blocked(&b->bf, desc, nkeys, bitmap, sz);
+        else
+            bf_filter_init(&b->bf, desc, nkeys, bitmap, sz);
+
+        for (j = 0; j < nkeys; ++j)
+            b->hashv[j] = xrand64(&xr);
+
+        bf_filter_insert_by_hashv(&b->bf, b->hashv, nkeys);
+    }
+
+    return 0;
+}
+
+static int
+run(const char *name, struct bloom *bv, bool blocked)
+{
+    bool (*lookup)(const struct bloom_filter *, u64);
+    struct xrand xr;
+    u64          start, miss_ns, hit_ns;
+    ulong        fpc = 0, fnc = 0;
+    uint         i;
+    int          rc;
+
+    rc = build(bv, blocked);
+    if (rc)
+        return rc;
+
+    lookup = blocked ? blocked_lookup : legacy_lookup;
+
+    /* Absent keys: every hit is a false positive.
+     */
+    xrand_init(&xr, seed + 1);
+
+    start = get_time_ns();
+    for (i = 0; i < nlookups; ++i)
+        fpc += lookup(&bv[i % nfilters].bf, xrand64(&xr));
+    miss_ns = get_time_ns() - start;
+
+    /* Present keys: every miss is a (fatal) false negative.
+     */
+    start = get_time_ns();
+    for (i = 0; i < nlookups; ++i) {
+        const struct bloom *b = bv + (i % nfilters);
+
+        fnc += !lookup(&b->bf, b->hashv[(i / nfilters) % nkeys]);
+    }
+    hit_ns = get_time_ns() - start;
+
+    printf("%-8s %6u %8u %8u %10.3f %12.6f %10.2f %10.2f\n",
+           name, bv[0].bf.bf_n_hashes, bv[0].bf.bf_bitmapsz, nfilters,
+           (bv[0].bf.bf_bitmapsz * 8.0) / nkeys, (double)fpc / nlookups,
+           (double)miss_ns / nlookups, (double)hit_ns / nlookups);
+
+    for (i = 0; i < nfilters; ++i) {
+        free(bv[i].bf.bf_bitmap);
+        bv[i].bf.bf_bitmap = NULL;
+    }
+
+    if (fnc) {
+        fprintf(stderr, "%s: %lu false negatives\n", name, fnc);
+        return 1;
+    }
+
+    return 0;
+}
+
+static void
+usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "-c nfilters  number of filters to probe round-robin (default %u)\n"
+            "-k nkeys     number of keys per filter (default %u)\n"
+            "-l nlookups  number of lookups per test (default %u)\n"
+            "-p prob      target false positive rate in ppm (default %u)\n"
+            "-s seed      random seed\n",
+            prog, nfilters, nkeys, nlookups, prob);
+}
+
+int
+main(int argc, char **argv)
+{
+    struct bloom *bv;
+    uint          i;
+    int           opt, rc;
+
+    seed = get_time_ns();
+
+    while ((opt = getopt(argc, argv, "c:hk:l:p:s:")) != -1) {
+        switch (opt) {
+            case 'c':
+                nfilters = strtoul(optarg, NULL, 0);
+                break;
+            case 'k':
+                nkeys = strtoul(optarg, NULL, 0);
+                break;
+            case 'l':
+                nlookups = strtoul(optarg, NULL, 0);
+                break;
+            case 'p':
+                prob = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                seed = strtoull(optarg, NULL, 0);
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                exit(opt == 'h' ? 0 : 1);
+        }
+    }
+
+    if (!nfilters || !nkeys || !nlookups || !prob) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    bv = calloc(nfilters, sizeof(*bv));
+    if (!bv)
+        return ENOMEM;
+
+    for (i = 0; i < nfilters; ++i) {
+        bv[i].hashv = malloc(nkeys * sizeof(*bv[i].hashv));
+        if (!bv[i].hashv)
+            return ENOMEM;
+    }
+
+    printf("seed %lu, keys/filter %u, target fp %.6f\n\n", seed, nkeys, prob / 1000000.0);
+    printf("%-8s %6s %8s %8s %10s %12s %10s %10s\n",
+           "layout", "hashes", "bytes", "filters", "bits/key", "fp_rate", "miss_ns", "hit_ns");
+
+    rc = run("legacy", bv, false);
+    if (!rc)
+        rc = run("blocked", bv, true);
+
+    for (i = 0; i < nfilters; ++i)
+        free(bv[i].hashv);
+    free(bv);
+
+    return rc;
+}
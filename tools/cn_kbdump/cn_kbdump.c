@@ -27,6 +27,7 @@
 
 #include <cn/omf.h>
 #include <cn/wbt_internal.h>
+#include <cn/wbt_reader.h>
 
 #include <libgen.h>
 #include <sysexits.h>
@@ -219,7 +220,8 @@ print_kblk(struct blk *blk)
         omf_kbh_blm_doff_pg(p),
         omf_kbh_blm_dlen_pg(p),
         omf_bh_version(blm_hdr));
-    printf("    kmd: start_pg %u\n", omf_kbh_wbt_doff_pg(p) + omf_wbt_root(wbt_hdr) + 1);
+    printf("    kmd: start_pg %u\n", omf_kbh_wbt_doff_pg(p) + omf_wbt_root(wbt_hdr) + 1 -
+           (omf_wbt_leaf_pgc(wbt_hdr) ? omf_wbt_leaf_cnt(wbt_hdr) - omf_wbt_leaf_pgc(wbt_hdr) : 0));
     printf(
         "    keymin: off %u len %u key %s\n",
         omf_kbh_min_koff(p),
@@ -435,6 +437,7 @@ struct kmd_vref {
     uint           vbidx;
     uint           vboff;
     uint           vlen;
+    u32            expire;
     u64            seq;
     int            cnt;
     char           vinfo[64];
@@ -453,7 +456,7 @@ val_get_next(void *kmd, size_t *off, struct kmd_vref *vref)
 
     vref->vtype_off = *off;
 
-    kmd_type_seq(kmd, off, &vref->vtype, &vref->seq);
+    kmd_type_seq_expire(kmd, off, &vref->vtype, &vref->seq, &vref->expire);
 
     switch (vref->vtype) {
         case VTYPE_UCVAL:
@@ -470,6 +473,21 @@ val_get_next(void *kmd, size_t *off, struct kmd_vref *vref)
             kmd_ival(kmd, off, &vdata, &vlen);
             snprintf(vref->vinfo, sizeof(vref->vinfo), "type=iv %u", vlen);
             break;
+        case VTYPE_LIVAL:
+            kmd_lival(kmd, off, &vdata, &vlen);
+            snprintf(vref->vinfo, sizeof(vref->vinfo), "type=liv %u", vlen);
+            break;
+        case VTYPE_CIVAL: {
+            u32 complen;
+
+            kmd_cival(kmd, off, &vdata, &vlen, &complen);
+            snprintf(vref->vinfo, sizeof(vref->vinfo), "type=civ %u/%u", vlen, complen);
+            break;
+        }
+        case VTYPE_MVAL:
+            kmd_mval(kmd, off, &vdata, &vlen);
+            snprintf(vref->vinfo, sizeof(vref->vinfo), "type=mv %u", vlen);
+            break;
         case VTYPE_ZVAL:
             strlcpy(vref->vinfo, "type=zv", sizeof(vref->vinfo));
             break;
@@ -493,6 +511,12 @@ val_get_next(void *kmd, size_t *off, struct kmd_vref *vref)
             vref->cnt = 0;
     }
 
+    if (vref->expire) {
+        size_t n = strlen(vref->vinfo);
+
+        snprintf(vref->vinfo + n, sizeof(vref->vinfo) - n, " exp=%u", vref->expire);
+    }
+
     return true;
 }
 
@@ -622,25 +646,38 @@ print_wbt_node(void *h, uint version, void *kmd, int pgno, int root)
 }
 
 void
-print_wbt_nodes(void *kblk, void *kmd, int root, bool ptomb)
+print_wbt_nodes(void *kblk, void *kmd, const struct wbt_desc *wbd)
 {
+    static char              leafbuf[WBT_NODE_SIZE];
     struct wbt_node_hdr_omf *wbn;
-    struct wbt_hdr_omf *     wbt_hdr = off2addr(kblk, omf_kbh_wbt_hoff(kblk));
     int                      terse = !opt.klen;
-    int                      i, pgno;
+    int                      i, pgno, root = wbd->wbd_root;
     uint                     magic, omagic = 0;
 
     if (terse)
         printf("wbt node list:");
 
     for (i = pgno = 0; pgno <= root; ++pgno, ++i) {
-        if (ptomb)
-            wbn = kblk + pgoff(pgno + omf_hbh_ptree_data_off_pg(kblk));
-        else
-            wbn = kblk + pgoff(pgno + omf_kbh_wbt_doff_pg(kblk));
+        if (wbd->wbd_leaf_pgc && pgno < wbd->wbd_leaf_cnt) {
+            size_t off;
+            uint   len;
+            merr_t err;
+
+            err = wbt_leaf_span(kblk, wbd, pgno, &off, &len);
+            if (!err)
+                err = wbt_leaf_decode(kblk + off, len, leafbuf);
+            if (err) {
+                printf("\nleaf %d: corrupt compressed leaf node\n", pgno);
+                continue;
+            }
+
+            wbn = (void *)leafbuf;
+        } else {
+            wbn = kblk + pgoff(wbt_node_pg(wbd, pgno));
+        }
 
         if (!terse) {
-            print_wbt_node(wbn, omf_wbt_version(wbt_hdr), kmd, pgno, root);
+            print_wbt_node(wbn, wbd->wbd_version, kmd, pgno, root);
             continue;
         }
 
@@ -661,31 +698,40 @@ print_wbt_nodes(void *kblk, void *kmd, int root, bool ptomb)
 void
 print_wbt_impl(const struct wbt_hdr_omf *wbt_hdr, void *blk, bool ptomb)
 {
-    u32 wbt_doff;
+    struct wbt_desc wbd = { 0 };
     u8 *kmd;
 
-    wbt_doff = ptomb ? omf_hbh_ptree_data_off_pg(blk) : omf_kbh_wbt_doff_pg(blk);
-    kmd = blk + pgoff(wbt_doff + omf_wbt_root(wbt_hdr) + 1);
+    wbd.wbd_first_page = ptomb ? omf_hbh_ptree_data_off_pg(blk) : omf_kbh_wbt_doff_pg(blk);
+    wbd.wbd_version = omf_wbt_version(wbt_hdr);
+    wbd.wbd_root = omf_wbt_root(wbt_hdr);
+    wbd.wbd_leaf = omf_wbt_leaf(wbt_hdr);
+    wbd.wbd_leaf_cnt = omf_wbt_leaf_cnt(wbt_hdr);
+    wbd.wbd_kmd_pgc = omf_wbt_kmd_pgc(wbt_hdr);
+    wbd.wbd_leaf_pgc = omf_wbt_leaf_pgc(wbt_hdr);
+
+    kmd = blk + pgoff(wbt_kmd_pg(&wbd));
 
     printf(
         "    wbthdr: magic 0x%08x  ver %d  root %d  leaf1 %d  nleaf %d "
-        "kmdpgc %d\n",
+        "kmdpgc %d  leafpgc %d\n",
         omf_wbt_magic(wbt_hdr),
         omf_wbt_version(wbt_hdr),
         omf_wbt_root(wbt_hdr),
         omf_wbt_leaf(wbt_hdr),
         omf_wbt_leaf_cnt(wbt_hdr),
-        omf_wbt_kmd_pgc(wbt_hdr));
+        omf_wbt_kmd_pgc(wbt_hdr),
+        omf_wbt_leaf_pgc(wbt_hdr));
 
     if ((opt.verbose || opt.klen) && omf_wbt_kmd_pgc(wbt_hdr) > 0)
-        print_wbt_nodes(blk, kmd, omf_wbt_root(wbt_hdr), ptomb);
+        print_wbt_nodes(blk, kmd, &wbd);
 }
 
 void
 print_wbt(const struct wbt_hdr_omf *wbt_hdr, void *blk, bool ptomb)
 {
     switch (omf_wbt_version(wbt_hdr)) {
-        case WBT_TREE_VERSION:
+        case WBT_TREE_VERSION6:
+        case WBT_TREE_VERSION7:
             print_wbt_impl(wbt_hdr, blk, ptomb);
             break;
         default:
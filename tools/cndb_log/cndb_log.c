@@ -110,8 +110,8 @@ cndb_print_record(struct cndb_reader *reader)
         uint64_t cnid;
 
         cndb_omf_kvs_add_read(reader->buf, &cp, &cnid, name, sizeof(name));
-        printf("%-8s name %s cnid %lu pfxlen %u capped %c\n",
-               "kvs_add", name, cnid, cp.pfx_len, cp.kvs_ext01 ? 'y' : 'n');
+        printf("%-8s name %s cnid %lu pfxlen %u capped %c vinline %u\n",
+               "kvs_add", name, cnid, cp.pfx_len, cp.kvs_ext01 ? 'y' : 'n', cp.vinline_len);
 
     } else if (rec_type == CNDB_TYPE_KVS_DEL) {
         uint64_t cnid;
@@ -186,6 +186,26 @@ cndb_print_record(struct cndb_reader *reader)
 
         cndb_omf_nak_read(reader->buf, &txid);
         printf("%-8s txid %lu\n", "nak", txid);
+
+    } else if (rec_type == CNDB_TYPE_KVSET_SUM) {
+        struct kvset_summary *sum;
+        uint64_t cnid, kvsetid;
+        merr_t err;
+
+        err = cndb_omf_kvset_sum_read(reader->buf, &cnid, &kvsetid, &sum);
+        if (err) {
+            printf("%-8s invalid record\n", "kvsum");
+            return;
+        }
+
+        printf("%-8s cnid %lu kvsetid %lu seqno %lu..%lu keys %lu tombs %lu ptombs %lu "
+               "kblks %u vblks %u vgroups %u minklen %u maxklen %u\n",
+               "kvsum", cnid, kvsetid, sum->ksum_seqno_min, sum->ksum_seqno_max,
+               sum->ksum_st.kst_keys, sum->ksum_st.kst_tombs, sum->ksum_st.kst_ptombs,
+               sum->ksum_st.kst_kblks, sum->ksum_st.kst_vblks, sum->ksum_vgroups,
+               sum->ksum_minklen, sum->ksum_maxklen);
+
+        free(sum);
     }
 }
 
@@ -607,6 +607,18 @@ run_kmd_read_perf(struct kmd_test_stats *s)
                     kmd_ival(mem, &off, &vdata, &vlen);
                     s->nvals++;
                     break;
+                case VTYPE_LIVAL:
+                    kmd_lival(mem, &off, &vdata, &vlen);
+                    s->nvals++;
+                    break;
+                case VTYPE_CIVAL:
+                    kmd_cival(mem, &off, &vdata, &vlen, &clen);
+                    s->nvals++;
+                    break;
+                case VTYPE_MVAL:
+                    kmd_mval(mem, &off, &vdata, &vlen);
+                    s->nvals++;
+                    break;
                 case VTYPE_UCVAL:
                     kmd_val(mem, &off, &vbidx, &vboff, &vlen);
                     s->nvals++;
@@ -673,6 +685,9 @@ run_kmd_tp(struct kmd_test_profile *tp, struct kmd_test_stats *s, bool writing)
                     s->nzvals++;
                     break;
                 case VTYPE_IVAL:
+                case VTYPE_LIVAL:
+                case VTYPE_CIVAL:
+                case VTYPE_MVAL:
                     s->nivals++;
                     break;
                 case VTYPE_CVAL:
@@ -694,6 +709,15 @@ run_kmd_tp(struct kmd_test_profile *tp, struct kmd_test_stats *s, bool writing)
                     case VTYPE_IVAL:
                         kmd_add_ival(mem, &off, seq, vdata, vlen);
                         break;
+                    case VTYPE_LIVAL:
+                        kmd_add_lival(mem, &off, seq, vdata, vlen);
+                        break;
+                    case VTYPE_CIVAL:
+                        kmd_add_cival(mem, &off, seq, vdata, vlen, clen);
+                        break;
+                    case VTYPE_MVAL:
+                        kmd_add_mval(mem, &off, seq, vdata, vlen);
+                        break;
                     case VTYPE_CVAL:
                         kmd_add_cval(mem, &off, seq, vbidx, vboff, vlen, clen);
                         break;
@@ -731,6 +755,19 @@ run_kmd_tp(struct kmd_test_profile *tp, struct kmd_test_stats *s, bool writing)
                         kmd_ival(mem, &off, &actual_vdata, &actual_vlen);
                         assert(actual_vlen == vlen);
                         break;
+                    case VTYPE_LIVAL:
+                        kmd_lival(mem, &off, &actual_vdata, &actual_vlen);
+                        assert(actual_vlen == vlen);
+                        break;
+                    case VTYPE_CIVAL:
+                        kmd_cival(mem, &off, &actual_vdata, &actual_vlen, &actual_clen);
+                        assert(actual_vlen == vlen);
+                        assert(actual_clen == clen);
+                        break;
+                    case VTYPE_MVAL:
+                        kmd_mval(mem, &off, &actual_vdata, &actual_vlen);
+                        assert(actual_vlen == vlen);
+                        break;
                     case VTYPE_TOMB:
                     case VTYPE_PTOMB:
                     case VTYPE_ZVAL: